@@ -0,0 +1,435 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "asset_pack.h"
+
+static const char *TAG = "asset_pack";
+
+/* Pack layout, little endian, kept in sync with asset_pack.py */
+#define PACK_MAGIC          (0x4B415041)    /* "APAK" */
+#define PACK_VERSION        (1)
+#define PACK_NAME_LEN       (32)
+
+#define PACK_TYPE_IMG       (1)
+#define PACK_TYPE_FONT      (2)
+#define PACK_CODEC_NONE     (0)
+#define PACK_CODEC_RLE      (1)
+#define PACK_KERN_NONE      (0)
+#define PACK_KERN_PAIRS     (1)
+#define PACK_KERN_CLASSES   (2)
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t size;                  /* Header, index and data */
+    uint32_t index_crc;
+    uint8_t color_depth;
+    uint8_t color_swap;
+    uint16_t reserved;
+} pack_header_t;
+
+/* Index sorted by name, assets stored once may have several entries */
+typedef struct {
+    char name[PACK_NAME_LEN];       /* "<scope>/<name>" for assets that differ between projects */
+    uint8_t type;
+    uint8_t codec;
+    uint16_t reserved;
+    uint32_t offset;                /* From the start of the pack, 4-byte aligned */
+    uint32_t size;
+    uint32_t raw_size;              /* Image data once expanded */
+    uint32_t crc;
+} pack_entry_t;
+
+typedef struct {
+    uint8_t cf;
+    uint8_t reserved;
+    uint16_t w;
+    uint16_t h;
+    uint16_t reserved2;
+} pack_img_t;
+
+/* Offsets from the start of the font, 4-byte aligned */
+typedef struct {
+    uint16_t line_height;
+    int16_t base_line;
+    int8_t underline_position;
+    int8_t underline_thickness;
+    uint8_t subpx;
+    uint8_t bpp;
+    uint8_t bitmap_format;
+    uint8_t kern_type;
+    uint16_t kern_scale;
+    uint16_t cmap_num;
+    uint16_t glyph_num;
+    uint32_t bitmap_off;
+    uint32_t glyph_off;
+    uint32_t cmap_off;
+    uint32_t kern_off;
+} pack_font_t;
+
+/* lv_font_fmt_txt_glyph_dsc_t with LV_FONT_FMT_TXT_LARGE */
+typedef struct {
+    uint32_t bitmap_index;
+    uint32_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t ofs_x;
+    int16_t ofs_y;
+} pack_glyph_t;
+
+typedef struct {
+    uint32_t range_start;
+    uint16_t range_length;
+    uint16_t glyph_id_start;
+    uint16_t list_length;
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t unicode_off;           /* 0 for none */
+    uint32_t glyph_id_ofs_off;      /* 0 for none */
+} pack_cmap_t;
+
+typedef struct {
+    uint32_t pair_cnt;
+    uint8_t glyph_ids_size;
+    uint8_t reserved[3];
+    uint32_t glyph_ids_off;
+    uint32_t values_off;
+} pack_kern_pairs_t;
+
+typedef struct {
+    uint8_t left_class_cnt;
+    uint8_t right_class_cnt;
+    uint16_t reserved;
+    uint32_t values_off;
+    uint32_t left_off;
+    uint32_t right_off;
+} pack_kern_classes_t;
+
+typedef struct {
+    lv_font_t font;
+    lv_font_fmt_txt_dsc_t dsc;
+    lv_font_fmt_txt_glyph_cache_t cache;
+    union {
+        lv_font_fmt_txt_kern_pair_t pairs;
+        lv_font_fmt_txt_kern_classes_t classes;
+    } kern;
+    lv_font_fmt_txt_cmap_t cmaps[];
+} asset_font_t;
+
+#if LV_FONT_FMT_TXT_LARGE
+_Static_assert(sizeof(lv_font_fmt_txt_glyph_dsc_t) == sizeof(pack_glyph_t), "glyphs are used straight from flash");
+#endif
+
+static const uint8_t *s_base = NULL;
+static const pack_entry_t *s_entries = NULL;
+static size_t s_count = 0;
+static void **s_assets = NULL;          /* lv_img_dsc_t or asset_font_t per entry, built on first use */
+static char s_scope[PACK_NAME_LEN];
+static SemaphoreHandle_t s_lock = NULL;
+
+static bool asset_range_valid(const pack_entry_t *entry, uint32_t offset, uint32_t size)
+{
+    return offset <= entry->size && size <= entry->size - offset;
+}
+
+static const pack_entry_t *asset_find(const char *name)
+{
+    size_t lo = 0;
+    size_t hi = s_count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int cmp = strncmp(name, s_entries[mid].name, PACK_NAME_LEN);
+        if (0 == cmp) {
+            return &s_entries[mid];
+        }
+        if (cmp < 0) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
+static const pack_entry_t *asset_lookup(const char *name)
+{
+    if (s_scope[0]) {
+        char scoped[PACK_NAME_LEN];
+        if (snprintf(scoped, sizeof(scoped), "%s/%s", s_scope, name) < (int)sizeof(scoped)) {
+            const pack_entry_t *entry = asset_find(scoped);
+            if (entry) {
+                return entry;
+            }
+        }
+    }
+    return asset_find(name);
+}
+
+/* Per pixel RLE: 0x80 | (n - 1) then one pixel repeated n times, or n - 1 then n literal pixels */
+static bool asset_rle_decode(const uint8_t *in, size_t in_size, uint8_t *out, size_t out_size, size_t px_size)
+{
+    const uint8_t *in_end = in + in_size;
+    uint8_t *out_end = out + out_size;
+
+    while (in < in_end && out < out_end) {
+        size_t n = (*in & 0x7f) + 1;
+        size_t len = n * px_size;
+        if (len > (size_t)(out_end - out)) {
+            return false;
+        }
+        if (*in++ & 0x80) {
+            if (px_size > (size_t)(in_end - in)) {
+                return false;
+            }
+            for (size_t i = 0; i < n; i++, out += px_size) {
+                memcpy(out, in, px_size);
+            }
+            in += px_size;
+        } else {
+            if (len > (size_t)(in_end - in)) {
+                return false;
+            }
+            memcpy(out, in, len);
+            in += len;
+            out += len;
+        }
+    }
+    return in == in_end && out == out_end;
+}
+
+static size_t asset_img_px_size(lv_img_cf_t cf)
+{
+    if (LV_IMG_CF_TRUE_COLOR_ALPHA == cf) {
+        return LV_IMG_PX_SIZE_ALPHA_BYTE;
+    }
+    return LV_COLOR_SIZE / 8;
+}
+
+static void *asset_img_load(const pack_entry_t *entry, const uint8_t *blob)
+{
+    ESP_RETURN_ON_FALSE(entry->size >= sizeof(pack_img_t), NULL, TAG, "%s: truncated", entry->name);
+    const pack_img_t *header = (const pack_img_t *)blob;
+    const uint8_t *data = blob + sizeof(pack_img_t);
+    size_t size = entry->size - sizeof(pack_img_t);
+    size_t px_size = asset_img_px_size(header->cf);
+
+    ESP_RETURN_ON_FALSE(entry->raw_size == (size_t)header->w * header->h * px_size, NULL, TAG,
+                        "%s: %u bytes for %ux%u", entry->name, (unsigned)entry->raw_size, header->w, header->h);
+
+    lv_img_dsc_t *img = calloc(1, sizeof(lv_img_dsc_t));
+    ESP_RETURN_ON_FALSE(img, NULL, TAG, "no mem for %s", entry->name);
+    img->header.cf = header->cf;
+    img->header.w = header->w;
+    img->header.h = header->h;
+    img->data_size = entry->raw_size;
+
+    if (PACK_CODEC_RLE == entry->codec) {
+        uint8_t *pixels = heap_caps_malloc(entry->raw_size, MALLOC_CAP_SPIRAM);
+        if (NULL == pixels || !asset_rle_decode(data, size, pixels, entry->raw_size, px_size)) {
+            ESP_LOGE(TAG, "%s: %s", entry->name, pixels ? "corrupted" : "no mem");
+            free(pixels);
+            free(img);
+            return NULL;
+        }
+        img->data = pixels;
+    } else {
+        if (size != entry->raw_size) {
+            ESP_LOGE(TAG, "%s: truncated", entry->name);
+            free(img);
+            return NULL;
+        }
+        img->data = data;
+    }
+    return img;
+}
+
+static void *asset_font_load(const pack_entry_t *entry, const uint8_t *blob)
+{
+    ESP_RETURN_ON_FALSE(entry->size >= sizeof(pack_font_t), NULL, TAG, "%s: truncated", entry->name);
+    const pack_font_t *header = (const pack_font_t *)blob;
+
+#if !LV_USE_FONT_COMPRESSED
+    ESP_RETURN_ON_FALSE(0 == header->bitmap_format, NULL, TAG, "%s: compressed, enable LV_USE_FONT_COMPRESSED", entry->name);
+#endif
+    ESP_RETURN_ON_FALSE(asset_range_valid(entry, header->glyph_off, header->glyph_num * sizeof(pack_glyph_t))
+                        && asset_range_valid(entry, header->cmap_off, header->cmap_num * sizeof(pack_cmap_t))
+                        && header->bitmap_off < entry->size, NULL, TAG, "%s: corrupted", entry->name);
+
+    asset_font_t *font = calloc(1, sizeof(asset_font_t) + header->cmap_num * sizeof(lv_font_fmt_txt_cmap_t));
+    ESP_RETURN_ON_FALSE(font, NULL, TAG, "no mem for %s", entry->name);
+
+    const pack_glyph_t *glyphs = (const pack_glyph_t *)(blob + header->glyph_off);
+#if LV_FONT_FMT_TXT_LARGE
+    font->dsc.glyph_dsc = (const lv_font_fmt_txt_glyph_dsc_t *)glyphs;
+#else
+    /* Small glyph descriptors only exist in RAM */
+    lv_font_fmt_txt_glyph_dsc_t *glyph_dsc = heap_caps_malloc(header->glyph_num * sizeof(lv_font_fmt_txt_glyph_dsc_t),
+                                                              MALLOC_CAP_SPIRAM);
+    if (NULL == glyph_dsc) {
+        ESP_LOGE(TAG, "no mem for %s", entry->name);
+        free(font);
+        return NULL;
+    }
+    for (size_t i = 0; i < header->glyph_num; i++) {
+        glyph_dsc[i].bitmap_index = glyphs[i].bitmap_index;
+        glyph_dsc[i].adv_w = glyphs[i].adv_w;
+        glyph_dsc[i].box_w = glyphs[i].box_w;
+        glyph_dsc[i].box_h = glyphs[i].box_h;
+        glyph_dsc[i].ofs_x = glyphs[i].ofs_x;
+        glyph_dsc[i].ofs_y = glyphs[i].ofs_y;
+    }
+    font->dsc.glyph_dsc = glyph_dsc;
+#endif
+
+    const pack_cmap_t *cmaps = (const pack_cmap_t *)(blob + header->cmap_off);
+    for (size_t i = 0; i < header->cmap_num; i++) {
+        lv_font_fmt_txt_cmap_t *cmap = &font->cmaps[i];
+        cmap->range_start = cmaps[i].range_start;
+        cmap->range_length = cmaps[i].range_length;
+        cmap->glyph_id_start = cmaps[i].glyph_id_start;
+        cmap->list_length = cmaps[i].list_length;
+        cmap->type = cmaps[i].type;
+        cmap->unicode_list = cmaps[i].unicode_off ? (const uint16_t *)(blob + cmaps[i].unicode_off) : NULL;
+        cmap->glyph_id_ofs_list = cmaps[i].glyph_id_ofs_off ? blob + cmaps[i].glyph_id_ofs_off : NULL;
+    }
+
+    if (PACK_KERN_PAIRS == header->kern_type && asset_range_valid(entry, header->kern_off, sizeof(pack_kern_pairs_t))) {
+        const pack_kern_pairs_t *kern = (const pack_kern_pairs_t *)(blob + header->kern_off);
+        font->kern.pairs.glyph_ids = blob + kern->glyph_ids_off;
+        font->kern.pairs.values = (const int8_t *)(blob + kern->values_off);
+        font->kern.pairs.pair_cnt = kern->pair_cnt;
+        font->kern.pairs.glyph_ids_size = kern->glyph_ids_size;
+        font->dsc.kern_dsc = &font->kern.pairs;
+    } else if (PACK_KERN_CLASSES == header->kern_type
+               && asset_range_valid(entry, header->kern_off, sizeof(pack_kern_classes_t))) {
+        const pack_kern_classes_t *kern = (const pack_kern_classes_t *)(blob + header->kern_off);
+        font->kern.classes.class_pair_values = (const int8_t *)(blob + kern->values_off);
+        font->kern.classes.left_class_mapping = blob + kern->left_off;
+        font->kern.classes.right_class_mapping = blob + kern->right_off;
+        font->kern.classes.left_class_cnt = kern->left_class_cnt;
+        font->kern.classes.right_class_cnt = kern->right_class_cnt;
+        font->dsc.kern_dsc = &font->kern.classes;
+        font->dsc.kern_classes = 1;
+    }
+
+    font->dsc.glyph_bitmap = blob + header->bitmap_off;
+    font->dsc.cmaps = font->cmaps;
+    font->dsc.kern_scale = header->kern_scale;
+    font->dsc.cmap_num = header->cmap_num;
+    font->dsc.bpp = header->bpp;
+    font->dsc.bitmap_format = header->bitmap_format;
+    font->dsc.cache = &font->cache;
+
+    font->font.get_glyph_dsc = lv_font_get_glyph_dsc_fmt_txt;
+    font->font.get_glyph_bitmap = lv_font_get_bitmap_fmt_txt;
+    font->font.line_height = header->line_height;
+    font->font.base_line = header->base_line;
+    font->font.subpx = header->subpx;
+    font->font.underline_position = header->underline_position;
+    font->font.underline_thickness = header->underline_thickness;
+    font->font.dsc = &font->dsc;
+    return font;
+}
+
+static void *asset_get(const char *name, uint8_t type)
+{
+    ESP_RETURN_ON_FALSE(s_base, NULL, TAG, "not initialized");
+    const pack_entry_t *entry = asset_lookup(name);
+    if (NULL == entry || entry->type != type) {
+        ESP_LOGW(TAG, "%s not in the pack", name);
+        return NULL;
+    }
+
+    size_t index = entry - s_entries;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (NULL == s_assets[index]) {
+        const uint8_t *blob = s_base + entry->offset;
+        if (esp_rom_crc32_le(0, blob, entry->size) != entry->crc) {
+            ESP_LOGE(TAG, "%s: CRC mismatch", name);
+        } else {
+            s_assets[index] = PACK_TYPE_IMG == type ? asset_img_load(entry, blob) : asset_font_load(entry, blob);
+        }
+    }
+    void *asset = s_assets[index];
+    xSemaphoreGive(s_lock);
+    return asset;
+}
+
+const lv_img_dsc_t *asset_pack_img(const char *name)
+{
+    return asset_get(name, PACK_TYPE_IMG);
+}
+
+const lv_font_t *asset_pack_font(const char *name)
+{
+    asset_font_t *font = asset_get(name, PACK_TYPE_FONT);
+    return font ? &font->font : LV_FONT_DEFAULT;
+}
+
+esp_err_t asset_pack_init(const char *partition_label, const char *scope)
+{
+    esp_err_t ret = ESP_OK;
+    esp_partition_mmap_handle_t handle = 0;
+    const void *base = NULL;
+
+    ESP_RETURN_ON_FALSE(NULL == s_base, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                                partition_label);
+    ESP_RETURN_ON_FALSE(partition, ESP_ERR_NOT_FOUND, TAG, "no partition %s", partition_label);
+    ESP_RETURN_ON_FALSE(partition->size >= sizeof(pack_header_t), ESP_ERR_INVALID_SIZE, TAG, "partition too small");
+
+    /* Only the pages that are read come into the cache, so the whole partition is mapped */
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &base, &handle),
+                        TAG, "mmap %s failed", partition_label);
+
+    const pack_header_t *header = base;
+    const pack_entry_t *entries = (const pack_entry_t *)(header + 1);
+    ESP_GOTO_ON_FALSE(PACK_MAGIC == header->magic && PACK_VERSION == header->version
+                      && header->size <= partition->size
+                      && sizeof(pack_header_t) + header->count * sizeof(pack_entry_t) <= header->size
+                      && esp_rom_crc32_le(0, (const uint8_t *)entries, header->count * sizeof(pack_entry_t)) == header->index_crc,
+                      ESP_ERR_INVALID_CRC, err, TAG, "no asset pack in %s, flash it with `idf.py flash`", partition_label);
+    ESP_GOTO_ON_FALSE(LV_COLOR_DEPTH == header->color_depth && (16 != LV_COLOR_DEPTH || LV_COLOR_16_SWAP == header->color_swap),
+                      ESP_ERR_INVALID_STATE, err, TAG, "pack built for %u-bit color%s", header->color_depth,
+                      header->color_swap ? ", swapped" : "");
+    for (size_t i = 0; i < header->count; i++) {
+        ESP_GOTO_ON_FALSE(entries[i].offset <= header->size && entries[i].size <= header->size - entries[i].offset,
+                          ESP_ERR_INVALID_CRC, err, TAG, "%.*s out of the pack", PACK_NAME_LEN, entries[i].name);
+    }
+
+    s_assets = calloc(header->count, sizeof(void *));
+    s_lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(s_assets && s_lock, ESP_ERR_NO_MEM, err, TAG, "no mem");
+
+    snprintf(s_scope, sizeof(s_scope), "%s", scope ? scope : "");
+    s_entries = entries;
+    s_count = header->count;
+    s_base = base;
+    ESP_LOGI(TAG, "%u assets, %u KB in %s", header->count, (unsigned)(header->size / 1024), partition_label);
+    return ESP_OK;
+
+err:
+    free(s_assets);
+    s_assets = NULL;
+    if (s_lock) {
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+    }
+    esp_partition_munmap(handle);
+    return ret;
+}
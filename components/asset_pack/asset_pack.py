@@ -0,0 +1,857 @@
+#!/usr/bin/env python
+#
+# SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+# SPDX-License-Identifier: Apache-2.0
+
+"""
+Pack the LVGL images and fonts that projects keep as generated C arrays (LVGL image converter,
+lv_font_conv, SquareLine) into one binary asset partition read by asset_pack.c.
+
+  build   write the pack for one or more projects, assets they share are stored once
+  verify  decode every asset of a pack back and compare it with the C sources
+  report  flash the assets take in each app and in a pack
+
+Only the assets a project's code names are packed, which is what the linker keeps in the app today.
+Fonts use LVGL's own RLE compression when the project enables CONFIG_LV_USE_FONT_COMPRESSED,
+images are RLE compressed per pixel when it saves at least a quarter and expanded once on first use.
+"""
+
+import argparse
+import hashlib
+import re
+import struct
+import sys
+import zlib
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+# Layout, keep in sync with asset_pack.c
+PACK_MAGIC = 0x4B415041                     # "APAK"
+PACK_VERSION = 1
+PACK_NAME_LEN = 32
+PACK_ALIGN = 4
+HEADER = struct.Struct('<IHHIIBBH')         # magic, version, count, size, index crc, color depth, color swap
+ENTRY = struct.Struct('<32sBBHIIII')        # name, type, codec, reserved, offset, size, raw size, crc
+IMG = struct.Struct('<BBHHH')               # cf, reserved, w, h, reserved
+FONT = struct.Struct('<HhbbBBBBHHHIIII')    # see pack_font_t
+GLYPH = struct.Struct('<IIHHhh')            # lv_font_fmt_txt_glyph_dsc_t with LV_FONT_FMT_TXT_LARGE
+CMAP = struct.Struct('<IHHHBBII')
+KERN_PAIRS = struct.Struct('<IB3xII')
+KERN_CLASSES = struct.Struct('<BBHIII')
+
+TYPE_IMG = 1
+TYPE_FONT = 2
+CODEC_NONE = 0
+CODEC_RLE = 1
+
+KERN_NONE = 0
+KERN_PAIRS_TYPE = 1
+KERN_CLASSES_TYPE = 2
+
+# lv_img_cf_t, lv_font_fmt_txt_cmap_type_t and lv_font_subpx_t of LVGL 8
+IMG_CF = {
+    'LV_IMG_CF_TRUE_COLOR': 4,
+    'LV_IMG_CF_TRUE_COLOR_ALPHA': 5,
+    'LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED': 6,
+}
+CMAP_TYPE = {
+    'LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL': 0,
+    'LV_FONT_FMT_TXT_CMAP_SPARSE_FULL': 1,
+    'LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY': 2,
+    'LV_FONT_FMT_TXT_CMAP_SPARSE_TINY': 3,
+}
+SUBPX = {
+    'LV_FONT_SUBPX_NONE': 0,
+    'LV_FONT_SUBPX_HOR': 1,
+    'LV_FONT_SUBPX_VER': 2,
+    'LV_FONT_SUBPX_BOTH': 3,
+}
+IMG_VARIANT = {
+    (8, False): 'LV_COLOR_DEPTH == 1 || LV_COLOR_DEPTH == 8',
+    (16, False): 'LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP == 0',
+    (16, True): 'LV_COLOR_DEPTH == 16 && LV_COLOR_16_SWAP != 0',
+    (32, False): 'LV_COLOR_DEPTH == 32',
+}
+
+# Images are only compressed when it saves this much, the rest is used straight from flash
+IMG_RLE_MAX_RATIO = 0.75
+
+
+class AssetError(Exception):
+    pass
+
+
+class Config:
+    """The LVGL options the C arrays and the pack depend on"""
+
+    def __init__(self, depth: int = 16, swap: bool = False, font_compressed: bool = False,
+                 font_large: bool = False) -> None:
+        self.depth = depth
+        self.swap = swap and depth == 16
+        self.font_compressed = font_compressed
+        self.font_large = font_large
+
+    @classmethod
+    def load(cls, path: Path) -> 'Config':
+        options = dict(re.findall(r'^(CONFIG_\w+)=(.*)$', path.read_text(), re.M))
+        depth = int(options.get('CONFIG_LV_COLOR_DEPTH', 16))
+        for d in (1, 8, 16, 32):
+            if options.get('CONFIG_LV_COLOR_DEPTH_{}'.format(d)) == 'y':
+                depth = d
+        return cls(depth=8 if depth == 1 else depth,
+                   swap=options.get('CONFIG_LV_COLOR_16_SWAP') == 'y',
+                   font_compressed=options.get('CONFIG_LV_USE_FONT_COMPRESSED') == 'y',
+                   font_large=options.get('CONFIG_LV_FONT_FMT_TXT_LARGE') == 'y')
+
+    @classmethod
+    def for_project(cls, project: Path) -> 'Config':
+        for name in ('sdkconfig', 'sdkconfig.defaults'):
+            if (project / name).exists():
+                return cls.load(project / name)
+        return cls()
+
+    def color_size(self) -> int:
+        return self.depth // 8
+
+    def px_size(self, cf: int) -> int:
+        if cf == IMG_CF['LV_IMG_CF_TRUE_COLOR_ALPHA']:
+            return self.color_size() + 1 if self.depth < 32 else 4
+        return self.color_size()
+
+
+# ---------------------------------------------------------------------------------------------------------------------
+# C sources
+
+def strip_comments(text: str) -> str:
+    text = re.sub(r'/\*.*?\*/', ' ', text, flags=re.S)
+    return re.sub(r'//[^\n]*', ' ', text)
+
+
+def parse_numbers(body: str) -> List[int]:
+    return [int(v, 16) if v.lower().startswith(('0x', '-0x')) else int(v)
+            for v in re.findall(r'-?0[xX][0-9a-fA-F]+|-?\d+', strip_comments(body))]
+
+
+def c_array(text: str, name: str) -> List[int]:
+    m = re.search(r'\b' + re.escape(name) + r'\s*\[\s*\]\s*=\s*\{(.*?)\};', text, re.S)
+    if not m:
+        raise AssetError('array {} not found'.format(name))
+    return parse_numbers(m.group(1))
+
+
+def c_struct(text: str, ctype: str, name: Optional[str] = None) -> Tuple[str, Dict[str, str]]:
+    """Fields of a designated initializer, e.g. .header.w = 72"""
+    m = re.search(r'\b' + ctype + r'\s+(' + (re.escape(name) if name else r'\w+') + r')\s*=\s*\{(.*?)\n\};',
+                  text, re.S)
+    if not m:
+        raise AssetError('{} not found'.format(ctype))
+    fields = dict(re.findall(r'\.([\w.]+)\s*=\s*([^,\n]+?)\s*(?:,|\n|$)', strip_comments(m.group(2))))
+    return m.group(1), fields
+
+
+def c_int(fields: Dict[str, str], key: str, default: Optional[int] = None) -> int:
+    if key not in fields:
+        if default is None:
+            raise AssetError('.{} missing'.format(key))
+        return default
+    return int(fields[key], 0)
+
+
+class Image:
+    kind = TYPE_IMG
+
+    def __init__(self, name: str, path: Path, cf: int, w: int, h: int, data: bytes) -> None:
+        self.name = name
+        self.path = path
+        self.cf = cf
+        self.w = w
+        self.h = h
+        self.data = data
+
+    @classmethod
+    def parse(cls, path: Path, text: str, config: Config) -> 'Image':
+        name, fields = c_struct(text, 'lv_img_dsc_t')
+        cf_name = fields.get('header.cf', '')
+        if cf_name not in IMG_CF:
+            raise AssetError('{}: {} is not supported'.format(name, cf_name or 'no color format'))
+        cf = IMG_CF[cf_name]
+        w, h = c_int(fields, 'header.w'), c_int(fields, 'header.h')
+
+        m = re.search(r'\b' + re.escape(fields['data']) + r'\s*\[\s*\]\s*=\s*\{(.*?)\};', text, re.S)
+        if not m:
+            raise AssetError('{}: pixel array {} not found'.format(name, fields['data']))
+        body = m.group(1)
+        variants = {re.sub(r'\s+', ' ', cond.strip()): data
+                    for cond, data in re.findall(r'#if\s+([^\n]+)\n(.*?)#endif', body, re.S)}
+        if variants:
+            key = IMG_VARIANT[(config.depth, config.swap)]
+            if key not in variants:
+                raise AssetError('{}: no pixels for {}'.format(name, key))
+            body = variants[key]
+        # Converters without variants (SquareLine) export for the project's color format only
+        data = bytes(parse_numbers(body))
+        size = w * h * config.px_size(cf)
+        if len(data) < size:
+            raise AssetError('{}: {} bytes of pixels for {}x{}'.format(name, len(data), w, h))
+        # LVGL never reads past data_size, some arrays carry a few stray bytes after it
+        return cls(name, path, cf, w, h, data[:size])
+
+    def app_size(self, config: Config) -> int:
+        return len(self.data) + 12     # lv_img_dsc_t
+
+    def blob(self, config: Config, compress: bool) -> Tuple[int, bytes, int]:
+        header = IMG.pack(self.cf, 0, self.w, self.h, 0)
+        if compress:
+            rle = img_rle_encode(self.data, config.px_size(self.cf))
+            if len(rle) <= len(self.data) * IMG_RLE_MAX_RATIO:
+                return CODEC_RLE, header + rle, len(self.data)
+        return CODEC_NONE, header + self.data, len(self.data)
+
+    def key(self) -> tuple:
+        return (self.cf, self.w, self.h, self.data)
+
+
+class Font:
+    kind = TYPE_FONT
+
+    def __init__(self, name: str, path: Path) -> None:
+        self.name = name
+        self.path = path
+        self.line_height = 0
+        self.base_line = 0
+        self.underline_position = 0
+        self.underline_thickness = 0
+        self.subpx = 0
+        self.bpp = 0
+        self.kern_scale = 0
+        self.bitmap = b''
+        self.glyphs: List[Tuple[int, int, int, int, int, int]] = []
+        self.cmaps: List[dict] = []
+        self.kern: Optional[dict] = None
+
+    @classmethod
+    def parse(cls, path: Path, text: str, config: Config) -> 'Font':
+        name, fields = c_struct(text, 'lv_font_t')
+        font = cls(name, path)
+        font.line_height = c_int(fields, 'line_height')
+        font.base_line = c_int(fields, 'base_line')
+        font.underline_position = c_int(fields, 'underline_position', 0)
+        font.underline_thickness = c_int(fields, 'underline_thickness', 0)
+        font.subpx = SUBPX[fields.get('subpx', 'LV_FONT_SUBPX_NONE')]
+
+        _, dsc = c_struct(text, 'lv_font_fmt_txt_dsc_t', fields['dsc'].lstrip('&').strip())
+        if c_int(dsc, 'bitmap_format', 0) != 0:
+            raise AssetError('{}: only plain bitmaps can be packed, convert the font without compression'.format(name))
+        font.bpp = c_int(dsc, 'bpp')
+        font.kern_scale = c_int(dsc, 'kern_scale', 0)
+        font.bitmap = bytes(c_array(text, dsc['glyph_bitmap']))
+
+        m = re.search(r'\b' + dsc['glyph_dsc'] + r'\s*\[\s*\]\s*=\s*\{(.*?)\n\};', text, re.S)
+        if not m:
+            raise AssetError('{}: glyph_dsc not found'.format(name))
+        for entry in re.findall(r'\{([^{}]*)\}', strip_comments(m.group(1))):
+            g = dict(re.findall(r'\.(\w+)\s*=\s*(-?\w+)', entry))
+            font.glyphs.append(tuple(int(g[k], 0) for k in ('bitmap_index', 'adv_w', 'box_w', 'box_h', 'ofs_x', 'ofs_y')))
+
+        cmap_num = c_int(dsc, 'cmap_num')
+        m = re.search(r'\b' + dsc['cmaps'] + r'\s*\[\s*\]\s*=\s*\{(.*?)\n\};', text, re.S)
+        if not m:
+            raise AssetError('{}: cmaps not found'.format(name))
+        for entry in re.findall(r'\{([^{}]*)\}', strip_comments(m.group(1))):
+            c = dict(re.findall(r'\.(\w+)\s*=\s*(\w+)', entry))
+            cmap = {
+                'range_start': int(c['range_start'], 0),
+                'range_length': int(c['range_length'], 0),
+                'glyph_id_start': int(c['glyph_id_start'], 0),
+                'list_length': int(c['list_length'], 0),
+                'type': CMAP_TYPE[c['type']],
+                'unicode_list': None,
+                'glyph_id_ofs_list': None,
+            }
+            if c['unicode_list'] != 'NULL':
+                cmap['unicode_list'] = c_array(text, c['unicode_list'])
+            if c['glyph_id_ofs_list'] != 'NULL':
+                cmap['glyph_id_ofs_list'] = c_array(text, c['glyph_id_ofs_list'])
+            font.cmaps.append(cmap)
+        if len(font.cmaps) != cmap_num:
+            raise AssetError('{}: {} cmaps, {} expected'.format(name, len(font.cmaps), cmap_num))
+
+        kern = dsc.get('kern_dsc', 'NULL').lstrip('&').strip()
+        if kern != 'NULL':
+            if c_int(dsc, 'kern_classes', 0):
+                _, k = c_struct(text, 'lv_font_fmt_txt_kern_classes_t', kern)
+                font.kern = {
+                    'type': KERN_CLASSES_TYPE,
+                    'values': c_array(text, k['class_pair_values']),
+                    'left': c_array(text, k['left_class_mapping']),
+                    'right': c_array(text, k['right_class_mapping']),
+                    'left_cnt': c_int(k, 'left_class_cnt'),
+                    'right_cnt': c_int(k, 'right_class_cnt'),
+                }
+            else:
+                _, k = c_struct(text, 'lv_font_fmt_txt_kern_pair_t', kern)
+                font.kern = {
+                    'type': KERN_PAIRS_TYPE,
+                    'ids': c_array(text, k['glyph_ids']),
+                    'values': c_array(text, k['values']),
+                    'pair_cnt': c_int(k, 'pair_cnt'),
+                    'ids_size': c_int(k, 'glyph_ids_size', 0),
+                }
+        return font
+
+    def glyph_pixels(self, index: int) -> List[int]:
+        offset, _, w, h, _, _ = self.glyphs[index]
+        return unpack_bits(self.bitmap, offset * 8, w * h, self.bpp)
+
+    def app_size(self, config: Config) -> int:
+        size = len(self.bitmap) + len(self.glyphs) * (GLYPH.size if config.font_large else 8)
+        for cmap in self.cmaps:
+            size += 24 + 2 * len(cmap['unicode_list'] or []) + 2 * len(cmap['glyph_id_ofs_list'] or [])
+        if self.kern:
+            size += 16 + sum(len(v) for k, v in self.kern.items() if isinstance(v, list))
+            if self.kern['type'] == KERN_PAIRS_TYPE and self.kern['ids_size']:
+                size += len(self.kern['ids'])
+        return size + 64    # lv_font_t, lv_font_fmt_txt_dsc_t and the glyph cache
+
+    def blob(self, config: Config, compress: bool) -> Tuple[int, bytes, int]:
+        bitmap_format = 0
+        bitmap, glyphs = self.bitmap, self.glyphs
+        # lv_font_fmt_txt.c only decompresses into whole bytes per pixel for these
+        if compress and config.font_compressed and self.bpp in (1, 2, 4, 8):
+            packed = bytearray()
+            packed_glyphs = []
+            for i, (_, adv_w, w, h, x, y) in enumerate(self.glyphs):
+                packed_glyphs.append((len(packed), adv_w, w, h, x, y))
+                packed += font_rle_encode(self.glyph_pixels(i), w, h, self.bpp)
+            packed += b'\0'     # the decoder may read one byte ahead
+            if len(packed) < len(self.bitmap):
+                bitmap_format, bitmap, glyphs = 1, bytes(packed), packed_glyphs
+
+        body = Blob(FONT.size)
+        bitmap_off = body.add(bitmap)
+        glyph_off = body.add(b''.join(GLYPH.pack(*g) for g in glyphs))
+        cmaps = []
+        for cmap in self.cmaps:
+            unicode_off = body.add(struct.pack('<{}H'.format(len(cmap['unicode_list'])), *cmap['unicode_list'])) \
+                if cmap['unicode_list'] is not None else 0
+            ofs_list_off = 0
+            if cmap['glyph_id_ofs_list'] is not None:
+                fmt = '<{}H' if cmap['type'] == CMAP_TYPE['LV_FONT_FMT_TXT_CMAP_SPARSE_FULL'] else '<{}B'
+                ofs_list_off = body.add(struct.pack(fmt.format(len(cmap['glyph_id_ofs_list'])),
+                                                    *cmap['glyph_id_ofs_list']))
+            cmaps.append(CMAP.pack(cmap['range_start'], cmap['range_length'], cmap['glyph_id_start'],
+                                   cmap['list_length'], cmap['type'], 0, unicode_off, ofs_list_off))
+        cmap_off = body.add(b''.join(cmaps))
+
+        kern_type, kern_off = KERN_NONE, 0
+        if self.kern and self.kern['type'] == KERN_PAIRS_TYPE:
+            k = self.kern
+            ids = struct.pack('<{}{}'.format(len(k['ids']), 'H' if k['ids_size'] else 'B'), *k['ids'])
+            ids_off = body.add(ids)
+            values_off = body.add(struct.pack('<{}b'.format(len(k['values'])), *k['values']))
+            kern_type = KERN_PAIRS_TYPE
+            kern_off = body.add(KERN_PAIRS.pack(k['pair_cnt'], k['ids_size'], ids_off, values_off))
+        elif self.kern:
+            k = self.kern
+            values_off = body.add(struct.pack('<{}b'.format(len(k['values'])), *k['values']))
+            left_off = body.add(bytes(k['left']))
+            right_off = body.add(bytes(k['right']))
+            kern_type = KERN_CLASSES_TYPE
+            kern_off = body.add(KERN_CLASSES.pack(k['left_cnt'], k['right_cnt'], 0, values_off, left_off, right_off))
+
+        header = FONT.pack(self.line_height, self.base_line, self.underline_position, self.underline_thickness,
+                           self.subpx, self.bpp, bitmap_format, kern_type, self.kern_scale, len(self.cmaps),
+                           len(glyphs), bitmap_off, glyph_off, cmap_off, kern_off)
+        data = header + body.data[FONT.size:]
+        return CODEC_NONE, data, len(data)
+
+    def key(self) -> tuple:
+        return (self.line_height, self.base_line, self.underline_position, self.underline_thickness, self.subpx,
+                self.bpp, self.kern_scale, self.bitmap, tuple(self.glyphs), repr(self.cmaps), repr(self.kern))
+
+
+class Blob:
+    """Sections of an asset, each 4-byte aligned so the runtime can point into the mapped flash"""
+
+    def __init__(self, header_size: int) -> None:
+        self.data = bytearray(header_size)
+
+    def add(self, section: bytes) -> int:
+        self.data += b'\0' * (-len(self.data) % PACK_ALIGN)
+        offset = len(self.data)
+        self.data += section
+        return offset
+
+
+def parse_asset(path: Path, config: Config):
+    text = path.read_text(errors='replace')
+    if re.search(r'\blv_font_fmt_txt_dsc_t\b', text) and re.search(r'\blv_font_t\s+\w+\s*=', text):
+        return Font.parse(path, text, config)
+    if re.search(r'\blv_img_dsc_t\s+\w+\s*=', text):
+        return Image.parse(path, text, config)
+    return None
+
+
+class Project:
+    def __init__(self, path: Path, config: Config) -> None:
+        self.path = path
+        self.name = path.name
+        self.config = config
+        self.assets: Dict[str, object] = {}
+        self.referenced: List[str] = []
+        self.missing: List[str] = []
+
+        tokens = set()
+        calls = set()
+        for source in sorted((path / 'main').rglob('*.[ch]')):
+            asset = parse_asset(source, config) if source.suffix == '.c' else None
+            if asset is not None:
+                if asset.name in self.assets:
+                    raise AssetError('{}: {} defined twice'.format(self.name, asset.name))
+                self.assets[asset.name] = asset
+            else:
+                # Declarations alone do not keep an asset in the app
+                text = re.sub(r'LV_(?:IMG|FONT)_DECLARE\s*\(\s*\w+\s*\)', ' ',
+                              strip_comments(source.read_text(errors='replace')))
+                tokens.update(re.findall(r'\w+', text))
+                calls.update(re.findall(r'\basset_pack_(?:img|font)\s*\(\s*"(\w+)"', text))
+
+        self.referenced = sorted(name for name in self.assets if name in tokens)
+        self.missing = sorted(calls - set(self.assets))
+
+    def used(self) -> List[object]:
+        return [self.assets[name] for name in self.referenced]
+
+
+def load_projects(paths: List[str], config: Optional[Config]) -> List[Project]:
+    projects = []
+    for p in paths:
+        path = Path(p).resolve()
+        if not (path / 'main').is_dir():
+            raise AssetError('{} is not a project directory'.format(p))
+        projects.append(Project(path, config or Config.for_project(path)))
+    names = [p.name for p in projects]
+    if len(set(names)) != len(names):
+        raise AssetError('projects with the same name: {}'.format(', '.join(names)))
+    return projects
+
+
+def common_config(projects: List[Project]) -> Config:
+    first = projects[0].config
+    for p in projects[1:]:
+        if (p.config.depth, p.config.swap) != (first.depth, first.swap):
+            raise AssetError('{} and {} use different color formats'.format(projects[0].name, p.name))
+    return Config(first.depth, first.swap,
+                  font_compressed=all(p.config.font_compressed for p in projects),
+                  font_large=first.font_large)
+
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Codecs
+
+class BitWriter:
+    def __init__(self) -> None:
+        self.data = bytearray()
+        self.bits = 0
+
+    def write(self, value: int, length: int) -> None:
+        for i in range(length - 1, -1, -1):
+            if self.bits % 8 == 0:
+                self.data.append(0)
+            if (value >> i) & 1:
+                self.data[-1] |= 0x80 >> (self.bits % 8)
+            self.bits += 1
+
+
+def unpack_bits(data: bytes, bit_pos: int, count: int, bpp: int) -> List[int]:
+    out = []
+    mask = (1 << bpp) - 1
+    for _ in range(count):
+        byte = bit_pos >> 3
+        word = (data[byte] << 8) | (data[byte + 1] if byte + 1 < len(data) else 0)
+        out.append((word >> (16 - (bit_pos & 7) - bpp)) & mask)
+        bit_pos += bpp
+    return out
+
+
+def font_prefilter(pixels: List[int], w: int, h: int) -> List[int]:
+    return pixels[:w] + [pixels[i] ^ pixels[i - w] for i in range(w, w * h)]
+
+
+def font_rle_encode(pixels: List[int], w: int, h: int, bpp: int) -> bytes:
+    """
+    RLE of lv_font_fmt_txt.c with the line prefilter (bitmap_format 1): a value repeated twice switches
+    to one bit per further repeat, after 11 repeats a 6-bit counter follows. Written by mirroring the decoder.
+    """
+    values = font_prefilter(pixels, w, h)
+    bits = BitWriter()
+    single = True
+    prev = 0
+    cnt = 0
+    i = 0
+    while i < len(values):
+        v = values[i]
+        if single:
+            bits.write(v, bpp)
+            if i != 0 and v == prev:
+                single, cnt = False, 0
+            prev = v
+            i += 1
+        elif v == prev:
+            bits.write(1, 1)
+            cnt += 1
+            i += 1
+            if cnt == 11:
+                run = 0
+                while i + run < len(values) and values[i + run] == prev and run < 62:
+                    run += 1
+                bits.write(run + 1, 6)     # run more repeats, then a literal
+                i += run
+                if i < len(values):
+                    prev = values[i]
+                    bits.write(prev, bpp)
+                    i += 1
+                single = True
+        else:
+            bits.write(0, 1)
+            bits.write(v, bpp)
+            prev = v
+            single = True
+            i += 1
+    return bytes(bits.data)
+
+
+def font_rle_decode(data: bytes, offset: int, w: int, h: int, bpp: int) -> List[int]:
+    """Port of rle_next() and decompress() in lv_font_fmt_txt.c, used to check the encoder"""
+    def get_bits(pos: int, length: int) -> int:
+        byte = pos >> 3
+        word = (data[byte] << 8) | (data[byte + 1] if byte + 1 < len(data) else 0)
+        return (word >> (16 - (pos & 7) - length)) & ((1 << length) - 1)
+
+    rdp = offset * 8
+    state, prev, cnt = 'single', 0, 0
+    values = []
+    for _ in range(w * h):
+        if state == 'single':
+            ret = get_bits(rdp, bpp)
+            if rdp != offset * 8 and prev == ret:
+                cnt, state = 0, 'repeat'
+            prev = ret
+            rdp += bpp
+        elif state == 'repeat':
+            v = get_bits(rdp, 1)
+            cnt += 1
+            rdp += 1
+            if v == 1:
+                ret = prev
+                if cnt == 11:
+                    cnt = get_bits(rdp, 6)
+                    rdp += 6
+                    if cnt != 0:
+                        state = 'counter'
+                    else:
+                        ret = get_bits(rdp, bpp)
+                        prev = ret
+                        rdp += bpp
+                        state = 'single'
+            else:
+                ret = get_bits(rdp, bpp)
+                prev = ret
+                rdp += bpp
+                state = 'single'
+        else:
+            ret = prev
+            cnt -= 1
+            if cnt == 0:
+                ret = get_bits(rdp, bpp)
+                prev = ret
+                rdp += bpp
+                state = 'single'
+        values.append(ret)
+
+    for i in range(w, w * h):
+        values[i] ^= values[i - w]
+    return values
+
+
+def img_rle_encode(data: bytes, px: int) -> bytes:
+    """Per pixel RLE: 0x80 | (n - 1) then one pixel repeated n times, or n - 1 then n literal pixels"""
+    out = bytearray()
+    n = len(data) // px
+    i = 0
+    while i < n:
+        pixel = data[i * px:(i + 1) * px]
+        run = 1
+        while i + run < n and run < 128 and data[(i + run) * px:(i + run + 1) * px] == pixel:
+            run += 1
+        if run > 1:
+            out.append(0x80 | (run - 1))
+            out += pixel
+            i += run
+            continue
+        start = i
+        i += 1
+        while i < n and i - start < 128 and not (i + 1 < n and data[i * px:(i + 1) * px] == data[(i + 1) * px:(i + 2) * px]):
+            i += 1
+        out.append(i - start - 1)
+        out += data[start * px:i * px]
+    return bytes(out)
+
+
+def img_rle_decode(data: bytes, px: int, size: int) -> bytes:
+    out = bytearray()
+    i = 0
+    while i < len(data) and len(out) < size:
+        ctrl = data[i]
+        n = (ctrl & 0x7f) + 1
+        if ctrl & 0x80:
+            out += data[i + 1:i + 1 + px] * n
+            i += 1 + px
+        else:
+            out += data[i + 1:i + 1 + n * px]
+            i += 1 + n * px
+    if len(out) != size or i != len(data):
+        raise AssetError('RLE stream decodes to {} bytes, {} expected'.format(len(out), size))
+    return bytes(out)
+
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Pack
+
+def pack_names(projects: List[Project]) -> Dict[str, object]:
+    """Index names, an asset that differs between projects is stored as <project>/<name> for each of them"""
+    variants: Dict[str, Dict[tuple, List[Project]]] = {}
+    for p in projects:
+        for asset in p.used():
+            variants.setdefault(asset.name, {}).setdefault(asset.key(), []).append(p)
+
+    names = {}
+    for name, by_key in variants.items():
+        for owners in by_key.values():
+            asset = owners[0].assets[name]
+            if len(by_key) == 1:
+                names[name] = asset
+            else:
+                for p in owners:
+                    names['{}/{}'.format(p.name, name)] = asset
+    for name in names:
+        if len(name.encode()) >= PACK_NAME_LEN:
+            raise AssetError('{} is longer than {} characters'.format(name, PACK_NAME_LEN - 1))
+    return names
+
+
+def build_pack(projects: List[Project], config: Config, compress: bool = True) -> bytes:
+    names = pack_names(projects)
+    order = sorted(names, key=lambda n: n.encode())
+    data_off = HEADER.size + ENTRY.size * len(order)
+    data = bytearray()
+    stored: Dict[bytes, Tuple[int, int, int, int, int]] = {}
+    entries = []
+    for name in order:
+        asset = names[name]
+        codec, blob, raw_size = asset.blob(config, compress)
+        digest = hashlib.sha256(bytes([asset.kind, codec]) + blob).digest()
+        if digest not in stored:
+            data += b'\0' * (-len(data) % PACK_ALIGN)
+            stored[digest] = (codec, data_off + len(data), len(blob), raw_size, zlib.crc32(blob))
+            data += blob
+        codec, offset, size, raw_size, crc = stored[digest]
+        entries.append(ENTRY.pack(name.encode(), asset.kind, codec, 0, offset, size, raw_size, crc))
+
+    index = b''.join(entries)
+    size = data_off + len(data)
+    header = HEADER.pack(PACK_MAGIC, PACK_VERSION, len(order), size, zlib.crc32(index),
+                         config.depth, int(config.swap), 0)
+    return header + index + bytes(data)
+
+
+class Pack:
+    def __init__(self, data: bytes) -> None:
+        if len(data) < HEADER.size:
+            raise AssetError('not an asset pack')
+        magic, version, count, size, index_crc, depth, swap, _ = HEADER.unpack_from(data)
+        if magic != PACK_MAGIC or version != PACK_VERSION:
+            raise AssetError('not an asset pack of version {}'.format(PACK_VERSION))
+        if size > len(data) or HEADER.size + count * ENTRY.size > size:
+            raise AssetError('pack truncated')
+        index = data[HEADER.size:HEADER.size + count * ENTRY.size]
+        if zlib.crc32(index) != index_crc:
+            raise AssetError('index CRC mismatch')
+        self.data = data[:size]
+        self.config = Config(depth, bool(swap))
+        self.entries = {}
+        for i in range(count):
+            name, kind, codec, _, offset, size_, raw_size, crc = ENTRY.unpack_from(index, i * ENTRY.size)
+            name = name.rstrip(b'\0').decode()
+            if offset + size_ > size:
+                raise AssetError('{}: out of the pack'.format(name))
+            blob = self.data[offset:offset + size_]
+            if zlib.crc32(blob) != crc:
+                raise AssetError('{}: CRC mismatch'.format(name))
+            self.entries[name] = (kind, codec, blob, raw_size, offset)
+
+    def lookup(self, scope: str, name: str):
+        return self.entries.get('{}/{}'.format(scope, name)) or self.entries.get(name)
+
+
+def check_image(image: Image, codec: int, blob: bytes, raw_size: int, config: Config) -> None:
+    cf, _, w, h, _ = IMG.unpack_from(blob)
+    if (cf, w, h) != (image.cf, image.w, image.h):
+        raise AssetError('{}: header differs'.format(image.name))
+    pixels = blob[IMG.size:]
+    if codec == CODEC_RLE:
+        pixels = img_rle_decode(pixels, config.px_size(cf), raw_size)
+    if pixels != image.data:
+        raise AssetError('{}: pixels differ'.format(image.name))
+
+
+def check_font(font: Font, blob: bytes) -> None:
+    (line_height, base_line, ul_pos, ul_thick, subpx, bpp, bitmap_format, kern_type, kern_scale, cmap_num,
+     glyph_num, bitmap_off, glyph_off, cmap_off, kern_off) = FONT.unpack_from(blob)
+    if (line_height, base_line, ul_pos, ul_thick, subpx, bpp, kern_scale) != \
+            (font.line_height, font.base_line, font.underline_position, font.underline_thickness, font.subpx,
+             font.bpp, font.kern_scale):
+        raise AssetError('{}: metrics differ'.format(font.name))
+    if glyph_num != len(font.glyphs) or cmap_num != len(font.cmaps):
+        raise AssetError('{}: glyph or cmap count differs'.format(font.name))
+
+    for i, glyph in enumerate(font.glyphs):
+        packed = GLYPH.unpack_from(blob, glyph_off + i * GLYPH.size)
+        if packed[1:] != glyph[1:]:
+            raise AssetError('{}: glyph {} metrics differ'.format(font.name, i))
+        w, h = glyph[2], glyph[3]
+        if bitmap_format == 1:
+            pixels = font_rle_decode(blob, bitmap_off + packed[0], w, h, bpp)
+        else:
+            pixels = unpack_bits(blob, (bitmap_off + packed[0]) * 8, w * h, bpp)
+        if pixels != font.glyph_pixels(i):
+            raise AssetError('{}: glyph {} pixels differ'.format(font.name, i))
+
+    for i, cmap in enumerate(font.cmaps):
+        start, length, gid, list_length, ctype, _, unicode_off, ofs_off = CMAP.unpack_from(blob, cmap_off + i * CMAP.size)
+        if (start, length, gid, list_length, ctype) != \
+                (cmap['range_start'], cmap['range_length'], cmap['glyph_id_start'], cmap['list_length'], cmap['type']):
+            raise AssetError('{}: cmap {} differs'.format(font.name, i))
+        if cmap['unicode_list'] is not None and \
+                list(struct.unpack_from('<{}H'.format(list_length), blob, unicode_off)) != cmap['unicode_list']:
+            raise AssetError('{}: cmap {} unicode list differs'.format(font.name, i))
+        if cmap['glyph_id_ofs_list'] is not None:
+            fmt = '<{}H' if ctype == CMAP_TYPE['LV_FONT_FMT_TXT_CMAP_SPARSE_FULL'] else '<{}B'
+            ofs = list(struct.unpack_from(fmt.format(len(cmap['glyph_id_ofs_list'])), blob, ofs_off))
+            if ofs != cmap['glyph_id_ofs_list']:
+                raise AssetError('{}: cmap {} glyph id list differs'.format(font.name, i))
+
+    k = font.kern
+    if (k['type'] if k else KERN_NONE) != kern_type:
+        raise AssetError('{}: kerning type differs'.format(font.name))
+    if kern_type == KERN_PAIRS_TYPE:
+        pair_cnt, ids_size, ids_off, values_off = KERN_PAIRS.unpack_from(blob, kern_off)
+        ids = struct.unpack_from('<{}{}'.format(len(k['ids']), 'H' if ids_size else 'B'), blob, ids_off)
+        values = struct.unpack_from('<{}b'.format(len(k['values'])), blob, values_off)
+        if (pair_cnt, ids_size, list(ids), list(values)) != (k['pair_cnt'], k['ids_size'], k['ids'], k['values']):
+            raise AssetError('{}: kerning pairs differ'.format(font.name))
+    elif kern_type == KERN_CLASSES_TYPE:
+        left_cnt, right_cnt, _, values_off, left_off, right_off = KERN_CLASSES.unpack_from(blob, kern_off)
+        values = struct.unpack_from('<{}b'.format(len(k['values'])), blob, values_off)
+        left = blob[left_off:left_off + len(k['left'])]
+        right = blob[right_off:right_off + len(k['right'])]
+        if (left_cnt, right_cnt, list(values), list(left), list(right)) != \
+                (k['left_cnt'], k['right_cnt'], k['values'], k['left'], k['right']):
+            raise AssetError('{}: kerning classes differ'.format(font.name))
+
+
+def verify_pack(pack: Pack, projects: List[Project]) -> int:
+    """Every asset a project names decodes to exactly its C array, returns the number checked"""
+    checked = 0
+    for p in projects:
+        if (p.config.depth, p.config.swap) != (pack.config.depth, pack.config.swap):
+            raise AssetError('{}: pack is for {}-bit color{}'.format(p.name, pack.config.depth,
+                                                                   ', swapped' if pack.config.swap else ''))
+        for asset in p.used():
+            found = pack.lookup(p.name, asset.name)
+            if found is None:
+                raise AssetError('{}: {} is not in the pack'.format(p.name, asset.name))
+            kind, codec, blob, raw_size, _ = found
+            if kind != asset.kind:
+                raise AssetError('{}: {} has another type in the pack'.format(p.name, asset.name))
+            if kind == TYPE_IMG:
+                check_image(asset, codec, blob, raw_size, pack.config)
+            else:
+                check_font(asset, blob)
+            checked += 1
+    return checked
+
+
+# ---------------------------------------------------------------------------------------------------------------------
+# Commands
+
+def cmd_build(args: argparse.Namespace) -> None:
+    config = Config.load(Path(args.sdkconfig)) if args.sdkconfig else None
+    projects = load_projects(args.projects, config)
+    pack = build_pack(projects, common_config(projects), compress=not args.no_compress)
+    verify_pack(Pack(pack), projects)
+    if args.size and len(pack) > args.size:
+        raise AssetError('pack is {} bytes, the partition {}'.format(len(pack), args.size))
+    Path(args.output).write_bytes(pack)
+    for p in projects:
+        for name in p.missing:
+            print('warning: {}: {} is named but not found'.format(p.name, name), file=sys.stderr)
+    print('{}: {} assets, {} bytes'.format(args.output, len(Pack(pack).entries), len(pack)))
+
+
+def cmd_verify(args: argparse.Namespace) -> None:
+    config = Config.load(Path(args.sdkconfig)) if args.sdkconfig else None
+    projects = load_projects(args.projects, config)
+    pack = Pack(Path(args.pack).read_bytes())
+    print('{}: {} assets checked, OK'.format(args.pack, verify_pack(pack, projects)))
+
+
+def cmd_report(args: argparse.Namespace) -> None:
+    config = Config.load(Path(args.sdkconfig)) if args.sdkconfig else None
+    projects = load_projects(args.projects, config)
+    print('{:<16} {:>6} {:>12} {:>12} {:>12}'.format('project', 'assets', 'in app KB', 'packed KB', 'saved KB'))
+    total_app = total_packed = 0
+    for p in projects:
+        app = sum(a.app_size(p.config) for a in p.used())
+        packed = len(build_pack([p], p.config)) if p.referenced else 0
+        total_app += app
+        total_packed += packed
+        print('{:<16} {:>6} {:>12.1f} {:>12.1f} {:>12.1f}'.format(p.name, len(p.referenced), app / 1024,
+                                                                  packed / 1024, (app - packed) / 1024))
+    if len(projects) > 1:
+        shared = len(build_pack(projects, common_config(projects)))
+        print('{:<16} {:>6} {:>12.1f} {:>12.1f} {:>12.1f}'.format('all', '', total_app / 1024, total_packed / 1024,
+                                                                  (total_app - total_packed) / 1024))
+        print('one pack shared by all: {:.1f} KB'.format(shared / 1024))
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--sdkconfig', help='LVGL options of the build, default: sdkconfig(.defaults) of each project')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    build = sub.add_parser('build', help='write a pack')
+    build.add_argument('-o', '--output', required=True)
+    build.add_argument('--size', type=lambda v: int(v, 0), help='partition size to check the pack against')
+    build.add_argument('--no-compress', action='store_true')
+    build.add_argument('projects', nargs='+')
+    build.set_defaults(func=cmd_build)
+
+    verify = sub.add_parser('verify', help='check a pack against the C sources')
+    verify.add_argument('pack')
+    verify.add_argument('projects', nargs='+')
+    verify.set_defaults(func=cmd_verify)
+
+    report = sub.add_parser('report', help='flash used by assets per project')
+    report.add_argument('projects', nargs='+')
+    report.set_defaults(func=cmd_report)
+
+    args = parser.parse_args()
+    try:
+        args.func(args)
+    except AssetError as e:
+        sys.exit('error: {}'.format(e))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,619 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Round trip of one example's assets: C arrays -> asset_pack.py -> pack -> asset_pack.c -> LVGL descriptors, compared
+ * with the same C arrays compiled into this test. Nothing of asset_pack.py is used to check its output: pixels and
+ * fonts are compared field by field against the compiler's view of the arrays, compressed glyphs are expanded by a
+ * decoder written after lv_font_fmt_txt.c of LVGL v8.3.
+ *
+ * The packs are built by CMakeLists.txt: with compression, without, and one shared by all the examples that is read
+ * with this project as the scope. Every asset of the pack has to have a C array, and the shared pack has to give the
+ * project its own copy of everything in its pack. Then corrupted packs have to be refused. Exits with 1 on failure.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fake_partition.h"
+#include "asset_pack.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define PARTITION_LABEL     "assets"
+#define PARTITION_SIZE      (2 * 1024 * 1024)
+#define GLYPH_PX_MAX        (256 * 256)
+
+typedef struct {
+    const char *name;
+    const lv_img_dsc_t *img;
+    const lv_font_t *font;
+} test_asset_t;
+
+/* s_test_assets[], every array of main/gui/font and main/gui/image, generated by CMakeLists.txt */
+#include "project_assets.h"
+
+#define TEST_ASSET_COUNT    (sizeof(s_test_assets) / sizeof(s_test_assets[0]))
+
+typedef struct {
+    int images;
+    int images_rle;
+    int fonts;
+    int fonts_rle;
+    int glyphs;
+} pack_stats_t;
+
+/* Assets of the project's own pack, the shared pack has to hold all of them */
+static bool s_packed[TEST_ASSET_COUNT];
+
+static const uint8_t *s_flash;
+static size_t s_flash_size;
+
+/* The font engine itself is not under test, asset_pack.c only takes the address of these */
+bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t unicode_letter,
+                                   uint32_t unicode_letter_next)
+{
+    return false;
+}
+
+const uint8_t *lv_font_get_bitmap_fmt_txt(const lv_font_t *font, uint32_t letter)
+{
+    return NULL;
+}
+
+const lv_font_t lv_font_montserrat_14;
+
+static const test_asset_t *find_test_asset(const char *name)
+{
+    for (size_t i = 0; i < TEST_ASSET_COUNT; i++) {
+        if (0 == strcmp(s_test_assets[i].name, name)) {
+            return &s_test_assets[i];
+        }
+    }
+    return NULL;
+}
+
+static bool in_flash(const void *ptr)
+{
+    return (const uint8_t *)ptr >= s_flash && (const uint8_t *)ptr < s_flash + s_flash_size;
+}
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+
+    if (f && 0 == fseek(f, 0, SEEK_END)) {
+        long len = ftell(f);
+        data = len > 0 ? malloc(len) : NULL;
+        if (data && (0 != fseek(f, 0, SEEK_SET) || fread(data, 1, len, f) != (size_t) len)) {
+            free(data);
+            data = NULL;
+        }
+        *size = data ? (size_t) len : 0;
+    }
+    if (f) {
+        fclose(f);
+    }
+    return data;
+}
+
+/* The pack file as partition content, erased flash after it */
+static uint8_t *pack_load(const char *path, size_t *size)
+{
+    uint8_t *data = read_file(path, size);
+    if (NULL == data) {
+        printf("FAIL cannot read %s\n", path);
+        return NULL;
+    }
+    uint8_t *flash = fake_partition_load(PARTITION_LABEL, data, *size, PARTITION_SIZE);
+    free(data);
+    s_flash = flash;
+    s_flash_size = PARTITION_SIZE;
+    return flash;
+}
+
+/* asset_pack.c is made to be initialized once per boot, take it back to that state */
+static void pack_close(void)
+{
+    for (size_t i = 0; s_assets && i < s_count; i++) {
+        if (NULL == s_assets[i]) {
+            continue;
+        }
+        if (PACK_TYPE_IMG == s_entries[i].type) {
+            lv_img_dsc_t *img = s_assets[i];
+            if (!in_flash(img->data)) {
+                free((void *) img->data);
+            }
+        } else {
+            asset_font_t *font = s_assets[i];
+            if (!in_flash(font->dsc.glyph_dsc)) {
+                free((void *) font->dsc.glyph_dsc);
+            }
+        }
+        free(s_assets[i]);
+    }
+    free(s_assets);
+    if (s_lock) {
+        vSemaphoreDelete(s_lock);
+    }
+    s_assets = NULL;
+    s_lock = NULL;
+    s_base = NULL;
+    s_entries = NULL;
+    s_count = 0;
+    s_scope[0] = '\0';
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/* Glyph bitmaps, after lv_font_fmt_txt.c of LVGL v8.3 */
+
+typedef struct {
+    const uint8_t *in;
+    const uint8_t *end;         /* Reads past this are an error, the decoder may look one byte ahead */
+    uint32_t rdp;
+    uint8_t bpp;
+    uint8_t prev_v;
+    uint8_t cnt;
+    enum {
+        RLE_STATE_SINGLE,
+        RLE_STATE_REPEATE,
+        RLE_STATE_COUNTER,
+    } state;
+    bool overrun;
+} rle_t;
+
+static uint8_t rle_bits(rle_t *rle, uint32_t len)
+{
+    uint32_t byte_pos = rle->rdp >> 3;
+    uint32_t bit_pos = rle->rdp & 0x7;
+    uint32_t value;
+
+    /* Like get_bits(), two bytes are read as soon as the field reaches a byte boundary */
+    if (bit_pos + len >= 8) {
+        if (rle->in + byte_pos + 1 >= rle->end) {
+            rle->overrun = true;
+            return 0;
+        }
+        value = ((uint32_t) rle->in[byte_pos] << 8 | rle->in[byte_pos + 1]) >> (16 - bit_pos - len);
+    } else {
+        if (rle->in + byte_pos >= rle->end) {
+            rle->overrun = true;
+            return 0;
+        }
+        value = rle->in[byte_pos] >> (8 - bit_pos - len);
+    }
+    rle->rdp += len;
+    return value & ((1u << len) - 1);
+}
+
+static uint8_t rle_next(rle_t *rle)
+{
+    uint8_t ret = 0;
+
+    if (RLE_STATE_SINGLE == rle->state) {
+        uint32_t rdp = rle->rdp;
+        ret = rle_bits(rle, rle->bpp);
+        if (0 != rdp && rle->prev_v == ret) {
+            rle->cnt = 0;
+            rle->state = RLE_STATE_REPEATE;
+        }
+        rle->prev_v = ret;
+    } else if (RLE_STATE_REPEATE == rle->state) {
+        uint8_t v = rle_bits(rle, 1);
+        rle->cnt++;
+        if (1 == v) {
+            ret = rle->prev_v;
+            if (11 == rle->cnt) {
+                rle->cnt = rle_bits(rle, 6);
+                if (0 != rle->cnt) {
+                    rle->state = RLE_STATE_COUNTER;
+                } else {
+                    ret = rle_bits(rle, rle->bpp);
+                    rle->prev_v = ret;
+                    rle->state = RLE_STATE_SINGLE;
+                }
+            }
+        } else {
+            ret = rle_bits(rle, rle->bpp);
+            rle->prev_v = ret;
+            rle->state = RLE_STATE_SINGLE;
+        }
+    } else {
+        ret = rle->prev_v;
+        rle->cnt--;
+        if (0 == rle->cnt) {
+            ret = rle_bits(rle, rle->bpp);
+            rle->prev_v = ret;
+            rle->state = RLE_STATE_SINGLE;
+        }
+    }
+    return ret;
+}
+
+/* Compressed glyph, each line XORed with the one above it */
+static bool glyph_decompress(const uint8_t *in, const uint8_t *end, uint8_t *px, int w, int h, uint8_t bpp)
+{
+    rle_t rle = {.in = in, .end = end, .bpp = bpp, .state = RLE_STATE_SINGLE};
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            px[y * w + x] = rle_next(&rle) ^ (y ? px[(y - 1) * w + x] : 0);
+        }
+    }
+    return !rle.overrun;
+}
+
+/* Plain glyph, pixels packed MSB first without padding between lines, `end` NULL for no bound */
+static bool glyph_unpack(const uint8_t *in, const uint8_t *end, uint8_t *px, int w, int h, uint8_t bpp)
+{
+    for (int i = 0; i < w * h; i++) {
+        uint32_t bit = (uint32_t) i * bpp;
+        if (end && in + bit / 8 >= end) {
+            return false;
+        }
+        px[i] = (in[bit / 8] >> (8 - bit % 8 - bpp)) & ((1u << bpp) - 1);
+    }
+    return true;
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/* Comparisons */
+
+static bool check_img(const pack_entry_t *entry, const lv_img_dsc_t *got, const lv_img_dsc_t *want, pack_stats_t *stats)
+{
+    CHECK(got->header.cf == want->header.cf && got->header.w == want->header.w && got->header.h == want->header.h,
+          "%s: cf %u %ux%u, the C array has cf %u %ux%u", entry->name, got->header.cf, got->header.w, got->header.h,
+          want->header.cf, want->header.w, want->header.h);
+    CHECK(got->data_size == want->data_size, "%s: %u bytes, the C array has %u", entry->name,
+          (unsigned) got->data_size, (unsigned) want->data_size);
+    for (uint32_t i = 0; i < want->data_size; i++) {
+        CHECK(got->data[i] == want->data[i], "%s: byte %u is 0x%02x, the C array has 0x%02x", entry->name,
+              (unsigned) i, got->data[i], want->data[i]);
+    }
+    /* Uncompressed images are not copied out of flash */
+    CHECK(in_flash(got->data) == (PACK_CODEC_NONE == entry->codec), "%s: pixels %s flash", entry->name,
+          in_flash(got->data) ? "in" : "not in");
+    stats->images++;
+    stats->images_rle += PACK_CODEC_RLE == entry->codec;
+    return true;
+}
+
+static size_t cmap_ofs_list_size(const lv_font_fmt_txt_cmap_t *cmap)
+{
+    switch (cmap->type) {
+    case LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL:
+        return cmap->range_length;
+    case LV_FONT_FMT_TXT_CMAP_SPARSE_FULL:
+        return cmap->list_length * sizeof(uint16_t);
+    default:
+        return 0;
+    }
+}
+
+/* Highest glyph id any cmap maps to, + 1 */
+static uint32_t font_glyph_count(const lv_font_fmt_txt_dsc_t *dsc)
+{
+    uint32_t count = 1;     /* Glyph 0 is reserved */
+
+    for (uint16_t c = 0; c < dsc->cmap_num; c++) {
+        const lv_font_fmt_txt_cmap_t *cmap = &dsc->cmaps[c];
+        uint32_t last = 0;
+        if (LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL == cmap->type) {
+            const uint8_t *ofs = cmap->glyph_id_ofs_list;
+            for (uint16_t i = 0; i < cmap->range_length; i++) {
+                last = ofs[i] > last ? ofs[i] : last;
+            }
+        } else if (LV_FONT_FMT_TXT_CMAP_SPARSE_FULL == cmap->type) {
+            const uint16_t *ofs = cmap->glyph_id_ofs_list;
+            for (uint16_t i = 0; i < cmap->list_length; i++) {
+                last = ofs[i] > last ? ofs[i] : last;
+            }
+        } else {
+            uint32_t n = LV_FONT_FMT_TXT_CMAP_SPARSE_TINY == cmap->type ? cmap->list_length : cmap->range_length;
+            last = n ? n - 1 : 0;
+        }
+        count = cmap->glyph_id_start + last + 1 > count ? cmap->glyph_id_start + last + 1 : count;
+    }
+    return count;
+}
+
+static bool check_cmaps(const char *name, const lv_font_fmt_txt_dsc_t *got, const lv_font_fmt_txt_dsc_t *want)
+{
+    for (uint16_t c = 0; c < want->cmap_num; c++) {
+        const lv_font_fmt_txt_cmap_t *g = &got->cmaps[c];
+        const lv_font_fmt_txt_cmap_t *w = &want->cmaps[c];
+        CHECK(g->range_start == w->range_start && g->range_length == w->range_length
+              && g->glyph_id_start == w->glyph_id_start && g->list_length == w->list_length && g->type == w->type,
+              "%s: cmap %u differs", name, c);
+        CHECK(!g->unicode_list == !w->unicode_list
+              && (!w->unicode_list || 0 == memcmp(g->unicode_list, w->unicode_list, w->list_length * sizeof(uint16_t))),
+              "%s: unicode list of cmap %u differs", name, c);
+        CHECK(!g->glyph_id_ofs_list == !w->glyph_id_ofs_list
+              && (!w->glyph_id_ofs_list
+                  || 0 == memcmp(g->glyph_id_ofs_list, w->glyph_id_ofs_list, cmap_ofs_list_size(w))),
+              "%s: glyph id list of cmap %u differs", name, c);
+    }
+    return true;
+}
+
+static bool check_kern(const char *name, const lv_font_fmt_txt_dsc_t *got, const lv_font_fmt_txt_dsc_t *want,
+                       uint32_t glyphs)
+{
+    CHECK(!got->kern_dsc == !want->kern_dsc && got->kern_classes == want->kern_classes
+          && got->kern_scale == want->kern_scale, "%s: kerning differs", name);
+    if (!want->kern_dsc) {
+        return true;
+    }
+    if (want->kern_classes) {
+        const lv_font_fmt_txt_kern_classes_t *g = got->kern_dsc;
+        const lv_font_fmt_txt_kern_classes_t *w = want->kern_dsc;
+        CHECK(g->left_class_cnt == w->left_class_cnt && g->right_class_cnt == w->right_class_cnt
+              && 0 == memcmp(g->class_pair_values, w->class_pair_values, w->left_class_cnt * w->right_class_cnt)
+              && 0 == memcmp(g->left_class_mapping, w->left_class_mapping, glyphs)
+              && 0 == memcmp(g->right_class_mapping, w->right_class_mapping, glyphs),
+              "%s: kerning classes differ", name);
+    } else {
+        const lv_font_fmt_txt_kern_pair_t *g = got->kern_dsc;
+        const lv_font_fmt_txt_kern_pair_t *w = want->kern_dsc;
+        size_t id_size = w->glyph_ids_size ? sizeof(uint16_t) : sizeof(uint8_t);
+        CHECK(g->pair_cnt == w->pair_cnt && g->glyph_ids_size == w->glyph_ids_size
+              && 0 == memcmp(g->glyph_ids, w->glyph_ids, 2 * w->pair_cnt * id_size)
+              && 0 == memcmp(g->values, w->values, w->pair_cnt),
+              "%s: kerning pairs differ", name);
+    }
+    return true;
+}
+
+static bool check_font(const pack_entry_t *entry, const lv_font_t *got, const lv_font_t *want, pack_stats_t *stats)
+{
+    const lv_font_fmt_txt_dsc_t *gd = got->dsc;
+    const lv_font_fmt_txt_dsc_t *wd = want->dsc;
+    const uint8_t *blob_end = s_base + entry->offset + entry->size;
+    static uint8_t got_px[GLYPH_PX_MAX];
+    static uint8_t want_px[GLYPH_PX_MAX];
+
+    CHECK(got->line_height == want->line_height && got->base_line == want->base_line && got->subpx == want->subpx
+          && got->underline_position == want->underline_position
+          && got->underline_thickness == want->underline_thickness, "%s: metrics differ", entry->name);
+    CHECK(got->get_glyph_dsc == want->get_glyph_dsc && got->get_glyph_bitmap == want->get_glyph_bitmap,
+          "%s: not an lv_font_fmt_txt font", entry->name);
+    CHECK(LV_FONT_FMT_TXT_PLAIN == wd->bitmap_format, "%s: the C array is compressed already", entry->name);
+    CHECK(gd->bpp == wd->bpp && gd->cmap_num == wd->cmap_num && gd->cache && gd->cache != wd->cache,
+          "%s: bpp %u, %u cmaps, the C array has bpp %u, %u cmaps", entry->name, gd->bpp, gd->cmap_num, wd->bpp,
+          wd->cmap_num);
+    if (!check_cmaps(entry->name, gd, wd)) {
+        return false;
+    }
+
+    uint32_t glyphs = font_glyph_count(wd);
+    const pack_font_t *header = (const pack_font_t *)(s_base + entry->offset);
+    CHECK(header->glyph_num == glyphs, "%s: %u glyphs, the cmaps reach %u", entry->name, header->glyph_num,
+          (unsigned) glyphs);
+    if (!check_kern(entry->name, gd, wd, glyphs)) {
+        return false;
+    }
+    /* Descriptors in the layout of LV_FONT_FMT_TXT_LARGE are used straight from flash */
+    CHECK(in_flash(gd->glyph_dsc) == (bool) LV_FONT_FMT_TXT_LARGE, "%s: glyph descriptors %s flash", entry->name,
+          in_flash(gd->glyph_dsc) ? "in" : "not in");
+
+    for (uint32_t id = 0; id < glyphs; id++) {
+        const lv_font_fmt_txt_glyph_dsc_t *g = &gd->glyph_dsc[id];
+        const lv_font_fmt_txt_glyph_dsc_t *w = &wd->glyph_dsc[id];
+        CHECK(g->adv_w == w->adv_w && g->box_w == w->box_w && g->box_h == w->box_h && g->ofs_x == w->ofs_x
+              && g->ofs_y == w->ofs_y, "%s: glyph %u metrics differ", entry->name, (unsigned) id);
+        CHECK(w->box_w * w->box_h <= GLYPH_PX_MAX, "%s: glyph %u is %ux%u", entry->name, (unsigned) id, w->box_w,
+              w->box_h);
+
+        /* The size of the C array is not known here, ASan watches its end */
+        glyph_unpack(wd->glyph_bitmap + w->bitmap_index, NULL, want_px, w->box_w, w->box_h, wd->bpp);
+        const uint8_t *in = gd->glyph_bitmap + g->bitmap_index;
+        bool ok = LV_FONT_FMT_TXT_PLAIN == gd->bitmap_format
+                  ? glyph_unpack(in, blob_end, got_px, g->box_w, g->box_h, gd->bpp)
+                  : glyph_decompress(in, blob_end, got_px, g->box_w, g->box_h, gd->bpp);
+        CHECK(ok, "%s: glyph %u runs past the end of the font", entry->name, (unsigned) id);
+        CHECK(0 == memcmp(got_px, want_px, w->box_w * w->box_h), "%s: glyph %u pixels differ", entry->name,
+              (unsigned) id);
+    }
+    stats->fonts++;
+    stats->fonts_rle += LV_FONT_FMT_TXT_PLAIN != gd->bitmap_format;
+    stats->glyphs += glyphs;
+    return true;
+}
+
+/* The asset asset_pack.c builds for `name`, against its C array, twice to see it cached */
+static bool check_asset(const char *name, const test_asset_t *asset, pack_stats_t *stats)
+{
+    const pack_entry_t *entry = asset_lookup(name);
+    CHECK(entry, "%s not in the pack", name);
+
+    if (asset->img) {
+        const lv_img_dsc_t *img = asset_pack_img(name);
+        CHECK(img, "%s not loaded", name);
+        CHECK(img == asset_pack_img(name), "%s loaded twice", name);
+        CHECK(LV_FONT_DEFAULT == asset_pack_font(name), "%s is a font", name);
+        return check_img(entry, img, asset->img, stats);
+    }
+    const lv_font_t *font = asset_pack_font(name);
+    CHECK(font && LV_FONT_DEFAULT != font, "%s not loaded", name);
+    CHECK(font == asset_pack_font(name), "%s loaded twice", name);
+    CHECK(NULL == asset_pack_img(name), "%s is an image", name);
+    return check_font(entry, font, asset->font, stats);
+}
+
+/* Every asset of a pack built from this project alone has its C array */
+static bool check_own_pack(const char *path, pack_stats_t *stats)
+{
+    size_t size = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    CHECK(pack_load(path, &size), "no pack");
+    CHECK(ESP_OK == asset_pack_init(PARTITION_LABEL, NULL), "init failed");
+    CHECK(s_count > 0, "empty pack");
+
+    bool ok = true;
+    memset(s_packed, 0, sizeof(s_packed));
+    for (size_t i = 0; ok && i < s_count; i++) {
+        char name[PACK_NAME_LEN + 1] = { 0 };
+        memcpy(name, s_entries[i].name, PACK_NAME_LEN);
+        const test_asset_t *asset = find_test_asset(name);
+        if (NULL == asset) {
+            printf("FAIL %s: %s has no C array in " PROJECT_NAME "\n", path, name);
+            ok = false;
+            break;
+        }
+        s_packed[asset - s_test_assets] = true;
+        ok = check_asset(name, asset, stats);
+    }
+    pack_close();
+    printf("  %-16s %3d images, %3d RLE   %3d fonts, %3d compressed   %5d glyphs   %4zu KB\n",
+           strrchr(path, '/') + 1, stats->images, stats->images_rle, stats->fonts, stats->fonts_rle, stats->glyphs,
+           size / 1024);
+    return ok;
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/* Tests */
+
+static bool test_compressed(void)
+{
+    pack_stats_t stats;
+
+    CHECK(check_own_pack(PACK_DIR "/assets.bin", &stats), "round trip failed");
+    CHECK(stats.fonts == stats.fonts_rle, "%d of %d fonts compressed", stats.fonts_rle, stats.fonts);
+    return true;
+}
+
+static bool test_plain(void)
+{
+    pack_stats_t stats;
+    bool packed[TEST_ASSET_COUNT];
+
+    memcpy(packed, s_packed, sizeof(packed));
+    CHECK(check_own_pack(PACK_DIR "/assets_plain.bin", &stats), "round trip failed");
+    CHECK(0 == stats.images_rle && 0 == stats.fonts_rle, "compressed without compression");
+    CHECK(0 == memcmp(packed, s_packed, sizeof(packed)), "other assets than with compression");
+    return true;
+}
+
+/* A pack of all the examples, this project's copy of each of its assets */
+static bool test_shared(void)
+{
+    pack_stats_t stats = { 0 };
+    size_t size = 0;
+    int scoped = 0;
+
+    CHECK(pack_load(SHARED_PACK, &size), "no pack");
+    CHECK(ESP_OK == asset_pack_init(PARTITION_LABEL, PROJECT_NAME), "init failed");
+    for (size_t i = 0; i < s_count; i++) {
+        scoped += 0 == strncmp(s_entries[i].name, PROJECT_NAME "/", strlen(PROJECT_NAME "/"));
+    }
+    bool ok = true;
+    for (size_t i = 0; ok && i < TEST_ASSET_COUNT; i++) {
+        if (s_packed[i]) {
+            ok = check_asset(s_test_assets[i].name, &s_test_assets[i], &stats);
+        }
+    }
+    size_t count = s_count;
+    pack_close();
+    printf("  %-16s %3d images, %3d RLE   %3d fonts, %3d compressed   %5d glyphs   %4zu KB, %zu assets, "
+           "%d own copies\n", "shared.bin", stats.images, stats.images_rle, stats.fonts, stats.fonts_rle, stats.glyphs,
+           size / 1024, count, scoped);
+    return ok;
+}
+
+static bool test_lookup(void)
+{
+    size_t size = 0;
+
+    CHECK(NULL == asset_pack_img("esp_logo"), "image before init");
+    CHECK(pack_load(PACK_DIR "/assets.bin", &size), "no pack");
+    CHECK(ESP_OK == asset_pack_init(PARTITION_LABEL, NULL), "init failed");
+    CHECK(ESP_ERR_INVALID_STATE == asset_pack_init(PARTITION_LABEL, NULL), "initialized twice");
+    bool ok = NULL == asset_pack_img("no_such_asset") && LV_FONT_DEFAULT == asset_pack_font("no_such_asset")
+              && NULL == asset_pack_img("") && NULL == asset_pack_img("a_name_longer_than_the_index_allows_for");
+    pack_close();
+    CHECK(ok, "unknown names found");
+    CHECK(ESP_ERR_NOT_FOUND == asset_pack_init("nvs", NULL), "partition nvs found");
+    return true;
+}
+
+/* The index, a truncated pack and another color format are refused at init, a corrupted asset when it is used */
+static bool test_corrupted(void)
+{
+    size_t size = 0;
+    uint8_t *flash = pack_load(PACK_DIR "/assets.bin", &size);
+    CHECK(flash, "no pack");
+
+    int mapped = fake_partition_mapped();
+    flash[sizeof(pack_header_t) + 5] ^= 0x01;
+    CHECK(ESP_ERR_INVALID_CRC == asset_pack_init(PARTITION_LABEL, NULL), "corrupted index accepted");
+    CHECK(mapped == fake_partition_mapped(), "partition left mapped");
+    CHECK(NULL == asset_pack_img("esp_logo"), "image from a refused pack");
+
+    uint8_t *data = read_file(PACK_DIR "/assets.bin", &size);
+    CHECK(data, "no pack");
+    fake_partition_load(PARTITION_LABEL, data, size / 2, size / 2);
+    esp_err_t truncated = asset_pack_init(PARTITION_LABEL, NULL);
+    flash = fake_partition_load(PARTITION_LABEL, data, size, PARTITION_SIZE);
+    s_flash = flash;
+    free(data);
+    CHECK(ESP_ERR_INVALID_CRC == truncated, "truncated pack accepted");
+
+    ((pack_header_t *) flash)->color_swap ^= 1;
+    CHECK(ESP_ERR_INVALID_STATE == asset_pack_init(PARTITION_LABEL, NULL), "other color format accepted");
+    ((pack_header_t *) flash)->color_swap ^= 1;
+
+    /* Once mapped: every entry stored at the offset of the first one fails, the others still load */
+    CHECK(ESP_OK == asset_pack_init(PARTITION_LABEL, NULL), "init failed");
+    uint32_t bad_offset = s_entries[0].offset;
+    flash[bad_offset + s_entries[0].size / 2] ^= 0x10;
+    bool ok = true;
+    for (size_t i = 0; i < s_count; i++) {
+        char name[PACK_NAME_LEN + 1] = { 0 };
+        memcpy(name, s_entries[i].name, PACK_NAME_LEN);
+        bool loaded = PACK_TYPE_IMG == s_entries[i].type ? NULL != asset_pack_img(name)
+                      : LV_FONT_DEFAULT != asset_pack_font(name);
+        if (loaded == (s_entries[i].offset == bad_offset)) {
+            printf("FAIL %s: %s\n", __func__, loaded ? "corrupted asset loaded" : "intact asset not loaded");
+            ok = false;
+        }
+    }
+    pack_close();
+    return ok;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"compressed", test_compressed},
+        {"plain", test_plain},
+        {"shared", test_shared},
+        {"lookup", test_lookup},
+        {"corrupted", test_corrupted},
+    };
+    int failed = 0;
+
+    printf(PROJECT_NAME ", %zu C arrays\n", TEST_ASSET_COUNT);
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
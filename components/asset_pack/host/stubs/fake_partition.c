@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* One data partition in RAM, mapped in place. Erased bytes read 0xFF as on flash. */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_partition.h"
+#include "fake_partition.h"
+
+static esp_partition_t s_partition;
+static uint8_t *s_data;
+static int s_mapped;
+
+uint8_t *fake_partition_load(const char *label, const uint8_t *data, size_t size, size_t partition_size)
+{
+    free(s_data);
+    s_data = malloc(partition_size);
+    memset(s_data, 0xFF, partition_size);
+    memcpy(s_data, data, size < partition_size ? size : partition_size);
+    s_partition = (esp_partition_t) {
+        .type = ESP_PARTITION_TYPE_DATA, .subtype = ESP_PARTITION_SUBTYPE_ANY, .size = partition_size,
+    };
+    strncpy(s_partition.label, label, sizeof(s_partition.label) - 1);
+    return s_data;
+}
+
+int fake_partition_mapped(void)
+{
+    return s_mapped;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (!s_data || type != s_partition.type || (label && strcmp(label, s_partition.label))) {
+        return NULL;
+    }
+    return &s_partition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    if (offset > partition->size || size > partition->size - offset) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_ptr = s_data + offset;
+    *out_handle = 1;
+    s_mapped++;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+    s_mapped--;
+}
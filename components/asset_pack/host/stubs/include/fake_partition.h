@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Make the data partition `label` hold a copy of `data`, the rest of it erased, replaces the one before
+ *
+ * @return Start of the partition, to corrupt it in place
+ */
+uint8_t *fake_partition_load(const char *label, const uint8_t *data, size_t size, size_t partition_size);
+
+/**
+ * @brief Number of mappings not unmapped yet
+ */
+int fake_partition_mapped(void);
@@ -0,0 +1,187 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stand-in: the image and font types of LVGL v8.3 with their exact layout, enough to compile the C arrays of
+ * the examples and asset_pack.c. The color format and LV_FONT_FMT_TXT_LARGE come from the build, as with lv_conf.h.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LVGL_VERSION_MAJOR          8
+#define LVGL_VERSION_MINOR          3
+#define LVGL_VERSION_PATCH          11
+#define LV_VERSION_CHECK(x, y, z)   (x == LVGL_VERSION_MAJOR && (y < LVGL_VERSION_MINOR || \
+                                     (y == LVGL_VERSION_MINOR && z <= LVGL_VERSION_PATCH)))
+
+#ifndef LV_COLOR_DEPTH
+#define LV_COLOR_DEPTH              16
+#endif
+#ifndef LV_COLOR_16_SWAP
+#define LV_COLOR_16_SWAP            0
+#endif
+#ifndef LV_FONT_FMT_TXT_LARGE
+#define LV_FONT_FMT_TXT_LARGE       0
+#endif
+#define LV_USE_FONT_COMPRESSED      1
+#define LV_USE_USER_DATA            1
+
+#define LV_COLOR_SIZE               LV_COLOR_DEPTH
+#if LV_COLOR_DEPTH == 32
+#define LV_IMG_PX_SIZE_ALPHA_BYTE   4
+#else
+#define LV_IMG_PX_SIZE_ALPHA_BYTE   (LV_COLOR_DEPTH / 8 + 1)
+#endif
+
+#define LV_ATTRIBUTE_LARGE_CONST
+
+typedef int16_t lv_coord_t;
+
+/* lv_img_buf.h */
+enum {
+    LV_IMG_CF_UNKNOWN = 0,
+    LV_IMG_CF_RAW,
+    LV_IMG_CF_RAW_ALPHA,
+    LV_IMG_CF_RAW_CHROMA_KEYED,
+    LV_IMG_CF_TRUE_COLOR,
+    LV_IMG_CF_TRUE_COLOR_ALPHA,
+    LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED,
+};
+typedef uint8_t lv_img_cf_t;
+
+typedef struct {
+    uint32_t cf : 5;
+    uint32_t always_zero : 3;
+    uint32_t reserved : 2;
+    uint32_t w : 11;
+    uint32_t h : 11;
+} lv_img_header_t;
+
+typedef struct {
+    lv_img_header_t header;
+    uint32_t data_size;
+    const uint8_t *data;
+} lv_img_dsc_t;
+
+/* lv_font.h */
+enum {
+    LV_FONT_SUBPX_NONE,
+    LV_FONT_SUBPX_HOR,
+    LV_FONT_SUBPX_VER,
+    LV_FONT_SUBPX_BOTH,
+};
+
+typedef struct {
+    const struct _lv_font_t *resolved_font;
+    uint16_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t ofs_x;
+    int16_t ofs_y;
+    uint8_t bpp : 4;
+    uint8_t is_placeholder : 1;
+} lv_font_glyph_dsc_t;
+
+typedef struct _lv_font_t {
+    bool (*get_glyph_dsc)(const struct _lv_font_t *, lv_font_glyph_dsc_t *, uint32_t letter, uint32_t letter_next);
+    const uint8_t *(*get_glyph_bitmap)(const struct _lv_font_t *, uint32_t);
+    lv_coord_t line_height;
+    lv_coord_t base_line;
+    uint8_t subpx : 2;
+    int8_t underline_position;
+    int8_t underline_thickness;
+    const void *dsc;
+    const struct _lv_font_t *fallback;
+    void *user_data;
+} lv_font_t;
+
+/* Defined by the test, LV_FONT_DEFAULT is only compared against */
+extern const lv_font_t lv_font_montserrat_14;
+#define LV_FONT_DEFAULT             (&lv_font_montserrat_14)
+
+/* lv_font_fmt_txt.h */
+typedef struct {
+#if LV_FONT_FMT_TXT_LARGE == 0
+    uint32_t bitmap_index : 20;
+    uint32_t adv_w : 12;
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+#else
+    uint32_t bitmap_index;
+    uint32_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t ofs_x;
+    int16_t ofs_y;
+#endif
+} lv_font_fmt_txt_glyph_dsc_t;
+
+typedef enum {
+    LV_FONT_FMT_TXT_CMAP_FORMAT0_FULL,
+    LV_FONT_FMT_TXT_CMAP_SPARSE_FULL,
+    LV_FONT_FMT_TXT_CMAP_FORMAT0_TINY,
+    LV_FONT_FMT_TXT_CMAP_SPARSE_TINY,
+} lv_font_fmt_txt_cmap_type_t;
+
+typedef struct {
+    uint32_t range_start;
+    uint16_t range_length;
+    uint16_t glyph_id_start;
+    const uint16_t *unicode_list;
+    const void *glyph_id_ofs_list;
+    uint16_t list_length;
+    lv_font_fmt_txt_cmap_type_t type;
+} lv_font_fmt_txt_cmap_t;
+
+typedef struct {
+    const void *glyph_ids;
+    const int8_t *values;
+    uint32_t pair_cnt : 30;
+    uint32_t glyph_ids_size : 2;
+} lv_font_fmt_txt_kern_pair_t;
+
+typedef struct {
+    const int8_t *class_pair_values;
+    const uint8_t *left_class_mapping;
+    const uint8_t *right_class_mapping;
+    uint8_t left_class_cnt;
+    uint8_t right_class_cnt;
+} lv_font_fmt_txt_kern_classes_t;
+
+/* Both formats are 1 in v8, and lv_font_fmt_txt.c always undoes the prefilter */
+typedef enum {
+    LV_FONT_FMT_TXT_PLAIN = 0,
+    LV_FONT_FMT_TXT_COMPRESSED = 1,
+    LV_FONT_FMT_TXT_COMPRESSED_NO_PREFILTER = 1,
+} lv_font_fmt_txt_bitmap_format_t;
+
+typedef struct {
+    uint32_t last_letter;
+    uint32_t last_glyph_id;
+} lv_font_fmt_txt_glyph_cache_t;
+
+typedef struct {
+    const uint8_t *glyph_bitmap;
+    const lv_font_fmt_txt_glyph_dsc_t *glyph_dsc;
+    const lv_font_fmt_txt_cmap_t *cmaps;
+    const void *kern_dsc;
+    uint16_t kern_scale;
+    uint16_t cmap_num : 9;
+    uint16_t bpp : 4;
+    uint16_t kern_classes : 1;
+    uint16_t bitmap_format : 2;
+    lv_font_fmt_txt_glyph_cache_t *cache;
+} lv_font_fmt_txt_dsc_t;
+
+bool lv_font_get_glyph_dsc_fmt_txt(const lv_font_t *font, lv_font_glyph_dsc_t *dsc_out, uint32_t unicode_letter,
+                                   uint32_t unicode_letter_next);
+const uint8_t *lv_font_get_bitmap_fmt_txt(const lv_font_t *font, uint32_t letter);
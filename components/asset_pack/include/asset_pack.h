@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Map the asset partition written by asset_pack_create_partition_image(), assets are built on first use
+ *
+ * @param partition_label  Label of the data partition
+ * @param scope            Project name, selects the project's own copy of assets that differ between the
+ *                         projects sharing a pack, may be NULL
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_NOT_FOUND if there is no such partition
+ *      - ESP_ERR_INVALID_CRC if the partition does not hold a valid pack
+ *      - ESP_ERR_INVALID_STATE if the pack was built for another color format than LV_COLOR_DEPTH / LV_COLOR_16_SWAP
+ */
+esp_err_t asset_pack_init(const char *partition_label, const char *scope);
+
+/**
+ * @brief Image by the name of the C array it was packed from, e.g. "esp_logo"
+ *
+ * @note Uncompressed images are used straight from flash, compressed ones are expanded into PSRAM once
+ *
+ * @return Descriptor for lv_img_set_src(), valid until reboot, NULL if the pack has no such image
+ */
+const lv_img_dsc_t *asset_pack_img(const char *name);
+
+/**
+ * @brief Font by the name it was generated with, e.g. "font_en_16"
+ *
+ * @return Font valid until reboot, LV_FONT_DEFAULT if the pack has no such font
+ */
+const lv_font_t *asset_pack_font(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
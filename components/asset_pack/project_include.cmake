@@ -0,0 +1,65 @@
+# asset_pack_create_partition_image
+#
+# Pack the images and fonts that the given projects keep as LVGL C arrays into a data partition,
+# see asset_pack.py. Assets shared by several projects are stored once, the pack is checked
+# against the C sources every time it is built.
+#
+# asset_pack_create_partition_image(<partition> [PROJECTS <dir>...] [FLASH_IN_PROJECT])
+#
+# PROJECTS defaults to the current project, FLASH_IN_PROJECT writes the pack with `idf.py flash`,
+# `idf.py <partition>-flash` writes only the pack.
+function(asset_pack_create_partition_image partition)
+    set(options FLASH_IN_PROJECT)
+    set(multi PROJECTS)
+    cmake_parse_arguments(arg "${options}" "" "${multi}" "${ARGN}")
+
+    idf_build_get_property(python PYTHON)
+    idf_build_get_property(project_dir PROJECT_DIR)
+    idf_build_get_property(sdkconfig SDKCONFIG)
+    idf_component_get_property(asset_pack_dir asset_pack COMPONENT_DIR)
+    set(asset_pack_py ${asset_pack_dir}/asset_pack.py)
+
+    if(NOT arg_PROJECTS)
+        set(arg_PROJECTS ${project_dir})
+    endif()
+
+    partition_table_get_partition_info(size "--partition-name ${partition}" "size")
+    partition_table_get_partition_info(offset "--partition-name ${partition}" "offset")
+
+    if("${size}" AND "${offset}")
+        set(image_file ${CMAKE_BINARY_DIR}/${partition}.bin)
+        set(projects)
+        set(sources)
+        foreach(project ${arg_PROJECTS})
+            get_filename_component(project ${project} ABSOLUTE BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+            file(GLOB_RECURSE project_sources CONFIGURE_DEPENDS ${project}/main/*.c ${project}/main/*.h)
+            list(APPEND projects ${project})
+            list(APPEND sources ${project_sources})
+        endforeach()
+
+        add_custom_command(OUTPUT ${image_file}
+            COMMAND ${python} ${asset_pack_py} --sdkconfig ${sdkconfig}
+                    build --size ${size} -o ${image_file} ${projects}
+            DEPENDS ${sources} ${asset_pack_py} ${sdkconfig}
+            COMMENT "Packing assets into ${partition}"
+            VERBATIM)
+        add_custom_target(asset_pack_${partition}_bin ALL DEPENDS ${image_file})
+        set_property(DIRECTORY "${CMAKE_CURRENT_SOURCE_DIR}" APPEND PROPERTY
+            ADDITIONAL_CLEAN_FILES ${image_file})
+
+        idf_component_get_property(main_args esptool_py FLASH_ARGS)
+        idf_component_get_property(sub_args esptool_py FLASH_SUB_ARGS)
+        esptool_py_flash_target(${partition}-flash "${main_args}" "${sub_args}")
+        esptool_py_flash_target_image(${partition}-flash "${partition}" "${offset}" "${image_file}")
+        add_dependencies(${partition}-flash asset_pack_${partition}_bin)
+
+        if(arg_FLASH_IN_PROJECT)
+            esptool_py_flash_target_image(flash "${partition}" "${offset}" "${image_file}")
+            add_dependencies(flash asset_pack_${partition}_bin)
+        endif()
+    else()
+        set(message "Failed to create asset pack for partition '${partition}'. "
+                    "Check project configuration if using the correct partition table file.")
+        fail_at_build_time(asset_pack_${partition}_bin "${message}")
+    endif()
+endfunction()
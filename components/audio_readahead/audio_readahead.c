@@ -0,0 +1,461 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* fopencookie() */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "audio_readahead.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_pthread.h"
+#include "esp_timer.h"
+#else
+#include <time.h>
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+/* Offset type of cookie_seek_function_t */
+#if defined(__NEWLIB__) && defined(__LARGE64_FILES)
+typedef _off64_t cookie_off_t;
+#elif defined(__NEWLIB__)
+typedef off_t cookie_off_t;
+#else
+typedef off64_t cookie_off_t;
+#endif
+
+static const char *TAG = "audio_readahead";
+
+typedef struct {
+    FILE *src;
+    audio_readahead_config_t config;
+    uint8_t *ring;
+    pthread_t reader;
+    pthread_mutex_t lock;
+    pthread_cond_t data_cond;       /* Reader to consumer: data, end of file or error */
+    pthread_cond_t space_cond;      /* Consumer to reader: below the low watermark, seek or close */
+    int64_t size;                   /* Of the file, -1 if src cannot seek */
+
+    /* File offsets. The ring holds [head - ring_size, head) at offset % ring_size */
+    int64_t start;                  /* Where the ring was last restarted */
+    int64_t head;                   /* End of the buffered data */
+    int64_t tail;                   /* Read position of the consumer */
+    int64_t reserved;               /* End of the file read in flight, head when there is none */
+    uint32_t generation;            /* Bumped by restarts, a read in flight for an older one is dropped */
+    bool refill;                    /* Went under the low watermark and did not reach the high one yet */
+    bool restart;                   /* The reader has to seek src to head */
+    bool primed;                    /* Reached the high watermark or the end since the last restart */
+    bool eof;
+    bool error;
+    bool stop;
+
+    uint32_t underruns;
+    uint32_t longest_underrun_us;
+} stream_t;
+
+static pthread_mutex_t s_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static audio_readahead_stats_t s_stats = {
+    .min_fill = SIZE_MAX,
+};
+
+static int64_t now_us(void)
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+#endif
+}
+
+static void stats_add_read(size_t bytes, int64_t took_us, bool stalled)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats.reads++;
+    s_stats.bytes += bytes;
+    s_stats.stalls += stalled;
+    if (took_us > s_stats.slowest_read_us) {
+        s_stats.slowest_read_us = took_us;
+    }
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+static void stats_add_underrun(int64_t waited_us)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats.underruns++;
+    s_stats.underrun_us += waited_us;
+    if (waited_us > s_stats.longest_underrun_us) {
+        s_stats.longest_underrun_us = waited_us;
+    }
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+static void stats_add_fill(size_t fill)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    if (fill < s_stats.min_fill) {
+        s_stats.min_fill = fill;
+    }
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+static void *reader_main(void *arg)
+{
+    stream_t *s = (stream_t *) arg;
+    const size_t ring_size = s->config.ring_size;
+    const size_t read_size = s->config.read_size;
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+        if (s->restart) {
+            int64_t pos = s->head;
+            uint32_t generation = s->generation;
+            s->restart = false;
+            pthread_mutex_unlock(&s->lock);
+            int ret = fseek(s->src, pos, SEEK_SET);
+            pthread_mutex_lock(&s->lock);
+            if (ret && generation == s->generation) {
+                s->error = true;
+                pthread_cond_broadcast(&s->data_cond);
+            }
+            continue;
+        }
+
+        size_t fill = s->head - s->tail;
+        if (fill < s->config.low_watermark) {
+            s->refill = true;
+        } else if (fill >= s->config.high_watermark) {
+            s->refill = false;
+            s->primed = true;
+        }
+        if (!s->refill || s->eof || s->error) {
+            pthread_cond_wait(&s->space_cond, &s->lock);
+            continue;
+        }
+
+        /* Up to the next multiple of read_size, which never crosses the end of the ring */
+        size_t len = read_size - s->head % read_size;
+        uint8_t *dst = s->ring + s->head % ring_size;
+        uint32_t generation = s->generation;
+        s->reserved = s->head + len;
+        pthread_mutex_unlock(&s->lock);
+
+        int64_t start = now_us();
+        size_t got = fread(dst, 1, len, s->src);
+        bool failed = got < len && ferror(s->src);
+        int64_t took = now_us() - start;
+        stats_add_read(got, took, took > s->config.stall_ms * 1000LL);
+
+        pthread_mutex_lock(&s->lock);
+        if (generation != s->generation) {
+            s->reserved = s->head;
+            continue;
+        }
+        s->head += got;
+        s->reserved = s->head;
+        if (got < len) {
+            s->error = failed;
+            s->eof = !failed;
+            s->primed = true;
+        }
+        pthread_cond_broadcast(&s->data_cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static ssize_t stream_read(void *cookie, char *buf, size_t size)
+{
+    stream_t *s = (stream_t *) cookie;
+
+    pthread_mutex_lock(&s->lock);
+    if (s->head == s->tail && !s->eof && !s->error) {
+        bool counted = s->primed;
+        int64_t start = now_us();
+        pthread_cond_signal(&s->space_cond);
+        while (s->head == s->tail && !s->eof && !s->error) {
+            pthread_cond_wait(&s->data_cond, &s->lock);
+        }
+        if (counted) {
+            uint32_t waited = now_us() - start;
+            s->underruns++;
+            if (waited > s->longest_underrun_us) {
+                s->longest_underrun_us = waited;
+            }
+            stats_add_underrun(waited);
+        }
+    }
+
+    size_t avail = s->head - s->tail;
+    if (0 == avail) {
+        bool error = s->error;
+        pthread_mutex_unlock(&s->lock);
+        if (error) {
+            errno = EIO;
+            return -1;
+        }
+        return 0;
+    }
+
+    /* The reader does not write over [tail, head) and stdio serializes reads and seeks, copy unlocked */
+    size_t n = size < avail ? size : avail;
+    size_t pos = s->tail % s->config.ring_size;
+    size_t first = s->config.ring_size - pos;
+    pthread_mutex_unlock(&s->lock);
+    if (first >= n) {
+        memcpy(buf, s->ring + pos, n);
+    } else {
+        memcpy(buf, s->ring + pos, first);
+        memcpy(buf + first, s->ring, n - first);
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->tail += n;
+    size_t fill = s->head - s->tail;
+    if (fill < s->config.low_watermark && !s->refill) {
+        pthread_cond_signal(&s->space_cond);
+    }
+    /* Draining the end of the file is no sign of a slow reader */
+    bool count_fill = s->primed && !s->eof;
+    pthread_mutex_unlock(&s->lock);
+
+    if (count_fill) {
+        stats_add_fill(fill);
+    }
+    return n;
+}
+
+static int stream_seek(void *cookie, cookie_off_t *offset, int whence)
+{
+    stream_t *s = (stream_t *) cookie;
+    int64_t target = *offset;
+
+    pthread_mutex_lock(&s->lock);
+    if (SEEK_CUR == whence) {
+        target += s->tail;
+    } else if (SEEK_END == whence) {
+        if (s->size < 0) {
+            pthread_mutex_unlock(&s->lock);
+            errno = ESPIPE;
+            return -1;
+        }
+        target += s->size;
+    }
+    if (target < 0) {
+        pthread_mutex_unlock(&s->lock);
+        errno = EINVAL;
+        return -1;
+    }
+
+    /* Bytes behind the read position stay valid until the reader writes over them */
+    int64_t lowest = s->reserved - (int64_t) s->config.ring_size;
+    if (lowest < s->start) {
+        lowest = s->start;
+    }
+    if (target < lowest || target > s->head) {
+        s->generation++;
+        s->start = s->head = s->tail = s->reserved = target;
+        s->restart = true;
+        s->refill = true;
+        s->primed = false;
+        s->eof = false;
+        s->error = false;
+        pthread_cond_signal(&s->space_cond);
+    } else {
+        s->tail = target;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    *offset = target;
+    return 0;
+}
+
+static int stream_close(void *cookie)
+{
+    stream_t *s = (stream_t *) cookie;
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_signal(&s->space_cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->reader, NULL);
+
+    if (s->underruns) {
+        ESP_LOGW(TAG, "%u underruns, longest %u ms", (unsigned) s->underruns,
+                 (unsigned)(s->longest_underrun_us / 1000));
+    }
+
+    int ret = fclose(s->src);
+    pthread_cond_destroy(&s->space_cond);
+    pthread_cond_destroy(&s->data_cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s->ring);
+    free(s);
+    return ret ? -1 : 0;
+}
+
+static bool config_valid(const audio_readahead_config_t *config)
+{
+    return config->read_size && config->ring_size >= 2 * config->read_size
+           && 0 == config->ring_size % config->read_size
+           && config->high_watermark <= config->ring_size - config->read_size
+           && config->low_watermark < config->high_watermark;
+}
+
+static int start_reader(stream_t *s)
+{
+#ifdef ESP_PLATFORM
+    /* The pthread configuration belongs to the calling task, put it back for its other threads */
+    esp_pthread_cfg_t prev;
+    bool had_cfg = ESP_OK == esp_pthread_get_cfg(&prev);
+    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
+    cfg.stack_size = s->config.stack_size;
+    cfg.prio = s->config.priority;
+    cfg.thread_name = "readahead";
+    if (s->config.core >= 0) {
+        cfg.pin_to_core = s->config.core;
+    }
+    esp_pthread_set_cfg(&cfg);
+    int ret = pthread_create(&s->reader, NULL, reader_main, s);
+    if (had_cfg) {
+        esp_pthread_set_cfg(&prev);
+    } else {
+        cfg = esp_pthread_get_default_config();
+        esp_pthread_set_cfg(&cfg);
+    }
+    return ret;
+#else
+    return pthread_create(&s->reader, NULL, reader_main, s);
+#endif
+}
+
+static uint8_t *ring_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    uint8_t *ring = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ring) {
+        return ring;
+    }
+#endif
+    return malloc(size);
+}
+
+FILE *audio_readahead_wrap(FILE *src, const audio_readahead_config_t *config)
+{
+    const audio_readahead_config_t default_config = AUDIO_READAHEAD_DEFAULT_CONFIG();
+    stream_t *s = NULL;
+    int err = EINVAL;
+
+    if (NULL == src) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (NULL == config) {
+        config = &default_config;
+    }
+    if (!config_valid(config)) {
+        ESP_LOGE(TAG, "Invalid ring or watermarks");
+        goto fail;
+    }
+
+    err = ENOMEM;
+    s = calloc(1, sizeof(stream_t));
+    if (NULL == s) {
+        goto fail;
+    }
+    s->src = src;
+    s->config = *config;
+    s->ring = ring_alloc(config->ring_size);
+    if (NULL == s->ring) {
+        ESP_LOGE(TAG, "No memory for a ring of %u bytes", (unsigned) config->ring_size);
+        goto fail;
+    }
+
+    long pos = ftell(src);
+    s->size = -1;
+    if (pos >= 0 && 0 == fseek(src, 0, SEEK_END)) {
+        s->size = ftell(src);
+        fseek(src, pos, SEEK_SET);
+    }
+    s->start = s->head = s->tail = s->reserved = pos > 0 ? pos : 0;
+    s->refill = true;
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->data_cond, NULL);
+    pthread_cond_init(&s->space_cond, NULL);
+    err = start_reader(s);
+    if (err) {
+        ESP_LOGE(TAG, "Start reader failed: %d", err);
+        goto fail_sync;
+    }
+
+    cookie_io_functions_t io = {
+        .read = stream_read,
+        .seek = stream_seek,
+        .close = stream_close,
+    };
+    FILE *fp = fopencookie(s, "r", io);
+    if (NULL == fp) {
+        /* Stops the reader and releases everything, src included */
+        err = errno;
+        stream_close(s);
+        errno = err;
+        return NULL;
+    }
+
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats.streams++;
+    pthread_mutex_unlock(&s_stats_lock);
+    return fp;
+
+fail_sync:
+    pthread_cond_destroy(&s->space_cond);
+    pthread_cond_destroy(&s->data_cond);
+    pthread_mutex_destroy(&s->lock);
+fail:
+    if (s) {
+        free(s->ring);
+        free(s);
+    }
+    fclose(src);
+    errno = err;
+    return NULL;
+}
+
+FILE *audio_readahead_open(const char *path, const audio_readahead_config_t *config)
+{
+    FILE *src = fopen(path, "rb");
+    if (NULL == src) {
+        return NULL;
+    }
+    return audio_readahead_wrap(src, config);
+}
+
+void audio_readahead_get_stats(audio_readahead_stats_t *stats)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    *stats = s_stats;
+    pthread_mutex_unlock(&s_stats_lock);
+}
+
+void audio_readahead_reset_stats(void)
+{
+    pthread_mutex_lock(&s_stats_lock);
+    s_stats = (audio_readahead_stats_t) {
+        .min_fill = SIZE_MAX,
+    };
+    pthread_mutex_unlock(&s_stats_lock);
+}
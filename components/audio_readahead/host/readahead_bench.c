@@ -0,0 +1,323 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Plays a file from a slow, jittery fake file system into a decoder that consumes it at the bit rate
+ * of an MP3, once read directly and then through audio_readahead with several low watermarks.
+ * A decoder stall is a read that waits longer than the audio buffered after the decoder.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include "audio_readahead.h"
+
+#define MP3_SAMPLES_PER_FRAME   1152
+#define MP3_RATE_HZ             44100
+
+typedef struct {
+    double seconds;             /* Of audio */
+    int kbps;
+    double speed;               /* Time runs this much faster than on the device */
+    int headroom_ms;            /* Audio queued after the decoder, e.g. I2S DMA buffers */
+    int read_base_us;           /* Fake file system: per read */
+    int read_ns_per_byte;
+    int read_jitter_us;
+    int gc_period_ms;           /* A garbage collection stall this often */
+    int gc_min_ms;
+    int gc_max_ms;
+    int low_kb;                 /* Only this low watermark, 0 for a sweep */
+    unsigned seed;
+} options_t;
+
+static options_t s_opt = {
+    .seconds = 30,
+    .kbps = 320,
+    .speed = 8,
+    .headroom_ms = 50,
+    .read_base_us = 2000,
+    .read_ns_per_byte = 1000,
+    .read_jitter_us = 5000,
+    .gc_period_ms = 3000,
+    .gc_min_ms = 200,
+    .gc_max_ms = 500,
+    .seed = 1,
+};
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    uint32_t rng;
+    int64_t next_gc_us;
+} fake_file_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t stalls;
+    int64_t longest_wait_us;
+} decode_result_t;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/* Device time to wall time */
+static void sleep_device_us(int64_t us)
+{
+    int64_t wall = us / s_opt.speed;
+    if (wall > 0) {
+        struct timespec ts = { .tv_sec = wall / 1000000, .tv_nsec = (wall % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static uint32_t rand_next(uint32_t *state)
+{
+    /* xorshift32, the same stalls on every run */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static ssize_t fake_read(void *cookie, char *buf, size_t size)
+{
+    fake_file_t *f = (fake_file_t *) cookie;
+
+    int64_t delay = s_opt.read_base_us + (int64_t) size * s_opt.read_ns_per_byte / 1000;
+    if (s_opt.read_jitter_us) {
+        delay += rand_next(&f->rng) % s_opt.read_jitter_us;
+    }
+    int64_t device_now = now_us() * s_opt.speed;
+    if (s_opt.gc_period_ms && device_now >= f->next_gc_us) {
+        delay += (s_opt.gc_min_ms + rand_next(&f->rng) % (s_opt.gc_max_ms - s_opt.gc_min_ms + 1)) * 1000LL;
+        f->next_gc_us = device_now + s_opt.gc_period_ms * 1000LL;
+    }
+    sleep_device_us(delay);
+
+    size_t n = f->size - f->pos < size ? f->size - f->pos : size;
+    memcpy(buf, f->data + f->pos, n);
+    f->pos += n;
+    return n;
+}
+
+static int fake_seek(void *cookie, off64_t *offset, int whence)
+{
+    fake_file_t *f = (fake_file_t *) cookie;
+    int64_t target = *offset + (SEEK_CUR == whence ? (int64_t) f->pos : SEEK_END == whence ? (int64_t) f->size : 0);
+    if (target < 0) {
+        return -1;
+    }
+    f->pos = target;
+    *offset = target;
+    return 0;
+}
+
+static int fake_close(void *cookie)
+{
+    free(cookie);
+    return 0;
+}
+
+static FILE *fake_open(const uint8_t *data, size_t size)
+{
+    fake_file_t *f = calloc(1, sizeof(fake_file_t));
+    f->data = data;
+    f->size = size;
+    f->rng = s_opt.seed;
+    f->next_gc_us = now_us() * s_opt.speed + s_opt.gc_period_ms * 1000LL;
+    cookie_io_functions_t io = {
+        .read = fake_read,
+        .seek = fake_seek,
+        .close = fake_close,
+    };
+    return fopencookie(f, "r", io);
+}
+
+/* Reads one frame per frame period, as the player task would between writes to I2S */
+static decode_result_t decode(FILE *fp, const uint8_t *expect, size_t size)
+{
+    decode_result_t result = { 0 };
+    const double frame_us = 1e6 * MP3_SAMPLES_PER_FRAME / MP3_RATE_HZ;
+    const size_t frame_bytes = s_opt.kbps * 1000 / 8 * MP3_SAMPLES_PER_FRAME / MP3_RATE_HZ;
+    uint8_t buf[4096];
+
+    /* The header is read and the file rewound, as the player does to find the format */
+    if (fread(buf, 1, 10, fp) != 10 || fseek(fp, 0, SEEK_SET)) {
+        fprintf(stderr, "Header read or rewind failed\n");
+        exit(1);
+    }
+
+    size_t pos = 0;
+    int64_t deadline = 0;
+    while (pos < size) {
+        size_t want = size - pos < frame_bytes ? size - pos : frame_bytes;
+        int64_t start = now_us();
+        size_t got = fread(buf, 1, want, fp);
+        int64_t waited = (now_us() - start) * s_opt.speed;
+        if (got != want || memcmp(buf, expect + pos, got)) {
+            fprintf(stderr, "Wrong data at %zu\n", pos);
+            exit(1);
+        }
+        pos += got;
+
+        /* The first frame may wait, nothing plays yet */
+        if (result.frames++) {
+            if (waited > s_opt.headroom_ms * 1000LL) {
+                result.stalls++;
+            }
+            if (waited > result.longest_wait_us) {
+                result.longest_wait_us = waited;
+            }
+        }
+
+        int64_t now = now_us() * s_opt.speed;
+        deadline = deadline && now < deadline + frame_us ? deadline + frame_us : now + frame_us;
+        sleep_device_us(deadline - now);
+    }
+    return result;
+}
+
+static void print_row(const char *mode, const char *low, const decode_result_t *r,
+                      const audio_readahead_stats_t *stats)
+{
+    printf("%-10s %6s %8u %8u %10.1f", mode, low, (unsigned) r->frames, (unsigned) r->stalls,
+           r->longest_wait_us / 1000.0);
+    if (stats) {
+        printf(" %9u %8u %9u %9.1f", (unsigned) stats->underruns, (unsigned) stats->stalls,
+               (unsigned) stats->reads, stats->min_fill == SIZE_MAX ? 0 : stats->min_fill / 1024.0);
+    }
+    printf("\n");
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -d SEC     seconds of audio, default %.0f\n"
+            "  -k KBPS    bit rate, default %d\n"
+            "  -x SPEED   time runs this much faster than on the device, default %.0f\n"
+            "  -r MS      audio buffered after the decoder, default %d\n"
+            "  -j US      read jitter, default %d\n"
+            "  -g MS      longest garbage collection stall, default %d\n"
+            "  -p MS      garbage collection period, 0 for none, default %d\n"
+            "  -l KB      low watermark to test, default a sweep ending at the default configuration\n"
+            "  -s SEED    default %u\n",
+            argv0, s_opt.seconds, s_opt.kbps, s_opt.speed, s_opt.headroom_ms, s_opt.read_jitter_us,
+            s_opt.gc_max_ms, s_opt.gc_period_ms, s_opt.seed);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "d:k:x:r:j:g:p:l:s:h")) != -1) {
+        switch (c) {
+        case 'd':
+            s_opt.seconds = atof(optarg);
+            break;
+        case 'k':
+            s_opt.kbps = atoi(optarg);
+            break;
+        case 'x':
+            s_opt.speed = atof(optarg);
+            break;
+        case 'r':
+            s_opt.headroom_ms = atoi(optarg);
+            break;
+        case 'j':
+            s_opt.read_jitter_us = atoi(optarg);
+            break;
+        case 'g':
+            s_opt.gc_max_ms = atoi(optarg);
+            break;
+        case 'p':
+            s_opt.gc_period_ms = atoi(optarg);
+            break;
+        case 'l':
+            s_opt.low_kb = atoi(optarg);
+            break;
+        case 's':
+            s_opt.seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (s_opt.speed <= 0 || s_opt.kbps <= 0 || s_opt.seconds <= 0 || !s_opt.seed ||
+            s_opt.gc_min_ms > s_opt.gc_max_ms) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* In order with the warnings of audio_readahead on stderr */
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    size_t size = s_opt.seconds * s_opt.kbps * 1000 / 8;
+    uint8_t *data = malloc(size);
+    uint32_t rng = s_opt.seed;
+    for (size_t i = 0; i < size; i++) {
+        data[i] = rand_next(&rng);
+    }
+
+    printf("%.0f s at %d kbps, read %d us + %d ns/B + up to %d us, %d-%d ms stall every %d ms, %.0fx speed\n",
+           s_opt.seconds, s_opt.kbps, s_opt.read_base_us, s_opt.read_ns_per_byte, s_opt.read_jitter_us,
+           s_opt.gc_min_ms, s_opt.gc_max_ms, s_opt.gc_period_ms, s_opt.speed);
+    printf("%-10s %6s %8s %8s %10s %9s %8s %9s %9s\n", "mode", "low KB", "frames", "stalls", "longest ms",
+           "underruns", "fs stalls", "fs reads", "min KB");
+
+    FILE *fp = fake_open(data, size);
+    decode_result_t direct = decode(fp, data, size);
+    fclose(fp);
+    print_row("direct", "-", &direct, NULL);
+
+    /* Lower watermarks first, the default configuration last decides the exit status */
+    const audio_readahead_config_t def = AUDIO_READAHEAD_DEFAULT_CONFIG();
+    const int def_kb = def.low_watermark / 1024;
+    int sweep[] = { def_kb / 4, def_kb / 2, def_kb };
+    int runs = s_opt.low_kb ? 1 : sizeof(sweep) / sizeof(sweep[0]);
+    decode_result_t result = { 0 };
+    audio_readahead_stats_t stats = { 0 };
+    for (int i = 0; i < runs; i++) {
+        audio_readahead_config_t config = def;
+        config.low_watermark = (s_opt.low_kb ? s_opt.low_kb : sweep[i]) * 1024;
+        /* stall_ms is in device time */
+        config.stall_ms = config.stall_ms / s_opt.speed;
+
+        audio_readahead_reset_stats();
+        fp = audio_readahead_wrap(fake_open(data, size), &config);
+        if (NULL == fp) {
+            fprintf(stderr, "Invalid configuration\n");
+            return 2;
+        }
+        result = decode(fp, data, size);
+        fclose(fp);
+        audio_readahead_get_stats(&stats);
+
+        char low[16];
+        snprintf(low, sizeof(low), "%u", (unsigned)(config.low_watermark / 1024));
+        print_row("readahead", low, &result, &stats);
+    }
+    free(data);
+
+    if (result.stalls || stats.underruns) {
+        printf("Decoder stalled at a low watermark of %d KB\n", s_opt.low_kb ? s_opt.low_kb : def_kb);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    size_t ring_size;           /*!< Bytes buffered ahead, a multiple of read_size */
+    size_t read_size;           /*!< Bytes per file read, file offsets of the reads are aligned to it */
+    size_t low_watermark;       /*!< The reader starts refilling when fewer bytes are buffered */
+    size_t high_watermark;      /*!< and stops once this many are, at most ring_size - read_size */
+    int priority;               /*!< Of the reader task, keep it below the decoder */
+    int core;                   /*!< Core of the reader task, -1 for any */
+    size_t stack_size;
+    uint32_t stall_ms;          /*!< File reads taking longer are counted as stalls */
+} audio_readahead_config_t;
+
+/*
+ * 64 KB hold 1.6 s of a 320 kbps MP3. Refilling from 24 KB rides out 0.6 s of file system stall,
+ * e.g. SPIFFS garbage collection, see host/readahead_bench.c.
+ */
+#define AUDIO_READAHEAD_DEFAULT_CONFIG() {  \
+        .ring_size = 64 * 1024,             \
+        .read_size = 4 * 1024,              \
+        .low_watermark = 24 * 1024,         \
+        .high_watermark = 60 * 1024,        \
+        .priority = 4,                      \
+        .core = -1,                         \
+        .stack_size = 3 * 1024,             \
+        .stall_ms = 50,                     \
+    }
+
+typedef struct {
+    uint32_t streams;           /*!< Streams opened */
+    uint32_t reads;             /*!< File reads made by the reader tasks */
+    uint64_t bytes;             /*!< Bytes they read */
+    uint32_t stalls;            /*!< File reads that took longer than stall_ms */
+    uint32_t slowest_read_us;
+    uint32_t underruns;         /*!< Reads of the consumer that found the ring empty, the first data of a stream
+                                     or after a seek excepted */
+    uint64_t underrun_us;       /*!< Time the consumer waited in them */
+    uint32_t longest_underrun_us;
+    size_t min_fill;            /*!< Fewest bytes left buffered after a read of the consumer before the end of
+                                     the file, SIZE_MAX if none */
+} audio_readahead_stats_t;
+
+/**
+ * @brief Open a file for reading through a read-ahead ring
+ *
+ * The ring is allocated in PSRAM when there is some. A reader task keeps it between the watermarks with
+ * large reads, so the reads of the returned stream only wait on the file system when the ring runs empty.
+ * Pass the stream to audio_player_play() instead of the result of fopen(), fclose() ends the reader task.
+ *
+ * @param config NULL for AUDIO_READAHEAD_DEFAULT_CONFIG()
+ * @return Stream for fread(), fseek() and fclose(), NULL with errno set on failure
+ */
+FILE *audio_readahead_open(const char *path, const audio_readahead_config_t *config);
+
+/**
+ * @brief Same as audio_readahead_open() for a file already open, which the returned stream then owns
+ */
+FILE *audio_readahead_wrap(FILE *src, const audio_readahead_config_t *config);
+
+/**
+ * @brief Counters summed over all streams since boot or the last reset, open streams included
+ */
+void audio_readahead_get_stats(audio_readahead_stats_t *stats);
+
+void audio_readahead_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
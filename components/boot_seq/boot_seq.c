@@ -0,0 +1,382 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "boot_seq_priv.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_log.h"
+#else
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#endif
+
+#define BAR_WIDTH   40
+
+static const char *TAG = "boot_seq";
+
+static bool has_bit(uint32_t mask, size_t i)
+{
+    return mask & (1UL << i);
+}
+
+esp_err_t boot_seq_check(const boot_seq_step_t *steps, size_t num)
+{
+    if (!steps || !num || num > BOOT_SEQ_MAX_STEPS) {
+        ESP_LOGE(TAG, "1 to %d steps expected, got %u", BOOT_SEQ_MAX_STEPS, (unsigned)num);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t all = (uint32_t)((1ULL << num) - 1);
+    for (size_t i = 0; i < num; i++) {
+        const boot_seq_step_t *step = &steps[i];
+        if (!step->name || !step->fn) {
+            ESP_LOGE(TAG, "step %u has no name or no function", (unsigned)i);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if ((step->deps & ~all) || has_bit(step->deps, i)) {
+            ESP_LOGE(TAG, "%s depends on itself or on a step past the table", step->name);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (step->core != BOOT_SEQ_CORE_ANY && (step->core < 0 || step->core >= BOOT_SEQ_CORES)) {
+            ESP_LOGE(TAG, "%s is pinned to core %d, there are %d", step->name, step->core, BOOT_SEQ_CORES);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    /* Peel off steps whose dependencies are all peeled, whatever is left is on a cycle */
+    uint32_t peeled = 0;
+    for (bool progress = true; progress;) {
+        progress = false;
+        for (size_t i = 0; i < num; i++) {
+            if (!has_bit(peeled, i) && (steps[i].deps & peeled) == steps[i].deps) {
+                peeled |= 1UL << i;
+                progress = true;
+            }
+        }
+    }
+    if (peeled != all) {
+        for (size_t i = 0; i < num; i++) {
+            if (!has_bit(peeled, i)) {
+                ESP_LOGE(TAG, "%s is on a dependency cycle", steps[i].name);
+            }
+        }
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+static int64_t rank_of(boot_seq_sched_t *sched, size_t i)
+{
+    if (sched->rank[i] >= 0) {
+        return sched->rank[i];
+    }
+    int64_t longest = 0;
+    for (size_t j = 0; j < sched->num; j++) {
+        if (has_bit(sched->steps[j].deps, i)) {
+            int64_t r = rank_of(sched, j);
+            longest = r > longest ? r : longest;
+        }
+    }
+    sched->rank[i] = sched->steps[i].expect_ms + longest;
+    return sched->rank[i];
+}
+
+esp_err_t boot_seq_sched_init(boot_seq_sched_t *sched, const boot_seq_step_t *steps, size_t num,
+                              const boot_seq_config_t *config, boot_seq_report_t *report)
+{
+    esp_err_t ret = boot_seq_check(steps, num);
+    if (ESP_OK != ret) {
+        return ret;
+    }
+    if (!config || !config->workers || config->workers > BOOT_SEQ_MAX_WORKERS) {
+        ESP_LOGE(TAG, "1 to %d workers expected", BOOT_SEQ_MAX_WORKERS);
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Workers go to the cores in turn, a pinned step needs one on its core */
+    for (size_t i = 0; i < num; i++) {
+        if (steps[i].core != BOOT_SEQ_CORE_ANY && (size_t)steps[i].core >= config->workers) {
+            ESP_LOGE(TAG, "%s is pinned to core %d, no worker runs there with %u workers", steps[i].name,
+                     steps[i].core, (unsigned)config->workers);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    memset(sched, 0, sizeof(*sched));
+    sched->steps = steps;
+    sched->num = num;
+    sched->report = report;
+    for (size_t i = 0; i < num; i++) {
+        sched->rank[i] = -1;
+    }
+    for (size_t i = 0; i < num; i++) {
+        rank_of(sched, i);
+    }
+
+    memset(report, 0, sizeof(*report));
+    report->num = num;
+    report->workers = config->workers;
+    for (size_t i = 0; i < num; i++) {
+        report->steps[i].worker = -1;
+        report->steps[i].core = -1;
+    }
+    return ESP_OK;
+}
+
+static void skip_unreachable(boot_seq_sched_t *sched)
+{
+    for (bool progress = true; progress;) {
+        progress = false;
+        uint32_t failed = sched->ended & ~sched->ok;
+        for (size_t i = 0; i < sched->num; i++) {
+            if (!has_bit(sched->started, i) && (sched->steps[i].deps & failed)) {
+                sched->started |= 1UL << i;
+                sched->ended |= 1UL << i;
+                sched->report->steps[i].err = ESP_ERR_INVALID_STATE;
+                progress = true;
+            }
+        }
+    }
+}
+
+int boot_seq_sched_pick(boot_seq_sched_t *sched, int core)
+{
+    skip_unreachable(sched);
+
+    int best = -1;
+    for (size_t i = 0; i < sched->num; i++) {
+        const boot_seq_step_t *step = &sched->steps[i];
+        if (has_bit(sched->started, i) || (step->deps & sched->ok) != step->deps) {
+            continue;
+        }
+        if (step->core != BOOT_SEQ_CORE_ANY && step->core != core) {
+            continue;
+        }
+        if (best < 0 || sched->rank[i] > sched->rank[best]) {
+            best = i;
+        }
+    }
+    if (best >= 0) {
+        sched->started |= 1UL << best;
+    }
+    return best;
+}
+
+void boot_seq_sched_end(boot_seq_sched_t *sched, int index, esp_err_t err)
+{
+    sched->ended |= 1UL << index;
+    if (ESP_OK == err) {
+        sched->ok |= 1UL << index;
+    }
+    sched->report->steps[index].err = err;
+}
+
+void boot_seq_sched_abort(boot_seq_sched_t *sched, esp_err_t err)
+{
+    for (size_t i = 0; i < sched->num; i++) {
+        if (!has_bit(sched->started, i)) {
+            sched->started |= 1UL << i;
+            sched->ended |= 1UL << i;
+            sched->report->steps[i].err = err;
+        }
+    }
+}
+
+esp_err_t boot_seq_simulate(const boot_seq_step_t *steps, size_t num, const boot_seq_config_t *config,
+                            boot_seq_report_t *report)
+{
+    boot_seq_sched_t sched;
+    esp_err_t ret = boot_seq_sched_init(&sched, steps, num, config, report);
+    if (ESP_OK != ret) {
+        return ret;
+    }
+
+    int running[BOOT_SEQ_MAX_WORKERS];
+    for (size_t w = 0; w < config->workers; w++) {
+        running[w] = -1;
+    }
+
+    /* Discrete events: idle workers pick in turn, then time jumps to the next step end */
+    int64_t now = 0;
+    esp_err_t first_err = ESP_OK;
+    while (!boot_seq_sched_done(&sched)) {
+        for (size_t w = 0; w < config->workers; w++) {
+            if (running[w] >= 0) {
+                continue;
+            }
+            int i = boot_seq_sched_pick(&sched, w % BOOT_SEQ_CORES);
+            if (i >= 0) {
+                running[w] = i;
+                report->steps[i] = (boot_seq_record_t) {
+                    .start_us = now,
+                    .end_us = now + steps[i].expect_ms * 1000LL,
+                    .worker = w,
+                    .core = w % BOOT_SEQ_CORES,
+                };
+            }
+        }
+
+        int64_t next = INT64_MAX;
+        for (size_t w = 0; w < config->workers; w++) {
+            if (running[w] >= 0 && report->steps[running[w]].end_us < next) {
+                next = report->steps[running[w]].end_us;
+            }
+        }
+        if (INT64_MAX == next) {
+            /* Nothing running and nothing ready, cannot happen with a checked table */
+            boot_seq_sched_abort(&sched, ESP_FAIL);
+            first_err = ESP_FAIL;
+            break;
+        }
+        now = next;
+        for (size_t w = 0; w < config->workers; w++) {
+            if (running[w] >= 0 && report->steps[running[w]].end_us == now) {
+                boot_seq_sched_end(&sched, running[w], ESP_OK);
+                running[w] = -1;
+            }
+        }
+    }
+    report->total_us = now;
+    return first_err;
+}
+
+esp_err_t boot_seq_verify(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report)
+{
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < num; i++) {
+        const boot_seq_record_t *rec = &report->steps[i];
+        bool dep_failed = false;
+        for (size_t j = 0; j < num; j++) {
+            if (!has_bit(steps[i].deps, j)) {
+                continue;
+            }
+            const boot_seq_record_t *dep = &report->steps[j];
+            dep_failed |= ESP_OK != dep->err;
+            if (rec->worker >= 0 && (dep->worker < 0 || dep->end_us > rec->start_us)) {
+                ESP_LOGE(TAG, "%s started at %lld us, before %s ended", steps[i].name,
+                         (long long)rec->start_us, steps[j].name);
+                ret = ESP_FAIL;
+            }
+        }
+        if (rec->worker < 0 && !dep_failed) {
+            ESP_LOGE(TAG, "%s did not run but none of its dependencies failed", steps[i].name);
+            ret = ESP_FAIL;
+        }
+        if (rec->worker >= 0 && steps[i].core != BOOT_SEQ_CORE_ANY && rec->core != steps[i].core) {
+            ESP_LOGE(TAG, "%s ran on core %d instead of %d", steps[i].name, rec->core, steps[i].core);
+            ret = ESP_FAIL;
+        }
+    }
+    return ret;
+}
+
+static int64_t chain_of(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report, size_t i,
+                        int64_t *longest, int *pred)
+{
+    if (longest[i] >= 0) {
+        return longest[i];
+    }
+    const boot_seq_record_t *rec = &report->steps[i];
+    int64_t before = 0;
+    for (size_t j = 0; j < num; j++) {
+        if (has_bit(steps[i].deps, j)) {
+            int64_t c = chain_of(steps, num, report, j, longest, pred);
+            if (c > before) {
+                before = c;
+                pred[i] = j;
+            }
+        }
+    }
+    longest[i] = before + (rec->worker >= 0 ? rec->end_us - rec->start_us : 0);
+    return longest[i];
+}
+
+int64_t boot_seq_critical_path(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report,
+                               size_t path[BOOT_SEQ_MAX_STEPS], size_t *path_len)
+{
+    int64_t longest[BOOT_SEQ_MAX_STEPS];
+    int pred[BOOT_SEQ_MAX_STEPS];
+    for (size_t i = 0; i < num; i++) {
+        longest[i] = -1;
+        pred[i] = -1;
+    }
+
+    int last = -1;
+    for (size_t i = 0; i < num; i++) {
+        if (last < 0 || chain_of(steps, num, report, i, longest, pred) > longest[last]) {
+            last = i;
+        }
+    }
+
+    size_t len = 0;
+    for (int i = last; i >= 0; i = pred[i]) {
+        len++;
+    }
+    if (path) {
+        size_t k = len;
+        for (int i = last; i >= 0; i = pred[i]) {
+            path[--k] = i;
+        }
+    }
+    if (path_len) {
+        *path_len = len;
+    }
+    return last >= 0 ? longest[last] : 0;
+}
+
+void boot_seq_print_report(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report)
+{
+    size_t path[BOOT_SEQ_MAX_STEPS];
+    size_t path_len;
+    int64_t critical_us = boot_seq_critical_path(steps, num, report, path, &path_len);
+    int64_t total_us = report->total_us > 0 ? report->total_us : 1;
+
+    printf("boot_seq: %u steps on %u workers in %.1f ms, critical path %.1f ms\n", (unsigned)num,
+           (unsigned)report->workers, report->total_us / 1000.0, critical_us / 1000.0);
+    printf("boot_seq: %-16s %4s %9s %9s %9s\n", "step", "core", "start", "end", "took");
+
+    /* In start order, steps that did not run last */
+    size_t order[BOOT_SEQ_MAX_STEPS];
+    for (size_t i = 0; i < num; i++) {
+        size_t k = i;
+        const boot_seq_record_t *rec = &report->steps[i];
+        while (k > 0) {
+            const boot_seq_record_t *prev = &report->steps[order[k - 1]];
+            bool later = prev->worker < 0 ? rec->worker >= 0 : rec->worker >= 0 && prev->start_us > rec->start_us;
+            if (!later) {
+                break;
+            }
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+
+    for (size_t n = 0; n < num; n++) {
+        size_t i = order[n];
+        const boot_seq_record_t *rec = &report->steps[i];
+        if (rec->worker < 0) {
+            printf("boot_seq: %-16s skipped, a dependency failed\n", steps[i].name);
+            continue;
+        }
+        char bar[BAR_WIDTH + 1];
+        int from = rec->start_us * BAR_WIDTH / total_us;
+        int to = (rec->end_us * BAR_WIDTH + total_us - 1) / total_us;
+        for (int c = 0; c < BAR_WIDTH; c++) {
+            bar[c] = c >= from && (c < to || c == from) ? '=' : ' ';
+        }
+        bar[BAR_WIDTH] = '\0';
+        printf("boot_seq: %-16s %4d %9.1f %9.1f %9.1f |%s|%s\n", steps[i].name, rec->core, rec->start_us / 1000.0,
+               rec->end_us / 1000.0, (rec->end_us - rec->start_us) / 1000.0, bar,
+               ESP_OK == rec->err ? "" : steps[i].optional ? " failed, optional" : " failed");
+    }
+
+    printf("boot_seq: critical path:");
+    for (size_t k = 0; k < path_len; k++) {
+        printf("%s %s", k ? " >" : "", steps[path[k]].name);
+    }
+    printf("\n");
+}
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Scheduling shared by boot_seq_run() and boot_seq_simulate(), the caller serializes access */
+
+#pragma once
+
+#include "boot_seq.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#define BOOT_SEQ_CORES          portNUM_PROCESSORS
+#else
+#define BOOT_SEQ_CORES          2
+#endif
+
+#define BOOT_SEQ_MAX_WORKERS    8
+
+typedef struct {
+    const boot_seq_step_t *steps;
+    size_t num;
+    boot_seq_report_t *report;
+    uint32_t started;
+    uint32_t ended;             /* Ran to the end or skipped */
+    uint32_t ok;
+    int64_t rank[BOOT_SEQ_MAX_STEPS];   /* Expected ms from the start of the step to the end of its longest chain */
+} boot_seq_sched_t;
+
+/**
+ * @brief Checks the table and the configuration, clears the report
+ */
+esp_err_t boot_seq_sched_init(boot_seq_sched_t *sched, const boot_seq_step_t *steps, size_t num,
+                              const boot_seq_config_t *config, boot_seq_report_t *report);
+
+/**
+ * @brief Next step for a worker on core and mark it started, -1 if none is ready
+ *
+ * Steps that can no longer run because a dependency failed are marked as skipped on the way.
+ */
+int boot_seq_sched_pick(boot_seq_sched_t *sched, int core);
+
+void boot_seq_sched_end(boot_seq_sched_t *sched, int index, esp_err_t err);
+
+/**
+ * @brief Skip every step that has not started yet
+ */
+void boot_seq_sched_abort(boot_seq_sched_t *sched, esp_err_t err);
+
+static inline bool boot_seq_sched_done(const boot_seq_sched_t *sched)
+{
+    return sched->ended == (uint32_t)((1ULL << sched->num) - 1);
+}
@@ -0,0 +1,167 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "boot_seq_priv.h"
+
+static const char *TAG = "boot_seq";
+
+typedef struct boot_seq_ctx boot_seq_ctx_t;
+
+typedef struct {
+    boot_seq_ctx_t *ctx;
+    size_t index;
+} worker_arg_t;
+
+struct boot_seq_ctx {
+    boot_seq_sched_t sched;
+    SemaphoreHandle_t lock;
+    EventGroupHandle_t exited;      /* One bit per worker */
+    TaskHandle_t workers[BOOT_SEQ_MAX_WORKERS];
+    worker_arg_t args[BOOT_SEQ_MAX_WORKERS];
+    bool alive[BOOT_SEQ_MAX_WORKERS];
+    size_t num_workers;
+    int64_t t0;
+    esp_err_t first_err;
+};
+
+/* Called with the lock held */
+static void wake_workers(boot_seq_ctx_t *ctx)
+{
+    for (size_t w = 0; w < ctx->num_workers; w++) {
+        if (ctx->alive[w]) {
+            xTaskNotifyGive(ctx->workers[w]);
+        }
+    }
+}
+
+static void worker_task(void *pvParameters)
+{
+    worker_arg_t *arg = (worker_arg_t *) pvParameters;
+    boot_seq_ctx_t *ctx = arg->ctx;
+    size_t w = arg->index;
+    int core = w % BOOT_SEQ_CORES;
+
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    while (!boot_seq_sched_done(&ctx->sched)) {
+        int i = boot_seq_sched_pick(&ctx->sched, core);
+        if (i < 0) {
+            /* Nothing ready for this core, wait for a step to end somewhere */
+            xSemaphoreGive(ctx->lock);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            xSemaphoreTake(ctx->lock, portMAX_DELAY);
+            continue;
+        }
+        xSemaphoreGive(ctx->lock);
+
+        const boot_seq_step_t *step = &ctx->sched.steps[i];
+        int64_t start = esp_timer_get_time() - ctx->t0;
+        esp_err_t err = step->fn(step->arg);
+        int64_t end = esp_timer_get_time() - ctx->t0;
+        if (ESP_OK != err && step->optional) {
+            ESP_LOGW(TAG, "%s failed: %s, optional, boot goes on", step->name, esp_err_to_name(err));
+        } else if (ESP_OK != err) {
+            ESP_LOGE(TAG, "%s failed: %s", step->name, esp_err_to_name(err));
+        }
+
+        xSemaphoreTake(ctx->lock, portMAX_DELAY);
+        ctx->sched.report->steps[i] = (boot_seq_record_t) {
+            .start_us = start,
+            .end_us = end,
+            .worker = w,
+            .core = core,
+        };
+        boot_seq_sched_end(&ctx->sched, i, err);
+        if (ESP_OK != err && !step->optional && ESP_OK == ctx->first_err) {
+            ctx->first_err = err;
+        }
+        wake_workers(ctx);
+    }
+    ctx->alive[w] = false;
+    xSemaphoreGive(ctx->lock);
+    /* Last access to ctx, boot_seq_run() frees it once every worker got here */
+    xEventGroupSetBits(ctx->exited, BIT(w));
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_seq_run(const boot_seq_step_t *steps, size_t num, const boot_seq_config_t *config,
+                       boot_seq_report_t *report)
+{
+    esp_err_t ret = ESP_OK;
+    boot_seq_report_t *own_report = NULL;
+    boot_seq_ctx_t *ctx = calloc(1, sizeof(boot_seq_ctx_t));
+    ESP_RETURN_ON_FALSE(ctx, ESP_ERR_NO_MEM, TAG, "No memory for the sequencer");
+    if (NULL == report) {
+        own_report = malloc(sizeof(boot_seq_report_t));
+        ESP_GOTO_ON_FALSE(own_report, ESP_ERR_NO_MEM, err, TAG, "No memory for the report");
+        report = own_report;
+    }
+
+    ESP_GOTO_ON_ERROR(boot_seq_sched_init(&ctx->sched, steps, num, config, report), err, TAG, "Invalid steps");
+    ctx->lock = xSemaphoreCreateMutex();
+    ctx->exited = xEventGroupCreate();
+    ESP_GOTO_ON_FALSE(ctx->lock && ctx->exited, ESP_ERR_NO_MEM, err, TAG, "No memory for the lock");
+
+    /* Workers wait for the lock until all of them exist, so none can finish the sequence alone */
+    EventBits_t all_exited = 0;
+    xSemaphoreTake(ctx->lock, portMAX_DELAY);
+    ctx->t0 = esp_timer_get_time();
+    for (size_t w = 0; w < config->workers; w++) {
+        ctx->args[w] = (worker_arg_t) {
+            .ctx = ctx,
+            .index = w,
+        };
+        ctx->alive[w] = true;
+        if (pdPASS != xTaskCreatePinnedToCore(worker_task, "boot_seq", config->stack_size, &ctx->args[w],
+                                              config->priority, &ctx->workers[w], w % BOOT_SEQ_CORES)) {
+            ctx->alive[w] = false;
+            boot_seq_sched_abort(&ctx->sched, ESP_ERR_NO_MEM);
+            ctx->first_err = ESP_ERR_NO_MEM;
+            ESP_LOGE(TAG, "No memory for worker %u", (unsigned) w);
+            break;
+        }
+        ctx->num_workers++;
+        all_exited |= BIT(w);
+    }
+    xSemaphoreGive(ctx->lock);
+
+    /* Steps still running after an abort end normally, the workers then see the sequence done */
+    if (all_exited) {
+        xEventGroupWaitBits(ctx->exited, all_exited, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+    report->total_us = 0;
+    for (size_t i = 0; i < num; i++) {
+        if (report->steps[i].worker >= 0 && report->steps[i].end_us > report->total_us) {
+            report->total_us = report->steps[i].end_us;
+        }
+    }
+    ret = ctx->first_err;
+    /* A critical step skipped after an optional one failed fails the boot as well */
+    for (size_t i = 0; i < num && ESP_OK == ret; i++) {
+        if (!steps[i].optional && ESP_ERR_INVALID_STATE == report->steps[i].err) {
+            ESP_LOGE(TAG, "%s skipped, it depends on a step that failed", steps[i].name);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+
+err:
+    if (ctx->lock) {
+        vSemaphoreDelete(ctx->lock);
+    }
+    if (ctx->exited) {
+        vEventGroupDelete(ctx->exited);
+    }
+    free(ctx);
+    free(own_report);
+    return ret;
+}
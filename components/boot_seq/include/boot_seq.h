@@ -0,0 +1,120 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_SEQ_MAX_STEPS      32
+#define BOOT_SEQ_CORE_ANY       (-1)
+
+typedef esp_err_t (*boot_seq_fn_t)(void *arg);
+
+/**
+ * @brief One init step, steps are given as a table and refer to each other by index
+ */
+typedef struct {
+    const char *name;
+    boot_seq_fn_t fn;
+    void *arg;
+    uint32_t deps;              /*!< BIT() of the steps that must have succeeded before this one starts */
+    int core;                   /*!< Core to run on, BOOT_SEQ_CORE_ANY to let any worker take it */
+    uint32_t expect_ms;         /*!< Expected duration. Ready steps heading the longest expected chain start first,
+                                     boot_seq_simulate() takes it as the duration */
+    bool optional;              /*!< The device works without it: a failure is logged but not returned by
+                                     boot_seq_run(). Critical steps depending on it are still skipped */
+} boot_seq_step_t;
+
+typedef struct {
+    int64_t start_us;           /*!< Since the sequence started */
+    int64_t end_us;
+    int worker;                 /*!< Worker that ran it, -1 if it did not run */
+    int core;
+    esp_err_t err;              /*!< ESP_ERR_INVALID_STATE if skipped because a dependency failed */
+} boot_seq_record_t;
+
+typedef struct {
+    size_t num;
+    size_t workers;
+    int64_t total_us;           /*!< First start to last end */
+    boot_seq_record_t steps[BOOT_SEQ_MAX_STEPS];
+} boot_seq_report_t;
+
+typedef struct {
+    size_t workers;             /*!< Worker tasks, pinned to the cores in turn */
+    int priority;
+    uint32_t stack_size;
+} boot_seq_config_t;
+
+/* One worker per core at the priority of app_main */
+#define BOOT_SEQ_DEFAULT_CONFIG() { \
+        .workers = 2,               \
+        .priority = 1,              \
+        .stack_size = 4096,         \
+    }
+
+/**
+ * @brief Check a step table: size, dependencies on existing steps, no cycle, cores that exist
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG with the reason logged
+ */
+esp_err_t boot_seq_check(const boot_seq_step_t *steps, size_t num);
+
+#ifdef ESP_PLATFORM
+/**
+ * @brief Run the steps on worker tasks and return once all of them ended or were skipped
+ *
+ * A step starts as soon as its dependencies succeeded and a worker on a suitable core is idle. When a step
+ * fails, the steps depending on it are skipped and the others still run.
+ *
+ * @param report Filled with the timeline, may be NULL
+ * @return ESP_OK when every critical step succeeded, the first error returned by a critical step,
+ *         ESP_ERR_INVALID_STATE when a critical step was skipped after an optional one failed,
+ *         or an error of the sequencer itself
+ */
+esp_err_t boot_seq_run(const boot_seq_step_t *steps, size_t num, const boot_seq_config_t *config,
+                       boot_seq_report_t *report);
+#endif
+
+/**
+ * @brief Schedule the steps as boot_seq_run() would, with expect_ms as their durations, without calling them
+ */
+esp_err_t boot_seq_simulate(const boot_seq_step_t *steps, size_t num, const boot_seq_config_t *config,
+                            boot_seq_report_t *report);
+
+/**
+ * @brief Check that no step started before all of its dependencies ended, and that only failures skipped steps
+ *
+ * @return ESP_OK, or ESP_FAIL with each violation logged
+ */
+esp_err_t boot_seq_verify(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report);
+
+/**
+ * @brief Longest chain of dependent steps by their durations in the report, the time boot would take with
+ *        a worker for every step
+ *
+ * @param path     Indexes of the steps on the chain, first step first, may be NULL
+ * @param path_len Steps on the chain, may be NULL
+ * @return Sum of the durations along the chain
+ */
+int64_t boot_seq_critical_path(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report,
+                               size_t path[BOOT_SEQ_MAX_STEPS], size_t *path_len);
+
+/**
+ * @brief Print the timeline, one bar per step, and the critical path
+ */
+void boot_seq_print_report(const boot_seq_step_t *steps, size_t num, const boot_seq_report_t *report);
+
+#ifdef __cplusplus
+}
+#endif
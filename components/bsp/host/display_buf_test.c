@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * bsp_display_buf_config() on the fake heaps of stubs/fake_heap.c: each mode with room to spare, the reserve left in
+ * internal DMA memory, a fragmented internal heap, and the fallbacks to PSRAM, to double partial buffers and to a
+ * single buffer.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "fake_heap.h"
+
+/* Included for INTERNAL_DMA_RESERVE */
+#include "../src/display/bsp_display_buf.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define KB              (1024)
+#define MB              (1024 * 1024)
+#define LINE_BYTES      (BSP_LCD_H_RES * sizeof(lv_color_t))
+#define PARTIAL_BYTES   (LINE_BYTES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT)
+
+typedef struct {
+    bsp_display_buf_mode_t mode;
+    uint32_t buffer_size;
+    bool double_buffer;
+    bool dma;
+    bool spiram;
+} expect_t;
+
+static bool configured(bsp_display_buf_mode_t request, const expect_t *expect)
+{
+    bsp_display_cfg_t cfg = { 0 };
+    bsp_display_buf_mode_t mode = bsp_display_buf_config(&cfg, request);
+
+    CHECK(expect->mode == mode, "mode %d for %d, expected %d", mode, request, expect->mode);
+    CHECK(expect->buffer_size == cfg.buffer_size, "%u px, expected %u", (unsigned) cfg.buffer_size,
+          (unsigned) expect->buffer_size);
+    CHECK(expect->double_buffer == cfg.double_buffer, "double_buffer %d", cfg.double_buffer);
+    CHECK(expect->dma == cfg.flags.buff_dma, "buff_dma %u", cfg.flags.buff_dma);
+    CHECK(expect->spiram == cfg.flags.buff_spiram, "buff_spiram %u", cfg.flags.buff_spiram);
+    return true;
+}
+
+/* Room for everything: each mode as asked, the default is the one of sdkconfig */
+static bool test_modes(void)
+{
+    const uint32_t partial = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT;
+    const uint32_t full = BSP_LCD_H_RES * BSP_LCD_V_RES;
+
+    fake_heap_set(256 * KB, 128 * KB, 8 * MB, 8 * MB);
+    CHECK(configured(BSP_DISPLAY_BUF_SINGLE, &(expect_t) {
+        BSP_DISPLAY_BUF_SINGLE, partial, false, true, false
+    }), "single");
+    CHECK(configured(BSP_DISPLAY_BUF_DOUBLE, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, true, false
+    }), "double");
+    CHECK(configured(BSP_DISPLAY_BUF_FULL, &(expect_t) {
+        BSP_DISPLAY_BUF_FULL, full, true, false, true
+    }), "full");
+    CHECK(configured(BSP_DISPLAY_BUF_DEFAULT, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, true, false
+    }), "default");
+    return true;
+}
+
+/* Two partial buffers stay internal as long as INTERNAL_DMA_RESERVE is left after them, not one byte less */
+static bool test_reserve(void)
+{
+    const uint32_t partial = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT;
+    const size_t just = 2 * PARTIAL_BYTES + INTERNAL_DMA_RESERVE;
+
+    fake_heap_set(just, just, 8 * MB, 8 * MB);
+    CHECK(configured(BSP_DISPLAY_BUF_DOUBLE, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, true, false
+    }), "at the reserve");
+    fake_heap_set(just - 1, just - 1, 8 * MB, 8 * MB);
+    CHECK(configured(BSP_DISPLAY_BUF_DOUBLE, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, false, true
+    }), "into the reserve");
+
+    /* One buffer needs half of it */
+    fake_heap_set(PARTIAL_BYTES + INTERNAL_DMA_RESERVE, 64 * KB, 0, 0);
+    CHECK(configured(BSP_DISPLAY_BUF_SINGLE, &(expect_t) {
+        BSP_DISPLAY_BUF_SINGLE, partial, false, true, false
+    }), "single at the reserve");
+    return true;
+}
+
+/* Enough free in total but no block for a buffer */
+static bool test_fragmented(void)
+{
+    const uint32_t partial = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT;
+
+    fake_heap_set(256 * KB, PARTIAL_BYTES - 1, 8 * MB, 8 * MB);
+    CHECK(configured(BSP_DISPLAY_BUF_DOUBLE, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, false, true
+    }), "internal blocks too small");
+
+    /* Nor in PSRAM for a full frame */
+    fake_heap_set(256 * KB, 128 * KB, 8 * MB, BSP_LCD_H_RES * BSP_LCD_V_RES * sizeof(lv_color_t) - 1);
+    CHECK(configured(BSP_DISPLAY_BUF_FULL, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, true, false
+    }), "PSRAM blocks too small");
+    return true;
+}
+
+/* Without PSRAM: full frame falls back to double partial, then to a single internal buffer */
+static bool test_no_psram(void)
+{
+    const uint32_t partial = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT;
+
+    fake_heap_set(256 * KB, 128 * KB, 0, 0);
+    CHECK(configured(BSP_DISPLAY_BUF_FULL, &(expect_t) {
+        BSP_DISPLAY_BUF_DOUBLE, partial, true, true, false
+    }), "full without PSRAM");
+
+    fake_heap_set(PARTIAL_BYTES + INTERNAL_DMA_RESERVE, 64 * KB, 0, 0);
+    CHECK(configured(BSP_DISPLAY_BUF_DOUBLE, &(expect_t) {
+        BSP_DISPLAY_BUF_SINGLE, partial, false, true, false
+    }), "double short of internal RAM");
+    CHECK(configured(BSP_DISPLAY_BUF_FULL, &(expect_t) {
+        BSP_DISPLAY_BUF_SINGLE, partial, false, true, false
+    }), "full short of internal RAM");
+
+    /* Nothing smaller to fall back to, the allocation of esp_lvgl_port tells */
+    fake_heap_set(16 * KB, 16 * KB, 0, 0);
+    CHECK(configured(BSP_DISPLAY_BUF_SINGLE, &(expect_t) {
+        BSP_DISPLAY_BUF_SINGLE, partial, false, true, false
+    }), "single short of internal RAM");
+    return true;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"modes", test_modes},
+        {"reserve", test_reserve},
+        {"fragmented", test_fragmented},
+        {"no psram", test_no_psram},
+    };
+    int failed = 0;
+
+    /* The fallbacks warn, only the results are printed */
+    esp_log_level_set("*", ESP_LOG_NONE);
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
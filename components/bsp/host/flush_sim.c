@@ -0,0 +1,193 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The frame rate of each draw buffer mode on a simulated SPI bus, the host counterpart of
+ * examples/lv_demos/main/flush_bench.c. The buffers are the ones bsp_display_buf_config() picks on a BOX-3 heap.
+ * A frame is rendered and flushed in chunks as lv_refr.c of LVGL v8.3 does:
+ *
+ * - single: rendering of a chunk waits until the previous one is off the bus
+ * - double and full: a chunk renders while the previous one is sent, its flush waits for the bus
+ *
+ * Rendering costs a fixed time per pixel, more in PSRAM, and a flush from PSRAM first copies the chunk to internal
+ * DMA memory on the CPU, as the SPI master driver does for buffers that are not DMA capable. The refresh timer runs
+ * every millisecond, as in the board benchmark. Exits with 1 when double buffering is slower than single buffering
+ * or when a scene goes faster than the bus allows.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bsp_display_buf.h"
+#include "esp_log.h"
+#include "fake_heap.h"
+
+#define KB                  (1024)
+#define MB                  (1024 * 1024)
+#define REFR_PERIOD_US      (1000.0)
+
+typedef struct {
+    const char *name;
+    int w;                  /* Area invalidated every frame */
+    int h;
+} scene_t;
+
+typedef struct {
+    int spi_mhz;
+    double render_ns;       /* Per pixel into internal RAM */
+    int spiram_pct;         /* Extra render time into PSRAM */
+    double bounce_ns;       /* Per byte copied from PSRAM to internal DMA memory before a transfer */
+    int seconds;
+} sim_opt_t;
+
+typedef struct {
+    unsigned frames;
+    double refr_us;         /* Time in the refresh timer, rendering and waiting for the bus */
+    double bus_us;
+} sim_result_t;
+
+/* As flush_bench.c: the whole screen, and a spinner of 80 x 80 on a still screen */
+static const scene_t s_scenes[] = {
+    {"full screen", BSP_LCD_H_RES, BSP_LCD_V_RES},
+    {"spinner", 80, 80},
+};
+
+static const bsp_display_buf_mode_t s_modes[] = {
+    BSP_DISPLAY_BUF_SINGLE,
+    BSP_DISPLAY_BUF_DOUBLE,
+    BSP_DISPLAY_BUF_FULL,
+};
+
+static sim_opt_t s_opt = {
+    .spi_mhz = 40,
+    .render_ns = 60,
+    .spiram_pct = 50,
+    .bounce_ns = 6,
+    .seconds = 5,
+};
+
+static double max_d(double a, double b)
+{
+    return a > b ? a : b;
+}
+
+static sim_result_t simulate(const scene_t *scene, const bsp_display_cfg_t *cfg)
+{
+    const double end = s_opt.seconds * 1e6;
+    const double render_us = s_opt.render_ns / 1000 * (cfg->flags.buff_spiram ? 1 + s_opt.spiram_pct / 100.0 : 1);
+    const double bounce_us = cfg->flags.buff_spiram ? s_opt.bounce_ns / 1000 * sizeof(lv_color_t) : 0;
+    /* LVGL fills the buffer with as many whole rows of the area as fit */
+    const int rows = (int) cfg->buffer_size / scene->w < scene->h ? (int) cfg->buffer_size / scene->w : scene->h;
+    sim_result_t result = { 0 };
+    double now = 0;
+    double bus_free = 0;
+    double next_refr = 0;
+
+    while (true) {
+        double start = max_d(now, next_refr);
+        now = start;
+        next_refr = start + REFR_PERIOD_US;
+        for (int y = 0; y < scene->h; y += rows) {
+            int px = scene->w * (y + rows <= scene->h ? rows : scene->h - y);
+            if (!cfg->double_buffer) {
+                now = max_d(now, bus_free);
+            }
+            now += px * render_us;
+            now = max_d(now, bus_free);
+            now += px * bounce_us;
+            /* Bits on the bus over the clock in MHz gives microseconds */
+            double xfer = (double) px * 8 * sizeof(lv_color_t) / s_opt.spi_mhz;
+            bus_free = now + xfer;
+            result.bus_us += xfer;
+        }
+        if (now > end) {
+            break;
+        }
+        result.frames++;
+        result.refr_us += now - start;
+    }
+    return result;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-m spi_mhz] [-r render_ns_per_px] [-p psram_render_pct] [-b bounce_ns_per_byte] "
+            "[-s seconds]\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "m:r:p:b:s:h")) != -1) {
+        switch (c) {
+        case 'm':
+            s_opt.spi_mhz = atoi(optarg);
+            break;
+        case 'r':
+            s_opt.render_ns = atof(optarg);
+            break;
+        case 'p':
+            s_opt.spiram_pct = atoi(optarg);
+            break;
+        case 'b':
+            s_opt.bounce_ns = atof(optarg);
+            break;
+        case 's':
+            s_opt.seconds = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (s_opt.spi_mhz <= 0 || s_opt.render_ns <= 0 || s_opt.spiram_pct < 0 || s_opt.bounce_ns < 0 ||
+            s_opt.seconds <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    /* A BOX-3 once Wi-Fi is up: about 160 KB of internal DMA memory in blocks up to 96 KB, 8 MB of PSRAM */
+    fake_heap_set(160 * KB, 96 * KB, 8 * MB, 8 * MB);
+    esp_log_level_set("*", ESP_LOG_NONE);
+
+    printf("%dx%d, %d MHz SPI, render %.0f ns/px, PSRAM +%d %% and %.0f ns/B bounce, %d s per run\n",
+           BSP_LCD_H_RES, BSP_LCD_V_RES, s_opt.spi_mhz, s_opt.render_ns, s_opt.spiram_pct, s_opt.bounce_ns,
+           s_opt.seconds);
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(s_scenes) / sizeof(s_scenes[0]); i++) {
+        const scene_t *scene = &s_scenes[i];
+        /* Every frame puts the whole area on the bus */
+        double bus_fps = s_opt.spi_mhz * 1e6 / ((double) scene->w * scene->h * 8 * sizeof(lv_color_t));
+        double single_fps = 0;
+
+        for (size_t m = 0; m < sizeof(s_modes) / sizeof(s_modes[0]); m++) {
+            bsp_display_cfg_t cfg = { 0 };
+            bsp_display_buf_mode_t mode = bsp_display_buf_config(&cfg, s_modes[m]);
+            sim_result_t r = simulate(scene, &cfg);
+            double fps = r.frames / (double) s_opt.seconds;
+
+            printf("%-12s %-7s %u x %6u B %-8s %5u frames %6.1f FPS %6.1f ms/frame, bus %3.0f %%\n", scene->name,
+                   mode == BSP_DISPLAY_BUF_SINGLE ? "single" : mode == BSP_DISPLAY_BUF_DOUBLE ? "double" : "full",
+                   cfg.double_buffer ? 2 : 1, (unsigned)(cfg.buffer_size * sizeof(lv_color_t)),
+                   cfg.flags.buff_spiram ? "PSRAM" : "internal", r.frames, fps,
+                   r.frames ? r.refr_us / r.frames / 1000 : 0.0, 100 * r.bus_us / (s_opt.seconds * 1e6));
+            if (fps > bus_fps) {
+                printf("%s: %.1f FPS is more than the bus carries (%.1f)\n", scene->name, fps, bus_fps);
+                failed++;
+            }
+            if (BSP_DISPLAY_BUF_SINGLE == mode) {
+                single_fps = fps;
+            } else if (BSP_DISPLAY_BUF_DOUBLE == mode && fps < single_fps) {
+                printf("%s: double buffering is slower than single\n", scene->name);
+                failed++;
+            }
+        }
+    }
+    return failed ? 1 : 0;
+}
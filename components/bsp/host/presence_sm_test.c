@@ -0,0 +1,302 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Drives the presence state machine with a fake millisecond clock, then replays a day of random presence against
+ * the per-second polling it replaced.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp_presence_sm.h"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define HOLD_MS         60000
+#define IDLE_MS         60000
+#define DAY_MS          (24 * 3600 * 1000U)
+
+typedef struct {
+    int count;
+    bsp_presence_state_t from[16];
+    bsp_presence_state_t to[16];
+} transitions_t;
+
+static void on_transition(bsp_presence_state_t from, bsp_presence_state_t to, void *user_data)
+{
+    transitions_t *log = user_data;
+    if (log->count < 16) {
+        log->from[log->count] = from;
+        log->to[log->count] = to;
+    }
+    log->count++;
+}
+
+static void init(bsp_presence_sm_t *sm, transitions_t *log, uint32_t now)
+{
+    bsp_presence_sm_config_t config = {
+        .active_hold_ms = HOLD_MS,
+        .idle_timeout_ms = IDLE_MS,
+        .cb = on_transition,
+        .user_data = log,
+    };
+    memset(log, 0, sizeof(*log));
+    bsp_presence_sm_init(sm, &config, now);
+}
+
+static bool test_timeouts(void)
+{
+    bsp_presence_sm_t sm;
+    transitions_t log;
+    uint32_t t = 1000;
+
+    init(&sm, &log, t);
+    CHECK(HOLD_MS == bsp_presence_sm_update(&sm, t), "first deadline");
+    bsp_presence_sm_set_level(&sm, true, t, t);
+    CHECK(BSP_PRESENCE_NO_DEADLINE == bsp_presence_sm_update(&sm, t + 10 * HOLD_MS), "timeout while present");
+    CHECK(BSP_PRESENCE_STATE_ACTIVE == sm.state, "left ACTIVE while present");
+
+    /* Timeouts run from the falling edge, not from when the task saw it */
+    t += 10 * HOLD_MS;
+    bsp_presence_sm_set_level(&sm, false, t, t + 500);
+    CHECK(HOLD_MS - 500 == bsp_presence_sm_update(&sm, t + 500), "hold deadline not from the edge");
+    CHECK(BSP_PRESENCE_STATE_ACTIVE == sm.state, "left ACTIVE early");
+    CHECK(IDLE_MS == bsp_presence_sm_update(&sm, t + HOLD_MS), "idle deadline");
+    CHECK(BSP_PRESENCE_STATE_IDLE == sm.state, "not IDLE after the hold time");
+    CHECK(BSP_PRESENCE_NO_DEADLINE == bsp_presence_sm_update(&sm, t + HOLD_MS + IDLE_MS), "deadline in SLEEP");
+    CHECK(BSP_PRESENCE_STATE_SLEEP == sm.state, "not SLEEP after the idle time");
+
+    /* A late update goes through IDLE to SLEEP in one call */
+    init(&sm, &log, 0);
+    bsp_presence_sm_update(&sm, 5 * HOLD_MS);
+    CHECK(2 == log.count && BSP_PRESENCE_STATE_IDLE == log.to[0] && BSP_PRESENCE_STATE_SLEEP == log.to[1],
+          "%d transitions on a late update", log.count);
+
+    /* Presence in IDLE goes back to ACTIVE and restarts the hold */
+    init(&sm, &log, 0);
+    bsp_presence_sm_update(&sm, HOLD_MS + 10);
+    bsp_presence_sm_set_level(&sm, true, HOLD_MS + 20, HOLD_MS + 20);
+    bsp_presence_sm_set_level(&sm, false, HOLD_MS + 30, HOLD_MS + 30);
+    CHECK(BSP_PRESENCE_STATE_ACTIVE == sm.state && HOLD_MS == bsp_presence_sm_update(&sm, HOLD_MS + 30),
+          "IDLE presence did not restart the hold");
+
+    /* A repeated level is not an edge */
+    bsp_presence_sm_set_level(&sm, false, HOLD_MS + 5000, HOLD_MS + 5000);
+    CHECK(HOLD_MS - 4970 == bsp_presence_sm_update(&sm, HOLD_MS + 5000), "repeated low level moved the timeout");
+    return true;
+}
+
+static bool test_wake_latency(void)
+{
+    bsp_presence_sm_t sm;
+    transitions_t log;
+    bsp_presence_stats_t stats;
+
+    /* Updates at the deadlines, as the monitor task wakes for them */
+    init(&sm, &log, 0);
+    bsp_presence_sm_update(&sm, HOLD_MS);
+    bsp_presence_sm_update(&sm, HOLD_MS + IDLE_MS);
+    bsp_presence_sm_set_level(&sm, true, 200000, 200035);
+    bsp_presence_sm_set_level(&sm, false, 201000, 201000);
+    bsp_presence_sm_update(&sm, 201000 + HOLD_MS);
+    bsp_presence_sm_update(&sm, 201000 + HOLD_MS + IDLE_MS);
+    bsp_presence_sm_set_level(&sm, true, 400000, 400012);
+
+    bsp_presence_sm_get_stats(&sm, 400012, &stats);
+    CHECK(12 == stats.sleep_exit_latency_ms && 35 == stats.sleep_exit_latency_max_ms, "latency %u, max %u",
+          (unsigned) stats.sleep_exit_latency_ms, (unsigned) stats.sleep_exit_latency_max_ms);
+    CHECK(3 == stats.enter_count[BSP_PRESENCE_STATE_ACTIVE] && 2 == stats.enter_count[BSP_PRESENCE_STATE_SLEEP],
+          "enter counts");
+    uint64_t total = 0;
+    for (int i = 0; i < BSP_PRESENCE_STATE_MAX; i++) {
+        total += stats.residency_ms[i];
+    }
+    CHECK(400012 == total, "residency sums to %llu", (unsigned long long) total);
+    CHECK(HOLD_MS + (201000 + HOLD_MS - 200035) == stats.residency_ms[BSP_PRESENCE_STATE_ACTIVE], "ACTIVE residency %llu",
+          (unsigned long long) stats.residency_ms[BSP_PRESENCE_STATE_ACTIVE]);
+    return true;
+}
+
+static bool test_disable(void)
+{
+    bsp_presence_sm_t sm;
+    transitions_t log;
+
+    init(&sm, &log, 0);
+    bsp_presence_sm_set_enable(&sm, false, 100);
+    CHECK(BSP_PRESENCE_STATE_DISABLED == sm.state, "not DISABLED");
+    CHECK(BSP_PRESENCE_NO_DEADLINE == bsp_presence_sm_update(&sm, 10 * HOLD_MS), "deadline while disabled");
+    bsp_presence_sm_set_level(&sm, true, 10 * HOLD_MS, 10 * HOLD_MS);
+    CHECK(BSP_PRESENCE_STATE_DISABLED == sm.state, "presence left DISABLED");
+    bsp_presence_sm_set_level(&sm, false, 10 * HOLD_MS + 1, 10 * HOLD_MS + 1);
+
+    /* Enabling restarts the timeouts from then, not from the last presence */
+    bsp_presence_sm_set_enable(&sm, true, 20 * HOLD_MS);
+    CHECK(BSP_PRESENCE_STATE_ACTIVE == sm.state && HOLD_MS == bsp_presence_sm_update(&sm, 20 * HOLD_MS),
+          "enable did not restart the hold");
+
+    /* Disabling from SLEEP, and enabling twice */
+    bsp_presence_sm_update(&sm, 22 * HOLD_MS);
+    CHECK(BSP_PRESENCE_STATE_SLEEP == sm.state, "not SLEEP");
+    bsp_presence_sm_set_enable(&sm, false, 23 * HOLD_MS);
+    bsp_presence_sm_set_enable(&sm, true, 24 * HOLD_MS);
+    bsp_presence_sm_set_enable(&sm, true, 24 * HOLD_MS + 5);
+    CHECK(HOLD_MS == bsp_presence_sm_update(&sm, 24 * HOLD_MS), "second enable moved the timeout");
+    return true;
+}
+
+/* The millisecond counter wraps after 49 days, the timeouts must not notice */
+static bool test_wrap(void)
+{
+    bsp_presence_sm_t sm;
+    transitions_t log;
+    uint32_t start = UINT32_MAX - HOLD_MS / 2;
+    bsp_presence_stats_t stats;
+
+    init(&sm, &log, start);
+    CHECK(HOLD_MS / 2 == bsp_presence_sm_update(&sm, start + HOLD_MS / 2), "deadline across the wrap");
+    CHECK(BSP_PRESENCE_STATE_ACTIVE == sm.state, "left ACTIVE at the wrap");
+    bsp_presence_sm_update(&sm, start + HOLD_MS);
+    CHECK(BSP_PRESENCE_STATE_IDLE == sm.state, "not IDLE after the wrap");
+    bsp_presence_sm_get_stats(&sm, start + HOLD_MS + 10, &stats);
+    CHECK(HOLD_MS == stats.residency_ms[BSP_PRESENCE_STATE_ACTIVE], "ACTIVE residency %llu across the wrap",
+          (unsigned long long) stats.residency_ms[BSP_PRESENCE_STATE_ACTIVE]);
+    return true;
+}
+
+static uint32_t s_rng = 0x9E3779B9;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* Radar edges of a day: visits of 5 s to 20 min, apart by 1 s to 2 h */
+static int make_day(uint32_t *edges, int max)
+{
+    int count = 0;
+    uint32_t t = 0;
+    while (count + 2 <= max) {
+        t += 1000 + rng_next() % (2 * 3600 * 1000);
+        if (t >= DAY_MS) {
+            break;
+        }
+        edges[count++] = t;
+        t += 5000 + rng_next() % (20 * 60 * 1000);
+        edges[count++] = t < DAY_MS ? t : DAY_MS - 1;
+    }
+    return count;
+}
+
+/* The monitor task as in esp32_bsp_sensor.c: sleep until the next edge or the next deadline */
+static uint32_t run_event_driven(const uint32_t *edges, int count, uint64_t *sleep_ms, uint32_t *sleeps)
+{
+    bsp_presence_sm_t sm;
+    transitions_t log;
+    bsp_presence_stats_t stats;
+    uint32_t wakeups = 0;
+    uint32_t now = 0;
+    int next = 0;
+
+    init(&sm, &log, 0);
+    while (now < DAY_MS) {
+        uint32_t wait = bsp_presence_sm_update(&sm, now);
+        uint32_t edge = next < count ? edges[next] : DAY_MS;
+        uint32_t deadline = (BSP_PRESENCE_NO_DEADLINE == wait) ? DAY_MS : now + wait;
+        now = edge < deadline ? edge : deadline;
+        if (now >= DAY_MS) {
+            break;
+        }
+        wakeups++;
+        if (now == edge) {
+            bsp_presence_sm_set_level(&sm, !(next & 1), edge, now);
+            next++;
+        }
+    }
+    bsp_presence_sm_get_stats(&sm, DAY_MS, &stats);
+    *sleep_ms = stats.residency_ms[BSP_PRESENCE_STATE_SLEEP];
+    *sleeps = stats.enter_count[BSP_PRESENCE_STATE_SLEEP];
+    return wakeups;
+}
+
+/* The previous monitor task: read the radar once a second, sleep after 2 min without presence */
+static uint32_t run_polled(const uint32_t *edges, int count, uint64_t *sleep_ms, uint32_t *sleeps)
+{
+    uint32_t wakeups = 0;
+    uint32_t last_seen = 0;
+    bool asleep = false;
+    int next = 0;
+    bool present = false;
+
+    *sleep_ms = 0;
+    *sleeps = 0;
+    for (uint32_t now = 1000; now < DAY_MS; now += 1000) {
+        wakeups++;
+        while (next < count && edges[next] <= now) {
+            present = !(next & 1);
+            next++;
+        }
+        if (present) {
+            last_seen = now;
+            asleep = false;
+        } else if (!asleep && now - last_seen >= HOLD_MS + IDLE_MS) {
+            asleep = true;
+            (*sleeps)++;
+        }
+        *sleep_ms += asleep ? 1000 : 0;
+    }
+    return wakeups;
+}
+
+static bool test_day(void)
+{
+    static uint32_t edges[4096];
+    int count = make_day(edges, 4096);
+    uint64_t event_sleep, poll_sleep;
+    uint32_t event_sleeps, poll_sleeps;
+
+    uint32_t event_wakeups = run_event_driven(edges, count, &event_sleep, &event_sleeps);
+    uint32_t poll_wakeups = run_polled(edges, count, &poll_sleep, &poll_sleeps);
+
+    printf("%-14s %8s %8s %10s\n", "day", "wakeups", "sleeps", "asleep s");
+    printf("%-14s %8u %8u %10.0f\n", "polled 1 s", (unsigned) poll_wakeups, (unsigned) poll_sleeps, poll_sleep / 1e3);
+    printf("%-14s %8u %8u %10.0f\n", "event driven", (unsigned) event_wakeups, (unsigned) event_sleeps,
+           event_sleep / 1e3);
+
+    CHECK(event_sleeps == poll_sleeps, "%u sleeps against %u polled", (unsigned) event_sleeps, (unsigned) poll_sleeps);
+    /* Polling notices an edge up to 1 s late, at each end of each sleep */
+    int64_t diff = (int64_t) event_sleep - (int64_t) poll_sleep;
+    CHECK(diff <= 2000LL * poll_sleeps && diff >= -2000LL * poll_sleeps, "asleep %.0f s against %.0f s polled",
+          event_sleep / 1e3, poll_sleep / 1e3);
+    CHECK(event_wakeups * 100 < poll_wakeups, "%u wakeups", (unsigned) event_wakeups);
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_timeouts, test_wake_latency, test_disable, test_wrap, test_day,
+    };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Two heaps reporting the sizes they were given, PSRAM for MALLOC_CAP_SPIRAM and internal RAM for the rest */
+
+#include "esp_heap_caps.h"
+#include "fake_heap.h"
+
+static size_t s_free[2];
+static size_t s_largest[2];
+
+void fake_heap_set(size_t internal_free, size_t internal_largest, size_t spiram_free, size_t spiram_largest)
+{
+    s_free[0] = internal_free;
+    s_largest[0] = internal_largest;
+    s_free[1] = spiram_free;
+    s_largest[1] = spiram_largest;
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return s_free[(caps & MALLOC_CAP_SPIRAM) ? 1 : 0];
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return s_largest[(caps & MALLOC_CAP_SPIRAM) ? 1 : 0];
+}
@@ -0,0 +1,27 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host stand-in for the ESP32-S3-BOX-3 BSP, only the display configuration that bsp_display_buf.c fills in */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BSP_LCD_H_RES   (320)
+#define BSP_LCD_V_RES   (240)
+
+/* LV_COLOR_DEPTH 16 */
+typedef uint16_t lv_color_t;
+
+typedef struct {
+    uint32_t buffer_size;           /*!< Size of each draw buffer in pixels */
+    bool double_buffer;
+    struct {
+        unsigned int buff_dma: 1;
+        unsigned int buff_spiram: 1;
+    } flags;
+} bsp_display_cfg_t;
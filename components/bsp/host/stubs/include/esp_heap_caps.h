@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stand-in, the free sizes come from fake_heap.c. Shadows the esp_heap_caps.h of components/host_stubs, which
+ * maps every capability to malloc().
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_bit_defs.h"
+
+#define MALLOC_CAP_DMA          BIT(3)
+#define MALLOC_CAP_SPIRAM       BIT(10)
+#define MALLOC_CAP_INTERNAL     BIT(11)
+
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/* Free bytes and largest free block of DMA capable internal RAM and of PSRAM, 0 for no PSRAM */
+void fake_heap_set(size_t internal_free, size_t internal_largest, size_t spiram_free, size_t spiram_largest);
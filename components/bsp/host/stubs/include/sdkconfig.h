@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The options of the examples' sdkconfig.defaults, PSRAM present: fake_heap_set() decides how much there is */
+
+#pragma once
+
+#define CONFIG_SPIRAM                   1
+#define CONFIG_BSP_LCD_DRAW_BUF_HEIGHT  10
+#define CONFIG_BSP_DISPLAY_BUF_DOUBLE   1
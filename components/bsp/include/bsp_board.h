@@ -14,6 +14,7 @@
 
 #include "bsp/esp-bsp.h"
 #include "iot_button.h"
+#include "bsp_presence.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -135,6 +136,23 @@ typedef bottom_id_t (*bsp_sys_get_bottom_id)();
  */
 typedef esp_err_t (*bsp_bottom_get_humiture)(float *temperature, float *humidity);
 
+/**
+ * @brief Register presence state transition callback
+ *
+ * @note The callback runs in the sensor monitor task after the BSP has suspended or resumed its peripherals.
+ *
+ * @param cb: Transition callback, NULL to unregister
+ * @param user_data: User data passed to the callback
+ */
+typedef void (*bsp_bottom_register_presence_cb)(bsp_presence_cb_t cb, void *user_data);
+
+/**
+ * @brief Get presence state residency and wake-up latency
+ *
+ * @param stats: Output statistics
+ */
+typedef void (*bsp_bottom_get_presence_stats)(bsp_presence_stats_t *stats);
+
 /**
  * @brief Player set mute.
  *
@@ -224,6 +242,8 @@ typedef struct {
     bsp_bottom_set_radar_enable set_radar_enable;
     bsp_bottom_get_radar_status get_radar_status;
     bsp_bottom_get_humiture get_humiture;
+    bsp_bottom_register_presence_cb register_presence_cb;
+    bsp_bottom_get_presence_stats get_presence_stats;
 } bsp_bottom_property_t;
 
 typedef struct {
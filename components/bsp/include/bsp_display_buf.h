@@ -0,0 +1,40 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "bsp/esp-bsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BSP_DISPLAY_BUF_DEFAULT = 0,    /*!< Mode selected in menuconfig */
+    BSP_DISPLAY_BUF_SINGLE,         /*!< One partial buffer, rendering waits for every transfer */
+    BSP_DISPLAY_BUF_DOUBLE,         /*!< Two partial buffers, a chunk renders while the previous one is sent */
+    BSP_DISPLAY_BUF_FULL,           /*!< Two full-frame buffers in PSRAM */
+} bsp_display_buf_mode_t;
+
+/**
+ * @brief Fill in the draw buffers of a display configuration
+ *
+ * Partial buffers hold CONFIG_BSP_LCD_DRAW_BUF_HEIGHT lines of DMA capable internal RAM and move to PSRAM
+ * when that would leave internal RAM short. Full-frame buffers fall back to double partial ones without PSRAM.
+ *
+ * @note A flush completes from the panel IO "color transfer done" callback, so with two buffers LVGL renders
+ *       into one while the other is on the bus
+ *
+ * @param cfg   Configuration for bsp_display_start_with_config(), only the buffer fields are written
+ * @param mode  Requested mode
+ *
+ * @return The mode actually configured
+ */
+bsp_display_buf_mode_t bsp_display_buf_config(bsp_display_cfg_t *cfg, bsp_display_buf_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
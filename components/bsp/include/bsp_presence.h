@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BSP_PRESENCE_STATE_ACTIVE,      /*!< Presence detected recently, radar status is active */
+    BSP_PRESENCE_STATE_IDLE,        /*!< Nobody detected for a while, counting down to sleep */
+    BSP_PRESENCE_STATE_SLEEP,       /*!< Display, LVGL, buttons and codec are suspended */
+    BSP_PRESENCE_STATE_DISABLED,    /*!< Radar function disabled, the system never sleeps */
+    BSP_PRESENCE_STATE_MAX,
+} bsp_presence_state_t;
+
+/**
+ * @brief Presence state transition callback
+ *
+ * @param from: State being left
+ * @param to: State being entered
+ * @param user_data: User data passed at registration
+ */
+typedef void (*bsp_presence_cb_t)(bsp_presence_state_t from, bsp_presence_state_t to, void *user_data);
+
+typedef struct {
+    uint64_t residency_ms[BSP_PRESENCE_STATE_MAX];  /*!< Total time spent in each state */
+    uint32_t enter_count[BSP_PRESENCE_STATE_MAX];   /*!< Number of times each state was entered */
+    uint32_t sleep_exit_latency_ms;                 /*!< Radar edge to SLEEP exit, last wake-up */
+    uint32_t sleep_exit_latency_max_ms;             /*!< Radar edge to SLEEP exit, worst case */
+} bsp_presence_stats_t;
+
+#ifdef __cplusplus
+}
+#endif
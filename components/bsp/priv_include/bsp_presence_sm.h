@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bsp_presence.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BSP_PRESENCE_NO_DEADLINE    UINT32_MAX
+
+typedef struct {
+    uint32_t active_hold_ms;        /*!< ACTIVE -> IDLE after this long without presence */
+    uint32_t idle_timeout_ms;       /*!< IDLE -> SLEEP after this much longer */
+    bsp_presence_cb_t cb;           /*!< Transition callback, may be NULL */
+    void *user_data;
+} bsp_presence_sm_config_t;
+
+/**
+ * @brief Presence/sleep state machine
+ *
+ * Time is passed in by the caller as a millisecond counter, no OS service is used,
+ * so the same code runs on target and against a fake clock.
+ */
+typedef struct {
+    bsp_presence_sm_config_t config;
+    bsp_presence_state_t state;
+    bool present;                   /*!< Radar output level */
+    uint32_t last_seen_ms;          /*!< Last time presence ended */
+    uint32_t state_enter_ms;
+    bsp_presence_stats_t stats;
+} bsp_presence_sm_t;
+
+/**
+ * @brief Init the state machine in ACTIVE state
+ */
+void bsp_presence_sm_init(bsp_presence_sm_t *sm, const bsp_presence_sm_config_t *config, uint32_t now_ms);
+
+/**
+ * @brief Feed a radar output level change
+ *
+ * @param present: New radar output level
+ * @param event_ms: Time the edge happened
+ * @param now_ms: Current time
+ */
+void bsp_presence_sm_set_level(bsp_presence_sm_t *sm, bool present, uint32_t event_ms, uint32_t now_ms);
+
+/**
+ * @brief Enable or disable the radar function
+ */
+void bsp_presence_sm_set_enable(bsp_presence_sm_t *sm, bool enable, uint32_t now_ms);
+
+/**
+ * @brief Run pending timeouts
+ *
+ * @return Milliseconds until the next timeout, BSP_PRESENCE_NO_DEADLINE if none is pending
+ */
+uint32_t bsp_presence_sm_update(bsp_presence_sm_t *sm, uint32_t now_ms);
+
+/**
+ * @brief Get counters, including the time spent in the current state so far
+ */
+void bsp_presence_sm_get_stats(const bsp_presence_sm_t *sm, uint32_t now_ms, bsp_presence_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "bsp_presence_sm.h"
+
+static void bsp_presence_sm_transition(bsp_presence_sm_t *sm, bsp_presence_state_t to, uint32_t now_ms)
+{
+    bsp_presence_state_t from = sm->state;
+
+    if (from == to) {
+        return;
+    }
+
+    sm->stats.residency_ms[from] += (uint32_t)(now_ms - sm->state_enter_ms);
+    sm->stats.enter_count[to]++;
+    sm->state_enter_ms = now_ms;
+    sm->state = to;
+
+    if (sm->config.cb) {
+        sm->config.cb(from, to, sm->config.user_data);
+    }
+}
+
+void bsp_presence_sm_init(bsp_presence_sm_t *sm, const bsp_presence_sm_config_t *config, uint32_t now_ms)
+{
+    memset(sm, 0, sizeof(bsp_presence_sm_t));
+    sm->config = *config;
+    sm->state = BSP_PRESENCE_STATE_ACTIVE;
+    sm->state_enter_ms = now_ms;
+    sm->last_seen_ms = now_ms;
+    sm->stats.enter_count[BSP_PRESENCE_STATE_ACTIVE] = 1;
+}
+
+void bsp_presence_sm_set_level(bsp_presence_sm_t *sm, bool present, uint32_t event_ms, uint32_t now_ms)
+{
+    if (present == sm->present) {
+        return;
+    }
+    sm->present = present;
+
+    if (!present) {
+        /* Timeouts count from the moment the radar stopped seeing anyone */
+        sm->last_seen_ms = event_ms;
+        return;
+    }
+
+    if (BSP_PRESENCE_STATE_DISABLED == sm->state) {
+        return;
+    }
+
+    if (BSP_PRESENCE_STATE_SLEEP == sm->state) {
+        uint32_t latency = now_ms - event_ms;
+        sm->stats.sleep_exit_latency_ms = latency;
+        if (latency > sm->stats.sleep_exit_latency_max_ms) {
+            sm->stats.sleep_exit_latency_max_ms = latency;
+        }
+    }
+    bsp_presence_sm_transition(sm, BSP_PRESENCE_STATE_ACTIVE, now_ms);
+}
+
+void bsp_presence_sm_set_enable(bsp_presence_sm_t *sm, bool enable, uint32_t now_ms)
+{
+    if (enable) {
+        if (BSP_PRESENCE_STATE_DISABLED == sm->state) {
+            sm->last_seen_ms = now_ms;
+            bsp_presence_sm_transition(sm, BSP_PRESENCE_STATE_ACTIVE, now_ms);
+        }
+    } else {
+        bsp_presence_sm_transition(sm, BSP_PRESENCE_STATE_DISABLED, now_ms);
+    }
+}
+
+uint32_t bsp_presence_sm_update(bsp_presence_sm_t *sm, uint32_t now_ms)
+{
+    if (sm->present || BSP_PRESENCE_STATE_DISABLED == sm->state || BSP_PRESENCE_STATE_SLEEP == sm->state) {
+        return BSP_PRESENCE_NO_DEADLINE;
+    }
+
+    uint32_t absent_ms = now_ms - sm->last_seen_ms;
+    uint32_t sleep_after_ms = sm->config.active_hold_ms + sm->config.idle_timeout_ms;
+
+    if (BSP_PRESENCE_STATE_ACTIVE == sm->state && absent_ms >= sm->config.active_hold_ms) {
+        bsp_presence_sm_transition(sm, BSP_PRESENCE_STATE_IDLE, now_ms);
+    }
+    if (BSP_PRESENCE_STATE_IDLE == sm->state && absent_ms >= sleep_after_ms) {
+        bsp_presence_sm_transition(sm, BSP_PRESENCE_STATE_SLEEP, now_ms);
+        return BSP_PRESENCE_NO_DEADLINE;
+    }
+
+    if (BSP_PRESENCE_STATE_ACTIVE == sm->state) {
+        return sm->config.active_hold_ms - absent_ms;
+    }
+    return sleep_after_ms - absent_ms;
+}
+
+void bsp_presence_sm_get_stats(const bsp_presence_sm_t *sm, uint32_t now_ms, bsp_presence_stats_t *stats)
+{
+    memcpy(stats, &sm->stats, sizeof(bsp_presence_stats_t));
+    stats->residency_ms[sm->state] += (uint32_t)(now_ms - sm->state_enter_ms);
+}
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string.h>
 #include "esp_log.h"
 #include "esp_check.h"
 #include "bsp_board.h"
@@ -35,6 +36,16 @@ static esp_err_t bsp_sensor_get_humiture(float *temperature, float *humidity)
     return ESP_FAIL;
 }
 
+static void bsp_sensor_register_presence_cb(bsp_presence_cb_t cb, void *user_data)
+{
+    return;
+}
+
+static void bsp_sensor_get_presence_stats(bsp_presence_stats_t *stats)
+{
+    memset(stats, 0, sizeof(bsp_presence_stats_t));
+}
+
 esp_err_t bsp_sensor_init(bsp_bottom_property_t *handle)
 {
     ESP_LOGW(TAG, "This example don't support Sensor!!");
@@ -44,6 +55,8 @@ esp_err_t bsp_sensor_init(bsp_bottom_property_t *handle)
     handle->get_radar_status = bsp_sensor_get_radar_status;
     handle->set_radar_enable = bsp_sensor_set_radar_enable;
     handle->get_humiture = bsp_sensor_get_humiture;
+    handle->register_presence_cb = bsp_sensor_register_presence_cb;
+    handle->get_presence_stats = bsp_sensor_get_presence_stats;
 
     return ESP_ERR_NOT_SUPPORTED;
 }
@@ -7,29 +7,52 @@
 #include "esp_log.h"
 #include "esp_check.h"
 #include "esp_pm.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "bsp_board.h"
 #include "aht20.h"
 #include "at581x.h"
+#include "bsp_presence_sm.h"
 
 #define BSP_I2C_EXPAND_NUM              ((1 == BSP_I2C_NUM) ? (0):(1))
 #define BSP_I2C_EXPAND_CLK_SPEED_HZ     CONFIG_BSP_I2C_CLK_SPEED_HZ
 
-#define RADAE_POWER_DELAY               (60 * 2) // 2min
-#define RADAE_FUNC_STOP                 (RADAE_POWER_DELAY + 1)
+#define RADAR_ACTIVE_HOLD_MS            (60 * 1000)
+#define RADAR_IDLE_TIMEOUT_MS           (60 * 1000)
+#define HUMITURE_PERIOD_MS              CONFIG_BSP_SENSOR_HUMITURE_PERIOD_MS
+
+typedef enum {
+    SENSOR_EVENT_RADAR_LEVEL,
+    SENSOR_EVENT_RADAR_ENABLE,
+} sensor_event_type_t;
+
+typedef struct {
+    sensor_event_type_t type;
+    bool value;
+    uint32_t time_ms;
+} sensor_event_t;
 
 static bool sys_sleep_entered = false;
 static bottom_id_t sys_bottom_id;
 
 static float sys_temp_result;
 static float sys_RH_result;
-static uint16_t power_off_delay;
 
 static aht20_dev_handle_t aht20 = NULL;
 static esp_pm_lock_handle_t g_pm_apb_lock = NULL;
 static esp_pm_lock_handle_t g_pm_light_lock = NULL;
 static esp_pm_lock_handle_t g_pm_cpu_lock = NULL;
 
+static QueueHandle_t sensor_event_queue = NULL;
+static SemaphoreHandle_t presence_lock = NULL;
+static bsp_presence_sm_t presence_sm;
+static bsp_presence_cb_t presence_user_cb = NULL;
+static void *presence_user_data = NULL;
+
 static const char *TAG = "bsp_sensor";
 
 static esp_err_t bsp_pm_init();
@@ -38,6 +61,11 @@ static esp_err_t bsp_pm_enter_sleep();
 
 static bool bsp_i2c_device_probe(i2c_port_t i2c_num, uint8_t addr);
 
+static uint32_t bsp_sensor_now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
 static bool bsp_get_sleep_mode()
 {
     return sys_sleep_entered;
@@ -51,7 +79,7 @@ static bottom_id_t bsp_get_bottom_id()
 static bool bsp_sensor_get_radar_status()
 {
     if (BOTTOM_ID_SENSOR == sys_bottom_id) {
-        return ((power_off_delay > RADAE_POWER_DELAY / 2) ? (true) : (false));
+        return (BSP_PRESENCE_STATE_ACTIVE == presence_sm.state);
     } else {
         return false;
     }
@@ -59,11 +87,12 @@ static bool bsp_sensor_get_radar_status()
 
 static void bsp_sensor_set_radar_onoff(bool enable)
 {
-    if (enable) {
-        power_off_delay = RADAE_POWER_DELAY;
-    } else {
-        power_off_delay = RADAE_FUNC_STOP;
-    }
+    sensor_event_t event = {
+        .type = SENSOR_EVENT_RADAR_ENABLE,
+        .value = enable,
+        .time_ms = bsp_sensor_now_ms(),
+    };
+    xQueueSend(sensor_event_queue, &event, portMAX_DELAY);
 }
 
 static esp_err_t bsp_sensor_get_humiture(float *temperature, float *humidity)
@@ -77,65 +106,155 @@ static esp_err_t bsp_sensor_get_humiture(float *temperature, float *humidity)
     }
 }
 
-static void low_power_monitor_task(void *arg)
+static void bsp_sensor_register_presence_cb(bsp_presence_cb_t cb, void *user_data)
+{
+    xSemaphoreTakeRecursive(presence_lock, portMAX_DELAY);
+    presence_user_cb = cb;
+    presence_user_data = user_data;
+    xSemaphoreGiveRecursive(presence_lock);
+}
+
+static void bsp_sensor_get_presence_stats(bsp_presence_stats_t *stats)
+{
+    xSemaphoreTakeRecursive(presence_lock, portMAX_DELAY);
+    bsp_presence_sm_get_stats(&presence_sm, bsp_sensor_now_ms(), stats);
+    xSemaphoreGiveRecursive(presence_lock);
+}
+
+static void bsp_sensor_presence_transition(bsp_presence_state_t from, bsp_presence_state_t to, void *user_data)
+{
+    ESP_LOGD(TAG, "Presence state %d -> %d", from, to);
+
+    if (BSP_PRESENCE_STATE_SLEEP == to) {
+        ESP_LOGD(TAG, "power off");
+        sys_sleep_entered = true;
+        bsp_display_enter_sleep();
+
+        lvgl_port_stop();
+        iot_button_stop();
+        bsp_codec_dev_stop();
+        bsp_pm_enter_sleep();
+    } else if (BSP_PRESENCE_STATE_SLEEP == from) {
+        bsp_pm_exit_sleep();
+
+        ESP_LOGD(TAG, "power on");
+        bsp_display_exit_sleep();
+
+        lvgl_port_resume();
+        iot_button_resume();
+        bsp_codec_dev_resume();
+        sys_sleep_entered = false;
+    }
+
+    if (presence_user_cb) {
+        presence_user_cb(from, to, presence_user_data);
+    }
+}
+
+/* Light sleep wakes on GPIO levels only, and the wakeup level is also the interrupt type of the pin. The pin
+ * waits for the level it is not at, and each interrupt flips it, which makes edges out of level interrupts.
+ * A change between the read and the flip raises the interrupt again at once.
+ */
+static void bsp_radar_wait_level_change(int level)
+{
+    gpio_set_intr_type(BSP_RADAR_OUT_IO, level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+}
+
+static void bsp_radar_isr_handler(void *arg)
+{
+    BaseType_t task_woken = pdFALSE;
+    int level = gpio_get_level(BSP_RADAR_OUT_IO);
+    bsp_radar_wait_level_change(level);
+    sensor_event_t event = {
+        .type = SENSOR_EVENT_RADAR_LEVEL,
+        .value = level,
+        .time_ms = bsp_sensor_now_ms(),
+    };
+
+    xQueueSendFromISR(sensor_event_queue, &event, &task_woken);
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+static void bsp_sensor_read_humiture(void)
 {
-    static uint8_t gpio_level_prev = 1;
     uint32_t temp_raw, RH_raw;
-    uint8_t gpio_level;
+
+    if (BOTTOM_ID_UNKNOW == sys_bottom_id) {
+        return;
+    }
+
+    /* A failing read replaces the periodic bus probe for detecting a removed bottom */
+    esp_err_t ret = aht20_read_temperature_humidity(aht20, &temp_raw, &sys_temp_result, &RH_raw, &sys_RH_result);
+    bottom_id_t bottom_id = (ESP_OK == ret) ? BOTTOM_ID_SENSOR : BOTTOM_ID_LOST;
+
+    if (bottom_id != sys_bottom_id) {
+        sys_bottom_id = bottom_id;
+        ESP_LOGW(TAG, "Sensor bottom %s", (BOTTOM_ID_SENSOR == bottom_id) ? "connected" : "lost");
+        /* Without the bottom there is no radar, stay awake like a permanent presence */
+        bool present = (BOTTOM_ID_SENSOR == bottom_id) ? gpio_get_level(BSP_RADAR_OUT_IO) : true;
+        uint32_t now = bsp_sensor_now_ms();
+        bsp_presence_sm_set_level(&presence_sm, present, now, now);
+    }
+}
+
+static void low_power_monitor_task(void *arg)
+{
+    sensor_event_t event;
+    uint32_t next_sample_ms = bsp_sensor_now_ms();
 
     gpio_config_t io_conf = {};
-    io_conf.intr_type = GPIO_INTR_POSEDGE;
+    io_conf.intr_type = GPIO_INTR_DISABLE;
     io_conf.pin_bit_mask = (1ULL << BSP_RADAR_OUT_IO);
     io_conf.mode = GPIO_MODE_INPUT;
     io_conf.pull_up_en = 1;
     gpio_config(&io_conf);
     vTaskDelay(pdMS_TO_TICKS(1500));
 
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ESP_OK != ret && ESP_ERR_INVALID_STATE != ret) {
+        ESP_LOGE(TAG, "Install GPIO ISR service failed");
+    }
+    gpio_isr_handler_add(BSP_RADAR_OUT_IO, bsp_radar_isr_handler, NULL);
+    /* Let the radar wake the chip from automatic light sleep, on the level it is not at */
+    gpio_wakeup_enable(BSP_RADAR_OUT_IO, gpio_get_level(BSP_RADAR_OUT_IO) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    xSemaphoreTakeRecursive(presence_lock, portMAX_DELAY);
+    uint32_t now = bsp_sensor_now_ms();
+    bool present = (BOTTOM_ID_SENSOR == sys_bottom_id) ? gpio_get_level(BSP_RADAR_OUT_IO) : true;
+    bsp_presence_sm_set_level(&presence_sm, present, now, now);
+    xSemaphoreGiveRecursive(presence_lock);
 
-        if (sys_bottom_id != BOTTOM_ID_UNKNOW) {
-            sys_bottom_id = (bsp_i2c_device_probe(BSP_I2C_EXPAND_NUM, AT581X_ADDRRES_0)) ? BOTTOM_ID_SENSOR : BOTTOM_ID_LOST;
+    while (1) {
+        xSemaphoreTakeRecursive(presence_lock, portMAX_DELAY);
+        now = bsp_sensor_now_ms();
+        if ((int32_t)(now - next_sample_ms) >= 0) {
+            bsp_sensor_read_humiture();
+            next_sample_ms = now + HUMITURE_PERIOD_MS;
         }
 
-        if (BOTTOM_ID_SENSOR == sys_bottom_id) {
-            gpio_level = gpio_get_level(BSP_RADAR_OUT_IO);
-            if ((RADAE_FUNC_STOP != power_off_delay) && power_off_delay) {
-                power_off_delay--;
-            }
-            aht20_read_temperature_humidity(aht20, &temp_raw, &sys_temp_result, &RH_raw, &sys_RH_result);
-        } else {
-            gpio_level = 1;
+        uint32_t wait_ms = bsp_presence_sm_update(&presence_sm, now);
+        if (BOTTOM_ID_UNKNOW != sys_bottom_id) {
+            uint32_t sample_wait_ms = next_sample_ms - now;
+            wait_ms = (sample_wait_ms < wait_ms) ? sample_wait_ms : wait_ms;
         }
+        xSemaphoreGiveRecursive(presence_lock);
 
-        if (gpio_level_prev ^ gpio_level) {
-            gpio_level_prev = gpio_level;
-            if (gpio_level && (RADAE_FUNC_STOP != power_off_delay)) {
-                power_off_delay = RADAE_POWER_DELAY;
-                ESP_LOGD(TAG, "Radar: %s", "active");
-            }
+        TickType_t wait_ticks = (BSP_PRESENCE_NO_DEADLINE == wait_ms) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+        if (pdTRUE != xQueueReceive(sensor_event_queue, &event, wait_ticks)) {
+            continue;
         }
 
-        if ((gpio_level) && (true == sys_sleep_entered)) {
-            bsp_pm_exit_sleep();
-
-            ESP_LOGD(TAG, "power on");
-            bsp_display_exit_sleep();
-
-            lvgl_port_resume();
-            iot_button_resume();
-            bsp_codec_dev_resume();
-            sys_sleep_entered = false;
-        } else if ((1 == power_off_delay) && (BOTTOM_ID_SENSOR == sys_bottom_id)) {
-            ESP_LOGD(TAG, "power off");
-            sys_sleep_entered = true;
-            bsp_display_enter_sleep();
-
-            lvgl_port_stop();
-            iot_button_stop();
-            bsp_codec_dev_stop();
-            bsp_pm_enter_sleep();
+        xSemaphoreTakeRecursive(presence_lock, portMAX_DELAY);
+        if (SENSOR_EVENT_RADAR_ENABLE == event.type) {
+            bsp_presence_sm_set_enable(&presence_sm, event.value, bsp_sensor_now_ms());
+        } else if (BOTTOM_ID_SENSOR == sys_bottom_id) {
+            ESP_LOGD(TAG, "Radar: %s", event.value ? "active" : "passive");
+            bsp_presence_sm_set_level(&presence_sm, event.value, event.time_ms, bsp_sensor_now_ms());
         }
+        xSemaphoreGiveRecursive(presence_lock);
     }
 }
 
@@ -224,11 +343,28 @@ static esp_err_t bsp_pm_init()
     }
     bsp_pm_exit_sleep();
 
+    sensor_event_queue = xQueueCreate(8, sizeof(sensor_event_t));
+    presence_lock = xSemaphoreCreateRecursiveMutex();
+    ESP_RETURN_ON_FALSE(sensor_event_queue && presence_lock, ESP_ERR_NO_MEM, TAG, "create sensor event queue failed");
+
+    bsp_presence_sm_config_t presence_cfg = {
+        .active_hold_ms = RADAR_ACTIVE_HOLD_MS,
+        .idle_timeout_ms = RADAR_IDLE_TIMEOUT_MS,
+        .cb = bsp_sensor_presence_transition,
+    };
+    bsp_presence_sm_init(&presence_sm, &presence_cfg, bsp_sensor_now_ms());
+
     ret = xTaskCreatePinnedToCore(&low_power_monitor_task, "Lowpower Task", 4 * 1024, NULL, 5, NULL, 1);
     ESP_RETURN_ON_ERROR(pdPASS != ret, TAG,  "create Lowpower task failed");
     return ret;
 }
 
+/*
+ * Stays on the legacy driver on purpose: the aht20 and at581x components take an i2c_port_t and talk through
+ * i2c_master_cmd_begin() on the bus installed below. ESP-IDF aborts at startup when the i2c_master driver is
+ * linked next to the legacy one, so an i2c_master_probe() here needs both sensor drivers ported first. This is
+ * the only transaction the BSP builds itself, it runs once per bsp_sensor_init().
+ */
 static bool bsp_i2c_device_probe(i2c_port_t i2c_num, uint8_t addr)
 {
     bool probe_result = false;
@@ -303,6 +439,8 @@ esp_err_t bsp_sensor_init(bsp_bottom_property_t *handle)
     handle->get_radar_status = bsp_sensor_get_radar_status;
     handle->set_radar_enable = bsp_sensor_set_radar_onoff;
     handle->get_humiture = bsp_sensor_get_humiture;
+    handle->register_presence_cb = bsp_sensor_register_presence_cb;
+    handle->get_presence_stats = bsp_sensor_get_presence_stats;
 
     return ret;
 }
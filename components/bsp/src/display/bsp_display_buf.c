@@ -0,0 +1,91 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#include "bsp_display_buf.h"
+
+/* Left to Wi-Fi, SPI and I2S DMA descriptors once the draw buffers are allocated */
+#define INTERNAL_DMA_RESERVE    (48 * 1024)
+
+static const char *TAG = "bsp_display_buf";
+
+static const char *const s_mode_name[] = {
+    [BSP_DISPLAY_BUF_SINGLE] = "single",
+    [BSP_DISPLAY_BUF_DOUBLE] = "double",
+    [BSP_DISPLAY_BUF_FULL] = "full frame",
+};
+
+static bool fits_internal(size_t bytes, size_t count)
+{
+    const uint32_t caps = MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL;
+
+    return heap_caps_get_largest_free_block(caps) >= bytes &&
+           heap_caps_get_free_size(caps) >= bytes * count + INTERNAL_DMA_RESERVE;
+}
+
+static bool fits_spiram(size_t bytes, size_t count)
+{
+#if CONFIG_SPIRAM
+    return heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) >= bytes &&
+           heap_caps_get_free_size(MALLOC_CAP_SPIRAM) >= bytes * count;
+#else
+    return false;
+#endif
+}
+
+bsp_display_buf_mode_t bsp_display_buf_config(bsp_display_cfg_t *cfg, bsp_display_buf_mode_t mode)
+{
+    const size_t line = BSP_LCD_H_RES * sizeof(lv_color_t);
+
+    if (BSP_DISPLAY_BUF_DEFAULT == mode) {
+#if CONFIG_BSP_DISPLAY_BUF_FULL
+        mode = BSP_DISPLAY_BUF_FULL;
+#elif CONFIG_BSP_DISPLAY_BUF_SINGLE
+        mode = BSP_DISPLAY_BUF_SINGLE;
+#else
+        mode = BSP_DISPLAY_BUF_DOUBLE;
+#endif
+    }
+
+    if (BSP_DISPLAY_BUF_FULL == mode && !fits_spiram(line * BSP_LCD_V_RES, 2)) {
+        ESP_LOGW(TAG, "No PSRAM for full-frame buffers, using double partial ones");
+        mode = BSP_DISPLAY_BUF_DOUBLE;
+    }
+
+    size_t lines = (BSP_DISPLAY_BUF_FULL == mode) ? BSP_LCD_V_RES : CONFIG_BSP_LCD_DRAW_BUF_HEIGHT;
+    size_t count = (BSP_DISPLAY_BUF_SINGLE == mode) ? 1 : 2;
+
+    cfg->buffer_size = BSP_LCD_H_RES * lines;
+    cfg->double_buffer = (count == 2);
+    cfg->flags.buff_dma = true;
+    cfg->flags.buff_spiram = false;
+
+    if (BSP_DISPLAY_BUF_FULL == mode) {
+        /* PSRAM goes out over the cache, the SPI driver bounces it through internal DMA memory */
+        cfg->flags.buff_dma = false;
+        cfg->flags.buff_spiram = true;
+    } else if (!fits_internal(line * lines, count)) {
+        if (fits_spiram(line * lines, count)) {
+            ESP_LOGW(TAG, "Internal RAM is short, draw buffers go to PSRAM");
+            cfg->flags.buff_dma = false;
+            cfg->flags.buff_spiram = true;
+        } else if (count == 2) {
+            ESP_LOGW(TAG, "No room for two draw buffers, using one");
+            cfg->double_buffer = false;
+            mode = BSP_DISPLAY_BUF_SINGLE;
+        }
+    }
+
+    ESP_LOGI(TAG, "%s buffering, %u x %u bytes in %s", s_mode_name[mode], cfg->double_buffer ? 2 : 1,
+             (unsigned)(line * lines), cfg->flags.buff_spiram ? "PSRAM" : "internal RAM");
+    return mode;
+}
@@ -0,0 +1,32 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include "esp_err.h"
+
+#define ERR_NAME(code)  case code: return #code
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    static __thread char name[16];
+
+    switch (code) {
+        ERR_NAME(ESP_OK);
+        ERR_NAME(ESP_FAIL);
+        ERR_NAME(ESP_ERR_NO_MEM);
+        ERR_NAME(ESP_ERR_INVALID_ARG);
+        ERR_NAME(ESP_ERR_INVALID_STATE);
+        ERR_NAME(ESP_ERR_INVALID_SIZE);
+        ERR_NAME(ESP_ERR_NOT_FOUND);
+        ERR_NAME(ESP_ERR_NOT_SUPPORTED);
+        ERR_NAME(ESP_ERR_TIMEOUT);
+        ERR_NAME(ESP_ERR_INVALID_RESPONSE);
+        ERR_NAME(ESP_ERR_INVALID_CRC);
+    default:
+        snprintf(name, sizeof(name), "0x%x", code);
+        return name;
+    }
+}
@@ -0,0 +1,260 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * FreeRTOS tasks, queues and semaphores on pthreads. A queue is a ring of fixed size items under one mutex, senders
+ * and receivers wait on a condition variable. Semaphores are queues of empty items, as in FreeRTOS.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "host_os.h"
+
+#define HOST_TASK_NAME_MAX  16
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    char name[HOST_TASK_NAME_MAX];
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    size_t item_size;
+    size_t length;
+    size_t head;
+    size_t count;
+    uint8_t *items;
+};
+
+static __thread struct host_task *s_self;
+static const char *s_fail_task;
+static atomic_int s_running;
+
+void host_os_fail_task(const char *name)
+{
+    s_fail_task = name;
+}
+
+int host_os_running_tasks(void)
+{
+    return atomic_load(&s_running);
+}
+
+static void task_exit(void *arg)
+{
+    free(arg);
+    atomic_fetch_sub(&s_running, 1);
+}
+
+static void *task_main(void *arg)
+{
+    struct host_task *task = arg;
+
+    s_self = task;
+    pthread_cleanup_push(task_exit, task);
+    task->fn(task->arg);
+    pthread_cleanup_pop(1);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    if (s_fail_task && !strcmp(s_fail_task, name)) {
+        return pdFAIL;
+    }
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (!task) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    snprintf(task->name, sizeof(task->name), "%s", name);
+    atomic_fetch_add(&s_running, 1);
+    if (pthread_create(&task->thread, NULL, task_main, task)) {
+        atomic_fetch_sub(&s_running, 1);
+        free(task);
+        return pdFAIL;
+    }
+    if (created_task) {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (NULL == task || task == s_self) {
+        pthread_exit(NULL);
+    }
+    /* Gone once this returns, as in FreeRTOS, so its queues may be deleted next */
+    pthread_t thread = task->thread;
+    pthread_cancel(thread);
+    pthread_join(thread, NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t) ticks * 1000);
+}
+
+char *pcTaskGetName(TaskHandle_t task)
+{
+    static char main_name[] = "main";
+    task = task ? task : s_self;
+    return task ? task->name : main_name;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = calloc(1, sizeof(struct host_queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->items = calloc(length, item_size ? item_size : 1);
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    queue->item_size = item_size;
+    queue->length = length;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
+
+static void queue_unlock(void *arg)
+{
+    pthread_mutex_unlock(&((struct host_queue *) arg)->lock);
+}
+
+/* Called locked, false once the ticks ran out. Unlocks when the task is deleted meanwhile. */
+static bool queue_wait(struct host_queue *queue, TickType_t ticks, const struct timespec *deadline)
+{
+    volatile int err = 0;      // set between the cleanup push and pop, which may be a setjmp
+
+    if (0 == ticks) {
+        return false;
+    }
+    pthread_cleanup_push(queue_unlock, queue);
+    if (portMAX_DELAY == ticks) {
+        pthread_cond_wait(&queue->changed, &queue->lock);
+    } else {
+        err = pthread_cond_timedwait(&queue->changed, &queue->lock, deadline);
+    }
+    pthread_cleanup_pop(0);
+    return ETIMEDOUT != err;
+}
+
+static struct timespec queue_deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (portMAX_DELAY != ticks) {
+        ts.tv_sec += ticks / 1000;
+        ts.tv_nsec += (long)(ticks % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+    }
+    return ts;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = queue_deadline(ticks_to_wait);
+    BaseType_t ret = pdFAIL;
+
+    pthread_mutex_lock(&queue->lock);
+    while (true) {
+        if (queue->count < queue->length) {
+            size_t tail = (queue->head + queue->count) % queue->length;
+            if (queue->item_size) {
+                memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+            }
+            queue->count++;
+            pthread_cond_broadcast(&queue->changed);
+            ret = pdPASS;
+            break;
+        }
+        if (!queue_wait(queue, ticks_to_wait, &deadline)) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+    struct timespec deadline = queue_deadline(ticks_to_wait);
+    BaseType_t ret = pdFAIL;
+
+    pthread_mutex_lock(&queue->lock);
+    while (true) {
+        if (queue->count) {
+            if (queue->item_size) {
+                memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+            }
+            queue->head = (queue->head + 1) % queue->length;
+            queue->count--;
+            pthread_cond_broadcast(&queue->changed);
+            ret = pdPASS;
+            break;
+        }
+        if (!queue_wait(queue, ticks_to_wait, &deadline)) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+    if (mutex) {
+        xSemaphoreGive(mutex);
+    }
+    return mutex;
+}
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id);
+/* NULL deletes the calling task. Another task is cancelled where it blocks on a queue and
+ * joined. */
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+/* NULL for the calling task, "main" outside of the tasks */
+char *pcTaskGetName(TaskHandle_t task);
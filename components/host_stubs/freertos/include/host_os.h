@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+/* Make the creation of the task with this name fail, NULL for none */
+void host_os_fail_task(const char *name);
+
+/* Tasks started and not returned or deleted yet */
+int host_os_running_tasks(void);
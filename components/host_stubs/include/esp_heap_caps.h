@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host stand-in, every capability maps to malloc() */
+
+#pragma once
+
+#include <stdlib.h>
+#include "esp_bit_defs.h"
+
+#define MALLOC_CAP_EXEC         BIT(0)
+#define MALLOC_CAP_32BIT        BIT(1)
+#define MALLOC_CAP_8BIT         BIT(2)
+#define MALLOC_CAP_DMA          BIT(3)
+#define MALLOC_CAP_SPIRAM       BIT(10)
+#define MALLOC_CAP_INTERNAL     BIT(11)
+#define MALLOC_CAP_DEFAULT      BIT(12)
+
+#define heap_caps_malloc(size, caps)            malloc(size)
+#define heap_caps_calloc(n, size, caps)         calloc(n, size)
+#define heap_caps_realloc(ptr, size, caps)      realloc(ptr, size)
+#define heap_caps_free(ptr)                     free(ptr)
@@ -0,0 +1,416 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * lvgl_prof.c linked with its wraps against the fake LVGL of stubs/. The display is 320 x 240, every invalidated
+ * area takes RENDER_US to draw and the flush is either done in the flush callback or by a thread standing for the
+ * SPI DMA. Exits with 1 when a check fails.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "lvgl.h"
+#include "lvgl_prof.h"
+
+#define RENDER_US           (300)
+#define FLUSH_US            (200)
+#define DMA_US              (1000)
+#define FRAMES              (20)
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_drv_t s_drv = {
+    .hor_res = 320,
+    .ver_res = 240,
+    .draw_buf = &s_draw_buf,
+};
+static lv_disp_t *s_disp;
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t thread;
+    bool pending;
+    bool stop;
+} s_dma = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/* What the driver's flush callback does, the profiler keeps the callback itself */
+static void (*s_flush)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+static uint32_t s_monitor_frames;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void spin_us(int64_t us)
+{
+    int64_t end = now_us() + us;
+    while (now_us() < end) {
+    }
+}
+
+static void *dma_task(void *arg)
+{
+    pthread_mutex_lock(&s_dma.lock);
+    while (!s_dma.stop) {
+        if (!s_dma.pending) {
+            pthread_cond_wait(&s_dma.cond, &s_dma.lock);
+            continue;
+        }
+        pthread_mutex_unlock(&s_dma.lock);
+        spin_us(DMA_US);
+        pthread_mutex_lock(&s_dma.lock);
+        s_dma.pending = false;
+        lv_disp_flush_ready(&s_drv);
+    }
+    pthread_mutex_unlock(&s_dma.lock);
+    return NULL;
+}
+
+static void sync_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    spin_us(FLUSH_US);
+    lv_disp_flush_ready(drv);
+}
+
+static void dma_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    pthread_mutex_lock(&s_dma.lock);
+    s_dma.pending = true;
+    pthread_cond_signal(&s_dma.cond);
+    pthread_mutex_unlock(&s_dma.lock);
+}
+
+/* Left for the next flush */
+static void idle_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+}
+
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    s_flush(drv, area, color_p);
+}
+
+static void monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    s_monitor_frames++;
+}
+
+static void obj_init(lv_obj_t *obj, const lv_obj_class_t *class_p, lv_obj_t *parent, lv_coord_t x, lv_coord_t y,
+                     lv_coord_t w, lv_coord_t h)
+{
+    *obj = (lv_obj_t) {
+        .class_p = class_p,
+        .parent = parent,
+        .coords = { .x1 = x, .y1 = y, .x2 = x + w - 1, .y2 = y + h - 1 },
+    };
+}
+
+static void refresh(void)
+{
+    _lv_disp_refr_timer(s_disp->refr_timer);
+}
+
+static const lvgl_prof_invalidator_t *find(const lvgl_prof_summary_t *summary, const char *name, const void *obj)
+{
+    for (size_t i = 0; i < summary->top_count; i++) {
+        const lvgl_prof_invalidator_t *inv = &summary->top[i];
+        if (((inv->name && name && !strcmp(inv->name, name)) || (!inv->name && !name)) && inv->obj == obj) {
+            return inv;
+        }
+    }
+    return NULL;
+}
+
+/* Render time has to leave out the flush done in the callback */
+static bool test_sync_flush(void)
+{
+    lv_obj_t scr;
+    lv_obj_t label;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    obj_init(&label, &lv_label_class, &scr, 10, 10, 100, 10);
+    s_flush = sync_flush_cb;
+    lvgl_prof_reset();
+    for (int i = 0; i < FRAMES; i++) {
+        lv_obj_invalidate(&label);
+        refresh();
+    }
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(FRAMES == summary.frames, "%u frames", (unsigned)summary.frames);
+    CHECK(1000 == summary.px_avg, "%u px per frame", (unsigned)summary.px_avg);
+    CHECK(summary.render_p50_us >= RENDER_US, "render p50 %u us", (unsigned)summary.render_p50_us);
+    CHECK(summary.flush_p50_us >= FLUSH_US, "flush p50 %u us", (unsigned)summary.flush_p50_us);
+    CHECK(summary.frame_p50_us >= RENDER_US + FLUSH_US, "frame p50 %u us", (unsigned)summary.frame_p50_us);
+    CHECK(summary.render_p50_us + FLUSH_US <= summary.frame_p50_us, "render p50 %u us of a %u us frame",
+          (unsigned)summary.render_p50_us, (unsigned)summary.frame_p50_us);
+    CHECK(FRAMES == s_monitor_frames, "%u frames seen by the driver", (unsigned)s_monitor_frames);
+    return true;
+}
+
+/* Three areas a frame on a bus slower than drawing: the wait for the bus is not render time */
+static bool test_dma_flush(void)
+{
+    lv_obj_t scr;
+    lv_obj_t a;
+    lv_obj_t b;
+    lv_obj_t c;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    obj_init(&a, &lv_obj_class, &scr, 0, 0, 10, 10);
+    obj_init(&b, &lv_obj_class, &scr, 0, 100, 10, 10);
+    obj_init(&c, &lv_obj_class, &scr, 0, 200, 10, 10);
+    s_flush = dma_flush_cb;
+    lvgl_prof_reset();
+    for (int i = 0; i < FRAMES; i++) {
+        lv_obj_invalidate(&a);
+        lv_obj_invalidate(&b);
+        lv_obj_invalidate(&c);
+        refresh();
+    }
+    /* The last flush of the last frame ends after it */
+    while (s_draw_buf.flushing) {
+    }
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(FRAMES == summary.frames, "%u frames", (unsigned)summary.frames);
+    CHECK(300 == summary.px_avg, "%u px per frame", (unsigned)summary.px_avg);
+    CHECK(summary.render_p50_us >= 3 * RENDER_US, "render p50 %u us", (unsigned)summary.render_p50_us);
+    CHECK(summary.render_p99_us <= summary.frame_p99_us, "render p99 %u us, frame p99 %u us",
+          (unsigned)summary.render_p99_us, (unsigned)summary.frame_p99_us);
+    CHECK(summary.frame_p50_us >= 2 * DMA_US, "frame p50 %u us", (unsigned)summary.frame_p50_us);
+    CHECK(summary.render_p50_us + DMA_US <= summary.frame_p50_us, "render p50 %u us of a %u us frame",
+          (unsigned)summary.render_p50_us, (unsigned)summary.frame_p50_us);
+    CHECK(summary.flush_p50_us >= 2 * DMA_US, "flush p50 %u us", (unsigned)summary.flush_p50_us);
+    return true;
+}
+
+/*
+ * lv_disp_flush_ready() between LVGL's look at the flushing flag and its wait_cb call, by hand: the wait_cb call
+ * then waits for nothing, and the drawing after it is render time.
+ */
+static bool test_ready_before_wait(void)
+{
+    lv_area_t area = { .x1 = 0, .y1 = 0, .x2 = 9, .y2 = 9 };
+    lvgl_prof_summary_t summary;
+
+    s_flush = idle_flush_cb;
+    lvgl_prof_reset();
+    s_drv.flush_cb(&s_drv, &area, NULL);
+    lv_disp_flush_ready(&s_drv);
+    s_drv.wait_cb(&s_drv);
+    spin_us(2000);
+    s_drv.flush_cb(&s_drv, &area, NULL);
+    lv_disp_flush_ready(&s_drv);
+    /* Outside of the refresh timer, the frame time is the one passed */
+    s_drv.monitor_cb(&s_drv, 3, 200);
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(1 == summary.frames && 3000 == summary.frame_p50_us, "%u frames, frame p50 %u us",
+          (unsigned)summary.frames, (unsigned)summary.frame_p50_us);
+    CHECK(summary.render_p50_us >= 2000, "render %u us", (unsigned)summary.render_p50_us);
+    return true;
+}
+
+static bool test_attribution(void)
+{
+    lv_obj_t scr;
+    lv_obj_t bar;
+    lv_obj_t indic;
+    lv_obj_t label;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    obj_init(&bar, &lv_bar_class, &scr, 100, 100, 100, 20);
+    obj_init(&indic, &lv_obj_class, &bar, 100, 100, 50, 20);
+    obj_init(&label, &lv_label_class, &scr, 0, 0, 40, 10);
+    s_flush = sync_flush_cb;
+    lvgl_prof_reset();
+    lvgl_prof_set_name(&bar, "volume");
+    for (int i = 0; i < 4; i++) {
+        lv_obj_invalidate(&indic);
+        lv_obj_invalidate(&label);
+        refresh();
+    }
+    lv_area_t part = { .x1 = 100, .y1 = 100, .x2 = 109, .y2 = 109 };
+    lv_obj_invalidate_area(&bar, &part);
+    lv_obj_set_x(&label, 20);
+    refresh();
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(5 == summary.frames, "%u frames", (unsigned)summary.frames);
+    CHECK(11 == summary.invalidations, "%u invalidations", (unsigned)summary.invalidations);
+    CHECK(3 == summary.top_count, "%u invalidators", (unsigned)summary.top_count);
+    const lvgl_prof_invalidator_t *named = find(&summary, "volume", NULL);
+    CHECK(named && 5 == named->count && 4 * 1000 + 100 == named->px, "volume %u x %u px",
+          named ? (unsigned)named->count : 0, named ? (unsigned)named->px : 0);
+    CHECK(&summary.top[0] == named, "volume is not first");
+    const lvgl_prof_invalidator_t *unnamed = find(&summary, NULL, &label);
+    CHECK(unnamed && 4 == unnamed->count && 4 * 400 == unnamed->px && &lv_label_class == unnamed->class_p,
+          "label %u x %u px", unnamed ? (unsigned)unnamed->count : 0, unnamed ? (unsigned)unnamed->px : 0);
+    const lvgl_prof_invalidator_t *inside = find(&summary, NULL, NULL);
+    CHECK(inside && 2 == inside->count && 800 == inside->px, "inside LVGL %u x %u px",
+          inside ? (unsigned)inside->count : 0, inside ? (unsigned)inside->px : 0);
+    lvgl_prof_print_summary(&summary);
+
+    /* Names are dropped with their object, the children then count by themselves */
+    lv_obj_del(&bar);
+    lvgl_prof_reset();
+    lv_obj_invalidate(&indic);
+    refresh();
+    lvgl_prof_get_summary(&summary);
+    CHECK(1 == summary.top_count && !summary.top[0].name && &indic == summary.top[0].obj, "name kept after delete");
+    return true;
+}
+
+/* Only what lies on the display counts, and nothing while invalidation is off */
+static bool test_clipping(void)
+{
+    lv_obj_t scr;
+    lv_obj_t half;
+    lv_obj_t off;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    obj_init(&half, &lv_obj_class, &scr, 300, 230, 40, 20);
+    obj_init(&off, &lv_obj_class, &scr, 400, 0, 40, 20);
+    s_flush = sync_flush_cb;
+    lvgl_prof_reset();
+    lv_obj_invalidate(&half);
+    lv_obj_invalidate(&off);
+    lv_disp_enable_invalidation(s_disp, false);
+    lv_obj_invalidate(&scr);
+    lv_disp_enable_invalidation(s_disp, true);
+    refresh();
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(1 == summary.invalidations, "%u invalidations", (unsigned)summary.invalidations);
+    CHECK(200 == summary.px_avg && 200 == summary.top[0].px, "%u px", (unsigned)summary.px_avg);
+    return true;
+}
+
+/*
+ * More objects than candidates: the 32nd seen invalidates the most and keeps its identity at the top, the 8 past
+ * the table are added up in "(other)".
+ */
+static bool test_other(void)
+{
+    static lv_obj_t objs[40];
+    lv_obj_t scr;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    for (int i = 0; i < 40; i++) {
+        obj_init(&objs[i], &lv_obj_class, &scr, i * 8, 0, 8, 31 == i ? 100 : 1);
+    }
+    s_flush = sync_flush_cb;
+    lvgl_prof_reset();
+    for (int i = 0; i < 40; i++) {
+        lv_obj_invalidate(&objs[i]);
+    }
+    refresh();
+    lvgl_prof_get_summary(&summary);
+
+    CHECK(40 == summary.invalidations, "%u invalidations", (unsigned)summary.invalidations);
+    CHECK(&objs[31] == summary.top[0].obj && 800 == summary.top[0].px, "top is %p with %u px", summary.top[0].obj,
+          (unsigned)summary.top[0].px);
+    const lvgl_prof_invalidator_t *other = find(&summary, "(other)", NULL);
+    CHECK(other && 8 == other->count && 64 == other->px, "(other) %u x %u px", other ? (unsigned)other->count : 0,
+          other ? (unsigned)other->px : 0);
+    CHECK(&summary.top[1] == other, "(other) is not second");
+    return true;
+}
+
+static bool test_detach(void)
+{
+    lv_obj_t scr;
+    lvgl_prof_summary_t summary;
+
+    obj_init(&scr, &lv_obj_class, NULL, 0, 0, 320, 240);
+    lvgl_prof_reset();
+    lvgl_prof_get_summary(&summary);
+    CHECK(0 == summary.frames && 0 == summary.invalidations, "reset kept %u frames", (unsigned)summary.frames);
+
+    lvgl_prof_detach();
+    CHECK(flush_cb == s_drv.flush_cb && monitor_cb == s_drv.monitor_cb && NULL == s_drv.wait_cb,
+          "callbacks not restored");
+    s_monitor_frames = 0;
+    lv_obj_invalidate(&scr);
+    refresh();
+    lvgl_prof_get_summary(&summary);
+    CHECK(0 == summary.frames && 1 == s_monitor_frames, "%u frames after detach", (unsigned)summary.frames);
+
+    CHECK(lvgl_prof_attach(s_disp), "attach again");
+    CHECK(!lvgl_prof_attach(s_disp), "attached twice");
+    lv_obj_invalidate(&scr);
+    refresh();
+    lvgl_prof_get_summary(&summary);
+    CHECK(1 == summary.frames && 320 * 240 == summary.px_avg, "%u frames after attach", (unsigned)summary.frames);
+    lvgl_prof_detach();
+    return true;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"sync flush", test_sync_flush},
+        {"dma flush", test_dma_flush},
+        {"ready before wait", test_ready_before_wait},
+        {"attribution", test_attribution},
+        {"clipping", test_clipping},
+        {"other", test_other},
+        {"detach", test_detach},
+    };
+    int failed = 0;
+
+    lv_fake_render_us = RENDER_US;
+    s_flush = sync_flush_cb;
+    s_drv.flush_cb = flush_cb;
+    s_drv.monitor_cb = monitor_cb;
+    s_disp = lv_disp_drv_register(&s_drv);
+    pthread_create(&s_dma.thread, NULL, dma_task, NULL);
+    if (!lvgl_prof_attach(s_disp)) {
+        printf("FAIL attach\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+
+    pthread_mutex_lock(&s_dma.lock);
+    s_dma.stop = true;
+    pthread_cond_signal(&s_dma.cond);
+    pthread_mutex_unlock(&s_dma.lock);
+    pthread_join(s_dma.thread, NULL);
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
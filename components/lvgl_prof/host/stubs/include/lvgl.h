@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host stand-in: the few types and calls of LVGL v8.3 that lvgl_prof.c uses, with the names it expects. The
+ * functions live in files named after the LVGL ones that define them, so that calls made inside LVGL stay in a
+ * translation unit, as they do in the library, and are not caught by the link time wraps.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LV_USE_LABEL                1
+#define LV_USE_IMG                  0
+#define LV_USE_BTN                  0
+#define LV_USE_BAR                  1
+#define LV_USE_ARC                  0
+#define LV_USE_SLIDER               0
+#define LV_USE_SWITCH               0
+
+#define LV_LOG_WARN(...)            do { fprintf(stderr, __VA_ARGS__); fprintf(stderr, "\n"); } while (0)
+
+typedef int16_t lv_coord_t;
+typedef uint16_t lv_color_t;
+
+/* lv_area.h */
+typedef struct {
+    lv_coord_t x1;
+    lv_coord_t y1;
+    lv_coord_t x2;
+    lv_coord_t y2;
+} lv_area_t;
+
+bool _lv_area_intersect(lv_area_t *res_p, const lv_area_t *a1_p, const lv_area_t *a2_p);
+uint32_t lv_area_get_size(const lv_area_t *area_p);
+
+/* lv_obj.h, one event callback per object is enough here */
+typedef struct {
+    int dummy;
+} lv_obj_class_t;
+
+typedef enum {
+    LV_EVENT_ALL = 0,
+    LV_EVENT_DELETE = 36,
+} lv_event_code_t;
+
+struct _lv_event_t;
+typedef void (*lv_event_cb_t)(struct _lv_event_t *e);
+
+typedef struct _lv_obj_t {
+    const lv_obj_class_t *class_p;
+    struct _lv_obj_t *parent;
+    lv_area_t coords;
+    lv_event_cb_t delete_cb;
+} lv_obj_t;
+
+typedef struct _lv_event_t {
+    lv_obj_t *target;
+    lv_event_code_t code;
+} lv_event_t;
+
+extern const lv_obj_class_t lv_obj_class;
+extern const lv_obj_class_t lv_label_class;
+extern const lv_obj_class_t lv_bar_class;
+
+lv_obj_t *lv_obj_get_parent(const lv_obj_t *obj);
+void *lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data);
+lv_obj_t *lv_event_get_target(lv_event_t *e);
+void lv_obj_del(lv_obj_t *obj);
+void lv_obj_invalidate(const lv_obj_t *obj);
+void lv_obj_invalidate_area(const lv_obj_t *obj, const lv_area_t *area);
+void lv_obj_set_x(lv_obj_t *obj, lv_coord_t x);
+
+/* lv_hal_disp.h */
+#define LV_INV_BUF_SIZE             32
+
+typedef struct {
+    volatile int flushing;
+} lv_disp_draw_buf_t;
+
+typedef struct _lv_disp_drv_t {
+    lv_coord_t hor_res;
+    lv_coord_t ver_res;
+    lv_disp_draw_buf_t *draw_buf;
+    void (*flush_cb)(struct _lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*monitor_cb)(struct _lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
+    void (*wait_cb)(struct _lv_disp_drv_t *disp_drv);
+    void *user_data;
+} lv_disp_drv_t;
+
+typedef struct {
+    void *user_data;
+} lv_timer_t;
+
+typedef struct _lv_disp_t {
+    lv_disp_drv_t *driver;
+    lv_timer_t *refr_timer;
+    lv_area_t inv_areas[LV_INV_BUF_SIZE];
+    uint16_t inv_p;
+    uint32_t inv_en_cnt;
+} lv_disp_t;
+
+lv_disp_t *lv_disp_drv_register(lv_disp_drv_t *driver);
+lv_disp_t *lv_disp_get_default(void);
+lv_coord_t lv_disp_get_hor_res(lv_disp_t *disp);
+lv_coord_t lv_disp_get_ver_res(lv_disp_t *disp);
+void lv_disp_enable_invalidation(lv_disp_t *disp, bool en);
+bool lv_disp_is_invalidation_enabled(lv_disp_t *disp);
+void lv_disp_flush_ready(lv_disp_drv_t *disp_drv);
+
+/* lv_refr.h, each invalidated area takes lv_fake_render_us to draw, areas are not joined */
+extern uint32_t lv_fake_render_us;
+
+void _lv_inv_area(lv_disp_t *disp, const lv_area_t *area_p);
+void _lv_disp_refr_timer(lv_timer_t *timer);
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "lvgl.h"
+
+bool _lv_area_intersect(lv_area_t *res_p, const lv_area_t *a1_p, const lv_area_t *a2_p)
+{
+    res_p->x1 = a1_p->x1 > a2_p->x1 ? a1_p->x1 : a2_p->x1;
+    res_p->y1 = a1_p->y1 > a2_p->y1 ? a1_p->y1 : a2_p->y1;
+    res_p->x2 = a1_p->x2 < a2_p->x2 ? a1_p->x2 : a2_p->x2;
+    res_p->y2 = a1_p->y2 < a2_p->y2 ? a1_p->y2 : a2_p->y2;
+    return res_p->x1 <= res_p->x2 && res_p->y1 <= res_p->y2;
+}
+
+uint32_t lv_area_get_size(const lv_area_t *area_p)
+{
+    return (uint32_t)(area_p->x2 - area_p->x1 + 1) * (uint32_t)(area_p->y2 - area_p->y1 + 1);
+}
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "lvgl.h"
+
+static lv_timer_t s_refr_timer;
+static lv_disp_t s_disp;
+
+/* A single display */
+lv_disp_t *lv_disp_drv_register(lv_disp_drv_t *driver)
+{
+    s_disp = (lv_disp_t) {
+        .driver = driver,
+        .refr_timer = &s_refr_timer,
+        .inv_en_cnt = 1,
+    };
+    s_refr_timer.user_data = &s_disp;
+    return &s_disp;
+}
+
+lv_disp_t *lv_disp_get_default(void)
+{
+    return s_disp.driver ? &s_disp : NULL;
+}
+
+lv_coord_t lv_disp_get_hor_res(lv_disp_t *disp)
+{
+    return disp->driver->hor_res;
+}
+
+lv_coord_t lv_disp_get_ver_res(lv_disp_t *disp)
+{
+    return disp->driver->ver_res;
+}
+
+void lv_disp_enable_invalidation(lv_disp_t *disp, bool en)
+{
+    disp->inv_en_cnt += en ? 1 : -1;
+}
+
+bool lv_disp_is_invalidation_enabled(lv_disp_t *disp)
+{
+    return disp->inv_en_cnt > 0;
+}
+
+void lv_disp_flush_ready(lv_disp_drv_t *disp_drv)
+{
+    disp_drv->draw_buf->flushing = 0;
+}
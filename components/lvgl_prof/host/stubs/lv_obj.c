@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "lvgl.h"
+
+const lv_obj_class_t lv_obj_class;
+const lv_obj_class_t lv_label_class;
+const lv_obj_class_t lv_bar_class;
+
+lv_obj_t *lv_obj_get_parent(const lv_obj_t *obj)
+{
+    return obj->parent;
+}
+
+void *lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data)
+{
+    if (LV_EVENT_DELETE == filter) {
+        obj->delete_cb = event_cb;
+    }
+    return NULL;
+}
+
+lv_obj_t *lv_event_get_target(lv_event_t *e)
+{
+    return e->target;
+}
+
+void lv_obj_del(lv_obj_t *obj)
+{
+    if (obj->delete_cb) {
+        lv_event_t e = {
+            .target = obj,
+            .code = LV_EVENT_DELETE,
+        };
+        obj->delete_cb(&e);
+    }
+    obj->delete_cb = NULL;
+}
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "lvgl.h"
+
+void lv_obj_invalidate_area(const lv_obj_t *obj, const lv_area_t *area)
+{
+    _lv_inv_area(NULL, area);
+}
+
+void lv_obj_invalidate(const lv_obj_t *obj)
+{
+    lv_obj_invalidate_area(obj, &obj->coords);
+}
+
+/* Invalidates from here, as lv_obj_move_to() does, so the wrap of lv_obj_invalidate() does not see it */
+void lv_obj_set_x(lv_obj_t *obj, lv_coord_t x)
+{
+    lv_obj_invalidate(obj);
+    obj->coords.x2 += x - obj->coords.x1;
+    obj->coords.x1 = x;
+    lv_obj_invalidate(obj);
+}
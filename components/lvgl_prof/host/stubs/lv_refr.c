@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <time.h>
+#include "lvgl.h"
+
+uint32_t lv_fake_render_us;
+
+static int64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void _lv_inv_area(lv_disp_t *disp, const lv_area_t *area_p)
+{
+    disp = disp ? disp : lv_disp_get_default();
+    if (!area_p) {
+        disp->inv_p = 0;
+        return;
+    }
+    if (!lv_disp_is_invalidation_enabled(disp)) {
+        return;
+    }
+    lv_area_t scr = {
+        .x1 = 0,
+        .y1 = 0,
+        .x2 = lv_disp_get_hor_res(disp) - 1,
+        .y2 = lv_disp_get_ver_res(disp) - 1,
+    };
+    lv_area_t clipped;
+    if (_lv_area_intersect(&clipped, area_p, &scr) && disp->inv_p < LV_INV_BUF_SIZE) {
+        disp->inv_areas[disp->inv_p++] = clipped;
+    }
+}
+
+/*
+ * Two buffers: an area is drawn while the previous one is on the bus, then flushed once that one is done. The
+ * monitor callback comes right after the last flush call, LVGL does not wait for it.
+ */
+void _lv_disp_refr_timer(lv_timer_t *timer)
+{
+    lv_disp_t *disp = timer->user_data;
+    lv_disp_drv_t *drv = disp->driver;
+    int64_t start = now_us();
+    uint32_t px = 0;
+
+    if (!disp->inv_p) {
+        return;
+    }
+    for (uint16_t i = 0; i < disp->inv_p; i++) {
+        int64_t drawn = now_us() + lv_fake_render_us;
+        while (now_us() < drawn) {
+        }
+        while (drv->draw_buf->flushing) {
+            if (drv->wait_cb) {
+                drv->wait_cb(drv);
+            }
+        }
+        drv->draw_buf->flushing = 1;
+        drv->flush_cb(drv, &disp->inv_areas[i], NULL);
+        px += lv_area_get_size(&disp->inv_areas[i]);
+    }
+    disp->inv_p = 0;
+    if (drv->monitor_cb) {
+        drv->monitor_cb(drv, (uint32_t)((now_us() - start) / 1000), px);
+    }
+}
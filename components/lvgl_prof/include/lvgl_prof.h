@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LVGL_PROF_TOP_N     5
+
+typedef struct {
+    const char *name;                   /*!< Name given with lvgl_prof_set_name(), NULL if none */
+    const void *obj;                    /*!< Object itself when it has no named ancestor, may be gone */
+    const lv_obj_class_t *class_p;      /*!< Class of that object */
+    uint32_t count;                     /*!< Invalidations in the window */
+    uint32_t px;                        /*!< Pixels they asked to redraw, overlaps included */
+} lvgl_prof_invalidator_t;
+
+typedef struct {
+    uint32_t frames;                    /*!< Frames in the ring */
+    uint32_t window_ms;                 /*!< Time they span */
+    uint32_t frame_p50_us;              /*!< First area rendered to refresh done */
+    uint32_t frame_p99_us;
+    uint32_t frame_max_us;
+    uint32_t render_p50_us;             /*!< Time LVGL spent drawing */
+    uint32_t render_p99_us;
+    uint32_t flush_p50_us;              /*!< Flush call to lv_disp_flush_ready(), overlaps rendering with two buffers */
+    uint32_t flush_p99_us;
+    uint32_t px_avg;                    /*!< Pixels invalidated per frame */
+    uint32_t invalidations;             /*!< Invalidations in the ring */
+    size_t top_count;
+    lvgl_prof_invalidator_t top[LVGL_PROF_TOP_N];   /*!< Most pixels invalidated first */
+} lvgl_prof_summary_t;
+
+#if !defined(ESP_PLATFORM) || CONFIG_LVGL_PROF_ENABLE
+
+/**
+ * @brief Start profiling a display by chaining its render start, flush and monitor callbacks
+ *
+ * Invalidations are caught by wrapping lv_obj_invalidate(), lv_obj_invalidate_area() and _lv_inv_area() at
+ * link time, moves and resizes done inside LVGL are counted without an object.
+ *
+ * @note Call with the LVGL lock held, after the display is registered
+ *
+ * @return false if out of memory or already attached
+ */
+bool lvgl_prof_attach(lv_disp_t *disp);
+
+/**
+ * @brief Restore the display callbacks and free the rings
+ */
+void lvgl_prof_detach(void);
+
+/**
+ * @brief Attribute invalidations of an object and of its children to a name
+ *
+ * @param name  Must outlive the object, e.g. a string literal
+ */
+void lvgl_prof_set_name(const lv_obj_t *obj, const char *name);
+
+/**
+ * @brief Forget the recorded frames and invalidations
+ */
+void lvgl_prof_reset(void);
+
+/**
+ * @brief Summarize the frames and invalidations in the rings
+ *
+ * @note Call with the LVGL lock held, then print outside of it
+ */
+void lvgl_prof_get_summary(lvgl_prof_summary_t *summary);
+
+/**
+ * @brief Print a summary to stdout
+ */
+void lvgl_prof_print_summary(const lvgl_prof_summary_t *summary);
+
+#else
+
+static inline bool lvgl_prof_attach(lv_disp_t *disp)
+{
+    return false;
+}
+
+static inline void lvgl_prof_detach(void) {}
+
+static inline void lvgl_prof_set_name(const lv_obj_t *obj, const char *name) {}
+
+static inline void lvgl_prof_reset(void) {}
+
+static inline void lvgl_prof_get_summary(lvgl_prof_summary_t *summary)
+{
+    *summary = (lvgl_prof_summary_t) { 0 };
+}
+
+static inline void lvgl_prof_print_summary(const lvgl_prof_summary_t *summary) {}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
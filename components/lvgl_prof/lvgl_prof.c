@@ -0,0 +1,482 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lvgl_prof.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+#ifndef CONFIG_LVGL_PROF_FRAMES
+#define CONFIG_LVGL_PROF_FRAMES         128
+#endif
+
+#ifndef CONFIG_LVGL_PROF_INVALIDATIONS
+#define CONFIG_LVGL_PROF_INVALIDATIONS  256
+#endif
+
+#define NAMES_MAX       16
+#define CANDIDATES_MAX  32
+
+typedef struct {
+    uint32_t end_ms;
+    uint32_t frame_us;
+    uint32_t render_us;
+    uint32_t flush_us;
+    uint32_t px;
+} frame_rec_t;
+
+typedef struct {
+    const char *name;
+    const void *obj;
+    const lv_obj_class_t *class_p;
+    uint32_t px;
+} inv_rec_t;
+
+typedef struct {
+    lv_disp_t *disp;
+    lv_disp_drv_t *drv;
+    void (*flush_cb)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+    void (*monitor_cb)(lv_disp_drv_t *drv, uint32_t time, uint32_t px);
+    void (*wait_cb)(lv_disp_drv_t *drv);
+
+    frame_rec_t frames[CONFIG_LVGL_PROF_FRAMES];
+    size_t frame_head;
+    size_t frame_count;
+    inv_rec_t invs[CONFIG_LVGL_PROF_INVALIDATIONS];
+    size_t inv_head;
+    size_t inv_count;
+
+    /* Current frame, from the refresh timer to the monitor callback */
+    bool in_frame;
+    int64_t frame_start;
+    uint32_t call_us;                   /* Spent inside the driver flush callback */
+    uint32_t px;
+    bool waiting;                       /* In wait_cb since wait_start */
+    int64_t wait_start;
+    uint32_t wait_us;
+
+    /* Also written from lv_disp_flush_ready(), which usually runs in the panel IO ISR */
+    volatile int64_t flush_start;
+    volatile int64_t ready_at;
+    volatile uint32_t flush_us;
+} prof_t;
+
+typedef struct {
+    const lv_obj_t *obj;
+    const char *name;
+} name_t;
+
+static prof_t *s_prof;
+static name_t s_names[NAMES_MAX];
+static const lv_obj_t *s_cur_obj;
+
+void __real_lv_obj_invalidate(const lv_obj_t *obj);
+void __real_lv_obj_invalidate_area(const lv_obj_t *obj, const lv_area_t *area);
+void __real__lv_inv_area(lv_disp_t *disp, const lv_area_t *area_p);
+void __real__lv_disp_refr_timer(lv_timer_t *timer);
+void __real_lv_disp_flush_ready(lv_disp_drv_t *disp_drv);
+
+static inline int64_t now_us(void)
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static const char *name_of(const lv_obj_t *obj)
+{
+    for (; obj; obj = lv_obj_get_parent(obj)) {
+        for (size_t i = 0; i < NAMES_MAX; i++) {
+            if (s_names[i].obj == obj) {
+                return s_names[i].name;
+            }
+        }
+    }
+    return NULL;
+}
+
+static const char *class_name(const lv_obj_class_t *class_p)
+{
+    static const struct {
+        const lv_obj_class_t *class_p;
+        const char *name;
+    } classes[] = {
+        { &lv_obj_class, "obj" },
+#if LV_USE_LABEL
+        { &lv_label_class, "label" },
+#endif
+#if LV_USE_IMG
+        { &lv_img_class, "img" },
+#endif
+#if LV_USE_BTN
+        { &lv_btn_class, "btn" },
+#endif
+#if LV_USE_BAR
+        { &lv_bar_class, "bar" },
+#endif
+#if LV_USE_ARC
+        { &lv_arc_class, "arc" },
+#endif
+#if LV_USE_SLIDER
+        { &lv_slider_class, "slider" },
+#endif
+#if LV_USE_SWITCH
+        { &lv_switch_class, "switch" },
+#endif
+    };
+
+    for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+        if (classes[i].class_p == class_p) {
+            return classes[i].name;
+        }
+    }
+    return "widget";
+}
+
+static void name_delete_cb(lv_event_t *e)
+{
+    const lv_obj_t *obj = lv_event_get_target(e);
+    for (size_t i = 0; i < NAMES_MAX; i++) {
+        if (s_names[i].obj == obj) {
+            s_names[i].obj = NULL;
+        }
+    }
+}
+
+void lvgl_prof_set_name(const lv_obj_t *obj, const char *name)
+{
+    name_t *slot = NULL;
+    for (size_t i = 0; i < NAMES_MAX; i++) {
+        if (s_names[i].obj == obj) {
+            s_names[i].name = name;
+            return;
+        }
+        if (!slot && !s_names[i].obj) {
+            slot = &s_names[i];
+        }
+    }
+    if (!slot) {
+        LV_LOG_WARN("lvgl_prof: no room for \"%s\"", name);
+        return;
+    }
+    slot->obj = obj;
+    slot->name = name;
+    lv_obj_add_event_cb((lv_obj_t *)obj, name_delete_cb, LV_EVENT_DELETE, NULL);
+}
+
+void __wrap_lv_obj_invalidate(const lv_obj_t *obj)
+{
+    const lv_obj_t *prev = s_cur_obj;
+    s_cur_obj = obj;
+    __real_lv_obj_invalidate(obj);
+    s_cur_obj = prev;
+}
+
+void __wrap_lv_obj_invalidate_area(const lv_obj_t *obj, const lv_area_t *area)
+{
+    const lv_obj_t *prev = s_cur_obj;
+    s_cur_obj = obj;
+    __real_lv_obj_invalidate_area(obj, area);
+    s_cur_obj = prev;
+}
+
+void __wrap__lv_inv_area(lv_disp_t *disp, const lv_area_t *area_p)
+{
+    prof_t *prof = s_prof;
+    lv_disp_t *target = disp ? disp : lv_disp_get_default();
+
+    /* NULL clears the invalidated areas, ignored ones are not worth counting */
+    if (prof && area_p && target == prof->disp && lv_disp_is_invalidation_enabled(target)) {
+        lv_area_t scr = {
+            .x1 = 0,
+            .y1 = 0,
+            .x2 = lv_disp_get_hor_res(target) - 1,
+            .y2 = lv_disp_get_ver_res(target) - 1,
+        };
+        lv_area_t clipped;
+        if (_lv_area_intersect(&clipped, area_p, &scr)) {
+            inv_rec_t *rec = &prof->invs[prof->inv_head];
+            rec->name = name_of(s_cur_obj);
+            rec->obj = rec->name ? NULL : s_cur_obj;
+            rec->class_p = s_cur_obj ? s_cur_obj->class_p : NULL;
+            rec->px = lv_area_get_size(&clipped);
+            prof->inv_head = (prof->inv_head + 1) % CONFIG_LVGL_PROF_INVALIDATIONS;
+            if (prof->inv_count < CONFIG_LVGL_PROF_INVALIDATIONS) {
+                prof->inv_count++;
+            }
+            prof->px += rec->px;
+        }
+    }
+    __real__lv_inv_area(disp, area_p);
+}
+
+void __wrap__lv_disp_refr_timer(lv_timer_t *timer)
+{
+    prof_t *prof = s_prof;
+    if (prof && (!timer || timer->user_data == prof->disp)) {
+        prof->in_frame = true;
+        prof->frame_start = now_us();
+    }
+    __real__lv_disp_refr_timer(timer);
+    if (prof) {
+        prof->in_frame = false;
+    }
+}
+
+void __wrap_lv_disp_flush_ready(lv_disp_drv_t *disp_drv)
+{
+    prof_t *prof = s_prof;
+    if (prof && disp_drv == prof->drv) {
+        int64_t t = now_us();
+        prof->flush_us += t - prof->flush_start;
+        prof->ready_at = t;
+    }
+    __real_lv_disp_flush_ready(disp_drv);
+}
+
+/*
+ * LVGL checks that the flush is over before calling wait_cb, so lv_disp_flush_ready() can run in between and the
+ * wait_cb call then waits for nothing. The wait is closed by the next flush or by the end of the frame instead,
+ * with the time the flush was really over.
+ */
+static void wait_end(prof_t *prof)
+{
+    if (prof->waiting) {
+        int64_t ready_at = prof->ready_at;
+        if (ready_at > prof->wait_start) {
+            prof->wait_us += ready_at - prof->wait_start;
+        }
+        prof->waiting = false;
+    }
+}
+
+static void prof_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    prof_t *prof = s_prof;
+    wait_end(prof);
+    int64_t t = now_us();
+    prof->flush_start = t;
+    prof->flush_cb(drv, area, color_p);
+    prof->call_us += now_us() - t;
+}
+
+static void prof_wait_cb(lv_disp_drv_t *drv)
+{
+    prof_t *prof = s_prof;
+    if (!prof->waiting) {
+        prof->wait_start = now_us();
+        prof->waiting = true;
+    }
+    if (prof->wait_cb) {
+        prof->wait_cb(drv);
+    }
+}
+
+static void prof_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    prof_t *prof = s_prof;
+    wait_end(prof);
+    int64_t t = now_us();
+    frame_rec_t *rec = &prof->frames[prof->frame_head];
+
+    /* lv_refr_now() refreshes without the timer, only the monitor time is known then */
+    rec->frame_us = prof->in_frame ? (uint32_t)(t - prof->frame_start) : time * 1000;
+    rec->end_ms = (uint32_t)(t / 1000);
+    rec->flush_us = prof->flush_us;
+    uint32_t busy_us = prof->wait_us + prof->call_us;
+    rec->render_us = rec->frame_us > busy_us ? rec->frame_us - busy_us : 0;
+    rec->px = prof->px;
+    prof->frame_head = (prof->frame_head + 1) % CONFIG_LVGL_PROF_FRAMES;
+    if (prof->frame_count < CONFIG_LVGL_PROF_FRAMES) {
+        prof->frame_count++;
+    }
+
+    /* With two buffers the last area may still be on the bus, its time then goes to the next frame */
+    prof->flush_us = 0;
+    prof->wait_us = 0;
+    prof->call_us = 0;
+    prof->px = 0;
+
+    if (prof->monitor_cb) {
+        prof->monitor_cb(drv, time, px);
+    }
+}
+
+bool lvgl_prof_attach(lv_disp_t *disp)
+{
+    if (s_prof || !disp) {
+        return false;
+    }
+    prof_t *prof = calloc(1, sizeof(prof_t));
+    if (!prof) {
+        return false;
+    }
+    prof->disp = disp;
+    prof->drv = disp->driver;
+    prof->flush_cb = disp->driver->flush_cb;
+    prof->monitor_cb = disp->driver->monitor_cb;
+    prof->wait_cb = disp->driver->wait_cb;
+    s_prof = prof;
+
+    disp->driver->flush_cb = prof_flush_cb;
+    disp->driver->monitor_cb = prof_monitor_cb;
+    disp->driver->wait_cb = prof_wait_cb;
+    return true;
+}
+
+void lvgl_prof_detach(void)
+{
+    prof_t *prof = s_prof;
+    if (!prof) {
+        return;
+    }
+    prof->drv->flush_cb = prof->flush_cb;
+    prof->drv->monitor_cb = prof->monitor_cb;
+    prof->drv->wait_cb = prof->wait_cb;
+    s_prof = NULL;
+    free(prof);
+}
+
+void lvgl_prof_reset(void)
+{
+    if (s_prof) {
+        s_prof->frame_head = 0;
+        s_prof->frame_count = 0;
+        s_prof->inv_head = 0;
+        s_prof->inv_count = 0;
+    }
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_px_desc(const void *a, const void *b)
+{
+    uint32_t x = ((const lvgl_prof_invalidator_t *)a)->px;
+    uint32_t y = ((const lvgl_prof_invalidator_t *)b)->px;
+    return (x < y) - (x > y);
+}
+
+/* Sorts values, nearest rank */
+static uint32_t percentile(uint32_t *values, size_t n, unsigned p)
+{
+    qsort(values, n, sizeof(uint32_t), cmp_u32);
+    return values[(n - 1) * p / 100];
+}
+
+void lvgl_prof_get_summary(lvgl_prof_summary_t *summary)
+{
+    prof_t *prof = s_prof;
+    static uint32_t values[CONFIG_LVGL_PROF_FRAMES];
+    /* One more than the candidates, for "(other)" */
+    static lvgl_prof_invalidator_t candidates[CANDIDATES_MAX + 1];
+
+    memset(summary, 0, sizeof(*summary));
+    if (!prof || !prof->frame_count) {
+        return;
+    }
+
+    size_t n = prof->frame_count;
+    size_t first = (prof->frame_head + CONFIG_LVGL_PROF_FRAMES - n) % CONFIG_LVGL_PROF_FRAMES;
+    const frame_rec_t *oldest = &prof->frames[first];
+    const frame_rec_t *newest = &prof->frames[(prof->frame_head + CONFIG_LVGL_PROF_FRAMES - 1) % CONFIG_LVGL_PROF_FRAMES];
+    uint64_t px = 0;
+
+    summary->frames = n;
+    summary->window_ms = newest->end_ms - oldest->end_ms + oldest->frame_us / 1000;
+
+    for (size_t i = 0; i < n; i++) {
+        const frame_rec_t *rec = &prof->frames[(first + i) % CONFIG_LVGL_PROF_FRAMES];
+        values[i] = rec->frame_us;
+        px += rec->px;
+    }
+    summary->px_avg = px / n;
+    summary->frame_p50_us = percentile(values, n, 50);
+    summary->frame_p99_us = percentile(values, n, 99);
+    summary->frame_max_us = values[n - 1];
+    for (size_t i = 0; i < n; i++) {
+        values[i] = prof->frames[(first + i) % CONFIG_LVGL_PROF_FRAMES].render_us;
+    }
+    summary->render_p50_us = percentile(values, n, 50);
+    summary->render_p99_us = percentile(values, n, 99);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = prof->frames[(first + i) % CONFIG_LVGL_PROF_FRAMES].flush_us;
+    }
+    summary->flush_p50_us = percentile(values, n, 50);
+    summary->flush_p99_us = percentile(values, n, 99);
+
+    /* Order does not matter here, group by name or by object when unnamed, past CANDIDATES_MAX into "(other)" */
+    lvgl_prof_invalidator_t other = { .name = "(other)" };
+    size_t used = 0;
+    summary->invalidations = prof->inv_count;
+    for (size_t i = 0; i < prof->inv_count; i++) {
+        const inv_rec_t *rec = &prof->invs[i];
+        lvgl_prof_invalidator_t *inv = &other;
+        for (size_t j = 0; j < used; j++) {
+            if (candidates[j].name == rec->name && candidates[j].obj == rec->obj) {
+                inv = &candidates[j];
+                break;
+            }
+        }
+        if (inv == &other && used < CANDIDATES_MAX) {
+            inv = &candidates[used++];
+            *inv = (lvgl_prof_invalidator_t) {
+                .name = rec->name, .obj = rec->obj, .class_p = rec->class_p,
+            };
+        }
+        inv->count++;
+        inv->px += rec->px;
+    }
+    if (other.count) {
+        candidates[used++] = other;
+    }
+    qsort(candidates, used, sizeof(candidates[0]), cmp_px_desc);
+    summary->top_count = used < LVGL_PROF_TOP_N ? used : LVGL_PROF_TOP_N;
+    memcpy(summary->top, candidates, summary->top_count * sizeof(candidates[0]));
+}
+
+void lvgl_prof_print_summary(const lvgl_prof_summary_t *summary)
+{
+    if (!summary->frames) {
+        printf("lvgl_prof: no frames\n");
+        return;
+    }
+    printf("lvgl_prof: %u frames in %u ms, %u px invalidated per frame\n", (unsigned)summary->frames,
+           (unsigned)summary->window_ms, (unsigned)summary->px_avg);
+    printf("lvgl_prof: frame  p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n", summary->frame_p50_us / 1000.0,
+           summary->frame_p99_us / 1000.0, summary->frame_max_us / 1000.0);
+    printf("lvgl_prof: render p50 %6.2f ms  p99 %6.2f ms\n", summary->render_p50_us / 1000.0,
+           summary->render_p99_us / 1000.0);
+    printf("lvgl_prof: flush  p50 %6.2f ms  p99 %6.2f ms\n", summary->flush_p50_us / 1000.0,
+           summary->flush_p99_us / 1000.0);
+    printf("lvgl_prof: top invalidators of the last %u\n", (unsigned)summary->invalidations);
+    for (size_t i = 0; i < summary->top_count; i++) {
+        const lvgl_prof_invalidator_t *inv = &summary->top[i];
+        char label[32];
+        if (inv->name) {
+            snprintf(label, sizeof(label), "%s", inv->name);
+        } else if (inv->obj) {
+            snprintf(label, sizeof(label), "%s@%p", class_name(inv->class_p), inv->obj);
+        } else {
+            snprintf(label, sizeof(label), "(inside LVGL)");
+        }
+        printf("lvgl_prof:   %-24s %5u x %8u px\n", label, (unsigned)inv->count, (unsigned)inv->px);
+    }
+}
@@ -0,0 +1,447 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * app_chat_stream.c against the OpenAI mock of stubs/mock_server.c, with the tasks on pthreads and the player of
+ * stubs/fake_player.c reading the speech rings at the pace of playback. The tests check that the reply reaches the
+ * UI and the speaker whole and in order, that speech starts while the reply is still being generated, and what
+ * happens on a broken stream, a failed speech request, an abort and a failed init.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fake_player.h"
+#include "host_os.h"
+#include "mock_server.h"
+
+/* Included to reach the sentence cutting and the task handles */
+#include "app_chat_stream.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define TEST_KEY            "sk-test"
+#define TEST_URL            "https://api.openai.test/v1"
+#define TEST_PLAY_RATE      (16000)     // bytes of MP3 per second of speech, 128 kbit/s
+#define TEST_PROBE_LEN      (512)
+#define TEST_EVENTS_MAX     (256)
+#define TEST_WAIT_MS        (10 * 1000)
+
+static const char *s_reply =
+    "The ESP32-S3 has two cores running at up to 240 MHz. "
+    "It reads pi as 3.14 without ending a sentence here! "
+    "Wi-Fi and Bluetooth LE share the same radio? "
+    "Yes, they take turns.\n"
+    "这是一个中文句子。这也是一个句子！"
+    "And a last one without a full stop";
+
+typedef struct {
+    app_chat_stream_event_t event;
+    int64_t time_us;
+    char task[16];
+} test_event_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static test_event_t s_events[TEST_EVENTS_MAX];
+static size_t s_event_count;
+static char s_text[4096];
+static size_t s_text_len;
+static int s_abort_after_text;
+
+static void test_cb(app_chat_stream_event_t event, const char *data)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_event_count < TEST_EVENTS_MAX) {
+        test_event_t *e = &s_events[s_event_count++];
+        e->event = event;
+        e->time_us = esp_timer_get_time();
+        snprintf(e->task, sizeof(e->task), "%s", pcTaskGetName(NULL));
+    }
+    if (APP_CHAT_STREAM_EVENT_TEXT == event && s_text_len + strlen(data) < sizeof(s_text)) {
+        memcpy(s_text + s_text_len, data, strlen(data) + 1);
+        s_text_len += strlen(data);
+    }
+    bool abort = APP_CHAT_STREAM_EVENT_TEXT == event && s_abort_after_text && 0 == --s_abort_after_text;
+    pthread_mutex_unlock(&s_lock);
+
+    if (abort) {
+        app_chat_stream_abort();
+    }
+}
+
+static void events_clear(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_event_count = 0;
+    s_text_len = 0;
+    s_text[0] = '\0';
+    s_abort_after_text = 0;
+    pthread_mutex_unlock(&s_lock);
+}
+
+static size_t events_count(app_chat_stream_event_t event, const test_event_t **first)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&s_lock);
+    for (size_t i = 0; i < s_event_count; i++) {
+        if (s_events[i].event == event) {
+            if (0 == count && first) {
+                *first = &s_events[i];
+            }
+            count++;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return count;
+}
+
+static bool events_wait(app_chat_stream_event_t event, int timeout_ms)
+{
+    for (int t = 0; t < timeout_ms; t += 10) {
+        if (events_count(event, NULL)) {
+            return true;
+        }
+        usleep(10 * 1000);
+    }
+    return false;
+}
+
+static mock_server_cfg_t test_server_cfg(uint32_t seed)
+{
+    mock_server_cfg_t cfg = {
+        .transcription = "What can the ESP32-S3 do?",
+        .reply = s_reply,
+        .delta_max = 6,
+        .delta_delay_ms = 5,
+        .chunk_max = 96,
+        .tts_bytes_per_char = 120,
+        .tts_bytes_per_s = 4 * TEST_PLAY_RATE,
+        .tts_delay_ms = 20,
+        .seed = seed,
+    };
+    return cfg;
+}
+
+/* The non-empty clips the player got, compared with the speech the server sent for each sentence */
+static bool check_clips(size_t *played)
+{
+    const mock_server_log_t *log = mock_server_log();
+    size_t n = 0;
+
+    for (size_t i = 0; i < fake_player_clip_count(); i++) {
+        const fake_player_clip_t *clip = fake_player_clip(i);
+        if (0 == clip->len) {
+            continue;   // aborted before its first byte
+        }
+        CHECK(n < log->sentence_count, "clip %zu has no sentence", i);
+        CHECK(clip->probe_rewound, "clip %zu: seek back after the probe failed", i);
+
+        size_t len = 0;
+        uint8_t *mp3 = mock_server_mp3(log->sentences[n], 120, &len);
+        bool same = clip->len == len && !memcmp(clip->data, mp3, len);
+        free(mp3);
+        CHECK(same, "clip %zu: %zu bytes, not the %zu of \"%s\"", i, clip->len, len, log->sentences[n]);
+        n++;
+    }
+    *played = n;
+    return true;
+}
+
+static bool test_segment_boundary(void)
+{
+    static const struct {
+        const char *text;
+        size_t len;
+    } cases[] = {
+        {"Hello there, how are you? Fine.", 25},
+        {"The value of pi is 3.14 roughly", 0},     // no space after the dot
+        {"Short. Then a longer sentence. ", 30},    // "Short." is below SEGMENT_MIN_CHARS
+        {"A line without a stop\nnext", 22},
+        {"这是一个中文句子。后面", 27},
+        {"这是一个中文句子！", 27},
+        {"No end yet", 0},
+        {"Ends with a stop but no space.", 0},      // the next delta may be "5 cm"
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        size_t len = segment_boundary(cases[i].text, strlen(cases[i].text));
+        CHECK(len == cases[i].len, "\"%s\": %zu, expected %zu", cases[i].text, len, cases[i].len);
+    }
+    return true;
+}
+
+static bool test_segment_split(void)
+{
+    char text[SEGMENT_MAX_CHARS];
+
+    /* At the last space */
+    memset(text, 'a', sizeof(text));
+    text[100] = ' ';
+    text[200] = ' ';
+    CHECK(201 == segment_split(text, sizeof(text)), "split at %zu", segment_split(text, sizeof(text)));
+
+    /* No space: never inside a 3 byte character, the one cut short is left for the next sentence */
+    for (size_t i = 0; i + 3 <= sizeof(text); i += 3) {
+        memcpy(text + i, "中", 3);
+    }
+    size_t len = sizeof(text) - 2;  // 318 = 106 characters
+    size_t cut = segment_split(text, len - 1);
+    CHECK(len - 3 == cut, "split inside a character at %zu", cut);
+    CHECK(len == segment_split(text, len), "split a complete text at %zu", segment_split(text, len));
+    return true;
+}
+
+/* First, while nothing runs: a task that fails to start leaves nothing behind, and the next init works */
+static bool test_init_failure(void)
+{
+    CHECK(0 == host_os_running_tasks(), "%d tasks before init", host_os_running_tasks());
+    host_os_fail_task("Chat Play Task");
+    esp_err_t ret = app_chat_stream_init(TEST_KEY, TEST_URL, test_cb);
+    host_os_fail_task(NULL);
+    CHECK(ESP_FAIL == ret, "init returned %s", esp_err_to_name(ret));
+    CHECK(0 == host_os_running_tasks(), "%d tasks left after a failed init", host_os_running_tasks());
+    CHECK(NULL == s_tts_queue && NULL == s_play_queue && NULL == s_idle_sem, "queues left after a failed init");
+    CHECK(NULL == s_slots[0].buf && NULL == s_auth, "buffers left after a failed init");
+
+    ret = app_chat_stream_init(TEST_KEY, TEST_URL, test_cb);
+    CHECK(ESP_OK == ret, "init after a failure returned %s", esp_err_to_name(ret));
+    CHECK(2 == host_os_running_tasks(), "%d tasks running", host_os_running_tasks());
+    CHECK(ESP_ERR_INVALID_STATE == app_chat_stream_init(TEST_KEY, TEST_URL, test_cb), "second init accepted");
+    return true;
+}
+
+static bool test_transcribe(void)
+{
+    mock_server_cfg_t cfg = test_server_cfg(1);
+    uint8_t audio[3000];
+    char *text = NULL;
+
+    for (size_t i = 0; i < sizeof(audio); i++) {
+        audio[i] = (uint8_t)(i * 7);
+    }
+    mock_server_start(&cfg);
+    esp_err_t ret = app_chat_stream_transcribe(audio, sizeof(audio), "flac", &text);
+    CHECK(ESP_OK == ret, "transcribe returned %s", esp_err_to_name(ret));
+    CHECK(text && !strcmp(text, cfg.transcription), "transcription \"%s\"", text ? text : "(null)");
+    free(text);
+
+    /* The upload is the multipart form, the audio in it unchanged, and the closing boundary at the end */
+    const mock_server_log_t *log = mock_server_log();
+    const char *tail = "\r\n--" STT_BOUNDARY "--\r\n";
+    CHECK(log->upload_len > sizeof(audio) + strlen(tail), "upload of %zu bytes", log->upload_len);
+    CHECK(!memcmp(log->upload, "--" STT_BOUNDARY "\r\n", strlen(STT_BOUNDARY) + 4), "upload does not start with the boundary");
+    CHECK(!memcmp(log->upload + log->upload_len - strlen(tail), tail, strlen(tail)), "upload does not end with the boundary");
+    const char *part = "filename=\"audio.flac\"\r\nContent-Type: audio/flac\r\n\r\n";
+    const char *file = memmem(log->upload, log->upload_len, part, strlen(part));
+    CHECK(file, "no file part");
+    CHECK(!memcmp(file + strlen(part), audio, sizeof(audio)), "audio changed in the upload");
+    CHECK(memmem(log->upload, log->upload_len, "name=\"model\"\r\n\r\n" STT_MODEL "\r\n", 16 + strlen(STT_MODEL) + 2), "no model part");
+
+    CHECK(ESP_ERR_INVALID_ARG == app_chat_stream_transcribe(audio, 0, "flac", &text), "empty audio accepted");
+    mock_server_stop();
+    return true;
+}
+
+/* One reply under a server configuration, the audio played to its end */
+static bool run_reply(const mock_server_cfg_t *cfg, esp_err_t expected, int64_t *reply_us)
+{
+    events_clear();
+    fake_player_clear();
+    mock_server_start(cfg);
+
+    esp_err_t ret = app_chat_stream_reply("What can the ESP32-S3 do?");
+    if (reply_us) {
+        *reply_us = esp_timer_get_time();
+    }
+    CHECK(expected == ret, "reply returned %s", esp_err_to_name(ret));
+    if (ESP_OK == expected) {
+        CHECK(events_wait(APP_CHAT_STREAM_EVENT_AUDIO_END, TEST_WAIT_MS), "no AUDIO_END");
+        CHECK(fake_player_wait_idle(TEST_WAIT_MS), "still playing");
+    }
+    return true;
+}
+
+static bool test_reply(void)
+{
+    mock_server_cfg_t cfg = test_server_cfg(2);
+    const test_event_t *start = NULL;
+    const test_event_t *end = NULL;
+    int64_t turn_us = esp_timer_get_time();
+    int64_t reply_us = 0;
+    size_t played = 0;
+
+    CHECK(run_reply(&cfg, ESP_OK, &reply_us), "reply failed");
+    const mock_server_log_t *log = mock_server_log();
+
+    CHECK(1 == log->chat_requests && log->chat_stream_requested, "chat not streamed");
+    CHECK(!strcmp(s_text, s_reply), "UI text \"%s\"", s_text);
+    CHECK(log->sentence_count >= 5, "%zu sentences", log->sentence_count);
+    CHECK(!strcmp(log->sentences[0], "The ESP32-S3 has two cores running at up to 240 MHz."), "first sentence \"%s\"",
+          log->sentences[0]);
+    CHECK(!strcmp(log->sentences[log->sentence_count - 1], "And a last one without a full stop"), "last sentence \"%s\"",
+          log->sentences[log->sentence_count - 1]);
+    for (size_t i = 0; i < log->sentence_count; i++) {
+        CHECK(!strstr(log->sentences[i], "3.") || strstr(log->sentences[i], "3.14 without"), "cut at 3.14: \"%s\"",
+              log->sentences[i]);
+    }
+    CHECK(1 == log->tts_connections, "%d speech connections, the client is not kept", log->tts_connections);
+
+    CHECK(check_clips(&played), "clips differ");
+    CHECK(played == log->sentence_count, "%zu of %zu sentences played", played, log->sentence_count);
+    CHECK(1 == events_count(APP_CHAT_STREAM_EVENT_AUDIO_START, &start), "AUDIO_START count");
+    CHECK(1 == events_count(APP_CHAT_STREAM_EVENT_AUDIO_END, &end), "AUDIO_END count");
+    CHECK(0 == events_count(APP_CHAT_STREAM_EVENT_TTS_FAILED, NULL), "TTS_FAILED");
+    CHECK(start->time_us < log->chat_done_us, "speech started %" PRId64 " ms after the reply was complete",
+          (start->time_us - log->chat_done_us) / 1000);
+    CHECK(end->time_us >= fake_player_clip(fake_player_clip_count() - 1)->end_us, "AUDIO_END before the audio ended");
+
+    printf("reply complete after %" PRId64 " ms, first audio after %" PRId64 " ms, audio end after %" PRId64 " ms\n",
+           (log->chat_done_us - turn_us) / 1000, (start->time_us - turn_us) / 1000, (end->time_us - turn_us) / 1000);
+    (void) reply_us;
+    mock_server_stop();
+    return true;
+}
+
+/* CRLF line ends, comments and an overlong line, the body handed over one byte at a time or in large pieces */
+static bool test_sse_framing(void)
+{
+    static const size_t chunk_max[] = {1, 7, 4096};
+
+    for (size_t i = 0; i < sizeof(chunk_max) / sizeof(chunk_max[0]); i++) {
+        mock_server_cfg_t cfg = test_server_cfg(10 + i);
+        cfg.chunk_max = chunk_max[i];
+        cfg.crlf = true;
+        cfg.comments = true;
+        cfg.delta_delay_ms = 0;
+        cfg.tts_bytes_per_s = 0;
+        cfg.tts_delay_ms = 0;
+
+        CHECK(run_reply(&cfg, ESP_OK, NULL), "reply failed with chunks up to %zu", chunk_max[i]);
+        CHECK(!strcmp(s_text, s_reply), "chunks up to %zu: UI text \"%s\"", chunk_max[i], s_text);
+        size_t played = 0;
+        CHECK(check_clips(&played), "clips differ");
+        CHECK(played == mock_server_log()->sentence_count, "%zu sentences played", played);
+    }
+    mock_server_stop();
+    return true;
+}
+
+/* A stream broken in the middle is spoken up to where it stopped, an error status is an error */
+static bool test_broken_stream(void)
+{
+    mock_server_cfg_t cfg = test_server_cfg(20);
+    cfg.drop_after_events = 20;
+
+    CHECK(run_reply(&cfg, ESP_OK, NULL), "truncated reply failed");
+    CHECK(s_text_len > 0 && s_text_len < strlen(s_reply), "%zu chars of truncated reply", s_text_len);
+    CHECK(!strncmp(s_text, s_reply, s_text_len), "truncated reply \"%s\"", s_text);
+
+    cfg = test_server_cfg(21);
+    cfg.chat_status = 429;
+    CHECK(run_reply(&cfg, ESP_ERR_INVALID_RESPONSE, NULL), "error status");
+    CHECK(0 == s_text_len, "text from an error: \"%s\"", s_text);
+    CHECK(0 == mock_server_log()->sentence_count, "speech for an error");
+    mock_server_stop();
+    return true;
+}
+
+/* The second sentence fails: the first one plays, then the play task reports the failure, the rest is silent */
+static bool test_tts_failed(void)
+{
+    mock_server_cfg_t cfg = test_server_cfg(30);
+    const test_event_t *failed = NULL;
+    size_t played = 0;
+
+    cfg.tts_fail_sentence = 2;
+    cfg.tts_bytes_per_s = 0;
+    CHECK(run_reply(&cfg, ESP_OK, NULL), "reply failed");
+    const mock_server_log_t *log = mock_server_log();
+
+    CHECK(2 == log->sentence_count, "%zu sentences sent to speech after the failure", log->sentence_count);
+    CHECK(check_clips(&played), "clips differ");
+    CHECK(1 == played, "%zu sentences played", played);
+    CHECK(1 == events_count(APP_CHAT_STREAM_EVENT_TTS_FAILED, &failed), "TTS_FAILED count");
+    CHECK(!strcmp(failed->task, "Chat Play Task"), "TTS_FAILED from %s", failed->task);
+    CHECK(failed->time_us >= fake_player_clip(0)->end_us, "TTS_FAILED while the first sentence played");
+    CHECK(1 == events_count(APP_CHAT_STREAM_EVENT_AUDIO_END, NULL), "AUDIO_END count");
+    CHECK(!strcmp(s_text, s_reply), "UI text \"%s\"", s_text);
+    mock_server_stop();
+    return true;
+}
+
+/* Abort halfway through the reply: nothing of it is reported any more, and the next turn plays normally */
+static bool test_abort(void)
+{
+    mock_server_cfg_t cfg = test_server_cfg(40);
+
+    events_clear();
+    fake_player_clear();
+    mock_server_start(&cfg);
+    pthread_mutex_lock(&s_lock);
+    s_abort_after_text = 2;
+    pthread_mutex_unlock(&s_lock);
+
+    esp_err_t ret = app_chat_stream_reply("Tell me a story");
+    CHECK(ESP_ERR_INVALID_STATE == ret, "aborted reply returned %s", esp_err_to_name(ret));
+    CHECK(fake_player_wait_idle(TEST_WAIT_MS), "still playing after the abort");
+    usleep(2 * PLAY_POLL_MS * 1000);
+    CHECK(0 == events_count(APP_CHAT_STREAM_EVENT_AUDIO_END, NULL), "AUDIO_END of an aborted turn");
+    CHECK(0 == events_count(APP_CHAT_STREAM_EVENT_TTS_FAILED, NULL), "TTS_FAILED of an aborted turn");
+    CHECK(2 == events_count(APP_CHAT_STREAM_EVENT_TEXT, NULL), "text after the abort");
+
+    /* Both rings are free again */
+    CHECK(TTS_SLOT_NUM == uxQueueMessagesWaiting(s_free_slots), "%d rings free",
+          (int) uxQueueMessagesWaiting(s_free_slots));
+
+    cfg = test_server_cfg(41);
+    size_t played = 0;
+    CHECK(run_reply(&cfg, ESP_OK, NULL), "reply after an abort failed");
+    CHECK(!strcmp(s_text, s_reply), "UI text \"%s\"", s_text);
+    CHECK(check_clips(&played), "clips differ");
+    CHECK(played == mock_server_log()->sentence_count, "%zu sentences played", played);
+    mock_server_stop();
+    return true;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"init failure", test_init_failure},
+        {"segment boundary", test_segment_boundary},
+        {"segment split", test_segment_split},
+        {"transcribe", test_transcribe},
+        {"reply", test_reply},
+        {"sse framing", test_sse_framing},
+        {"broken stream", test_broken_stream},
+        {"tts failed", test_tts_failed},
+        {"abort", test_abort},
+    };
+    int failed = 0;
+
+    fake_player_start(TEST_PLAY_RATE, TEST_PROBE_LEN, app_chat_stream_play_idle);
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    fake_player_stop();
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,418 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * app_flac.c on synthetic recordings at 16 kHz: the compression against the WAV upload and the time to encode one
+ * block. Every stream is decoded again by the small reference decoder below, written from the FLAC format
+ * description, which checks the header CRC-8, the frame CRC-16, the frame numbers and STREAMINFO, and the samples
+ * have to come back bit-exact. A stream cut short by a full output buffer has to decode as a valid prefix.
+ *
+ * With -o <dir> the streams are also written as .flac files, e.g. for `flac -t` or `ffmpeg -i`.
+ * Exits with 1 on any mismatch.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "app_flac.h"
+
+#define SAMPLE_RATE         (16000)
+#define OUT_SIZE            (256000)    // FILE_SIZE, the upload buffer of app_audio.c
+#define BENCH_REPEAT        (20)
+
+typedef struct {
+    const char *name;
+    double seconds;
+    void (*gen)(int16_t *pcm, size_t num, uint32_t *rng);
+} signal_t;
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double uniform(uint32_t *rng)
+{
+    return (xorshift32(rng) >> 8) / (double)(1 << 24) * 2 - 1;
+}
+
+static int16_t clip16(double v)
+{
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : (int16_t) lrint(v);
+}
+
+/* Voiced syllables: a gliding pitch with its harmonics under two formants, gaps between words, room noise */
+static void gen_speech(int16_t *pcm, size_t num, uint32_t *rng)
+{
+    double phase = 0;
+    double lp = 0;
+
+    for (size_t i = 0; i < num; i++) {
+        double t = (double) i / SAMPLE_RATE;
+        double syllable = fmod(t, 0.25) / 0.25;
+        double word = fmod(t, 1.1) < 0.85 ? 1 : 0;
+        double env = word * sin(M_PI * syllable) * (0.6 + 0.4 * sin(2 * M_PI * 0.3 * t));
+        double f0 = 140 + 30 * sin(2 * M_PI * 0.7 * t);
+        double v = 0;
+
+        phase += 2 * M_PI * f0 / SAMPLE_RATE;
+        for (int h = 1; h <= 20; h++) {
+            double f = f0 * h;
+            double formant = exp(-pow((f - 700) / 300, 2)) + 0.5 * exp(-pow((f - 1800) / 400, 2)) + 0.05;
+            v += formant * sin(h * phase) / h;
+        }
+        lp += 0.2 * (uniform(rng) - lp);
+        pcm[i] = clip16(6000 * env * v + 60 * lp);
+    }
+}
+
+/* Fan and traffic: low-passed noise with a slow swell */
+static void gen_room(int16_t *pcm, size_t num, uint32_t *rng)
+{
+    double lp1 = 0, lp2 = 0;
+
+    for (size_t i = 0; i < num; i++) {
+        double t = (double) i / SAMPLE_RATE;
+        lp1 += 0.1 * (uniform(rng) - lp1);
+        lp2 += 0.1 * (lp1 - lp2);
+        pcm[i] = clip16(3000 * lp2 * (1 + 0.5 * sin(2 * M_PI * 0.2 * t)) + 100 * sin(2 * M_PI * 50 * t));
+    }
+}
+
+static void gen_white(int16_t *pcm, size_t num, uint32_t *rng)
+{
+    for (size_t i = 0; i < num; i++) {
+        pcm[i] = (int16_t) xorshift32(rng);
+    }
+}
+
+static void gen_silence(int16_t *pcm, size_t num, uint32_t *rng)
+{
+    memset(pcm, 0, num * sizeof(int16_t));
+}
+
+/* Full scale square wave with single sample spikes: the largest residuals the fixed predictors produce */
+static void gen_extremes(int16_t *pcm, size_t num, uint32_t *rng)
+{
+    for (size_t i = 0; i < num; i++) {
+        pcm[i] = ((i / 3) & 1) ? 32767 : -32768;
+        if (0 == xorshift32(rng) % 17) {
+            pcm[i] = -pcm[i] - 1;
+        }
+    }
+}
+
+static const signal_t s_signals[] = {
+    {"speech 4.6 s", 4.6, gen_speech},
+    {"room noise 3.1 s", 3.1, gen_room},
+    {"white noise 2 s", 2.0, gen_white},
+    {"silence 2 s", 2.0, gen_silence},
+    {"full scale 1 s", 1.0, gen_extremes},
+};
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;     // in bits
+    bool error;
+} bit_reader_t;
+
+static uint32_t br_get(bit_reader_t *br, uint32_t bits)
+{
+    uint32_t val = 0;
+
+    for (uint32_t i = 0; i < bits; i++) {
+        if (br->pos >= br->len * 8) {
+            br->error = true;
+            return 0;
+        }
+        val = (val << 1) | ((br->data[br->pos / 8] >> (7 - br->pos % 8)) & 1);
+        br->pos++;
+    }
+    return val;
+}
+
+static int32_t br_get_signed(bit_reader_t *br, uint32_t bits)
+{
+    uint32_t val = br_get(br, bits);
+    return bits && (val & (1u << (bits - 1))) ? (int32_t)(val | ~((1u << bits) - 1)) : (int32_t) val;
+}
+
+static uint32_t br_get_unary(bit_reader_t *br)
+{
+    uint32_t q = 0;
+    while (!br->error && 0 == br_get(br, 1)) {
+        q++;
+    }
+    return q;
+}
+
+static uint8_t ref_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t ref_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t) data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static const int s_fixed_coefs[5][4] = {
+    {0}, {1}, {2, -1}, {3, -3, 1}, {4, -6, 4, -1},
+};
+
+#define DECODE_FAIL(...) do { printf("FAIL decode: "); printf(__VA_ARGS__); printf("\n"); return -1; } while (0)
+
+/* The subset of FLAC a mono 16-bit encoder with fixed predictors may produce, -1 on any error */
+static long flac_decode(const uint8_t *data, size_t len, int16_t *pcm, size_t max)
+{
+    bit_reader_t br = {.data = data, .len = len};
+    size_t total = 0;
+    uint32_t min_frame = UINT32_MAX, max_frame = 0;
+
+    if (len < 42 || memcmp(data, "fLaC", 4)) {
+        DECODE_FAIL("no signature");
+    }
+    br.pos = 32;
+    if (1 != br_get(&br, 1) || 0 != br_get(&br, 7) || 34 != br_get(&br, 24)) {
+        DECODE_FAIL("STREAMINFO is not the only metadata block");
+    }
+    uint32_t min_block = br_get(&br, 16), max_block = br_get(&br, 16);
+    uint32_t info_min_frame = br_get(&br, 24), info_max_frame = br_get(&br, 24);
+    uint32_t rate = br_get(&br, 20), channels = br_get(&br, 3) + 1, bps = br_get(&br, 5) + 1;
+    uint64_t samples = ((uint64_t) br_get(&br, 4) << 32) | br_get(&br, 32);
+    br.pos += 128;
+    if (APP_FLAC_BLOCK_SIZE != min_block || APP_FLAC_BLOCK_SIZE != max_block || SAMPLE_RATE != rate || 1 != channels
+            || 16 != bps) {
+        DECODE_FAIL("STREAMINFO %u-%u samples per block, %u Hz, %u channels, %u bits", min_block, max_block, rate,
+                    channels, bps);
+    }
+
+    for (uint32_t frame = 0; br.pos / 8 < len; frame++) {
+        size_t start = br.pos / 8;
+        if (0xFFF8 != br_get(&br, 16)) {
+            DECODE_FAIL("frame %u: no sync", frame);
+        }
+        uint32_t bs_code = br_get(&br, 4), rate_code = br_get(&br, 4);
+        if (0x08 != br_get(&br, 8)) {
+            DECODE_FAIL("frame %u: not mono 16 bit", frame);
+        }
+        uint32_t number = br_get(&br, 8);
+        int extra = number < 0x80 ? 0 : number < 0xE0 ? 1 : number < 0xF0 ? 2 : number < 0xF8 ? 3 : number < 0xFC ? 4 : 5;
+        number &= extra ? 0x7F >> (extra + 1) : 0x7F;
+        for (int i = 0; i < extra; i++) {
+            number = (number << 6) | (br_get(&br, 8) & 0x3F);
+        }
+        uint32_t num = 12 == bs_code ? 4096 : 7 == bs_code ? br_get(&br, 16) + 1 : 0;
+        if (0 == num || 5 != rate_code || number != frame) {
+            DECODE_FAIL("frame %u: block size code %u, rate code %u, number %u", frame, bs_code, rate_code, number);
+        }
+        if (ref_crc8(data + start, br.pos / 8 - start) != br_get(&br, 8)) {
+            DECODE_FAIL("frame %u: header CRC", frame);
+        }
+        if (total + num > max) {
+            DECODE_FAIL("frame %u: more samples than encoded", frame);
+        }
+
+        int16_t *out = pcm + total;
+        uint32_t type = br_get(&br, 8);
+        if (type & 0x81) {
+            DECODE_FAIL("frame %u: padding bit or wasted bits", frame);
+        }
+        type >>= 1;
+        if (0 == type) {
+            int16_t v = (int16_t) br_get_signed(&br, 16);
+            for (uint32_t i = 0; i < num; i++) {
+                out[i] = v;
+            }
+        } else if (1 == type) {
+            for (uint32_t i = 0; i < num; i++) {
+                out[i] = (int16_t) br_get_signed(&br, 16);
+            }
+        } else if (type >= 8 && type <= 12) {
+            uint32_t order = type - 8;
+            int32_t *res = calloc(num, sizeof(int32_t));
+            for (uint32_t i = 0; i < order; i++) {
+                res[i] = br_get_signed(&br, 16);
+            }
+            uint32_t method = br_get(&br, 2);
+            uint32_t porder = br_get(&br, 4);
+            uint32_t param_bits = method ? 5 : 4;
+            if (method > 1 || (num >> porder) << porder != num || (num >> porder) < order) {
+                free(res);
+                DECODE_FAIL("frame %u: residual coding %u, partition order %u", frame, method, porder);
+            }
+            for (uint32_t p = 0, i = order; p < (1u << porder); p++) {
+                uint32_t k = br_get(&br, param_bits);
+                uint32_t end = (p + 1) * (num >> porder);
+                bool escape = k == (1u << param_bits) - 1;
+                uint32_t raw_bits = escape ? br_get(&br, 5) : 0;
+                for (; i < end && !br.error; i++) {
+                    if (escape) {
+                        res[i] = br_get_signed(&br, raw_bits);
+                    } else {
+                        uint32_t u = (br_get_unary(&br) << k) | br_get(&br, k);
+                        res[i] = (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+                    }
+                }
+            }
+            /* Undo the prediction, the warm-up samples are stored as they are */
+            for (uint32_t i = 0; i < num; i++) {
+                int64_t v = res[i];
+                if (i >= order) {
+                    for (uint32_t c = 0; c < order; c++) {
+                        v += (int64_t) s_fixed_coefs[order][c] * out[i - 1 - c];
+                    }
+                }
+                if (v < -32768 || v > 32767) {
+                    free(res);
+                    DECODE_FAIL("frame %u: sample %u out of range", frame, i);
+                }
+                out[i] = (int16_t) v;
+            }
+            free(res);
+        } else {
+            DECODE_FAIL("frame %u: subframe type %u", frame, type);
+        }
+
+        br.pos = (br.pos + 7) / 8 * 8;
+        size_t crc_at = br.pos / 8;
+        if (br.error || ref_crc16(data + start, crc_at - start) != br_get(&br, 16)) {
+            DECODE_FAIL("frame %u: %s", frame, br.error ? "truncated" : "frame CRC");
+        }
+        uint32_t frame_len = br.pos / 8 - start;
+        min_frame = frame_len < min_frame ? frame_len : min_frame;
+        max_frame = frame_len > max_frame ? frame_len : max_frame;
+        total += num;
+    }
+    if (total != samples || (total && (min_frame != info_min_frame || max_frame != info_max_frame))) {
+        DECODE_FAIL("STREAMINFO says %llu samples, frames %u-%u bytes, decoded %zu, frames %u-%u bytes",
+                    (unsigned long long) samples, info_min_frame, info_max_frame, total, min_frame, max_frame);
+    }
+    return (long) total;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* Block by block, as the detect task encodes the recording */
+static size_t encode(app_flac_enc_t *enc, const int16_t *pcm, size_t num, uint8_t *out, size_t out_size, size_t *encoded)
+{
+    app_flac_enc_init(enc, SAMPLE_RATE, out, out_size);
+    *encoded = 0;
+    for (size_t i = 0; i < num; i += APP_FLAC_BLOCK_SIZE) {
+        uint32_t n = num - i < APP_FLAC_BLOCK_SIZE ? num - i : APP_FLAC_BLOCK_SIZE;
+        if (!app_flac_enc_block(enc, pcm + i, n)) {
+            break;
+        }
+        *encoded += n;
+    }
+    return app_flac_enc_finish(enc);
+}
+
+static void write_file(const char *dir, const char *name, const uint8_t *data, size_t len)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%.*s.flac", dir, (int) strcspn(name, " "), name);
+    FILE *fp = fopen(path, "wb");
+    if (fp) {
+        fwrite(data, 1, len, fp);
+        fclose(fp);
+    }
+}
+
+static bool check_stream(const char *name, const uint8_t *out, size_t len, const int16_t *pcm, size_t encoded)
+{
+    int16_t *decoded = malloc((encoded + 1) * sizeof(int16_t));
+    long n = flac_decode(out, len, decoded, encoded);
+    bool same = n == (long) encoded && 0 == memcmp(decoded, pcm, encoded * sizeof(int16_t));
+    free(decoded);
+    if (!same) {
+        printf("FAIL %s: %ld of %zu samples decoded%s\n", name, n, encoded, n == (long) encoded ? ", not the same" : "");
+    }
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    const char *dir = argc > 2 && !strcmp(argv[1], "-o") ? argv[2] : NULL;
+    app_flac_enc_t *enc = malloc(sizeof(app_flac_enc_t));
+    uint8_t *out = malloc(OUT_SIZE);
+    int failed = 0;
+
+    printf("%-18s %9s %9s %7s %12s\n", "signal", "WAV KB", "FLAC KB", "ratio", "us/block");
+    for (size_t s = 0; s < sizeof(s_signals) / sizeof(s_signals[0]); s++) {
+        const signal_t *sig = &s_signals[s];
+        size_t num = (size_t)(sig->seconds * SAMPLE_RATE);
+        int16_t *pcm = malloc(num * sizeof(int16_t));
+        uint32_t rng = 12345;
+        size_t encoded = 0;
+        size_t len = 0;
+
+        sig->gen(pcm, num, &rng);
+        double start = now_us();
+        for (int r = 0; r < BENCH_REPEAT; r++) {
+            len = encode(enc, pcm, num, out, OUT_SIZE, &encoded);
+        }
+        double per_block = (now_us() - start) / BENCH_REPEAT / ((num + APP_FLAC_BLOCK_SIZE - 1) / APP_FLAC_BLOCK_SIZE);
+        double wav = 44 + num * sizeof(int16_t);
+
+        printf("%-18s %9.1f %9.1f %7.2f %12.0f\n", sig->name, wav / 1024, len / 1024.0, wav / len, per_block);
+        if (encoded != num) {
+            printf("FAIL %s: %zu of %zu samples fit\n", sig->name, encoded, num);
+            failed++;
+        }
+        failed += !check_stream(sig->name, out, len, pcm, encoded);
+        if (dir) {
+            write_file(dir, sig->name, out, len);
+        }
+
+        /* Output buffer too small: what was written is still a valid stream of the first blocks */
+        if (len < 1024) {
+            free(pcm);
+            continue;
+        }
+        size_t small = len / 3 + 100;
+        size_t cut_len = encode(enc, pcm, num, out, small, &encoded);
+        if (cut_len > small || encoded >= num) {
+            printf("FAIL %s: %zu bytes and %zu samples in a %zu byte buffer\n", sig->name, cut_len, encoded, small);
+            failed++;
+        }
+        failed += !check_stream(sig->name, out, cut_len, pcm, encoded);
+        free(pcm);
+    }
+    free(out);
+    free(enc);
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
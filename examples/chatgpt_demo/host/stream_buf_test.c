@@ -0,0 +1,331 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * app_stream_buf.c between a writer thread standing in for the speech download and a reader using the FILE the way
+ * the MP3 decoder does: a format probe, a seek back to 0, then reads at playback pace. Chunk sizes and delays are
+ * jittered on both sides. The stream is far longer than the ring, every byte is compared.
+ */
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "app_stream_buf.h"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define TEST_RING           (32 * 1024)
+#define TEST_PREBUFFER      (4 * 1024)
+#define TEST_PIN            (8 * 1024)
+#define TEST_STREAM_LEN     (300 * 1024)
+#define TEST_PROBE_LEN      (512)
+
+typedef struct {
+    app_stream_buf_handle_t buf;
+    size_t len;
+    size_t chunk_max;
+    int delay_max_us;       /*!< Pause after each chunk, 0 to this at random */
+    int pause_at;           /*!< Offset of a long pause of the writer, 0 none */
+    int pause_ms;
+    uint32_t rng;
+    esp_err_t ret;
+    int64_t done_us;
+} writer_t;
+
+typedef struct {
+    int stalls;
+    int resumes;
+} events_t;
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static uint8_t pattern(size_t pos)
+{
+    return (uint8_t)(pos * 31 + (pos >> 8) * 7);
+}
+
+static void on_event(app_stream_buf_event_t event, void *args)
+{
+    events_t *events = args;
+    if (APP_STREAM_BUF_EVENT_STALL == event) {
+        events->stalls++;
+    } else {
+        events->resumes++;
+    }
+}
+
+static void *writer_main(void *arg)
+{
+    writer_t *w = arg;
+    uint8_t chunk[4096];
+    size_t pos = 0;
+    bool paused = false;
+
+    w->ret = ESP_OK;
+    while (pos < w->len) {
+        size_t n = 1 + xorshift32(&w->rng) % w->chunk_max;
+        n = n > w->len - pos ? w->len - pos : n;
+        for (size_t i = 0; i < n; i++) {
+            chunk[i] = pattern(pos + i);
+        }
+        w->ret = app_stream_buf_write(w->buf, chunk, n, portMAX_DELAY);
+        if (ESP_OK != w->ret) {
+            break;
+        }
+        pos += n;
+        if (w->delay_max_us) {
+            usleep(xorshift32(&w->rng) % w->delay_max_us);
+        }
+        if (w->pause_at && !paused && pos >= (size_t) w->pause_at) {
+            paused = true;
+            usleep(w->pause_ms * 1000);
+        }
+    }
+    if (ESP_OK == w->ret) {
+        app_stream_buf_finish(w->buf);
+    }
+    w->done_us = esp_timer_get_time();
+    return NULL;
+}
+
+static app_stream_buf_handle_t test_buf_create(events_t *events)
+{
+    app_stream_buf_cfg_t cfg = {
+        .size = TEST_RING,
+        .prebuffer = TEST_PREBUFFER,
+        .pin = TEST_PIN,
+        .cb = on_event,
+        .cb_args = events,
+    };
+    app_stream_buf_handle_t buf = NULL;
+    return ESP_OK == app_stream_buf_create(&cfg, &buf) ? buf : NULL;
+}
+
+/* Reads like the decoder: probe, pause to look at it, seek back to 0, then the stream at a jittered pace */
+static bool read_stream(FILE *fp, size_t len, uint32_t *rng, int think_ms, int delay_max_us)
+{
+    uint8_t data[4096];
+    size_t pos = 0;
+
+    CHECK(TEST_PROBE_LEN == fread(data, 1, TEST_PROBE_LEN, fp), "short probe");
+    for (size_t i = 0; i < TEST_PROBE_LEN; i++) {
+        CHECK(pattern(i) == data[i], "probe byte %zu", i);
+    }
+    usleep(think_ms * 1000);
+    CHECK(0 == fseek(fp, 0, SEEK_SET), "seek back to 0 after the probe failed");
+
+    while (true) {
+        size_t want = 1 + xorshift32(rng) % sizeof(data);
+        size_t n = fread(data, 1, want, fp);
+        for (size_t i = 0; i < n; i++) {
+            CHECK(pattern(pos + i) == data[i], "byte %zu: %02x, expected %02x", pos + i, data[i], pattern(pos + i));
+        }
+        pos += n;
+        if (n < want) {
+            break;
+        }
+        if (delay_max_us) {
+            usleep(xorshift32(rng) % delay_max_us);
+        }
+    }
+    CHECK(pos == len, "read %zu of %zu bytes", pos, len);
+    return true;
+}
+
+/* The writer is far ahead while the decoder looks at its probe: the head has to still be there for the seek */
+static bool test_rewind_after_probe(void)
+{
+    events_t events = { 0 };
+    app_stream_buf_handle_t buf = test_buf_create(&events);
+    writer_t w = {.buf = buf, .len = TEST_STREAM_LEN, .chunk_max = 4096, .rng = 1};
+    pthread_t thread;
+    uint32_t rng = 2;
+
+    CHECK(buf, "create failed");
+    FILE *fp = app_stream_buf_fopen(buf);
+    pthread_create(&thread, NULL, writer_main, &w);
+    bool ok = read_stream(fp, TEST_STREAM_LEN, &rng, 50, 0);
+    if (!ok) {
+        app_stream_buf_abort(buf);
+    }
+    pthread_join(thread, NULL);
+    fclose(fp);
+    app_stream_buf_delete(buf);
+    CHECK(ok, "stream corrupted");
+    CHECK(ESP_OK == w.ret, "write returned %s", esp_err_to_name(w.ret));
+    return true;
+}
+
+/* Jitter on both sides, several streams through the same ring after a reset */
+static bool test_jitter(void)
+{
+    events_t events = { 0 };
+    app_stream_buf_handle_t buf = test_buf_create(&events);
+
+    CHECK(buf, "create failed");
+    for (uint32_t seed = 1; seed <= 4; seed++) {
+        writer_t w = {.buf = buf, .len = TEST_STREAM_LEN, .chunk_max = 1 + seed * 900, .delay_max_us = 200, .rng = seed};
+        pthread_t thread;
+        uint32_t rng = seed * 77;
+
+        app_stream_buf_reset(buf);
+        FILE *fp = app_stream_buf_fopen(buf);
+        pthread_create(&thread, NULL, writer_main, &w);
+        bool ok = read_stream(fp, TEST_STREAM_LEN, &rng, (int) seed, 200);
+        if (!ok) {
+            app_stream_buf_abort(buf);
+        }
+        pthread_join(thread, NULL);
+        fclose(fp);
+        if (!ok) {
+            app_stream_buf_delete(buf);
+            CHECK(false, "seed %" PRIu32 ": stream corrupted", seed);
+        }
+    }
+    app_stream_buf_delete(buf);
+    return true;
+}
+
+/* The writer, much faster than the reader, stops for a while: one stall, one resume, nothing lost */
+static bool test_stall(void)
+{
+    events_t events = { 0 };
+    app_stream_buf_handle_t buf = test_buf_create(&events);
+    writer_t w = {.buf = buf, .len = 64 * 1024, .chunk_max = 4096, .pause_at = 16 * 1024, .pause_ms = 100, .rng = 5};
+    pthread_t thread;
+    uint32_t rng = 6;
+
+    CHECK(buf, "create failed");
+    FILE *fp = app_stream_buf_fopen(buf);
+    pthread_create(&thread, NULL, writer_main, &w);
+    bool ok = read_stream(fp, w.len, &rng, 0, 2000);
+    pthread_join(thread, NULL);
+    fclose(fp);
+    uint32_t stalls = app_stream_buf_get_stalls(buf);
+    app_stream_buf_delete(buf);
+    CHECK(ok, "stream corrupted");
+    CHECK(1 == stalls && 1 == events.stalls && 1 == events.resumes, "%" PRIu32 " stalls, %d stall and %d resume events",
+          stalls, events.stalls, events.resumes);
+    return true;
+}
+
+static void *abort_later(void *arg)
+{
+    usleep(50 * 1000);
+    app_stream_buf_abort(arg);
+    return NULL;
+}
+
+/* A writer blocked on a full ring and a reader blocked on an empty one both return on abort */
+static bool test_abort(void)
+{
+    events_t events = { 0 };
+    app_stream_buf_handle_t buf = test_buf_create(&events);
+    writer_t w = {.buf = buf, .len = 2 * TEST_RING, .chunk_max = 4096, .rng = 7};
+    pthread_t aborter;
+    uint8_t data[1024];
+
+    CHECK(buf, "create failed");
+    pthread_create(&aborter, NULL, abort_later, buf);
+    writer_main(&w);
+    pthread_join(aborter, NULL);
+    CHECK(ESP_ERR_INVALID_STATE == w.ret, "blocked write returned %s", esp_err_to_name(w.ret));
+
+    app_stream_buf_reset(buf);
+    FILE *fp = app_stream_buf_fopen(buf);
+    CHECK(ESP_OK == app_stream_buf_write(buf, data, 100, 0), "write failed");
+    pthread_create(&aborter, NULL, abort_later, buf);
+    int64_t start_us = esp_timer_get_time();
+    size_t n = fread(data, 1, sizeof(data), fp);
+    int64_t waited_ms = (esp_timer_get_time() - start_us) / 1000;
+    pthread_join(aborter, NULL);
+    fclose(fp);
+
+    /* A full ring with no reader times out */
+    app_stream_buf_reset(buf);
+    uint8_t *big = calloc(1, TEST_RING + 1);
+    esp_err_t ret = app_stream_buf_write(buf, big, TEST_RING + 1, 20);
+    free(big);
+    app_stream_buf_delete(buf);
+
+    CHECK(0 == n && waited_ms >= 40, "read %zu bytes after %" PRId64 " ms", n, waited_ms);
+    CHECK(ESP_ERR_TIMEOUT == ret, "write to a full ring returned %s", esp_err_to_name(ret));
+    return true;
+}
+
+/* SEEK_END only once the length is known, no seek before the oldest byte the ring still holds */
+static bool test_seek(void)
+{
+    events_t events = { 0 };
+    app_stream_buf_handle_t buf = test_buf_create(&events);
+    uint8_t data[TEST_RING];
+
+    CHECK(buf, "create failed");
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = pattern(i);
+    }
+    FILE *fp = app_stream_buf_fopen(buf);
+    app_stream_buf_write(buf, data, sizeof(data), 0);
+    CHECK(0 != fseek(fp, 0, SEEK_END), "SEEK_END before the end is known");
+
+    /* Past the pinned head, the oldest bytes may be overwritten */
+    uint8_t *sink = malloc(TEST_PIN * 2);
+    size_t n = fread(sink, 1, TEST_PIN * 2, fp);
+    free(sink);
+    CHECK(TEST_PIN * 2 == n, "read %zu", n);
+    app_stream_buf_write(buf, data, TEST_PIN, 0);
+    app_stream_buf_finish(buf);
+    CHECK(0 != fseek(fp, 0, SEEK_SET), "seek to an overwritten byte");
+    CHECK(0 == fseek(fp, 0, SEEK_END) && TEST_RING + TEST_PIN == ftell(fp), "SEEK_END once finished");
+    CHECK(0 == fseek(fp, TEST_PIN + 10, SEEK_SET) && fgetc(fp) == pattern(TEST_PIN + 10), "seek within the ring");
+    fclose(fp);
+    app_stream_buf_delete(buf);
+    return true;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"rewind after probe", test_rewind_after_probe},
+        {"jitter", test_jitter},
+        {"stall", test_stall},
+        {"abort", test_abort},
+        {"seek", test_seek},
+    };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,472 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Enough of cJSON for the host tests: objects, arrays, strings with escapes including \u surrogate pairs, numbers,
+ * true, false and null. Parse errors return NULL, printing is unformatted.
+ */
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+
+typedef struct {
+    const char *p;
+} parser_t;
+
+static cJSON *parse_value(parser_t *ps);
+
+static cJSON *item_new(int type)
+{
+    cJSON *item = calloc(1, sizeof(cJSON));
+    if (item) {
+        item->type = type;
+    }
+    return item;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    while (item) {
+        cJSON *next = item->next;
+        cJSON_Delete(item->child);
+        free(item->valuestring);
+        free(item->string);
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void *object)
+{
+    free(object);
+}
+
+static void skip_space(parser_t *ps)
+{
+    while (isspace((unsigned char) *ps->p)) {
+        ps->p++;
+    }
+}
+
+static int hex4(const char *p)
+{
+    int v = 0;
+    for (int i = 0; i < 4; i++) {
+        int c = p[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') {
+            v |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            v |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            v |= c - 'A' + 10;
+        } else {
+            return -1;
+        }
+    }
+    return v;
+}
+
+static size_t utf8_put(char *out, uint32_t cp)
+{
+    if (cp < 0x80) {
+        out[0] = cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = 0xC0 | (cp >> 6);
+        out[1] = 0x80 | (cp & 0x3F);
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = 0xE0 | (cp >> 12);
+        out[1] = 0x80 | ((cp >> 6) & 0x3F);
+        out[2] = 0x80 | (cp & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (cp >> 18);
+    out[1] = 0x80 | ((cp >> 12) & 0x3F);
+    out[2] = 0x80 | ((cp >> 6) & 0x3F);
+    out[3] = 0x80 | (cp & 0x3F);
+    return 4;
+}
+
+/* At the opening quote, returns the decoded string */
+static char *parse_string(parser_t *ps)
+{
+    const char *p = ps->p + 1;
+    char *out = malloc(strlen(p) + 1);      // escapes never grow the text
+    size_t n = 0;
+
+    if (!out) {
+        return NULL;
+    }
+    while (*p && *p != '"') {
+        if (*p != '\\') {
+            out[n++] = *p++;
+            continue;
+        }
+        p++;
+        switch (*p) {
+        case '"':
+        case '\\':
+        case '/':
+            out[n++] = *p;
+            break;
+        case 'b':
+            out[n++] = '\b';
+            break;
+        case 'f':
+            out[n++] = '\f';
+            break;
+        case 'n':
+            out[n++] = '\n';
+            break;
+        case 'r':
+            out[n++] = '\r';
+            break;
+        case 't':
+            out[n++] = '\t';
+            break;
+        case 'u': {
+            int hi = hex4(p + 1);
+            uint32_t cp = hi;
+            if (hi < 0) {
+                goto err;
+            }
+            p += 4;
+            if (hi >= 0xD800 && hi < 0xDC00) {
+                int lo = (p[1] == '\\' && p[2] == 'u') ? hex4(p + 3) : -1;
+                if (lo < 0xDC00 || lo >= 0xE000) {
+                    goto err;
+                }
+                cp = 0x10000 + ((hi - 0xD800) << 10) + (lo - 0xDC00);
+                p += 6;
+            }
+            n += utf8_put(out + n, cp);
+            break;
+        }
+        default:
+            goto err;
+        }
+        p++;
+    }
+    if (*p != '"') {
+        goto err;
+    }
+    out[n] = '\0';
+    ps->p = p + 1;
+    return out;
+
+err:
+    free(out);
+    return NULL;
+}
+
+static cJSON *parse_container(parser_t *ps, int type, char close)
+{
+    cJSON *item = item_new(type);
+    cJSON **tail = item ? &item->child : NULL;
+
+    if (!item) {
+        return NULL;
+    }
+    ps->p++;
+    skip_space(ps);
+    if (*ps->p == close) {
+        ps->p++;
+        return item;
+    }
+    while (true) {
+        char *name = NULL;
+        skip_space(ps);
+        if (cJSON_Object == type) {
+            if (*ps->p != '"' || !(name = parse_string(ps))) {
+                goto err;
+            }
+            skip_space(ps);
+            if (*ps->p++ != ':') {
+                free(name);
+                goto err;
+            }
+        }
+        cJSON *child = parse_value(ps);
+        if (!child) {
+            free(name);
+            goto err;
+        }
+        child->string = name;
+        *tail = child;
+        tail = &child->next;
+        skip_space(ps);
+        if (*ps->p == ',') {
+            ps->p++;
+        } else if (*ps->p == close) {
+            ps->p++;
+            return item;
+        } else {
+            goto err;
+        }
+    }
+
+err:
+    cJSON_Delete(item);
+    return NULL;
+}
+
+static cJSON *parse_value(parser_t *ps)
+{
+    skip_space(ps);
+    const char *p = ps->p;
+    cJSON *item = NULL;
+
+    if (*p == '{') {
+        return parse_container(ps, cJSON_Object, '}');
+    } else if (*p == '[') {
+        return parse_container(ps, cJSON_Array, ']');
+    } else if (*p == '"') {
+        char *s = parse_string(ps);
+        if (s && (item = item_new(cJSON_String))) {
+            item->valuestring = s;
+        } else {
+            free(s);
+        }
+    } else if (!strncmp(p, "true", 4)) {
+        item = item_new(cJSON_True);
+        ps->p += 4;
+    } else if (!strncmp(p, "false", 5)) {
+        item = item_new(cJSON_False);
+        ps->p += 5;
+    } else if (!strncmp(p, "null", 4)) {
+        item = item_new(cJSON_NULL);
+        ps->p += 4;
+    } else if (*p == '-' || isdigit((unsigned char) *p)) {
+        char *end;
+        double v = strtod(p, &end);
+        if ((item = item_new(cJSON_Number))) {
+            item->valuedouble = v;
+        }
+        ps->p = end;
+    }
+    return item;
+}
+
+cJSON *cJSON_Parse(const char *value)
+{
+    if (!value) {
+        return NULL;
+    }
+    parser_t ps = {.p = value};
+    cJSON *item = parse_value(&ps);
+    skip_space(&ps);
+    if (item && *ps.p) {
+        cJSON_Delete(item);
+        item = NULL;
+    }
+    return item;
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    if (!object || object->type != cJSON_Object) {
+        return NULL;
+    }
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && !strcmp(c->string, string)) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    if (!array || array->type != cJSON_Array || index < 0) {
+        return NULL;
+    }
+    cJSON *c = array->child;
+    while (c && index--) {
+        c = c->next;
+    }
+    return c;
+}
+
+bool cJSON_IsString(const cJSON *item)
+{
+    return item && item->type == cJSON_String;
+}
+
+bool cJSON_IsTrue(const cJSON *item)
+{
+    return item && item->type == cJSON_True;
+}
+
+cJSON *cJSON_CreateObject(void)
+{
+    return item_new(cJSON_Object);
+}
+
+static cJSON *add_item(cJSON *container, const char *name, cJSON *item)
+{
+    if (!container || !item) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    if (name && !(item->string = strdup(name))) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    cJSON **tail = &container->child;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = item;
+    return item;
+}
+
+cJSON *cJSON_AddArrayToObject(cJSON *object, const char *name)
+{
+    return add_item(object, name, item_new(cJSON_Array));
+}
+
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string)
+{
+    cJSON *item = item_new(cJSON_String);
+    if (item && !(item->valuestring = strdup(string))) {
+        cJSON_Delete(item);
+        return NULL;
+    }
+    return add_item(object, name, item);
+}
+
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number)
+{
+    cJSON *item = item_new(cJSON_Number);
+    if (item) {
+        item->valuedouble = number;
+    }
+    return add_item(object, name, item);
+}
+
+cJSON *cJSON_AddTrueToObject(cJSON *object, const char *name)
+{
+    return add_item(object, name, item_new(cJSON_True));
+}
+
+bool cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    return add_item(array, NULL, item) != NULL;
+}
+
+bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    return add_item(object, string, item) != NULL;
+}
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t size;
+    bool failed;
+} printer_t;
+
+static void put(printer_t *pr, const char *s, size_t n)
+{
+    if (pr->failed) {
+        return;
+    }
+    if (pr->len + n + 1 > pr->size) {
+        size_t size = (pr->len + n + 1) * 2;
+        char *buf = realloc(pr->buf, size);
+        if (!buf) {
+            pr->failed = true;
+            return;
+        }
+        pr->buf = buf;
+        pr->size = size;
+    }
+    memcpy(pr->buf + pr->len, s, n);
+    pr->len += n;
+    pr->buf[pr->len] = '\0';
+}
+
+static void print_string(printer_t *pr, const char *s)
+{
+    put(pr, "\"", 1);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        char esc[8];
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = c;
+            put(pr, esc, 2);
+        } else if (c < 0x20) {
+            put(pr, esc, snprintf(esc, sizeof(esc), "\\u%04x", c));
+        } else {
+            put(pr, (const char *) &c, 1);
+        }
+    }
+    put(pr, "\"", 1);
+}
+
+static void print_value(printer_t *pr, const cJSON *item)
+{
+    char num[32];
+
+    switch (item->type) {
+    case cJSON_False:
+        put(pr, "false", 5);
+        break;
+    case cJSON_True:
+        put(pr, "true", 4);
+        break;
+    case cJSON_NULL:
+        put(pr, "null", 4);
+        break;
+    case cJSON_Number:
+        put(pr, num, snprintf(num, sizeof(num), "%.17g", item->valuedouble));
+        break;
+    case cJSON_String:
+        print_string(pr, item->valuestring);
+        break;
+    case cJSON_Array:
+    case cJSON_Object: {
+        bool object = item->type == cJSON_Object;
+        put(pr, object ? "{" : "[", 1);
+        for (const cJSON *c = item->child; c; c = c->next) {
+            if (object) {
+                print_string(pr, c->string);
+                put(pr, ":", 1);
+            }
+            print_value(pr, c);
+            if (c->next) {
+                put(pr, ",", 1);
+            }
+        }
+        put(pr, object ? "}" : "]", 1);
+        break;
+    }
+    default:
+        pr->failed = true;
+        break;
+    }
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    printer_t pr = {0};
+    if (!item) {
+        return NULL;
+    }
+    print_value(&pr, item);
+    if (pr.failed) {
+        free(pr.buf);
+        return NULL;
+    }
+    return pr.buf;
+}
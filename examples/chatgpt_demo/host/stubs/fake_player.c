@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* audio_player_play() on a thread that reads the file at the pace of playback and keeps what it read */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "audio_player.h"
+#include "esp_timer.h"
+#include "fake_player.h"
+
+#define FAKE_PLAYER_READ    (1024)
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_idle = PTHREAD_COND_INITIALIZER;
+static bool s_playing;
+static bool s_joinable;
+static pthread_t s_thread;
+static size_t s_bytes_per_s;
+static size_t s_probe_len;
+static void (*s_idle_cb)(void);
+static fake_player_clip_t s_clips[FAKE_PLAYER_CLIPS_MAX];
+static size_t s_clip_count;
+
+static bool clip_append(fake_player_clip_t *clip, const uint8_t *data, size_t len)
+{
+    uint8_t *buf = realloc(clip->data, clip->len + len);
+    if (!buf) {
+        return false;
+    }
+    memcpy(buf + clip->len, data, len);
+    clip->data = buf;
+    clip->len += len;
+    return true;
+}
+
+static void *player_main(void *arg)
+{
+    FILE *fp = arg;
+    fake_player_clip_t clip = {.start_us = esp_timer_get_time()};
+    uint8_t buf[FAKE_PLAYER_READ];
+    size_t n;
+
+    /* The decoder looks at the head of the file to find its format, then starts over */
+    size_t probe = s_probe_len < sizeof(buf) ? s_probe_len : sizeof(buf);
+    if (probe) {
+        n = fread(buf, 1, probe, fp);
+        clip.probe_rewound = (0 == fseek(fp, 0, SEEK_SET));
+    } else {
+        clip.probe_rewound = true;
+    }
+
+    int64_t played = 0;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        clip_append(&clip, buf, n);
+        played += n;
+        if (s_bytes_per_s) {
+            int64_t due_us = clip.start_us + played * 1000000 / (int64_t) s_bytes_per_s;
+            int64_t now_us = esp_timer_get_time();
+            if (due_us > now_us) {
+                usleep(due_us - now_us);
+            }
+        }
+    }
+    fclose(fp);
+    clip.end_us = esp_timer_get_time();
+
+    pthread_mutex_lock(&s_lock);
+    if (s_clip_count < FAKE_PLAYER_CLIPS_MAX) {
+        s_clips[s_clip_count++] = clip;
+    } else {
+        free(clip.data);
+    }
+    s_playing = false;
+    pthread_cond_broadcast(&s_idle);
+    pthread_mutex_unlock(&s_lock);
+
+    if (s_idle_cb) {
+        s_idle_cb();
+    }
+    return NULL;
+}
+
+void fake_player_start(size_t bytes_per_s, size_t probe_len, void (*idle_cb)(void))
+{
+    s_bytes_per_s = bytes_per_s;
+    s_probe_len = probe_len;
+    s_idle_cb = idle_cb;
+}
+
+void fake_player_stop(void)
+{
+    fake_player_wait_idle(-1);
+    if (s_joinable) {
+        pthread_join(s_thread, NULL);
+        s_joinable = false;
+    }
+    fake_player_clear();
+}
+
+audio_player_state_t audio_player_get_state(void)
+{
+    pthread_mutex_lock(&s_lock);
+    bool playing = s_playing;
+    pthread_mutex_unlock(&s_lock);
+    return playing ? AUDIO_PLAYER_STATE_PLAYING : AUDIO_PLAYER_STATE_IDLE;
+}
+
+esp_err_t audio_player_play(FILE *fp)
+{
+    if (!fp) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* The real player stops the current file first, here it has to end by itself */
+    fake_player_wait_idle(-1);
+    if (s_joinable) {
+        pthread_join(s_thread, NULL);
+        s_joinable = false;
+    }
+    pthread_mutex_lock(&s_lock);
+    s_playing = true;
+    pthread_mutex_unlock(&s_lock);
+    if (pthread_create(&s_thread, NULL, player_main, fp)) {
+        s_playing = false;
+        return ESP_FAIL;
+    }
+    s_joinable = true;
+    return ESP_OK;
+}
+
+bool fake_player_wait_idle(int timeout_ms)
+{
+    struct timespec deadline;
+    int err = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    pthread_mutex_lock(&s_lock);
+    while (s_playing && 0 == err) {
+        err = timeout_ms < 0 ? pthread_cond_wait(&s_idle, &s_lock) : pthread_cond_timedwait(&s_idle, &s_lock, &deadline);
+    }
+    bool idle = !s_playing;
+    pthread_mutex_unlock(&s_lock);
+    return idle;
+}
+
+size_t fake_player_clip_count(void)
+{
+    pthread_mutex_lock(&s_lock);
+    size_t count = s_clip_count;
+    pthread_mutex_unlock(&s_lock);
+    return count;
+}
+
+const fake_player_clip_t *fake_player_clip(size_t index)
+{
+    return index < fake_player_clip_count() ? &s_clips[index] : NULL;
+}
+
+void fake_player_clear(void)
+{
+    pthread_mutex_lock(&s_lock);
+    for (size_t i = 0; i < s_clip_count; i++) {
+        free(s_clips[i].data);
+    }
+    memset(s_clips, 0, sizeof(s_clips));
+    s_clip_count = 0;
+    pthread_mutex_unlock(&s_lock);
+}
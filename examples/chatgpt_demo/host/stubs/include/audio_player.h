@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* Player of fake_player.c, see fake_player.h */
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+
+typedef enum {
+    AUDIO_PLAYER_STATE_IDLE,
+    AUDIO_PLAYER_STATE_PLAYING,
+    AUDIO_PLAYER_STATE_PAUSE,
+    AUDIO_PLAYER_STATE_SHUTDOWN,
+} audio_player_state_t;
+
+audio_player_state_t audio_player_get_state(void);
+/* Takes the file, closed once played */
+esp_err_t audio_player_play(FILE *fp);
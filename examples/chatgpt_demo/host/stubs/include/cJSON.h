@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* The part of the cJSON API used by app_chat_stream.c and the mock server, see cjson_min.c */
+
+#pragma once
+
+#include <stdbool.h>
+
+#define cJSON_Invalid   (0)
+#define cJSON_False     (1 << 0)
+#define cJSON_True      (1 << 1)
+#define cJSON_NULL      (1 << 2)
+#define cJSON_Number    (1 << 3)
+#define cJSON_String    (1 << 4)
+#define cJSON_Array     (1 << 5)
+#define cJSON_Object    (1 << 6)
+
+typedef struct cJSON {
+    struct cJSON *next;
+    struct cJSON *child;
+    int type;
+    char *valuestring;
+    double valuedouble;
+    char *string;
+} cJSON;
+
+cJSON *cJSON_Parse(const char *value);
+void cJSON_Delete(cJSON *item);
+char *cJSON_PrintUnformatted(const cJSON *item);
+void cJSON_free(void *object);
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string);
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index);
+bool cJSON_IsString(const cJSON *item);
+bool cJSON_IsTrue(const cJSON *item);
+
+cJSON *cJSON_CreateObject(void);
+cJSON *cJSON_AddArrayToObject(cJSON *object, const char *name);
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string);
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number);
+cJSON *cJSON_AddTrueToObject(cJSON *object, const char *name);
+bool cJSON_AddItemToArray(cJSON *array, cJSON *item);
+bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item);
@@ -0,0 +1,35 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FAKE_PLAYER_CLIPS_MAX   32
+
+typedef struct {
+    uint8_t *data;          /*!< Everything the player read after its probe */
+    size_t len;
+    int64_t start_us;
+    int64_t end_us;
+    bool probe_rewound;     /*!< The seek back to 0 after the format probe worked */
+} fake_player_clip_t;
+
+/*
+ * Like esp-audio-player, the player reads a format probe, seeks back to the start and decodes from there. Reads are
+ * paced to `bytes_per_s` of playback, 0 for no pacing. `idle_cb` runs when a file ends, from the player thread.
+ */
+void fake_player_start(size_t bytes_per_s, size_t probe_len, void (*idle_cb)(void));
+void fake_player_stop(void);
+
+/* Waits until nothing plays, false on timeout */
+bool fake_player_wait_idle(int timeout_ms);
+
+size_t fake_player_clip_count(void);
+const fake_player_clip_t *fake_player_clip(size_t index);
+void fake_player_clear(void);
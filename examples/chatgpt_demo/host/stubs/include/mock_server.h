@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * In-process stand-in for the OpenAI endpoints, served through the esp_http_client calls:
+ *
+ *   audio/transcriptions   answers the multipart upload with a fixed transcription
+ *   chat/completions       streams the reply as server-sent events, a few characters per delta
+ *   audio/speech           returns a fake MP3 for the input, see mock_server_mp3()
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MOCK_SERVER_SENTENCES_MAX   32
+
+typedef struct {
+    const char *transcription;
+    const char *reply;              /*!< Text of the chat completion */
+    int chat_status;                /*!< 200 unless testing an error */
+    size_t delta_max;               /*!< Characters per delta, 1 to this at random, never inside a UTF-8 character */
+    int delta_delay_ms;             /*!< Time between two events */
+    size_t chunk_max;               /*!< Bytes per ON_DATA event, 1 to this at random, across event boundaries */
+    bool crlf;                      /*!< Lines end with \r\n */
+    bool comments;                  /*!< Keep-alive comments and an overlong unknown line between the events */
+    int drop_after_events;          /*!< The connection breaks after this many events, 0 never */
+    int tts_fail_sentence;          /*!< 1-based speech request answered with status 500, 0 none */
+    size_t tts_bytes_per_char;      /*!< MP3 size per input character */
+    size_t tts_bytes_per_s;         /*!< Download rate of the speech, 0 unthrottled */
+    int tts_delay_ms;               /*!< Time to the first byte of speech */
+    uint32_t seed;
+} mock_server_cfg_t;
+
+typedef struct {
+    int chat_requests;
+    bool chat_stream_requested;     /*!< The request body asked for "stream": true */
+    int64_t chat_done_us;           /*!< When the last event was sent */
+    int tts_connections;            /*!< Clients created for speech, one per TLS handshake */
+    size_t sentence_count;
+    char *sentences[MOCK_SERVER_SENTENCES_MAX];
+    char *upload;                   /*!< Multipart body of the last transcription */
+    size_t upload_len;
+} mock_server_log_t;
+
+void mock_server_start(const mock_server_cfg_t *cfg);
+void mock_server_stop(void);
+const mock_server_log_t *mock_server_log(void);
+
+/* The MP3 the server returns for `sentence`, to be freed by the caller */
+uint8_t *mock_server_mp3(const char *sentence, size_t bytes_per_char, size_t *len);
@@ -0,0 +1,423 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * esp_http_client answered in process, see mock_server.h. The response bodies reach the event handler the way the
+ * real client hands them over: in pieces of arbitrary size that know nothing about lines or events.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "cJSON.h"
+#include "esp_crt_bundle.h"
+#include "esp_http_client.h"
+#include "esp_timer.h"
+#include "mock_server.h"
+
+#define MOCK_TTS_CHUNK      (1024)
+#define MOCK_LONG_LINE      (3000)  // past SSE_LINE_MAX of the client
+
+typedef enum {
+    MOCK_ROUTE_NONE = 0,
+    MOCK_ROUTE_STT,
+    MOCK_ROUTE_CHAT,
+    MOCK_ROUTE_TTS,
+} mock_route_t;
+
+struct esp_http_client {
+    esp_http_client_config_t config;
+    mock_route_t route;
+    uint32_t rng;
+    int status;
+    const char *post;
+    int post_len;
+    char *upload;
+    size_t upload_len;
+    char *resp;
+    size_t resp_len;
+    size_t resp_pos;
+};
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t size;
+} mock_text_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static mock_server_cfg_t s_cfg;
+static mock_server_log_t s_log;
+static uint32_t s_rng = 1;
+
+static uint32_t mock_rand(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static size_t mock_rand_len(uint32_t *state, size_t max)
+{
+    return max > 1 ? 1 + mock_rand(state) % max : 1;
+}
+
+static void mock_sleep_ms(int ms)
+{
+    if (ms > 0) {
+        usleep(ms * 1000);
+    }
+}
+
+static void text_append(mock_text_t *text, const char *data, size_t len)
+{
+    if (text->len + len + 1 > text->size) {
+        text->size = (text->len + len + 1) * 2;
+        text->data = realloc(text->data, text->size);
+    }
+    memcpy(text->data + text->len, data, len);
+    text->len += len;
+    text->data[text->len] = '\0';
+}
+
+static void text_line(mock_text_t *text, const char *line)
+{
+    text_append(text, line, strlen(line));
+    text_append(text, s_cfg.crlf ? "\r\n" : "\n", s_cfg.crlf ? 2 : 1);
+}
+
+static esp_err_t mock_deliver(esp_http_client_handle_t client, const char *data, size_t len)
+{
+    esp_http_client_event_t evt = {
+        .event_id = HTTP_EVENT_ON_DATA,
+        .client = client,
+        .data = (void *) data,
+        .data_len = (int) len,
+        .user_data = client->config.user_data,
+    };
+    return client->config.event_handler ? client->config.event_handler(&evt) : ESP_OK;
+}
+
+uint8_t *mock_server_mp3(const char *sentence, size_t bytes_per_char, size_t *len)
+{
+    uint32_t state = 2166136261u;
+    size_t n = strlen(sentence) * bytes_per_char;
+
+    /* FNV-1a of the sentence seeds the frames, each sentence has its own bytes */
+    for (const char *p = sentence; *p; p++) {
+        state = (state ^ (uint8_t) * p) * 16777619u;
+    }
+    state = state ? state : 1;
+    n = n < 4 ? 4 : n;
+    uint8_t *mp3 = malloc(n);
+    if (!mp3) {
+        return NULL;
+    }
+    memcpy(mp3, "ID3\x04", 4);
+    for (size_t i = 4; i < n; i++) {
+        mp3[i] = (uint8_t) mock_rand(&state);
+    }
+    *len = n;
+    return mp3;
+}
+
+/* The reply cut into deltas of a few characters, as the model streams it, each one a complete event */
+static void chat_events(uint32_t *rng, mock_text_t *stream, size_t *ends, size_t *count, size_t max)
+{
+    const char *reply = s_cfg.reply ? s_cfg.reply : "";
+    size_t len = strlen(reply);
+    size_t pos = 0;
+
+    *count = 0;
+    while (pos < len && *count < max - 1) {
+        size_t n = mock_rand_len(rng, s_cfg.delta_max);
+        n = pos + n > len ? len - pos : n;
+        while (pos + n < len && 0x80 == ((uint8_t) reply[pos + n] & 0xC0)) {
+            n++;
+        }
+
+        cJSON *root = cJSON_CreateObject();
+        cJSON *choices = cJSON_AddArrayToObject(root, "choices");
+        cJSON *choice = cJSON_CreateObject();
+        cJSON_AddItemToArray(choices, choice);
+        cJSON *delta = cJSON_CreateObject();
+        cJSON_AddItemToObject(choice, "delta", delta);
+        char *content = strndup(reply + pos, n);
+        cJSON_AddStringToObject(delta, "content", content);
+        free(content);
+        char *json = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+
+        if (s_cfg.comments && 0 == *count % 3) {
+            text_line(stream, ": keep-alive");
+            if (0 == *count % 9) {
+                char *line = malloc(MOCK_LONG_LINE + 1);
+                memcpy(line, "x-pad: ", 7);
+                memset(line + 7, 'x', MOCK_LONG_LINE - 7);
+                line[MOCK_LONG_LINE] = '\0';
+                text_line(stream, line);
+                free(line);
+            }
+        }
+        text_append(stream, "data: ", 6);
+        text_line(stream, json);
+        text_line(stream, "");
+        cJSON_free(json);
+
+        ends[(*count)++] = stream->len;
+        pos += n;
+    }
+    text_line(stream, "data: [DONE]");
+    text_line(stream, "");
+    ends[(*count)++] = stream->len;
+}
+
+static esp_err_t chat_perform(esp_http_client_handle_t client)
+{
+    esp_err_t ret = ESP_OK;
+    mock_text_t stream = { 0 };
+    size_t ends_max = (s_cfg.reply ? strlen(s_cfg.reply) : 0) + 2;
+    size_t *ends = calloc(ends_max, sizeof(size_t));
+    size_t count = 0;
+
+    cJSON *request = cJSON_Parse(client->post);
+    pthread_mutex_lock(&s_lock);
+    s_log.chat_requests++;
+    s_log.chat_stream_requested = cJSON_IsTrue(cJSON_GetObjectItem(request, "stream"));
+    pthread_mutex_unlock(&s_lock);
+    cJSON_Delete(request);
+
+    client->status = s_cfg.chat_status ? s_cfg.chat_status : 200;
+    if (200 != client->status) {
+        const char *error = "{\"error\":{\"message\":\"mock failure\"}}";
+        mock_deliver(client, error, strlen(error));
+        free(ends);
+        return ESP_OK;
+    }
+
+    chat_events(&client->rng, &stream, ends, &count, ends_max);
+    size_t total = stream.len;
+    if (s_cfg.drop_after_events && (size_t) s_cfg.drop_after_events < count) {
+        /* Broken halfway through the next event */
+        size_t start = ends[s_cfg.drop_after_events - 1];
+        total = start + (ends[s_cfg.drop_after_events] - start) / 2;
+        ret = ESP_ERR_HTTP_CONNECT;
+    }
+
+    size_t pos = 0;
+    size_t event = 0;
+    while (pos < total) {
+        size_t n = mock_rand_len(&client->rng, s_cfg.chunk_max);
+        n = pos + n > total ? total - pos : n;
+        mock_deliver(client, stream.data + pos, n);
+        pos += n;
+        while (event < count && ends[event] <= pos) {
+            event++;
+            mock_sleep_ms(s_cfg.delta_delay_ms);
+        }
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_log.chat_done_us = esp_timer_get_time();
+    pthread_mutex_unlock(&s_lock);
+    free(stream.data);
+    free(ends);
+    return ret;
+}
+
+static esp_err_t tts_perform(esp_http_client_handle_t client)
+{
+    size_t index = 0;
+    cJSON *request = cJSON_Parse(client->post);
+    cJSON *input = cJSON_GetObjectItem(request, "input");
+    char *sentence = strdup(cJSON_IsString(input) ? input->valuestring : "");
+    cJSON_Delete(request);
+
+    pthread_mutex_lock(&s_lock);
+    if (s_log.sentence_count < MOCK_SERVER_SENTENCES_MAX) {
+        s_log.sentences[s_log.sentence_count] = strdup(sentence);
+    }
+    index = ++s_log.sentence_count;
+    pthread_mutex_unlock(&s_lock);
+
+    mock_sleep_ms(s_cfg.tts_delay_ms);
+    if ((int) index == s_cfg.tts_fail_sentence) {
+        const char *error = "{\"error\":{\"message\":\"mock speech failure\"}}";
+        client->status = 500;
+        mock_deliver(client, error, strlen(error));
+        free(sentence);
+        return ESP_OK;
+    }
+
+    size_t len = 0;
+    uint8_t *mp3 = mock_server_mp3(sentence, s_cfg.tts_bytes_per_char, &len);
+    free(sentence);
+    if (!mp3) {
+        return ESP_ERR_NO_MEM;
+    }
+    client->status = 200;
+    int64_t start_us = esp_timer_get_time();
+    for (size_t pos = 0; pos < len; pos += MOCK_TTS_CHUNK) {
+        size_t n = len - pos < MOCK_TTS_CHUNK ? len - pos : MOCK_TTS_CHUNK;
+        if (s_cfg.tts_bytes_per_s) {
+            int64_t due_us = start_us + (int64_t) pos * 1000000 / (int64_t) s_cfg.tts_bytes_per_s;
+            int64_t now_us = esp_timer_get_time();
+            if (due_us > now_us) {
+                usleep(due_us - now_us);
+            }
+        }
+        mock_deliver(client, (const char *) mp3 + pos, n);
+    }
+    free(mp3);
+    return ESP_OK;
+}
+
+esp_err_t esp_crt_bundle_attach(void *conf)
+{
+    return ESP_OK;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    esp_http_client_handle_t client = calloc(1, sizeof(struct esp_http_client));
+    if (!client) {
+        return NULL;
+    }
+    client->config = *config;
+    if (strstr(config->url, "audio/transcriptions")) {
+        client->route = MOCK_ROUTE_STT;
+    } else if (strstr(config->url, "chat/completions")) {
+        client->route = MOCK_ROUTE_CHAT;
+    } else if (strstr(config->url, "audio/speech")) {
+        client->route = MOCK_ROUTE_TTS;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    client->rng = mock_rand(&s_rng);
+    if (MOCK_ROUTE_TTS == client->route) {
+        s_log.tts_connections++;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return client;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    free(client->upload);
+    free(client->resp);
+    free(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    client->post = data;
+    client->post_len = len;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    switch (client->route) {
+    case MOCK_ROUTE_CHAT:
+        return chat_perform(client);
+    case MOCK_ROUTE_TTS:
+        return tts_perform(client);
+    default:
+        client->status = 404;
+        return ESP_OK;
+    }
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+    if (MOCK_ROUTE_STT != client->route) {
+        return ESP_ERR_HTTP_CONNECT;
+    }
+    client->upload = malloc(write_len > 0 ? write_len : 1);
+    client->upload_len = 0;
+    return client->upload ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+int esp_http_client_write(esp_http_client_handle_t client, const char *buffer, int len)
+{
+    if (len <= 0) {
+        return 0;
+    }
+    /* Short writes, the caller has to loop */
+    size_t n = mock_rand_len(&client->rng, len);
+    memcpy(client->upload + client->upload_len, buffer, n);
+    client->upload_len += n;
+    return (int) n;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+    pthread_mutex_lock(&s_lock);
+    free(s_log.upload);
+    s_log.upload = client->upload;
+    s_log.upload_len = client->upload_len;
+    pthread_mutex_unlock(&s_lock);
+    client->upload = NULL;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "text", s_cfg.transcription ? s_cfg.transcription : "");
+    client->resp = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    client->resp_len = client->resp ? strlen(client->resp) : 0;
+    client->resp_pos = 0;
+    client->status = 200;
+    return (int64_t) client->resp_len;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer, int len)
+{
+    size_t n = client->resp_len - client->resp_pos;
+    n = (size_t) len < n ? (size_t) len : n;
+    memcpy(buffer, client->resp + client->resp_pos, n);
+    client->resp_pos += n;
+    return (int) n;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client->status;
+}
+
+void mock_server_start(const mock_server_cfg_t *cfg)
+{
+    mock_server_stop();
+    pthread_mutex_lock(&s_lock);
+    s_cfg = *cfg;
+    s_rng = cfg->seed ? cfg->seed : 1;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void mock_server_stop(void)
+{
+    pthread_mutex_lock(&s_lock);
+    for (size_t i = 0; i < s_log.sentence_count && i < MOCK_SERVER_SENTENCES_MAX; i++) {
+        free(s_log.sentences[i]);
+    }
+    free(s_log.upload);
+    memset(&s_log, 0, sizeof(s_log));
+    pthread_mutex_unlock(&s_lock);
+}
+
+const mock_server_log_t *mock_server_log(void)
+{
+    return &s_log;
+}
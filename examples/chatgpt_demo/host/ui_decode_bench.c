@@ -0,0 +1,215 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * The "\n" decoder of the reply label, app_ui_text.c, against the loop app_ui_ctrl.c had before, which called
+ * strlen() twice per character. Replies of several sizes with escapes and multibyte text are decoded whole, and also
+ * the way they are streamed: one sentence at a time, where the old code decoded and set the whole reply again on
+ * every sentence and the new one decodes only the sentence appended.
+ *
+ * Exits with 1 when the two decoders disagree on any input, or when a text decoded in two chunks, split anywhere,
+ * differs from the text decoded whole.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "app_ui_text.h"
+
+#define SENTENCE_LEN        (120)
+#define BENCH_MIN_US        (200000)
+#define STREAMED_MAX        (16 * 1024)     // The old code takes seconds for a streamed 64 KB reply
+
+static const char *const s_edge_cases[] = {
+    "", "\\", "n", "\\n", "\\\\n", "\\n\\n", "a\\", "a\\nb\\", "\\\\", "x\\ny\\tz", "\xe4\xbd\xa0\\n\xe5\xa5\xbd",
+};
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* app_ui_ctrl.c before the decoder was rewritten */
+static size_t old_decode(char *decode, const char *text)
+{
+    int j = 0;
+    for (int i = 0; i < (int) strlen(text);) {
+        if ((*(text + i) == '\\') && ((i + 1) < (int) strlen(text)) && (*(text + i + 1) == 'n')) {
+            *(decode + j++) = '\n';
+            i += 2;
+        } else {
+            *(decode + j++) = *(text + i);
+            i += 1;
+        }
+    }
+    *(decode + j) = '\0';
+    return j;
+}
+
+/* Words, an escaped line break now and then, some of it in Chinese */
+static char *gen_reply(size_t len, uint32_t *rng)
+{
+    static const char *const words[] = {
+        "the ", "board ", "speaker ", "volume ", "\\n", "\\n\\n", "- ", "\xe4\xbd\xa0\xe5\xa5\xbd ", "1. ", "ESP32-S3 ",
+    };
+    char *text = malloc(len + 1);
+    size_t pos = 0;
+
+    while (pos < len) {
+        const char *w = words[xorshift32(rng) % (sizeof(words) / sizeof(words[0]))];
+        size_t n = strlen(w);
+        if (pos + n > len) {
+            memset(text + pos, '.', len - pos);
+            pos = len;
+        } else {
+            memcpy(text + pos, w, n);
+            pos += n;
+        }
+    }
+    text[len] = '\0';
+    return text;
+}
+
+static bool same(const char *text, char *a, char *b)
+{
+    size_t na = old_decode(a, text);
+    size_t nb = app_ui_text_decode(b, text);
+    return na == nb && !memcmp(a, b, na + 1);
+}
+
+/* Every split into two chunks, as SSE deltas cut the text, gives the whole decoded text, a final lone '\' aside */
+static bool same_split(const char *text)
+{
+    size_t len = strlen(text);
+    char *whole = malloc(len + 1);
+    char *first = malloc(len + 1);
+    char *joined = malloc(len + 3);
+    bool ok = true;
+
+    size_t n = app_ui_text_decode(whole, text);
+    if (len && '\\' == text[len - 1]) {
+        whole[--n] = '\0';
+    }
+    for (size_t cut = 0; cut <= len && ok; cut++) {
+        app_ui_text_stream_t stream = {0};
+        memcpy(first, text, cut);
+        first[cut] = '\0';
+        size_t m = app_ui_text_decode_chunk(&stream, joined, first);
+        m += app_ui_text_decode_chunk(&stream, joined + m, text + cut);
+        ok = m == n && !memcmp(joined, whole, n + 1);
+    }
+    free(joined);
+    free(first);
+    free(whole);
+    return ok;
+}
+
+/* Average over enough runs to take at least BENCH_MIN_US */
+static double time_whole(size_t (*decode)(char *, const char *), char *dst, const char *text)
+{
+    double start = now_us();
+    int runs = 0;
+    double elapsed;
+
+    do {
+        decode(dst, text);
+        runs++;
+        elapsed = now_us() - start;
+    } while (elapsed < BENCH_MIN_US);
+    return elapsed / runs;
+}
+
+/* Total decode time over a reply arriving SENTENCE_LEN bytes at a time */
+static double time_streamed(bool old, char *dst, char *text, size_t len)
+{
+    double start = now_us();
+    int runs = 0;
+    double elapsed;
+
+    do {
+        app_ui_text_stream_t stream = {0};
+        for (size_t end = SENTENCE_LEN; end < len + SENTENCE_LEN; end += SENTENCE_LEN) {
+            size_t stop = end < len ? end : len;
+            char saved = text[stop];
+            text[stop] = '\0';
+            if (old) {
+                old_decode(dst, text);
+            } else {
+                app_ui_text_decode_chunk(&stream, dst, text + end - SENTENCE_LEN);
+            }
+            text[stop] = saved;
+        }
+        runs++;
+        elapsed = now_us() - start;
+    } while (elapsed < BENCH_MIN_US);
+    return elapsed / runs;
+}
+
+int main(void)
+{
+    static const size_t sizes[] = {1024, 4096, 16 * 1024, 64 * 1024};
+    char a[16];
+    char b[16];
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(s_edge_cases) / sizeof(s_edge_cases[0]); i++) {
+        if (!same(s_edge_cases[i], a, b)) {
+            printf("FAIL edge case %zu: \"%s\" decodes to \"%s\", expected \"%s\"\n", i, s_edge_cases[i], b, a);
+            failed++;
+        }
+        if (!same_split(s_edge_cases[i])) {
+            printf("FAIL edge case %zu: \"%s\" decodes differently in two chunks\n", i, s_edge_cases[i]);
+            failed++;
+        }
+    }
+
+    printf("%-8s %12s %12s %16s %16s\n", "reply", "old us", "new us", "old streamed us", "new streamed us");
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        uint32_t rng = 4321 + s;
+        char *text = gen_reply(sizes[s], &rng);
+        char *old_out = malloc(sizes[s] + 1);
+        char *new_out = malloc(sizes[s] + 1);
+
+        if (!same(text, old_out, new_out)) {
+            printf("FAIL %zu KB reply decoded differently\n", sizes[s] / 1024);
+            failed++;
+        }
+        if (sizes[s] <= STREAMED_MAX / 4 && !same_split(text)) {
+            printf("FAIL %zu KB reply decoded differently in two chunks\n", sizes[s] / 1024);
+            failed++;
+        }
+        double old_us = time_whole(old_decode, old_out, text);
+        double new_us = time_whole(app_ui_text_decode, new_out, text);
+        printf("%5zu KB %12.1f %12.1f", sizes[s] / 1024, old_us, new_us);
+        if (sizes[s] <= STREAMED_MAX) {
+            double old_stream_us = time_streamed(true, old_out, text, sizes[s]);
+            double new_stream_us = time_streamed(false, new_out, text, sizes[s]);
+            printf(" %16.0f %16.1f\n", old_stream_us, new_stream_us);
+        } else {
+            printf(" %16s %16s\n", "-", "-");
+        }
+        free(new_out);
+        free(old_out);
+        free(text);
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
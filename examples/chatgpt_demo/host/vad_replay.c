@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Synthetic AFE VAD traces replayed through app_vad.c, one 32 ms frame at a time as audio_detect_task feeds them,
+ * with the settings of app_audio.c and the Kconfig defaults. Each turn starts at the wake word, the wake prompt plays
+ * for the first second. For comparison the old rule runs on the same trace: the turn ended after 100 more identical
+ * silence frames, and the whole recording from the wake word on was uploaded.
+ *
+ * Exits with 1 when speech heard after the prompt and held by the recording buffer falls outside the uploaded range,
+ * when a turn ends later than the hangover after the last speech, or when silence is uploaded.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "app_audio.h"
+#include "app_vad.h"
+
+#define SAMPLE_RATE         (16000)
+#define FRAME_SAMPLES       (512)
+#define FRAME_MS            (FRAME_SAMPLES * 1000 / SAMPLE_RATE)
+#define PROMPT_MS           (1000)
+#define TRACE_MS            (20000)
+#define CAPACITY            ((FILE_SIZE - sizeof(wav_header_t)) / sizeof(int16_t))
+#define OLD_KEEP_FRAMES     (100)
+
+/* Kconfig defaults and RECORD_TAIL_MS */
+#define HANGOVER_MS         (800)
+#define PREROLL_MS          (300)
+#define TAIL_MS             (150)
+#define MAX_SPEECH_MS       (8000)
+#define NO_SPEECH_MS        (4000)
+
+typedef struct {
+    bool speech;
+    int ms;
+} segment_t;
+
+typedef struct {
+    const char *name;
+    segment_t segments[8];      /*!< From the wake word on, silence after the last one */
+    int flicker_per_mille;      /*!< Silence frames the VAD takes for speech, and the other way round */
+} scenario_t;
+
+typedef struct {
+    bool ended;
+    uint32_t end;               /*!< Samples from the wake word to the end of the turn */
+    bool upload;
+    uint32_t start;             /*!< Uploaded range */
+    uint32_t stop;
+    app_vad_result_t result;
+} turn_t;
+
+static const scenario_t s_scenarios[] = {
+    {"short question", {{false, 1400}, {true, 1500}}, 0},
+    {"pauses in speech", {{false, 1200}, {true, 1200}, {false, 600}, {true, 2000}, {false, 500}, {true, 1000}}, 0},
+    {"late start", {{false, 2800}, {true, 1500}}, 0},
+    {"silence only", {{false, 0}}, 0},
+    {"flickering vad", {{false, 1300}, {true, 2500}, {false, 400}, {true, 800}}, 15},
+    {"monologue", {{false, 1200}, {true, 12000}}, 0},
+    {"speech over prompt", {{true, 900}, {false, 500}, {true, 1500}}, 0},
+};
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* What the user says in the frame ending at this many ms, before the VAD gets it wrong */
+static bool scenario_speech(const scenario_t *sc, int ms)
+{
+    int t = 0;
+    for (size_t i = 0; i < sizeof(sc->segments) / sizeof(sc->segments[0]) && sc->segments[i].ms; i++) {
+        t += sc->segments[i].ms;
+        if (ms <= t) {
+            return sc->segments[i].speech;
+        }
+    }
+    return false;
+}
+
+static bool vad_frame(const scenario_t *sc, int frame, uint32_t *rng)
+{
+    bool speech = scenario_speech(sc, (frame + 1) * FRAME_MS);
+    if (sc->flicker_per_mille && (int)(xorshift32(rng) % 1000) < sc->flicker_per_mille) {
+        speech = !speech;
+    }
+    return speech;
+}
+
+static turn_t run_new(const scenario_t *sc)
+{
+    app_vad_cfg_t cfg = {
+        .sample_rate = SAMPLE_RATE,
+        .hangover_ms = HANGOVER_MS,
+        .preroll_ms = PREROLL_MS,
+        .tail_ms = TAIL_MS,
+        .max_speech_ms = MAX_SPEECH_MS,
+        .no_speech_ms = NO_SPEECH_MS,
+        .capacity = CAPACITY,
+    };
+    app_vad_t vad;
+    turn_t turn = { 0 };
+    uint32_t rng = 1;
+
+    app_vad_reset(&vad, &cfg);
+    for (int frame = 0; frame * FRAME_MS < TRACE_MS; frame++) {
+        uint32_t end = (frame + 1) * FRAME_SAMPLES;
+        if (frame * FRAME_MS >= PROMPT_MS) {
+            app_vad_listen(&vad, frame * FRAME_SAMPLES);
+        }
+        app_vad_result_t result = app_vad_process(&vad, vad_frame(sc, frame, &rng), end, FRAME_SAMPLES);
+        if (APP_VAD_CONTINUE != result) {
+            turn.ended = true;
+            turn.end = end;
+            turn.result = result;
+            break;
+        }
+    }
+    turn.upload = app_vad_get_range(&vad, &turn.start, &turn.stop);
+    return turn;
+}
+
+/* The rule app_sr.c used before: 100 more frames of the same state, and that state silence */
+static turn_t run_old(const scenario_t *sc)
+{
+    turn_t turn = { 0 };
+    int keep = 0;
+    bool last = false;
+    uint32_t rng = 1;
+
+    for (int frame = 0; frame * FRAME_MS < TRACE_MS; frame++) {
+        bool speech = vad_frame(sc, frame, &rng);
+        uint32_t end = (frame + 1) * FRAME_SAMPLES;
+        if (0 == frame || speech != last) {
+            last = speech;
+            keep = 0;
+        } else {
+            keep++;
+        }
+        if ((OLD_KEEP_FRAMES == keep && !speech) || end >= CAPACITY) {
+            turn.ended = true;
+            turn.end = end;
+            break;
+        }
+    }
+    turn.upload = true;
+    turn.start = 0;
+    turn.stop = turn.end < CAPACITY ? turn.end : CAPACITY;
+    return turn;
+}
+
+static bool check(const scenario_t *sc, const turn_t *turn)
+{
+    uint32_t listen = PROMPT_MS * SAMPLE_RATE / 1000;
+    uint32_t last_speech = 0;
+    bool ok = true;
+
+    for (int frame = 0; (uint32_t)(frame + 1) * FRAME_SAMPLES <= turn->end; frame++) {
+        uint32_t start = frame * FRAME_SAMPLES;
+        uint32_t end = start + FRAME_SAMPLES < CAPACITY ? start + FRAME_SAMPLES : CAPACITY;
+        if (start < listen || !scenario_speech(sc, (frame + 1) * FRAME_MS)) {
+            continue;
+        }
+        last_speech = end;
+        if (!turn->upload || start < turn->start || end > turn->stop) {
+            printf("FAIL %s: speech at %u ms not uploaded\n", sc->name, start * 1000 / SAMPLE_RATE);
+            ok = false;
+            break;
+        }
+    }
+    if (!turn->ended) {
+        printf("FAIL %s: the turn never ended\n", sc->name);
+        ok = false;
+    }
+    if (last_speech && APP_VAD_END_SILENCE == turn->result &&
+            turn->end > last_speech + (HANGOVER_MS + 2 * FRAME_MS) * SAMPLE_RATE / 1000 && !sc->flicker_per_mille) {
+        printf("FAIL %s: ended %u ms after the last speech\n", sc->name, (turn->end - last_speech) * 1000 / SAMPLE_RATE);
+        ok = false;
+    }
+    if (!last_speech && turn->upload && !sc->flicker_per_mille) {
+        printf("FAIL %s: silence uploaded\n", sc->name);
+        ok = false;
+    }
+    return ok;
+}
+
+static const char *result_name(app_vad_result_t result)
+{
+    switch (result) {
+    case APP_VAD_END_SILENCE:
+        return "silence";
+    case APP_VAD_END_MAX:
+        return "max length";
+    case APP_VAD_NO_SPEECH:
+        return "no speech";
+    default:
+        return "-";
+    }
+}
+
+static double kb(const turn_t *turn)
+{
+    return turn->upload ? (turn->stop - turn->start) * sizeof(int16_t) / 1024.0 : 0;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("%-20s %-11s %8s %8s %10s %10s\n", "scenario", "endpoint", "end s", "old s", "upload KB", "old KB");
+    for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        const scenario_t *sc = &s_scenarios[i];
+        turn_t turn = run_new(sc);
+        turn_t old = run_old(sc);
+
+        printf("%-20s %-11s %8.1f %8.1f %10.0f %10.0f\n", sc->name, result_name(turn.result),
+               turn.end / (double) SAMPLE_RATE, old.end / (double) SAMPLE_RATE, kb(&turn), kb(&old));
+        failed += !check(sc, &turn);
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
@@ -5,10 +5,12 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include "freertos/event_groups.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_task_wdt.h"
 #include "esp_check.h"
 #include "esp_err.h"
@@ -19,6 +21,9 @@
 #include "esp_vfs.h"
 #include "app_sr.h"
 #include "app_audio.h"
+#include "app_chat_stream.h"
+#include "app_vad.h"
+#include "app_flac.h"
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "audio_player.h"
@@ -26,6 +31,19 @@
 #include "app_ui_ctrl.h"
 #include "app_wifi.h"
 
+#define RECORD_SAMPLE_RATE      (16000)
+#define RECORD_CHANNELS         (PCM_ONE_CHANNEL ? 1 : 2)
+#define RECORD_CAPACITY         ((FILE_SIZE - sizeof(wav_header_t)) / sizeof(int16_t) / RECORD_CHANNELS)
+#define RECORD_TAIL_MS          (150)
+
+#if defined(CONFIG_SPEECH_UPLOAD_FLAC) && PCM_ONE_CHANNEL
+#define RECORD_FLAC             (1)
+#define RECORD_FORMAT           "flac"
+#else
+#define RECORD_FLAC             (0)
+#define RECORD_FORMAT           "wav"
+#endif
+
 static const char *TAG = "app_audio";
 
 #if !CONFIG_BSP_BOARD_ESP32_S3_BOX_Lite
@@ -35,11 +53,24 @@ bool record_flag = false;
 uint32_t record_total_len = 0;
 uint32_t file_total_len = 0;
 static uint8_t *record_audio_buffer = NULL;
-uint8_t *audio_rx_buffer = NULL;
+static uint8_t *record_upload = NULL;       // the file sent for transcription, in front of the PCM for WAV
 audio_play_finish_cb_t audio_play_finish_cb = NULL;
 
+static app_vad_t record_vad;
+static portMUX_TYPE record_vad_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t fed_samples = 0;   // samples fed to the AFE, the clock VAD frames are placed on
+static uint32_t record_start_sample = 0;
+
+#if RECORD_FLAC
+static app_flac_enc_t *record_flac = NULL;
+static SemaphoreHandle_t record_flac_lock = NULL;
+static uint32_t record_flac_pos = 0;        // next sample to encode
+static bool record_flac_started = false;
+static bool record_flac_done = false;
+#endif
+
 extern sr_data_t *g_sr_data;
-extern esp_err_t start_openai(uint8_t *audio, int audio_len);
+extern esp_err_t start_openai(uint8_t *audio, int audio_len, const char *format);
 extern int Cache_WriteBack_Addr(uint32_t addr, uint32_t size);
 
 /* main function */
@@ -115,12 +146,18 @@ void audio_record_init()
     record_audio_buffer = heap_caps_calloc(1, FILE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     assert(record_audio_buffer);
     printf("successfully created record_audio_buffer with a size: %zu\n", FILE_SIZE);
-    audio_rx_buffer = heap_caps_calloc(1, MAX_FILE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-    assert(audio_rx_buffer);
-    printf("audio_rx_buffer with a size: %zu\n", MAX_FILE_SIZE);
+#if RECORD_FLAC
+    /* FLAC is never larger than the PCM it comes from, give or take its headers */
+    record_upload = heap_caps_calloc(1, FILE_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    record_flac = heap_caps_calloc(1, sizeof(app_flac_enc_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    record_flac_lock = xSemaphoreCreateMutex();
+    assert(record_upload && record_flac && record_flac_lock);
+#else
+    record_upload = record_audio_buffer;
+#endif
 #endif
 
-    if (record_audio_buffer == NULL || audio_rx_buffer == NULL) {
+    if (record_audio_buffer == NULL || record_upload == NULL) {
         printf("Error: Failed to allocate memory for buffers\n");
         return; // Return or handle the error condition appropriately
     }
@@ -143,8 +180,8 @@ void audio_record_save(int16_t *audio_buffer, int audio_chunksize)
     if (record_flag) {
         uint16_t *record_buff = (uint16_t *)(record_audio_buffer + sizeof(wav_header_t));
         record_buff += record_total_len;
-        for (int i = 0; i < (audio_chunksize - 1); i++) {
-            if (record_total_len < (MAX_FILE_SIZE - sizeof(wav_header_t)) / 2) {
+        for (int i = 0; i < audio_chunksize; i++) {
+            if (record_total_len < RECORD_CAPACITY * RECORD_CHANNELS) {
 #if PCM_ONE_CHANNEL
                 record_buff[ i * 1 + 0] = audio_buffer[i * 3 + 0];
                 record_total_len += 1;
@@ -157,6 +194,7 @@ void audio_record_save(int16_t *audio_buffer, int audio_chunksize)
         }
     }
 #endif
+    fed_samples += audio_chunksize;
 }
 
 void audio_register_play_finish_cb(audio_play_finish_cb_t cb)
@@ -168,58 +206,167 @@ static void audio_record_start()
 {
 #if DEBUG_SAVE_PCM
     ESP_LOGI(TAG, "### record Start");
+    app_chat_stream_abort();
     audio_player_stop();
 
-    record_flag = true;
+    app_vad_cfg_t vad_cfg = {
+        .sample_rate = RECORD_SAMPLE_RATE,
+        .hangover_ms = CONFIG_VAD_HANGOVER_MS,
+        .preroll_ms = CONFIG_VAD_PREROLL_MS,
+        .tail_ms = RECORD_TAIL_MS,
+        .max_speech_ms = CONFIG_VAD_MAX_SPEECH_MS,
+        .no_speech_ms = CONFIG_VAD_NO_SPEECH_MS,
+        .capacity = RECORD_CAPACITY,
+    };
+    taskENTER_CRITICAL(&record_vad_lock);
+    app_vad_reset(&record_vad, &vad_cfg);
     record_total_len = 0;
+    record_start_sample = fed_samples;
+    record_flag = true;
+    taskEXIT_CRITICAL(&record_vad_lock);
     file_total_len = sizeof(wav_header_t);
+#if RECORD_FLAC
+    xSemaphoreTake(record_flac_lock, portMAX_DELAY);
+    record_flac_started = false;
+    record_flac_done = false;
+    xSemaphoreGive(record_flac_lock);
+#endif
 #endif
 }
 
-static esp_err_t audio_record_stop()
+/* The wake prompt is over, what the microphone hears from now on is the user */
+static void audio_record_listen()
 {
-    esp_err_t ret = ESP_OK;
-#if DEBUG_SAVE_PCM
-    record_flag = false;
-#if PCM_ONE_CHANNEL
-    record_total_len *= 1;
+    taskENTER_CRITICAL(&record_vad_lock);
+    app_vad_listen(&record_vad, fed_samples - record_start_sample);
+    taskEXIT_CRITICAL(&record_vad_lock);
+}
+
+#if RECORD_FLAC
+/*
+ * Encode the speech in [start, end) that is recorded, block by block, so most of the work is done while the
+ * user is still speaking. Only the last call may encode a short block, it also closes the stream.
+ */
+static void audio_record_encode(uint32_t start, uint32_t end, bool last)
+{
+    const int16_t *pcm = (const int16_t *)(record_audio_buffer + sizeof(wav_header_t));
+    uint32_t recorded = record_total_len;
+
+    end = end < recorded ? end : recorded;
+    xSemaphoreTake(record_flac_lock, portMAX_DELAY);
+    if (!record_flac_done) {
+        if (!record_flac_started) {
+            app_flac_enc_init(record_flac, RECORD_SAMPLE_RATE, record_upload, FILE_SIZE);
+            record_flac_pos = start;
+            record_flac_started = true;
+        }
+        while (record_flac_pos < end) {
+            uint32_t num = end - record_flac_pos;
+            num = num < APP_FLAC_BLOCK_SIZE ? num : APP_FLAC_BLOCK_SIZE;
+            if ((num < APP_FLAC_BLOCK_SIZE && !last) || !app_flac_enc_block(record_flac, pcm + record_flac_pos, num)) {
+                break;
+            }
+            record_flac_pos += num;
+        }
+        if (last) {
+            file_total_len = app_flac_enc_finish(record_flac);
+            record_flac_done = true;
+        }
+    }
+    xSemaphoreGive(record_flac_lock);
+}
 #else
-    record_total_len *= 2;
+static void audio_record_wav_header(wav_header_t *head, uint32_t data_len)
+{
+    memcpy(head->ChunkID, "RIFF", 4);
+    head->ChunkSize = sizeof(wav_header_t) - 8 + data_len;
+    memcpy(head->Format, "WAVE", 4);
+    memcpy(head->Subchunk1ID, "fmt ", 4);
+    head->Subchunk1Size = 16;
+    head->AudioFormat = 1;      // PCM
+    head->NumChannels = RECORD_CHANNELS;
+    head->SampleRate = RECORD_SAMPLE_RATE;
+    head->BitsPerSample = 16;
+    head->BlockAlign = head->NumChannels * head->BitsPerSample / 8;
+    head->ByteRate = head->SampleRate * head->BlockAlign;
+    memcpy(head->Subchunk2ID, "data", 4);
+    head->Subchunk2Size = data_len;
+}
 #endif
-    file_total_len += record_total_len;
-    ESP_LOGI(TAG, "### record Stop, %" PRIu32 " %" PRIu32 "K", \
-             record_total_len, \
-             record_total_len / 1024);
 
-    FILE *fp = fopen("/spiffs/echo_en_wake.wav", "r");
-    ESP_GOTO_ON_FALSE(NULL != fp, ESP_FAIL, err, TAG, "Failed create record file");
-
-    wav_header_t wav_head;
-    int len = fread(&wav_head, 1, sizeof(wav_header_t), fp);
-    ESP_GOTO_ON_FALSE(len > 0, ESP_FAIL, err, TAG, "Failed create record file");
+bool audio_record_vad(bool speech, uint32_t end, uint32_t samples)
+{
+    app_vad_result_t result = APP_VAD_CONTINUE;
+#if RECORD_FLAC
+    bool heard = false;
+    uint32_t range_start = 0;
+    uint32_t range_end = 0;
+#endif
 
-    wav_head.SampleRate = 16000;
-#if PCM_ONE_CHANNEL
-    wav_head.NumChannels = 1;
-#else
-    wav_head.NumChannels = 2;
+    taskENTER_CRITICAL(&record_vad_lock);
+    if (record_flag && (int32_t)(end - record_start_sample) > 0) {
+        result = app_vad_process(&record_vad, speech, end - record_start_sample, samples);
+#if RECORD_FLAC
+        heard = app_vad_get_range(&record_vad, &range_start, &range_end);
 #endif
-    wav_head.BitsPerSample = 16;
-    wav_head.ChunkSize = file_total_len - 8;
-    wav_head.ByteRate = wav_head.SampleRate * wav_head.BitsPerSample * wav_head.NumChannels / 8;
-    wav_head.Subchunk2ID[0] = 'd';
-    wav_head.Subchunk2ID[1] = 'a';
-    wav_head.Subchunk2ID[2] = 't';
-    wav_head.Subchunk2ID[3] = 'a';
-    wav_head.Subchunk2Size = record_total_len;
-    memcpy((void *)record_audio_buffer, &wav_head, sizeof(wav_header_t));
-    Cache_WriteBack_Addr((uint32_t)record_audio_buffer, record_total_len);
+    }
+    taskEXIT_CRITICAL(&record_vad_lock);
 
+#if RECORD_FLAC
+    if (heard) {
+        audio_record_encode(range_start, range_end, false);
+    }
 #endif
-err:
-    if (fp) {
-        fclose(fp);
+
+    if (APP_VAD_CONTINUE != result) {
+        ESP_LOGI(TAG, "endpoint: %s", APP_VAD_END_SILENCE == result ? "silence" :
+                 APP_VAD_END_MAX == result ? "max length" : "no speech");
     }
+    return APP_VAD_CONTINUE != result;
+}
+
+static esp_err_t audio_record_stop()
+{
+    esp_err_t ret = ESP_OK;
+#if DEBUG_SAVE_PCM
+    uint32_t start = 0;
+    uint32_t end = 0;
+
+    taskENTER_CRITICAL(&record_vad_lock);
+    record_flag = false;
+    bool heard = app_vad_get_range(&record_vad, &start, &end);
+    taskEXIT_CRITICAL(&record_vad_lock);
+
+    uint32_t recorded = record_total_len / RECORD_CHANNELS;
+    end = end < recorded ? end : recorded;
+    ESP_RETURN_ON_FALSE(heard && start < end, ESP_ERR_NOT_FOUND, TAG, "### record Stop, no speech in %" PRIu32 " ms",
+                        recorded * 1000 / RECORD_SAMPLE_RATE);
+
+    /* Only the speech is uploaded, leading and trailing silence are dropped */
+    uint32_t data_len = (end - start) * RECORD_CHANNELS * sizeof(int16_t);
+#if RECORD_FLAC
+    int64_t start_us = esp_timer_get_time();
+    audio_record_encode(start, end, true);
+    ESP_LOGI(TAG, "### record Stop, %" PRIu32 "K of PCM in %" PRIu32 "K of FLAC, speech %" PRIu32 "-%" PRIu32 " ms, last block in %" PRId64 " ms", \
+             data_len / 1024, \
+             file_total_len / 1024, \
+             start * 1000 / RECORD_SAMPLE_RATE, \
+             end * 1000 / RECORD_SAMPLE_RATE, \
+             (esp_timer_get_time() - start_us) / 1000);
+#else
+    int16_t *pcm = (int16_t *)(record_audio_buffer + sizeof(wav_header_t));
+    memmove(pcm, pcm + start * RECORD_CHANNELS, data_len);
+    record_total_len = (end - start) * RECORD_CHANNELS;
+    file_total_len = sizeof(wav_header_t) + data_len;
+    audio_record_wav_header((wav_header_t *)record_audio_buffer, data_len);
+    ESP_LOGI(TAG, "### record Stop, %" PRIu32 "K of %" PRIu32 "K kept, speech %" PRIu32 "-%" PRIu32 " ms", \
+             data_len / 1024, \
+             recorded * RECORD_CHANNELS * (uint32_t)sizeof(int16_t) / 1024, \
+             start * 1000 / RECORD_SAMPLE_RATE, \
+             end * 1000 / RECORD_SAMPLE_RATE);
+#endif
+    Cache_WriteBack_Addr((uint32_t)record_upload, file_total_len);
+#endif
     return ret;
 }
 
@@ -311,13 +458,17 @@ void sr_handler_task(void *pvParam)
 #endif
         if (ESP_MN_STATE_TIMEOUT == result.state) {
             ESP_LOGI(TAG, "ESP_MN_STATE_TIMEOUT");
-            audio_record_stop();
+            if (ESP_OK != audio_record_stop()) {
+                // Nothing was said, no need for a round trip
+                ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, 0);
+                continue;
+            }
             FILE *fp = fopen("/spiffs/waitPlease.mp3", "r");
             if (fp) {
                 audio_player_play(fp);
             }
             if (WIFI_STATUS_CONNECTED_OK == wifi_connected_already()) {
-                start_openai((uint8_t *)record_audio_buffer, record_total_len);
+                start_openai(record_upload, file_total_len, RECORD_FORMAT);
             }
             continue;
         }
@@ -330,6 +481,7 @@ void sr_handler_task(void *pvParam)
             ui_ctrl_show_panel(UI_CTRL_PANEL_LISTEN, 0);
 
             audio_play_task("/spiffs/echo_en_wake.wav");
+            audio_record_listen();
             continue;
         }
 
@@ -9,7 +9,6 @@
 #define DEBUG_SAVE_PCM      (1)
 #define PCM_ONE_CHANNEL     (1)
 #define FILE_SIZE (256000)
-#define MAX_FILE_SIZE       (1*1024*1024)
 #define RECORD_NAME         "/spiffs/record.wav"
 
 typedef struct {
@@ -35,15 +34,21 @@ typedef void (*audio_play_finish_cb_t)(void);
 
 void sr_handler_task(void *pvParam);
 
-/**
- * @brief The buffer to hold the recorded audio.
- */
-extern uint8_t *audio_rx_buffer;
-
 esp_err_t audio_play_task(void *filepath);
 
 void audio_record_init();
 
 void audio_record_save(int16_t *audio_buffer, int audio_chunksize);
 
+/**
+ * @brief Feed the AFE VAD decision of one fetched frame to the endpointing of the recording
+ *
+ * @param speech    The frame was classified as speech
+ * @param end       AFE samples fetched so far, this frame included
+ * @param samples   Samples in the frame
+ *
+ * @return true once the user stopped speaking, or the recording has to end anyway
+ */
+bool audio_record_vad(bool speech, uint32_t end, uint32_t samples);
+
 void audio_register_play_finish_cb(audio_play_finish_cb_t cb);
@@ -0,0 +1,798 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Transcription -> chat completion -> speech -> playback, each stage in its own task:
+ *
+ *   caller task      uploads the question, then streams the chat completion (SSE) and cuts it into sentences
+ *   Chat TTS Task    turns one sentence at a time into MP3 while the next is generated
+ *   Chat Play Task   plays the sentences in order, each one while its MP3 is still downloading
+ *
+ * The MP3 goes through one of TTS_SLOT_NUM bounded rings, so memory does not grow with the reply.
+ *
+ * Every sentence carries the turn it belongs to, an abort bumps the turn and the
+ * stages drop whatever they receive from an older one.
+ */
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_http_client.h"
+#include "esp_crt_bundle.h"
+#include "cJSON.h"
+#include "audio_player.h"
+#include "app_chat_stream.h"
+#include "app_stream_buf.h"
+
+#define STT_PATH                "audio/transcriptions"
+#define STT_MODEL               "whisper-1"
+#define STT_LANGUAGE            "en"        // "zh" for Chinese
+#define STT_TEMPERATURE         "0.2"
+#define STT_BOUNDARY            "esp-box-chat-stream-boundary"
+#define STT_RESPONSE_MAX        (2048)
+#define CHAT_PATH               "chat/completions"
+#define CHAT_MODEL              "gpt-3.5-turbo"
+#define CHAT_TEMPERATURE        (0.2)
+#define TTS_PATH                "audio/speech"
+#define TTS_MODEL               "tts-1"
+#define TTS_VOICE               "nova"
+#define TTS_RETRY               (1)         // a kept-alive connection may have been closed by the server meanwhile
+
+#define HTTP_TIMEOUT_MS         (15 * 1000)
+#define HTTP_BUFFER_SIZE        (2048)
+#define SSE_LINE_MAX            (1024)
+
+#define SEGMENT_MIN_CHARS       (16)        // shorter sentences are merged with the next one, each costs a TTS round trip
+#define SEGMENT_MAX_CHARS       (320)       // cut at a space when no sentence ends before this
+
+#define TTS_QUEUE_LEN           (4)
+#define PLAY_QUEUE_LEN          (TTS_SLOT_NUM)
+#define TTS_SLOT_NUM            (2)         // rings in use, whatever the length of the reply
+#define PLAY_POLL_MS            (100)
+#define PLAY_PROBE_PIN          (8 * 1024)  // head of the MP3 kept for the player, it seeks back to 0 after probing
+#define PLAY_STOP_WAIT_MS       (500)
+
+#define REPLY_BUF_INIT_SIZE     (512)
+
+typedef struct {
+    app_stream_buf_handle_t buf;
+    int refs;                   // the TTS and play stages each drop one, the slot is free again at zero
+} tts_slot_t;
+
+typedef struct {
+    uint32_t turn;
+    char *data;                 // sentence on the TTS queue
+    size_t len;
+    tts_slot_t *slot;           // MP3 stream on the play queue, no data and no slot closes the turn
+    bool failed;                // speech failed, reported by the play task after the sentences before it
+} stream_item_t;
+
+typedef struct {
+    uint32_t turn;
+    bool done;
+    char line[SSE_LINE_MAX];
+    size_t line_len;
+    bool line_drop;             // line longer than the buffer, skipped up to its end
+    char pending[SEGMENT_MAX_CHARS];
+    size_t pending_len;
+    char *reply;
+    size_t reply_len;
+    size_t reply_size;
+} chat_ctx_t;
+
+typedef struct {
+    tts_slot_t *slot;
+    size_t len;
+    bool failed;
+} tts_ctx_t;
+
+static const char *TAG = "chat_stream";
+
+static char *s_auth = NULL;
+static char *s_stt_url = NULL;
+static char *s_chat_url = NULL;
+static char *s_tts_url = NULL;
+static app_chat_stream_cb_t s_cb = NULL;
+static QueueHandle_t s_tts_queue = NULL;
+static QueueHandle_t s_play_queue = NULL;
+static SemaphoreHandle_t s_idle_sem = NULL;
+static tts_slot_t s_slots[TTS_SLOT_NUM];
+static QueueHandle_t s_free_slots = NULL;
+static volatile uint32_t s_turn = 0;
+static int64_t s_turn_start_us = 0;
+
+static void stream_notify(app_chat_stream_event_t event, const char *data)
+{
+    if (s_cb) {
+        s_cb(event, data);
+    }
+}
+
+static char *stream_url(const char *base_url, const char *path)
+{
+    size_t len = strlen(base_url);
+    char *url = NULL;
+
+    if (asprintf(&url, "%s%s%s", base_url, (len && '/' == base_url[len - 1]) ? "" : "/", path) < 0) {
+        return NULL;
+    }
+    return url;
+}
+
+static esp_http_client_handle_t stream_client_create(const char *url, http_event_handle_cb handler, void *ctx)
+{
+    esp_http_client_config_t config = {
+        .url = url,
+        .method = HTTP_METHOD_POST,
+        .timeout_ms = HTTP_TIMEOUT_MS,
+        .buffer_size = HTTP_BUFFER_SIZE,
+        .event_handler = handler,
+        .user_data = ctx,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client) {
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+        esp_http_client_set_header(client, "Authorization", s_auth);
+    }
+    return client;
+}
+
+static esp_err_t stt_write(esp_http_client_handle_t client, const char *data, size_t len)
+{
+    while (len) {
+        int n = esp_http_client_write(client, data, len);
+        if (n <= 0) {
+            return ESP_FAIL;
+        }
+        data += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_chat_stream_transcribe(const uint8_t *audio, size_t len, const char *format, char **text)
+{
+    esp_err_t ret = ESP_OK;
+    esp_http_client_handle_t client = NULL;
+    char *head = NULL;
+    char *resp = NULL;
+    cJSON *root = NULL;
+    const char *tail = "\r\n--" STT_BOUNDARY "--\r\n";
+
+    ESP_RETURN_ON_FALSE(NULL != s_stt_url, ESP_ERR_INVALID_STATE, TAG, "pipeline not initialized");
+    ESP_RETURN_ON_FALSE(audio && len && format && text, ESP_ERR_INVALID_ARG, TAG, "invalid audio");
+    *text = NULL;
+
+    int head_len = asprintf(&head,
+                            "--" STT_BOUNDARY "\r\nContent-Disposition: form-data; name=\"model\"\r\n\r\n" STT_MODEL "\r\n"
+                            "--" STT_BOUNDARY "\r\nContent-Disposition: form-data; name=\"language\"\r\n\r\n" STT_LANGUAGE "\r\n"
+                            "--" STT_BOUNDARY "\r\nContent-Disposition: form-data; name=\"temperature\"\r\n\r\n" STT_TEMPERATURE "\r\n"
+                            "--" STT_BOUNDARY "\r\nContent-Disposition: form-data; name=\"response_format\"\r\n\r\njson\r\n"
+                            "--" STT_BOUNDARY "\r\nContent-Disposition: form-data; name=\"file\"; filename=\"audio.%s\"\r\n"
+                            "Content-Type: audio/%s\r\n\r\n", format, format);
+    ESP_RETURN_ON_FALSE(head_len > 0, ESP_ERR_NO_MEM, TAG, "no mem for transcription request");
+    resp = heap_caps_malloc(STT_RESPONSE_MAX, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(NULL != resp, ESP_ERR_NO_MEM, err, TAG, "no mem for transcription response");
+
+    int64_t start_us = esp_timer_get_time();
+    client = stream_client_create(s_stt_url, NULL, NULL);
+    ESP_GOTO_ON_FALSE(NULL != client, ESP_FAIL, err, TAG, "transcription client init failed");
+    esp_http_client_set_header(client, "Content-Type", "multipart/form-data; boundary=" STT_BOUNDARY);
+
+    /* The audio is sent from where it was recorded, the body is never assembled in memory */
+    ret = esp_http_client_open(client, head_len + len + strlen(tail));
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "transcription connect failed");
+    ret = stt_write(client, head, head_len);
+    if (ESP_OK == ret) {
+        ret = stt_write(client, (const char *)audio, len);
+    }
+    if (ESP_OK == ret) {
+        ret = stt_write(client, tail, strlen(tail));
+    }
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "transcription upload failed");
+    ESP_GOTO_ON_FALSE(esp_http_client_fetch_headers(client) >= 0, ESP_FAIL, err, TAG, "transcription no response");
+
+    int resp_len = 0;
+    int n;
+    while (resp_len < STT_RESPONSE_MAX - 1 &&
+            (n = esp_http_client_read(client, resp + resp_len, STT_RESPONSE_MAX - 1 - resp_len)) > 0) {
+        resp_len += n;
+    }
+    resp[resp_len] = '\0';
+
+    int status = esp_http_client_get_status_code(client);
+    ESP_LOGI(TAG, "transcription of %zu bytes of %s in %" PRId64 " ms", len, format, (esp_timer_get_time() - start_us) / 1000);
+    ESP_GOTO_ON_FALSE(200 == status, ESP_ERR_INVALID_RESPONSE, err, TAG, "transcription status %d: %s", status, resp);
+
+    root = cJSON_Parse(resp);
+    cJSON *result = cJSON_GetObjectItem(root, "text");
+    ESP_GOTO_ON_FALSE(cJSON_IsString(result), ESP_ERR_INVALID_RESPONSE, err, TAG, "transcription: %s", resp);
+    *text = strdup(result->valuestring);
+    ESP_GOTO_ON_FALSE(NULL != *text, ESP_ERR_NO_MEM, err, TAG, "no mem for transcription");
+
+err:
+    cJSON_Delete(root);
+    if (client) {
+        esp_http_client_cleanup(client);
+    }
+    free(resp);
+    free(head);
+    return ret;
+}
+
+/* Length of the first sentence long enough to be spoken on its own, 0 while none is complete */
+static size_t segment_boundary(const char *text, size_t len)
+{
+    for (size_t i = SEGMENT_MIN_CHARS - 1; i < len; i++) {
+        char c = text[i];
+        bool end = ('\n' == c);
+
+        /* The next character has to be a space, so "3.14" does not end anything */
+        if (('.' == c || '!' == c || '?' == c) && (i + 1 < len) && isspace((unsigned char)text[i + 1])) {
+            end = true;
+        }
+        if (end) {
+            return i + 1;
+        }
+        /* Full-width stops are not followed by a space */
+        if (i + 3 <= len && (!memcmp(text + i, "。", 3) || !memcmp(text + i, "！", 3) || !memcmp(text + i, "？", 3))) {
+            return i + 3;
+        }
+    }
+    return 0;
+}
+
+/* Forced cut of an overlong sentence, at the last space if there is one, never inside a UTF-8 character */
+static size_t segment_split(const char *text, size_t len)
+{
+    for (size_t i = len; i > SEGMENT_MIN_CHARS; i--) {
+        if (isspace((unsigned char)text[i - 1])) {
+            return i;
+        }
+    }
+    size_t lead = len;
+    while (lead > 1 && 0x80 == ((unsigned char)text[lead - 1] & 0xC0)) {
+        lead--;
+    }
+    unsigned char c = (unsigned char)text[lead - 1];
+    size_t need = (c >= 0xF0) ? 4 : (c >= 0xE0) ? 3 : (c >= 0xC0) ? 2 : 1;
+    if (lead > 1 && len - (lead - 1) < need) {
+        len = lead - 1;     // the last character did not fit, it starts the next sentence
+    }
+    return len;
+}
+
+static bool chat_reply_append(chat_ctx_t *ctx, const char *text, size_t len)
+{
+    if (ctx->reply_len + len + 1 > ctx->reply_size) {
+        size_t size = ctx->reply_size ? ctx->reply_size : REPLY_BUF_INIT_SIZE;
+        while (size < ctx->reply_len + len + 1) {
+            size *= 2;
+        }
+        char *reply = heap_caps_realloc(ctx->reply, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (NULL == reply) {
+            ESP_LOGE(TAG, "no mem for reply text");
+            return false;
+        }
+        ctx->reply = reply;
+        ctx->reply_size = size;
+    }
+    memcpy(ctx->reply + ctx->reply_len, text, len);
+    ctx->reply_len += len;
+    ctx->reply[ctx->reply_len] = '\0';
+    return true;
+}
+
+/* Hand the first len pending characters to the speech stage and to the UI */
+static void chat_emit(chat_ctx_t *ctx, size_t len)
+{
+    const char *start = ctx->pending;
+    const char *end = ctx->pending + len;
+    size_t reply_len = ctx->reply_len;
+
+    /* The UI gets the new text only, with its spacing, it appends instead of redrawing the reply */
+    if (len && chat_reply_append(ctx, ctx->pending, len)) {
+        stream_notify(APP_CHAT_STREAM_EVENT_TEXT, ctx->reply + reply_len);
+    }
+
+    while (start < end && isspace((unsigned char)*start)) {
+        start++;
+    }
+    while (end > start && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    if (end > start) {
+        stream_item_t item = {
+            .turn = ctx->turn,
+            .data = strndup(start, end - start),
+            .len = end - start,
+        };
+        /* Blocks while the speech stage is behind, which in turn throttles the download */
+        if (item.data && pdTRUE != xQueueSend(s_tts_queue, &item, portMAX_DELAY)) {
+            free(item.data);
+        }
+    }
+
+    ctx->pending_len -= len;
+    memmove(ctx->pending, ctx->pending + len, ctx->pending_len);
+}
+
+static void chat_feed(chat_ctx_t *ctx, const char *token)
+{
+    size_t cut;
+
+    for (const char *p = token; *p; p++) {
+        if (ctx->pending_len == sizeof(ctx->pending)) {
+            cut = segment_boundary(ctx->pending, ctx->pending_len);
+            chat_emit(ctx, cut ? cut : segment_split(ctx->pending, ctx->pending_len));
+        }
+        ctx->pending[ctx->pending_len++] = *p;
+    }
+
+    while ((cut = segment_boundary(ctx->pending, ctx->pending_len)) > 0) {
+        chat_emit(ctx, cut);
+    }
+}
+
+/* One server-sent event line, e.g. data: {"choices":[{"delta":{"content":"Hi"}}]} */
+static void chat_line(chat_ctx_t *ctx, int status)
+{
+    const char *data = ctx->line;
+
+    if (200 != status) {
+        ESP_LOGE(TAG, "chat: %s", data);
+        return;
+    }
+    if (strncmp(data, "data:", 5)) {
+        return;     // comments, keep-alives and event names
+    }
+    data += 5;
+    while (' ' == *data) {
+        data++;
+    }
+    if (0 == strcmp(data, "[DONE]")) {
+        ctx->done = true;
+        return;
+    }
+
+    cJSON *root = cJSON_Parse(data);
+    cJSON *choice = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "choices"), 0);
+    cJSON *content = cJSON_GetObjectItem(cJSON_GetObjectItem(choice, "delta"), "content");
+    if (cJSON_IsString(content)) {
+        chat_feed(ctx, content->valuestring);
+    }
+    cJSON_Delete(root);
+}
+
+static esp_err_t chat_http_event_handler(esp_http_client_event_t *evt)
+{
+    chat_ctx_t *ctx = (chat_ctx_t *)evt->user_data;
+
+    if (HTTP_EVENT_ON_DATA != evt->event_id || ctx->done) {
+        return ESP_OK;
+    }
+    if (ctx->turn != s_turn) {
+        ctx->done = true;   // aborted, the rest of the body is ignored
+        return ESP_OK;
+    }
+
+    int status = esp_http_client_get_status_code(evt->client);
+    const char *data = (const char *)evt->data;
+    for (int i = 0; i < evt->data_len && !ctx->done; i++) {
+        if ('\n' == data[i]) {
+            if (!ctx->line_drop) {
+                if (ctx->line_len && '\r' == ctx->line[ctx->line_len - 1]) {
+                    ctx->line_len--;
+                }
+                ctx->line[ctx->line_len] = '\0';
+                chat_line(ctx, status);
+            }
+            ctx->line_len = 0;
+            ctx->line_drop = false;
+        } else if (ctx->line_len < sizeof(ctx->line) - 1) {
+            ctx->line[ctx->line_len++] = data[i];
+        } else {
+            ctx->line_drop = true;
+        }
+    }
+    return ESP_OK;
+}
+
+static char *chat_request_body(const char *question)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *messages = cJSON_AddArrayToObject(root, "messages");
+    cJSON *message = cJSON_CreateObject();
+    char *body = NULL;
+
+    if (messages && message) {
+        cJSON_AddStringToObject(message, "role", "user");
+        cJSON_AddStringToObject(message, "content", question);
+        cJSON_AddItemToArray(messages, message);
+        message = NULL;
+        cJSON_AddStringToObject(root, "model", CHAT_MODEL);
+        cJSON_AddNumberToObject(root, "max_tokens", CONFIG_MAX_TOKEN);
+        cJSON_AddNumberToObject(root, "temperature", CHAT_TEMPERATURE);
+        cJSON_AddStringToObject(root, "stop", "\r");
+        cJSON_AddStringToObject(root, "user", "OpenAI-ESP32");
+        cJSON_AddTrueToObject(root, "stream");
+        body = cJSON_PrintUnformatted(root);
+    }
+    cJSON_Delete(message);
+    cJSON_Delete(root);
+    return body;
+}
+
+esp_err_t app_chat_stream_reply(const char *question)
+{
+    esp_err_t ret = ESP_OK;
+    esp_http_client_handle_t client = NULL;
+    char *body = NULL;
+
+    ESP_RETURN_ON_FALSE(NULL != s_tts_queue, ESP_ERR_INVALID_STATE, TAG, "pipeline not initialized");
+    ESP_RETURN_ON_FALSE(NULL != question, ESP_ERR_INVALID_ARG, TAG, "no question");
+
+    chat_ctx_t *ctx = heap_caps_calloc(1, sizeof(chat_ctx_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(NULL != ctx, ESP_ERR_NO_MEM, TAG, "no mem for chat context");
+
+    s_turn_start_us = esp_timer_get_time();
+    ctx->turn = ++s_turn;
+
+    body = chat_request_body(question);
+    ESP_GOTO_ON_FALSE(NULL != body, ESP_ERR_NO_MEM, err, TAG, "no mem for chat request");
+    client = stream_client_create(s_chat_url, chat_http_event_handler, ctx);
+    ESP_GOTO_ON_FALSE(NULL != client, ESP_FAIL, err, TAG, "chat client init failed");
+    esp_http_client_set_header(client, "Accept", "text/event-stream");
+    esp_http_client_set_post_field(client, body, strlen(body));
+
+    ret = esp_http_client_perform(client);
+    ESP_GOTO_ON_FALSE(ctx->turn == s_turn, ESP_ERR_INVALID_STATE, err, TAG, "reply aborted");
+    if (ESP_OK == ret && 200 != esp_http_client_get_status_code(client)) {
+        ret = ESP_ERR_INVALID_RESPONSE;
+    }
+    if (ctx->pending_len) {
+        chat_emit(ctx, ctx->pending_len);
+    }
+
+    /* A reply cut short by the network is still spoken up to where it stopped */
+    if (ctx->reply_len) {
+        if (ESP_OK != ret) {
+            ESP_LOGW(TAG, "reply truncated: %s", esp_err_to_name(ret));
+            ret = ESP_OK;
+        }
+    } else if (ESP_OK == ret) {
+        ret = ESP_ERR_INVALID_RESPONSE;
+    }
+    ESP_LOGI(TAG, "reply of %zu chars in %" PRId64 " ms", ctx->reply_len, (esp_timer_get_time() - s_turn_start_us) / 1000);
+
+err:
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "chat failed: %s", esp_err_to_name(ret));
+    }
+    /* Close the turn even on failure, the later stages report its end */
+    stream_item_t end = { .turn = ctx->turn };
+    xQueueSend(s_tts_queue, &end, portMAX_DELAY);
+
+    if (client) {
+        esp_http_client_cleanup(client);
+    }
+    cJSON_free(body);
+    free(ctx->reply);
+    free(ctx);
+    return ret;
+}
+
+static esp_err_t tts_http_event_handler(esp_http_client_event_t *evt)
+{
+    tts_ctx_t *ctx = (tts_ctx_t *)evt->user_data;
+
+    if (HTTP_EVENT_ON_DATA != evt->event_id || ctx->failed) {
+        return ESP_OK;
+    }
+    if (200 != esp_http_client_get_status_code(evt->client)) {
+        ESP_LOGE(TAG, "speech: %.*s", evt->data_len, (const char *)evt->data);
+        return ESP_OK;
+    }
+
+    /* Blocks while the ring is full, the player draining it paces the download */
+    if (ESP_OK != app_stream_buf_write(ctx->slot->buf, evt->data, evt->data_len, portMAX_DELAY)) {
+        ctx->failed = true;     // aborted, the rest of the body is ignored
+        return ESP_OK;
+    }
+    ctx->len += evt->data_len;
+    return ESP_OK;
+}
+
+static char *tts_request_body(const char *sentence)
+{
+    cJSON *root = cJSON_CreateObject();
+    char *body = NULL;
+
+    if (root) {
+        cJSON_AddStringToObject(root, "model", TTS_MODEL);
+        cJSON_AddStringToObject(root, "input", sentence);
+        cJSON_AddStringToObject(root, "voice", TTS_VOICE);
+        cJSON_AddStringToObject(root, "response_format", "mp3");
+        cJSON_AddNumberToObject(root, "speed", 1.0);
+        body = cJSON_PrintUnformatted(root);
+        cJSON_Delete(root);
+    }
+    return body;
+}
+
+static esp_err_t tts_fetch(esp_http_client_handle_t *client, tts_ctx_t *ctx, const char *sentence)
+{
+    esp_err_t ret = ESP_FAIL;
+    int status = 0;
+    char *body = tts_request_body(sentence);
+    ESP_RETURN_ON_FALSE(NULL != body, ESP_ERR_NO_MEM, TAG, "no mem for speech request");
+
+    ctx->len = 0;
+    ctx->failed = false;
+    for (int i = 0; i <= TTS_RETRY; i++) {
+        if (NULL == *client) {
+            *client = stream_client_create(s_tts_url, tts_http_event_handler, ctx);
+            ESP_GOTO_ON_FALSE(NULL != *client, ESP_FAIL, err, TAG, "speech client init failed");
+        }
+        esp_http_client_set_post_field(*client, body, strlen(body));
+        ret = esp_http_client_perform(*client);
+        if (ESP_OK == ret) {
+            status = esp_http_client_get_status_code(*client);
+            break;
+        }
+        esp_http_client_cleanup(*client);
+        *client = NULL;
+        if (ctx->len) {
+            break;      // part of it is already playing, a retry would repeat it
+        }
+    }
+    ESP_GOTO_ON_ERROR(ret, err, TAG, "speech request failed");
+    ESP_GOTO_ON_FALSE(200 == status, ESP_ERR_INVALID_RESPONSE, err, TAG, "speech status %d", status);
+    ESP_GOTO_ON_FALSE(!ctx->failed, ESP_ERR_INVALID_STATE, err, TAG, "speech aborted");
+    ESP_GOTO_ON_FALSE(ctx->len, ESP_ERR_INVALID_RESPONSE, err, TAG, "empty speech");
+
+err:
+    cJSON_free(body);
+    return ret;
+}
+
+static void tts_slot_put(tts_slot_t *slot)
+{
+    if (0 == __atomic_sub_fetch(&slot->refs, 1, __ATOMIC_ACQ_REL)) {
+        xQueueSend(s_free_slots, &slot, 0);
+    }
+}
+
+static void tts_task(void *pvParam)
+{
+    esp_http_client_handle_t client = NULL;     // kept across sentences, saves a TLS handshake per sentence
+    tts_ctx_t ctx = { 0 };
+    uint32_t failed_turn = 0;
+    stream_item_t item;
+
+    while (true) {
+        xQueueReceive(s_tts_queue, &item, portMAX_DELAY);
+        if (item.turn != s_turn || (item.data && item.turn == failed_turn)) {
+            free(item.data);
+            continue;
+        }
+        if (NULL == item.data) {
+            xQueueSend(s_play_queue, &item, portMAX_DELAY);
+            continue;
+        }
+
+        /* Wait for a free ring, one is playing while the next sentence downloads into the other */
+        xQueueReceive(s_free_slots, &ctx.slot, portMAX_DELAY);
+        app_stream_buf_reset(ctx.slot->buf);
+        ctx.slot->refs = 2;
+
+        /* The player starts on the ring right away, it waits for the prebuffer by itself */
+        stream_item_t mp3 = {
+            .turn = item.turn,
+            .slot = ctx.slot,
+        };
+        xQueueSend(s_play_queue, &mp3, portMAX_DELAY);
+
+        int64_t start_us = esp_timer_get_time();
+        esp_err_t ret = tts_fetch(&client, &ctx, item.data);
+        ESP_LOGI(TAG, "speech for %zu chars: %zu bytes in %" PRId64 " ms", item.len, ctx.len, (esp_timer_get_time() - start_us) / 1000);
+        free(item.data);
+
+        if (ESP_OK == ret) {
+            app_stream_buf_finish(ctx.slot->buf);
+        } else {
+            app_stream_buf_abort(ctx.slot->buf);
+            if (item.turn == s_turn) {
+                stream_item_t failed = {
+                    .turn = item.turn,
+                    .failed = true,
+                };
+                failed_turn = item.turn;
+                xQueueSend(s_play_queue, &failed, portMAX_DELAY);
+            }
+        }
+        tts_slot_put(ctx.slot);
+        ctx.slot = NULL;
+    }
+}
+
+/* Wait for the sentence to finish, or for the player to let go of it after an abort */
+static void play_wait_idle(uint32_t turn, tts_slot_t *slot)
+{
+    while (true) {
+        if (pdTRUE == xSemaphoreTake(s_idle_sem, pdMS_TO_TICKS(PLAY_POLL_MS))) {
+            if (AUDIO_PLAYER_STATE_PLAYING != audio_player_get_state()) {
+                return;
+            }
+            continue;   // left over from a sound started before this sentence
+        }
+        if (turn != s_turn) {
+            app_stream_buf_abort(slot->buf);    // a read stuck on an underrun returns EOF
+            xSemaphoreTake(s_idle_sem, pdMS_TO_TICKS(PLAY_STOP_WAIT_MS));
+            return;
+        }
+    }
+}
+
+static void play_stream_buf_cb(app_stream_buf_event_t event, void *args)
+{
+    if (APP_STREAM_BUF_EVENT_STALL == event) {
+        ESP_LOGW(TAG, "speech underrun, waiting for data");
+    } else {
+        ESP_LOGI(TAG, "speech resumed");
+    }
+}
+
+static void play_task(void *pvParam)
+{
+    uint32_t started_turn = 0;
+    uint32_t stalls = 0;
+    stream_item_t item;
+
+    while (true) {
+        xQueueReceive(s_play_queue, &item, portMAX_DELAY);
+        if (item.failed) {
+            /* The player is free by now, the handler may play a prompt of its own */
+            if (item.turn == s_turn) {
+                stream_notify(APP_CHAT_STREAM_EVENT_TTS_FAILED, NULL);
+            }
+            continue;
+        }
+        if (NULL == item.slot) {
+            if (item.turn == s_turn) {
+                ESP_LOGI(TAG, "turnaround %" PRId64 " ms, %" PRIu32 " underruns", (esp_timer_get_time() - s_turn_start_us) / 1000, stalls);
+                stream_notify(APP_CHAT_STREAM_EVENT_AUDIO_END, NULL);
+            }
+            continue;
+        }
+        if (item.turn != s_turn) {
+            app_stream_buf_abort(item.slot->buf);
+            tts_slot_put(item.slot);
+            continue;
+        }
+
+        esp_err_t ret = ESP_FAIL;
+        FILE *fp = app_stream_buf_fopen(item.slot->buf);
+        xSemaphoreTake(s_idle_sem, 0);
+        if (fp) {
+            ret = audio_player_play(fp);
+        }
+        if (ESP_OK == ret) {
+            if (started_turn != item.turn) {
+                started_turn = item.turn;
+                stalls = 0;
+                ESP_LOGI(TAG, "first audio after %" PRId64 " ms", (esp_timer_get_time() - s_turn_start_us) / 1000);
+                stream_notify(APP_CHAT_STREAM_EVENT_AUDIO_START, NULL);
+            }
+            play_wait_idle(item.turn, item.slot);
+            stalls += app_stream_buf_get_stalls(item.slot->buf);
+        } else {
+            ESP_LOGE(TAG, "play failed: %s", esp_err_to_name(ret));
+            if (fp) {
+                fclose(fp);
+            }
+            app_stream_buf_abort(item.slot->buf);
+        }
+        tts_slot_put(item.slot);
+    }
+}
+
+void app_chat_stream_abort(void)
+{
+    s_turn++;
+}
+
+void app_chat_stream_play_idle(void)
+{
+    if (s_idle_sem) {
+        xSemaphoreGive(s_idle_sem);
+    }
+}
+
+esp_err_t app_chat_stream_init(const char *key, const char *base_url, app_chat_stream_cb_t cb)
+{
+    esp_err_t ret = ESP_OK;
+    TaskHandle_t tts_task_handle = NULL;
+
+    ESP_RETURN_ON_FALSE(key && base_url, ESP_ERR_INVALID_ARG, TAG, "invalid key or url");
+    ESP_RETURN_ON_FALSE(NULL == s_tts_queue, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+
+    s_cb = cb;
+    ESP_GOTO_ON_FALSE(asprintf(&s_auth, "Bearer %s", key) > 0, ESP_ERR_NO_MEM, err, TAG, "no mem for key");
+    s_stt_url = stream_url(base_url, STT_PATH);
+    s_chat_url = stream_url(base_url, CHAT_PATH);
+    s_tts_url = stream_url(base_url, TTS_PATH);
+    ESP_GOTO_ON_FALSE(s_stt_url && s_chat_url && s_tts_url, ESP_ERR_NO_MEM, err, TAG, "no mem for url");
+
+    s_idle_sem = xSemaphoreCreateBinary();
+    s_tts_queue = xQueueCreate(TTS_QUEUE_LEN, sizeof(stream_item_t));
+    s_play_queue = xQueueCreate(PLAY_QUEUE_LEN, sizeof(stream_item_t));
+    s_free_slots = xQueueCreate(TTS_SLOT_NUM, sizeof(tts_slot_t *));
+    ESP_GOTO_ON_FALSE(s_idle_sem && s_tts_queue && s_play_queue && s_free_slots, ESP_ERR_NO_MEM, err, TAG, "no mem for queues");
+
+    app_stream_buf_cfg_t buf_cfg = {
+        .size = CONFIG_TTS_STREAM_BUFFER_SIZE * 1024,
+        .prebuffer = CONFIG_TTS_STREAM_PREBUFFER_SIZE * 1024,
+        .pin = PLAY_PROBE_PIN,
+        .cb = play_stream_buf_cb,
+    };
+    for (int i = 0; i < TTS_SLOT_NUM; i++) {
+        ret = app_stream_buf_create(&buf_cfg, &s_slots[i].buf);
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "no mem for speech buffer");
+        tts_slot_t *slot = &s_slots[i];
+        xQueueSend(s_free_slots, &slot, 0);
+    }
+
+    BaseType_t ret_val = xTaskCreatePinnedToCore(tts_task, "Chat TTS Task", 8 * 1024, NULL, 5, &tts_task_handle, 0);
+    ESP_GOTO_ON_FALSE(pdPASS == ret_val, ESP_FAIL, err, TAG, "Failed create chat tts task");
+    ret_val = xTaskCreatePinnedToCore(play_task, "Chat Play Task", 3 * 1024, NULL, 5, NULL, 0);
+    ESP_GOTO_ON_FALSE(pdPASS == ret_val, ESP_FAIL, err, TAG, "Failed create chat play task");
+
+    return ESP_OK;
+
+err:
+    /* Nothing was queued yet, the TTS task is blocked on its empty queue */
+    if (tts_task_handle) {
+        vTaskDelete(tts_task_handle);
+    }
+    for (int i = 0; i < TTS_SLOT_NUM; i++) {
+        app_stream_buf_delete(s_slots[i].buf);
+        s_slots[i].buf = NULL;
+    }
+    if (s_free_slots) {
+        vQueueDelete(s_free_slots);
+        s_free_slots = NULL;
+    }
+    if (s_play_queue) {
+        vQueueDelete(s_play_queue);
+        s_play_queue = NULL;
+    }
+    if (s_tts_queue) {
+        vQueueDelete(s_tts_queue);
+        s_tts_queue = NULL;
+    }
+    if (s_idle_sem) {
+        vSemaphoreDelete(s_idle_sem);
+        s_idle_sem = NULL;
+    }
+    free(s_tts_url);
+    free(s_chat_url);
+    free(s_stt_url);
+    free(s_auth);
+    s_tts_url = s_chat_url = s_stt_url = s_auth = NULL;
+    return ret;
+}
@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    APP_CHAT_STREAM_EVENT_TEXT = 0,     /*!< Text was added to the reply, data is the added text */
+    APP_CHAT_STREAM_EVENT_AUDIO_START,  /*!< The first sentence of the reply started playing */
+    APP_CHAT_STREAM_EVENT_AUDIO_END,    /*!< The reply is over, all of its sentences were played or dropped */
+    APP_CHAT_STREAM_EVENT_TTS_FAILED,   /*!< Speech failed, the rest of the reply stays silent. Sent from the play
+                                             task once the sentences before it have played, the player is free */
+} app_chat_stream_event_t;
+
+typedef void (*app_chat_stream_cb_t)(app_chat_stream_event_t event, const char *data);
+
+/**
+ * @brief Create the speech and playback stages of the pipeline
+ *
+ * @param key       OpenAI API key
+ * @param base_url  API base URL, e.g. "https://api.openai.com/v1/"
+ * @param cb        Called from the pipeline tasks, must not block for long
+ */
+esp_err_t app_chat_stream_init(const char *key, const char *base_url, app_chat_stream_cb_t cb);
+
+/**
+ * @brief Turn the recorded question into text
+ *
+ * @param audio     Audio file in memory, uploaded as it is
+ * @param format    File extension of the audio, e.g. "flac" or "wav"
+ * @param text      The transcription, to be freed by the caller
+ */
+esp_err_t app_chat_stream_transcribe(const uint8_t *audio, size_t len, const char *format, char **text);
+
+/**
+ * @brief Ask a question and stream the answer
+ *
+ * The chat completion is read as server-sent events and cut at sentence boundaries.
+ * Each sentence is handed to the speech stage as soon as it is complete, so speech
+ * and playback of the first sentences overlap with the generation of the next ones.
+ *
+ * @note Returns once the reply text is complete, the audio may still be playing.
+ */
+esp_err_t app_chat_stream_reply(const char *question);
+
+/**
+ * @brief Drop the reply in progress, its pending sentences and audio are discarded
+ */
+void app_chat_stream_abort(void);
+
+/**
+ * @brief Tell the pipeline the audio player went idle, call it from the player callback
+ */
+void app_chat_stream_play_idle(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,381 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Minimal FLAC encoder for the speech upload: fixed predictors of order 0 to 4 and partitioned Rice
+ * coding, no LPC and no MD5. It needs no driver so the output can be checked by any FLAC decoder on a host.
+ */
+
+#include <string.h>
+#include "app_flac.h"
+
+#define FLAC_STREAMINFO_LEN     (34)
+#define FLAC_HEADER_LEN         (4 + 4 + FLAC_STREAMINFO_LEN)
+#define FLAC_MAX_FIXED_ORDER    (4)
+#define FLAC_MAX_RICE_PARAM     (14)        // 15 is the escape code
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t pos;
+    uint64_t acc;
+    uint32_t bits;
+    bool overflow;
+} bit_writer_t;
+
+static void bw_put(bit_writer_t *bw, uint32_t val, uint32_t bits)
+{
+    if (bits < 32) {
+        val &= (1u << bits) - 1;
+    }
+    bw->acc = (bw->acc << bits) | val;
+    bw->bits += bits;
+    while (bw->bits >= 8) {
+        bw->bits -= 8;
+        if (bw->pos < bw->cap) {
+            bw->buf[bw->pos++] = (uint8_t)(bw->acc >> bw->bits);
+        } else {
+            bw->overflow = true;
+        }
+    }
+}
+
+static void bw_align(bit_writer_t *bw)
+{
+    if (bw->bits) {
+        bw_put(bw, 0, 8 - bw->bits);
+    }
+}
+
+static void bw_put_rice(bit_writer_t *bw, int32_t val, uint32_t k)
+{
+    uint32_t u = ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+    uint32_t q = u >> k;
+
+    while (q >= 32) {
+        bw_put(bw, 0, 32);
+        q -= 32;
+    }
+    bw_put(bw, 0, q);
+    bw_put(bw, (1u << k) | (u & ((1u << k) - 1)), k + 1);
+}
+
+static uint8_t flac_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t flac_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0;
+
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t flac_sample_rate_code(uint32_t sample_rate)
+{
+    switch (sample_rate) {
+    case 8000:
+        return 4;
+    case 16000:
+        return 5;
+    case 22050:
+        return 6;
+    case 24000:
+        return 7;
+    case 32000:
+        return 8;
+    case 44100:
+        return 9;
+    case 48000:
+        return 10;
+    default:
+        return 0;               // taken from STREAMINFO
+    }
+}
+
+static void flac_write_streaminfo(app_flac_enc_t *enc)
+{
+    bit_writer_t bw = {
+        .buf = enc->out + 8,
+        .cap = FLAC_STREAMINFO_LEN,
+    };
+
+    bw_put(&bw, APP_FLAC_BLOCK_SIZE, 16);
+    bw_put(&bw, APP_FLAC_BLOCK_SIZE, 16);
+    bw_put(&bw, enc->frames ? enc->min_frame : 0, 24);
+    bw_put(&bw, enc->max_frame, 24);
+    bw_put(&bw, enc->sample_rate, 20);
+    bw_put(&bw, 0, 3);          // mono
+    bw_put(&bw, 15, 5);         // 16 bits per sample
+    bw_put(&bw, 0, 4);          // upper bits of the 36 bit sample count
+    bw_put(&bw, enc->samples, 32);
+    memset(enc->out + 8 + 18, 0, 16);   // MD5 not computed
+}
+
+bool app_flac_enc_init(app_flac_enc_t *enc, uint32_t sample_rate, uint8_t *out, size_t out_size)
+{
+    if (out_size < FLAC_HEADER_LEN || 0 == sample_rate || sample_rate >= (1u << 20)) {
+        return false;
+    }
+
+    enc->out = out;
+    enc->out_size = out_size;
+    enc->out_len = FLAC_HEADER_LEN;
+    enc->sample_rate = sample_rate;
+    enc->samples = 0;
+    enc->frames = 0;
+    enc->min_frame = UINT32_MAX;
+    enc->max_frame = 0;
+    enc->overflow = false;
+
+    memcpy(out, "fLaC", 4);
+    out[4] = 0x80;              // last metadata block, STREAMINFO
+    out[5] = 0;
+    out[6] = 0;
+    out[7] = FLAC_STREAMINFO_LEN;
+    flac_write_streaminfo(enc);
+    return true;
+}
+
+/* Pick the fixed predictor with the smallest absolute residual, -1 if the block is constant */
+static int flac_fixed_order(const int16_t *pcm, uint32_t num)
+{
+    uint64_t err[FLAC_MAX_FIXED_ORDER + 1] = { 0 };
+    bool constant = true;
+
+    for (uint32_t i = 1; i < num; i++) {
+        if (pcm[i] != pcm[0]) {
+            constant = false;
+            break;
+        }
+    }
+    if (constant) {
+        return -1;
+    }
+
+    for (uint32_t i = FLAC_MAX_FIXED_ORDER; i < num; i++) {
+        int32_t e0 = pcm[i];
+        int32_t e1 = e0 - pcm[i - 1];
+        int32_t e2 = e1 - (pcm[i - 1] - pcm[i - 2]);
+        int32_t e3 = e2 - (pcm[i - 1] - 2 * pcm[i - 2] + pcm[i - 3]);
+        int32_t e4 = e3 - (pcm[i - 1] - 3 * pcm[i - 2] + 3 * pcm[i - 3] - pcm[i - 4]);
+
+        err[0] += e0 < 0 ? -e0 : e0;
+        err[1] += e1 < 0 ? -e1 : e1;
+        err[2] += e2 < 0 ? -e2 : e2;
+        err[3] += e3 < 0 ? -e3 : e3;
+        err[4] += e4 < 0 ? -e4 : e4;
+    }
+
+    int order = 0;
+    uint32_t max_order = num > FLAC_MAX_FIXED_ORDER ? FLAC_MAX_FIXED_ORDER : num - 1;
+    for (uint32_t o = 1; o <= max_order; o++) {
+        if (err[o] < err[order]) {
+            order = o;
+        }
+    }
+    return order;
+}
+
+static void flac_fixed_residual(const int16_t *pcm, uint32_t num, int order, int32_t *res)
+{
+    for (uint32_t i = order; i < num; i++) {
+        switch (order) {
+        case 0:
+            res[i] = pcm[i];
+            break;
+        case 1:
+            res[i] = pcm[i] - pcm[i - 1];
+            break;
+        case 2:
+            res[i] = pcm[i] - 2 * pcm[i - 1] + pcm[i - 2];
+            break;
+        case 3:
+            res[i] = pcm[i] - 3 * pcm[i - 1] + 3 * pcm[i - 2] - pcm[i - 3];
+            break;
+        default:
+            res[i] = pcm[i] - 4 * pcm[i - 1] + 6 * pcm[i - 2] - 4 * pcm[i - 3] + pcm[i - 4];
+            break;
+        }
+    }
+}
+
+/* Rice parameter and estimated bits for a partition given the sum of its zigzag residuals */
+static uint32_t flac_rice_param(uint64_t sum, uint32_t count, uint64_t *bits)
+{
+    uint32_t k = 0;
+
+    if (0 == count) {
+        *bits = 4;
+        return 0;
+    }
+    while (k < FLAC_MAX_RICE_PARAM && ((uint64_t)count << (k + 1)) <= sum) {
+        k++;
+    }
+    *bits = 4 + (uint64_t)count * (k + 1) + (sum >> k);
+    return k;
+}
+
+/* Estimated residual bits, the partition order and the parameters are returned for the writer */
+static uint64_t flac_plan_residual(const int32_t *res, uint32_t num, int order, uint32_t *ret_porder, uint32_t *params)
+{
+    uint64_t sums[1 << APP_FLAC_MAX_PARTITION_ORDER];
+    uint32_t max_porder = 0;
+
+    while (max_porder < APP_FLAC_MAX_PARTITION_ORDER && 0 == (num & (1u << max_porder))
+            && (num >> (max_porder + 1)) > (uint32_t)order) {
+        max_porder++;
+    }
+
+    uint32_t parts = 1u << max_porder;
+    uint32_t part_len = num >> max_porder;
+    for (uint32_t p = 0, i = order; p < parts; p++) {
+        uint64_t sum = 0;
+        for (uint32_t end = (p + 1) * part_len; i < end; i++) {
+            sum += ((uint32_t)res[i] << 1) ^ (uint32_t)(res[i] >> 31);
+        }
+        sums[p] = sum;
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (int porder = max_porder; porder >= 0; porder--) {
+        uint32_t n = 1u << porder;
+        uint32_t len = num >> porder;
+        uint32_t k[1 << APP_FLAC_MAX_PARTITION_ORDER];
+        uint64_t total = 6;
+
+        for (uint32_t p = 0; p < n; p++) {
+            uint64_t bits;
+            k[p] = flac_rice_param(sums[p], p ? len : len - order, &bits);
+            total += bits;
+        }
+        if (total < best) {
+            best = total;
+            *ret_porder = porder;
+            memcpy(params, k, n * sizeof(uint32_t));
+        }
+        /* Merge pairs for the next lower order */
+        for (uint32_t p = 0; p < n / 2; p++) {
+            sums[p] = sums[2 * p] + sums[2 * p + 1];
+        }
+    }
+    return best;
+}
+
+static void flac_write_utf8(bit_writer_t *bw, uint32_t val)
+{
+    if (val < 0x80) {
+        bw_put(bw, val, 8);
+        return;
+    }
+
+    int extra = val < 0x800 ? 1 : val < 0x10000 ? 2 : val < 0x200000 ? 3 : val < 0x4000000 ? 4 : 5;
+    uint32_t lead = (0xFF00u >> (extra + 1)) & 0xFF;
+
+    bw_put(bw, lead | (val >> (6 * extra)), 8);
+    for (int i = extra - 1; i >= 0; i--) {
+        bw_put(bw, 0x80 | ((val >> (6 * i)) & 0x3F), 8);
+    }
+}
+
+bool app_flac_enc_block(app_flac_enc_t *enc, const int16_t *pcm, uint32_t num)
+{
+    if (enc->overflow || 0 == num || num > APP_FLAC_BLOCK_SIZE) {
+        return false;
+    }
+
+    size_t start = enc->out_len;
+    bit_writer_t bw = {
+        .buf = enc->out + start,
+        .cap = enc->out_size - start,
+    };
+
+    /* Frame header, fixed block size so the frame number is coded */
+    bw_put(&bw, 0xFFF8, 16);
+    uint32_t rate_code = flac_sample_rate_code(enc->sample_rate);
+    bw_put(&bw, APP_FLAC_BLOCK_SIZE == num ? 12 : 7, 4);
+    bw_put(&bw, rate_code, 4);
+    bw_put(&bw, 0x08, 8);       // mono, 16 bits
+    flac_write_utf8(&bw, enc->frames);
+    if (APP_FLAC_BLOCK_SIZE != num) {
+        bw_put(&bw, num - 1, 16);
+    }
+    if (bw.overflow) {
+        enc->overflow = true;
+        return false;
+    }
+    bw_put(&bw, flac_crc8(bw.buf, bw.pos), 8);
+
+    /* Subframe */
+    int order = flac_fixed_order(pcm, num);
+    if (order < 0) {
+        bw_put(&bw, 0x00, 8);
+        bw_put(&bw, (uint16_t)pcm[0], 16);
+    } else {
+        uint32_t porder = 0;
+        uint32_t params[1 << APP_FLAC_MAX_PARTITION_ORDER];
+
+        flac_fixed_residual(pcm, num, order, enc->residual);
+        uint64_t bits = 16 * order + flac_plan_residual(enc->residual, num, order, &porder, params);
+        if (bits >= 16 * num) {
+            bw_put(&bw, 0x02, 8);   // verbatim
+            for (uint32_t i = 0; i < num; i++) {
+                bw_put(&bw, (uint16_t)pcm[i], 16);
+            }
+        } else {
+            bw_put(&bw, (0x08 | order) << 1, 8);
+            for (int i = 0; i < order; i++) {
+                bw_put(&bw, (uint16_t)pcm[i], 16);
+            }
+            bw_put(&bw, 0, 2);      // Rice coding with 4 bit parameters
+            bw_put(&bw, porder, 4);
+            uint32_t len = num >> porder;
+            for (uint32_t p = 0, i = order; p < (1u << porder); p++) {
+                bw_put(&bw, params[p], 4);
+                for (uint32_t end = (p + 1) * len; i < end; i++) {
+                    bw_put_rice(&bw, enc->residual[i], params[p]);
+                }
+            }
+        }
+    }
+
+    bw_align(&bw);
+    uint16_t crc = flac_crc16(bw.buf, bw.pos);
+    bw_put(&bw, crc, 16);
+    if (bw.overflow) {
+        enc->overflow = true;
+        return false;
+    }
+
+    uint32_t frame_len = bw.pos;
+    enc->min_frame = frame_len < enc->min_frame ? frame_len : enc->min_frame;
+    enc->max_frame = frame_len > enc->max_frame ? frame_len : enc->max_frame;
+    enc->out_len += frame_len;
+    enc->samples += num;
+    enc->frames++;
+    return true;
+}
+
+size_t app_flac_enc_finish(app_flac_enc_t *enc)
+{
+    flac_write_streaminfo(enc);
+    return enc->out_len;
+}
@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_FLAC_BLOCK_SIZE         (4096)
+#define APP_FLAC_MAX_PARTITION_ORDER (6)
+
+/* Mono 16-bit FLAC encoder with fixed predictors, one call per block so it can follow a recording */
+typedef struct {
+    uint8_t *out;
+    size_t out_size;
+    size_t out_len;
+    uint32_t sample_rate;
+    uint32_t samples;
+    uint32_t frames;
+    uint32_t min_frame;
+    uint32_t max_frame;
+    bool overflow;
+    int32_t residual[APP_FLAC_BLOCK_SIZE];
+} app_flac_enc_t;
+
+/**
+ * @brief Start a stream, the FLAC signature and STREAMINFO are written to out
+ *
+ * @note The encoder holds a block of residuals, it is best allocated in PSRAM
+ */
+bool app_flac_enc_init(app_flac_enc_t *enc, uint32_t sample_rate, uint8_t *out, size_t out_size);
+
+/**
+ * @brief Encode one frame
+ *
+ * @param num   Samples in the block, APP_FLAC_BLOCK_SIZE except for the last one
+ *
+ * @return false once the output buffer is full, the frames already written stay a valid stream
+ */
+bool app_flac_enc_block(app_flac_enc_t *enc, const int16_t *pcm, uint32_t num);
+
+/**
+ * @brief End the stream, STREAMINFO is completed with the totals
+ *
+ * @return Length of the stream in out
+ */
+size_t app_flac_enc_finish(app_flac_enc_t *enc);
+
+#ifdef __cplusplus
+}
+#endif
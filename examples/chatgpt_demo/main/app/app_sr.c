@@ -77,16 +77,17 @@ static void audio_feed_task(void *arg)
 
             /* Feed samples of an audio stream to the AFE_SR */
             afe_handle->feed(afe_data, audio_buffer);
+
+            /* Recorded along with the feed, so VAD results line up with the recording */
+            audio_record_save(audio_buffer, audio_chunksize);
         }
-        audio_record_save(audio_buffer, audio_chunksize);
     }
 }
 
 static void audio_detect_task(void *arg)
 {
     ESP_LOGI(TAG, "Detection task");
-    static afe_vad_state_t local_state;
-    static uint8_t frame_keep = 0;
+    uint32_t fetched_samples = 0;   // runs in step with the samples fed, places VAD frames in the recording
 
     bool detect_flag = false;
     esp_afe_sr_data_t *afe_data = arg;
@@ -101,6 +102,9 @@ static void audio_detect_task(void *arg)
         if (!res || res->ret_value == ESP_FAIL) {
             continue;
         }
+        uint32_t frame_samples = res->data_size / sizeof(int16_t);
+        fetched_samples += frame_samples;
+
         if (res->wakeup_state == WAKENET_DETECTED) {
             ESP_LOGI(TAG,  "wakeword detected");
             sr_result_t result = {
@@ -120,21 +124,12 @@ static void audio_detect_task(void *arg)
                 };
                 xQueueSend(g_sr_data->result_que, &result, 0);
             }
-            frame_keep = 0;
             g_sr_data->afe_handle->disable_wakenet(afe_data);
             ESP_LOGI(TAG,  "AFE_FETCH_CHANNEL_VERIFIED, channel index: %d\n", res->trigger_channel_id);
         }
 
         if (true == detect_flag) {
-
-            if (local_state != res->vad_state) {
-                local_state = res->vad_state;
-                frame_keep = 0;
-            } else {
-                frame_keep++;
-            }
-
-            if ((100 == frame_keep) && (AFE_VAD_SILENCE == res->vad_state)) {
+            if (audio_record_vad(AFE_VAD_SPEECH == res->vad_state, fetched_samples, frame_samples)) {
                 sr_result_t result = {
                     .wakenet_mode = WAKENET_NO_DETECT,
                     .state = ESP_MN_STATE_TIMEOUT,
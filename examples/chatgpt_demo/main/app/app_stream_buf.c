@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "app_stream_buf.h"
+
+/* Positions count bytes from the start of the stream, the ring holds [wr - size, wr) */
+struct app_stream_buf_t {
+    uint8_t *data;
+    app_stream_buf_cfg_t cfg;
+    size_t wr;
+    size_t rd;
+    size_t low;                 // oldest byte still in the ring, lower bound for seeks
+    bool pinned;                // the head up to cfg.pin is kept, the reader did not get past it yet
+    bool started;               // prebuffer reached once
+    bool stalled;
+    bool finished;
+    bool aborted;
+    uint32_t stalls;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t readable;
+    SemaphoreHandle_t writable;
+};
+
+static const char *TAG = "stream_buf";
+
+esp_err_t app_stream_buf_create(const app_stream_buf_cfg_t *cfg, app_stream_buf_handle_t *ret_handle)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(cfg && ret_handle && cfg->size, ESP_ERR_INVALID_ARG, TAG, "invalid config");
+
+    struct app_stream_buf_t *sb = calloc(1, sizeof(struct app_stream_buf_t));
+    ESP_RETURN_ON_FALSE(NULL != sb, ESP_ERR_NO_MEM, TAG, "no mem for stream buffer");
+
+    sb->cfg = *cfg;
+    if (sb->cfg.prebuffer > sb->cfg.size) {
+        sb->cfg.prebuffer = sb->cfg.size;
+    }
+    if (sb->cfg.pin > sb->cfg.size) {
+        sb->cfg.pin = sb->cfg.size;
+    }
+    sb->pinned = sb->cfg.pin > 0;
+    sb->data = heap_caps_malloc(cfg->size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    sb->lock = xSemaphoreCreateMutex();
+    sb->readable = xSemaphoreCreateBinary();
+    sb->writable = xSemaphoreCreateBinary();
+    ESP_GOTO_ON_FALSE(sb->data && sb->lock && sb->readable && sb->writable, ESP_ERR_NO_MEM, err, TAG, "no mem for ring");
+
+    *ret_handle = sb;
+    return ESP_OK;
+
+err:
+    app_stream_buf_delete(sb);
+    return ret;
+}
+
+void app_stream_buf_delete(app_stream_buf_handle_t handle)
+{
+    if (NULL == handle) {
+        return;
+    }
+    if (handle->writable) {
+        vSemaphoreDelete(handle->writable);
+    }
+    if (handle->readable) {
+        vSemaphoreDelete(handle->readable);
+    }
+    if (handle->lock) {
+        vSemaphoreDelete(handle->lock);
+    }
+    free(handle->data);
+    free(handle);
+}
+
+void app_stream_buf_reset(app_stream_buf_handle_t handle)
+{
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->wr = 0;
+    handle->rd = 0;
+    handle->low = 0;
+    handle->pinned = handle->cfg.pin > 0;
+    handle->started = false;
+    handle->stalled = false;
+    handle->finished = false;
+    handle->aborted = false;
+    handle->stalls = 0;
+    xSemaphoreTake(handle->readable, 0);
+    xSemaphoreTake(handle->writable, 0);
+    xSemaphoreGive(handle->lock);
+}
+
+esp_err_t app_stream_buf_write(app_stream_buf_handle_t handle, const void *data, size_t len, TickType_t timeout)
+{
+    const uint8_t *src = (const uint8_t *)data;
+    size_t size = handle->cfg.size;
+
+    while (len) {
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        if (handle->aborted) {
+            xSemaphoreGive(handle->lock);
+            return ESP_ERR_INVALID_STATE;
+        }
+
+        /* Bytes the reader consumed may be overwritten, the rest and a pinned head may not */
+        size_t keep = handle->pinned ? 0 : handle->rd;
+        size_t space = size - (handle->wr - keep);
+        if (0 == space) {
+            xSemaphoreGive(handle->lock);
+            if (pdTRUE != xSemaphoreTake(handle->writable, timeout)) {
+                return ESP_ERR_TIMEOUT;
+            }
+            continue;
+        }
+
+        size_t n = len < space ? len : space;
+        size_t offset = handle->wr % size;
+        size_t first = (size - offset) < n ? (size - offset) : n;
+        memcpy(handle->data + offset, src, first);
+        memcpy(handle->data, src + first, n - first);
+        handle->wr += n;
+        if (handle->wr - handle->low > size) {
+            handle->low = handle->wr - size;
+        }
+        xSemaphoreGive(handle->lock);
+        xSemaphoreGive(handle->readable);
+
+        src += n;
+        len -= n;
+    }
+    return ESP_OK;
+}
+
+void app_stream_buf_finish(app_stream_buf_handle_t handle)
+{
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->finished = true;
+    xSemaphoreGive(handle->lock);
+    xSemaphoreGive(handle->readable);
+}
+
+void app_stream_buf_abort(app_stream_buf_handle_t handle)
+{
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->aborted = true;
+    xSemaphoreGive(handle->lock);
+    xSemaphoreGive(handle->readable);
+    xSemaphoreGive(handle->writable);
+}
+
+uint32_t app_stream_buf_get_stalls(app_stream_buf_handle_t handle)
+{
+    return handle->stalls;
+}
+
+static void stream_buf_notify(app_stream_buf_handle_t handle, app_stream_buf_event_t event)
+{
+    if (handle->cfg.cb) {
+        handle->cfg.cb(event, handle->cfg.cb_args);
+    }
+}
+
+static ssize_t stream_buf_read(void *cookie, char *buf, size_t size)
+{
+    app_stream_buf_handle_t handle = (app_stream_buf_handle_t)cookie;
+    size_t ring = handle->cfg.size;
+
+    while (true) {
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        size_t avail = handle->wr - handle->rd;
+        bool ended = handle->finished || handle->aborted;
+
+        if (ended || (handle->started ? avail > 0 : avail >= handle->cfg.prebuffer)) {
+            bool resumed = handle->stalled;
+            size_t n = handle->aborted ? 0 : (size < avail ? size : avail);
+            size_t offset = handle->rd % ring;
+            size_t first = (ring - offset) < n ? (ring - offset) : n;
+
+            memcpy(buf, handle->data + offset, first);
+            memcpy(buf + first, handle->data, n - first);
+            handle->rd += n;
+            if (handle->pinned && handle->rd > handle->cfg.pin) {
+                handle->pinned = false;     // past the probe, the head may go
+            }
+            handle->started = true;
+            handle->stalled = false;
+            xSemaphoreGive(handle->lock);
+            xSemaphoreGive(handle->writable);
+
+            if (resumed) {
+                stream_buf_notify(handle, APP_STREAM_BUF_EVENT_RESUME);
+            }
+            return n;
+        }
+
+        bool stall = handle->started && !handle->stalled;
+        if (stall) {
+            handle->stalled = true;
+            handle->stalls++;
+        }
+        xSemaphoreGive(handle->lock);
+
+        if (stall) {
+            stream_buf_notify(handle, APP_STREAM_BUF_EVENT_STALL);
+        }
+        xSemaphoreTake(handle->readable, portMAX_DELAY);
+    }
+}
+
+static int stream_buf_seek(void *cookie, _off64_t *pos, int whence)
+{
+    app_stream_buf_handle_t handle = (app_stream_buf_handle_t)cookie;
+    int ret = 0;
+    _off64_t target = *pos;
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    switch (whence) {
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        target += handle->rd;
+        break;
+    case SEEK_END:
+        /* The end is only known once the writer is done */
+        target = handle->finished ? target + (_off64_t)handle->wr : -1;
+        break;
+    default:
+        target = -1;
+        break;
+    }
+
+    if (target < (_off64_t)handle->low || target > (_off64_t)handle->wr) {
+        ret = -1;
+    } else {
+        handle->rd = target;
+        *pos = target;
+    }
+    xSemaphoreGive(handle->lock);
+    return ret;
+}
+
+FILE *app_stream_buf_fopen(app_stream_buf_handle_t handle)
+{
+    cookie_io_functions_t io = {
+        .read = stream_buf_read,
+        .write = NULL,
+        .seek = stream_buf_seek,
+        .close = NULL,
+    };
+
+    return fopencookie(handle, "rb", io);
+}
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct app_stream_buf_t *app_stream_buf_handle_t;
+
+typedef enum {
+    APP_STREAM_BUF_EVENT_STALL = 0,     /*!< The reader ran dry after the prebuffer, it waits for the writer */
+    APP_STREAM_BUF_EVENT_RESUME,        /*!< Data arrived again after a stall */
+} app_stream_buf_event_t;
+
+typedef void (*app_stream_buf_cb_t)(app_stream_buf_event_t event, void *args);
+
+typedef struct {
+    size_t size;                        /*!< Ring size, the memory used whatever the length of the stream */
+    size_t prebuffer;                   /*!< Bytes buffered before the first read returns */
+    size_t pin;                         /*!< Bytes at the head of the stream kept until the reader got past them,
+                                             so a decoder may probe the format and seek back to 0 */
+    app_stream_buf_cb_t cb;             /*!< Called from the reader task */
+    void *cb_args;
+} app_stream_buf_cfg_t;
+
+/**
+ * @brief Create a bounded buffer connecting a network writer to a FILE reader
+ */
+esp_err_t app_stream_buf_create(const app_stream_buf_cfg_t *cfg, app_stream_buf_handle_t *ret_handle);
+
+void app_stream_buf_delete(app_stream_buf_handle_t handle);
+
+/**
+ * @brief Empty the buffer for a new stream, neither side may be using it
+ */
+void app_stream_buf_reset(app_stream_buf_handle_t handle);
+
+/**
+ * @brief Append data, waiting for the reader while the ring is full
+ *
+ * @return
+ *      - ESP_OK                 All data written
+ *      - ESP_ERR_TIMEOUT        The reader did not make room in time
+ *      - ESP_ERR_INVALID_STATE  The stream was aborted
+ */
+esp_err_t app_stream_buf_write(app_stream_buf_handle_t handle, const void *data, size_t len, TickType_t timeout);
+
+/**
+ * @brief End of stream, the reader gets EOF once it consumed everything
+ */
+void app_stream_buf_finish(app_stream_buf_handle_t handle);
+
+/**
+ * @brief Give up on the stream, both sides are released at once
+ */
+void app_stream_buf_abort(app_stream_buf_handle_t handle);
+
+/**
+ * @brief Open the read side as a FILE, reads block on underrun instead of failing
+ *
+ * Seeking is possible within the part of the stream still held by the ring, and back to 0
+ * until the reader got past the pinned head.
+ */
+FILE *app_stream_buf_fopen(app_stream_buf_handle_t handle);
+
+/**
+ * @brief Underruns since the last reset
+ */
+uint32_t app_stream_buf_get_stalls(app_stream_buf_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
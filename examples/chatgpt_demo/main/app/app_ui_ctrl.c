@@ -7,6 +7,7 @@
 #include "esp_log.h"
 
 #include "app_ui_ctrl.h"
+#include "app_ui_text.h"
 #include "app_wifi.h"
 #include "bsp/esp-bsp.h"
 
@@ -17,19 +18,15 @@
 #define LABEL_NOT_WIFI_TEXT                 "Not Connected to Wi-Fi\n"
 #define LABEL_WIFI_DOT_COUNT_MAX        (10)
 #define WIFI_CHECK_TIMER_INTERVAL_S     (1)
-#define REPLY_SCROLL_TIMER_INTERVAL_MS  (1000)
-#define REPLY_SCROLL_SPEED              (1)
+#define REPLY_SLEEP_DELAY_MS            (1000)
 
 static char *TAG = "ui_ctrl";
 
 static ui_ctrl_panel_t current_panel = UI_CTRL_PANEL_SLEEP;
-static lv_timer_t *scroll_timer_handle = NULL;
 static bool reply_audio_start = false;
-static bool reply_audio_end = false;
-static bool reply_content_get = false;
-static uint16_t content_height = 0;
+static lv_coord_t content_height = 0;
+static app_ui_text_stream_t reply_stream;
 
-static void reply_content_scroll_timer_handler();
 static void wifi_check_timer_handler(lv_timer_t *timer);
 
 void ui_ctrl_init(void)
@@ -38,9 +35,6 @@ void ui_ctrl_init(void)
 
     ui_init();
 
-    scroll_timer_handle = lv_timer_create(reply_content_scroll_timer_handler, REPLY_SCROLL_TIMER_INTERVAL_MS / REPLY_SCROLL_SPEED, NULL);
-    lv_timer_pause(scroll_timer_handle);
-
     lv_timer_create(wifi_check_timer_handler, WIFI_CHECK_TIMER_INTERVAL_S * 1000, NULL);
 
     bsp_display_unlock();
@@ -89,11 +83,8 @@ static void show_panel_timer_handler(struct _lv_timer_t *t)
         hide_panel[2] = ui_PanelReply;
         lv_obj_clear_flag(ui_LabelListenSpeak, LV_OBJ_FLAG_HIDDEN);
         lv_label_set_text(ui_LabelListenSpeak, "Listening ...");
-        // Reset flags and timer of reply
-        reply_content_get = false;
+        // Reset flags of reply
         reply_audio_start = false;
-        reply_audio_end = false;
-        lv_timer_pause(scroll_timer_handle);
         break;
     case UI_CTRL_PANEL_GET:
         show_panel = ui_PanelGet;
@@ -148,39 +139,47 @@ void ui_ctrl_show_panel(ui_ctrl_panel_t panel, uint16_t timeout)
     bsp_display_unlock();
 }
 
-static void reply_content_show_text(const char *text)
+/* Keep the newest text in view once the reply is being spoken, the label grew by what was appended */
+static void reply_content_scroll(void)
 {
-    if (NULL == text) {
-        return;
+    lv_coord_t view = lv_obj_get_height(ui_ContainerReplyContent);
+
+    content_height = lv_obj_get_self_height(ui_LabelReplyContent);
+    if (reply_audio_start && content_height > view) {
+        lv_obj_scroll_to_y(ui_ContainerReplyContent, content_height - view, LV_ANIM_ON);
     }
+}
 
+static void reply_content_show_text(const char *text)
+{
     char *decode = heap_caps_malloc((strlen(text) + 1), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     assert(decode);
 
-    int j = 0;
-    for (int i = 0; i < strlen(text);) {
-        if ((*(text + i) == '\\') && ((i + 1) < strlen(text)) && (*(text + i + 1) == 'n')) {
-            *(decode + j++) = '\n';
-            i += 2;
-        } else {
-            *(decode + j++) = *(text + i);
-            i += 1;
-        }
-    }
-    *(decode + j) = '\0';
-
-    ESP_LOGI(TAG, "decode:[%d, %d] %s\r\n", j, strlen(decode), decode);
+    size_t len = app_ui_text_decode(decode, text);
+    ESP_LOGI(TAG, "reply content: %zu chars", len);
 
     lv_label_set_text(ui_LabelReplyContent, decode);
-    content_height = lv_obj_get_self_height(ui_LabelReplyContent);
+    memset(&reply_stream, 0, sizeof(reply_stream));
     lv_obj_scroll_to_y(ui_ContainerReplyContent, 0, LV_ANIM_OFF);
-    reply_content_get = true;
-    lv_timer_resume(scroll_timer_handle);
-    ESP_LOGI(TAG, "reply scroll timer start");
+    content_height = lv_obj_get_self_height(ui_LabelReplyContent);
+    free(decode);
+}
 
-    if (decode) {
-        free(decode);
+/*
+ * Only the new chunk is decoded and copied, the text already shown stays as it is. A chunk ending on the '' of a
+ * "
+" keeps it for the next one.
+ */
+static void reply_content_append_text(const char *text)
+{
+    char *decode = heap_caps_malloc((strlen(text) + 2), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    assert(decode);
+
+    if (app_ui_text_decode_chunk(&reply_stream, decode, text)) {
+        lv_label_ins_text(ui_LabelReplyContent, LV_LABEL_POS_LAST, decode);
+        reply_content_scroll();
     }
+    free(decode);
 }
 
 void ui_ctrl_label_show_text(ui_ctrl_label_t label, const char *text)
@@ -209,6 +208,29 @@ void ui_ctrl_label_show_text(ui_ctrl_label_t label, const char *text)
     bsp_display_unlock();
 }
 
+void ui_ctrl_label_append_text(ui_ctrl_label_t label, const char *text)
+{
+    bsp_display_lock(0);
+
+    if (text != NULL) {
+        switch (label) {
+        case UI_CTRL_LABEL_LISTEN_SPEAK:
+            lv_label_ins_text(ui_LabelListenSpeak, LV_LABEL_POS_LAST, text);
+            break;
+        case UI_CTRL_LABEL_REPLY_QUESTION:
+            lv_label_ins_text(ui_LabelReplyQuestion, LV_LABEL_POS_LAST, text);
+            break;
+        case UI_CTRL_LABEL_REPLY_CONTENT:
+            reply_content_append_text(text);
+            break;
+        default:
+            break;
+        }
+    }
+
+    bsp_display_unlock();
+}
+
 static void anim_callback_set_bg_img_opacity(lv_anim_t *a, int32_t v)
 {
     ui_anim_user_data_t *usr = (ui_anim_user_data_t *)a->user_data;
@@ -270,7 +292,12 @@ void ui_sleep_show_animation(void)
 
 void ui_ctrl_reply_set_audio_start_flag(bool result)
 {
+    bsp_display_lock(0);
     reply_audio_start = result;
+    if (result) {
+        reply_content_scroll();
+    }
+    bsp_display_unlock();
 }
 
 bool ui_ctrl_reply_get_audio_start_flag(void)
@@ -280,30 +307,10 @@ bool ui_ctrl_reply_get_audio_start_flag(void)
 
 void ui_ctrl_reply_set_audio_end_flag(bool result)
 {
-    reply_audio_end = result;
-}
-
-static void reply_content_scroll_timer_handler()
-{
-    lv_coord_t offset = 0;
-    const lv_font_t *font = NULL;
-
-    if (reply_content_get && reply_audio_start) {
-        font = lv_obj_get_style_text_font(ui_LabelReplyContent, 0);
-        offset = lv_obj_get_scroll_y(ui_ContainerReplyContent);
-        // ESP_LOGI(TAG, "offset: %d, content_height: %d, font_height: %d", offset, content_height, font->line_height);
-        if ((content_height > lv_obj_get_height(ui_ContainerReplyContent)) &&
-                (offset < (content_height - lv_obj_get_height(ui_ContainerReplyContent)))) {
-            offset += font->line_height / 2;
-            lv_obj_scroll_to_y(ui_ContainerReplyContent, offset, LV_ANIM_OFF);
-        } else if (reply_audio_end) {
-            ESP_LOGI(TAG, "reply scroll timer stop");
-            reply_content_get = false;
-            reply_audio_start = false;
-            reply_audio_end = false;
-            lv_timer_pause(scroll_timer_handle);
-            ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, 1000);
-        }
+    if (result) {
+        // The newest text was scrolled into view as it arrived, nothing is left to show
+        ESP_LOGI(TAG, "reply end");
+        ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, REPLY_SLEEP_DELAY_MS);
     }
 }
 
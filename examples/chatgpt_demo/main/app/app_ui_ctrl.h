@@ -31,6 +31,8 @@ void ui_ctrl_show_panel(ui_ctrl_panel_t panel, uint16_t timeout);
 
 void ui_ctrl_label_show_text(ui_ctrl_label_t label, const char *text);
 
+void ui_ctrl_label_append_text(ui_ctrl_label_t label, const char *text);
+
 void ui_sleep_show_animation(void);
 
 void ui_ctrl_reply_set_audio_start_flag(bool result);
@@ -0,0 +1,52 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#include "app_ui_text.h"
+
+/* Stops before a '\' ending src when hold is set and returns whether it did */
+static bool decode(char **dst, const char *src, bool hold)
+{
+    char *out = *dst;
+
+    while (*src) {
+        if ('\\' == src[0] && 'n' == src[1]) {
+            *out++ = '\n';
+            src += 2;
+        } else if (hold && '\\' == src[0] && '\0' == src[1]) {
+            break;
+        } else {
+            *out++ = *src++;
+        }
+    }
+    *out = '\0';
+    *dst = out;
+    return '\0' != *src;
+}
+
+size_t app_ui_text_decode(char *dst, const char *src)
+{
+    char *out = dst;
+
+    decode(&out, src, false);
+    return out - dst;
+}
+
+size_t app_ui_text_decode_chunk(app_ui_text_stream_t *stream, char *dst, const char *src)
+{
+    char *out = dst;
+
+    if (stream->backslash && *src) {
+        stream->backslash = false;
+        if ('n' == *src) {
+            *out++ = '\n';
+            src++;
+        } else {
+            *out++ = '\\';
+        }
+    }
+    stream->backslash |= decode(&out, src, true);
+    return out - dst;
+}
@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Decode the "\n" escapes replies may carry, in a single pass
+ *
+ * @param dst   At least strlen(src) + 1 bytes, may not overlap src
+ *
+ * @return The decoded length
+ */
+size_t app_ui_text_decode(char *dst, const char *src);
+
+/**
+ * @brief State of a text decoded chunk by chunk, zero it before the first chunk
+ */
+typedef struct {
+    bool backslash;             /*!< The last chunk ended on a '\', held back until the next one tells if it is "\n" */
+} app_ui_text_stream_t;
+
+/**
+ * @brief Decode the next chunk of a streamed text, an escape split between two chunks is decoded with the second one
+ *
+ * The chunks decoded one after the other give the same text as app_ui_text_decode() on the whole, except that a
+ * text ending on a single '\' loses it.
+ *
+ * @param dst   At least strlen(src) + 2 bytes, may not overlap src
+ *
+ * @return The decoded length
+ */
+size_t app_ui_text_decode_chunk(app_ui_text_stream_t *stream, char *dst, const char *src);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* Speech endpointing on top of the AFE VAD, no driver calls so recorded VAD traces can be replayed on a host */
+
+#include <string.h>
+#include "app_vad.h"
+
+#define VAD_MS_TO_SAMPLES(vad, ms)      ((uint32_t)((uint64_t)(ms) * (vad)->cfg.sample_rate / 1000))
+
+void app_vad_reset(app_vad_t *vad, const app_vad_cfg_t *cfg)
+{
+    memset(vad, 0, sizeof(app_vad_t));
+    vad->cfg = *cfg;
+    vad->listen = UINT32_MAX;
+}
+
+void app_vad_listen(app_vad_t *vad, uint32_t pos)
+{
+    if (UINT32_MAX == vad->listen) {
+        vad->listen = pos;
+    }
+}
+
+app_vad_result_t app_vad_process(app_vad_t *vad, bool speech, uint32_t end, uint32_t samples)
+{
+    if (APP_VAD_CONTINUE != vad->result) {
+        return APP_VAD_CONTINUE;
+    }
+    vad->pos = end;
+    if (UINT32_MAX == vad->listen || end <= vad->listen) {
+        return APP_VAD_CONTINUE;
+    }
+
+    if (speech) {
+        if (!vad->heard) {
+            uint32_t start = end > samples ? end - samples : 0;
+            vad->speech_start = start > vad->listen ? start : vad->listen;
+            vad->heard = true;
+        }
+        vad->speech_end = end;
+    }
+
+    if (end >= vad->cfg.capacity) {
+        vad->result = vad->heard ? APP_VAD_END_MAX : APP_VAD_NO_SPEECH;
+    } else if (!vad->heard) {
+        if (end - vad->listen >= VAD_MS_TO_SAMPLES(vad, vad->cfg.no_speech_ms)) {
+            vad->result = APP_VAD_NO_SPEECH;
+        }
+    } else if (end - vad->speech_end >= VAD_MS_TO_SAMPLES(vad, vad->cfg.hangover_ms)) {
+        vad->result = APP_VAD_END_SILENCE;
+    } else if (end - vad->speech_start >= VAD_MS_TO_SAMPLES(vad, vad->cfg.max_speech_ms)) {
+        vad->result = APP_VAD_END_MAX;
+    }
+    return vad->result;
+}
+
+bool app_vad_get_range(const app_vad_t *vad, uint32_t *start, uint32_t *end)
+{
+    if (!vad->heard) {
+        return false;
+    }
+
+    uint32_t preroll = VAD_MS_TO_SAMPLES(vad, vad->cfg.preroll_ms);
+    uint32_t tail = vad->speech_end + VAD_MS_TO_SAMPLES(vad, vad->cfg.tail_ms);
+    uint32_t limit = vad->pos < vad->cfg.capacity ? vad->pos : vad->cfg.capacity;
+
+    *start = vad->speech_start - vad->listen > preroll ? vad->speech_start - preroll : vad->listen;
+    *end = tail < limit ? tail : limit;
+    return true;
+}
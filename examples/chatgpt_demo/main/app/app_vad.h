@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    APP_VAD_CONTINUE = 0,       /*!< Keep recording */
+    APP_VAD_END_SILENCE,        /*!< The user stopped speaking for the hangover time */
+    APP_VAD_END_MAX,            /*!< The utterance or the recording hit its maximum length */
+    APP_VAD_NO_SPEECH,          /*!< Nothing was said after the listening started */
+} app_vad_result_t;
+
+typedef struct {
+    uint32_t sample_rate;
+    uint32_t hangover_ms;       /*!< Silence after speech that ends the turn */
+    uint32_t preroll_ms;        /*!< Audio kept before the detected speech start */
+    uint32_t tail_ms;           /*!< Audio kept after the last speech frame */
+    uint32_t max_speech_ms;     /*!< Longest utterance */
+    uint32_t no_speech_ms;      /*!< Give up when nothing is said for this long */
+    uint32_t capacity;          /*!< Samples per channel the recording can hold */
+} app_vad_cfg_t;
+
+/* Positions are samples per channel since the recording started */
+typedef struct {
+    app_vad_cfg_t cfg;
+    uint32_t listen;            // VAD frames before this are ignored, the wake prompt is still playing
+    uint32_t pos;
+    uint32_t speech_start;
+    uint32_t speech_end;
+    bool heard;
+    app_vad_result_t result;
+} app_vad_t;
+
+/**
+ * @brief Start a new turn, frames are ignored until app_vad_listen()
+ */
+void app_vad_reset(app_vad_t *vad, const app_vad_cfg_t *cfg);
+
+/**
+ * @brief Start judging frames from this position on
+ */
+void app_vad_listen(app_vad_t *vad, uint32_t pos);
+
+/**
+ * @brief Feed the VAD decision of one frame
+ *
+ * @param speech    The frame was classified as speech
+ * @param end       Position right after the frame
+ * @param samples   Length of the frame
+ *
+ * @return The end of the turn, once, then APP_VAD_CONTINUE is never returned again
+ */
+app_vad_result_t app_vad_process(app_vad_t *vad, bool speech, uint32_t end, uint32_t samples);
+
+/**
+ * @brief Part of the recording worth uploading, pre-roll and tail included
+ *
+ * @return false if no speech was heard
+ */
+bool app_vad_get_range(const app_vad_t *vad, uint32_t *start, uint32_t *end);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,86 +13,65 @@
 #include "esp_check.h"
 #include "nvs_flash.h"
 #include "app_ui_ctrl.h"
-#include "OpenAI.h"
 #include "audio_player.h"
 #include "app_sr.h"
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 #include "bsp_board.h"
 #include "app_audio.h"
+#include "app_chat_stream.h"
 #include "app_wifi.h"
 #include "settings.h"
 
-#define SCROLL_START_DELAY_S            (1.5)
 #define LISTEN_SPEAK_PANEL_DELAY_MS     2000
-#define SERVER_ERROR                    "server_error"
-#define INVALID_REQUEST_ERROR           "invalid_request_error"
 #define SORRY_CANNOT_UNDERSTAND         "Sorry, I can't understand."
 #define API_KEY_NOT_VALID               "API Key is not valid"
 
 static char *TAG = "app_main";
 static sys_param_t *sys_param = NULL;
 
-/* program flow. This function is called in app_audio.c */
-esp_err_t start_openai(uint8_t *audio, int audio_len)
+static void chat_stream_event_cb(app_chat_stream_event_t event, const char *data)
 {
-    esp_err_t ret = ESP_OK;
-    static OpenAI_t *openai = NULL;
-    static OpenAI_AudioTranscription_t *audioTranscription = NULL;
-    static OpenAI_ChatCompletion_t *chatCompletion = NULL;
-    static OpenAI_AudioSpeech_t *audioSpeech = NULL;
-
-    OpenAI_SpeechResponse_t *speechresult = NULL;
-    OpenAI_StringResponse_t *result = NULL;
     FILE *fp = NULL;
 
-    if (openai == NULL) {
-        openai = OpenAICreate(sys_param->key);
-        ESP_RETURN_ON_FALSE(NULL != openai, ESP_ERR_INVALID_ARG, TAG, "OpenAICreate faield");
-
-        OpenAIChangeBaseURL(openai, sys_param->url);
-
-        audioTranscription = openai->audioTranscriptionCreate(openai);
-        chatCompletion = openai->chatCreate(openai);
-        audioSpeech = openai->audioSpeechCreate(openai);
-
-        audioTranscription->setResponseFormat(audioTranscription, OPENAI_AUDIO_RESPONSE_FORMAT_JSON);
-        audioTranscription->setLanguage(audioTranscription, "en");
-        audioTranscription->setTemperature(audioTranscription, 0.2);
-
-        chatCompletion->setModel(chatCompletion, "gpt-3.5-turbo");
-        chatCompletion->setSystem(chatCompletion, "user");
-        chatCompletion->setMaxTokens(chatCompletion, CONFIG_MAX_TOKEN);
-        chatCompletion->setTemperature(chatCompletion, 0.2);
-        chatCompletion->setStop(chatCompletion, "\r");
-        chatCompletion->setPresencePenalty(chatCompletion, 0);
-        chatCompletion->setFrequencyPenalty(chatCompletion, 0);
-        chatCompletion->setUser(chatCompletion, "OpenAI-ESP32");
-
-        audioSpeech->setModel(audioSpeech, "tts-1");
-        audioSpeech->setVoice(audioSpeech, "nova");
-        audioSpeech->setResponseFormat(audioSpeech, OPENAI_AUDIO_OUTPUT_FORMAT_MP3);
-        audioSpeech->setSpeed(audioSpeech, 1.0);
+    switch (event) {
+    case APP_CHAT_STREAM_EVENT_TEXT:
+        ui_ctrl_label_append_text(UI_CTRL_LABEL_REPLY_CONTENT, data);
+        ui_ctrl_show_panel(UI_CTRL_PANEL_REPLY, 0);
+        break;
+    case APP_CHAT_STREAM_EVENT_AUDIO_START:
+        ui_ctrl_reply_set_audio_start_flag(true);
+        break;
+    case APP_CHAT_STREAM_EVENT_AUDIO_END:
+        ESP_LOGI(TAG, "replay audio end");
+        if (ui_ctrl_reply_get_audio_start_flag()) {
+            ui_ctrl_reply_set_audio_end_flag(true);
+        }
+        break;
+    case APP_CHAT_STREAM_EVENT_TTS_FAILED:
+        /* Comes from the play task after the sentences that did get spoken */
+        ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, 5 * LISTEN_SPEAK_PANEL_DELAY_MS);
+        fp = fopen("/spiffs/tts_failed.mp3", "r");
+        if (fp) {
+            audio_player_play(fp);
+        }
+        break;
+    default:
+        break;
     }
+}
 
-    ui_ctrl_show_panel(UI_CTRL_PANEL_GET, 0);
-
-    // OpenAI Audio Transcription
-    char *text = audioTranscription->file(audioTranscription, (uint8_t *)audio, audio_len, OPENAI_AUDIO_INPUT_FORMAT_WAV);
-
-    if (NULL == text) {
-        ret = ESP_ERR_INVALID_RESPONSE;
-        ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, INVALID_REQUEST_ERROR);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[audioTranscription]: invalid url");
-    }
+/* program flow. This function is called in app_audio.c */
+esp_err_t start_openai(uint8_t *audio, int audio_len, const char *format)
+{
+    esp_err_t ret = ESP_OK;
+    char *text = NULL;
 
-    if (strstr(text, "\"code\": ")) {
-        ret = ESP_ERR_INVALID_RESPONSE;
-        ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, text);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[audioTranscription]: invalid response");
-    }
+    ui_ctrl_show_panel(UI_CTRL_PANEL_GET, 0);
 
-    if (strcmp(text, INVALID_REQUEST_ERROR) == 0 || strcmp(text, SERVER_ERROR) == 0) {
-        ret = ESP_ERR_INVALID_RESPONSE;
+    // Audio transcription, the recording is uploaded in the format it was encoded in while the user spoke
+    ret = app_chat_stream_transcribe(audio, audio_len, format, &text);
+    if (ESP_OK != ret) {
         ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, SORRY_CANNOT_UNDERSTAND);
         ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, LISTEN_SPEAK_PANEL_DELAY_MS);
         ESP_GOTO_ON_ERROR(ret, err, TAG, "[audioTranscription]: invalid response");
@@ -101,78 +80,20 @@ esp_err_t start_openai(uint8_t *audio, int audio_len)
     // UI listen success
     ui_ctrl_label_show_text(UI_CTRL_LABEL_REPLY_QUESTION, text);
     ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, text);
+    ui_ctrl_label_show_text(UI_CTRL_LABEL_REPLY_CONTENT, "");
 
-    // OpenAI Chat Completion
-    result = chatCompletion->message(chatCompletion, text, false);
-    if (NULL == result) {
-        ret = ESP_ERR_INVALID_RESPONSE;
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[chatCompletion]: invalid response");
-    }
-
-    char *response = result->getData(result, 0);
-
-    if (response != NULL && (strcmp(response, INVALID_REQUEST_ERROR) == 0 || strcmp(response, SERVER_ERROR) == 0)) {
-        // UI listen fail
-        ret = ESP_ERR_INVALID_RESPONSE;
-        ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, SORRY_CANNOT_UNDERSTAND);
-        ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, LISTEN_SPEAK_PANEL_DELAY_MS);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[chatCompletion]: invalid response");
-    }
-
-    // UI listen success
-    ui_ctrl_label_show_text(UI_CTRL_LABEL_REPLY_QUESTION, text);
-    ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, response);
-
-    if (strcmp(response, INVALID_REQUEST_ERROR) == 0) {
-        ret = ESP_ERR_INVALID_RESPONSE;
+    // Chat completion and speech overlap, the reply panel shows up with the first sentence
+    ret = app_chat_stream_reply(text);
+    if (ESP_ERR_INVALID_STATE == ret) {
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "[chatStream]: aborted by a new question");
+    } else if (ESP_OK != ret) {
         ui_ctrl_label_show_text(UI_CTRL_LABEL_LISTEN_SPEAK, SORRY_CANNOT_UNDERSTAND);
         ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, LISTEN_SPEAK_PANEL_DELAY_MS);
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[chatCompletion]: invalid response");
-    }
-
-    ui_ctrl_label_show_text(UI_CTRL_LABEL_REPLY_CONTENT, response);
-    ui_ctrl_show_panel(UI_CTRL_PANEL_REPLY, 0);
-
-    // OpenAI Speech Response
-    speechresult = audioSpeech->speech(audioSpeech, response);
-    if (NULL == speechresult) {
-        ret = ESP_ERR_INVALID_RESPONSE;
-        ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, 5 * LISTEN_SPEAK_PANEL_DELAY_MS);
-        fp = fopen("/spiffs/tts_failed.mp3", "r");
-        if (fp) {
-            audio_player_play(fp);
-        }
-        ESP_GOTO_ON_ERROR(ret, err, TAG, "[audioSpeech]: invalid response");
-    }
-
-    uint32_t dataLength = speechresult->getLen(speechresult);
-    char *speechptr = speechresult->getData(speechresult);
-    esp_err_t status = ESP_FAIL;
-    fp = fmemopen((void *)speechptr, dataLength, "rb");
-    if (fp) {
-        status = audio_player_play(fp);
-    }
-
-    if (status != ESP_OK) {
-        ESP_LOGE(TAG, "Error creating ChatGPT request: %s\n", esp_err_to_name(status));
-        // UI reply audio fail
-        ui_ctrl_show_panel(UI_CTRL_PANEL_SLEEP, 0);
-    } else {
-        // Wait a moment before starting to scroll the reply content
-        vTaskDelay(pdMS_TO_TICKS(SCROLL_START_DELAY_S * 1000));
-        ui_ctrl_reply_set_audio_start_flag(true);
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "[chatStream]: invalid response");
     }
 
 err:
     // Clearing resources
-    if (speechresult) {
-        speechresult->deleteResponse (speechresult);
-    }
-
-    if (result) {
-        result->deleteResponse (result);
-    }
-
     if (text) {
         free(text);
     }
@@ -183,10 +104,7 @@ err:
 
 static void audio_play_finish_cb(void)
 {
-    ESP_LOGI(TAG, "replay audio end");
-    if (ui_ctrl_reply_get_audio_start_flag()) {
-        ui_ctrl_reply_set_audio_end_flag(true);
-    }
+    app_chat_stream_play_idle();
 }
 
 void app_main()
@@ -206,12 +124,8 @@ void app_main()
 
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
     bsp_board_init();
 
@@ -219,6 +133,7 @@ void app_main()
     bsp_display_backlight_on();
     ui_ctrl_init();
     app_network_start();
+    ESP_ERROR_CHECK(app_chat_stream_init(sys_param->key, sys_param->url, chat_stream_event_cb));
 
     ESP_LOGI(TAG, "speech recognition start");
     app_sr_start(false);
@@ -0,0 +1,284 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Checks the rocker calibration record on an in-memory NVS: migration from the per-key values,
+ * power cuts at every write of a save with every tear length, corrupted slots, sequence number
+ * wrap, and the flash accesses of boot and save against the per-key storage.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "fake_nvs.h"
+
+/* Included so that a reboot can clear its RAM copy */
+#include "../main/app/app_nvs_flash.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+static void reboot(void)
+{
+    fake_nvs_power_on();
+    memset(&s_calib, 0, sizeof(s_calib));
+    s_calib_slot = -1;
+    s_calib_loaded = false;
+}
+
+static rocker_calib_record_t make_record(uint16_t base, uint16_t flags)
+{
+    rocker_calib_record_t record = { .flags = flags };
+    for (int i = 0; i < ROCKER_AXIS_MAX; i++) {
+        for (int j = 0; j < 3; j++) {
+            record.axis[i][j] = base + i * 100 + j * 1000;
+        }
+    }
+    return record;
+}
+
+static bool same_calib(const rocker_calib_record_t *a, const rocker_calib_record_t *b)
+{
+    return a->flags == b->flags && !memcmp(a->axis, b->axis, sizeof(a->axis));
+}
+
+/* What the previous firmware left in flash after a calibration in BLE mode */
+static void write_legacy(const rocker_calib_record_t *record)
+{
+    char value[10];
+    flash_write_state("hid_mode", "1");
+    for (int i = 0; i < ROCKER_AXIS_MAX; i++) {
+        for (int j = 0; j < 3; j++) {
+            snprintf(value, sizeof(value), "%d", record->axis[i][j]);
+            flash_write_state((char *) s_calib_legacy_key[i][j], value);
+        }
+    }
+    flash_write_state("calibrate_state", "1");
+}
+
+/* The boot of the previous firmware, see app_ui_event.c before the record */
+static void read_legacy(void)
+{
+    read_rocker_value_from_flash("hid_mode");
+    for (int pass = 0; pass < 2; pass++) {
+        if (1 == read_rocker_value_from_flash("calibrate_state")) {
+            for (int i = 0; i < ROCKER_AXIS_MAX; i++) {
+                for (int j = 0; j < 3; j++) {
+                    read_rocker_value_from_flash((char *) s_calib_legacy_key[i][j]);
+                }
+            }
+        }
+    }
+}
+
+static bool test_empty(void)
+{
+    rocker_calib_record_t record;
+    fake_nvs_reset();
+    reboot();
+    CHECK(ESP_ERR_NOT_FOUND == rocker_calib_load(&record), "empty flash loaded a record");
+    CHECK(!(record.flags & ROCKER_CALIB_FLAG_VALID), "empty flash is calibrated");
+    return true;
+}
+
+static bool test_migrate(void)
+{
+    rocker_calib_record_t legacy = make_record(11, ROCKER_CALIB_FLAG_VALID | ROCKER_CALIB_FLAG_BLE);
+    rocker_calib_record_t record;
+    fake_nvs_stats_t stats;
+
+    fake_nvs_reset();
+    write_legacy(&legacy);
+    reboot();
+    CHECK(ESP_OK == rocker_calib_load(&record), "per-key values not migrated");
+    CHECK(same_calib(&record, &legacy), "migrated values differ");
+
+    reboot();
+    fake_nvs_reset_stats();
+    CHECK(ESP_OK == rocker_calib_load(&record) && same_calib(&record, &legacy), "migrated record lost");
+    fake_nvs_get_stats(&stats);
+    CHECK(0 == stats.writes && stats.reads <= ROCKER_CALIB_SLOT_NUM, "second boot migrated again, %u reads %u writes",
+          (unsigned) stats.reads, (unsigned) stats.writes);
+    return true;
+}
+
+/* A save interrupted at any write and any byte keeps the previous calibration or the new one */
+static bool test_power_cut(void)
+{
+    rocker_calib_record_t old_calib = make_record(100, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t new_calib = make_record(200, ROCKER_CALIB_FLAG_VALID | ROCKER_CALIB_FLAG_BLE);
+    rocker_calib_record_t next_calib = make_record(300, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t record;
+    const size_t tears[] = { 0, 1, 4, 8, sizeof(record) / 2, sizeof(record) - 4, sizeof(record) - 1, sizeof(record) };
+    int cases = 0;
+
+    for (int history = 1; history <= 3; history++) {
+        for (uint32_t cut = 0; cut < 2; cut++) {
+            for (size_t t = 0; t < sizeof(tears) / sizeof(tears[0]); t++) {
+                fake_nvs_reset();
+                reboot();
+                rocker_calib_load(&record);
+                /* 1 to 3 earlier saves, so both slot orders are covered */
+                for (int i = 0; i < history; i++) {
+                    CHECK(ESP_OK == rocker_calib_save(&old_calib), "save failed");
+                }
+
+                fake_nvs_power_cut(cut, tears[t]);
+                rocker_calib_save(&new_calib);
+                reboot();
+
+                CHECK(ESP_OK == rocker_calib_load(&record), "history %d, cut at write %u, %zu bytes: calibration lost",
+                      history, (unsigned) cut, tears[t]);
+                bool is_old = same_calib(&record, &old_calib);
+                bool is_new = same_calib(&record, &new_calib);
+                CHECK(is_old || is_new, "history %d, cut at write %u, %zu bytes: loaded a mix", history,
+                      (unsigned) cut, tears[t]);
+                CHECK(is_new || tears[t] < sizeof(record) || cut > 0, "a complete write was not taken");
+
+                /* The next save must not overwrite the slot just loaded */
+                CHECK(ESP_OK == rocker_calib_save(&next_calib), "save after the cut failed");
+                fake_nvs_power_cut(0, 3);
+                rocker_calib_save(&old_calib);
+                reboot();
+                CHECK(ESP_OK == rocker_calib_load(&record) && same_calib(&record, &next_calib),
+                      "history %d, cut at write %u, %zu bytes: save after reboot lost", history, (unsigned) cut,
+                      tears[t]);
+                cases++;
+            }
+        }
+    }
+    printf("power cut: %d cases\n", cases);
+    return true;
+}
+
+static bool test_corrupt_slot(void)
+{
+    rocker_calib_record_t first = make_record(10, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t second = make_record(20, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t record;
+
+    for (size_t bit = 0; bit < sizeof(record) * 8; bit++) {
+        fake_nvs_reset();
+        reboot();
+        rocker_calib_load(&record);
+        rocker_calib_save(&first);
+        rocker_calib_save(&second);
+        const char *newest = s_calib_slot_key[s_calib_slot];
+        CHECK(fake_nvs_flip_bit(newest, bit), "no slot %s", newest);
+        reboot();
+        CHECK(ESP_OK == rocker_calib_load(&record) && same_calib(&record, &first), "bit %zu flipped: not the older slot",
+              bit);
+    }
+    return true;
+}
+
+static bool test_seq_wrap(void)
+{
+    rocker_calib_record_t older = make_record(30, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t newer = make_record(40, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t record;
+    nvs_handle_t handle;
+
+    older.version = newer.version = ROCKER_CALIB_VERSION;
+    older.seq = UINT32_MAX;
+    newer.seq = 0;
+    older.crc = rocker_calib_crc(&older);
+    newer.crc = rocker_calib_crc(&newer);
+
+    fake_nvs_reset();
+    nvs_open_from_partition(NVS_PART_NAME, NVS_PART_NAMESPACE, NVS_READWRITE, &handle);
+    nvs_set_blob(handle, s_calib_slot_key[1], &older, sizeof(older));
+    nvs_set_blob(handle, s_calib_slot_key[0], &newer, sizeof(newer));
+    nvs_close(handle);
+    reboot();
+    CHECK(ESP_OK == rocker_calib_load(&record) && same_calib(&record, &newer), "wrapped sequence number lost");
+    return true;
+}
+
+/* A save without a load first must still go to the older slot with a newer sequence number */
+static bool test_save_first(void)
+{
+    rocker_calib_record_t calib = make_record(50, ROCKER_CALIB_FLAG_VALID);
+    rocker_calib_record_t record;
+
+    fake_nvs_reset();
+    reboot();
+    for (int i = 0; i < 5; i++) {
+        rocker_calib_save(&calib);
+    }
+    calib = make_record(60, ROCKER_CALIB_FLAG_VALID | ROCKER_CALIB_FLAG_BLE);
+    reboot();
+    CHECK(ESP_OK == rocker_calib_save(&calib), "save failed");
+    reboot();
+    CHECK(ESP_OK == rocker_calib_load(&record) && same_calib(&record, &calib), "save before load was dropped");
+    return true;
+}
+
+static void print_stats(const char *what, const fake_nvs_stats_t *stats)
+{
+    printf("%-22s %6u %6u %7u %8u %6u\n", what, (unsigned) stats->opens, (unsigned) stats->reads,
+           (unsigned) stats->writes, (unsigned) stats->commits, (unsigned) stats->bytes_written);
+}
+
+/* Flash accesses of a boot and a calibration save, per-key values against the record */
+static bool test_cost(void)
+{
+    rocker_calib_record_t calib = make_record(70, ROCKER_CALIB_FLAG_VALID | ROCKER_CALIB_FLAG_BLE);
+    rocker_calib_record_t record;
+    fake_nvs_stats_t legacy_boot, legacy_save, record_boot, record_save;
+
+    fake_nvs_reset();
+    write_legacy(&calib);
+    fake_nvs_get_stats(&legacy_save);
+    fake_nvs_reset_stats();
+    read_legacy();
+    fake_nvs_get_stats(&legacy_boot);
+
+    fake_nvs_reset();
+    reboot();
+    rocker_calib_load(&record);
+    fake_nvs_reset_stats();
+    rocker_calib_save(&calib);
+    fake_nvs_get_stats(&record_save);
+    reboot();
+    fake_nvs_reset_stats();
+    rocker_calib_load(&record);
+    for (int i = 0; i < 3; i++) {
+        rocker_calib_load(&record);         /* From RAM */
+    }
+    fake_nvs_get_stats(&record_boot);
+
+    printf("%-22s %6s %6s %7s %8s %6s\n", "", "opens", "reads", "writes", "commits", "bytes");
+    print_stats("per-key boot", &legacy_boot);
+    print_stats("record boot", &record_boot);
+    print_stats("per-key calibration", &legacy_save);
+    print_stats("record calibration", &record_save);
+
+    CHECK(record_boot.reads < legacy_boot.reads && record_boot.opens < legacy_boot.opens, "boot not cheaper");
+    CHECK(1 == record_save.writes && 1 == record_save.commits, "save is not one write");
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_empty, test_migrate, test_power_cut, test_corrupt_slot, test_seq_wrap, test_save_first, test_cost,
+    };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
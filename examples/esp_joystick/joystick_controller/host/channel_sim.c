@@ -0,0 +1,345 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Simulates an initiator reconnecting to responders on a 13 channel medium with frame loss, slow
+ * answers, peers that are switched off and peers that move to another channel. Each scenario runs
+ * once with the previous discovery (one saved channel, then a sweep with a fixed ACK wait) and once
+ * with espnow_chan (per-peer channels, backoff, sweep of the rest), on the same sequence of events,
+ * and prints the time-to-reconnect distribution of both.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Included so that its state can be reset between scenarios */
+#include "../main/app/espnow_chan.c"
+
+#define CHANNEL_NUM     13
+#define PEER_MAX        4
+#define TX_MS           1.0     /* espnow_send() including the channel switch */
+#define ACK_MS          3.0     /* Answer of an idle responder */
+#define BUSY_MIN_MS     40.0    /* Answer of a busy responder */
+#define BUSY_MAX_MS     160.0
+
+typedef struct {
+    const char *name;
+    int peers;
+    uint8_t channels[PEER_MAX];
+    double present;             /* Each peer is powered at a reconnect with this probability, one at least */
+    double move;                /* A peer moves to another channel before a reconnect */
+    double loss;                /* Of a frame, in each direction */
+    double busy;                /* The responder answers late */
+} scenario_t;
+
+typedef struct {
+    int trials;
+    int wait_ms;                /* CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION */
+    int retransmit;             /* CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES */
+    uint32_t seed;
+} options_t;
+
+typedef struct {
+    double ms;
+    int frames;
+    bool found;
+} reconnect_t;
+
+typedef struct {
+    uint8_t channel[PEER_MAX];
+    bool present[PEER_MAX];
+    int peers;
+    double loss;
+    double busy;
+    uint32_t rng;
+} medium_t;
+
+typedef enum {
+    ALGO_SWEEP,
+    ALGO_CHAN,
+} algo_t;
+
+static const scenario_t s_scenarios[] = {
+    { "steady",    1, { 6 },     1.0, 0.0, 0.05, 0.05 },
+    { "slow peer", 1, { 6 },     1.0, 0.0, 0.05, 0.50 },
+    { "lossy",     1, { 6 },     1.0, 0.0, 0.30, 0.10 },
+    { "two peers", 2, { 1, 11 }, 0.5, 0.0, 0.05, 0.05 },
+    { "moving",    1, { 6 },     1.0, 0.2, 0.05, 0.05 },
+};
+
+static options_t s_opt = {
+    .trials = 2000,
+    .wait_ms = 50,
+    .retransmit = 3,
+    .seed = 1,
+};
+
+wifi_country_t g_self_country = { .cc = "01", .schan = 1, .nchan = CHANNEL_NUM };
+
+static uint8_t s_saved_channel;         /* "ch_key" of the previous discovery */
+static espnow_chan_store_t s_flash;     /* "ch_peers" */
+static bool s_flash_valid;
+static uint32_t s_flash_writes;
+
+esp_err_t espnow_storage_get(const char *key, void *value, size_t length)
+{
+    if (!strcmp(key, ESPNOW_CHAN_PEERS_KEY) && s_flash_valid && length == sizeof(s_flash)) {
+        memcpy(value, &s_flash, length);
+        return ESP_OK;
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t espnow_storage_set(const char *key, const void *value, size_t length)
+{
+    if (!strcmp(key, ESPNOW_CHAN_PEERS_KEY) && length == sizeof(s_flash)) {
+        memcpy(&s_flash, value, length);
+        s_flash_valid = true;
+    }
+    s_flash_writes++;
+    return ESP_OK;
+}
+
+static void chan_reset(void)
+{
+    memset(&s_store, 0, sizeof(s_store));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_forward_mask = 0;
+    s_forward_count = 0;
+    s_loaded = false;
+    s_flash_valid = false;
+    s_flash_writes = 0;
+    s_saved_channel = 1;
+}
+
+static uint32_t rand_next(uint32_t *state)
+{
+    /* xorshift32, the same medium on every run */
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static double rand_unit(uint32_t *state)
+{
+    return rand_next(state) / 4294967296.0;
+}
+
+static void peer_mac(int peer, uint8_t mac[6])
+{
+    const uint8_t base[6] = { 0x24, 0x0a, 0xc4, 0x00, 0x00, 0x00 };
+    memcpy(mac, base, 6);
+    mac[5] = peer + 1;
+}
+
+static void on_ack(algo_t algo, const medium_t *medium, int peer, uint8_t channel)
+{
+    if (ALGO_SWEEP == algo) {
+        /* Stored on every ACK, the answer echoes the requested channel */
+        s_saved_channel = channel;
+        s_flash_writes++;
+    } else {
+        uint8_t mac[6];
+        peer_mac(peer, mac);
+        espnow_chan_update(mac, medium->channel[peer]);
+    }
+}
+
+/* espnow_ctrl_initiator_try() on virtual time */
+static bool try_channel(algo_t algo, medium_t *medium, uint8_t channel, bool backoff, reconnect_t *r)
+{
+    double ack_at = INFINITY;
+    int ack_peer = -1;
+
+    for (int retransmit = 0; retransmit <= s_opt.retransmit; retransmit++) {
+        r->ms += TX_MS;
+        r->frames++;
+
+        for (int i = 0; i < medium->peers; i++) {
+            if (!medium->present[i] || medium->channel[i] != channel
+                    || rand_unit(&medium->rng) < medium->loss || rand_unit(&medium->rng) < medium->loss) {
+                continue;
+            }
+            double latency = rand_unit(&medium->rng) < medium->busy
+                             ? BUSY_MIN_MS + rand_unit(&medium->rng) * (BUSY_MAX_MS - BUSY_MIN_MS) : ACK_MS;
+            if (r->ms + latency < ack_at) {
+                ack_at = r->ms + latency;
+                ack_peer = i;
+            }
+        }
+
+        /* A late ACK to an earlier retransmission is still taken while on the channel */
+        uint32_t wait_ms = backoff ? espnow_chan_backoff_ms(s_opt.wait_ms, retransmit, s_opt.retransmit + 1)
+                           : (uint32_t) s_opt.wait_ms;
+        if (ack_at <= r->ms + wait_ms) {
+            r->ms = ack_at;
+            on_ack(algo, medium, ack_peer, channel);
+            return true;
+        }
+        r->ms += wait_ms;
+    }
+
+    return false;
+}
+
+/* The previous espnow_ctrl_initiator_handle() */
+static reconnect_t reconnect_sweep(medium_t *medium)
+{
+    reconnect_t r = { 0 };
+    uint8_t channel = s_saved_channel;
+
+    r.found = try_channel(ALGO_SWEEP, medium, channel, false, &r);
+    for (int i = 0; i < g_self_country.nchan && !r.found; i++) {
+        if (g_self_country.schan + i != channel) {
+            r.found = try_channel(ALGO_SWEEP, medium, g_self_country.schan + i, false, &r);
+        }
+    }
+    return r;
+}
+
+/* espnow_ctrl_initiator_handle() */
+static reconnect_t reconnect_chan(medium_t *medium)
+{
+    reconnect_t r = { 0 };
+    uint8_t probe[ESPNOW_CHAN_PEER_MAX];
+    uint8_t sweep[CHANNEL_NUM + 1];
+
+    size_t probe_num = espnow_chan_get_probe_list(probe, sizeof(probe));
+    for (size_t i = 0; i < probe_num && !r.found; i++) {
+        r.found = try_channel(ALGO_CHAN, medium, probe[i], true, &r);
+    }
+
+    bool probed = r.found;
+    bool swept = false;
+    if (!r.found) {
+        size_t sweep_num = espnow_chan_get_sweep_list(sweep, sizeof(sweep), probe, probe_num);
+        swept = true;
+        for (size_t i = 0; i < sweep_num && !r.found; i++) {
+            r.found = try_channel(ALGO_CHAN, medium, sweep[i], false, &r);
+        }
+    }
+    espnow_chan_report(probed, swept, r.found);
+    return r;
+}
+
+/* Peers switched off and channel moves before the next reconnect, the same for both algorithms */
+static void medium_step(medium_t *medium, const scenario_t *scenario, uint32_t *env)
+{
+    int on = 0;
+    for (int i = 0; i < medium->peers; i++) {
+        if (rand_unit(env) < scenario->move) {
+            medium->channel[i] = 1 + (medium->channel[i] + rand_next(env) % (CHANNEL_NUM - 1)) % CHANNEL_NUM;
+        }
+        medium->present[i] = rand_unit(env) < scenario->present;
+        on += medium->present[i];
+    }
+    if (!on) {
+        medium->present[rand_next(env) % medium->peers] = true;
+    }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+    return x < y ? -1 : x > y;
+}
+
+static double run(const scenario_t *scenario, algo_t algo)
+{
+    medium_t medium = {
+        .peers = scenario->peers,
+        .loss = scenario->loss,
+        .busy = scenario->busy,
+        .rng = s_opt.seed,
+    };
+    memcpy(medium.channel, scenario->channels, sizeof(medium.channel));
+    uint32_t env = s_opt.seed * 2654435761u | 1;
+    double *ms = malloc(sizeof(double) * s_opt.trials);
+    double total = 0;
+    long frames = 0;
+    int failed = 0;
+
+    chan_reset();
+    for (int i = 0; i < s_opt.trials; i++) {
+        medium_step(&medium, scenario, &env);
+        reconnect_t r = ALGO_SWEEP == algo ? reconnect_sweep(&medium) : reconnect_chan(&medium);
+        ms[i] = r.ms;
+        total += r.ms;
+        frames += r.frames;
+        failed += !r.found;
+    }
+    qsort(ms, s_opt.trials, sizeof(double), compare_double);
+
+    printf("%-10s %-6s %8.1f %8.1f %8.1f %8.1f %8.1f %7.1f %6d %7.2f\n", scenario->name,
+           ALGO_SWEEP == algo ? "sweep" : "chan", total / s_opt.trials, ms[s_opt.trials / 2],
+           ms[s_opt.trials * 9 / 10], ms[s_opt.trials * 99 / 100], ms[s_opt.trials - 1],
+           (double) frames / s_opt.trials, failed, (double) s_flash_writes / s_opt.trials);
+    free(ms);
+    return total / s_opt.trials;
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n N       reconnects per scenario, default %d\n"
+            "  -w MS      ACK wait, CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION, default %d\n"
+            "  -r N       retransmissions, CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES, default %d\n"
+            "  -s SEED    default %u\n",
+            argv0, s_opt.trials, s_opt.wait_ms, s_opt.retransmit, (unsigned) s_opt.seed);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "n:w:r:s:h")) != -1) {
+        switch (c) {
+        case 'n':
+            s_opt.trials = atoi(optarg);
+            break;
+        case 'w':
+            s_opt.wait_ms = atoi(optarg);
+            break;
+        case 'r':
+            s_opt.retransmit = atoi(optarg);
+            break;
+        case 's':
+            s_opt.seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (s_opt.trials <= 0 || s_opt.wait_ms <= 0 || s_opt.retransmit < 0 || !s_opt.seed) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    printf("%d reconnects per scenario, ACK wait %d ms, %d retransmissions, %d channels\n",
+           s_opt.trials, s_opt.wait_ms, s_opt.retransmit, CHANNEL_NUM);
+    printf("%-10s %-6s %8s %8s %8s %8s %8s %7s %6s %7s\n", "scenario", "algo", "mean ms", "p50", "p90",
+           "p99", "max", "frames", "failed", "writes");
+
+    int worse = 0;
+    for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        double sweep = run(&s_scenarios[i], ALGO_SWEEP);
+        double chan = run(&s_scenarios[i], ALGO_CHAN);
+        /* Both see the same frames, a difference below 1 % is rounding of the waits */
+        if (chan > sweep * 1.01) {
+            printf("%s: espnow_chan is slower than the sweep\n", s_scenarios[i].name);
+            worse++;
+        }
+    }
+    return worse ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* NVS in memory, one namespace, with access counters and power cuts */
+
+#include <stdbool.h>
+#include <string.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_rom_crc.h"
+#include "fake_nvs.h"
+
+#define FAKE_NVS_ENTRY_MAX  32
+#define FAKE_NVS_KEY_MAX    16
+#define FAKE_NVS_VALUE_MAX  256
+
+typedef struct {
+    char key[FAKE_NVS_KEY_MAX];
+    bool used;
+    bool is_str;
+    size_t length;
+    uint8_t value[FAKE_NVS_VALUE_MAX];
+} fake_nvs_entry_t;
+
+static fake_nvs_entry_t s_entries[FAKE_NVS_ENTRY_MAX];
+static fake_nvs_stats_t s_stats;
+static bool s_cut_armed;
+static bool s_power_off;
+static uint32_t s_cut_writes;
+static size_t s_cut_torn;
+
+void fake_nvs_reset(void)
+{
+    memset(s_entries, 0, sizeof(s_entries));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_cut_armed = false;
+    s_power_off = false;
+}
+
+void fake_nvs_power_cut(uint32_t writes, size_t torn)
+{
+    s_cut_armed = true;
+    s_cut_writes = writes;
+    s_cut_torn = torn;
+}
+
+void fake_nvs_power_on(void)
+{
+    s_cut_armed = false;
+    s_power_off = false;
+}
+
+void fake_nvs_get_stats(fake_nvs_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+void fake_nvs_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+}
+
+static fake_nvs_entry_t *find(const char *key, bool create)
+{
+    fake_nvs_entry_t *free_entry = NULL;
+    for (int i = 0; i < FAKE_NVS_ENTRY_MAX; i++) {
+        if (s_entries[i].used && !strncmp(s_entries[i].key, key, FAKE_NVS_KEY_MAX)) {
+            return &s_entries[i];
+        }
+        if (!s_entries[i].used && !free_entry) {
+            free_entry = &s_entries[i];
+        }
+    }
+    if (create && free_entry) {
+        memset(free_entry, 0, sizeof(fake_nvs_entry_t));
+        strncpy(free_entry->key, key, FAKE_NVS_KEY_MAX - 1);
+        free_entry->used = true;
+    }
+    return create ? free_entry : NULL;
+}
+
+bool fake_nvs_flip_bit(const char *key, size_t bit)
+{
+    fake_nvs_entry_t *entry = find(key, false);
+    if (!entry || bit >= entry->length * 8) {
+        return false;
+    }
+    entry->value[bit / 8] ^= 1 << (bit % 8);
+    return true;
+}
+
+static esp_err_t entry_write(const char *key, const void *value, size_t length, bool is_str)
+{
+    if (s_power_off) {
+        return ESP_FAIL;
+    }
+    if (length > FAKE_NVS_VALUE_MAX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    fake_nvs_entry_t *entry = find(key, true);
+    if (!entry) {
+        return ESP_FAIL;
+    }
+
+    if (s_cut_armed && 0 == s_cut_writes--) {
+        memcpy(entry->value, value, s_cut_torn < length ? s_cut_torn : length);
+        entry->length = length;
+        entry->is_str = is_str;
+        s_power_off = true;
+        return ESP_FAIL;
+    }
+
+    memcpy(entry->value, value, length);
+    entry->length = length;
+    entry->is_str = is_str;
+    s_stats.writes++;
+    s_stats.bytes_written += length;
+    return ESP_OK;
+}
+
+static esp_err_t entry_read(const char *key, void *value, size_t *length, bool is_str)
+{
+    if (s_power_off) {
+        return ESP_FAIL;
+    }
+    s_stats.reads++;
+    fake_nvs_entry_t *entry = find(key, false);
+    if (!entry || entry->is_str != is_str) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (!value) {
+        *length = entry->length;
+        return ESP_OK;
+    }
+    if (*length < entry->length) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(value, entry->value, entry->length);
+    *length = entry->length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    memset(s_entries, 0, sizeof(s_entries));
+    return ESP_OK;
+}
+
+esp_err_t nvs_open_from_partition(const char *part_name, const char *name, nvs_open_mode_t open_mode,
+                                  nvs_handle_t *out_handle)
+{
+    (void) part_name;
+    (void) name;
+    (void) open_mode;
+    if (s_power_off) {
+        return ESP_FAIL;
+    }
+    s_stats.opens++;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void) handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void) handle;
+    if (s_power_off) {
+        return ESP_FAIL;
+    }
+    s_stats.commits++;
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    (void) handle;
+    return entry_read(key, out_value, length, true);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    (void) handle;
+    return entry_write(key, value, strlen(value) + 1, true);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    (void) handle;
+    return entry_read(key, out_value, length, false);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    (void) handle;
+    return entry_write(key, value, length, false);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
@@ -0,0 +1,15 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in of the esp-now storage, implemented by the simulation in memory */
+
+#pragma once
+
+#include <stddef.h>
+#include "esp_err.h"
+
+esp_err_t espnow_storage_get(const char *key, void *value, size_t length);
+esp_err_t espnow_storage_set(const char *key, const void *value, size_t length);
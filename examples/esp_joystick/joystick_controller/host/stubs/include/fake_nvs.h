@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Control of the in-memory NVS of the host tests */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t opens;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t commits;
+    uint32_t bytes_written;
+} fake_nvs_stats_t;
+
+/* Forget all keys and counters, power on */
+void fake_nvs_reset(void);
+
+/*
+ * Cut the power during the write after `writes` more successful ones: it stores only the first `torn`
+ * bytes of the new value over the old one, and every access fails until fake_nvs_power_on()
+ */
+void fake_nvs_power_cut(uint32_t writes, size_t torn);
+void fake_nvs_power_on(void);
+
+void fake_nvs_get_stats(fake_nvs_stats_t *stats);
+void fake_nvs_reset_stats(void);
+
+/* Flip one bit of a stored value, false if the key does not exist */
+bool fake_nvs_flip_bit(const char *key, size_t bit);
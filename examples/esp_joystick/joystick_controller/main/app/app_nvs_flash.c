@@ -4,6 +4,11 @@
  * SPDX-License-Identifier: CC0-1.0
  */
 
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
 #include "app_nvs_flash.h"
 
 nvs_handle_t nvs_flash_handle;
@@ -44,3 +49,133 @@ uint16_t read_rocker_value_from_flash(char *key)
         return num;
     }
 }
+
+#define ROCKER_CALIB_SLOT_NUM       2
+
+static const char *s_calib_slot_key[ROCKER_CALIB_SLOT_NUM] = { "calib_a", "calib_b" };
+static const char *s_calib_legacy_key[ROCKER_AXIS_MAX][3] = {
+    { "left_x_min", "left_x_mid", "left_x_max" },
+    { "left_y_min", "left_y_mid", "left_y_max" },
+    { "right_x_min", "right_x_mid", "right_x_max" },
+    { "right_y_min", "right_y_mid", "right_y_max" },
+};
+
+static rocker_calib_record_t s_calib;
+static int s_calib_slot = -1;       /* Slot holding s_calib, -1 if none */
+static bool s_calib_loaded = false;
+
+static uint32_t rocker_calib_crc(const rocker_calib_record_t *record)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)record, offsetof(rocker_calib_record_t, crc));
+}
+
+static bool rocker_calib_read_slot(nvs_handle_t handle, int slot, rocker_calib_record_t *record)
+{
+    size_t length = sizeof(rocker_calib_record_t);
+    esp_err_t err = nvs_get_blob(handle, s_calib_slot_key[slot], record, &length);
+
+    return err == ESP_OK && length == sizeof(rocker_calib_record_t)
+           && record->version == ROCKER_CALIB_VERSION && record->crc == rocker_calib_crc(record);
+}
+
+static bool rocker_calib_migrate(nvs_handle_t handle, rocker_calib_record_t *record)
+{
+    char value[10] = {0};
+    size_t length = sizeof(value);
+    bool found = false;
+
+    memset(record, 0, sizeof(rocker_calib_record_t));
+
+    if (nvs_get_str(handle, "hid_mode", value, &length) == ESP_OK) {
+        found = true;
+        if (atoi(value) == 1) {
+            record->flags |= ROCKER_CALIB_FLAG_BLE;
+        }
+    }
+
+    length = sizeof(value);
+    if (nvs_get_str(handle, "calibrate_state", value, &length) == ESP_OK && atoi(value) == 1) {
+        found = true;
+        record->flags |= ROCKER_CALIB_FLAG_VALID;
+        for (int i = 0; i < ROCKER_AXIS_MAX; i++) {
+            for (int j = 0; j < 3; j++) {
+                length = sizeof(value);
+                record->axis[i][j] = (nvs_get_str(handle, s_calib_legacy_key[i][j], value, &length) == ESP_OK) ? atoi(value) : 2;
+            }
+        }
+    }
+
+    return found;
+}
+
+esp_err_t rocker_calib_load(rocker_calib_record_t *record)
+{
+    if (!s_calib_loaded) {
+        nvs_handle_t handle;
+        rocker_calib_record_t slot_record;
+
+        memset(&s_calib, 0, sizeof(s_calib));
+        s_calib_slot = -1;
+
+        if (nvs_open_from_partition(NVS_PART_NAME, NVS_PART_NAMESPACE, NVS_READWRITE, &handle) == ESP_OK) {
+            for (int i = 0; i < ROCKER_CALIB_SLOT_NUM; i++) {
+                if (rocker_calib_read_slot(handle, i, &slot_record)
+                        && (s_calib_slot < 0 || (int32_t)(slot_record.seq - s_calib.seq) > 0)) {
+                    memcpy(&s_calib, &slot_record, sizeof(s_calib));
+                    s_calib_slot = i;
+                }
+            }
+
+            bool migrated = s_calib_slot < 0 && rocker_calib_migrate(handle, &slot_record);
+            nvs_close(handle);
+            s_calib_loaded = true;
+
+            if (migrated) {
+                ESP_LOGI("NVS", "Migrating rocker calibration from per-key storage");
+                rocker_calib_save(&slot_record);
+            }
+        }
+        s_calib_loaded = true;
+    }
+
+    memcpy(record, &s_calib, sizeof(rocker_calib_record_t));
+
+    return s_calib_slot < 0 ? ESP_ERR_NOT_FOUND : ESP_OK;
+}
+
+esp_err_t rocker_calib_save(const rocker_calib_record_t *record)
+{
+    nvs_handle_t handle;
+    rocker_calib_record_t new_record;
+
+    /* The slot and sequence number follow the stored records, also when nothing was loaded yet */
+    if (!s_calib_loaded) {
+        rocker_calib_load(&new_record);
+    }
+
+    int slot = (s_calib_slot + 1) % ROCKER_CALIB_SLOT_NUM;
+
+    memcpy(&new_record, record, sizeof(new_record));
+    new_record.version = ROCKER_CALIB_VERSION;
+    new_record.seq = (s_calib_slot < 0) ? 1 : s_calib.seq + 1;
+    new_record.crc = rocker_calib_crc(&new_record);
+
+    esp_err_t err = nvs_open_from_partition(NVS_PART_NAME, NVS_PART_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_set_blob(handle, s_calib_slot_key[slot], &new_record, sizeof(new_record));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    if (err == ESP_OK) {
+        memcpy(&s_calib, &new_record, sizeof(s_calib));
+        s_calib_slot = slot;
+        s_calib_loaded = true;
+    }
+
+    return err;
+}
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include "esp_bit_defs.h"
 #include "esp_flash.h"
 #include "nvs.h"
 #include "nvs_flash.h"
@@ -16,10 +17,57 @@ extern "C" {
 #define NVS_PART_NAME      "nvs"
 #define NVS_PART_NAMESPACE "test_result"
 
+#define ROCKER_CALIB_VERSION        1
+#define ROCKER_CALIB_FLAG_VALID     BIT(0)      /* Min/mid/max values come from a finished calibration */
+#define ROCKER_CALIB_FLAG_BLE       BIT(1)      /* HID mode, cleared for USB */
+
+typedef enum {
+    ROCKER_AXIS_LEFT_X = 0,
+    ROCKER_AXIS_LEFT_Y,
+    ROCKER_AXIS_RIGHT_X,
+    ROCKER_AXIS_RIGHT_Y,
+    ROCKER_AXIS_MAX,
+} rocker_axis_t;
+
+/* Whole joystick calibration, stored as one CRC protected blob */
+typedef struct {
+    uint16_t version;
+    uint16_t flags;
+    uint32_t seq;                               /* Incremented on every save, the newest valid slot wins */
+    uint16_t axis[ROCKER_AXIS_MAX][3];          /* Minimum, middle and maximum ADC value */
+    uint32_t crc;                               /* CRC32 of all fields above */
+} rocker_calib_record_t;
+
 void flash_write_init(void);
 void flash_write_state(char *key, char *value);
 uint16_t read_rocker_value_from_flash(char *key);
 
+/**
+ * @brief Get the calibration record
+ *
+ * The record is read from flash once and served from RAM afterwards. When no valid
+ * record exists the per-key values written by older firmware are migrated.
+ *
+ * @param[out] record Calibration record
+ * @return
+ *      - ESP_OK: a stored or migrated record was returned
+ *      - ESP_ERR_NOT_FOUND: nothing stored, `record` holds no valid calibration
+ */
+esp_err_t rocker_calib_load(rocker_calib_record_t *record);
+
+/**
+ * @brief Save the calibration record
+ *
+ * Slots are written alternately so that losing power during a write leaves the
+ * previous record intact.
+ *
+ * @param[in] record Calibration record, version/seq/crc are filled in here
+ * @return
+ *      - ESP_OK: Success
+ *      - Others: NVS error
+ */
+esp_err_t rocker_calib_save(const rocker_calib_record_t *record);
+
 #ifdef __cplusplus
 }
 #endif
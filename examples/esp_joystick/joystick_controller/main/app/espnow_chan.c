@@ -0,0 +1,251 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_wifi.h"
+#include "esp_mac.h"
+#include "esp_bit_defs.h"
+#include "esp_log.h"
+
+#include "espnow_storage.h"
+#include "espnow_chan.h"
+
+#define ESPNOW_CHAN_PEERS_KEY       "ch_peers"
+#define ESPNOW_CHAN_LEGACY_KEY      "ch_key"
+#define ESPNOW_CHAN_STORE_VERSION   1
+
+extern wifi_country_t g_self_country;
+
+typedef struct {
+    uint8_t mac[6];
+    uint8_t channel;
+} espnow_chan_peer_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t size;
+    espnow_chan_peer_t peers[ESPNOW_CHAN_PEER_MAX];     /**< Most recently confirmed first */
+} espnow_chan_store_t;
+
+static const char *TAG = "espnow_chan";
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static espnow_chan_store_t s_store = {0};
+static espnow_chan_stats_t s_stats = {0};
+static uint32_t s_forward_mask = 0;
+static uint32_t s_forward_count = 0;
+static bool s_loaded = false;
+
+static uint8_t espnow_chan_first(void)
+{
+    return g_self_country.schan ? g_self_country.schan : 1;
+}
+
+static uint8_t espnow_chan_num(void)
+{
+    return g_self_country.nchan ? g_self_country.nchan : 13;
+}
+
+static bool espnow_chan_valid(uint8_t channel)
+{
+    return channel >= espnow_chan_first() && channel < espnow_chan_first() + espnow_chan_num();
+}
+
+static bool espnow_chan_contains(const uint8_t *list, size_t num, uint8_t channel)
+{
+    for (size_t i = 0; list && i < num; i++) {
+        if (list[i] == channel) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+esp_err_t espnow_chan_init(void)
+{
+    if (s_loaded) {
+        return ESP_OK;
+    }
+
+    espnow_chan_store_t store = {0};
+    esp_err_t ret = espnow_storage_get(ESPNOW_CHAN_PEERS_KEY, &store, sizeof(store));
+
+    if (ret != ESP_OK || store.version != ESPNOW_CHAN_STORE_VERSION || store.size > ESPNOW_CHAN_PEER_MAX) {
+        memset(&store, 0, sizeof(store));
+        store.version = ESPNOW_CHAN_STORE_VERSION;
+
+        /**< Migrate the single channel saved by previous firmware, the peer is unknown so the MAC stays zero */
+        uint8_t channel = 0;
+        if (espnow_storage_get(ESPNOW_CHAN_LEGACY_KEY, &channel, sizeof(channel)) == ESP_OK && espnow_chan_valid(channel)) {
+            store.peers[0].channel = channel;
+            store.size = 1;
+            ESP_LOGI(TAG, "Migrated legacy channel %d", channel);
+        }
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(&s_store, &store, sizeof(s_store));
+    s_loaded = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    return ESP_OK;
+}
+
+size_t espnow_chan_get_probe_list(uint8_t *channels, size_t max)
+{
+    size_t num = 0;
+
+    espnow_chan_init();
+
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < s_store.size && num < max; i++) {
+        uint8_t channel = s_store.peers[i].channel;
+        if (espnow_chan_valid(channel) && !espnow_chan_contains(channels, num, channel)) {
+            channels[num++] = channel;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!num && max) {
+        channels[num++] = espnow_chan_first();
+    }
+
+    return num;
+}
+
+size_t espnow_chan_get_sweep_list(uint8_t *channels, size_t max, const uint8_t *skip, size_t skip_num)
+{
+    size_t num = 0;
+
+    for (int i = 0; i < espnow_chan_num() && num < max; i++) {
+        uint8_t channel = espnow_chan_first() + i;
+        if (!espnow_chan_contains(skip, skip_num, channel)) {
+            channels[num++] = channel;
+        }
+    }
+
+    return num;
+}
+
+uint32_t espnow_chan_backoff_ms(uint32_t base_ms, uint32_t attempt, uint32_t attempts)
+{
+    attempts = MIN(MAX(attempts, 1), 16);
+    attempt = MIN(attempt, attempts - 1);
+
+    /**< base_ms * attempts split as 1 : 2 : 4 : ... */
+    uint32_t wait_ms = (uint64_t)base_ms * attempts * BIT(attempt) / (BIT(attempts) - 1);
+    return MAX(wait_ms, ESPNOW_CHAN_BACKOFF_MIN_MS);
+}
+
+void espnow_chan_update(const uint8_t mac[6], uint8_t channel)
+{
+    if (!espnow_chan_valid(channel)) {
+        return;
+    }
+
+    espnow_chan_init();
+
+    bool changed = true;
+    espnow_chan_store_t store;
+
+    portENTER_CRITICAL(&s_lock);
+    int index = s_store.size;
+    for (int i = 0; i < s_store.size; i++) {
+        /**< A zero MAC is the migrated legacy entry, adopt it for the first peer that answers */
+        if (!memcmp(s_store.peers[i].mac, mac, 6) || !memcmp(s_store.peers[i].mac, "\0\0\0\0\0\0", 6)) {
+            index = i;
+            break;
+        }
+    }
+
+    if (index < s_store.size) {
+        changed = memcmp(s_store.peers[index].mac, mac, 6) || s_store.peers[index].channel != channel;
+        if (s_store.peers[index].channel != channel && memcmp(s_store.peers[index].mac, "\0\0\0\0\0\0", 6)) {
+            s_stats.channel_moved++;
+        }
+    } else if (s_store.size < ESPNOW_CHAN_PEER_MAX) {
+        s_store.size++;
+    } else {
+        index = ESPNOW_CHAN_PEER_MAX - 1;
+    }
+
+    /**< Move the peer to the front so the probe list is ordered by recency */
+    memmove(s_store.peers + 1, s_store.peers, sizeof(espnow_chan_peer_t) * index);
+    memcpy(s_store.peers[0].mac, mac, 6);
+    s_store.peers[0].channel = channel;
+    memcpy(&store, &s_store, sizeof(store));
+    portEXIT_CRITICAL(&s_lock);
+
+    if (changed) {
+        ESP_LOGI(TAG, "peer: "MACSTR", channel: %d", MAC2STR(mac), channel);
+        espnow_storage_set(ESPNOW_CHAN_PEERS_KEY, &store, sizeof(store));
+    }
+}
+
+void espnow_chan_report(bool probed, bool swept, bool found)
+{
+    portENTER_CRITICAL(&s_lock);
+    if (probed) {
+        s_stats.probe_hit++;
+    } else {
+        s_stats.probe_miss++;
+    }
+
+    if (swept) {
+        s_stats.sweep++;
+        if (found) {
+            s_stats.sweep_hit++;
+        } else {
+            s_stats.sweep_miss++;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+size_t espnow_chan_get_forward_list(uint8_t target, uint8_t primary, uint8_t *channels, size_t max)
+{
+    size_t num = 0;
+
+    espnow_chan_init();
+
+    portENTER_CRITICAL(&s_lock);
+    if (espnow_chan_valid(target)) {
+        s_forward_mask |= BIT(target);
+    }
+    for (int i = 0; i < s_store.size; i++) {
+        if (espnow_chan_valid(s_store.peers[i].channel)) {
+            s_forward_mask |= BIT(s_store.peers[i].channel);
+        }
+    }
+
+    bool sweep = (s_forward_count++ % ESPNOW_CHAN_FORWARD_SWEEP_PERIOD) == 0
+                 || !(s_forward_mask & ~BIT(primary));
+
+    for (int i = 0; i < espnow_chan_num() && num < max; i++) {
+        uint8_t channel = espnow_chan_first() + i;
+        if (sweep || channel == primary || (s_forward_mask & BIT(channel))) {
+            channels[num++] = channel;
+        } else {
+            s_stats.forward_skip++;
+        }
+    }
+    s_stats.forward_tx += num;
+    portEXIT_CRITICAL(&s_lock);
+
+    return num;
+}
+
+void espnow_chan_get_stats(espnow_chan_stats_t *stats)
+{
+    portENTER_CRITICAL(&s_lock);
+    memcpy(stats, &s_stats, sizeof(espnow_chan_stats_t));
+    portEXIT_CRITICAL(&s_lock);
+}
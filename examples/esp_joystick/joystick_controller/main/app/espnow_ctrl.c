@@ -29,6 +29,7 @@
 
 #include "espnow.h"
 #include "espnow_ctrl.h"
+#include "espnow_chan.h"
 #include "espnow_mem.h"
 #include "espnow_storage.h"
 #include "espnow_utils.h"
@@ -58,8 +59,7 @@ static espnow_bindlist_t g_bindlist = {0};
 #endif
 
 #ifdef CONFIG_ESPNOW_CONTROL_AUTO_CHANNEL_SENDING
-#define ESPNOW_CHANNEL_KEY       "ch_key"
-#define RESEND_SCAN_COUNT_MAX (sizeof(scan_channel_sequence) * 2)
+#define ESPNOW_CHANNEL_MAX       14
 
 #ifndef CONFIG_ESPNOW_VERSION
 #define ESPNOW_VERSION                  2
@@ -90,6 +90,25 @@ static const espnow_frame_head_t g_initiator_frame = {
 };
 #endif
 
+#ifdef CONFIG_ESPNOW_CONTROL_AUTO_CHANNEL_SENDING
+/**
+ * @brief Answer with the channel this responder is actually on, so the initiator
+ *        remembers it even if the frame reached us through a forwarder.
+ */
+static void espnow_ctrl_responder_ack(const espnow_frame_head_t *frame_head)
+{
+    uint8_t primary           = 0;
+    wifi_second_chan_t second = 0;
+    espnow_frame_head_t ack   = *frame_head;
+
+    if (esp_wifi_get_channel(&primary, &second) == ESP_OK) {
+        ack.channel = primary;
+    }
+
+    espnow_send(ESPNOW_DATA_TYPE_ACK, ESPNOW_ADDR_BROADCAST, &ack, sizeof(ack), frame_head, pdMS_TO_TICKS(100));
+}
+#endif
+
 static bool espnow_ctrl_responder_is_bindlist(const uint8_t *mac, espnow_attribute_t initiator_attribute)
 {
     for (int i = 0; i < g_bindlist.size; ++i) {
@@ -149,7 +168,8 @@ static esp_err_t espnow_ctrl_responder_forward(uint8_t type, uint8_t *src_addr,
 {
     uint8_t primary           = 0;
     wifi_second_chan_t second = 0;
-    int retransmit_count = 0;
+    uint8_t channels[ESPNOW_CHANNEL_MAX] = {0};
+    size_t channel_num = 0;
     espnow_ctrl_data_t *ctrl_data = (espnow_ctrl_data_t *)data;
     espnow_forward_data_t *espnow_data = ESP_MALLOC(sizeof(espnow_forward_data_t) + size);
 
@@ -162,12 +182,20 @@ static esp_err_t espnow_ctrl_responder_forward(uint8_t type, uint8_t *src_addr,
     memcpy(espnow_data->payload, data, size);
 
     esp_wifi_get_channel(&primary, &second);
-    while (retransmit_count < g_self_country.nchan) {
-        esp_wifi_set_channel(g_self_country.schan + retransmit_count, WIFI_SECOND_CHAN_NONE);
+
+    /**< Bind frames are rare and must reach every responder, data frames only go where peers were seen */
+    if (type == ESPNOW_DATA_TYPE_CONTROL_BIND) {
+        channel_num = espnow_chan_get_sweep_list(channels, sizeof(channels), NULL, 0);
+    } else {
+        channel_num = espnow_chan_get_forward_list(ctrl_data->frame_head.channel, primary, channels, sizeof(channels));
+    }
+
+    for (int i = 0; i < channel_num; i++) {
+        esp_wifi_set_channel(channels[i], WIFI_SECOND_CHAN_NONE);
         esp_now_send(ESPNOW_ADDR_BROADCAST, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_forward_data_t));
-        retransmit_count++;
     }
     esp_wifi_set_channel(primary, second);
+    ESP_FREE(espnow_data);
 
     return ESP_OK;
 }
@@ -185,7 +213,7 @@ static esp_err_t espnow_ctrl_responder_bind_process(uint8_t *src_addr, void *dat
 
 #ifdef CONFIG_ESPNOW_CONTROL_AUTO_CHANNEL_SENDING
     if (ctrl_data->frame_head.ack) {
-        espnow_send(ESPNOW_DATA_TYPE_ACK, ESPNOW_ADDR_BROADCAST, &ctrl_data->frame_head, sizeof(ctrl_data->frame_head), &ctrl_data->frame_head, pdMS_TO_TICKS(100));
+        espnow_ctrl_responder_ack(&ctrl_data->frame_head);
     }
 #endif
 
@@ -279,7 +307,7 @@ static esp_err_t espnow_ctrl_responder_data_process(uint8_t *src_addr, void *dat
 
 #ifdef CONFIG_ESPNOW_CONTROL_AUTO_CHANNEL_SENDING
     if (ctrl_data->frame_head.ack) {
-        espnow_send(ESPNOW_DATA_TYPE_ACK, ESPNOW_ADDR_BROADCAST, &ctrl_data->frame_head, sizeof(ctrl_data->frame_head), &ctrl_data->frame_head, pdMS_TO_TICKS(100));
+        espnow_ctrl_responder_ack(&ctrl_data->frame_head);
     }
 #endif
 
@@ -320,9 +348,9 @@ static esp_err_t espnow_ctrl_initiator_ack(uint8_t *src_addr, void *data,
 
     uint8_t channel = frame_head ? frame_head->channel : 1;
 
-    ESP_LOGI(TAG, "src_addr: "MACSTR", %s, channel: %d", MAC2STR(src_addr), __func__, channel);
+    ESP_LOGD(TAG, "src_addr: "MACSTR", %s, channel: %d", MAC2STR(src_addr), __func__, channel);
 
-    espnow_storage_set(ESPNOW_CHANNEL_KEY, &channel, sizeof(channel));
+    espnow_chan_update(src_addr, channel);
 
     if (g_bind_sem) {
         xSemaphoreGive(g_bind_sem);
@@ -331,19 +359,43 @@ static esp_err_t espnow_ctrl_initiator_ack(uint8_t *src_addr, void *data,
     return ESP_OK;
 }
 
-static esp_err_t espnow_ctrl_initiator_handle(espnow_data_type_t type, espnow_attribute_t initiator_attribute, espnow_attribute_t responder_attribute, uint32_t responder_value)
+static bool espnow_ctrl_initiator_try(espnow_data_type_t type, espnow_ctrl_data_t *data, uint8_t channel, bool backoff, bool sleep)
 {
-    esp_err_t ret = ESP_OK;
+    data->frame_head.channel = channel;
+
+    for (int retransmit_count = 0; retransmit_count <= CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES; retransmit_count++) {
+        uint32_t wait_ms = backoff ? espnow_chan_backoff_ms(CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION, retransmit_count,
+                                                            CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES + 1)
+                           : CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION;
+
+        espnow_send(type, ESPNOW_ADDR_BROADCAST, data, sizeof(espnow_ctrl_data_t), &data->frame_head, portMAX_DELAY);
+
+        if (xSemaphoreTake(g_bind_sem, pdMS_TO_TICKS(wait_ms)) == pdPASS) {
+            return true;
+        }
+
+#ifdef CONFIG_ESPNOW_LIGHT_SLEEP
+        if (sleep || retransmit_count < CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES) {
+            esp_sleep_enable_timer_wakeup(CONFIG_ESPNOW_LIGHT_SLEEP_DURATION * 1000);
+            esp_light_sleep_start();
+        }
+#endif
+    }
+
+    return false;
+}
 
+static esp_err_t espnow_ctrl_initiator_handle(espnow_data_type_t type, espnow_attribute_t initiator_attribute, espnow_attribute_t responder_attribute, uint32_t responder_value)
+{
     g_bind_sem = xSemaphoreCreateBinary();
     if (!g_bind_sem) {
         return ESP_FAIL;
     }
 
-    BaseType_t bind_sem_ret = pdFAIL;
-    int retransmit_count = 0;
-    uint8_t channel = 1;
-    espnow_storage_get(ESPNOW_CHANNEL_KEY, &channel, sizeof(channel));
+    bool found = false;
+    bool swept = false;
+    uint8_t probe[ESPNOW_CHAN_PEER_MAX] = {0};
+    uint8_t sweep[ESPNOW_CHANNEL_MAX] = {0};
     espnow_ctrl_data_t data = {
         .frame_head = {
             .broadcast        = true,
@@ -351,7 +403,6 @@ static esp_err_t espnow_ctrl_initiator_handle(espnow_data_type_t type, espnow_at
             .forward_rssi     = CONFIG_ESPNOW_CONTROL_FORWARD_RSSI,
             .magic            = esp_random(),
             .ack              = true,
-            .channel          = channel,
             .security         = CONFIG_ESPNOW_CONTROL_SECURITY,
         },
         .initiator_attribute = initiator_attribute,
@@ -360,53 +411,30 @@ static esp_err_t espnow_ctrl_initiator_handle(espnow_data_type_t type, espnow_at
     };
     espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_ACK, true, espnow_ctrl_initiator_ack);
 
-    do {
-        espnow_send(type, ESPNOW_ADDR_BROADCAST, &data, sizeof(espnow_ctrl_data_t), &data.frame_head, portMAX_DELAY);
-        bind_sem_ret = xSemaphoreTake(g_bind_sem, pdMS_TO_TICKS(CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION));
+    /**< Probe the channels peers last answered on, waiting longer on every retry */
+    size_t probe_num = espnow_chan_get_probe_list(probe, sizeof(probe));
+    for (int i = 0; i < probe_num && !found; i++) {
+        found = espnow_ctrl_initiator_try(type, &data, probe[i], true, true);
+    }
 
-        if (bind_sem_ret == pdPASS) {
-            break;
-        }
-#ifdef CONFIG_ESPNOW_LIGHT_SLEEP
-        esp_sleep_enable_timer_wakeup(CONFIG_ESPNOW_LIGHT_SLEEP_DURATION * 1000);
-        esp_light_sleep_start();
-#endif
-    } while (retransmit_count ++ < CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES);
+    bool probed = found;
 
-    if (bind_sem_ret != pdPASS) {
-        for (int i = 0; i < g_self_country.nchan; i++) {
-            if (g_self_country.schan + i == channel) {
-                continue;
-            }
-            data.frame_head.channel = g_self_country.schan + i;
-            retransmit_count = 0;
-            do {
-                espnow_send(type, ESPNOW_ADDR_BROADCAST, &data, sizeof(espnow_ctrl_data_t), &data.frame_head, portMAX_DELAY);
-                bind_sem_ret = xSemaphoreTake(g_bind_sem, pdMS_TO_TICKS(CONFIG_ESPNOW_CONTROL_WAIT_ACK_DURATION));
-                if (bind_sem_ret == pdPASS) {
-                    ret = ESP_OK;
-                    break;
-                } else {
-                    ret = ESP_FAIL;
-                }
-#ifdef CONFIG_ESPNOW_LIGHT_SLEEP
-                if (retransmit_count < CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES || (i < g_self_country.nchan - 1 &&
-                    // !(Second last channel, however last channel is the saved channel)
-                    !(i == g_self_country.nchan - 2 && g_self_country.schan + i + 1 == channel))) {
-                    esp_sleep_enable_timer_wakeup(CONFIG_ESPNOW_LIGHT_SLEEP_DURATION * 1000);
-                    esp_light_sleep_start();
-                }
-#endif
-            } while (retransmit_count ++ < CONFIG_ESPNOW_CONTROL_RETRANSMISSION_TIMES);
-            if (ret == ESP_OK) {
-                break;
-            }
+    /**< Only sweep the remaining channels once all remembered ones stayed silent */
+    if (!found) {
+        size_t sweep_num = espnow_chan_get_sweep_list(sweep, sizeof(sweep), probe, probe_num);
+        swept = true;
+
+        for (int i = 0; i < sweep_num && !found; i++) {
+            found = espnow_ctrl_initiator_try(type, &data, sweep[i], false, i < sweep_num - 1);
         }
     }
+
+    espnow_chan_report(probed, swept, found);
+
     vSemaphoreDelete(g_bind_sem);
     g_bind_sem = NULL;
 
-    ESP_ERROR_RETURN(ret != ESP_OK, ret,  "espnow_broadcast, ret: %d", ret);
+    ESP_ERROR_RETURN(!found, ESP_FAIL,  "espnow_broadcast, ret: %d", ESP_FAIL);
 
     return ESP_OK;
 }
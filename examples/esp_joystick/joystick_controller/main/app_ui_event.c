@@ -41,6 +41,44 @@ typedef enum {
 
 static app_espnow_ctrl_status_t s_espnow_ctrl_status = APP_ESPNOW_CTRL_INIT;
 
+static void app_rocker_calibration_load(void)
+{
+    rocker_calib_record_t record;
+
+    if (ESP_OK == rocker_calib_load(&record) && (record.flags & ROCKER_CALIB_FLAG_VALID)) {
+        memcpy(left_rocker_x_adc_value, record.axis[ROCKER_AXIS_LEFT_X], sizeof(left_rocker_x_adc_value));
+        memcpy(left_rocker_y_adc_value, record.axis[ROCKER_AXIS_LEFT_Y], sizeof(left_rocker_y_adc_value));
+        memcpy(right_rocker_x_adc_value, record.axis[ROCKER_AXIS_RIGHT_X], sizeof(right_rocker_x_adc_value));
+        memcpy(right_rocker_y_adc_value, record.axis[ROCKER_AXIS_RIGHT_Y], sizeof(right_rocker_y_adc_value));
+    }
+}
+
+static void app_rocker_calibration_save(void)
+{
+    rocker_calib_record_t record;
+
+    rocker_calib_load(&record);
+    record.flags |= ROCKER_CALIB_FLAG_VALID;
+    memcpy(record.axis[ROCKER_AXIS_LEFT_X], left_rocker_x_adc_value, sizeof(left_rocker_x_adc_value));
+    memcpy(record.axis[ROCKER_AXIS_LEFT_Y], left_rocker_y_adc_value, sizeof(left_rocker_y_adc_value));
+    memcpy(record.axis[ROCKER_AXIS_RIGHT_X], right_rocker_x_adc_value, sizeof(right_rocker_x_adc_value));
+    memcpy(record.axis[ROCKER_AXIS_RIGHT_Y], right_rocker_y_adc_value, sizeof(right_rocker_y_adc_value));
+    ESP_ERROR_CHECK_WITHOUT_ABORT(rocker_calib_save(&record));
+}
+
+static void app_hid_mode_save(void)
+{
+    rocker_calib_record_t record;
+
+    rocker_calib_load(&record);
+    if (g_hid_mode) {
+        record.flags |= ROCKER_CALIB_FLAG_BLE;
+    } else {
+        record.flags &= ~ROCKER_CALIB_FLAG_BLE;
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(rocker_calib_save(&record));
+}
+
 esp_err_t event_state_group_init(void)
 {
     g_init_event_grp = xEventGroupCreate();
@@ -139,7 +177,9 @@ static void game_pad_app_task(void *pvParameters)
         }
     }
 
-    if (1 == read_rocker_value_from_flash("hid_mode")) {
+    rocker_calib_record_t record;
+    rocker_calib_load(&record);
+    if (record.flags & ROCKER_CALIB_FLAG_BLE) {
         g_hid_mode = 1;
         lv_obj_set_x(ui_hidModeSelectBtnPart, 22);
         lv_label_set_text(ui_hidModeSelectLab, "BLE");
@@ -159,23 +199,7 @@ static void game_pad_app_task(void *pvParameters)
         }
     }
 
-    if (1 == read_rocker_value_from_flash("calibrate_state")) {
-        left_rocker_x_adc_value[0] = read_rocker_value_from_flash("left_x_min");
-        left_rocker_x_adc_value[1] = read_rocker_value_from_flash("left_x_mid");
-        left_rocker_x_adc_value[2] = read_rocker_value_from_flash("left_x_max");
-
-        left_rocker_y_adc_value[0] = read_rocker_value_from_flash("left_y_min");
-        left_rocker_y_adc_value[1] = read_rocker_value_from_flash("left_y_mid");
-        left_rocker_y_adc_value[2] = read_rocker_value_from_flash("left_y_max");
-
-        right_rocker_x_adc_value[0] = read_rocker_value_from_flash("right_x_min");
-        right_rocker_x_adc_value[1] = read_rocker_value_from_flash("right_x_mid");
-        right_rocker_x_adc_value[2] = read_rocker_value_from_flash("right_x_max");
-
-        right_rocker_y_adc_value[0] = read_rocker_value_from_flash("right_y_min");
-        right_rocker_y_adc_value[1] = read_rocker_value_from_flash("right_y_mid");
-        right_rocker_y_adc_value[2] = read_rocker_value_from_flash("right_y_max");
-    }
+    app_rocker_calibration_load();
 
     while (1) {
         while (1 == g_rocker_calibration_state) {
@@ -273,23 +297,7 @@ static void rc_app_task(void *pvParameters)
         }
     }
 
-    if (1 == read_rocker_value_from_flash("calibrate_state")) {
-        left_rocker_x_adc_value[0] = read_rocker_value_from_flash("left_x_min");
-        left_rocker_x_adc_value[1] = read_rocker_value_from_flash("left_x_mid");
-        left_rocker_x_adc_value[2] = read_rocker_value_from_flash("left_x_max");
-
-        left_rocker_y_adc_value[0] = read_rocker_value_from_flash("left_y_min");
-        left_rocker_y_adc_value[1] = read_rocker_value_from_flash("left_y_mid");
-        left_rocker_y_adc_value[2] = read_rocker_value_from_flash("left_y_max");
-
-        right_rocker_x_adc_value[0] = read_rocker_value_from_flash("right_x_min");
-        right_rocker_x_adc_value[1] = read_rocker_value_from_flash("right_x_mid");
-        right_rocker_x_adc_value[2] = read_rocker_value_from_flash("right_x_max");
-
-        right_rocker_y_adc_value[0] = read_rocker_value_from_flash("right_y_min");
-        right_rocker_y_adc_value[1] = read_rocker_value_from_flash("right_y_mid");
-        right_rocker_y_adc_value[2] = read_rocker_value_from_flash("right_y_max");
-    }
+    app_rocker_calibration_load();
 
     uint16_t rocker_adc_value[4] = {0};
     while (1) {
@@ -402,7 +410,6 @@ void app_ui_event_espnow_bind(lv_event_t *e)
 
 void app_ui_event_rocker_calibration(lv_event_t *e)
 {
-    char rocker_value_str[6];
     uint16_t rocker_adc_value[4] = {0};
     ESP_LOGI(GAME_PAD_APP_TAG, "rocker_calibration.");
     g_rocker_calibration_state = 0;
@@ -431,17 +438,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     right_rocker_y_adc_value[1] = right_rocker_y_adc_value[1] / 10.0;
     printf("left x-mid: %d, left y-mid: %d, right x-mid: %d, right y-mid: %d\n", left_rocker_x_adc_value[1], left_rocker_y_adc_value[1],
            right_rocker_x_adc_value[1], right_rocker_y_adc_value[1]);
-    sprintf(rocker_value_str, "%d", left_rocker_x_adc_value[1]);
-    flash_write_state("left_x_mid", rocker_value_str);
-
-    sprintf(rocker_value_str, "%d", left_rocker_y_adc_value[1]);
-    flash_write_state("left_y_mid", rocker_value_str);
-
-    sprintf(rocker_value_str, "%d", right_rocker_x_adc_value[1]);
-    flash_write_state("right_x_mid", rocker_value_str);
-
-    sprintf(rocker_value_str, "%d", right_rocker_y_adc_value[1]);
-    flash_write_state("right_y_mid", rocker_value_str);
 
     //get left rocker x-adc min value
     ESP_LOGI(GAME_PAD_APP_TAG, "Push the left rocker to the far left");
@@ -466,9 +462,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     left_rocker_x_adc_value[0] = left_rocker_x_adc_value[0] / 5;
     printf("left x min: %d\n", left_rocker_x_adc_value[0]);
 
-    sprintf(rocker_value_str, "%d", left_rocker_x_adc_value[0]);
-    flash_write_state("left_x_min", rocker_value_str);
-
     lv_obj_set_x(ui_leftRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release left rocker");
     lv_refr_now(NULL);
@@ -494,8 +487,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     left_rocker_x_adc_value[2] = left_rocker_x_adc_value[2] / 5;
     printf("left x max: %d\n", left_rocker_x_adc_value[2]);
-    sprintf(rocker_value_str, "%d", left_rocker_x_adc_value[2]);
-    flash_write_state("left_x_max", rocker_value_str);
 
     lv_obj_set_x(ui_leftRockerCalibrateBtn, 0);
     ESP_LOGI(GAME_PAD_APP_TAG, "Release left rocker");
@@ -524,8 +515,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     left_rocker_y_adc_value[2] = left_rocker_y_adc_value[2] / 5;
     printf("left y max: %d\n", left_rocker_y_adc_value[2]);
-    sprintf(rocker_value_str, "%d", left_rocker_y_adc_value[2]);
-    flash_write_state("left_y_max", rocker_value_str);
     lv_obj_set_y(ui_leftRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release left rocker");
     lv_refr_now(NULL);
@@ -551,8 +540,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     left_rocker_y_adc_value[0] = left_rocker_y_adc_value[0] / 5;
     printf("left y min: %d\n", left_rocker_y_adc_value[0]);
-    sprintf(rocker_value_str, "%d", left_rocker_y_adc_value[0]);
-    flash_write_state("left_y_min", rocker_value_str);
     lv_obj_set_y(ui_leftRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release left rocker");
     lv_refr_now(NULL);
@@ -578,8 +565,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     right_rocker_x_adc_value[0] = right_rocker_x_adc_value[0] / 5;
     printf("right x min: %d\n", right_rocker_x_adc_value[0]);
-    sprintf(rocker_value_str, "%d", right_rocker_x_adc_value[0]);
-    flash_write_state("right_x_min", rocker_value_str);
     lv_obj_set_x(ui_rightRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release right rocker");
     lv_refr_now(NULL);
@@ -606,8 +591,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     right_rocker_x_adc_value[2] = right_rocker_x_adc_value[2] / 5;
     printf("right x max: %d\n", right_rocker_x_adc_value[2]);
-    sprintf(rocker_value_str, "%d", right_rocker_x_adc_value[2]);
-    flash_write_state("right_x_max", rocker_value_str);
     lv_obj_set_x(ui_rightRockerCalibrateBtn, 0);
     ESP_LOGI(GAME_PAD_APP_TAG, "Release right rocker");
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release right rocker");
@@ -635,8 +618,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     right_rocker_y_adc_value[2] = right_rocker_y_adc_value[2] / 5;
     printf("right y max: %d\n", right_rocker_y_adc_value[2]);
-    sprintf(rocker_value_str, "%d", right_rocker_y_adc_value[2]);
-    flash_write_state("right_y_max", rocker_value_str);
     lv_obj_set_y(ui_rightRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release right rocker");
     lv_refr_now(NULL);
@@ -662,8 +643,6 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     }
     right_rocker_y_adc_value[0] = right_rocker_y_adc_value[0] / 5;
     printf("right y min: %d\n", right_rocker_y_adc_value[0]);
-    sprintf(rocker_value_str, "%d", right_rocker_y_adc_value[0]);
-    flash_write_state("right_y_min", rocker_value_str);
 
     lv_obj_set_y(ui_rightRockerCalibrateBtn, 0);
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Calibration success!");
@@ -673,7 +652,7 @@ void app_ui_event_rocker_calibration(lv_event_t *e)
     lv_label_set_text(ui_rockerCalibrationTipsLab, "Release all rocker");
     lv_label_set_text(ui_rockerCalibrationStartBtnText, "Start");
 
-    flash_write_state("calibrate_state", "1");
+    app_rocker_calibration_save();
 
     g_rocker_calibration_state = 1;
 }
@@ -691,12 +670,12 @@ void app_ui_event_hid_mode_select(lv_event_t *e)
         ESP_LOGI(GAME_PAD_APP_TAG, "BLE HID mode.");
         lv_obj_set_x(ui_hidModeSelectBtnPart, 22);
         lv_label_set_text(ui_hidModeSelectLab, "BLE");
-        flash_write_state("hid_mode", "1");
+        app_hid_mode_save();
     } else {
         ESP_LOGI(GAME_PAD_APP_TAG, "USB HID mode.");
         lv_obj_set_x(ui_hidModeSelectBtnPart, -22);
         lv_label_set_text(ui_hidModeSelectLab, "USB");
-        flash_write_state("hid_mode", "0");
+        app_hid_mode_save();
     }
 }
 
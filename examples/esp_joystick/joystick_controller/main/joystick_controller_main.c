@@ -38,7 +38,7 @@ void app_main(void)
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
         .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
+        .double_buffer = 1,     /* Render the next chunk while the previous one is on the bus */
         .flags = {
             .buff_dma = true,
         }
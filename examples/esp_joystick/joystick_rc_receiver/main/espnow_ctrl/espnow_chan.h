@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /**< _cplusplus */
+
+/**
+ * @brief Maximum number of peers whose last good channel is remembered
+ */
+#define ESPNOW_CHAN_PEER_MAX            8
+
+/**
+ * @brief Shortest ACK wait of the backoff, in millisecond
+ */
+#define ESPNOW_CHAN_BACKOFF_MIN_MS      10
+
+/**
+ * @brief Every Nth forwarded data frame is still swept across all channels,
+ *        so that peers on channels not learned yet keep receiving updates
+ */
+#define ESPNOW_CHAN_FORWARD_SWEEP_PERIOD 32
+
+/**
+ * @brief Channel discovery counters
+ */
+typedef struct {
+    uint32_t probe_hit;     /**< ACK received on a remembered channel */
+    uint32_t probe_miss;    /**< Remembered channel did not answer after all retries */
+    uint32_t sweep;         /**< Full channel sweeps started */
+    uint32_t sweep_hit;     /**< ACK received during a sweep */
+    uint32_t sweep_miss;    /**< Sweep finished without any ACK */
+    uint32_t channel_moved; /**< A known peer answered from a different channel */
+    uint32_t forward_tx;    /**< Frames transmitted by the forward path */
+    uint32_t forward_skip;  /**< Channels skipped by the forward path */
+} espnow_chan_stats_t;
+
+/**
+ * @brief  Load the remembered peer channels from storage
+ *
+ * @note  Called lazily by the other functions, calling it early only moves the flash read out of the first send.
+ *
+ * @return
+ *    - ESP_OK: succeed
+ *    - others: fail
+ */
+esp_err_t espnow_chan_init(void);
+
+/**
+ * @brief  Get the channels to probe before falling back to a sweep
+ *
+ * @param[out]  channels  buffer that receives the channels, most recently confirmed first
+ * @param[in]  max  buffer size
+ *
+ * @return  number of channels written, always at least one
+ */
+size_t espnow_chan_get_probe_list(uint8_t *channels, size_t max);
+
+/**
+ * @brief  Get the sweep order of all regulatory channels, excluding the ones in `skip`
+ *
+ * @param[out]  channels  buffer that receives the channels
+ * @param[in]  max  buffer size
+ * @param[in]  skip  channels already probed, may be NULL
+ * @param[in]  skip_num  number of entries in `skip`
+ *
+ * @return  number of channels written
+ */
+size_t espnow_chan_get_sweep_list(uint8_t *channels, size_t max, const uint8_t *skip, size_t skip_num);
+
+/**
+ * @brief  ACK wait time for the given retry, doubling on every retry
+ *
+ * The waits of all `attempts` add up to `base_ms` per attempt, as with a fixed wait, so a probed
+ * channel takes no longer than before: early retries are short for a lost frame, the last one is
+ * long for a slow responder. None is shorter than ESPNOW_CHAN_BACKOFF_MIN_MS.
+ */
+uint32_t espnow_chan_backoff_ms(uint32_t base_ms, uint32_t attempt, uint32_t attempts);
+
+/**
+ * @brief  Record that `mac` answered on `channel`
+ *
+ * @note  Storage is only written when the peer is new or its channel changed.
+ */
+void espnow_chan_update(const uint8_t mac[6], uint8_t channel);
+
+/**
+ * @brief  Account the result of a discovery round
+ *
+ * @param[in]  probed  true if the ACK arrived during the probe phase
+ * @param[in]  swept  true if a sweep was started
+ * @param[in]  found  true if any ACK was received
+ */
+void espnow_chan_report(bool probed, bool swept, bool found);
+
+/**
+ * @brief  Get the channels a received frame has to be forwarded on
+ *
+ * @param[in]  target  channel requested by the original sender
+ * @param[in]  primary  current channel of this device
+ * @param[out]  channels  buffer that receives the channels
+ * @param[in]  max  buffer size
+ *
+ * @return  number of channels written
+ */
+size_t espnow_chan_get_forward_list(uint8_t target, uint8_t primary, uint8_t *channels, size_t max);
+
+/**
+ * @brief  Get a snapshot of the discovery counters
+ */
+void espnow_chan_get_stats(espnow_chan_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /**< _cplusplus */
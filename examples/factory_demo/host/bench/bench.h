@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BENCH_STEP_WAIT,            /*!< Let virtual time run for ms */
+    BENCH_STEP_TAP_TEXT,        /*!< Press and release the visible label showing text */
+    BENCH_STEP_TAP_IMG,         /*!< Press and release the visible image showing the asset named img */
+    BENCH_STEP_BUTTON,          /*!< Release of the main button, i.e. "return" */
+    BENCH_STEP_CALL,            /*!< Call fn with the UI lock held, stands in for another task */
+    BENCH_STEP_MIC,             /*!< Start or stop feeding synthetic speech to the level meter */
+    BENCH_STEP_SHOT,            /*!< Compare the screen with the golden screenshot name */
+    BENCH_STEP_END,
+} bench_step_type_t;
+
+typedef struct {
+    bench_step_type_t type;
+    uint32_t ms;
+    const char *text;
+    const char *img;
+    void (*fn)(void);
+    bool on;
+} bench_step_t;
+
+#define BENCH_WAIT(ms_)         { .type = BENCH_STEP_WAIT, .ms = (ms_) }
+#define BENCH_TAP_TEXT(text_)   { .type = BENCH_STEP_TAP_TEXT, .text = (text_) }
+#define BENCH_TAP_IMG(img_)     { .type = BENCH_STEP_TAP_IMG, .img = (img_) }
+#define BENCH_BUTTON()          { .type = BENCH_STEP_BUTTON }
+#define BENCH_CALL(fn_)         { .type = BENCH_STEP_CALL, .fn = (fn_) }
+#define BENCH_MIC(on_)          { .type = BENCH_STEP_MIC, .on = (on_) }
+#define BENCH_SHOT(name_)       { .type = BENCH_STEP_SHOT, .text = (name_) }
+#define BENCH_END()             { .type = BENCH_STEP_END }
+
+typedef struct {
+    const char *name;
+    const bench_step_t *steps;  /*!< Ends with BENCH_END() */
+} bench_scenario_t;
+
+/* Run in order on one UI instance, each starts where the previous one left the screen */
+extern const bench_scenario_t bench_scenarios[];
+extern const size_t bench_scenario_count;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Schedules the boot steps of main/boot_steps.c with their expected durations, checks the order
+ * and prints the timeline with the critical path, the time boot cannot get under.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "boot_steps.h"
+
+/* Never called, the simulation only takes the table */
+#define STEP_STUB(_name) esp_err_t boot_##_name(void *arg) { (void) arg; return ESP_OK; }
+
+STEP_STUB(nvs)
+STEP_STUB(settings)
+STEP_STUB(spiffs)
+STEP_STUB(i2c)
+STEP_STUB(display)
+STEP_STUB(board)
+STEP_STUB(sensor_events)
+STEP_STUB(telemetry)
+STEP_STUB(assets)
+STEP_STUB(ui)
+STEP_STUB(backlight)
+STEP_STUB(player)
+STEP_STUB(led)
+STEP_STUB(sr)
+STEP_STUB(rmaker)
+
+static void usage(const char *argv0)
+{
+    boot_seq_config_t config = BOOT_SEQ_DEFAULT_CONFIG();
+    fprintf(stderr,
+            "Usage: %s [options] [STEP=MS ...]\n"
+            "  -w N       worker tasks, default %u\n"
+            "  -b MS      fail when boot takes longer\n"
+            "  STEP=MS    expected duration of a step, e.g. display=300\n",
+            argv0, (unsigned) config.workers);
+}
+
+static bool set_duration(const char *arg)
+{
+    const char *eq = strchr(arg, '=');
+    if (!eq) {
+        return false;
+    }
+    for (size_t i = 0; i < BOOT_STEP_NUM; i++) {
+        if (strlen(boot_steps[i].name) == (size_t)(eq - arg) && !strncmp(boot_steps[i].name, arg, eq - arg)) {
+            boot_steps[i].expect_ms = atoi(eq + 1);
+            return true;
+        }
+    }
+    fprintf(stderr, "No step named %.*s\n", (int)(eq - arg), arg);
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    boot_seq_config_t config = BOOT_SEQ_DEFAULT_CONFIG();
+    int budget_ms = 0;
+    int c;
+    while ((c = getopt(argc, argv, "w:b:h")) != -1) {
+        switch (c) {
+        case 'w':
+            config.workers = atoi(optarg);
+            break;
+        case 'b':
+            budget_ms = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    for (int i = optind; i < argc; i++) {
+        if (!set_duration(argv[i])) {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    boot_seq_report_t report;
+    if (ESP_OK != boot_seq_simulate(boot_steps, BOOT_STEP_NUM, &config, &report)) {
+        return 1;
+    }
+    boot_seq_print_report(boot_steps, BOOT_STEP_NUM, &report);
+
+    uint32_t serial_ms = 0;
+    for (size_t i = 0; i < BOOT_STEP_NUM; i++) {
+        serial_ms += boot_steps[i].expect_ms;
+    }
+    printf("boot_sim: one after another %u ms, %u workers %.1f ms, critical path %.1f ms\n", serial_ms,
+           (unsigned) config.workers, report.total_us / 1000.0,
+           boot_seq_critical_path(boot_steps, BOOT_STEP_NUM, &report, NULL, NULL) / 1000.0);
+
+    int ret = 0;
+    if (ESP_OK != boot_seq_verify(boot_steps, BOOT_STEP_NUM, &report)) {
+        ret = 1;
+    }
+    if (budget_ms && report.total_us > budget_ms * 1000LL) {
+        printf("boot_sim: over the budget of %d ms\n", budget_ms);
+        ret = 1;
+    }
+    return ret;
+}
@@ -0,0 +1,461 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * app_ir_store.c on a directory of the host: the record codec round trip, save, load and remove, and power loss.
+ * Every file operation of the store counts as a step; a save that compacts the library is cut at each step in
+ * turn, the last write torn in half, and the library reopened must hold the old or the new command and nothing
+ * else. Renames fail onto an existing file, as on SPIFFS.
+ */
+
+#include <errno.h>
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static FILE *crash_fopen(const char *path, const char *mode);
+static size_t crash_fwrite(const void *ptr, size_t size, size_t n, FILE *fp);
+static int crash_fclose(FILE *fp);
+static int crash_fsync(int fd);
+static int crash_rename(const char *from, const char *to);
+static int crash_remove(const char *path);
+
+/* Not in every libc */
+static size_t host_strlcpy(char *dst, const char *src, size_t size)
+{
+    snprintf(dst, size, "%s", src);
+    return strlen(src);
+}
+
+#define fopen   crash_fopen
+#define fwrite  crash_fwrite
+#define fclose  crash_fclose
+#define fsync   crash_fsync
+#define rename  crash_rename
+#define remove  crash_remove
+#define strlcpy host_strlcpy
+/* Included for the file names, the entries and the codec helpers */
+#include "app_ir_store.c"
+#undef fopen
+#undef fwrite
+#undef fclose
+#undef fsync
+#undef rename
+#undef remove
+#undef strlcpy
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define OPEN_MAX    8
+
+/* A power loss drops what the save had allocated, that is not a leak of the store */
+const char *__asan_default_options(void)
+{
+    return "detect_leaks=0";
+}
+
+static jmp_buf s_crash;
+static int s_steps;
+static int s_crash_at;          // 0 never
+static FILE *s_open[OPEN_MAX];
+static char s_dir[32];
+static uint32_t s_rng = 2463534242u;
+
+static uint32_t xorshift32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* Counts a step that changes the flash, and loses power before it when its turn has come */
+static bool crash_step(void)
+{
+    return ++s_steps == s_crash_at;
+}
+
+static void crash_now(void)
+{
+    longjmp(s_crash, 1);
+}
+
+static FILE *crash_fopen(const char *path, const char *mode)
+{
+    bool write = strpbrk(mode, "wa");
+    if (write && crash_step()) {
+        crash_now();
+    }
+    FILE *fp = fopen(path, mode);
+    for (int i = 0; fp && i < OPEN_MAX; i++) {
+        if (!s_open[i]) {
+            s_open[i] = fp;
+            break;
+        }
+    }
+    return fp;
+}
+
+/* Goes straight to the file, nothing buffered is written behind the store's back after a power loss */
+static size_t crash_fwrite(const void *ptr, size_t size, size_t n, FILE *fp)
+{
+    if (crash_step()) {
+        fwrite(ptr, 1, size * n / 2, fp);
+        fflush(fp);
+        crash_now();
+    }
+    size_t written = fwrite(ptr, size, n, fp);
+    fflush(fp);
+    return written;
+}
+
+static int crash_fclose(FILE *fp)
+{
+    for (int i = 0; i < OPEN_MAX; i++) {
+        if (s_open[i] == fp) {
+            s_open[i] = NULL;
+        }
+    }
+    return fclose(fp);
+}
+
+static int crash_fsync(int fd)
+{
+    if (crash_step()) {
+        crash_now();
+    }
+    return 0;
+}
+
+static int crash_rename(const char *from, const char *to)
+{
+    if (crash_step()) {
+        crash_now();
+    }
+    if (0 == access(to, F_OK)) {
+        errno = EEXIST;
+        return -1;
+    }
+    return rename(from, to);
+}
+
+static int crash_remove(const char *path)
+{
+    if (crash_step()) {
+        crash_now();
+    }
+    return remove(path);
+}
+
+/* After a power loss, what was left open is gone with the RAM */
+static void power_cycle(void)
+{
+    for (int i = 0; i < OPEN_MAX; i++) {
+        if (s_open[i]) {
+            fclose(s_open[i]);
+            s_open[i] = NULL;
+        }
+    }
+    s_crash_at = 0;
+    app_ir_store_init(s_dir);
+}
+
+static bool file_exists(const char *name)
+{
+    char path[IR_STORE_PATH_LEN];
+    ir_store_path(path, name);
+    return 0 == access(path, F_OK);
+}
+
+static void clean_dir(void)
+{
+    const char *const files[] = {
+        IR_STORE_INDEX_FILE, IR_STORE_INDEX_NEW_FILE, IR_STORE_DATA_FILE, IR_STORE_TEMP_FILE, IR_STORE_OLD_FILE,
+    };
+    char path[IR_STORE_PATH_LEN];
+
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", s_dir, files[i]);
+        remove(path);
+    }
+}
+
+static void add_frame(struct ir_learn_sub_list_head *head, uint32_t gap_us, const uint16_t *h, size_t n)
+{
+    rmt_symbol_word_t symbols[IR_STORE_MAX_HALVES / 2 + 1];
+    rmt_rx_done_event_data_t data = {
+        .received_symbols = symbols, .num_symbols = (n + 1) / 2,
+    };
+
+    for (size_t i = 0; i < data.num_symbols; i++) {
+        symbols[i] = (rmt_symbol_word_t) {
+            .duration0 = h[2 * i], .level0 = 1,
+            .duration1 = (2 * i + 1 < n) ? h[2 * i + 1] : 0, .level1 = 0,
+        };
+    }
+    ir_learn_add_sub_list_node(head, gap_us, &data);
+}
+
+/* A command that only compresses so far, with `version` in its timings */
+static void make_raw_command(struct ir_learn_sub_list_head *head, uint32_t version)
+{
+    uint16_t h[120];
+
+    SLIST_INIT(head);
+    s_rng = 2463534242u + version;
+    for (size_t i = 0; i < sizeof(h) / sizeof(h[0]); i++) {
+        h[i] = 300 + xorshift32() % 3000;
+    }
+    add_frame(head, 0, h, sizeof(h) / sizeof(h[0]));
+    add_frame(head, 40000 + version, h, 31);
+}
+
+static bool same_command(struct ir_learn_sub_list_head *a, struct ir_learn_sub_list_head *b)
+{
+    uint8_t ra[1024];
+    uint8_t rb[1024];
+    size_t la = app_ir_store_encode(a, ra, sizeof(ra));
+    size_t lb = app_ir_store_encode(b, rb, sizeof(rb));
+    return la && la == lb && !memcmp(ra, rb, la);
+}
+
+/* Which of versions `first`..`last` the stored command is, -1 for none */
+static int stored_version(const char *key, uint32_t first, uint32_t last)
+{
+    struct ir_learn_sub_list_head loaded;
+    int version = -1;
+
+    SLIST_INIT(&loaded);
+    if (ESP_OK == app_ir_store_load("tv", key, &loaded)) {
+        for (uint32_t v = first; v <= last && version < 0; v++) {
+            struct ir_learn_sub_list_head expected;
+            make_raw_command(&expected, v);
+            version = same_command(&loaded, &expected) ? (int) v : -1;
+            ir_learn_clean_sub_data(&expected);
+        }
+    }
+    ir_learn_clean_sub_data(&loaded);
+    return version;
+}
+
+static esp_err_t save_version(const char *key, uint32_t version)
+{
+    struct ir_learn_sub_list_head cmd;
+    make_raw_command(&cmd, version);
+    esp_err_t ret = app_ir_store_save("tv", key, &cmd);
+    ir_learn_clean_sub_data(&cmd);
+    return ret;
+}
+
+static bool test_codec(void)
+{
+    uint16_t h[IR_STORE_MAX_HALVES];
+    struct ir_learn_sub_list_head cmd;
+    struct ir_learn_sub_list_head decoded;
+    uint8_t record[2048];
+    const app_ir_proto_t protos[] = {
+        APP_IR_PROTO_NEC, APP_IR_PROTO_NEC_REPEAT, APP_IR_PROTO_SONY, APP_IR_PROTO_RC5, APP_IR_PROTO_RAW,
+    };
+
+    for (size_t i = 0; i < sizeof(protos) / sizeof(protos[0]); i++) {
+        size_t n = 0;
+        SLIST_INIT(&cmd);
+        switch (protos[i]) {
+        case APP_IR_PROTO_NEC:
+            n = ir_store_build_nec(0x3FC0EE11, h);
+            break;
+        case APP_IR_PROTO_NEC_REPEAT:
+            n = ir_store_build_nec_repeat(h);
+            break;
+        case APP_IR_PROTO_SONY:
+            n = ir_store_build_sony(0x5A3, 12, h);
+            break;
+        case APP_IR_PROTO_RC5:
+            n = ir_store_build_rc5(0x3123, h);
+            break;
+        default:
+            for (n = 0; n < 200; n++) {
+                h[n] = 100 + xorshift32() % 20000;
+            }
+            break;
+        }
+        add_frame(&cmd, 0, h, n);
+        add_frame(&cmd, 108000, h, n);
+
+        size_t len = app_ir_store_encode(&cmd, record, sizeof(record));
+        CHECK(len && len == app_ir_store_encode(&cmd, NULL, 0), "proto %d: encoded %zu", protos[i], len);
+        /* Frame count, gap of the first frame, then its type */
+        CHECK((record[2] & IR_STORE_PROTO_MASK) == protos[i], "proto %d stored as %d", protos[i],
+              record[2] & IR_STORE_PROTO_MASK);
+
+        SLIST_INIT(&decoded);
+        CHECK(ESP_OK == app_ir_store_decode(record, len, &decoded), "proto %d: decode failed", protos[i]);
+        ir_learn_sub_list_t *a = SLIST_FIRST(&cmd);
+        ir_learn_sub_list_t *b = SLIST_FIRST(&decoded);
+        for (; a && b; a = SLIST_NEXT(a, next), b = SLIST_NEXT(b, next)) {
+            uint16_t ha[IR_STORE_MAX_HALVES];
+            uint16_t hb[IR_STORE_MAX_HALVES];
+            uint8_t la = 0;
+            uint8_t lb = 0;
+            size_t na = ir_store_get_halves(a->symbols.received_symbols, a->symbols.num_symbols, ha, &la);
+            size_t nb = ir_store_get_halves(b->symbols.received_symbols, b->symbols.num_symbols, hb, &lb);
+            CHECK(a->timediff == b->timediff && na == nb && la == lb, "proto %d: frame differs", protos[i]);
+            for (size_t k = 0; k < na; k++) {
+                CHECK(abs(ha[k] - hb[k]) <= IR_STORE_QUANTUM_US / 2, "proto %d: half %zu is %u, was %u",
+                      protos[i], k, hb[k], ha[k]);
+            }
+        }
+        CHECK(!a && !b, "proto %d: frame count differs", protos[i]);
+        /* Cut short anywhere, a record must not decode */
+        for (size_t cut = 1; cut < len; cut++) {
+            struct ir_learn_sub_list_head partial;
+            SLIST_INIT(&partial);
+            CHECK(ESP_OK != app_ir_store_decode(record, cut, &partial), "proto %d: %zu of %zu bytes decoded",
+                  protos[i], cut, len);
+            ir_learn_clean_sub_data(&partial);
+        }
+        ir_learn_clean_sub_data(&cmd);
+        ir_learn_clean_sub_data(&decoded);
+    }
+    return true;
+}
+
+static bool test_save_load(void)
+{
+    clean_dir();
+    power_cycle();
+    CHECK(0 == entry_count, "%d commands in an empty library", entry_count);
+
+    for (int i = 0; i < 5; i++) {
+        CHECK(ESP_OK == save_version((char[]) { 'a' + i, 0 }, i), "save %d failed", i);
+    }
+    CHECK(ESP_OK == save_version("b", 10), "replace failed");
+    CHECK(ESP_OK == app_ir_store_remove("tv", "c"), "remove failed");
+    CHECK(ESP_ERR_NOT_FOUND == app_ir_store_remove("tv", "c"), "removed twice");
+
+    power_cycle();
+    CHECK(4 == entry_count, "%d commands after reopening", entry_count);
+    CHECK(0 == stored_version("a", 0, 0), "a lost");
+    CHECK(10 == stored_version("b", 10, 10), "b not replaced");
+    CHECK(!app_ir_store_exists("tv", "c"), "c not removed");
+    CHECK(4 == stored_version("e", 4, 4), "e lost");
+
+    /* A flipped bit in the data file is caught by the record CRC */
+    char path[IR_STORE_PATH_LEN];
+    ir_store_path(path, IR_STORE_DATA_FILE);
+    FILE *fp = fopen(path, "r+b");
+    CHECK(fp, "no data file");
+    fseek(fp, entries[0].offset + 3, SEEK_SET);
+    int byte = fgetc(fp);
+    fseek(fp, entries[0].offset + 3, SEEK_SET);
+    fputc(byte ^ 0x10, fp);
+    fclose(fp);
+    struct ir_learn_sub_list_head loaded;
+    SLIST_INIT(&loaded);
+    CHECK(ESP_ERR_INVALID_CRC == app_ir_store_load("tv", entries[0].key, &loaded), "corrupt record loaded");
+    ir_learn_clean_sub_data(&loaded);
+    return true;
+}
+
+/* Fills the library so that the next save of "k1" compacts it */
+static bool setup_compaction(void)
+{
+    clean_dir();
+    power_cycle();
+    for (int i = 0; i < 4; i++) {
+        CHECK(ESP_OK == save_version((char[]) { 'k', '0' + i, 0 }, 0), "setup save failed");
+    }
+    CHECK(ESP_OK == save_version("junk", 0), "setup save failed");
+    uint32_t k1_len = entries[ir_store_find("tv", "k1")].length;
+    while (dead_bytes + k1_len <= IR_STORE_COMPACT_BYTES) {
+        CHECK(ESP_OK == save_version("junk", 0), "setup save failed");
+    }
+    return true;
+}
+
+static bool check_after_crash(int step)
+{
+    CHECK(5 == entry_count, "step %d: %d commands", step, entry_count);
+    for (int i = 0; i < 4; i++) {
+        char key[3] = { 'k', '0' + i, 0 };
+        int version = stored_version(key, 0, 1);
+        CHECK(version == 0 || (i == 1 && version == 1), "step %d: %s is version %d", step, key, version);
+    }
+    CHECK(0 == stored_version("junk", 0, 0), "step %d: junk lost", step);
+    CHECK(!file_exists(IR_STORE_INDEX_NEW_FILE) && !file_exists(IR_STORE_TEMP_FILE) && !file_exists(IR_STORE_OLD_FILE),
+          "step %d: temporary files left", step);
+
+    /* And it keeps working */
+    CHECK(ESP_OK == save_version("k2", 7), "step %d: save after recovery failed", step);
+    power_cycle();
+    CHECK(7 == stored_version("k2", 7, 7) && 0 == stored_version("k3", 0, 0), "step %d: lost after recovery", step);
+    return true;
+}
+
+static bool test_power_loss(void)
+{
+    int step;
+    bool completed = false;
+    int compactions = 0;
+
+    for (step = 1; !completed && step < 200; step++) {
+        if (!setup_compaction()) {
+            return false;
+        }
+        s_steps = 0;
+        s_crash_at = step;
+        if (!setjmp(s_crash)) {
+            esp_err_t ret = save_version("k1", 1);
+            s_crash_at = 0;
+            CHECK(ESP_OK == ret, "save failed");
+            CHECK(0 == dead_bytes, "save did not compact");
+            compactions++;
+            completed = true;
+            /* Once the save returned, the new command survives a power loss */
+            power_cycle();
+            CHECK(1 == stored_version("k1", 1, 1), "saved command lost");
+        } else {
+            power_cycle();
+        }
+        if (!check_after_crash(step)) {
+            return false;
+        }
+    }
+    CHECK(completed && compactions == 1, "save never completed");
+    printf("power loss at each of %d steps of a compacting save recovered\n", step - 2);
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_codec, test_save_load, test_power_loss,
+    };
+    int failed = 0;
+
+    snprintf(s_dir, sizeof(s_dir), "/tmp/ir_store_XXXXXX");
+    if (!mkdtemp(s_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    clean_dir();
+    rmdir(s_dir);
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
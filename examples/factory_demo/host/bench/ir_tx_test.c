@@ -0,0 +1,322 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * app_ir_tx.c on the fake RMT channel of stubs/fake_rmt.c: the waveform of learned commands with their gaps, the
+ * pending queue and the done callbacks, a failed transmit, and deleting a command that is still being sent.
+ * Built with AddressSanitizer, which catches the channel reading a freed command.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "fake_rmt.h"
+
+/* Included to play the part of the done task, see run_done_task() */
+#include "app_ir_tx.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define DONE_MAX    16
+
+static const char *s_done[DONE_MAX];
+static size_t s_done_count;
+
+static void on_done(app_ir_tx_cmd_handle_t cmd, void *user_data)
+{
+    if (s_done_count < DONE_MAX) {
+        s_done[s_done_count] = user_data;
+    }
+    s_done_count++;
+}
+
+/* What ir_tx_done_task does on the target */
+static size_t run_done_task(void)
+{
+    ir_tx_pending_t done;
+    size_t count = 0;
+
+    while (xQueueReceive(tx_done_queue, &done, 0) == pdPASS) {
+        if (done.cb) {
+            done.cb(done.cmd, done.user_data);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void complete(size_t count)
+{
+    /* The done queue holds as many entries as can be pending */
+    while (count) {
+        size_t played = fake_rmt_complete(count < APP_IR_TX_QUEUE_DEPTH ? count : APP_IR_TX_QUEUE_DEPTH);
+        run_done_task();
+        if (!played) {
+            break;
+        }
+        count -= played;
+    }
+}
+
+static void reset_done(void)
+{
+    s_done_count = 0;
+    memset(s_done, 0, sizeof(s_done));
+}
+
+/* A learned NEC style frame, the receiver ends it with a zero duration */
+static const rmt_symbol_word_t s_frame_a[] = {
+    { .duration0 = 9000, .level0 = 1, .duration1 = 4500, .level1 = 0 },
+    { .duration0 = 560, .level0 = 1, .duration1 = 1690, .level1 = 0 },
+    { .duration0 = 560, .level0 = 1, .duration1 = 560, .level1 = 0 },
+    { .duration0 = 560, .level0 = 1, .duration1 = 0, .level1 = 0 },
+};
+
+/* A repeat code */
+static const rmt_symbol_word_t s_frame_b[] = {
+    { .duration0 = 9000, .level0 = 1, .duration1 = 2250, .level1 = 0 },
+    { .duration0 = 560, .level0 = 1, .duration1 = 0, .level1 = 0 },
+};
+
+/* A frame cut by the receive buffer, without the end marker */
+static const rmt_symbol_word_t s_frame_c[] = {
+    { .duration0 = 3000, .level0 = 1, .duration1 = 1000, .level1 = 0 },
+    { .duration0 = 500, .level0 = 1, .duration1 = 1500, .level1 = 0 },
+};
+
+typedef struct {
+    const rmt_symbol_word_t *symbols;
+    size_t num;
+    uint32_t gap_us;
+} learned_frame_t;
+
+static void learn(struct ir_learn_sub_list_head *head, const learned_frame_t *frames, size_t count)
+{
+    SLIST_INIT(head);
+    for (size_t i = 0; i < count; i++) {
+        rmt_rx_done_event_data_t data = {
+            .received_symbols = (rmt_symbol_word_t *) frames[i].symbols,
+            .num_symbols = frames[i].num,
+        };
+        ir_learn_add_sub_list_node(head, frames[i].gap_us, &data);
+    }
+}
+
+/* The waveform expected on air: the frames up to their end marker, low for each gap in between */
+static fake_rmt_output_t *expected_output(const learned_frame_t *frames, size_t count)
+{
+    static fake_rmt_output_t out;
+    bool open = false;
+
+    memset(&out, 0, sizeof(out));
+    for (size_t i = 0; i < count; i++) {
+        uint32_t gap = i ? frames[i].gap_us : 0;
+        if (open && !gap) {
+            gap = 1;        /* Zero would end the transmission */
+        } else if (!open && gap == 1) {
+            gap = 2;        /* An idle symbol has two halves of at least a tick */
+        }
+        fake_rmt_run_t runs[2 * 8 + 1];
+        size_t num = 0;
+        if (gap) {
+            runs[num++] = (fake_rmt_run_t) {
+                .level = 0, .duration = gap
+            };
+        }
+        open = false;
+        for (size_t j = 0; j < frames[i].num; j++) {
+            runs[num++] = (fake_rmt_run_t) {
+                .level = frames[i].symbols[j].level0, .duration = frames[i].symbols[j].duration0
+            };
+            if (!frames[i].symbols[j].duration1) {
+                open = true;
+                break;
+            }
+            runs[num++] = (fake_rmt_run_t) {
+                .level = frames[i].symbols[j].level1, .duration = frames[i].symbols[j].duration1
+            };
+        }
+        for (size_t k = 0; k < num; k++) {
+            fake_rmt_run_t *last = out.runs ? &out.air[out.runs - 1] : NULL;
+            if (last && last->level == runs[k].level) {
+                last->duration += runs[k].duration;
+            } else {
+                out.air[out.runs++] = runs[k];
+            }
+        }
+    }
+    out.transactions = 1;
+    return &out;
+}
+
+static bool same_output(const fake_rmt_output_t *got, const fake_rmt_output_t *expected)
+{
+    if (got->runs != expected->runs || got->transactions != expected->transactions || got->zero_duration) {
+        return false;
+    }
+    for (size_t i = 0; i < got->runs; i++) {
+        if (got->air[i].level != expected->air[i].level || got->air[i].duration != expected->air[i].duration) {
+            printf("run %zu: level %u for %u us, expected level %u for %u us\n", i, got->air[i].level,
+                   (unsigned) got->air[i].duration, expected->air[i].level, (unsigned) expected->air[i].duration);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool test_not_initialized(void)
+{
+    struct ir_learn_sub_list_head head;
+    const learned_frame_t frames[] = { { s_frame_a, 4, 0 } };
+    app_ir_tx_cmd_handle_t cmd = NULL;
+
+    learn(&head, frames, 1);
+    CHECK(ESP_OK == app_ir_tx_cmd_create(&head, &cmd), "create failed");
+    CHECK(ESP_ERR_INVALID_STATE == app_ir_tx_send(cmd, on_done, "x"), "sent without a channel");
+    app_ir_tx_cmd_delete(cmd);
+    ir_learn_clean_sub_data(&head);
+    return true;
+}
+
+static bool test_waveform(void)
+{
+    const learned_frame_t cases[][5] = {
+        { { s_frame_a, 4, 0 } },
+        { { s_frame_a, 4, 0 }, { s_frame_b, 2, 40000 }, { s_frame_b, 2, 96000 } },
+        { { s_frame_a, 4, 0 }, { s_frame_c, 2, 5000 }, { s_frame_a, 4, 70000 }, { s_frame_b, 2, 0 } },
+        { { s_frame_c, 2, 0 }, { s_frame_c, 2, 32767 }, { s_frame_c, 2, 32768 }, { s_frame_a, 4, 1 } },
+    };
+    const size_t lens[] = { 1, 3, 4, 4 };
+
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); i++) {
+        struct ir_learn_sub_list_head head;
+        app_ir_tx_cmd_handle_t cmd = NULL;
+
+        learn(&head, cases[i], lens[i]);
+        CHECK(ESP_OK == app_ir_tx_cmd_create(&head, &cmd), "case %zu: create failed", i);
+        /* The learned list is not needed after the command is created */
+        ir_learn_clean_sub_data(&head);
+
+        fake_rmt_clear_output();
+        CHECK(ESP_OK == app_ir_tx_send(cmd, NULL, NULL), "case %zu: send failed", i);
+        complete(1);
+        CHECK(same_output(fake_rmt_output(), expected_output(cases[i], lens[i])), "case %zu: waveform differs", i);
+        app_ir_tx_cmd_delete(cmd);
+    }
+    return true;
+}
+
+static bool test_queue(void)
+{
+    static const char *const names[] = { "0", "1", "2", "3", "4", "5", "6" };
+    struct ir_learn_sub_list_head head;
+    const learned_frame_t frames[] = { { s_frame_a, 4, 0 }, { s_frame_b, 2, 40000 } };
+    app_ir_tx_cmd_handle_t cmd = NULL;
+
+    learn(&head, frames, 2);
+    CHECK(ESP_OK == app_ir_tx_cmd_create(&head, &cmd), "create failed");
+    ir_learn_clean_sub_data(&head);
+    reset_done();
+    fake_rmt_clear_output();
+
+    for (int i = 0; i < APP_IR_TX_QUEUE_DEPTH; i++) {
+        CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, (void *) names[i]), "send %d failed", i);
+    }
+    CHECK(ESP_ERR_NO_MEM == app_ir_tx_send(cmd, on_done, (void *) names[6]), "queue deeper than the channel");
+    CHECK(APP_IR_TX_QUEUE_DEPTH == fake_rmt_queued(), "%zu queued", fake_rmt_queued());
+
+    complete(2);
+    CHECK(2 == s_done_count && !strcmp(s_done[0], "0") && !strcmp(s_done[1], "1"), "done out of order");
+    CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, (void *) names[4]), "send after done failed");
+    CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, (void *) names[5]), "send after done failed");
+    complete(4);
+    CHECK(6 == s_done_count, "%zu done", s_done_count);
+    for (int i = 0; i < 6; i++) {
+        CHECK(!strcmp(s_done[i], names[i]), "done %d is %s", i, s_done[i]);
+    }
+    CHECK(6 == fake_rmt_output()->transactions, "%zu transactions", fake_rmt_output()->transactions);
+    app_ir_tx_cmd_delete(cmd);
+    return true;
+}
+
+/* A failed transmit must give its pending slot back, and report nothing done */
+static bool test_transmit_fail(void)
+{
+    struct ir_learn_sub_list_head head;
+    const learned_frame_t frames[] = { { s_frame_b, 2, 0 } };
+    app_ir_tx_cmd_handle_t cmd = NULL;
+
+    learn(&head, frames, 1);
+    CHECK(ESP_OK == app_ir_tx_cmd_create(&head, &cmd), "create failed");
+    ir_learn_clean_sub_data(&head);
+    reset_done();
+
+    for (int i = 0; i < 2 * APP_IR_TX_QUEUE_DEPTH; i++) {
+        fake_rmt_fail_next();
+        CHECK(ESP_OK != app_ir_tx_send(cmd, on_done, "failed"), "failed transmit reported as sent");
+    }
+    for (int i = 0; i < APP_IR_TX_QUEUE_DEPTH; i++) {
+        CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, "sent"), "slot %d lost to a failed transmit", i);
+    }
+    complete(APP_IR_TX_QUEUE_DEPTH);
+    CHECK(APP_IR_TX_QUEUE_DEPTH == s_done_count, "%zu done", s_done_count);
+    for (size_t i = 0; i < s_done_count; i++) {
+        CHECK(!strcmp(s_done[i], "sent"), "a failed transmit was reported done");
+    }
+    app_ir_tx_cmd_delete(cmd);
+    return true;
+}
+
+/* Deleting a command waits for its queued transmissions, the channel reads its symbols until then */
+static bool test_delete_in_flight(void)
+{
+    struct ir_learn_sub_list_head head;
+    const learned_frame_t frames[] = { { s_frame_a, 4, 0 }, { s_frame_a, 4, 40000 } };
+    app_ir_tx_cmd_handle_t cmd = NULL;
+
+    learn(&head, frames, 2);
+    CHECK(ESP_OK == app_ir_tx_cmd_create(&head, &cmd), "create failed");
+    ir_learn_clean_sub_data(&head);
+    reset_done();
+    fake_rmt_clear_output();
+
+    CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, "a"), "send failed");
+    CHECK(ESP_OK == app_ir_tx_send(cmd, on_done, "b"), "send failed");
+    app_ir_tx_cmd_delete(cmd);
+    CHECK(0 == fake_rmt_queued(), "delete returned with %zu transmissions queued", fake_rmt_queued());
+    CHECK(2 == fake_rmt_output()->transactions, "%zu transactions", fake_rmt_output()->transactions);
+    run_done_task();
+    CHECK(2 == s_done_count, "%zu done", s_done_count);
+
+    app_ir_tx_cmd_delete(NULL);
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_waveform, test_queue, test_transmit_fail, test_delete_in_flight,
+    };
+    int failed = 0;
+
+    failed += !test_not_initialized();
+    if (ESP_OK != app_ir_tx_init() || ESP_OK != app_ir_tx_init()) {
+        printf("FAIL: init\n");
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
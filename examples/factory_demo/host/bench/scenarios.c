@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include "lvgl.h"
+#include "ui_net_config.h"
+#include "ui_sr.h"
+#include "host_stub.h"
+#include "bench.h"
+
+/* Menu of the BOX-3: Sensor Monitor, Device Control, Network, Media Player, Help, About Us */
+
+static void net_show_qrcode(void)
+{
+    ui_net_config_update_cb(UI_NET_EVT_GET_NAME, NULL);
+}
+
+static void player_playing(void)
+{
+    host_stub_audio_event(AUDIO_PLAYER_CALLBACK_EVENT_PLAYING);
+}
+
+static void sr_wake(void)
+{
+    sr_anim_start();
+    sr_anim_set_text("Say command");
+}
+
+static void sr_sleep(void)
+{
+    sr_anim_stop();
+}
+
+static const bench_step_t s_boot[] = {
+    BENCH_WAIT(4500),
+    BENCH_SHOT("boot_menu"),
+    BENCH_END(),
+};
+
+/* Nothing but the clock should redraw here, a minute boundary is crossed once */
+static const bench_step_t s_home_idle[] = {
+    BENCH_WAIT(60000),
+    BENCH_END(),
+};
+
+static const bench_step_t s_menu_cycle[] = {
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_END(),
+};
+
+static const bench_step_t s_sensor_monitor[] = {
+    BENCH_TAP_IMG("icon_sensor_monitor"),
+    BENCH_WAIT(3000),
+    BENCH_SHOT("sensor_monitor"),
+    BENCH_BUTTON(),
+    BENCH_WAIT(500),
+    BENCH_END(),
+};
+
+static const bench_step_t s_media_player[] = {
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_TEXT(LV_SYMBOL_RIGHT), BENCH_WAIT(300),
+    BENCH_TAP_IMG("icon_media_player"),
+    BENCH_WAIT(500),
+    BENCH_CALL(player_playing),
+    BENCH_WAIT(2000),
+    BENCH_SHOT("media_player"),
+    BENCH_TAP_TEXT(LV_SYMBOL_PAUSE),
+    BENCH_WAIT(1000),
+    BENCH_BUTTON(),
+    BENCH_WAIT(500),
+    BENCH_END(),
+};
+
+static const bench_step_t s_network[] = {
+    BENCH_TAP_TEXT(LV_SYMBOL_LEFT), BENCH_WAIT(300),
+    BENCH_TAP_IMG("icon_network"),
+    BENCH_WAIT(500),
+    BENCH_CALL(net_show_qrcode),
+    BENCH_WAIT(1000),
+    BENCH_SHOT("network"),
+    BENCH_BUTTON(),
+    BENCH_WAIT(500),
+    BENCH_END(),
+};
+
+static const bench_step_t s_sr_overlay[] = {
+    BENCH_CALL(sr_wake),
+    BENCH_MIC(true),
+    BENCH_WAIT(1500),
+    BENCH_SHOT("sr_overlay"),
+    BENCH_WAIT(1500),
+    BENCH_MIC(false),
+    BENCH_CALL(sr_sleep),
+    BENCH_WAIT(1000),
+    BENCH_END(),
+};
+
+const bench_scenario_t bench_scenarios[] = {
+    { "boot",           s_boot },
+    { "home_idle",      s_home_idle },
+    { "menu_cycle",     s_menu_cycle },
+    { "sensor_monitor", s_sensor_monitor },
+    { "media_player",   s_media_player },
+    { "network",        s_network },
+    { "sr_overlay",     s_sr_overlay },
+};
+
+const size_t bench_scenario_count = sizeof(bench_scenarios) / sizeof(bench_scenarios[0]);
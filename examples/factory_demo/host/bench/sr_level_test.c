@@ -0,0 +1,278 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * main/app/app_sr_level.c fed in AFE sized chunks: tones have to land in their own band, silence and full scale at
+ * the ends of the scale, and every chunk of the PCM files has to be measured within the budget. The files are the
+ * voice prompts of spiffs/, left channel, and any raw 16 kHz mono recording given on the command line, as the demo's
+ * SR record option writes them. Exits with 1 when a check fails.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "app_sr_level.h"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define SAMPLE_RATE     (16000)
+#define CHUNK           (512)       /* get_fetch_chunksize() of the AFE on the ESP32-S3, 32 ms */
+#define TONE_CHUNKS     (8)
+
+static const char *const s_prompts[] = {
+    "echo_en_wake.wav", "echo_en_ok.wav", "echo_en_end.wav", "echo_cn_wake.wav", "echo_cn_ok.wav", "echo_cn_end.wav",
+};
+
+static double s_budget_us = 100.0;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static sr_level_t feed(const int16_t *pcm, size_t chunks)
+{
+    sr_level_t level = { 0 };
+    for (size_t i = 0; i < chunks; i++) {
+        app_sr_level_update(pcm + i * CHUNK, CHUNK);
+    }
+    app_sr_level_get(&level, NULL);
+    return level;
+}
+
+static void tone(int16_t *pcm, size_t samples, double hz, double amplitude)
+{
+    for (size_t i = 0; i < samples; i++) {
+        pcm[i] = (int16_t) lrint(amplitude * 32767 * sin(2 * M_PI * hz * i / SAMPLE_RATE));
+    }
+}
+
+/* Before anything else: nothing is published until the first chunk */
+static bool test_publish(void)
+{
+    static int16_t pcm[CHUNK];
+    sr_level_t level;
+    uint32_t seq;
+
+    CHECK(!app_sr_level_get(&level, &seq), "published before the first chunk");
+    app_sr_level_update(pcm, CHUNK);
+    CHECK(app_sr_level_get(&level, &seq) && 1 == seq, "sequence %u after one chunk", (unsigned) seq);
+    app_sr_level_update(pcm, 0);
+    app_sr_level_update(pcm, CHUNK);
+    CHECK(app_sr_level_get(&level, &seq) && 2 == seq, "sequence %u after two chunks and an empty one",
+          (unsigned) seq);
+    return true;
+}
+
+/* Half scale sine: -9 dBFS RMS, -6 dBFS peak, the band of the tone well above the others */
+static bool test_tones(void)
+{
+    static const double hz[SR_LEVEL_BANDS] = { 200, 800, 1800, 5000 };
+    static int16_t pcm[TONE_CHUNKS * CHUNK];
+
+    for (size_t t = 0; t < SR_LEVEL_BANDS; t++) {
+        tone(pcm, TONE_CHUNKS * CHUNK, hz[t], 0.5);
+        sr_level_t level = feed(pcm, TONE_CHUNKS);
+        CHECK(level.rms >= 84 && level.rms <= 86, "%.0f Hz: rms %u", hz[t], level.rms);
+        CHECK(level.peak >= 89 && level.peak <= 90, "%.0f Hz: peak %u", hz[t], level.peak);
+        for (size_t b = 0; b < SR_LEVEL_BANDS; b++) {
+            CHECK(b == t || level.band[b] + 5 <= level.band[t], "%.0f Hz: band %zu %u, own band %u", hz[t], b,
+                  level.band[b], level.band[t]);
+        }
+    }
+    return true;
+}
+
+static bool test_range(void)
+{
+    static int16_t pcm[TONE_CHUNKS * CHUNK];
+
+    memset(pcm, 0, sizeof(pcm));
+    sr_level_t level = feed(pcm, TONE_CHUNKS);
+    CHECK(0 == level.rms && 0 == level.peak, "silence: rms %u peak %u", level.rms, level.peak);
+    for (size_t b = 0; b < SR_LEVEL_BANDS; b++) {
+        CHECK(0 == level.band[b], "silence: band %zu %u", b, level.band[b]);
+    }
+
+    /* -66 dBFS, under the floor */
+    tone(pcm, TONE_CHUNKS * CHUNK, 800, 0.0005);
+    level = feed(pcm, TONE_CHUNKS);
+    CHECK(0 == level.rms, "-66 dBFS: rms %u", level.rms);
+
+    for (size_t i = 0; i < TONE_CHUNKS * CHUNK; i++) {
+        pcm[i] = (i / 10) & 1 ? -32768 : 32767;
+    }
+    level = feed(pcm, TONE_CHUNKS);
+    CHECK(level.rms >= 99 && 100 == level.peak, "full scale: rms %u peak %u", level.rms, level.peak);
+    return true;
+}
+
+/* Left channel of a 16 kHz 16 bit WAV, or the whole file when it is not a WAV */
+static int16_t *load_pcm(const char *path, size_t *samples)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    size_t len = fread(data, 1, size, f);
+    fclose(f);
+
+    size_t channels = 1;
+    const uint8_t *pcm = data;
+    size_t bytes = len;
+    if (len >= 12 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WAVE", 4)) {
+        bytes = 0;
+        for (size_t pos = 12; pos + 8 <= len;) {
+            uint32_t chunk = data[pos + 4] | data[pos + 5] << 8 | data[pos + 6] << 16 | (uint32_t) data[pos + 7] << 24;
+            if (!memcmp(data + pos, "fmt ", 4) && chunk >= 16) {
+                uint32_t rate = data[pos + 12] | data[pos + 13] << 8 | data[pos + 14] << 16;
+                channels = data[pos + 10] | data[pos + 11] << 8;
+                if (SAMPLE_RATE != rate || 16 != data[pos + 22] || 0 == channels) {
+                    free(data);
+                    return NULL;
+                }
+            } else if (!memcmp(data + pos, "data", 4)) {
+                pcm = data + pos + 8;
+                bytes = chunk < len - pos - 8 ? chunk : len - pos - 8;
+                break;
+            }
+            pos += 8 + chunk + (chunk & 1);
+        }
+    }
+
+    *samples = bytes / (2 * channels);
+    int16_t *out = malloc((*samples ? *samples : 1) * sizeof(int16_t));
+    for (size_t i = 0; i < *samples; i++) {
+        out[i] = (int16_t)(pcm[2 * channels * i] | pcm[2 * channels * i + 1] << 8);
+    }
+    free(data);
+    return out;
+}
+
+/* Average and worst time of app_sr_level_update() per chunk, the loudest chunk */
+static double time_chunks(const int16_t *pcm, size_t chunks, double *worst_us, unsigned *loudest)
+{
+    double total_us = 0;
+
+    *worst_us = 0;
+    *loudest = 0;
+    for (size_t i = 0; i < chunks; i++) {
+        double start = now_us();
+        app_sr_level_update(pcm + i * CHUNK, CHUNK);
+        double us = now_us() - start;
+        total_us += us;
+        *worst_us = us > *worst_us ? us : *worst_us;
+
+        sr_level_t level;
+        app_sr_level_get(&level, NULL);
+        *loudest = level.rms > *loudest ? level.rms : *loudest;
+    }
+    return total_us / chunks;
+}
+
+/*
+ * Speech has to cost about what a tone does, silence included: a filter left to decay into subnormal floats costs
+ * several times more, whatever the build flags.
+ */
+static bool measure_file(const char *path, const char *name, double tone_us)
+{
+    size_t samples = 0;
+    int16_t *pcm = load_pcm(path, &samples);
+
+    CHECK(pcm, "%s: cannot read, or not 16 kHz 16 bit", path);
+    size_t chunks = samples / CHUNK;
+    if (0 == chunks) {
+        free(pcm);
+        CHECK(false, "%s: shorter than a chunk", path);
+    }
+    double worst_us;
+    unsigned loudest;
+    double avg_us = time_chunks(pcm, chunks, &worst_us, &loudest);
+    free(pcm);
+
+    printf("%-20s %6zu %8.2f %8.2f %8u\n", name, chunks, avg_us, worst_us, loudest);
+    CHECK(avg_us <= s_budget_us, "%s: %.2f us per chunk, budget %.2f us", name, avg_us, s_budget_us);
+    CHECK(avg_us <= 2 * tone_us, "%s: %.2f us per chunk, %.2f us on a tone", name, avg_us, tone_us);
+    /* Voice prompts, not silence */
+    CHECK(loudest >= 50, "%s: loudest chunk at %u", name, loudest);
+    return true;
+}
+
+static bool test_files(int argc, char **argv)
+{
+    static int16_t pcm[TONE_CHUNKS * CHUNK];
+    char path[512];
+    bool ok = true;
+    double worst_us;
+    unsigned loudest;
+
+    printf("%-20s %6s %8s %8s %8s\n", "file", "chunks", "avg us", "worst us", "max rms");
+    tone(pcm, TONE_CHUNKS * CHUNK, 800, 0.5);
+    double tone_us = 0;
+    for (int i = 0; i < 16; i++) {
+        tone_us += time_chunks(pcm, TONE_CHUNKS, &worst_us, &loudest) / 16;
+    }
+    printf("%-20s %6d %8.2f %8s %8u\n", "800 Hz tone", 16 * TONE_CHUNKS, tone_us, "-", loudest);
+    for (size_t i = 0; i < sizeof(s_prompts) / sizeof(s_prompts[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", SPIFFS_DIR, s_prompts[i]);
+        ok = measure_file(path, s_prompts[i], tone_us) && ok;
+    }
+    for (int i = 0; i < argc; i++) {
+        const char *name = strrchr(argv[i], '/');
+        ok = measure_file(argv[i], name ? name + 1 : argv[i], tone_us) && ok;
+    }
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int failed = 0;
+
+    while ((opt = getopt(argc, argv, "b:")) != -1) {
+        if ('b' == opt) {
+            s_budget_us = atof(optarg);
+        } else {
+            printf("usage: %s [-b budget_us] [file.pcm...]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"publish", test_publish},
+        {"tones", test_tones},
+        {"range", test_range},
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    failed += !test_files(argc - optind, argv + optind);
+
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
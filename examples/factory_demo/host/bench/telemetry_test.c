@@ -0,0 +1,291 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * app_telemetry.c fed with a synthetic day/night signal: every rollup against the raw samples behind it, queries
+ * over each chart range against a brute force summary of all samples, and the flash log of the rollups across a
+ * reboot, with its wrap, a torn record and samples taken before the clock was set.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "fake_partition.h"
+
+static time_t s_now;
+
+/* The history reads the wall clock only in queries, it follows the samples here */
+#define time(t) (s_now)
+#include "app_telemetry.c"
+#undef time
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define PERIOD_S        (APP_TELEMETRY_SAMPLE_PERIOD_MS / 1000)
+#define DAY_S           (24 * 3600)
+/* Monday 2024-03-04 00:00:00 UTC */
+#define TEST_START      1709510400
+#define HISTORY_DAYS    31
+
+/* Every sample fed, both channels, for the brute force summaries */
+static int16_t (*s_samples)[TELEMETRY_CH_NUM];
+static uint32_t s_sample_num;
+static uint32_t s_rng = 2463534242u;
+
+/* The sampling task is not run, the test feeds the samples */
+bsp_bottom_property_t *bsp_board_get_sensor_handle(void)
+{
+    return NULL;
+}
+
+static uint32_t xorshift32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+/* Day/night swing, a slow drift and sensor noise */
+static void feed(time_t from, time_t to)
+{
+    for (s_now = from; s_now < to; s_now += PERIOD_S) {
+        double day = (double)(s_now % DAY_S) / DAY_S;
+        double temperature = 22.0 + 4.0 * sin(2 * M_PI * day) + (s_now - TEST_START) / (30.0 * DAY_S)
+                             + (int)(xorshift32() % 21 - 10) / 100.0;
+        double humidity = 45.0 - 10.0 * sin(2 * M_PI * day) + (int)(xorshift32() % 41 - 20) / 100.0;
+
+        app_telemetry_add_sample(s_now, temperature, humidity);
+        if (s_now >= TEST_START) {
+            uint32_t i = (s_now - TEST_START) / PERIOD_S;
+            s_samples[i][APP_TELEMETRY_TEMPERATURE] = raw[(raw_head + TELEMETRY_RAW_SIZE - 1) % TELEMETRY_RAW_SIZE][0];
+            s_samples[i][APP_TELEMETRY_HUMIDITY] = raw[(raw_head + TELEMETRY_RAW_SIZE - 1) % TELEMETRY_RAW_SIZE][1];
+            s_sample_num = i + 1;
+        }
+    }
+    s_now -= PERIOD_S;
+}
+
+/* Summary of the samples in [start, start + width) */
+static void summarize(uint32_t start, uint32_t width, int ch, int16_t *min, int16_t *max, int64_t *sum, uint32_t *count)
+{
+    *min = INT16_MAX;
+    *max = INT16_MIN;
+    *sum = 0;
+    *count = 0;
+    for (uint32_t t = MAX(start, TEST_START); t < start + width; t += PERIOD_S) {
+        uint32_t i = (t - TEST_START) / PERIOD_S;
+        if (i >= s_sample_num) {
+            break;
+        }
+        *min = MIN(*min, s_samples[i][ch]);
+        *max = MAX(*max, s_samples[i][ch]);
+        *sum += s_samples[i][ch];
+        (*count)++;
+    }
+}
+
+static bool test_rollups(void)
+{
+    for (int t = 0; t < TELEMETRY_TIER_NUM; t++) {
+        const telemetry_tier_t *tier = &tiers[t];
+        CHECK(tier->count == MIN(tier->size, (s_now - TEST_START) / tier->width_s), "tier %d holds %u", t,
+              tier->count);
+        for (uint16_t i = 0; i < tier->count; i++) {
+            const telemetry_bucket_t *bucket = telemetry_tier_get(tier, i);
+            CHECK(bucket->start == s_now - s_now % tier->width_s - (i + 1) * tier->width_s, "tier %d bucket %u at %u",
+                  t, i, (unsigned) bucket->start);
+            for (int ch = 0; ch < TELEMETRY_CH_NUM; ch++) {
+                int16_t min, max;
+                int64_t sum;
+                uint32_t count;
+                summarize(bucket->start, tier->width_s, ch, &min, &max, &sum, &count);
+                CHECK(bucket->count == count && bucket->min[ch] == min && bucket->max[ch] == max
+                      && bucket->avg[ch] == sum / count, "tier %d bucket %u channel %d differs", t, i, ch);
+            }
+        }
+    }
+
+    int16_t samples[TELEMETRY_RAW_SIZE];
+    size_t num = app_telemetry_get_raw(APP_TELEMETRY_HUMIDITY, samples, TELEMETRY_RAW_SIZE);
+    CHECK(TELEMETRY_RAW_SIZE == num, "%zu raw samples", num);
+    for (size_t i = 0; i < num; i++) {
+        CHECK(samples[i] == s_samples[s_sample_num - num + i][APP_TELEMETRY_HUMIDITY], "raw sample %zu differs", i);
+    }
+    return true;
+}
+
+static bool test_queries(void)
+{
+    const uint32_t ranges[] = { 3600, DAY_S, 7 * DAY_S, 30 * DAY_S };
+    app_telemetry_point_t points[APP_TELEMETRY_QUERY_MAX_POINTS];
+
+    for (size_t r = 0; r < sizeof(ranges) / sizeof(ranges[0]); r++) {
+        const size_t num = 120;
+        CHECK(ESP_OK == app_telemetry_query(APP_TELEMETRY_TEMPERATURE, ranges[r], points, num), "query failed");
+
+        /* The finest tier that keeps the visit bounded, points made of whole buckets of it */
+        int t = 0;
+        while (t < TELEMETRY_TIER_NUM - 1 && ranges[r] / tiers[t].width_s > TELEMETRY_QUERY_MAX_BUCKETS) {
+            t++;
+        }
+        uint32_t width = tiers[t].width_s;
+        uint32_t from = s_now - ranges[r];
+        uint32_t slot = ranges[r] / num;
+
+        for (size_t p = 0; p < num; p++) {
+            int16_t min = INT16_MAX, max = INT16_MIN;
+            int64_t sum = 0;
+            uint32_t count = 0;
+            /* Buckets starting in the slot, the first one may reach back before it */
+            uint32_t first = from + p * slot;
+            uint32_t start = first - first % width + (first % width ? width : 0);
+            uint32_t end = (p == num - 1) ? (uint32_t) s_now + 1 : from + (p + 1) * slot;
+            for (; start < end; start += width) {
+                int16_t bmin, bmax;
+                int64_t bsum;
+                uint32_t bcount;
+                summarize(start, width, APP_TELEMETRY_TEMPERATURE, &bmin, &bmax, &bsum, &bcount);
+                if (bcount) {
+                    min = MIN(min, bmin);
+                    max = MAX(max, bmax);
+                    sum += bsum;
+                    count += bcount;
+                }
+            }
+            CHECK(points[p].count == count, "range %u point %zu: %u samples, expected %u", (unsigned) ranges[r], p,
+                  points[p].count, (unsigned) count);
+            if (count) {
+                /* Bucket averages are rounded down before they are merged */
+                CHECK(points[p].min == min && points[p].max == max && llabs(points[p].avg - sum / count) <= 1,
+                      "range %u point %zu: %d/%d/%d, expected %d/%d/%lld", (unsigned) ranges[r], p, points[p].min,
+                      points[p].max, points[p].avg, min, max, (long long)(sum / count));
+            }
+        }
+    }
+
+    CHECK(ESP_ERR_INVALID_ARG == app_telemetry_query(APP_TELEMETRY_TEMPERATURE, 3600, points,
+                                                     APP_TELEMETRY_QUERY_MAX_POINTS + 1), "too many points accepted");
+    return true;
+}
+
+/* The RAM is lost, the flash log is kept */
+static void reboot(void)
+{
+    persist_ready = false;
+    raw_head = raw_count = 0;
+    for (int t = 0; t < TELEMETRY_TIER_NUM; t++) {
+        telemetry_tier_clear(&tiers[t]);
+    }
+}
+
+static bool test_persist(void)
+{
+    const size_t sectors = 8;
+    const size_t per_sector = TELEMETRY_SECTOR_SIZE / sizeof(telemetry_record_t);
+    static telemetry_bucket_t before[TELEMETRY_TIER_NUM][30 * 24 * 4];
+    uint16_t before_count[TELEMETRY_TIER_NUM];
+
+    reboot();
+    fake_partition_create(APP_TELEMETRY_PARTITION_LABEL, sectors * TELEMETRY_SECTOR_SIZE);
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                         APP_TELEMETRY_PARTITION_LABEL);
+
+    /* Half a day before the clock is set, nothing of it may reach the log */
+    feed(3600, 3600 + DAY_S / 2);
+    CHECK(!persist_ready && 0 == fake_partition_erase_count(0), "persisted before the clock was set");
+    feed(TEST_START, TEST_START + 12 * DAY_S);
+    CHECK(0 == fake_partition_bad_writes(), "%u writes over unerased flash", (unsigned) fake_partition_bad_writes());
+
+    /* Twelve days of 15 min and 1 h rollups wrap the log once */
+    uint32_t records = 12 * 24 * (4 + 1);
+    for (size_t s = 0; s < sectors; s++) {
+        uint32_t erases = fake_partition_erase_count(s * TELEMETRY_SECTOR_SIZE);
+        CHECK(erases <= records / (sectors * per_sector) + 1, "sector %zu erased %u times", s, (unsigned) erases);
+    }
+
+    for (int t = TELEMETRY_PERSIST_TIER_MIN; t < TELEMETRY_TIER_NUM; t++) {
+        before_count[t] = tiers[t].count;
+        for (uint16_t i = 0; i < tiers[t].count; i++) {
+            before[t][i] = *telemetry_tier_get(&tiers[t], i);
+        }
+    }
+
+    /* A record torn by a power loss is skipped */
+    telemetry_record_t *torn = (telemetry_record_t *)(fake_partition_data() + write_offset) - 1;
+    if ((uint8_t *) torn < fake_partition_data()) {
+        torn = (telemetry_record_t *)(fake_partition_data() + partition->size) - 1;
+    }
+    torn->bucket.avg[0] ^= 1;
+    uint32_t torn_start = torn->bucket.start;
+    int torn_tier = torn->tier;
+
+    reboot();
+    app_telemetry_add_sample(s_now + PERIOD_S, 20.0, 50.0);
+
+    /* Whatever the log still holds comes back, the newest first */
+    size_t logged[TELEMETRY_TIER_NUM] = {0};
+    const telemetry_record_t *log = (const telemetry_record_t *) fake_partition_data();
+    for (size_t i = 0; i < sectors * per_sector; i++) {
+        if (telemetry_record_valid(&log[i]) && log[i].bucket.start >= TELEMETRY_TIME_VALID) {
+            logged[log[i].tier]++;
+        }
+    }
+    CHECK(logged[1] + logged[2] >= (sectors - 1) * per_sector - 1, "%zu rollups left in the log",
+          logged[1] + logged[2]);
+    for (int t = TELEMETRY_PERSIST_TIER_MIN; t < TELEMETRY_TIER_NUM; t++) {
+        const telemetry_tier_t *tier = &tiers[t];
+        uint16_t j = 0;
+        CHECK(tier->count == MIN(tier->size, logged[t]), "tier %d: %u of %zu rollups restored", t, tier->count,
+              logged[t]);
+        for (uint16_t i = 0; i < tier->count; i++) {
+            const telemetry_bucket_t *bucket = telemetry_tier_get(tier, i);
+            while (j < before_count[t] && before[t][j].start > bucket->start) {
+                CHECK(t == torn_tier && before[t][j].start == torn_start, "tier %d lost the bucket at %u", t,
+                      (unsigned) before[t][j].start);
+                j++;
+            }
+            /* Older than RAM held, with the torn one missing the log reaches one further back */
+            if (j == before_count[t]) {
+                break;
+            }
+            CHECK(!memcmp(bucket, &before[t][j], sizeof(*bucket)), "tier %d bucket at %u differs", t,
+                  (unsigned) bucket->start);
+            j++;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    s_samples = calloc(HISTORY_DAYS * DAY_S / PERIOD_S, sizeof(s_samples[0]));
+    if (!s_samples || ESP_OK != app_telemetry_init(false)) {
+        printf("FAIL: init\n");
+        return 1;
+    }
+
+    /* Thirty days and a bit, the 1 h tier wraps */
+    feed(TEST_START, TEST_START + HISTORY_DAYS * DAY_S - 1234);
+    failed += !test_rollups();
+    failed += !test_queries();
+    failed += !test_persist();
+
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,560 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Runs the factory_demo GUI headless on virtual time and replays the scenarios of scenarios.c.
+ * Frames and pixels depend only on the GUI code and are compared exactly, CPU time is compared
+ * with a slack, screenshots are compared with a per-channel tolerance.
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "lvgl.h"
+#include "lvgl_prof.h"
+#include "asset_pack.h"
+#include "esp_log.h"
+#include "app_sr_level.h"
+#include "ui_main.h"
+#include "ui_sensor_monitor.h"
+#include "host_stub.h"
+#include "fake_partition.h"
+#include "bench.h"
+
+#define HOR_RES             BSP_LCD_H_RES
+#define VER_RES             BSP_LCD_V_RES
+#define STEP_MS             5
+#define TAP_PRESS_MS        100
+#define TAP_RELEASE_MS      50
+#define MIC_RATE_HZ         16000
+#define MIC_CHUNK           512
+/* 2024-01-01 09:00:00 UTC, the clock turns to 09:01 during home_idle */
+#define VIRTUAL_EPOCH       1704099600
+#define ASSET_PARTITION     (256 * 1024)    // partitions.csv
+
+typedef struct {
+    uint32_t frames;
+    uint64_t px;
+    double cpu_ms;
+    uint32_t render_p50_us;
+    uint32_t render_p99_us;
+    uint32_t mem_peak_kb;
+    uint32_t mem_used_kb;
+} result_t;
+
+typedef struct {
+    const char *golden_dir;
+    const char *out_dir;
+    bool update;
+    double slack;
+    int tolerance;
+    int lines;
+} options_t;
+
+static options_t s_opt = {
+    .golden_dir = BENCH_GOLDEN_DIR,
+    .out_dir = "bench_out",
+    .slack = 0.5,
+    .tolerance = 2,
+    .lines = 10,
+};
+
+static lv_color_t s_fb[HOR_RES * VER_RES];
+static lv_disp_drv_t s_disp_drv;
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_indev_drv_t s_indev_drv;
+static lv_point_t s_touch_point;
+static bool s_touch_pressed;
+
+static uint32_t s_now_ms;
+static uint32_t s_frames;
+static uint64_t s_px;
+static double s_cpu_ms;
+
+static bool s_mic_on;
+static uint32_t s_mic_next_ms;
+static uint64_t s_mic_samples;
+
+static int s_failures;
+
+uint32_t host_stub_now_ms(void)
+{
+    return s_now_ms;
+}
+
+time_t __wrap_time(time_t *t)
+{
+    time_t now = VIRTUAL_EPOCH + s_now_ms / 1000;
+    if (t) {
+        *t = now;
+    }
+    return now;
+}
+
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    lv_coord_t w = lv_area_get_width(area);
+    for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+        memcpy(&s_fb[y * HOR_RES + area->x1], color_map, w * sizeof(lv_color_t));
+        color_map += w;
+    }
+    lv_disp_flush_ready(drv);
+}
+
+static void monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    s_frames++;
+    s_px += px;
+}
+
+static void touch_read_cb(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    data->point = s_touch_point;
+    data->state = s_touch_pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+static double wall_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+/* A voice-like signal: 140 Hz with a few harmonics under a 4 Hz syllable envelope */
+static void mic_feed(void)
+{
+    int16_t pcm[MIC_CHUNK];
+    for (size_t i = 0; i < MIC_CHUNK; i++) {
+        double t = (double)(s_mic_samples + i) / MIC_RATE_HZ;
+        double env = 0.5 * (1 - cos(2 * M_PI * 4 * t));
+        double v = sin(2 * M_PI * 140 * t) + 0.5 * sin(2 * M_PI * 280 * t) + 0.25 * sin(2 * M_PI * 700 * t);
+        pcm[i] = (int16_t)(6000 * env * v);
+    }
+    s_mic_samples += MIC_CHUNK;
+    app_sr_level_update(pcm, MIC_CHUNK);
+}
+
+static void run_for(uint32_t ms)
+{
+    for (uint32_t end = s_now_ms + ms; s_now_ms < end; s_now_ms += STEP_MS) {
+        if (s_mic_on && s_now_ms >= s_mic_next_ms) {
+            mic_feed();
+            s_mic_next_ms += MIC_CHUNK * 1000 / MIC_RATE_HZ;
+        }
+        lv_tick_inc(STEP_MS);
+        double start = wall_ms();
+        lv_timer_handler();
+        s_cpu_ms += wall_ms() - start;
+    }
+}
+
+static bool obj_visible(lv_obj_t *obj)
+{
+    lv_area_t area;
+    lv_obj_get_coords(obj, &area);
+    lv_area_t screen = { 0, 0, HOR_RES - 1, VER_RES - 1 };
+    if (!_lv_area_intersect(&area, &area, &screen)) {
+        return false;
+    }
+    for (lv_obj_t *o = obj; o; o = lv_obj_get_parent(o)) {
+        if (lv_obj_has_flag(o, LV_OBJ_FLAG_HIDDEN)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static lv_obj_t *find_obj(lv_obj_t *parent, const bench_step_t *step)
+{
+    /* Children drawn last are on top, search them first */
+    for (int32_t i = lv_obj_get_child_cnt(parent) - 1; i >= 0; i--) {
+        lv_obj_t *child = lv_obj_get_child(parent, i);
+        lv_obj_t *found = find_obj(child, step);
+        if (found) {
+            return found;
+        }
+    }
+    if (BENCH_STEP_TAP_TEXT == step->type && lv_obj_check_type(parent, &lv_label_class)) {
+        if (!strcmp(lv_label_get_text(parent), step->text) && obj_visible(parent)) {
+            return parent;
+        }
+    } else if (BENCH_STEP_TAP_IMG == step->type && lv_obj_check_type(parent, &lv_img_class)) {
+        if (lv_img_get_src(parent) == asset_pack_img(step->img) && obj_visible(parent)) {
+            return parent;
+        }
+    }
+    return NULL;
+}
+
+static bool tap(const bench_step_t *step)
+{
+    lv_obj_t *obj = find_obj(lv_layer_top(), step);
+    if (!obj) {
+        obj = find_obj(lv_scr_act(), step);
+    }
+    if (!obj) {
+        return false;
+    }
+
+    lv_area_t area;
+    lv_obj_get_coords(obj, &area);
+    s_touch_point.x = (area.x1 + area.x2) / 2;
+    s_touch_point.y = (area.y1 + area.y2) / 2;
+    s_touch_pressed = true;
+    run_for(TAP_PRESS_MS);
+    s_touch_pressed = false;
+    run_for(TAP_RELEASE_MS);
+    return true;
+}
+
+static void ensure_dir(const char *path)
+{
+    if (mkdir(path, 0755) && EEXIST != errno) {
+        fprintf(stderr, "Cannot create %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+}
+
+/* The pack CMake builds from the demo's sources, in the RAM partition the GUI maps like the one on the board */
+static void load_assets(void)
+{
+    FILE *f = fopen(BENCH_ASSET_PACK, "rb");
+    if (!f) {
+        fprintf(stderr, "Cannot read %s: %s\n", BENCH_ASSET_PACK, strerror(errno));
+        exit(1);
+    }
+    fake_partition_create("assets", ASSET_PARTITION);
+    size_t size = fread(fake_partition_data(), 1, ASSET_PARTITION, f);
+    bool whole = EOF == fgetc(f);
+    fclose(f);
+    if (!whole || ESP_OK != asset_pack_init("assets", NULL)) {
+        fprintf(stderr, "%s: %zu bytes, not a pack that fits the assets partition\n", BENCH_ASSET_PACK, size);
+        exit(1);
+    }
+}
+
+static void screen_to_rgb(uint8_t *rgb)
+{
+    for (size_t i = 0; i < HOR_RES * VER_RES; i++) {
+        lv_color32_t c = { .full = lv_color_to32(s_fb[i]) };
+        rgb[3 * i] = c.ch.red;
+        rgb[3 * i + 1] = c.ch.green;
+        rgb[3 * i + 2] = c.ch.blue;
+    }
+}
+
+static bool write_ppm(const char *path, const uint8_t *rgb)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", HOR_RES, VER_RES);
+    fwrite(rgb, 3, HOR_RES * VER_RES, f);
+    fclose(f);
+    return true;
+}
+
+static bool read_ppm(const char *path, uint8_t *rgb)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    int w = 0, h = 0, max = 0;
+    bool ok = 3 == fscanf(f, "P6 %d %d %d", &w, &h, &max) && HOR_RES == w && VER_RES == h && 255 == max &&
+              '\n' == fgetc(f) && HOR_RES * VER_RES == fread(rgb, 3, HOR_RES * VER_RES, f);
+    fclose(f);
+    if (!ok) {
+        fprintf(stderr, "%s is not a %dx%d P6 image\n", path, HOR_RES, VER_RES);
+    }
+    return ok;
+}
+
+static void shot(const char *name)
+{
+    static uint8_t rgb[HOR_RES * VER_RES * 3];
+    static uint8_t golden[HOR_RES * VER_RES * 3];
+    char path[512];
+
+    screen_to_rgb(rgb);
+    snprintf(path, sizeof(path), "%s/%s.ppm", s_opt.out_dir, name);
+    write_ppm(path, rgb);
+
+    snprintf(path, sizeof(path), "%s/%s.ppm", s_opt.golden_dir, name);
+    if (s_opt.update) {
+        write_ppm(path, rgb);
+        return;
+    }
+    if (!read_ppm(path, golden)) {
+        printf("  %-16s no golden screenshot in %s, run with -u to create it\n", name, s_opt.golden_dir);
+        s_failures++;
+        return;
+    }
+
+    /* Differing pixels in red over a faded copy of the golden */
+    size_t diff = 0;
+    for (size_t i = 0; i < HOR_RES * VER_RES; i++) {
+        bool same = true;
+        for (int c = 0; c < 3; c++) {
+            same &= abs(rgb[3 * i + c] - golden[3 * i + c]) <= s_opt.tolerance;
+        }
+        if (!same) {
+            diff++;
+        }
+        uint8_t gray = (golden[3 * i] + golden[3 * i + 1] + golden[3 * i + 2]) / 12 + 160;
+        rgb[3 * i] = same ? gray : 255;
+        rgb[3 * i + 1] = same ? gray : 0;
+        rgb[3 * i + 2] = same ? gray : 0;
+    }
+    if (diff) {
+        snprintf(path, sizeof(path), "%s/%s.diff.ppm", s_opt.out_dir, name);
+        write_ppm(path, rgb);
+        printf("  %-16s %zu pixels differ from the golden screenshot, see %s\n", name, diff, path);
+        s_failures++;
+    }
+}
+
+static void run_scenario(const bench_scenario_t *scenario, result_t *result)
+{
+    s_frames = 0;
+    s_px = 0;
+    s_cpu_ms = 0;
+    lvgl_prof_reset();
+
+    for (const bench_step_t *step = scenario->steps; BENCH_STEP_END != step->type; step++) {
+        switch (step->type) {
+        case BENCH_STEP_WAIT:
+            run_for(step->ms);
+            break;
+        case BENCH_STEP_TAP_TEXT:
+        case BENCH_STEP_TAP_IMG:
+            if (!tap(step)) {
+                printf("  %-16s nothing to tap for step %d\n", scenario->name, (int)(step - scenario->steps));
+                s_failures++;
+            }
+            break;
+        case BENCH_STEP_BUTTON:
+            host_stub_button_event(BSP_BUTTON_MAIN, BUTTON_PRESS_UP);
+            break;
+        case BENCH_STEP_CALL:
+            ui_acquire();
+            step->fn();
+            ui_release();
+            break;
+        case BENCH_STEP_MIC:
+            s_mic_on = step->on;
+            s_mic_next_ms = s_now_ms;
+            break;
+        case BENCH_STEP_SHOT:
+            shot(step->text);
+            break;
+        default:
+            break;
+        }
+    }
+
+    lvgl_prof_summary_t summary;
+    lvgl_prof_get_summary(&summary);
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    *result = (result_t) {
+        .frames = s_frames,
+        .px = s_px,
+        .cpu_ms = s_cpu_ms,
+        .render_p50_us = summary.render_p50_us,
+        .render_p99_us = summary.render_p99_us,
+        .mem_peak_kb = (mon.max_used + 1023) / 1024,
+        .mem_used_kb = (mon.total_size - mon.free_size + 1023) / 1024,
+    };
+}
+
+static void write_csv(const char *path, const result_t *results)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        s_failures++;
+        return;
+    }
+    fprintf(f, "scenario,frames,px,cpu_ms,render_p50_us,render_p99_us,mem_peak_kb,mem_used_kb\n");
+    for (size_t i = 0; i < bench_scenario_count; i++) {
+        const result_t *r = &results[i];
+        fprintf(f, "%s,%u,%llu,%.1f,%u,%u,%u,%u\n", bench_scenarios[i].name, (unsigned)r->frames,
+                (unsigned long long)r->px, r->cpu_ms, (unsigned)r->render_p50_us, (unsigned)r->render_p99_us,
+                (unsigned)r->mem_peak_kb, (unsigned)r->mem_used_kb);
+    }
+    fclose(f);
+}
+
+/* Frames and pixels must match, CPU time may grow by the slack, memory by a tenth */
+static void compare_csv(const char *path, const result_t *results)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("No golden results in %s, run with -u to create them\n", path);
+        s_failures++;
+        return;
+    }
+
+    char line[256];
+    fgets(line, sizeof(line), f);
+    while (fgets(line, sizeof(line), f)) {
+        char name[64];
+        result_t g;
+        unsigned long long px;
+        if (8 != sscanf(line, "%63[^,],%u,%llu,%lf,%u,%u,%u,%u", name, &g.frames, &px, &g.cpu_ms,
+                        &g.render_p50_us, &g.render_p99_us, &g.mem_peak_kb, &g.mem_used_kb)) {
+            continue;
+        }
+        g.px = px;
+
+        for (size_t i = 0; i < bench_scenario_count; i++) {
+            if (strcmp(name, bench_scenarios[i].name)) {
+                continue;
+            }
+            const result_t *r = &results[i];
+            if (r->frames != g.frames || r->px != g.px) {
+                printf("  %-16s frames %u px %llu, golden has %u and %llu\n", name, (unsigned)r->frames,
+                       (unsigned long long)r->px, (unsigned)g.frames, px);
+                s_failures++;
+            }
+            if (r->cpu_ms > g.cpu_ms * (1 + s_opt.slack)) {
+                printf("  %-16s %.1f ms of CPU, golden has %.1f ms\n", name, r->cpu_ms, g.cpu_ms);
+                s_failures++;
+            }
+            if (r->mem_peak_kb > g.mem_peak_kb * 11 / 10) {
+                printf("  %-16s peak %u KB, golden has %u KB\n", name, (unsigned)r->mem_peak_kb,
+                       (unsigned)g.mem_peak_kb);
+                s_failures++;
+            }
+        }
+    }
+    fclose(f);
+}
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -u         write screenshots and results as the new goldens\n"
+            "  -g DIR     golden directory, default %s\n"
+            "  -o DIR     output directory, default %s\n"
+            "  -s SLACK   allowed CPU time growth over the golden, default %.2f\n"
+            "  -t N       allowed difference per color channel, default %d\n"
+            "  -l LINES   height of each of the two draw buffers, default %d\n"
+            "  -v         LVGL and GUI logs down to info\n",
+            argv0, s_opt.golden_dir, s_opt.out_dir, s_opt.slack, s_opt.tolerance, s_opt.lines);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+    while ((c = getopt(argc, argv, "ug:o:s:t:l:vh")) != -1) {
+        switch (c) {
+        case 'u':
+            s_opt.update = true;
+            break;
+        case 'g':
+            s_opt.golden_dir = optarg;
+            break;
+        case 'o':
+            s_opt.out_dir = optarg;
+            break;
+        case 's':
+            s_opt.slack = atof(optarg);
+            break;
+        case 't':
+            s_opt.tolerance = atoi(optarg);
+            break;
+        case 'l':
+            s_opt.lines = atoi(optarg);
+            break;
+        case 'v':
+            esp_log_level_set("*", ESP_LOG_INFO);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (s_opt.lines < 1 || s_opt.lines > VER_RES) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    ensure_dir(s_opt.out_dir);
+    if (s_opt.update) {
+        ensure_dir(s_opt.golden_dir);
+    }
+
+    lv_init();
+    load_assets();
+
+    lv_color_t *buf[2];
+    for (int i = 0; i < 2; i++) {
+        buf[i] = malloc(HOR_RES * s_opt.lines * sizeof(lv_color_t));
+    }
+    lv_disp_draw_buf_init(&s_draw_buf, buf[0], buf[1], HOR_RES * s_opt.lines);
+    lv_disp_drv_init(&s_disp_drv);
+    s_disp_drv.hor_res = HOR_RES;
+    s_disp_drv.ver_res = VER_RES;
+    s_disp_drv.flush_cb = flush_cb;
+    s_disp_drv.monitor_cb = monitor_cb;
+    s_disp_drv.draw_buf = &s_draw_buf;
+    lv_disp_t *disp = lv_disp_drv_register(&s_disp_drv);
+    lvgl_prof_attach(disp);
+
+    lv_indev_drv_init(&s_indev_drv);
+    s_indev_drv.type = LV_INDEV_TYPE_POINTER;
+    s_indev_drv.read_cb = touch_read_cb;
+    lv_indev_drv_register(&s_indev_drv);
+
+    sensor_task_state_event_init();
+    ui_main_start();
+
+    result_t *results = calloc(bench_scenario_count, sizeof(result_t));
+    printf("%dx%d, 2 x %d line buffers\n", HOR_RES, VER_RES, s_opt.lines);
+    printf("%-16s %7s %11s %9s %9s %9s %8s %8s\n", "scenario", "frames", "px", "cpu ms", "rend p50", "rend p99",
+           "peak KB", "used KB");
+    for (size_t i = 0; i < bench_scenario_count; i++) {
+        result_t *r = &results[i];
+        run_scenario(&bench_scenarios[i], r);
+        printf("%-16s %7u %11llu %9.1f %7u us %7u us %8u %8u\n", bench_scenarios[i].name, (unsigned)r->frames,
+               (unsigned long long)r->px, r->cpu_ms, (unsigned)r->render_p50_us, (unsigned)r->render_p99_us,
+               (unsigned)r->mem_peak_kb, (unsigned)r->mem_used_kb);
+    }
+
+    char path[512];
+    snprintf(path, sizeof(path), "%s/bench.csv", s_opt.out_dir);
+    write_csv(path, results);
+    snprintf(path, sizeof(path), "%s/bench.csv", s_opt.golden_dir);
+    if (s_opt.update) {
+        write_csv(path, results);
+    } else {
+        compare_csv(path, results);
+    }
+    free(results);
+
+    if (s_failures) {
+        printf("%d check(s) failed\n", s_failures);
+        return 1;
+    }
+    if (s_opt.update) {
+        printf("Goldens updated in %s\n", s_opt.golden_dir);
+    } else {
+        printf("All checks passed\n");
+    }
+    return 0;
+}
@@ -0,0 +1,326 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * main/gui/ui_bind.c on the fake labels of stubs/fake_lvgl.c: unchanged values, coalesced sets, text already shown,
+ * custom binds, detaching on delete and attaching again, and a writer thread racing the flushes. Then one minute of
+ * the status bar clock and of the sensor page, once the way the GUI wrote its labels before the binds and once
+ * through them, with the label writes and the pixels they invalidate. Exits with 1 when a check fails.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "ui_bind.h"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define RACE_SETS           (200000)
+
+/* Sizes on the BOX-3: "09:00" in Montserrat 14, two digits of font_en_22 and icon_rader_on */
+#define CLOCK_W             (39)
+#define CLOCK_H             (16)
+#define VALUE_W             (27)
+#define VALUE_H             (24)
+#define RADAR_W             (32)
+#define RADAR_H             (32)
+
+/* Period of update_timer_cb() in ui_sensor_monitor.c */
+#define SENSOR_PERIOD_MS    (300)
+
+static int s_applied;
+static const char s_img_on[] = "icon_rader_on";
+static const char s_img_off[] = "icon_rader_off";
+
+static void src_apply(lv_obj_t *obj, intptr_t src)
+{
+    lv_img_set_src(obj, (const void *) src);
+    s_applied++;
+}
+
+/* As ui_main.c */
+static void clock_apply(lv_obj_t *lab_time, intptr_t minute_of_day)
+{
+    lv_label_set_text_fmt(lab_time, "%02u:%02u", (unsigned)(minute_of_day / 60), (unsigned)(minute_of_day % 60));
+}
+
+static bool test_unchanged(void)
+{
+    static ui_bind_t bind = UI_BIND_TEXT_INT("%d");
+    lv_obj_t label;
+
+    fake_lvgl_obj_init(&label, VALUE_W, VALUE_H);
+    ui_bind_set(&bind, 5);
+    ui_bind_attach(&bind, &label);
+    CHECK(!strcmp("5", label.text) && 1 == label.writes, "\"%s\" after %u writes", label.text,
+          (unsigned) label.writes);
+    ui_bind_set(&bind, 5);
+    ui_bind_flush();
+    CHECK(1 == label.writes, "%u writes for the value shown", (unsigned) label.writes);
+
+    /* Other code wrote the same text meanwhile */
+    lv_label_set_text(&label, "6");
+    ui_bind_set(&bind, 6);
+    ui_bind_flush();
+    CHECK(2 == label.writes, "%u writes for the text shown", (unsigned) label.writes);
+    lv_obj_del(&label);
+    return true;
+}
+
+static bool test_coalesce(void)
+{
+    static ui_bind_t bind = UI_BIND_TEXT_INT("%d%%");
+    lv_obj_t label;
+
+    fake_lvgl_obj_init(&label, VALUE_W, VALUE_H);
+    ui_bind_attach(&bind, &label);
+    uint32_t writes = label.writes;
+    for (int i = 0; i < 10; i++) {
+        ui_bind_set(&bind, i);
+    }
+    ui_bind_set(&bind, 42);
+    ui_bind_flush();
+    CHECK(writes + 1 == label.writes && !strcmp("42%", label.text), "\"%s\" after %u writes", label.text,
+          (unsigned)(label.writes - writes));
+
+    /* Away and back within a period */
+    ui_bind_set(&bind, 43);
+    ui_bind_set(&bind, 42);
+    ui_bind_flush();
+    CHECK(writes + 1 == label.writes, "%u writes for a value set back", (unsigned)(label.writes - writes));
+
+    /* The timer created by ui_bind_init() flushes once per refresh period */
+    ui_bind_set(&bind, 7);
+    fake_lvgl_run(LV_DISP_DEF_REFR_PERIOD);
+    CHECK(writes + 2 == label.writes && !strcmp("7%", label.text), "\"%s\" after the refresh period", label.text);
+    lv_obj_del(&label);
+    return true;
+}
+
+static bool test_static(void)
+{
+    static ui_bind_t bind = UI_BIND_TEXT_STATIC();
+    lv_obj_t label;
+
+    fake_lvgl_obj_init(&label, VALUE_W, VALUE_H);
+    lv_label_set_text(&label, "ab");
+    ui_bind_attach(&bind, &label);
+    CHECK(1 == label.writes && !strcmp("ab", label.text), "a bind without a value wrote \"%s\"", label.text);
+    ui_bind_set(&bind, (intptr_t) "ab");
+    ui_bind_flush();
+    CHECK(1 == label.writes, "%u writes for the text shown", (unsigned) label.writes);
+    ui_bind_set(&bind, (intptr_t) "cd");
+    ui_bind_flush();
+    CHECK(2 == label.writes && !strcmp("cd", label.text), "\"%s\" after %u writes", label.text,
+          (unsigned) label.writes);
+    lv_obj_del(&label);
+    return true;
+}
+
+/* Values set while the page is closed show when it opens again, the bind moves to the new object */
+static bool test_reattach(void)
+{
+    static ui_bind_t bind = UI_BIND_CUSTOM(src_apply);
+    lv_obj_t img;
+    lv_obj_t img2;
+
+    s_applied = 0;
+    fake_lvgl_obj_init(&img, RADAR_W, RADAR_H);
+    ui_bind_set(&bind, (intptr_t) s_img_off);
+    ui_bind_attach(&bind, &img);
+    CHECK(1 == s_applied && s_img_off == img.src, "%d applies on attach", s_applied);
+    ui_bind_set(&bind, (intptr_t) s_img_on);
+    ui_bind_set(&bind, (intptr_t) s_img_off);
+    ui_bind_set(&bind, (intptr_t) s_img_on);
+    ui_bind_flush();
+    CHECK(2 == s_applied && s_img_on == img.src, "%d applies", s_applied);
+
+    lv_obj_del(&img);
+    ui_bind_set(&bind, (intptr_t) s_img_off);
+    ui_bind_flush();
+    CHECK(2 == s_applied, "applied to a deleted object");
+
+    fake_lvgl_obj_init(&img2, RADAR_W, RADAR_H);
+    ui_bind_attach(&bind, &img2);
+    CHECK(3 == s_applied && s_img_off == img2.src, "%d applies after attach", s_applied);
+
+    /* Straight to another object, the old one keeps no callback */
+    fake_lvgl_obj_init(&img, RADAR_W, RADAR_H);
+    ui_bind_attach(&bind, &img);
+    for (size_t i = 0; i < FAKE_LVGL_EVENT_CB_MAX; i++) {
+        CHECK(NULL == img2.event_cbs[i].cb, "delete callback left on the previous object");
+    }
+    CHECK(4 == s_applied && s_img_off == img.src, "%d applies after moving", s_applied);
+    lv_obj_del(&img2);
+    ui_bind_flush();
+    CHECK(4 == s_applied, "the bind left its object with the previous one");
+    lv_obj_del(&img);
+    return true;
+}
+
+static ui_bind_t s_race_bind = UI_BIND_TEXT_INT("%d");
+static volatile bool s_race_done;
+
+static void *writer_task(void *arg)
+{
+    for (int i = 0; i <= RACE_SETS; i++) {
+        ui_bind_set(&s_race_bind, i);
+    }
+    s_race_done = true;
+    return NULL;
+}
+
+/* Sets from another task while the UI flushes: no value is lost for good, the last one always lands */
+static bool test_race(void)
+{
+    lv_obj_t label;
+    pthread_t writer;
+    unsigned flushes = 0;
+    char last[16];
+
+    fake_lvgl_obj_init(&label, VALUE_W, VALUE_H);
+    ui_bind_attach(&s_race_bind, &label);
+    pthread_create(&writer, NULL, writer_task, NULL);
+    while (!s_race_done) {
+        ui_bind_flush();
+        flushes++;
+    }
+    pthread_join(writer, NULL);
+    ui_bind_flush();
+    snprintf(last, sizeof(last), "%d", RACE_SETS);
+    CHECK(!strcmp(last, label.text), "\"%s\" after the last set", label.text);
+    CHECK(label.writes <= flushes + 2, "%u writes for %u flushes", (unsigned) label.writes, flushes);
+    lv_obj_del(&label);
+    return true;
+}
+
+typedef struct {
+    const char *name;
+    uint32_t changes;
+    lv_obj_t before;
+    lv_obj_t after;
+} minute_row_t;
+
+/* The demo rounds up from .5 exclusive */
+static int reading(float value)
+{
+    int whole = (int) value;
+    return value - whole > 0.5f ? whole + 1 : whole;
+}
+
+/* What the GUI shows at ms into the minute */
+static void minute_values(int ms, intptr_t value[4])
+{
+    value[0] = 9 * 60 + (30 + ms / 1000) / 60;
+    value[1] = reading(24.3f + 0.5f * ms / 60000);
+    value[2] = reading(41.2f + 1.6f * ms / 60000);
+    value[3] = (intptr_t)(ms >= 20000 && ms < 45000 ? s_img_on : s_img_off);
+}
+
+/*
+ * One minute from 09:00:30: the clock timer every second, the sensor page every SENSOR_PERIOD_MS with temperature
+ * drifting up by half a degree, humidity by 1.6 %, and someone in front of the radar from 20 s to 45 s. Before,
+ * each tick wrote its label or image whatever the value; now each tick sets a bind, set once before attaching as
+ * the pages do.
+ */
+static bool test_minute(void)
+{
+    static ui_bind_t clock_bind = UI_BIND_CUSTOM(clock_apply);
+    static ui_bind_t temp_bind = UI_BIND_TEXT_INT("%d");
+    static ui_bind_t hum_bind = UI_BIND_TEXT_INT("%d");
+    static ui_bind_t radar_bind = UI_BIND_CUSTOM(src_apply);
+    ui_bind_t *binds[] = { &clock_bind, &temp_bind, &hum_bind, &radar_bind };
+    minute_row_t rows[] = {
+        { .name = "clock" },
+        { .name = "temperature" },
+        { .name = "humidity" },
+        { .name = "radar image" },
+    };
+    const lv_coord_t sizes[][2] = {
+        { CLOCK_W, CLOCK_H }, { VALUE_W, VALUE_H }, { VALUE_W, VALUE_H }, { RADAR_W, RADAR_H },
+    };
+    intptr_t shown[4];
+
+    minute_values(0, shown);
+    for (size_t r = 0; r < 4; r++) {
+        fake_lvgl_obj_init(&rows[r].before, sizes[r][0], sizes[r][1]);
+        fake_lvgl_obj_init(&rows[r].after, sizes[r][0], sizes[r][1]);
+        ui_bind_set(binds[r], shown[r]);
+        ui_bind_attach(binds[r], &rows[r].after);
+    }
+    for (int ms = 0; ms < 60000; ms += 10) {
+        intptr_t value[4];
+        minute_values(ms, value);
+        if (0 == ms % 1000) {
+            clock_apply(&rows[0].before, value[0]);
+            ui_bind_set(&clock_bind, value[0]);
+            rows[0].changes += value[0] != shown[0];
+            shown[0] = value[0];
+        }
+        if (0 == ms % SENSOR_PERIOD_MS) {
+            lv_label_set_text_fmt(&rows[1].before, "%d", (int) value[1]);
+            lv_label_set_text_fmt(&rows[2].before, "%d", (int) value[2]);
+            lv_img_set_src(&rows[3].before, (const void *) value[3]);
+            for (size_t r = 1; r < 4; r++) {
+                ui_bind_set(binds[r], value[r]);
+                rows[r].changes += value[r] != shown[r];
+                shown[r] = value[r];
+            }
+        }
+        fake_lvgl_run(10);
+    }
+
+    printf("%-14s %8s %14s %14s %14s %14s\n", "one minute", "changes", "writes before", "writes after",
+           "px before", "px after");
+    for (size_t r = 0; r < 4; r++) {
+        printf("%-14s %8u %14u %14u %14u %14u\n", rows[r].name, (unsigned) rows[r].changes,
+               (unsigned) rows[r].before.writes, (unsigned) rows[r].after.writes, (unsigned) rows[r].before.px,
+               (unsigned) rows[r].after.px);
+    }
+    for (size_t r = 0; r < 4; r++) {
+        /* The write on attach, then one per change */
+        CHECK(rows[r].after.writes == 1 + rows[r].changes, "%s: %u writes for %u changes", rows[r].name,
+              (unsigned) rows[r].after.writes, (unsigned) rows[r].changes);
+        CHECK(!strcmp(rows[r].before.text, rows[r].after.text) && rows[r].before.src == rows[r].after.src,
+              "%s: \"%s\" shown, \"%s\" before", rows[r].name, rows[r].after.text, rows[r].before.text);
+        lv_obj_del(&rows[r].before);
+        lv_obj_del(&rows[r].after);
+    }
+    return true;
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        bool (*fn)(void);
+    } tests[] = {
+        {"unchanged", test_unchanged},
+        {"coalesce", test_coalesce},
+        {"static", test_static},
+        {"reattach", test_reattach},
+        {"race", test_race},
+        {"minute", test_minute},
+    };
+    int failed = 0;
+
+    ui_bind_init();
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        bool ok = tests[i].fn();
+        printf("%-20s %s\n", tests[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
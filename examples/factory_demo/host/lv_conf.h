@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * LVGL 8.3 configuration of the host bench. Options follow sdkconfig.defaults of the demo where they change
+ * what is drawn, anything not set here takes the lv_conf_internal.h default.
+ */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <stdint.h>
+
+#define LV_COLOR_DEPTH              16
+/* The panel wants swapped bytes, the framebuffer here is read back by the bench */
+#define LV_COLOR_16_SWAP            0
+
+/* Built-in allocator, so lv_mem_monitor() reports the peak the GUI needs */
+#define LV_MEM_CUSTOM               0
+#define LV_MEM_SIZE                 (512U * 1024U)
+
+/* Time is virtual, the bench calls lv_tick_inc() */
+#define LV_TICK_CUSTOM              0
+#define LV_DISP_DEF_REFR_PERIOD     30
+#define LV_INDEV_DEF_READ_PERIOD    30
+
+#define LV_USE_LOG                  1
+#define LV_LOG_LEVEL                LV_LOG_LEVEL_WARN
+#define LV_LOG_PRINTF               1
+
+#define LV_FONT_MONTSERRAT_14       1
+#define LV_FONT_MONTSERRAT_24       1
+#define LV_FONT_MONTSERRAT_32       1
+#define LV_FONT_FMT_TXT_LARGE       1
+#define LV_USE_FONT_COMPRESSED      1
+#define LV_USE_FONT_PLACEHOLDER     0
+
+#define LV_USE_QRCODE               1
+
+#endif /*LV_CONF_H*/
@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* The parts of components/bsp/include/bsp_board.h used by the app tests, which are built without the BSP and LVGL */
+
+#pragma once
+
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#define BSP_IR_TX_GPIO          (GPIO_NUM_39)
+#define BSP_IR_CTRL_GPIO        (GPIO_NUM_44)
+
+typedef esp_err_t (*bsp_bottom_get_humiture)(float *temperature, float *humidity);
+
+typedef struct {
+    bsp_bottom_get_humiture get_humiture;
+} bsp_bottom_property_t;
+
+bsp_bottom_property_t *bsp_board_get_sensor_handle(void);
@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * The parts of LVGL v8.3 used by main/gui/ui_bind.c, for ui_bind_test, with the implementation in fake_lvgl.c.
+ * Labels and images count their writes and the pixels those invalidate: LVGL invalidates the whole object on every
+ * lv_label_set_text*() and lv_img_set_src(), the same text or source included. Objects have the size given to
+ * fake_lvgl_obj_init(), text does not resize them.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LV_DISP_DEF_REFR_PERIOD     30
+#define lv_snprintf                 snprintf
+
+typedef int16_t lv_coord_t;
+
+typedef enum {
+    LV_EVENT_ALL = 0,
+    LV_EVENT_DELETE = 36,
+} lv_event_code_t;
+
+struct _lv_event_t;
+typedef void (*lv_event_cb_t)(struct _lv_event_t *e);
+
+#define FAKE_LVGL_EVENT_CB_MAX      4
+
+typedef struct _lv_obj_t {
+    lv_coord_t w;
+    lv_coord_t h;
+    char text[64];
+    const void *src;
+    uint32_t writes;
+    uint32_t px;
+    struct {
+        lv_event_cb_t cb;
+        void *user_data;
+    } event_cbs[FAKE_LVGL_EVENT_CB_MAX];
+} lv_obj_t;
+
+typedef struct _lv_event_t {
+    lv_obj_t *target;
+    lv_event_code_t code;
+    void *user_data;
+} lv_event_t;
+
+typedef struct _lv_timer_t lv_timer_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t *timer);
+
+struct _lv_timer_t {
+    uint32_t period;
+    uint32_t last_run;
+    lv_timer_cb_t timer_cb;
+    void *user_data;
+};
+
+const char *lv_label_get_text(const lv_obj_t *obj);
+void lv_label_set_text(lv_obj_t *obj, const char *text);
+void lv_label_set_text_static(lv_obj_t *obj, const char *text);
+void lv_label_set_text_fmt(lv_obj_t *obj, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void lv_img_set_src(lv_obj_t *obj, const void *src);
+
+void *lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data);
+uint32_t lv_obj_remove_event_cb_with_user_data(lv_obj_t *obj, lv_event_cb_t event_cb, const void *user_data);
+void *lv_event_get_user_data(lv_event_t *e);
+void lv_obj_del(lv_obj_t *obj);
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void *user_data);
+
+/* Not in LVGL */
+void fake_lvgl_obj_init(lv_obj_t *obj, lv_coord_t w, lv_coord_t h);
+/* Moves the virtual clock on millisecond by millisecond, running the timers as they come due */
+void fake_lvgl_run(uint32_t ms);
@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* The app_* modules the GUI talks to, reduced to the state it reads back */
+
+#include <math.h>
+#include <string.h>
+#include "app_fan.h"
+#include "app_ir_store.h"
+#include "app_ir_tx.h"
+#include "app_led.h"
+#include "app_rmaker.h"
+#include "app_switch.h"
+#include "app_telemetry.h"
+#include "app_wifi.h"
+#include "settings.h"
+#include "host_stub.h"
+
+static bool s_led_on;
+static bool s_fan_on;
+static bool s_switch_on;
+
+sys_param_t *settings_get_parameter(void)
+{
+    static sys_param_t param = {
+        .need_hint = false,
+        .sr_lang = SR_LANG_EN,
+        .volume = 60,
+        .radar_en = true,
+    };
+    return &param;
+}
+
+esp_err_t settings_write_parameter_to_nvs(void)
+{
+    return ESP_OK;
+}
+
+char *app_wifi_get_prov_payload(void)
+{
+    static char payload[] = "{\"ver\":\"v1\",\"name\":\"PROV_BOX3\",\"pop\":\"abcd1234\",\"transport\":\"ble\"}";
+    return payload;
+}
+
+bool app_wifi_is_connected(void)
+{
+    return false;
+}
+
+esp_err_t app_wifi_get_wifi_ssid(char *ssid, size_t len)
+{
+    strncpy(ssid, "host", len);
+    return ESP_OK;
+}
+
+esp_err_t app_wifi_prov_start(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t app_wifi_prov_stop(void)
+{
+    return ESP_OK;
+}
+
+bool app_rmaker_is_connected(void)
+{
+    return false;
+}
+
+esp_err_t app_pwm_led_set_power(bool power)
+{
+    s_led_on = power;
+    return ESP_OK;
+}
+
+bool app_pwm_led_get_state(void)
+{
+    return s_led_on;
+}
+
+esp_err_t app_fan_set_power(bool power)
+{
+    s_fan_on = power;
+    return ESP_OK;
+}
+
+bool app_fan_get_state(void)
+{
+    return s_fan_on;
+}
+
+esp_err_t app_switch_set_power(bool power)
+{
+    s_switch_on = power;
+    return ESP_OK;
+}
+
+bool app_switch_get_state(void)
+{
+    return s_switch_on;
+}
+
+esp_err_t app_telemetry_query(app_telemetry_channel_t channel, uint32_t range_s, app_telemetry_point_t *points, size_t num)
+{
+    /* Same curve whatever the range, in the units of the real store */
+    for (size_t i = 0; i < num; i++) {
+        float x = (float) i / num * 6.2832f;
+        int16_t v = APP_TELEMETRY_TEMPERATURE == channel ? 2400 + 200 * sinf(x) : 4500 + 500 * cosf(x);
+        points[i] = (app_telemetry_point_t) {
+            .min = v - 50,
+            .max = v + 50,
+            .avg = v,
+            .count = 1,
+        };
+    }
+    return ESP_OK;
+}
+
+/* No infrared on host, nothing is ever learned or stored */
+
+esp_err_t app_ir_store_init(const char *base_path)
+{
+    return ESP_OK;
+}
+
+esp_err_t app_ir_store_save(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t app_ir_store_load(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+bool app_ir_store_exists(const char *device, const char *key)
+{
+    return false;
+}
+
+esp_err_t app_ir_store_remove(const char *device, const char *key)
+{
+    return ESP_OK;
+}
+
+esp_err_t app_ir_store_import_legacy(const char *path, const char *device, const char *key)
+{
+    return ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t app_ir_tx_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t app_ir_tx_cmd_create(struct ir_learn_sub_list_head *cmd_list, app_ir_tx_cmd_handle_t *ret_cmd)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void app_ir_tx_cmd_delete(app_ir_tx_cmd_handle_t cmd)
+{
+}
+
+esp_err_t app_ir_tx_send(app_ir_tx_cmd_handle_t cmd, app_ir_tx_done_cb_t cb, void *user_data)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <math.h>
+#include "bsp_board.h"
+#include "host_stub.h"
+
+typedef struct {
+    button_cb_t cb;
+    void *user_data;
+} btn_cb_t;
+
+static btn_cb_t s_btn_cb[BSP_BUTTON_NUM][BUTTON_EVENT_MAX];
+static bool s_radar_en;
+
+bool bsp_display_lock(uint32_t timeout_ms)
+{
+    /* The bench calls into LVGL from the only thread there is */
+    return true;
+}
+
+void bsp_display_unlock(void)
+{
+}
+
+esp_err_t bsp_btn_register_callback(bsp_button_t btn, button_event_t event, button_cb_t callback, void *user_data)
+{
+    if (btn >= BSP_BUTTON_NUM || event >= BUTTON_EVENT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_btn_cb[btn][event] = (btn_cb_t) {
+        .cb = callback,
+        .user_data = user_data,
+    };
+    return ESP_OK;
+}
+
+esp_err_t bsp_btn_rm_all_callback(bsp_button_t btn)
+{
+    if (btn >= BSP_BUTTON_NUM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < BUTTON_EVENT_MAX; i++) {
+        s_btn_cb[btn][i] = (btn_cb_t) { 0 };
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_btn_rm_event_callback(bsp_button_t btn, size_t event)
+{
+    if (btn >= BSP_BUTTON_NUM || event >= BUTTON_EVENT_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_btn_cb[btn][event] = (btn_cb_t) { 0 };
+    return ESP_OK;
+}
+
+void host_stub_button_event(bsp_button_t btn, button_event_t event)
+{
+    btn_cb_t cb = s_btn_cb[btn][event];
+    if (cb.cb) {
+        cb.cb(NULL, cb.user_data);
+    }
+}
+
+esp_err_t bsp_codec_volume_set(int volume, int *volume_set)
+{
+    if (volume_set) {
+        *volume_set = volume;
+    }
+    return ESP_OK;
+}
+
+esp_err_t bsp_codec_set_fs(uint32_t rate, uint32_t bits_cfg, i2s_slot_mode_t ch)
+{
+    return ESP_OK;
+}
+
+static bool get_sleep_mode(void)
+{
+    return false;
+}
+
+static bottom_id_t get_bottom_id(void)
+{
+    return BOTTOM_ID_SENSOR;
+}
+
+static void set_radar_enable(bool enable)
+{
+    s_radar_en = enable;
+}
+
+static bool get_radar_status(void)
+{
+    return s_radar_en;
+}
+
+static esp_err_t get_humiture(float *temperature, float *humidity)
+{
+    /* Slow drift over virtual time, so the labels change at a known rate */
+    float t = host_stub_now_ms() / 1000.0f;
+    *temperature = 24.0f + 2.0f * sinf(t / 20.0f);
+    *humidity = 45.0f + 5.0f * cosf(t / 30.0f);
+    return ESP_OK;
+}
+
+static void register_presence_cb(bsp_presence_cb_t cb, void *user_data)
+{
+}
+
+static void get_presence_stats(bsp_presence_stats_t *stats)
+{
+    *stats = (bsp_presence_stats_t) { 0 };
+}
+
+bsp_bottom_property_t *bsp_board_get_sensor_handle(void)
+{
+    static bsp_bottom_property_t handle = {
+        .get_sleep_mode = get_sleep_mode,
+        .get_bottom_id = get_bottom_id,
+        .set_radar_enable = set_radar_enable,
+        .get_radar_status = get_radar_status,
+        .get_humiture = get_humiture,
+        .register_presence_cb = register_presence_cb,
+        .get_presence_stats = get_presence_stats,
+    };
+    return &handle;
+}
+
+const boards_info_t *bsp_board_get_info(void)
+{
+    static const boards_info_t info = {
+        .name = "S3_BOX_3",
+    };
+    return &info;
+}
@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdarg.h>
+#include <string.h>
+#include "lvgl.h"
+
+#define TIMER_MAX       8
+
+static lv_timer_t s_timers[TIMER_MAX];
+static size_t s_timer_count;
+static uint32_t s_now_ms;
+
+static void invalidate(lv_obj_t *obj)
+{
+    obj->writes++;
+    obj->px += (uint32_t) obj->w * obj->h;
+}
+
+void fake_lvgl_obj_init(lv_obj_t *obj, lv_coord_t w, lv_coord_t h)
+{
+    *obj = (lv_obj_t) {
+        .w = w,
+        .h = h,
+    };
+}
+
+const char *lv_label_get_text(const lv_obj_t *obj)
+{
+    return obj->text;
+}
+
+void lv_label_set_text(lv_obj_t *obj, const char *text)
+{
+    snprintf(obj->text, sizeof(obj->text), "%s", text);
+    invalidate(obj);
+}
+
+void lv_label_set_text_static(lv_obj_t *obj, const char *text)
+{
+    lv_label_set_text(obj, text);
+}
+
+void lv_label_set_text_fmt(lv_obj_t *obj, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(obj->text, sizeof(obj->text), fmt, args);
+    va_end(args);
+    invalidate(obj);
+}
+
+void lv_img_set_src(lv_obj_t *obj, const void *src)
+{
+    obj->src = src;
+    invalidate(obj);
+}
+
+void *lv_obj_add_event_cb(lv_obj_t *obj, lv_event_cb_t event_cb, lv_event_code_t filter, void *user_data)
+{
+    for (size_t i = 0; i < FAKE_LVGL_EVENT_CB_MAX; i++) {
+        if (NULL == obj->event_cbs[i].cb) {
+            obj->event_cbs[i].cb = event_cb;
+            obj->event_cbs[i].user_data = user_data;
+            return &obj->event_cbs[i];
+        }
+    }
+    return NULL;
+}
+
+uint32_t lv_obj_remove_event_cb_with_user_data(lv_obj_t *obj, lv_event_cb_t event_cb, const void *user_data)
+{
+    uint32_t removed = 0;
+    for (size_t i = 0; i < FAKE_LVGL_EVENT_CB_MAX; i++) {
+        if (event_cb == obj->event_cbs[i].cb && user_data == obj->event_cbs[i].user_data) {
+            obj->event_cbs[i].cb = NULL;
+            removed++;
+        }
+    }
+    return removed;
+}
+
+void *lv_event_get_user_data(lv_event_t *e)
+{
+    return e->user_data;
+}
+
+/* Every callback is taken as one for LV_EVENT_DELETE */
+void lv_obj_del(lv_obj_t *obj)
+{
+    for (size_t i = 0; i < FAKE_LVGL_EVENT_CB_MAX; i++) {
+        if (obj->event_cbs[i].cb) {
+            lv_event_t e = {
+                .target = obj,
+                .code = LV_EVENT_DELETE,
+                .user_data = obj->event_cbs[i].user_data,
+            };
+            obj->event_cbs[i].cb(&e);
+        }
+    }
+    memset(obj, 0, sizeof(*obj));
+}
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t timer_xcb, uint32_t period, void *user_data)
+{
+    if (s_timer_count >= TIMER_MAX) {
+        return NULL;
+    }
+    lv_timer_t *timer = &s_timers[s_timer_count++];
+    *timer = (lv_timer_t) {
+        .period = period,
+        .last_run = s_now_ms,
+        .timer_cb = timer_xcb,
+        .user_data = user_data,
+    };
+    return timer;
+}
+
+void fake_lvgl_run(uint32_t ms)
+{
+    uint32_t end = s_now_ms + ms;
+    while (s_now_ms < end) {
+        s_now_ms++;
+        for (size_t i = 0; i < s_timer_count; i++) {
+            if (s_now_ms - s_timers[i].last_run >= s_timers[i].period) {
+                s_timers[i].last_run = s_now_ms;
+                s_timers[i].timer_cb(&s_timers[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* One data partition in RAM with the rules of NOR flash: erase sets whole sectors to 0xFF, writes only clear bits */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_partition.h"
+#include "fake_partition.h"
+
+static esp_partition_t s_partition;
+static uint8_t *s_data;
+static uint32_t *s_erases;
+static uint32_t s_bad_writes;
+
+void fake_partition_create(const char *label, size_t size)
+{
+    free(s_data);
+    free(s_erases);
+    s_data = malloc(size);
+    s_erases = calloc(size / FAKE_PARTITION_SECTOR_SIZE, sizeof(uint32_t));
+    memset(s_data, 0xFF, size);
+    s_bad_writes = 0;
+    s_partition = (esp_partition_t) {
+        .type = ESP_PARTITION_TYPE_DATA, .subtype = ESP_PARTITION_SUBTYPE_ANY, .size = size,
+    };
+    strncpy(s_partition.label, label, sizeof(s_partition.label) - 1);
+}
+
+uint8_t *fake_partition_data(void)
+{
+    return s_data;
+}
+
+uint32_t fake_partition_erase_count(size_t offset)
+{
+    return s_erases[offset / FAKE_PARTITION_SECTOR_SIZE];
+}
+
+uint32_t fake_partition_bad_writes(void)
+{
+    return s_bad_writes;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    if (!s_data || type != s_partition.type || (label && strcmp(label, s_partition.label))) {
+        return NULL;
+    }
+    return &s_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    if (src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, s_data + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    const uint8_t *bytes = src;
+    bool bad = false;
+
+    if (dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (size_t i = 0; i < size; i++) {
+        bad |= (bytes[i] & ~s_data[dst_offset + i]) != 0;
+        s_data[dst_offset + i] &= bytes[i];
+    }
+    s_bad_writes += bad;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (offset % FAKE_PARTITION_SECTOR_SIZE || size % FAKE_PARTITION_SECTOR_SIZE || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(s_data + offset, 0xFF, size);
+    for (size_t s = offset; s < offset + size; s += FAKE_PARTITION_SECTOR_SIZE) {
+        s_erases[s / FAKE_PARTITION_SECTOR_SIZE]++;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size,
+                             esp_partition_mmap_memory_t memory, const void **out_ptr,
+                             esp_partition_mmap_handle_t *out_handle)
+{
+    if (offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out_ptr = s_data + offset;
+    *out_handle = 0;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+}
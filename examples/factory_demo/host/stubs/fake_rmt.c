@@ -0,0 +1,213 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * Fake RMT TX channel and IR encoder. Transactions wait in a queue of the configured depth and their symbols are
+ * only read when fake_rmt_complete() plays them, like the hardware reading the buffer while it transmits.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "driver/gpio.h"
+#include "driver/rmt_tx.h"
+#include "ir_encoder.h"
+#include "fake_rmt.h"
+
+#define FAKE_RMT_QUEUE_MAX  16
+
+typedef struct {
+    const rmt_symbol_word_t *symbols;
+    size_t num_symbols;
+} fake_rmt_trans_t;
+
+struct rmt_channel_t {
+    size_t depth;
+    bool enabled;
+    rmt_tx_done_callback_t on_trans_done;
+    void *user_ctx;
+    fake_rmt_trans_t queue[FAKE_RMT_QUEUE_MAX];
+    size_t head;
+    size_t count;
+};
+
+static struct rmt_channel_t *s_channel;
+static bool s_fail_next;
+static fake_rmt_output_t s_output;
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    return ESP_OK;
+}
+
+esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t *config, rmt_channel_handle_t *ret_chan)
+{
+    if (s_channel || config->trans_queue_depth > FAKE_RMT_QUEUE_MAX) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_channel = calloc(1, sizeof(struct rmt_channel_t));
+    if (!s_channel) {
+        return ESP_ERR_NO_MEM;
+    }
+    s_channel->depth = config->trans_queue_depth;
+    *ret_chan = s_channel;
+    return ESP_OK;
+}
+
+esp_err_t rmt_del_channel(rmt_channel_handle_t channel)
+{
+    free(channel);
+    s_channel = NULL;
+    return ESP_OK;
+}
+
+esp_err_t rmt_apply_carrier(rmt_channel_handle_t channel, const rmt_carrier_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t rmt_tx_register_event_callbacks(rmt_channel_handle_t tx_channel, const rmt_tx_event_callbacks_t *cbs,
+                                          void *user_data)
+{
+    tx_channel->on_trans_done = cbs->on_trans_done;
+    tx_channel->user_ctx = user_data;
+    return ESP_OK;
+}
+
+esp_err_t rmt_enable(rmt_channel_handle_t channel)
+{
+    channel->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t rmt_disable(rmt_channel_handle_t channel)
+{
+    channel->enabled = false;
+    return ESP_OK;
+}
+
+static esp_err_t fake_encoder_del(rmt_encoder_handle_t encoder)
+{
+    free(encoder);
+    return ESP_OK;
+}
+
+esp_err_t ir_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder)
+{
+    rmt_encoder_handle_t encoder = calloc(1, sizeof(struct rmt_encoder_t));
+    if (!encoder) {
+        return ESP_ERR_NO_MEM;
+    }
+    encoder->del = fake_encoder_del;
+    *ret_encoder = encoder;
+    return ESP_OK;
+}
+
+esp_err_t rmt_transmit(rmt_channel_handle_t tx_channel, rmt_encoder_handle_t encoder, const void *payload,
+                       size_t payload_bytes, const rmt_transmit_config_t *config)
+{
+    if (!tx_channel->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_fail_next) {
+        s_fail_next = false;
+        return ESP_FAIL;
+    }
+    /* The driver would block here, nothing could free a slot meanwhile on one thread */
+    if (tx_channel->count == tx_channel->depth) {
+        return ESP_ERR_TIMEOUT;
+    }
+    size_t tail = (tx_channel->head + tx_channel->count) % FAKE_RMT_QUEUE_MAX;
+    /* The IR encoder takes the payload size as a symbol count */
+    tx_channel->queue[tail] = (fake_rmt_trans_t) {
+        .symbols = payload, .num_symbols = payload_bytes
+    };
+    tx_channel->count++;
+    return ESP_OK;
+}
+
+static void fake_rmt_emit(uint32_t level, uint32_t duration)
+{
+    fake_rmt_run_t *last = s_output.runs ? &s_output.air[s_output.runs - 1] : NULL;
+    if (last && last->level == level) {
+        last->duration += duration;
+    } else if (s_output.runs < FAKE_RMT_AIR_MAX) {
+        s_output.air[s_output.runs++] = (fake_rmt_run_t) {
+            .level = level, .duration = duration
+        };
+    }
+}
+
+static void fake_rmt_play(const fake_rmt_trans_t *trans)
+{
+    for (size_t i = 0; i < trans->num_symbols; i++) {
+        rmt_symbol_word_t symbol = trans->symbols[i];
+        /* A zero duration is the end marker, the hardware stops there */
+        if (!symbol.duration0) {
+            s_output.zero_duration = true;
+            break;
+        }
+        fake_rmt_emit(symbol.level0, symbol.duration0);
+        if (!symbol.duration1) {
+            s_output.zero_duration |= (i + 1 < trans->num_symbols);
+            break;
+        }
+        fake_rmt_emit(symbol.level1, symbol.duration1);
+    }
+    s_output.transactions++;
+}
+
+size_t fake_rmt_complete(size_t count)
+{
+    size_t played = 0;
+
+    while (s_channel && s_channel->count && played < count) {
+        fake_rmt_trans_t trans = s_channel->queue[s_channel->head];
+        s_channel->head = (s_channel->head + 1) % FAKE_RMT_QUEUE_MAX;
+        s_channel->count--;
+        fake_rmt_play(&trans);
+        played++;
+
+        if (s_channel->on_trans_done) {
+            rmt_tx_done_event_data_t edata = {
+                .num_symbols = trans.num_symbols,
+            };
+            s_channel->on_trans_done(s_channel, &edata, s_channel->user_ctx);
+        }
+    }
+    return played;
+}
+
+size_t fake_rmt_queued(void)
+{
+    return s_channel ? s_channel->count : 0;
+}
+
+esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t tx_channel, int timeout_ms)
+{
+    fake_rmt_complete(SIZE_MAX);
+    return ESP_OK;
+}
+
+void fake_rmt_fail_next(void)
+{
+    s_fail_next = true;
+}
+
+const fake_rmt_output_t *fake_rmt_output(void)
+{
+    return &s_output;
+}
+
+void fake_rmt_clear_output(void)
+{
+    memset(&s_output, 0, sizeof(s_output));
+}
@@ -0,0 +1,43 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in for chmorgan/esp-audio-player, nothing is decoded, events come from the bench */
+
+#pragma once
+
+#include <stdio.h>
+#include "esp_err.h"
+
+typedef enum {
+    AUDIO_PLAYER_STATE_IDLE,
+    AUDIO_PLAYER_STATE_PLAYING,
+    AUDIO_PLAYER_STATE_PAUSE,
+    AUDIO_PLAYER_STATE_SHUTDOWN,
+} audio_player_state_t;
+
+typedef enum {
+    AUDIO_PLAYER_CALLBACK_EVENT_IDLE,
+    AUDIO_PLAYER_CALLBACK_EVENT_COMPLETED_PLAYING_NEXT,
+    AUDIO_PLAYER_CALLBACK_EVENT_PLAYING,
+    AUDIO_PLAYER_CALLBACK_EVENT_PAUSE,
+    AUDIO_PLAYER_CALLBACK_EVENT_SHUTDOWN,
+    AUDIO_PLAYER_CALLBACK_EVENT_UNKNOWN_FILE_TYPE,
+    AUDIO_PLAYER_CALLBACK_EVENT_UNKNOWN,
+} audio_player_callback_event_t;
+
+typedef struct {
+    audio_player_callback_event_t audio_event;
+    void *user_ctx;
+} audio_player_cb_ctx_t;
+
+typedef void (*audio_player_cb_t)(audio_player_cb_ctx_t *ctx);
+
+esp_err_t audio_player_callback_register(audio_player_cb_t call_back, void *user_ctx);
+audio_player_state_t audio_player_get_state(void);
+esp_err_t audio_player_play(FILE *fp);
+esp_err_t audio_player_pause(void);
+esp_err_t audio_player_resume(void);
+esp_err_t audio_player_stop(void);
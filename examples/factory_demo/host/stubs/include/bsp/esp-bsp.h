@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in for the ESP32-S3-BOX-3 BSP, see bsp_stub.h for the hooks the bench drives it with */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "iot_button.h"
+#include "lvgl.h"
+
+#define BSP_LCD_H_RES           (320)
+#define BSP_LCD_V_RES           (240)
+#define BSP_SPIFFS_MOUNT_POINT  "/spiffs"
+
+typedef enum {
+    BSP_BUTTON_CONFIG = 0,
+    BSP_BUTTON_MUTE,
+    BSP_BUTTON_MAIN,
+    BSP_BUTTON_NUM,
+} bsp_button_t;
+
+bool bsp_display_lock(uint32_t timeout_ms);
+void bsp_display_unlock(void);
@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+typedef enum {
+    WAKENET_NO_DETECT = 0,
+    WAKENET_CHANNEL_VERIFIED = -1,
+    WAKENET_DETECTED = 1,
+} wakenet_state_t;
@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+typedef enum {
+    ESP_MN_STATE_DETECTING = 0,
+    ESP_MN_STATE_DETECTED = 1,
+    ESP_MN_STATE_TIMEOUT = 2,
+} esp_mn_state_t;
@@ -0,0 +1,42 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Hooks of the RAM flash partition in fake_partition.c */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FAKE_PARTITION_SECTOR_SIZE  4096
+
+/**
+ * @brief Create the one data partition, erased, replacing any previous one
+ */
+void fake_partition_create(const char *label, size_t size);
+
+/**
+ * @brief Contents of the partition, for the test to inspect or corrupt
+ */
+uint8_t *fake_partition_data(void);
+
+/**
+ * @brief Times the sector at `offset` was erased
+ */
+uint32_t fake_partition_erase_count(size_t offset);
+
+/**
+ * @brief Writes that tried to turn a 0 bit back into 1, which NOR flash cannot do without an erase
+ */
+uint32_t fake_partition_bad_writes(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* The RMT TX hardware of fake_rmt.c, driven by a test */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/rmt_types.h"
+
+#define FAKE_RMT_AIR_MAX    4096
+
+/**
+ * @brief Output of the channel as runs of one level, merged across symbols and transactions
+ */
+typedef struct {
+    uint8_t level;
+    uint32_t duration;
+} fake_rmt_run_t;
+
+typedef struct {
+    size_t transactions;            /*!< Transactions played */
+    size_t runs;                    /*!< Entries of `air` */
+    fake_rmt_run_t air[FAKE_RMT_AIR_MAX];
+    bool zero_duration;             /*!< A symbol half with duration 0 ended a transaction early */
+} fake_rmt_output_t;
+
+/**
+ * @brief Play the `count` oldest queued transactions and run the done callback for each
+ *
+ * @return Number of transactions played
+ */
+size_t fake_rmt_complete(size_t count);
+
+/**
+ * @brief Transactions queued and not played yet
+ */
+size_t fake_rmt_queued(void);
+
+/**
+ * @brief Make the next rmt_transmit() fail
+ */
+void fake_rmt_fail_next(void);
+
+/**
+ * @brief Output so far, cleared by fake_rmt_clear_output()
+ */
+const fake_rmt_output_t *fake_rmt_output(void);
+void fake_rmt_clear_output(void);
@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in for chmorgan/esp-file-iterator over a fixed list of names */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef struct file_iterator_instance_t file_iterator_instance_t;
+
+size_t file_iterator_get_count(file_iterator_instance_t *i);
+size_t file_iterator_get_index(file_iterator_instance_t *i);
+void file_iterator_set_index(file_iterator_instance_t *i, size_t index);
+const char *file_iterator_get_name_from_index(file_iterator_instance_t *i, size_t index);
+int file_iterator_get_full_path_from_index(file_iterator_instance_t *i, size_t index, char *path, size_t len);
+int file_iterator_next(file_iterator_instance_t *i);
+int file_iterator_prev(file_iterator_instance_t *i);
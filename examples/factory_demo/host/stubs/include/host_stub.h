@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Hooks the bench uses to play the part of the hardware and of the tasks that are not built on host */
+
+#pragma once
+
+#include <stdint.h>
+#include "bsp/esp-bsp.h"
+#include "audio_player.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Run the callbacks registered for a button event, as the button driver task would
+ */
+void host_stub_button_event(bsp_button_t btn, button_event_t event);
+
+/**
+ * @brief Report a player state change to the registered audio player callback
+ */
+void host_stub_audio_event(audio_player_callback_event_t event);
+
+/**
+ * @brief Virtual milliseconds since start, the telemetry and time() stand-ins follow it
+ */
+uint32_t host_stub_now_ms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in, the fake encoder passes the symbols through as they are */
+
+#pragma once
+
+#include <stdint.h>
+#include "driver/rmt_tx.h"
+
+typedef struct {
+    uint32_t resolution;
+} ir_encoder_config_t;
+
+esp_err_t ir_encoder_new(const ir_encoder_config_t *config, rmt_encoder_handle_t *ret_encoder);
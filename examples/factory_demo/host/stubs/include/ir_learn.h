@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Host stand-in for espressif/ir_learn, lists work, learning itself never reports progress */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/queue.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+#include "driver/rmt_types.h"
+
+typedef enum {
+    IR_LEARN_STATE_STEP,
+    IR_LEARN_STATE_READY = 20,
+    IR_LEARN_STATE_END,
+    IR_LEARN_STATE_FAIL,
+    IR_LEARN_STATE_EXIT,
+} ir_learn_state_t;
+
+typedef struct ir_learn_sub_list_t {
+    uint32_t timediff;
+    rmt_rx_done_event_data_t symbols;
+    SLIST_ENTRY(ir_learn_sub_list_t) next;
+} ir_learn_sub_list_t;
+
+SLIST_HEAD(ir_learn_sub_list_head, ir_learn_sub_list_t);
+
+typedef struct ir_learn_list_t {
+    struct ir_learn_sub_list_head cmd_sub_node;
+    SLIST_ENTRY(ir_learn_list_t) next;
+} ir_learn_list_t;
+
+SLIST_HEAD(ir_learn_list_head, ir_learn_list_t);
+
+typedef void (*ir_learn_result_cb)(ir_learn_state_t state, uint8_t sub_step, struct ir_learn_sub_list_head *data);
+
+typedef struct {
+    rmt_clock_source_t clk_src;
+    uint32_t resolution;
+    uint32_t learn_count;
+    gpio_num_t learn_gpio;
+    ir_learn_result_cb callback;
+    int task_priority;
+    uint32_t task_stack;
+    int task_affinity;
+} ir_learn_cfg_t;
+
+typedef struct ir_learn_t *ir_learn_handle_t;
+
+esp_err_t ir_learn_new(const ir_learn_cfg_t *cfg, ir_learn_handle_t *handle_out);
+esp_err_t ir_learn_restart(ir_learn_handle_t handle);
+esp_err_t ir_learn_stop(ir_learn_handle_t *handle);
+esp_err_t ir_learn_add_list_node(struct ir_learn_list_head *learn_head);
+esp_err_t ir_learn_add_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff,
+                                     const rmt_rx_done_event_data_t *symbol);
+esp_err_t ir_learn_check_valid(struct ir_learn_list_head *learn_head, struct ir_learn_sub_list_head *result_out);
+void ir_learn_clean_data(struct ir_learn_list_head *learn_head);
+void ir_learn_clean_sub_data(struct ir_learn_sub_list_head *sub_head);
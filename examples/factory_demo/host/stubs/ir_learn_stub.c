@@ -0,0 +1,99 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ir_learn.h"
+
+esp_err_t ir_learn_new(const ir_learn_cfg_t *cfg, ir_learn_handle_t *handle_out)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ir_learn_restart(ir_learn_handle_t handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t ir_learn_stop(ir_learn_handle_t *handle)
+{
+    *handle = NULL;
+    return ESP_OK;
+}
+
+esp_err_t ir_learn_add_list_node(struct ir_learn_list_head *learn_head)
+{
+    ir_learn_list_t *node = calloc(1, sizeof(ir_learn_list_t));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    SLIST_INIT(&node->cmd_sub_node);
+
+    /* Appended, like the component does */
+    ir_learn_list_t *last = SLIST_FIRST(learn_head);
+    if (!last) {
+        SLIST_INSERT_HEAD(learn_head, node, next);
+    } else {
+        while (SLIST_NEXT(last, next)) {
+            last = SLIST_NEXT(last, next);
+        }
+        SLIST_INSERT_AFTER(last, node, next);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ir_learn_add_sub_list_node(struct ir_learn_sub_list_head *sub_head, uint32_t timediff,
+                                     const rmt_rx_done_event_data_t *symbol)
+{
+    ir_learn_sub_list_t *node = calloc(1, sizeof(ir_learn_sub_list_t));
+    if (!node) {
+        return ESP_ERR_NO_MEM;
+    }
+    node->timediff = timediff;
+    node->symbols.num_symbols = symbol->num_symbols;
+    node->symbols.received_symbols = malloc(symbol->num_symbols * sizeof(rmt_symbol_word_t));
+    if (!node->symbols.received_symbols) {
+        free(node);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(node->symbols.received_symbols, symbol->received_symbols, symbol->num_symbols * sizeof(rmt_symbol_word_t));
+
+    ir_learn_sub_list_t *last = SLIST_FIRST(sub_head);
+    if (!last) {
+        SLIST_INSERT_HEAD(sub_head, node, next);
+    } else {
+        while (SLIST_NEXT(last, next)) {
+            last = SLIST_NEXT(last, next);
+        }
+        SLIST_INSERT_AFTER(last, node, next);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ir_learn_check_valid(struct ir_learn_list_head *learn_head, struct ir_learn_sub_list_head *result_out)
+{
+    return ESP_FAIL;
+}
+
+void ir_learn_clean_sub_data(struct ir_learn_sub_list_head *sub_head)
+{
+    while (!SLIST_EMPTY(sub_head)) {
+        ir_learn_sub_list_t *node = SLIST_FIRST(sub_head);
+        SLIST_REMOVE_HEAD(sub_head, next);
+        free(node->symbols.received_symbols);
+        free(node);
+    }
+}
+
+void ir_learn_clean_data(struct ir_learn_list_head *learn_head)
+{
+    while (!SLIST_EMPTY(learn_head)) {
+        ir_learn_list_t *node = SLIST_FIRST(learn_head);
+        SLIST_REMOVE_HEAD(learn_head, next);
+        ir_learn_clean_sub_data(&node->cmd_sub_node);
+        free(node);
+    }
+}
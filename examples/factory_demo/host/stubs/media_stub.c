@@ -0,0 +1,143 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Audio player and file iterator over a fixed play list, nothing is read or decoded */
+
+#include <stdio.h>
+#include "audio_player.h"
+#include "file_iterator.h"
+#include "host_stub.h"
+
+static const char *const s_files[] = {
+    "Canon in D.mp3",
+    "For Elise.mp3",
+    "Something.mp3",
+};
+
+#define FILE_COUNT  (sizeof(s_files) / sizeof(s_files[0]))
+
+struct file_iterator_instance_t {
+    size_t index;
+};
+
+static file_iterator_instance_t s_iterator;
+
+/* Defined by main.c on target */
+file_iterator_instance_t *file_iterator = &s_iterator;
+
+static audio_player_cb_t s_cb;
+static void *s_cb_ctx;
+static audio_player_state_t s_state = AUDIO_PLAYER_STATE_IDLE;
+
+void host_stub_audio_event(audio_player_callback_event_t event)
+{
+    switch (event) {
+    case AUDIO_PLAYER_CALLBACK_EVENT_PLAYING:
+    case AUDIO_PLAYER_CALLBACK_EVENT_COMPLETED_PLAYING_NEXT:
+        s_state = AUDIO_PLAYER_STATE_PLAYING;
+        break;
+    case AUDIO_PLAYER_CALLBACK_EVENT_PAUSE:
+        s_state = AUDIO_PLAYER_STATE_PAUSE;
+        break;
+    case AUDIO_PLAYER_CALLBACK_EVENT_IDLE:
+        s_state = AUDIO_PLAYER_STATE_IDLE;
+        break;
+    default:
+        break;
+    }
+    if (s_cb) {
+        audio_player_cb_ctx_t ctx = {
+            .audio_event = event,
+            .user_ctx = s_cb_ctx,
+        };
+        s_cb(&ctx);
+    }
+}
+
+esp_err_t audio_player_callback_register(audio_player_cb_t call_back, void *user_ctx)
+{
+    s_cb = call_back;
+    s_cb_ctx = user_ctx;
+    return ESP_OK;
+}
+
+audio_player_state_t audio_player_get_state(void)
+{
+    return s_state;
+}
+
+esp_err_t audio_player_play(FILE *fp)
+{
+    if (fp) {
+        fclose(fp);
+    }
+    host_stub_audio_event(AUDIO_PLAYER_CALLBACK_EVENT_PLAYING);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_pause(void)
+{
+    host_stub_audio_event(AUDIO_PLAYER_CALLBACK_EVENT_PAUSE);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_resume(void)
+{
+    host_stub_audio_event(AUDIO_PLAYER_CALLBACK_EVENT_PLAYING);
+    return ESP_OK;
+}
+
+esp_err_t audio_player_stop(void)
+{
+    host_stub_audio_event(AUDIO_PLAYER_CALLBACK_EVENT_IDLE);
+    return ESP_OK;
+}
+
+size_t file_iterator_get_count(file_iterator_instance_t *i)
+{
+    return FILE_COUNT;
+}
+
+size_t file_iterator_get_index(file_iterator_instance_t *i)
+{
+    return i ? i->index : 0;
+}
+
+void file_iterator_set_index(file_iterator_instance_t *i, size_t index)
+{
+    if (i && index < FILE_COUNT) {
+        i->index = index;
+    }
+}
+
+const char *file_iterator_get_name_from_index(file_iterator_instance_t *i, size_t index)
+{
+    return index < FILE_COUNT ? s_files[index] : NULL;
+}
+
+int file_iterator_get_full_path_from_index(file_iterator_instance_t *i, size_t index, char *path, size_t len)
+{
+    if (index >= FILE_COUNT) {
+        return 0;
+    }
+    return snprintf(path, len, "/spiffs/music/%s", s_files[index]);
+}
+
+int file_iterator_next(file_iterator_instance_t *i)
+{
+    if (i) {
+        i->index = (i->index + 1) % FILE_COUNT;
+    }
+    return 0;
+}
+
+int file_iterator_prev(file_iterator_instance_t *i)
+{
+    if (i) {
+        i->index = (i->index + FILE_COUNT - 1) % FILE_COUNT;
+    }
+    return 0;
+}
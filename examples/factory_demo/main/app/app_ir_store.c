@@ -0,0 +1,911 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* The library is two files. The data file holds one record per command, appended on save. The index
+ * file is small, kept in RAM, and maps device/key to the offset, length and CRC of its record, so any
+ * command loads with a single seek. Frames of a known protocol are stored as their decoded code, other
+ * frames as quantized timings, delta coded against the previous mark or space and run-length compressed.
+ *
+ * The index is only ever replaced by a complete, synced copy, and only points at data already on flash.
+ * A power loss at any point leaves either the old or the new command, app_ir_store_init() finishes or
+ * undoes what was cut short.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_rom_crc.h"
+#include "app_ir_store.h"
+
+#define IR_STORE_INDEX_FILE     "ir_lib.idx"
+#define IR_STORE_DATA_FILE      "ir_lib.dat"
+#define IR_STORE_INDEX_NEW_FILE "ir_lib.new"  // index being written
+#define IR_STORE_TEMP_FILE      "ir_lib.tmp"  // data being compacted
+#define IR_STORE_OLD_FILE       "ir_lib.old"  // data before compaction, until the index points past it
+#define IR_STORE_MAGIC          0x58495249  // "IRIX"
+#define IR_STORE_VERSION        1
+#define IR_STORE_PATH_LEN       64
+
+#define IR_STORE_QUANTUM_US     8
+#define IR_STORE_DURATION_MAX   0x7FFF      // 15 bit duration field of an RMT symbol
+#define IR_STORE_MAX_HALVES     1024
+#define IR_STORE_MAX_SYMBOLS    4096        // sanity bound for legacy files
+#define IR_STORE_COMPACT_BYTES  4096        // dead data tolerated before compaction
+
+#define IR_STORE_MATCH(d, t)    ((d) >= (t) * 3 / 4 && (d) <= (t) * 5 / 4)
+
+#define NEC_LEADER_MARK_US      9000
+#define NEC_LEADER_SPACE_US     4500
+#define NEC_REPEAT_SPACE_US     2250
+#define NEC_MARK_US             560
+#define NEC_ZERO_SPACE_US       560
+#define NEC_ONE_SPACE_US        1690
+#define NEC_FRAME_HALVES        (2 + 32 * 2 + 1)
+#define NEC_REPEAT_HALVES       3
+
+#define SONY_LEADER_MARK_US     2400
+#define SONY_SPACE_US           600
+#define SONY_ZERO_MARK_US       600
+#define SONY_ONE_MARK_US        1200
+
+#define RC5_UNIT_US             889
+#define RC5_BITS                14
+
+#define IR_STORE_PROTO_MASK     0x7F
+#define IR_STORE_LEVEL_SHIFT    7
+
+static const char *TAG = "app_ir_store";
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t dead_bytes;    // bytes of the data file no longer referenced
+    uint32_t crc;           // of the entries that follow
+} ir_store_header_t;
+
+typedef struct {
+    char device[APP_IR_STORE_NAME_LEN];
+    char key[APP_IR_STORE_NAME_LEN];
+    uint32_t offset;
+    uint32_t length;
+    uint32_t crc;           // of the record
+} ir_store_entry_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+} ir_store_writer_t;
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool error;
+} ir_store_reader_t;
+
+static char base_path[IR_STORE_PATH_LEN] = {0};
+static ir_store_entry_t entries[APP_IR_STORE_MAX_KEYS];
+static uint16_t entry_count = 0;
+static uint32_t dead_bytes = 0;
+
+static void ir_store_put_u8(ir_store_writer_t *w, uint8_t value)
+{
+    if (w->buf && w->len < w->size) {
+        w->buf[w->len] = value;
+    }
+    w->len++;
+}
+
+static void ir_store_put_varint(ir_store_writer_t *w, uint32_t value)
+{
+    while (value >= 0x80) {
+        ir_store_put_u8(w, (value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    ir_store_put_u8(w, value);
+}
+
+static uint8_t ir_store_get_u8(ir_store_reader_t *r)
+{
+    if (r->pos >= r->len) {
+        r->error = true;
+        return 0;
+    }
+    return r->data[r->pos++];
+}
+
+static uint32_t ir_store_get_varint(ir_store_reader_t *r)
+{
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 35 && !r->error; shift += 7) {
+        uint8_t byte = ir_store_get_u8(r);
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    r->error = true;
+    return 0;
+}
+
+static uint32_t ir_store_zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t ir_store_unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/* Flatten symbols into alternating mark/space durations, stopping at the end marker */
+static size_t ir_store_get_halves(const rmt_symbol_word_t *symbols, size_t num, uint16_t *halves, uint8_t *first_level)
+{
+    size_t n = 0;
+    int level = -1;
+
+    for (size_t i = 0; i < num; i++) {
+        uint16_t duration[2] = {symbols[i].duration0, symbols[i].duration1};
+        uint8_t lvl[2] = {symbols[i].level0, symbols[i].level1};
+        for (int k = 0; k < 2; k++) {
+            if (!duration[k]) {
+                return n;
+            }
+            if (n && lvl[k] == level) {
+                halves[n - 1] = MIN(halves[n - 1] + duration[k], IR_STORE_DURATION_MAX);
+                continue;
+            }
+            if (!n) {
+                *first_level = lvl[k];
+            }
+            halves[n++] = duration[k];
+            level = lvl[k];
+        }
+    }
+    return n;
+}
+
+static bool ir_store_match_nec(const uint16_t *h, size_t n, uint32_t *code)
+{
+    if (n != NEC_FRAME_HALVES || !IR_STORE_MATCH(h[0], NEC_LEADER_MARK_US) || !IR_STORE_MATCH(h[1], NEC_LEADER_SPACE_US)) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (int i = 0; i < 32; i++) {
+        if (!IR_STORE_MATCH(h[2 + 2 * i], NEC_MARK_US)) {
+            return false;
+        }
+        if (IR_STORE_MATCH(h[3 + 2 * i], NEC_ONE_SPACE_US)) {
+            value |= 1UL << i;
+        } else if (!IR_STORE_MATCH(h[3 + 2 * i], NEC_ZERO_SPACE_US)) {
+            return false;
+        }
+    }
+    *code = value;
+    return IR_STORE_MATCH(h[n - 1], NEC_MARK_US);
+}
+
+static bool ir_store_match_nec_repeat(const uint16_t *h, size_t n)
+{
+    return n == NEC_REPEAT_HALVES && IR_STORE_MATCH(h[0], NEC_LEADER_MARK_US)
+           && IR_STORE_MATCH(h[1], NEC_REPEAT_SPACE_US) && IR_STORE_MATCH(h[2], NEC_MARK_US);
+}
+
+static bool ir_store_match_sony(const uint16_t *h, size_t n, uint32_t *code, uint8_t *bits)
+{
+    size_t num_bits = (n - 1) / 2;
+
+    if (!(n % 2) || (num_bits != 12 && num_bits != 15 && num_bits != 20)
+            || !IR_STORE_MATCH(h[0], SONY_LEADER_MARK_US) || !IR_STORE_MATCH(h[1], SONY_SPACE_US)) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (size_t i = 0; i < num_bits; i++) {
+        if (IR_STORE_MATCH(h[2 + 2 * i], SONY_ONE_MARK_US)) {
+            value |= 1UL << i;
+        } else if (!IR_STORE_MATCH(h[2 + 2 * i], SONY_ZERO_MARK_US)) {
+            return false;
+        }
+        if (i < num_bits - 1 && !IR_STORE_MATCH(h[3 + 2 * i], SONY_SPACE_US)) {
+            return false;
+        }
+    }
+    *code = value;
+    *bits = num_bits;
+    return true;
+}
+
+static bool ir_store_match_rc5(const uint16_t *h, size_t n, uint32_t *code)
+{
+    uint8_t units[RC5_BITS * 2];
+    size_t u = 0;
+
+    /* The first half of the leading start bit is idle and never captured */
+    units[u++] = 0;
+    for (size_t i = 0; i < n; i++) {
+        int count = IR_STORE_MATCH(h[i], RC5_UNIT_US) ? 1 : IR_STORE_MATCH(h[i], 2 * RC5_UNIT_US) ? 2 : 0;
+        if (!count || u + count > sizeof(units)) {
+            return false;
+        }
+        while (count--) {
+            units[u++] = !(i % 2);
+        }
+    }
+    /* Likewise a trailing space merges with idle */
+    if (u == sizeof(units) - 1) {
+        units[u++] = 0;
+    }
+    if (u != sizeof(units)) {
+        return false;
+    }
+
+    uint32_t value = 0;
+    for (int b = 0; b < RC5_BITS; b++) {
+        if (units[2 * b] == units[2 * b + 1]) {
+            return false;
+        }
+        value = (value << 1) | units[2 * b + 1];
+    }
+    *code = value;
+    return value & (1 << (RC5_BITS - 1));
+}
+
+static size_t ir_store_build_nec(uint32_t code, uint16_t *h)
+{
+    size_t n = 0;
+
+    h[n++] = NEC_LEADER_MARK_US;
+    h[n++] = NEC_LEADER_SPACE_US;
+    for (int i = 0; i < 32; i++) {
+        h[n++] = NEC_MARK_US;
+        h[n++] = (code & (1UL << i)) ? NEC_ONE_SPACE_US : NEC_ZERO_SPACE_US;
+    }
+    h[n++] = NEC_MARK_US;
+    return n;
+}
+
+static size_t ir_store_build_nec_repeat(uint16_t *h)
+{
+    h[0] = NEC_LEADER_MARK_US;
+    h[1] = NEC_REPEAT_SPACE_US;
+    h[2] = NEC_MARK_US;
+    return NEC_REPEAT_HALVES;
+}
+
+static size_t ir_store_build_sony(uint32_t code, uint8_t bits, uint16_t *h)
+{
+    size_t n = 0;
+
+    h[n++] = SONY_LEADER_MARK_US;
+    h[n++] = SONY_SPACE_US;
+    for (int i = 0; i < bits; i++) {
+        h[n++] = (code & (1UL << i)) ? SONY_ONE_MARK_US : SONY_ZERO_MARK_US;
+        if (i < bits - 1) {
+            h[n++] = SONY_SPACE_US;
+        }
+    }
+    return n;
+}
+
+static size_t ir_store_build_rc5(uint32_t code, uint16_t *h)
+{
+    uint8_t units[RC5_BITS * 2];
+    size_t n = 0;
+
+    for (int b = 0; b < RC5_BITS; b++) {
+        uint8_t bit = (code >> (RC5_BITS - 1 - b)) & 1;
+        units[2 * b] = !bit;
+        units[2 * b + 1] = bit;
+    }
+
+    /* Skip the idle first unit, merge equal neighbours and drop a trailing space */
+    size_t end = units[sizeof(units) - 1] ? sizeof(units) : sizeof(units) - 1;
+    for (size_t i = 1; i < end; i++) {
+        if (i > 1 && units[i] == units[i - 1]) {
+            h[n - 1] += RC5_UNIT_US;
+        } else {
+            h[n++] = RC5_UNIT_US;
+        }
+    }
+    return n;
+}
+
+static void ir_store_put_raw(ir_store_writer_t *w, const uint16_t *h, size_t n)
+{
+    uint32_t run = 0;
+
+    ir_store_put_varint(w, n);
+    for (size_t i = 0; i < n; i++) {
+        int32_t q = (h[i] + IR_STORE_QUANTUM_US / 2) / IR_STORE_QUANTUM_US;
+        int32_t prev = (i >= 2) ? (h[i - 2] + IR_STORE_QUANTUM_US / 2) / IR_STORE_QUANTUM_US : 0;
+        int32_t delta = q - prev;
+
+        /* Tokens: a literal delta has the low bit clear, a run of zero deltas has it set */
+        if (!delta) {
+            run++;
+            continue;
+        }
+        if (run) {
+            ir_store_put_varint(w, (run << 1) | 1);
+            run = 0;
+        }
+        ir_store_put_varint(w, ir_store_zigzag(delta) << 1);
+    }
+    if (run) {
+        ir_store_put_varint(w, (run << 1) | 1);
+    }
+}
+
+static size_t ir_store_get_raw(ir_store_reader_t *r, uint16_t **halves)
+{
+    size_t n = ir_store_get_varint(r);
+    if (r->error || n > IR_STORE_MAX_HALVES) {
+        r->error = true;
+        return 0;
+    }
+    if (!n) {
+        return 0;
+    }
+
+    uint16_t *q = calloc(n, sizeof(uint16_t));
+    if (!q) {
+        r->error = true;
+        return 0;
+    }
+
+    size_t i = 0;
+    while (i < n && !r->error) {
+        uint32_t token = ir_store_get_varint(r);
+        uint32_t run = (token & 1) ? (token >> 1) : 1;
+        int32_t delta = (token & 1) ? 0 : ir_store_unzigzag(token >> 1);
+        if (!run || run > n - i) {
+            r->error = true;
+            break;
+        }
+        while (run--) {
+            int32_t value = ((i >= 2) ? q[i - 2] : 0) + delta;
+            if (value < 0 || value > IR_STORE_DURATION_MAX / IR_STORE_QUANTUM_US + 1) {
+                r->error = true;
+                break;
+            }
+            q[i++] = value;
+        }
+    }
+
+    if (r->error) {
+        free(q);
+        return 0;
+    }
+
+    /* Decode in place, a zero duration would read as an end marker */
+    for (i = 0; i < n; i++) {
+        q[i] = MIN(MAX(q[i] * IR_STORE_QUANTUM_US, 1), IR_STORE_DURATION_MAX);
+    }
+    *halves = q;
+    return n;
+}
+
+static esp_err_t ir_store_add_frame(struct ir_learn_sub_list_head *cmd_list, uint32_t gap_us,
+                                    const uint16_t *h, size_t n, uint8_t first_level)
+{
+    rmt_rx_done_event_data_t symbols;
+
+    symbols.num_symbols = (n + 1) / 2;
+    symbols.received_symbols = (rmt_symbol_word_t *)heap_caps_malloc(symbols.num_symbols * sizeof(rmt_symbol_word_t), \
+                               MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(symbols.received_symbols, ESP_ERR_NO_MEM, TAG, "no mem for symbols");
+
+    for (size_t i = 0; i < symbols.num_symbols; i++) {
+        rmt_symbol_word_t *s = &symbols.received_symbols[i];
+        s->duration0 = h[2 * i];
+        s->level0 = first_level;
+        s->duration1 = (2 * i + 1 < n) ? h[2 * i + 1] : 0;
+        s->level1 = !first_level;
+    }
+    ir_learn_add_sub_list_node(cmd_list, gap_us, &symbols);
+    free(symbols.received_symbols);
+    return ESP_OK;
+}
+
+size_t app_ir_store_encode(struct ir_learn_sub_list_head *cmd_list, uint8_t *out, size_t size)
+{
+    ir_store_writer_t w = {.buf = out, .size = size, .len = 0};
+    ir_learn_sub_list_t *sub_it;
+    uint8_t frame_num = 0;
+
+    SLIST_FOREACH(sub_it, cmd_list, next) {
+        frame_num++;
+    }
+    if (!frame_num) {
+        return 0;
+    }
+    ir_store_put_u8(&w, frame_num);
+
+    SLIST_FOREACH(sub_it, cmd_list, next) {
+        size_t num_symbols = sub_it->symbols.num_symbols;
+        uint16_t *h = malloc(MAX(num_symbols, 1) * 2 * sizeof(uint16_t));
+        if (!h) {
+            return 0;
+        }
+
+        uint8_t first_level = 1;
+        uint32_t code = 0;
+        uint8_t bits = 0;
+        size_t n = ir_store_get_halves(sub_it->symbols.received_symbols, num_symbols, h, &first_level);
+        uint8_t level = first_level << IR_STORE_LEVEL_SHIFT;
+
+        ir_store_put_varint(&w, sub_it->timediff);
+        if (ir_store_match_nec(h, n, &code)) {
+            ir_store_put_u8(&w, APP_IR_PROTO_NEC | level);
+            for (int i = 0; i < 4; i++) {
+                ir_store_put_u8(&w, code >> (8 * i));
+            }
+        } else if (ir_store_match_nec_repeat(h, n)) {
+            ir_store_put_u8(&w, APP_IR_PROTO_NEC_REPEAT | level);
+        } else if (ir_store_match_sony(h, n, &code, &bits)) {
+            ir_store_put_u8(&w, APP_IR_PROTO_SONY | level);
+            ir_store_put_u8(&w, bits);
+            ir_store_put_varint(&w, code);
+        } else if (ir_store_match_rc5(h, n, &code)) {
+            ir_store_put_u8(&w, APP_IR_PROTO_RC5 | level);
+            ir_store_put_varint(&w, code);
+        } else {
+            ir_store_put_u8(&w, APP_IR_PROTO_RAW | level);
+            ir_store_put_raw(&w, h, MIN(n, IR_STORE_MAX_HALVES));
+        }
+        free(h);
+    }
+
+    return (out && w.len > size) ? 0 : w.len;
+}
+
+esp_err_t app_ir_store_decode(const uint8_t *data, size_t len, struct ir_learn_sub_list_head *cmd_list)
+{
+    esp_err_t ret = ESP_OK;
+    ir_store_reader_t r = {.data = data, .len = len, .pos = 0, .error = false};
+    uint16_t frame_halves[NEC_FRAME_HALVES];
+
+    uint8_t frame_num = ir_store_get_u8(&r);
+    for (int i = 0; i < frame_num && !r.error && ESP_OK == ret; i++) {
+        uint32_t gap_us = ir_store_get_varint(&r);
+        uint8_t type = ir_store_get_u8(&r);
+        uint8_t first_level = type >> IR_STORE_LEVEL_SHIFT;
+        uint16_t *h = frame_halves;
+        size_t n = 0;
+
+        switch (type & IR_STORE_PROTO_MASK) {
+        case APP_IR_PROTO_NEC: {
+            uint32_t code = 0;
+            for (int k = 0; k < 4; k++) {
+                code |= (uint32_t)ir_store_get_u8(&r) << (8 * k);
+            }
+            n = ir_store_build_nec(code, h);
+            break;
+        }
+        case APP_IR_PROTO_NEC_REPEAT:
+            n = ir_store_build_nec_repeat(h);
+            break;
+        case APP_IR_PROTO_SONY: {
+            uint8_t bits = ir_store_get_u8(&r);
+            uint32_t code = ir_store_get_varint(&r);
+            r.error |= (bits != 12 && bits != 15 && bits != 20);
+            n = r.error ? 0 : ir_store_build_sony(code, bits, h);
+            break;
+        }
+        case APP_IR_PROTO_RC5:
+            n = ir_store_build_rc5(ir_store_get_varint(&r), h);
+            break;
+        case APP_IR_PROTO_RAW:
+            n = ir_store_get_raw(&r, &h);
+            break;
+        default:
+            r.error = true;
+            break;
+        }
+
+        if (!r.error && n) {
+            ret = ir_store_add_frame(cmd_list, gap_us, h, n, first_level);
+        }
+        if (h != frame_halves) {
+            free(h);
+        }
+    }
+
+    ESP_RETURN_ON_FALSE(!r.error, ESP_ERR_INVALID_SIZE, TAG, "malformed record");
+    return ret;
+}
+
+static void ir_store_path(char *path, const char *file)
+{
+    snprintf(path, IR_STORE_PATH_LEN, "%s/%s", base_path, file);
+}
+
+static int ir_store_find(const char *device, const char *key)
+{
+    for (int i = 0; i < entry_count; i++) {
+        if (!strcmp(entries[i].device, device) && !strcmp(entries[i].key, key)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Written data reaches the flash before anything that relies on it */
+static bool ir_store_sync(FILE *fp)
+{
+    return 0 == fflush(fp) && 0 == fsync(fileno(fp));
+}
+
+/* SPIFFS does not rename onto an existing file. A power loss between the remove and the rename leaves only
+ * the new file, which app_ir_store_init() looks for.
+ */
+static esp_err_t ir_store_replace(const char *from, const char *to)
+{
+    if (0 != rename(from, to)) {
+        remove(to);
+        ESP_RETURN_ON_FALSE(0 == rename(from, to), ESP_FAIL, TAG, "Failed rename %s", from);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t ir_store_write_index(void)
+{
+    char path[IR_STORE_PATH_LEN];
+    char new_path[IR_STORE_PATH_LEN];
+    ir_store_header_t header = {
+        .magic = IR_STORE_MAGIC,
+        .version = IR_STORE_VERSION,
+        .count = entry_count,
+        .dead_bytes = dead_bytes,
+        .crc = esp_rom_crc32_le(0, (const uint8_t *)entries, entry_count * sizeof(ir_store_entry_t)),
+    };
+
+    ir_store_path(new_path, IR_STORE_INDEX_NEW_FILE);
+    FILE *fp = fopen(new_path, "wb");
+    ESP_RETURN_ON_FALSE(fp, ESP_FAIL, TAG, "Failed open file:%s", new_path);
+
+    bool ok = (1 == fwrite(&header, sizeof(header), 1, fp));
+    if (ok && entry_count) {
+        ok = (entry_count == fwrite(entries, sizeof(ir_store_entry_t), entry_count, fp));
+    }
+    ok = ir_store_sync(fp) && ok;
+    ok = (0 == fclose(fp)) && ok;
+    if (!ok) {
+        remove(new_path);
+        ESP_LOGE(TAG, "Failed write index");
+        return ESP_FAIL;
+    }
+
+    ir_store_path(path, IR_STORE_INDEX_FILE);
+    return ir_store_replace(new_path, path);
+}
+
+static esp_err_t ir_store_read_index(const char *path)
+{
+    ir_store_header_t header = {0};
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    bool ok = (1 == fread(&header, sizeof(header), 1, fp))
+              && header.magic == IR_STORE_MAGIC && header.version == IR_STORE_VERSION
+              && header.count <= APP_IR_STORE_MAX_KEYS;
+    if (ok && header.count) {
+        ok = (header.count == fread(entries, sizeof(ir_store_entry_t), header.count, fp))
+             && header.crc == esp_rom_crc32_le(0, (const uint8_t *)entries, header.count * sizeof(ir_store_entry_t));
+    }
+    fclose(fp);
+
+    if (!ok) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    entry_count = header.count;
+    dead_bytes = header.dead_bytes;
+    return ESP_OK;
+}
+
+/* Whether every entry of the index finds its record in the data file at `path` */
+static bool ir_store_check_data(const char *path)
+{
+    bool ok = true;
+    uint8_t *record = NULL;
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return !entry_count;
+    }
+    for (int i = 0; i < entry_count && ok; i++) {
+        record = realloc(record, entries[i].length);
+        ok = record && 0 == fseek(fp, entries[i].offset, SEEK_SET) && 1 == fread(record, entries[i].length, 1, fp)
+             && entries[i].crc == esp_rom_crc32_le(0, record, entries[i].length);
+    }
+    free(record);
+    fclose(fp);
+    return ok;
+}
+
+/* After a compaction cut short the index points into the old data file or the new one, keep that one */
+static void ir_store_recover_data(void)
+{
+    char data_path[IR_STORE_PATH_LEN];
+    char old_path[IR_STORE_PATH_LEN];
+    char temp_path[IR_STORE_PATH_LEN];
+
+    ir_store_path(data_path, IR_STORE_DATA_FILE);
+    ir_store_path(old_path, IR_STORE_OLD_FILE);
+    ir_store_path(temp_path, IR_STORE_TEMP_FILE);
+    remove(temp_path);
+
+    FILE *fp = fopen(old_path, "rb");
+    if (!fp) {
+        return;
+    }
+    fclose(fp);
+
+    if (ir_store_check_data(data_path)) {
+        ESP_LOGW(TAG, "compaction interrupted after the index, dropping the old data");
+        remove(old_path);
+    } else {
+        ESP_LOGW(TAG, "compaction interrupted before the index, restoring the old data");
+        remove(data_path);
+        rename(old_path, data_path);
+    }
+}
+
+/* Copy live records into a fresh data file so replaced commands stop taking space */
+static esp_err_t ir_store_compact(void)
+{
+    esp_err_t ret = ESP_OK;
+    char data_path[IR_STORE_PATH_LEN];
+    char temp_path[IR_STORE_PATH_LEN];
+    char old_path[IR_STORE_PATH_LEN];
+    uint32_t offsets[APP_IR_STORE_MAX_KEYS];
+    uint8_t *record = NULL;
+    FILE *src = NULL;
+    FILE *dst = NULL;
+
+    ir_store_path(data_path, IR_STORE_DATA_FILE);
+    ir_store_path(temp_path, IR_STORE_TEMP_FILE);
+    ir_store_path(old_path, IR_STORE_OLD_FILE);
+    src = fopen(data_path, "rb");
+    dst = fopen(temp_path, "wb");
+    ESP_GOTO_ON_FALSE(src && dst, ESP_FAIL, err, TAG, "Failed open data file");
+
+    uint32_t offset = 0;
+    for (int i = 0; i < entry_count; i++) {
+        record = malloc(entries[i].length);
+        ESP_GOTO_ON_FALSE(record, ESP_ERR_NO_MEM, err, TAG, "no mem for record");
+        ESP_GOTO_ON_FALSE(0 == fseek(src, entries[i].offset, SEEK_SET)
+                          && 1 == fread(record, entries[i].length, 1, src)
+                          && 1 == fwrite(record, entries[i].length, 1, dst), ESP_FAIL, err, TAG, "copy record failed");
+        free(record);
+        record = NULL;
+        offsets[i] = offset;
+        offset += entries[i].length;
+    }
+    ESP_GOTO_ON_FALSE(ir_store_sync(dst), ESP_FAIL, err, TAG, "sync data file failed");
+    fclose(src);
+    src = NULL;
+    ESP_GOTO_ON_FALSE(0 == fclose(dst), ESP_FAIL, err, TAG, "close data file failed");
+    dst = NULL;
+
+    /* The index on flash points into the old data file until it is rewritten, so that file stays until then.
+     * The caller has just written the index, any old file left over is stale.
+     */
+    remove(old_path);
+    ESP_GOTO_ON_FALSE(0 == rename(data_path, old_path), ESP_FAIL, err, TAG, "rename data file failed");
+    bool moved = (0 == rename(temp_path, data_path));
+    if (!moved) {
+        rename(old_path, data_path);
+    }
+    ESP_GOTO_ON_FALSE(moved, ESP_FAIL, err, TAG, "rename data file failed");
+    for (int i = 0; i < entry_count; i++) {
+        entries[i].offset = offsets[i];
+    }
+    dead_bytes = 0;
+    /* On failure the entries in RAM match the new data file, app_ir_store_init() sorts out the files */
+    ESP_RETURN_ON_ERROR(ir_store_write_index(), TAG, "commit compaction failed");
+    remove(old_path);
+    return ESP_OK;
+
+err:
+    free(record);
+    if (src) {
+        fclose(src);
+    }
+    if (dst) {
+        fclose(dst);
+    }
+    remove(temp_path);
+    return ret;
+}
+
+esp_err_t app_ir_store_init(const char *path)
+{
+    char index_path[IR_STORE_PATH_LEN];
+    char new_path[IR_STORE_PATH_LEN];
+
+    ESP_RETURN_ON_FALSE(path && strlen(path) < IR_STORE_PATH_LEN - sizeof(IR_STORE_INDEX_FILE) - 1,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid base path");
+    strlcpy(base_path, path, sizeof(base_path));
+    entry_count = 0;
+    dead_bytes = 0;
+
+    ir_store_path(index_path, IR_STORE_INDEX_FILE);
+    ir_store_path(new_path, IR_STORE_INDEX_NEW_FILE);
+
+    /* A complete new index was written after its data, only its rename was cut short */
+    esp_err_t ret = ir_store_read_index(new_path);
+    if (ESP_OK == ret) {
+        ESP_LOGW(TAG, "index update interrupted, finishing it");
+        ir_store_replace(new_path, index_path);
+    } else {
+        remove(new_path);
+        ret = ir_store_read_index(index_path);
+    }
+    ir_store_recover_data();
+
+    if (ESP_ERR_NOT_FOUND == ret) {
+        ESP_LOGI(TAG, "no IR library yet");
+    } else if (ESP_OK != ret) {
+        entry_count = 0;
+        dead_bytes = 0;
+        ESP_LOGW(TAG, "IR library index invalid, starting empty");
+    } else {
+        ESP_LOGI(TAG, "IR library: %d commands", entry_count);
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_ir_store_save(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list)
+{
+    esp_err_t ret = ESP_OK;
+    char path[IR_STORE_PATH_LEN];
+    uint8_t *record = NULL;
+    FILE *fp = NULL;
+
+    ESP_RETURN_ON_FALSE(device && key && strlen(device) < APP_IR_STORE_NAME_LEN && strlen(key) < APP_IR_STORE_NAME_LEN,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid name");
+
+    int index = ir_store_find(device, key);
+    ESP_RETURN_ON_FALSE(index >= 0 || entry_count < APP_IR_STORE_MAX_KEYS, ESP_ERR_NO_MEM, TAG, "IR library full");
+
+    size_t length = app_ir_store_encode(cmd_list, NULL, 0);
+    ESP_RETURN_ON_FALSE(length, ESP_ERR_INVALID_ARG, TAG, "empty command");
+    record = malloc(length);
+    ESP_RETURN_ON_FALSE(record, ESP_ERR_NO_MEM, TAG, "no mem for record");
+    length = app_ir_store_encode(cmd_list, record, length);
+    ESP_GOTO_ON_FALSE(length, ESP_ERR_NO_MEM, err, TAG, "encode failed");
+
+    /* Data is appended before the index points at it, an interrupted save keeps the old command */
+    ir_store_path(path, IR_STORE_DATA_FILE);
+    fp = fopen(path, "ab");
+    ESP_GOTO_ON_FALSE(fp, ESP_FAIL, err, TAG, "Failed open file:%s", path);
+    fseek(fp, 0, SEEK_END);
+    long offset = ftell(fp);
+    bool ok = (offset >= 0) && (1 == fwrite(record, length, 1, fp)) && ir_store_sync(fp);
+    ok = (0 == fclose(fp)) && ok;
+    ESP_GOTO_ON_FALSE(ok, ESP_FAIL, err, TAG, "Failed write record");
+
+    if (index < 0) {
+        index = entry_count++;
+        memset(&entries[index], 0, sizeof(ir_store_entry_t));
+        strlcpy(entries[index].device, device, APP_IR_STORE_NAME_LEN);
+        strlcpy(entries[index].key, key, APP_IR_STORE_NAME_LEN);
+    } else {
+        dead_bytes += entries[index].length;
+    }
+    entries[index].offset = offset;
+    entries[index].length = length;
+    entries[index].crc = esp_rom_crc32_le(0, record, length);
+    ESP_LOGD(TAG, "save %s/%s, %d bytes", device, key, (int) length);
+
+    ret = ir_store_write_index();
+    if (ESP_OK == ret && dead_bytes > IR_STORE_COMPACT_BYTES) {
+        ret = ir_store_compact();
+    }
+
+err:
+    free(record);
+    return ret;
+}
+
+esp_err_t app_ir_store_load(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list)
+{
+    esp_err_t ret = ESP_OK;
+    char path[IR_STORE_PATH_LEN];
+
+    int index = ir_store_find(device, key);
+    ESP_RETURN_ON_FALSE(index >= 0, ESP_ERR_NOT_FOUND, TAG, "%s/%s not found", device, key);
+
+    const ir_store_entry_t *entry = &entries[index];
+    uint8_t *record = malloc(entry->length);
+    ESP_RETURN_ON_FALSE(record, ESP_ERR_NO_MEM, TAG, "no mem for record");
+
+    ir_store_path(path, IR_STORE_DATA_FILE);
+    FILE *fp = fopen(path, "rb");
+    ESP_GOTO_ON_FALSE(fp, ESP_FAIL, err, TAG, "Failed open file:%s", path);
+    bool ok = (0 == fseek(fp, entry->offset, SEEK_SET)) && (1 == fread(record, entry->length, 1, fp));
+    fclose(fp);
+    ESP_GOTO_ON_FALSE(ok, ESP_FAIL, err, TAG, "Failed read record");
+    ESP_GOTO_ON_FALSE(entry->crc == esp_rom_crc32_le(0, record, entry->length), ESP_ERR_INVALID_CRC, err, TAG,
+                      "%s/%s crc mismatch", device, key);
+
+    ret = app_ir_store_decode(record, entry->length, cmd_list);
+
+err:
+    free(record);
+    return ret;
+}
+
+bool app_ir_store_exists(const char *device, const char *key)
+{
+    return ir_store_find(device, key) >= 0;
+}
+
+esp_err_t app_ir_store_remove(const char *device, const char *key)
+{
+    int index = ir_store_find(device, key);
+    ESP_RETURN_ON_FALSE(index >= 0, ESP_ERR_NOT_FOUND, TAG, "%s/%s not found", device, key);
+
+    dead_bytes += entries[index].length;
+    entry_count--;
+    memmove(&entries[index], &entries[index + 1], (entry_count - index) * sizeof(ir_store_entry_t));
+    return ir_store_write_index();
+}
+
+esp_err_t app_ir_store_import_legacy(const char *path, const char *device, const char *key)
+{
+    esp_err_t ret = ESP_OK;
+    struct ir_learn_sub_list_head cmd_list;
+    rmt_rx_done_event_data_t symbols = {0};
+    uint8_t total_cmd_num = 0;
+
+    SLIST_INIT(&cmd_list);
+    FILE *fp = fopen(path, "rb");
+    ESP_RETURN_ON_FALSE(fp, ESP_FAIL, TAG, "Failed open file:%s", path);
+    ESP_GOTO_ON_FALSE(1 == fread(&total_cmd_num, sizeof(total_cmd_num), 1, fp), ESP_ERR_INVALID_SIZE, err, TAG, "truncated file");
+
+    for (int i = 0; i < total_cmd_num; i++) {
+        uint32_t timediff;
+        ESP_GOTO_ON_FALSE(1 == fread(&timediff, sizeof(uint32_t), 1, fp)
+                          && 1 == fread(&symbols.num_symbols, sizeof(size_t), 1, fp)
+                          && symbols.num_symbols && symbols.num_symbols <= IR_STORE_MAX_SYMBOLS,
+                          ESP_ERR_INVALID_SIZE, err, TAG, "truncated file");
+        symbols.received_symbols = (rmt_symbol_word_t *)heap_caps_malloc(symbols.num_symbols * sizeof(rmt_symbol_word_t), \
+                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ESP_GOTO_ON_FALSE(symbols.received_symbols, ESP_ERR_NO_MEM, err, TAG, "no mem for symbols");
+        ESP_GOTO_ON_FALSE(symbols.num_symbols == fread(symbols.received_symbols, sizeof(rmt_symbol_word_t), symbols.num_symbols, fp),
+                          ESP_ERR_INVALID_SIZE, err, TAG, "truncated file");
+        ir_learn_add_sub_list_node(&cmd_list, timediff, &symbols);
+        free(symbols.received_symbols);
+        symbols.received_symbols = NULL;
+    }
+    fclose(fp);
+    fp = NULL;
+
+    ret = app_ir_store_save(device, key, &cmd_list);
+    ESP_LOGI(TAG, "imported %s as %s/%s", path, device, key);
+
+err:
+    if (fp) {
+        fclose(fp);
+    }
+    free(symbols.received_symbols);
+    ir_learn_clean_sub_data(&cmd_list);
+    return ret;
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_IR_STORE_NAME_LEN       16  // including the terminating zero
+#define APP_IR_STORE_MAX_KEYS       32
+
+typedef enum {
+    APP_IR_PROTO_RAW,           /*!< Quantized, run-length compressed timings */
+    APP_IR_PROTO_NEC,           /*!< 32 bit NEC frame */
+    APP_IR_PROTO_NEC_REPEAT,    /*!< NEC repeat code, no payload */
+    APP_IR_PROTO_SONY,          /*!< Sony SIRC, 12, 15 or 20 bits */
+    APP_IR_PROTO_RC5,           /*!< Philips RC5, 14 bits including start bits */
+} app_ir_proto_t;
+
+/**
+ * @brief Open the IR library, loading its index into RAM
+ *
+ * @param base_path Directory that holds the index and data files
+ *
+ * @return
+ *      - ESP_OK    On success, a missing or corrupted index starts an empty library
+ *      - Others    Fail
+ */
+esp_err_t app_ir_store_init(const char *base_path);
+
+/**
+ * @brief Save a learned command, replacing an existing one with the same name
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_NO_MEM        Index full or out of memory
+ *      - ESP_FAIL              File write failed
+ */
+esp_err_t app_ir_store_save(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list);
+
+/**
+ * @brief Load a command, frames are appended to `cmd_list`
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_NOT_FOUND     No such command
+ *      - ESP_ERR_INVALID_CRC   Stored record is corrupted
+ */
+esp_err_t app_ir_store_load(const char *device, const char *key, struct ir_learn_sub_list_head *cmd_list);
+
+/**
+ * @brief Check whether a command is stored
+ */
+bool app_ir_store_exists(const char *device, const char *key);
+
+/**
+ * @brief Remove a command, its data is reclaimed by the next compaction
+ */
+esp_err_t app_ir_store_remove(const char *device, const char *key);
+
+/**
+ * @brief Import a file written by the former raw symbol format
+ *
+ * @param path  Legacy file, it is left in place
+ */
+esp_err_t app_ir_store_import_legacy(const char *path, const char *device, const char *key);
+
+/**
+ * @brief Serialize a command into the library record format
+ *
+ * @param cmd_list  Learned frames
+ * @param out       Output buffer, NULL to only compute the size
+ * @param size      Size of `out`
+ *
+ * @return Record size in bytes, 0 if the command is empty or does not fit
+ */
+size_t app_ir_store_encode(struct ir_learn_sub_list_head *cmd_list, uint8_t *out, size_t size);
+
+/**
+ * @brief Parse a record produced by app_ir_store_encode, frames are appended to `cmd_list`
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_SIZE  Truncated or malformed record
+ *      - ESP_ERR_NO_MEM        Out of memory
+ */
+esp_err_t app_ir_store_decode(const uint8_t *data, size_t len, struct ir_learn_sub_list_head *cmd_list);
+
+#ifdef __cplusplus
+}
+#endif
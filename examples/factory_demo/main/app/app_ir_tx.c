@@ -0,0 +1,304 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "driver/gpio.h"
+#include "driver/rmt_tx.h"
+#include "ir_encoder.h"
+#include "bsp_board.h"
+#include "app_ir_tx.h"
+
+#define IR_TX_DURATION_MAX      0x7FFF  // 15 bit duration field of an RMT symbol
+
+static const char *TAG = "app_ir_tx";
+
+struct app_ir_tx_cmd_t {
+    rmt_symbol_word_t *symbols;
+    size_t num_symbols;
+};
+
+typedef struct {
+    app_ir_tx_cmd_handle_t cmd;
+    app_ir_tx_done_cb_t cb;
+    void *user_data;
+} ir_tx_pending_t;
+
+static rmt_channel_handle_t tx_channel = NULL;
+static rmt_encoder_handle_t tx_encoder = NULL;
+static SemaphoreHandle_t tx_lock = NULL;
+static QueueHandle_t tx_done_queue = NULL;
+
+/* Transactions complete in submission order, so the oldest entry belongs to each done event */
+static portMUX_TYPE pending_spinlock = portMUX_INITIALIZER_UNLOCKED;
+static ir_tx_pending_t pending[APP_IR_TX_QUEUE_DEPTH];
+static uint8_t pending_head = 0;
+static uint8_t pending_num = 0;
+
+static void ir_tx_put(rmt_symbol_word_t *out, size_t index, uint32_t d0, uint32_t l0, uint32_t d1, uint32_t l1)
+{
+    if (out) {
+        out[index].duration0 = d0;
+        out[index].level0 = l0;
+        out[index].duration1 = d1;
+        out[index].level1 = l1;
+    }
+}
+
+size_t app_ir_tx_encode(const app_ir_tx_frame_t *frames, size_t frame_num, rmt_symbol_word_t *out)
+{
+    size_t num = 0;
+    bool open = false;  // second half of the last symbol is still empty
+
+    for (size_t i = 0; i < frame_num; i++) {
+        uint32_t gap = i ? frames[i].gap_us : 0;
+
+        if (open) {
+            /* Zero would end the transmission here, so at least one tick is used */
+            uint32_t d = MAX(MIN(gap, IR_TX_DURATION_MAX), 1);
+            if (out) {
+                out[num - 1].duration1 = d;
+                out[num - 1].level1 = 0;
+            }
+            gap -= MIN(gap, d);
+            open = false;
+        }
+
+        while (gap) {
+            uint32_t d0 = MIN(gap, IR_TX_DURATION_MAX);
+            gap -= d0;
+            uint32_t d1 = MIN(gap, IR_TX_DURATION_MAX);
+            gap -= d1;
+            if (!d1) {
+                d1 = MAX(d0 / 2, 1);
+                d0 = MAX(d0 - d1, 1);
+            }
+            ir_tx_put(out, num++, d0, 0, d1, 0);
+        }
+
+        for (size_t j = 0; j < frames[i].num_symbols; j++) {
+            rmt_symbol_word_t s = frames[i].symbols[j];
+            if (!s.duration0) {
+                break;
+            }
+            ir_tx_put(out, num++, s.duration0, s.level0, s.duration1, s.level1);
+            if (!s.duration1) {
+                open = true;
+                break;
+            }
+        }
+    }
+
+    return num;
+}
+
+static bool ir_tx_done_isr(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    BaseType_t task_woken = pdFALSE;
+    ir_tx_pending_t done = {0};
+    bool valid = false;
+
+    portENTER_CRITICAL_ISR(&pending_spinlock);
+    if (pending_num) {
+        done = pending[pending_head];
+        pending_head = (pending_head + 1) % APP_IR_TX_QUEUE_DEPTH;
+        pending_num--;
+        valid = true;
+    }
+    portEXIT_CRITICAL_ISR(&pending_spinlock);
+
+    if (valid) {
+        xQueueSendFromISR(tx_done_queue, &done, &task_woken);
+    }
+    return task_woken == pdTRUE;
+}
+
+static void ir_tx_done_task(void *arg)
+{
+    ir_tx_pending_t done;
+
+    while (1) {
+        if (xQueueReceive(tx_done_queue, &done, portMAX_DELAY) == pdPASS && done.cb) {
+            done.cb(done.cmd, done.user_data);
+        }
+    }
+}
+
+esp_err_t app_ir_tx_init(void)
+{
+    esp_err_t ret = ESP_OK;
+
+    if (tx_channel) {
+        return ESP_OK;
+    }
+
+    gpio_config_t io_conf = {};
+    io_conf.pin_bit_mask = BIT64(BSP_IR_CTRL_GPIO);
+    io_conf.mode = GPIO_MODE_OUTPUT;
+    io_conf.pull_up_en = true;
+    gpio_config(&io_conf);
+    gpio_set_level(BSP_IR_CTRL_GPIO, 0);//enable IR TX
+
+    tx_lock = xSemaphoreCreateMutex();
+    tx_done_queue = xQueueCreate(APP_IR_TX_QUEUE_DEPTH, sizeof(ir_tx_pending_t));
+    ESP_GOTO_ON_FALSE(tx_lock && tx_done_queue, ESP_ERR_NO_MEM, err, TAG, "create tx queue failed");
+
+    rmt_tx_channel_config_t tx_channel_cfg = {
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = APP_IR_TX_RESOLUTION_HZ,
+        .mem_block_symbols = 128, // amount of RMT symbols that the channel can store at a time
+        .trans_queue_depth = APP_IR_TX_QUEUE_DEPTH,
+        .gpio_num = BSP_IR_TX_GPIO,
+    };
+    ESP_GOTO_ON_ERROR(rmt_new_tx_channel(&tx_channel_cfg, &tx_channel), err, TAG, "create tx channel failed");
+
+    rmt_carrier_config_t carrier_cfg = {
+        .duty_cycle = 0.33,
+        .frequency_hz = 38000, // 38KHz
+    };
+    ESP_GOTO_ON_ERROR(rmt_apply_carrier(tx_channel, &carrier_cfg), err, TAG, "apply carrier failed");
+
+    ir_encoder_config_t encoder_cfg = {
+        .resolution = APP_IR_TX_RESOLUTION_HZ,
+    };
+    ESP_GOTO_ON_ERROR(ir_encoder_new(&encoder_cfg, &tx_encoder), err, TAG, "create encoder failed");
+
+    rmt_tx_event_callbacks_t cbs = {
+        .on_trans_done = ir_tx_done_isr,
+    };
+    ESP_GOTO_ON_ERROR(rmt_tx_register_event_callbacks(tx_channel, &cbs, NULL), err, TAG, "register callback failed");
+    ESP_GOTO_ON_ERROR(rmt_enable(tx_channel), err, TAG, "enable tx channel failed");
+
+    ESP_GOTO_ON_FALSE(pdPASS == xTaskCreatePinnedToCore(ir_tx_done_task, "ir_tx_done", 1024 * 3, NULL, 10, NULL, 1),
+                      ESP_ERR_NO_MEM, err, TAG, "create done task failed");
+
+    return ESP_OK;
+
+err:
+    if (tx_channel) {
+        rmt_disable(tx_channel);
+        rmt_del_channel(tx_channel);
+        tx_channel = NULL;
+    }
+    if (tx_encoder) {
+        tx_encoder->del(tx_encoder);
+        tx_encoder = NULL;
+    }
+    if (tx_done_queue) {
+        vQueueDelete(tx_done_queue);
+        tx_done_queue = NULL;
+    }
+    if (tx_lock) {
+        vSemaphoreDelete(tx_lock);
+        tx_lock = NULL;
+    }
+    return ret;
+}
+
+esp_err_t app_ir_tx_cmd_create(struct ir_learn_sub_list_head *cmd_list, app_ir_tx_cmd_handle_t *ret_cmd)
+{
+    esp_err_t ret = ESP_OK;
+    size_t frame_num = 0;
+    ir_learn_sub_list_t *sub_it;
+    app_ir_tx_frame_t *frames = NULL;
+    app_ir_tx_cmd_handle_t cmd = NULL;
+
+    ESP_RETURN_ON_FALSE(cmd_list && ret_cmd, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    SLIST_FOREACH(sub_it, cmd_list, next) {
+        frame_num++;
+    }
+    ESP_RETURN_ON_FALSE(frame_num, ESP_ERR_INVALID_ARG, TAG, "empty command");
+
+    frames = calloc(frame_num, sizeof(app_ir_tx_frame_t));
+    cmd = calloc(1, sizeof(struct app_ir_tx_cmd_t));
+    ESP_GOTO_ON_FALSE(frames && cmd, ESP_ERR_NO_MEM, err, TAG, "no mem for command");
+
+    frame_num = 0;
+    SLIST_FOREACH(sub_it, cmd_list, next) {
+        frames[frame_num].symbols = sub_it->symbols.received_symbols;
+        frames[frame_num].num_symbols = sub_it->symbols.num_symbols;
+        frames[frame_num].gap_us = sub_it->timediff;
+        frame_num++;
+    }
+
+    cmd->num_symbols = app_ir_tx_encode(frames, frame_num, NULL);
+    ESP_GOTO_ON_FALSE(cmd->num_symbols, ESP_ERR_INVALID_ARG, err, TAG, "empty command");
+    cmd->symbols = heap_caps_malloc(cmd->num_symbols * sizeof(rmt_symbol_word_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(cmd->symbols, ESP_ERR_NO_MEM, err, TAG, "no mem for symbols");
+    app_ir_tx_encode(frames, frame_num, cmd->symbols);
+
+    ESP_LOGD(TAG, "command encoded, frames:%d, symbols:%d", (int) frame_num, (int) cmd->num_symbols);
+    free(frames);
+    *ret_cmd = cmd;
+    return ESP_OK;
+
+err:
+    free(frames);
+    free(cmd);
+    return ret;
+}
+
+void app_ir_tx_cmd_delete(app_ir_tx_cmd_handle_t cmd)
+{
+    if (!cmd) {
+        return;
+    }
+
+    if (tx_channel) {
+        xSemaphoreTake(tx_lock, portMAX_DELAY);
+        rmt_tx_wait_all_done(tx_channel, -1);
+        xSemaphoreGive(tx_lock);
+    }
+    free(cmd->symbols);
+    free(cmd);
+}
+
+esp_err_t app_ir_tx_send(app_ir_tx_cmd_handle_t cmd, app_ir_tx_done_cb_t cb, void *user_data)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(cmd, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(tx_channel, ESP_ERR_INVALID_STATE, TAG, "ir tx not initialized");
+
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+
+    /* Queued before transmitting, the done interrupt may fire before rmt_transmit returns */
+    portENTER_CRITICAL(&pending_spinlock);
+    bool full = (APP_IR_TX_QUEUE_DEPTH == pending_num);
+    if (!full) {
+        uint8_t tail = (pending_head + pending_num) % APP_IR_TX_QUEUE_DEPTH;
+        pending[tail].cmd = cmd;
+        pending[tail].cb = cb;
+        pending[tail].user_data = user_data;
+        pending_num++;
+    }
+    portEXIT_CRITICAL(&pending_spinlock);
+    ESP_GOTO_ON_FALSE(!full, ESP_ERR_NO_MEM, err, TAG, "tx queue full");
+
+    rmt_transmit_config_t transmit_config = {
+        .loop_count = 0, // no loop
+    };
+    /* The IR encoder takes the payload size as a symbol count */
+    ret = rmt_transmit(tx_channel, tx_encoder, cmd->symbols, cmd->num_symbols, &transmit_config);
+    if (ESP_OK != ret) {
+        ESP_LOGE(TAG, "transmit failed");
+        portENTER_CRITICAL(&pending_spinlock);
+        pending_num--;
+        portEXIT_CRITICAL(&pending_spinlock);
+    }
+
+err:
+    xSemaphoreGive(tx_lock);
+    return ret;
+}
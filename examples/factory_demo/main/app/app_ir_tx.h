@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/rmt_types.h"
+#include "ir_learn.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_IR_TX_RESOLUTION_HZ     1000000 // 1MHz resolution, 1 tick = 1us
+#define APP_IR_TX_QUEUE_DEPTH       4       // commands allowed to be pending in the RMT driver
+
+typedef struct app_ir_tx_cmd_t *app_ir_tx_cmd_handle_t;
+
+/**
+ * @brief Called from the IR TX task once every frame of a command has left the RMT channel
+ */
+typedef void (*app_ir_tx_done_cb_t)(app_ir_tx_cmd_handle_t cmd, void *user_data);
+
+/**
+ * @brief One learned frame, `gap_us` is the idle time before it, ignored for the first frame
+ */
+typedef struct {
+    const rmt_symbol_word_t *symbols;
+    size_t num_symbols;
+    uint32_t gap_us;
+} app_ir_tx_frame_t;
+
+/**
+ * @brief Create the RMT TX channel and encoder, they are kept until reboot
+ *
+ * @return
+ *      - ESP_OK    On success, also when already initialized
+ *      - Others    Failed to set up the channel
+ */
+esp_err_t app_ir_tx_init(void);
+
+/**
+ * @brief Pre-encode a learned command, all frames and gaps become one RMT transaction
+ *
+ * @param cmd_list  Learned frames, the list is not referenced after return
+ * @param ret_cmd   Created command
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Empty command
+ *      - ESP_ERR_NO_MEM        Out of memory
+ */
+esp_err_t app_ir_tx_cmd_create(struct ir_learn_sub_list_head *cmd_list, app_ir_tx_cmd_handle_t *ret_cmd);
+
+/**
+ * @brief Delete a command, waits for a transmission in progress to finish
+ */
+void app_ir_tx_cmd_delete(app_ir_tx_cmd_handle_t cmd);
+
+/**
+ * @brief Queue a command without waiting for it to be sent
+ *
+ * @param cmd       Command created by app_ir_tx_cmd_create
+ * @param cb        Completion callback, may be NULL
+ * @param user_data Passed to the callback
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_STATE Not initialized
+ *      - ESP_ERR_NO_MEM        APP_IR_TX_QUEUE_DEPTH commands already pending
+ */
+esp_err_t app_ir_tx_send(app_ir_tx_cmd_handle_t cmd, app_ir_tx_done_cb_t cb, void *user_data);
+
+/**
+ * @brief Lay out frames and inter-frame gaps as one RMT symbol stream
+ *
+ * Gaps are emitted as idle symbols so their timing is produced by the RMT hardware. A frame whose last
+ * symbol ends with a zero duration (the RX end marker) has that half filled with the following gap.
+ *
+ * @param frames    Frames in transmit order
+ * @param frame_num Number of frames
+ * @param out       Output buffer, NULL to only count the symbols
+ *
+ * @return Number of symbols written or needed
+ */
+size_t app_ir_tx_encode(const app_ir_tx_frame_t *frames, size_t frame_num, rmt_symbol_word_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -28,6 +28,7 @@
 #include "esp_afe_sr_iface.h"
 #include "esp_mn_iface.h"
 #include "app_sr_handler.h"
+#include "app_sr_level.h"
 #include "model_path.h"
 #include "bsp_board.h"
 #include "settings.h"
@@ -192,6 +193,9 @@ static void audio_detect_task(void *arg)
             continue;
         }
 
+        /* Drives the speech animation, a few microseconds per chunk */
+        app_sr_level_update(res->data, afe_chunksize);
+
         if (res->wakeup_state == WAKENET_DETECTED) {
             ESP_LOGI(TAG,  "wakeword detected");
             sr_result_t result = {
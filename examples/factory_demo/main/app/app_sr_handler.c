@@ -13,6 +13,7 @@
 #include "app_sr.h"
 #include "file_manager.h"
 #include "audio_player.h"
+#include "audio_readahead.h"
 #include "file_iterator.h"
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
@@ -239,7 +240,7 @@ void sr_handler_task(void *pvParam)
             case SR_CMD_NEXT:
                 file_iterator_next(file_iterator);
                 file_iterator_get_full_path_from_index(file_iterator, file_iterator_get_index(file_iterator), filename, sizeof(filename));
-                fp = fopen(filename, "rb");
+                fp = audio_readahead_open(filename, NULL);
                 if (!fp) {
                     ESP_LOGE(TAG, "unable to open '%s'", filename);
                 } else {
@@ -251,7 +252,7 @@ void sr_handler_task(void *pvParam)
                 ESP_LOGD(TAG, "SR_CMD_PLAY:%d, last_player_state:%d", audio_player_get_state(), last_player_state);
                 if (AUDIO_PLAYER_STATE_IDLE == audio_player_get_state()) {
                     file_iterator_get_full_path_from_index(file_iterator, file_iterator_get_index(file_iterator), filename, sizeof(filename));
-                    fp = fopen(filename, "rb");
+                    fp = audio_readahead_open(filename, NULL);
                     if (!fp) {
                         ESP_LOGE(TAG, "unable to open '%s'", filename);
                     } else {
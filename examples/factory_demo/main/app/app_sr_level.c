@@ -0,0 +1,135 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "app_sr_level.h"
+
+#define LEVEL_FLOOR_DB      (-60.0f)
+#define SAMPLE_RATE         (16000.0f)
+#define BAND_Q              (1.2f)
+
+typedef struct {
+    float b0;           /* b1 is 0 and b2 is -b0 for a band-pass */
+    float a1;
+    float a2;
+    float z1;
+    float z2;
+} band_t;
+
+static const float s_band_hz[SR_LEVEL_BANDS] = { 300.0f, 800.0f, 1800.0f, 4000.0f };
+static band_t s_band[SR_LEVEL_BANDS];
+static bool s_band_ready;
+
+/* Single writer seqlock: odd while an update is being written, readers retry then */
+static atomic_uint s_seq;
+static atomic_uint s_word[2];
+
+static uint8_t level_of(uint64_t sum_sq, size_t samples)
+{
+    if (0 == sum_sq) {
+        return 0;
+    }
+    float db = 10.0f * log10f((float)sum_sq / samples / (32768.0f * 32768.0f));
+    if (db <= LEVEL_FLOOR_DB) {
+        return 0;
+    }
+    return db >= 0.0f ? 100 : (uint8_t)(100.0f * (1.0f - db / LEVEL_FLOOR_DB));
+}
+
+/* Constant 0 dB peak gain band-pass biquads, from the Audio EQ Cookbook */
+static void band_init(void)
+{
+    for (size_t b = 0; b < SR_LEVEL_BANDS; b++) {
+        float w0 = 2.0f * (float)M_PI * s_band_hz[b] / SAMPLE_RATE;
+        float alpha = sinf(w0) / (2.0f * BAND_Q);
+        float a0 = 1.0f + alpha;
+        s_band[b] = (band_t) {
+            .b0 = alpha / a0,
+            .a1 = -2.0f * cosf(w0) / a0,
+            .a2 = (1.0f - alpha) / a0,
+        };
+    }
+    s_band_ready = true;
+}
+
+void app_sr_level_update(const int16_t *pcm, size_t samples)
+{
+    uint64_t sum_sq = 0;
+    float band_sq[SR_LEVEL_BANDS] = { 0 };
+    int32_t peak = 0;
+
+    if (0 == samples) {
+        return;
+    }
+    if (!s_band_ready) {
+        band_init();
+    }
+
+    for (size_t i = 0; i < samples; i++) {
+        int32_t x = pcm[i];
+        sum_sq += (int64_t)x * x;
+        if (abs(x) > peak) {
+            peak = abs(x);
+        }
+    }
+    for (size_t b = 0; b < SR_LEVEL_BANDS; b++) {
+        band_t *f = &s_band[b];
+        float z1 = f->z1, z2 = f->z2, sq = 0.0f;
+        for (size_t i = 0; i < samples; i++) {
+            float x = pcm[i];
+            float y = f->b0 * x + z1;
+            z1 = z2 - f->a1 * y;
+            z2 = -f->b0 * x - f->a2 * y;
+            sq += y * y;
+        }
+        /* Below one LSB the state only decays, into subnormals that cost many times a sample on silence */
+        f->z1 = fabsf(z1) < 1.0f ? 0.0f : z1;
+        f->z2 = fabsf(z2) < 1.0f ? 0.0f : z2;
+        band_sq[b] = sq;
+    }
+
+    sr_level_t level = {
+        .rms = level_of(sum_sq, samples),
+        .peak = level_of((uint64_t)peak * peak, 1),
+    };
+    for (size_t b = 0; b < SR_LEVEL_BANDS; b++) {
+        level.band[b] = level_of((uint64_t)band_sq[b], samples);
+    }
+
+    unsigned seq = atomic_load_explicit(&s_seq, memory_order_relaxed);
+    atomic_store_explicit(&s_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&s_word[0], level.rms | level.peak << 8 | level.band[0] << 16 | level.band[1] << 24,
+                          memory_order_relaxed);
+    atomic_store_explicit(&s_word[1], level.band[2] | level.band[3] << 8, memory_order_relaxed);
+    atomic_store_explicit(&s_seq, seq + 2, memory_order_release);
+}
+
+bool app_sr_level_get(sr_level_t *level, uint32_t *seq)
+{
+    unsigned begin, end, w0, w1;
+
+    do {
+        begin = atomic_load_explicit(&s_seq, memory_order_acquire);
+        w0 = atomic_load_explicit(&s_word[0], memory_order_relaxed);
+        w1 = atomic_load_explicit(&s_word[1], memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        end = atomic_load_explicit(&s_seq, memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    *level = (sr_level_t) {
+        .rms = w0 & 0xff,
+        .peak = (w0 >> 8) & 0xff,
+        .band = { (w0 >> 16) & 0xff, w0 >> 24, w1 & 0xff, (w1 >> 8) & 0xff },
+    };
+    if (seq) {
+        *seq = end / 2;
+    }
+    return 0 != end;
+}
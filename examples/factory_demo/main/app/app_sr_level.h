@@ -0,0 +1,46 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SR_LEVEL_BANDS  4
+
+/**
+ * @brief Level of one AFE output chunk, 0 - 100 maps -60 dBFS - 0 dBFS
+ */
+typedef struct {
+    uint8_t rms;
+    uint8_t peak;
+    uint8_t band[SR_LEVEL_BANDS];   /*!< RMS around 300 Hz, 800 Hz, 1.8 kHz and 4 kHz */
+} sr_level_t;
+
+/**
+ * @brief Measure a chunk of 16 kHz mono samples and publish it
+ *
+ * @note Only the detect task may call this, the band filters keep their state from chunk to chunk
+ */
+void app_sr_level_update(const int16_t *pcm, size_t samples);
+
+/**
+ * @brief Latest published level, never blocks
+ *
+ * @param[out] seq  Bumped by every update, may be NULL
+ *
+ * @return false if nothing was published yet
+ */
+bool app_sr_level_get(sr_level_t *level, uint32_t *seq);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,413 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Fixed size temperature/humidity history. Raw samples cover the last hour, min/max/avg rollups at
+ * 1 min, 15 min and 1 h cover one day, one week and 30 days. Every tier is fed by the raw samples
+ * directly, so a rollup is exact whatever happened to the finer tiers. The 15 min and 1 h rollups can
+ * be appended to a raw flash partition used as a circular log, one sector is erased per wrap.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "bsp_board.h"
+#include "app_telemetry.h"
+
+#define TELEMETRY_CH_NUM            APP_TELEMETRY_CHANNEL_MAX
+#define TELEMETRY_RAW_SIZE          (3600 * 1000 / APP_TELEMETRY_SAMPLE_PERIOD_MS)
+#define TELEMETRY_TIER_NUM          3
+#define TELEMETRY_PERSIST_TIER_MIN  1                   // 15 min and 1 h rollups are persisted
+#define TELEMETRY_QUERY_MAX_BUCKETS (4 * APP_TELEMETRY_QUERY_MAX_POINTS)
+#define TELEMETRY_TIME_VALID        1700000000          // wall clock is considered synced after 2023-11
+#define TELEMETRY_RECORD_MAGIC      0x544C
+#define TELEMETRY_SECTOR_SIZE       4096
+
+static const char *TAG = "app_telemetry";
+
+typedef struct __attribute__((packed)) {
+    uint32_t start;
+    int16_t min[TELEMETRY_CH_NUM];
+    int16_t max[TELEMETRY_CH_NUM];
+    int16_t avg[TELEMETRY_CH_NUM];
+    uint16_t count;
+} telemetry_bucket_t;
+
+typedef struct {
+    uint32_t start;
+    int16_t min[TELEMETRY_CH_NUM];
+    int16_t max[TELEMETRY_CH_NUM];
+    int32_t sum[TELEMETRY_CH_NUM];
+    uint16_t count;
+} telemetry_accum_t;
+
+typedef struct {
+    uint32_t width_s;
+    uint16_t size;
+    uint16_t head;              // next slot to write
+    uint16_t count;
+    telemetry_bucket_t *buckets;
+    telemetry_accum_t open;
+} telemetry_tier_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t tier;
+    uint8_t reserved[3];
+    uint32_t seq;
+    telemetry_bucket_t bucket;
+    uint32_t crc;
+} telemetry_record_t;
+
+_Static_assert(TELEMETRY_SECTOR_SIZE % sizeof(telemetry_record_t) == 0, "records must not straddle sectors");
+
+static telemetry_tier_t tiers[TELEMETRY_TIER_NUM] = {
+    {.width_s = 60,         .size = 24 * 60},
+    {.width_s = 15 * 60,    .size = 7 * 24 * 4},
+    {.width_s = 60 * 60,    .size = 30 * 24},
+};
+
+static int16_t (*raw)[TELEMETRY_CH_NUM] = NULL;
+static uint16_t raw_head = 0;
+static uint16_t raw_count = 0;
+static SemaphoreHandle_t telemetry_lock = NULL;
+
+static const esp_partition_t *partition = NULL;
+static bool persist_ready = false;
+static uint32_t write_offset = 0;
+static uint32_t write_seq = 0;
+
+static void telemetry_accum_reset(telemetry_accum_t *acc, uint32_t start)
+{
+    memset(acc, 0, sizeof(telemetry_accum_t));
+    acc->start = start;
+    for (int ch = 0; ch < TELEMETRY_CH_NUM; ch++) {
+        acc->min[ch] = INT16_MAX;
+        acc->max[ch] = INT16_MIN;
+    }
+}
+
+static void telemetry_accum_to_bucket(const telemetry_accum_t *acc, telemetry_bucket_t *bucket)
+{
+    bucket->start = acc->start;
+    bucket->count = acc->count;
+    for (int ch = 0; ch < TELEMETRY_CH_NUM; ch++) {
+        bucket->min[ch] = acc->min[ch];
+        bucket->max[ch] = acc->max[ch];
+        bucket->avg[ch] = acc->count ? acc->sum[ch] / acc->count : 0;
+    }
+}
+
+static void telemetry_tier_clear(telemetry_tier_t *tier)
+{
+    tier->head = 0;
+    tier->count = 0;
+    telemetry_accum_reset(&tier->open, 0);
+}
+
+static void telemetry_tier_push(telemetry_tier_t *tier, const telemetry_bucket_t *bucket)
+{
+    tier->buckets[tier->head] = *bucket;
+    tier->head = (tier->head + 1) % tier->size;
+    tier->count = MIN(tier->count + 1, tier->size);
+}
+
+/* index 0 is the newest closed bucket */
+static const telemetry_bucket_t *telemetry_tier_get(const telemetry_tier_t *tier, uint16_t index)
+{
+    return &tier->buckets[(tier->head + tier->size - 1 - index) % tier->size];
+}
+
+/* Returns true and fills `closed` when the sample starts a new bucket */
+static bool telemetry_tier_ingest(telemetry_tier_t *tier, uint32_t now, const int16_t *value, telemetry_bucket_t *closed)
+{
+    uint32_t start = now - now % tier->width_s;
+    bool ret = false;
+
+    if (tier->open.count && start != tier->open.start) {
+        if (start > tier->open.start) {
+            telemetry_accum_to_bucket(&tier->open, closed);
+            telemetry_tier_push(tier, closed);
+            ret = true;
+        }
+        telemetry_accum_reset(&tier->open, start);
+    }
+
+    /* The clock went backwards, history no longer lines up with it */
+    if (tier->count && start <= telemetry_tier_get(tier, 0)->start) {
+        telemetry_tier_clear(tier);
+        ret = false;
+    }
+
+    if (!tier->open.count) {
+        telemetry_accum_reset(&tier->open, start);
+    }
+    for (int ch = 0; ch < TELEMETRY_CH_NUM; ch++) {
+        tier->open.min[ch] = MIN(tier->open.min[ch], value[ch]);
+        tier->open.max[ch] = MAX(tier->open.max[ch], value[ch]);
+        tier->open.sum[ch] += value[ch];
+    }
+    tier->open.count++;
+    return ret;
+}
+
+static void telemetry_point_merge(app_telemetry_point_t *point, int32_t *sum, int16_t min, int16_t max, int16_t avg, uint16_t count)
+{
+    point->min = MIN(point->min, min);
+    point->max = MAX(point->max, max);
+    *sum += (int32_t)avg * count;
+    point->count += count;
+}
+
+static uint32_t telemetry_record_crc(const telemetry_record_t *record)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)record, offsetof(telemetry_record_t, crc));
+}
+
+static bool telemetry_record_valid(const telemetry_record_t *record)
+{
+    return record->magic == TELEMETRY_RECORD_MAGIC && record->tier >= TELEMETRY_PERSIST_TIER_MIN
+           && record->tier < TELEMETRY_TIER_NUM && record->crc == telemetry_record_crc(record);
+}
+
+/* Find the write position, then replay the log from its oldest record */
+static void telemetry_persist_restore(void)
+{
+    telemetry_record_t *sector = malloc(TELEMETRY_SECTOR_SIZE);
+    const size_t per_sector = TELEMETRY_SECTOR_SIZE / sizeof(telemetry_record_t);
+    bool found = false;
+
+    if (!sector) {
+        ESP_LOGE(TAG, "no mem for restore");
+        return;
+    }
+
+    write_offset = 0;
+    write_seq = 0;
+    for (uint32_t offset = 0; offset < partition->size; offset += TELEMETRY_SECTOR_SIZE) {
+        if (ESP_OK != esp_partition_read(partition, offset, sector, TELEMETRY_SECTOR_SIZE)) {
+            continue;
+        }
+        for (size_t i = 0; i < per_sector; i++) {
+            if (telemetry_record_valid(&sector[i]) && (!found || sector[i].seq >= write_seq)) {
+                found = true;
+                write_seq = sector[i].seq + 1;
+                write_offset = (offset + (i + 1) * sizeof(telemetry_record_t)) % partition->size;
+            }
+        }
+    }
+
+    for (int t = TELEMETRY_PERSIST_TIER_MIN; t < TELEMETRY_TIER_NUM; t++) {
+        telemetry_tier_clear(&tiers[t]);
+    }
+
+    size_t restored = 0;
+    uint32_t first_sector = write_offset - write_offset % TELEMETRY_SECTOR_SIZE;
+    for (uint32_t n = 0; found && n <= partition->size / TELEMETRY_SECTOR_SIZE; n++) {
+        uint32_t offset = (first_sector + n * TELEMETRY_SECTOR_SIZE) % partition->size;
+        if (ESP_OK != esp_partition_read(partition, offset, sector, TELEMETRY_SECTOR_SIZE)) {
+            continue;
+        }
+        /* The sector holding the write position is visited twice, its older part first */
+        size_t split = (write_offset - first_sector) / sizeof(telemetry_record_t);
+        size_t begin = (0 == n) ? split : 0;
+        size_t end = (n == partition->size / TELEMETRY_SECTOR_SIZE) ? split : per_sector;
+        for (size_t i = begin; i < end; i++) {
+            if (telemetry_record_valid(&sector[i])) {
+                telemetry_tier_t *tier = &tiers[sector[i].tier];
+                if (!tier->count || sector[i].bucket.start > telemetry_tier_get(tier, 0)->start) {
+                    telemetry_tier_push(tier, &sector[i].bucket);
+                    restored++;
+                }
+            }
+        }
+    }
+    free(sector);
+    ESP_LOGI(TAG, "restored %d rollups, next seq %" PRIu32, (int) restored, write_seq);
+}
+
+static void telemetry_persist_write(uint8_t tier, const telemetry_bucket_t *bucket)
+{
+    telemetry_record_t record = {
+        .magic = TELEMETRY_RECORD_MAGIC,
+        .tier = tier,
+        .seq = write_seq,
+        .bucket = *bucket,
+    };
+    record.crc = telemetry_record_crc(&record);
+
+    /* Entering a sector drops its oldest records, each sector is erased once per wrap */
+    if (0 == write_offset % TELEMETRY_SECTOR_SIZE) {
+        if (ESP_OK != esp_partition_erase_range(partition, write_offset, TELEMETRY_SECTOR_SIZE)) {
+            ESP_LOGE(TAG, "erase 0x%" PRIx32 " failed", write_offset);
+            return;
+        }
+    }
+    if (ESP_OK != esp_partition_write(partition, write_offset, &record, sizeof(record))) {
+        ESP_LOGE(TAG, "write 0x%" PRIx32 " failed", write_offset);
+    }
+    write_offset = (write_offset + sizeof(record)) % partition->size;
+    write_seq++;
+}
+
+void app_telemetry_add_sample(time_t now, float temperature, float humidity)
+{
+    telemetry_bucket_t closed[TELEMETRY_TIER_NUM];
+    bool persist[TELEMETRY_TIER_NUM] = {0};
+    int16_t value[TELEMETRY_CH_NUM] = {
+        [APP_TELEMETRY_TEMPERATURE] = MAX(MIN(temperature * 100, INT16_MAX), INT16_MIN),
+        [APP_TELEMETRY_HUMIDITY] = MAX(MIN(humidity * 100, INT16_MAX), INT16_MIN),
+    };
+
+    if (!telemetry_lock) {
+        return;
+    }
+
+    /* Persisted history is only meaningful against a synced clock, it is loaded on the first such sample */
+    if (partition && !persist_ready && now >= TELEMETRY_TIME_VALID) {
+        xSemaphoreTake(telemetry_lock, portMAX_DELAY);
+        telemetry_persist_restore();
+        persist_ready = true;
+        xSemaphoreGive(telemetry_lock);
+    }
+
+    xSemaphoreTake(telemetry_lock, portMAX_DELAY);
+    memcpy(raw[raw_head], value, sizeof(value));
+    raw_head = (raw_head + 1) % TELEMETRY_RAW_SIZE;
+    raw_count = MIN(raw_count + 1, TELEMETRY_RAW_SIZE);
+
+    for (int t = 0; t < TELEMETRY_TIER_NUM; t++) {
+        persist[t] = telemetry_tier_ingest(&tiers[t], now, value, &closed[t]);
+    }
+    xSemaphoreGive(telemetry_lock);
+
+    /* Flash writes happen outside the lock so chart queries are not held up */
+    for (int t = TELEMETRY_PERSIST_TIER_MIN; persist_ready && t < TELEMETRY_TIER_NUM; t++) {
+        if (persist[t] && closed[t].start >= TELEMETRY_TIME_VALID) {
+            telemetry_persist_write(t, &closed[t]);
+        }
+    }
+}
+
+esp_err_t app_telemetry_query(app_telemetry_channel_t channel, uint32_t range_s, app_telemetry_point_t *points, size_t num)
+{
+    int32_t sum[APP_TELEMETRY_QUERY_MAX_POINTS] = {0};
+
+    ESP_RETURN_ON_FALSE(channel < TELEMETRY_CH_NUM && points && num && num <= APP_TELEMETRY_QUERY_MAX_POINTS && range_s >= num,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(telemetry_lock, ESP_ERR_INVALID_STATE, TAG, "telemetry not initialized");
+
+    for (size_t i = 0; i < num; i++) {
+        points[i].min = INT16_MAX;
+        points[i].max = INT16_MIN;
+        points[i].count = 0;
+    }
+
+    int t = 0;
+    while (t < TELEMETRY_TIER_NUM - 1 && range_s / tiers[t].width_s > TELEMETRY_QUERY_MAX_BUCKETS) {
+        t++;
+    }
+    const telemetry_tier_t *tier = &tiers[t];
+
+    xSemaphoreTake(telemetry_lock, portMAX_DELAY);
+    uint32_t now = time(NULL);
+    uint32_t from = now - range_s;
+    uint32_t slot = range_s / num;
+
+    if (tier->open.count && tier->open.start >= from) {
+        size_t index = MIN((tier->open.start - from) / slot, num - 1);
+        const telemetry_accum_t *acc = &tier->open;
+        telemetry_point_merge(&points[index], &sum[index], acc->min[channel], acc->max[channel],
+                              acc->sum[channel] / acc->count, acc->count);
+    }
+
+    uint16_t visit = MIN(tier->count, range_s / tier->width_s + 1);
+    for (uint16_t i = 0; i < visit; i++) {
+        const telemetry_bucket_t *bucket = telemetry_tier_get(tier, i);
+        if (bucket->start < from) {
+            break;
+        }
+        size_t index = MIN((bucket->start - from) / slot, num - 1);
+        telemetry_point_merge(&points[index], &sum[index], bucket->min[channel], bucket->max[channel],
+                              bucket->avg[channel], bucket->count);
+    }
+    xSemaphoreGive(telemetry_lock);
+
+    for (size_t i = 0; i < num; i++) {
+        if (points[i].count) {
+            points[i].avg = sum[i] / points[i].count;
+        } else {
+            points[i].min = points[i].max = points[i].avg = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+size_t app_telemetry_get_raw(app_telemetry_channel_t channel, int16_t *samples, size_t max)
+{
+    if (!telemetry_lock || channel >= TELEMETRY_CH_NUM) {
+        return 0;
+    }
+
+    xSemaphoreTake(telemetry_lock, portMAX_DELAY);
+    size_t num = MIN(max, raw_count);
+    for (size_t i = 0; i < num; i++) {
+        samples[i] = raw[(raw_head + TELEMETRY_RAW_SIZE - num + i) % TELEMETRY_RAW_SIZE][channel];
+    }
+    xSemaphoreGive(telemetry_lock);
+    return num;
+}
+
+static void telemetry_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    float temperature, humidity;
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(APP_TELEMETRY_SAMPLE_PERIOD_MS));
+        if (ESP_OK == bsp_board_get_sensor_handle()->get_humiture(&temperature, &humidity)) {
+            app_telemetry_add_sample(time(NULL), temperature, humidity);
+        }
+    }
+}
+
+esp_err_t app_telemetry_init(bool persist)
+{
+    ESP_RETURN_ON_FALSE(!telemetry_lock, ESP_ERR_INVALID_STATE, TAG, "telemetry already initialized");
+
+    raw = heap_caps_calloc(TELEMETRY_RAW_SIZE, sizeof(raw[0]), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(raw, ESP_ERR_NO_MEM, TAG, "no mem for raw samples");
+    for (int t = 0; t < TELEMETRY_TIER_NUM; t++) {
+        tiers[t].buckets = heap_caps_calloc(tiers[t].size, sizeof(telemetry_bucket_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        ESP_RETURN_ON_FALSE(tiers[t].buckets, ESP_ERR_NO_MEM, TAG, "no mem for rollups");
+        telemetry_tier_clear(&tiers[t]);
+    }
+
+    if (persist) {
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, APP_TELEMETRY_PARTITION_LABEL);
+        if (!partition || partition->size < 2 * TELEMETRY_SECTOR_SIZE) {
+            ESP_LOGW(TAG, "no \"%s\" partition, history is kept in RAM only", APP_TELEMETRY_PARTITION_LABEL);
+            partition = NULL;
+        }
+    }
+
+    telemetry_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(telemetry_lock, ESP_ERR_NO_MEM, TAG, "no mem for lock");
+    BaseType_t ret = xTaskCreatePinnedToCore(telemetry_task, "telemetry", 1024 * 3, NULL, 2, NULL, 0);
+    ESP_RETURN_ON_FALSE(pdPASS == ret, ESP_ERR_NO_MEM, TAG, "create telemetry task failed");
+
+    ESP_LOGI(TAG, "history: %d raw, %d + %d + %d rollups", TELEMETRY_RAW_SIZE, tiers[0].size, tiers[1].size, tiers[2].size);
+    return ESP_OK;
+}
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define APP_TELEMETRY_SAMPLE_PERIOD_MS      2000
+#define APP_TELEMETRY_QUERY_MAX_POINTS      128
+#define APP_TELEMETRY_PARTITION_LABEL       "telemetry"
+
+typedef enum {
+    APP_TELEMETRY_TEMPERATURE,  /*!< 0.01 degree Celsius */
+    APP_TELEMETRY_HUMIDITY,     /*!< 0.01 %RH */
+    APP_TELEMETRY_CHANNEL_MAX,
+} app_telemetry_channel_t;
+
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t avg;
+    uint16_t count;             /*!< Raw samples behind this point, 0 if the slot has no data */
+} app_telemetry_point_t;
+
+/**
+ * @brief Allocate the history and start sampling the sensor bottom
+ *
+ * @param persist  Keep the 15 min and 1 h rollups in the "telemetry" partition, ignored if it doesn't exist
+ *
+ * @return
+ *      - ESP_OK            On success
+ *      - ESP_ERR_NO_MEM    Out of memory
+ */
+esp_err_t app_telemetry_init(bool persist);
+
+/**
+ * @brief Add one sample, normally called by the internal sampling task
+ */
+void app_telemetry_add_sample(time_t now, float temperature, float humidity);
+
+/**
+ * @brief Summarize the last `range_s` seconds into `num` equally wide points, oldest first
+ *
+ * Only the rollups are read. The finest rollup that keeps the number of buckets visited under
+ * 4 * APP_TELEMETRY_QUERY_MAX_POINTS is used, so the cost does not grow with the range.
+ *
+ * @param channel   Channel to query
+ * @param range_s   Time span ending now
+ * @param points    Output points
+ * @param num       Number of points, at most APP_TELEMETRY_QUERY_MAX_POINTS
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_ARG   Invalid argument
+ *      - ESP_ERR_INVALID_STATE Not initialized
+ */
+esp_err_t app_telemetry_query(app_telemetry_channel_t channel, uint32_t range_s, app_telemetry_point_t *points, size_t num);
+
+/**
+ * @brief Copy the newest raw samples, oldest first
+ *
+ * @return Number of samples copied
+ */
+size_t app_telemetry_get_raw(app_telemetry_channel_t channel, int16_t *samples, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -132,18 +132,14 @@ static void event_handler(void *arg, esp_event_base_t event_base,
         ip_event_got_ip_t *event = (ip_event_got_ip_t *) event_data;
         ESP_LOGI(TAG, "Connected with IP Address:" IPSTR, IP2STR(&event->ip_info.ip));
         s_connected = 1;
-        ui_acquire();
         ui_main_status_bar_set_wifi(s_connected);
-        ui_release();
         /* Signal main application to continue execution */
         xEventGroupSetBits(wifi_event_group, WIFI_STA_CONNECT_OK);
     } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGI(TAG, "Disconnected. Connecting to the AP again...");
         esp_wifi_connect();
         s_connected = 0;
-        ui_acquire();
         ui_main_status_bar_set_wifi(s_connected);
-        ui_release();
         ui_net_config_update_cb(UI_NET_EVT_START_CONNECT, NULL);
     }
 }
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include "esp_bit_defs.h"
+#include "boot_steps.h"
+
+#define STEP(_fn, _deps, _core, _ms, _kind) { .name = #_fn, .fn = boot_##_fn, .deps = (_deps), .core = (_core), \
+                                            .expect_ms = (_ms), .optional = (_kind) }
+#define CRITICAL    false
+#define OPTIONAL    true
+
+/*
+ * Expected durations are from a BOX-3 boot, a step that moves a lot should have its number updated
+ * so that the steps heading long chains keep starting first.
+ *
+ * Without a critical step there is no UI to show, app_main() stops on its failure. The demo still runs without
+ * the optional ones: no music, LED, voice commands or cloud.
+ */
+boot_seq_step_t boot_steps[BOOT_STEP_NUM] = {
+    [BOOT_STEP_NVS]             = STEP(nvs, 0, BOOT_SEQ_CORE_ANY, 30, CRITICAL),
+    [BOOT_STEP_SETTINGS]        = STEP(settings, BIT(BOOT_STEP_NVS), BOOT_SEQ_CORE_ANY, 5, CRITICAL),
+    [BOOT_STEP_SPIFFS]          = STEP(spiffs, 0, BOOT_SEQ_CORE_ANY, 150, OPTIONAL),
+    [BOOT_STEP_I2C]             = STEP(i2c, 0, BOOT_SEQ_CORE_ANY, 2, CRITICAL),
+    [BOOT_STEP_DISPLAY]         = STEP(display, BIT(BOOT_STEP_I2C), BOOT_SEQ_CORE_ANY, 250, CRITICAL),
+    /* Kept after the display as before, the display start of the BSP may set up the same buttons as input device */
+    [BOOT_STEP_BOARD]           = STEP(board, BIT(BOOT_STEP_I2C) | BIT(BOOT_STEP_DISPLAY), BOOT_SEQ_CORE_ANY, 120,
+                                       CRITICAL),
+    [BOOT_STEP_SENSOR_EVENTS]   = STEP(sensor_events, BIT(BOOT_STEP_SETTINGS) | BIT(BOOT_STEP_BOARD),
+                                       BOOT_SEQ_CORE_ANY, 2, CRITICAL),
+    [BOOT_STEP_TELEMETRY]       = STEP(telemetry, BIT(BOOT_STEP_NVS) | BIT(BOOT_STEP_BOARD), BOOT_SEQ_CORE_ANY, 20,
+                                       CRITICAL),
+    [BOOT_STEP_ASSETS]          = STEP(assets, 0, BOOT_SEQ_CORE_ANY, 2, CRITICAL),
+    [BOOT_STEP_UI]              = STEP(ui, BIT(BOOT_STEP_DISPLAY) | BIT(BOOT_STEP_BOARD) | BIT(BOOT_STEP_SETTINGS) |
+                                       BIT(BOOT_STEP_SENSOR_EVENTS) | BIT(BOOT_STEP_TELEMETRY) | BIT(BOOT_STEP_ASSETS),
+                                       BOOT_SEQ_CORE_ANY, 80, CRITICAL),
+    [BOOT_STEP_BACKLIGHT]       = STEP(backlight, BIT(BOOT_STEP_UI), BOOT_SEQ_CORE_ANY, 500, CRITICAL),
+    [BOOT_STEP_PLAYER]          = STEP(player, BIT(BOOT_STEP_SPIFFS) | BIT(BOOT_STEP_BOARD) | BIT(BOOT_STEP_SETTINGS),
+                                       BOOT_SEQ_CORE_ANY, 20, OPTIONAL),
+    [BOOT_STEP_LED]             = STEP(led, BIT(BOOT_STEP_BOARD), BOOT_SEQ_CORE_ANY, 2, OPTIONAL),
+    /* Loading the models takes long, keep it off core 1 where LVGL draws the boot animation */
+    [BOOT_STEP_SR]              = STEP(sr, BIT(BOOT_STEP_UI) | BIT(BOOT_STEP_PLAYER), 0, 1500, OPTIONAL),
+    [BOOT_STEP_RMAKER]          = STEP(rmaker, BIT(BOOT_STEP_NVS) | BIT(BOOT_STEP_BOARD), BOOT_SEQ_CORE_ANY, 50,
+                                       OPTIONAL),
+};
@@ -0,0 +1,60 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include "boot_seq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOOT_STEP_NVS,
+    BOOT_STEP_SETTINGS,
+    BOOT_STEP_SPIFFS,
+    BOOT_STEP_I2C,
+    BOOT_STEP_DISPLAY,
+    BOOT_STEP_BOARD,
+    BOOT_STEP_SENSOR_EVENTS,
+    BOOT_STEP_TELEMETRY,
+    BOOT_STEP_ASSETS,
+    BOOT_STEP_UI,
+    BOOT_STEP_BACKLIGHT,
+    BOOT_STEP_PLAYER,
+    BOOT_STEP_LED,
+    BOOT_STEP_SR,
+    BOOT_STEP_RMAKER,
+    BOOT_STEP_NUM,
+} boot_step_t;
+
+/**
+ * @brief Init steps of the demo in the order of boot_step_t, for boot_seq_run()
+ *
+ * Not const, so that the host simulation can change the expected durations.
+ */
+extern boot_seq_step_t boot_steps[BOOT_STEP_NUM];
+
+/* Implemented in main.c */
+esp_err_t boot_nvs(void *arg);
+esp_err_t boot_settings(void *arg);
+esp_err_t boot_spiffs(void *arg);
+esp_err_t boot_i2c(void *arg);
+esp_err_t boot_display(void *arg);
+esp_err_t boot_board(void *arg);
+esp_err_t boot_sensor_events(void *arg);
+esp_err_t boot_telemetry(void *arg);
+esp_err_t boot_assets(void *arg);
+esp_err_t boot_ui(void *arg);
+esp_err_t boot_backlight(void *arg);
+esp_err_t boot_player(void *arg);
+esp_err_t boot_led(void *arg);
+esp_err_t boot_sr(void *arg);
+esp_err_t boot_rmaker(void *arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <string.h>
+#include "esp_log.h"
+#include "ui_bind.h"
+
+#define UI_BIND_MAX     32
+
+static const char *TAG = "ui_bind";
+
+static ui_bind_t *s_binds[UI_BIND_MAX];
+static size_t s_bind_count;
+static atomic_uint s_dirty;
+static lv_timer_t *s_flush_timer;
+
+static void bind_apply(ui_bind_t *bind)
+{
+    lv_obj_t *obj = bind->obj;
+    if (NULL == obj) {
+        return;
+    }
+
+    /* seq_cst, see ui_bind_set() */
+    intptr_t value = atomic_load(&bind->value);
+    switch (bind->type) {
+    case UI_BIND_TYPE_TEXT_INT: {
+        /* Compare with the label itself, other code may still write to it */
+        char text[32];
+        lv_snprintf(text, sizeof(text), bind->fmt, (int) value);
+        if (strcmp(lv_label_get_text(obj), text)) {
+            lv_label_set_text(obj, text);
+        }
+        break;
+    }
+    case UI_BIND_TYPE_TEXT_STATIC: {
+        const char *text = (const char *) value;
+        if (text && strcmp(lv_label_get_text(obj), text)) {
+            lv_label_set_text_static(obj, text);
+        }
+        break;
+    }
+    case UI_BIND_TYPE_CUSTOM:
+        if (!bind->synced || bind->shown != value) {
+            bind->apply(obj, value);
+        }
+        break;
+    }
+    bind->shown = value;
+    bind->synced = true;
+}
+
+static void bind_delete_cb(lv_event_t *e)
+{
+    ui_bind_t *bind = (ui_bind_t *) lv_event_get_user_data(e);
+    bind->obj = NULL;
+    bind->synced = false;
+}
+
+static void flush_timer_cb(lv_timer_t *timer)
+{
+    ui_bind_flush();
+}
+
+void ui_bind_init(void)
+{
+    if (NULL == s_flush_timer) {
+        /* Newer timers run first, so values applied here are drawn by the refresh in the same pass */
+        s_flush_timer = lv_timer_create(flush_timer_cb, LV_DISP_DEF_REFR_PERIOD, NULL);
+    }
+}
+
+void ui_bind_attach(ui_bind_t *bind, lv_obj_t *obj)
+{
+    if (0 == atomic_load_explicit(&bind->slot, memory_order_relaxed)) {
+        if (s_bind_count >= UI_BIND_MAX) {
+            ESP_LOGE(TAG, "No free slot, raise UI_BIND_MAX");
+            return;
+        }
+        s_binds[s_bind_count++] = bind;
+        atomic_store(&bind->slot, s_bind_count);
+    }
+
+    if (bind->obj && bind->obj != obj) {
+        lv_obj_remove_event_cb_with_user_data(bind->obj, bind_delete_cb, bind);
+    }
+    if (bind->obj != obj) {
+        lv_obj_add_event_cb(obj, bind_delete_cb, LV_EVENT_DELETE, bind);
+    }
+    bind->obj = obj;
+    bind->synced = false;
+    bind_apply(bind);
+}
+
+void ui_bind_set(ui_bind_t *bind, intptr_t value)
+{
+    /*
+     * The value is stored then the slot loaded here, the slot stored then the value loaded in ui_bind_attach().
+     * All four are seq_cst so that at least one side sees the other: with release and acquire both loads may
+     * read the old values, the set is then neither applied by the attach nor marked dirty.
+     */
+    if (atomic_exchange(&bind->value, value) == value) {
+        return;
+    }
+
+    /* Unregistered binds pick the value up when attached */
+    unsigned slot = atomic_load(&bind->slot);
+    if (slot) {
+        atomic_fetch_or_explicit(&s_dirty, 1U << (slot - 1), memory_order_release);
+    }
+}
+
+void ui_bind_flush(void)
+{
+    unsigned dirty = atomic_exchange_explicit(&s_dirty, 0, memory_order_acquire);
+    while (dirty) {
+        bind_apply(s_binds[__builtin_ctz(dirty)]);
+        dirty &= dirty - 1;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UI_BIND_TYPE_TEXT_INT,      /* Integer shown in a label through fmt */
+    UI_BIND_TYPE_TEXT_STATIC,   /* Pointer to a string that outlives the label */
+    UI_BIND_TYPE_CUSTOM,        /* Any value, shown by apply */
+} ui_bind_type_t;
+
+typedef void (*ui_bind_apply_t)(lv_obj_t *obj, intptr_t value);
+
+/**
+ * @brief Value observed by one widget, declare it static with one of the UI_BIND_* initializers
+ *
+ * The bind outlives its widget: values set while the page is closed are shown once it is attached again.
+ */
+typedef struct {
+    ui_bind_type_t type;
+    union {
+        const char *fmt;
+        ui_bind_apply_t apply;
+    };
+    atomic_intptr_t value;
+    atomic_uint slot;           /* 1-based index in the dirty mask, 0 while unregistered */
+    lv_obj_t *obj;
+    intptr_t shown;
+    bool synced;
+} ui_bind_t;
+
+#define UI_BIND_TEXT_INT(fmt_)  { .type = UI_BIND_TYPE_TEXT_INT, .fmt = (fmt_) }
+#define UI_BIND_TEXT_STATIC()   { .type = UI_BIND_TYPE_TEXT_STATIC }
+#define UI_BIND_CUSTOM(apply_)  { .type = UI_BIND_TYPE_CUSTOM, .apply = (apply_) }
+
+/**
+ * @brief Start applying bound values once per display refresh period, call with the UI lock held
+ */
+void ui_bind_init(void);
+
+/**
+ * @brief Show the bind's value in obj from now on, call with the UI lock held
+ *
+ * @note The current value is applied right away, the bind is detached when obj is deleted
+ */
+void ui_bind_attach(ui_bind_t *bind, lv_obj_t *obj);
+
+/**
+ * @brief Set the value to show, from any task and without the UI lock
+ *
+ * @note Setting the value already held is free. Several sets within one refresh period
+ *       end up as a single widget update with the last value.
+ */
+void ui_bind_set(ui_bind_t *bind, intptr_t value);
+
+/**
+ * @brief Apply pending values now instead of at the next refresh period, call with the UI lock held
+ */
+void ui_bind_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
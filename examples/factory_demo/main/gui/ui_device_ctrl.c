@@ -7,6 +7,7 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "app_led.h"
 #include "app_fan.h"
 #include "app_switch.h"
@@ -15,17 +16,6 @@
 
 static const char *TAG = "ui_dev_ctrl";
 
-LV_FONT_DECLARE(font_en_16);
-
-LV_IMG_DECLARE(icon_fan_on)
-LV_IMG_DECLARE(icon_fan_off)
-LV_IMG_DECLARE(icon_light_on)
-LV_IMG_DECLARE(icon_light_off)
-LV_IMG_DECLARE(icon_switch_on)
-LV_IMG_DECLARE(icon_switch_off)
-LV_IMG_DECLARE(icon_air_on)
-LV_IMG_DECLARE(icon_air_off)
-
 static ui_dev_type_t g_active_dev_type = UI_DEV_LIGHT;
 static lv_obj_t *g_func_btn[4] = {NULL};
 static void (*g_dev_ctrl_end_cb)(void) = NULL;
@@ -33,15 +23,15 @@ static void (*g_dev_ctrl_end_cb)(void) = NULL;
 typedef struct {
     ui_dev_type_t type;
     const char *name;
-    lv_img_dsc_t const *img_on;
-    lv_img_dsc_t const *img_off;
+    const char *img_on;
+    const char *img_off;
 } btn_img_src_t;
 
 static const btn_img_src_t img_src_list[] = {
-    { .type = UI_DEV_LIGHT, .name = "Light", .img_on = &icon_light_on, .img_off = &icon_light_off },
-    { .type = UI_DEV_SWITCH, .name = "Switch", .img_on = &icon_switch_on, .img_off = &icon_switch_off },
-    { .type = UI_DEV_FAN, .name = "Fan", .img_on = &icon_fan_on, .img_off = &icon_fan_off },
-    { .type = UI_DEV_AIR, .name = "Air", .img_on = &icon_air_on, .img_off = &icon_air_off },
+    { .type = UI_DEV_LIGHT, .name = "Light", .img_on = "icon_light_on", .img_off = "icon_light_off" },
+    { .type = UI_DEV_SWITCH, .name = "Switch", .img_on = "icon_switch_on", .img_off = "icon_switch_off" },
+    { .type = UI_DEV_FAN, .name = "Fan", .img_on = "icon_fan_on", .img_off = "icon_fan_off" },
+    { .type = UI_DEV_AIR, .name = "Air", .img_on = "icon_air_on", .img_off = "icon_air_off" },
 };
 
 void ui_dev_ctrl_set_state(ui_dev_type_t type, bool state)
@@ -53,10 +43,10 @@ void ui_dev_ctrl_set_state(ui_dev_type_t type, bool state)
     lv_obj_t *img = (lv_obj_t *) g_func_btn[type]->user_data;
     if (state) {
         lv_obj_add_state(g_func_btn[type], LV_STATE_CHECKED);
-        lv_img_set_src(img, img_src_list[type].img_on);
+        lv_img_set_src(img, asset_pack_img(img_src_list[type].img_on));
     } else {
         lv_obj_clear_state(g_func_btn[type], LV_STATE_CHECKED);
-        lv_img_set_src(img, img_src_list[type].img_off);
+        lv_img_set_src(img, asset_pack_img(img_src_list[type].img_off));
     }
     ui_release();
 }
@@ -156,14 +146,14 @@ void ui_device_ctrl_start(void (*fn)(void))
         lv_obj_align(g_func_btn[i], LV_ALIGN_CENTER, i % 2 ? 48 : -48, i < 2 ? -48 - 3 : 48 - 3);
 
         lv_obj_t *img = lv_img_create(g_func_btn[i]);
-        lv_img_set_src(img, img_src_list[i].img_off);
+        lv_img_set_src(img, asset_pack_img(img_src_list[i].img_off));
         lv_obj_align(img, LV_ALIGN_CENTER, 0, -10);
         lv_obj_set_user_data(img, (void *) &img_src_list[i]);
 
         lv_obj_t *label = lv_label_create(g_func_btn[i]);
         lv_label_set_text_static(label, img_src_list[i].name);
         lv_obj_set_style_text_color(label, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-        lv_obj_set_style_text_font(label, &font_en_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(label, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
         lv_obj_align(label, LV_ALIGN_CENTER, 0, 20);
 
         lv_obj_set_user_data(g_func_btn[i], (void *) img);
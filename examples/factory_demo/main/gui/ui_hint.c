@@ -8,6 +8,7 @@
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 #include "settings.h"
 
@@ -17,9 +18,6 @@ static const char *TAG = "ui_hint";
 static lv_obj_t *g_hint_page_btn[HINT_PAGE_NUM] = {0};
 static void (*g_hint_end_cb)(void) = NULL;
 
-LV_FONT_DECLARE(font_en_16);
-LV_FONT_DECLARE(font_cn_gb1_16);
-
 static void hint_page_btn_next_cb(void *arg, void *data)
 {
     lv_obj_t *obj = (lv_obj_t *) data;
@@ -60,8 +58,6 @@ void ui_hint_start(void (*fn)(void))
 
     /*Create a Tab view object*/
     lv_obj_t *tabview = lv_tabview_create(lv_scr_act(), LV_DIR_TOP, 0);
-    LV_IMG_DECLARE(hand_down);
-    LV_IMG_DECLARE(hand_left);
     lv_obj_t *hint_page = NULL;
 
     /*Add content to the tabs*/
@@ -89,7 +85,7 @@ void ui_hint_start(void (*fn)(void))
         lv_obj_set_style_text_align(lab_hint, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
         lv_obj_align(lab_hint, LV_ALIGN_CENTER, 100 * i - 100, -10);
         img = lv_img_create(hint_page);
-        lv_img_set_src(img, &hand_down);
+        lv_img_set_src(img, asset_pack_img("hand_down"));
         lv_obj_align_to(img, lab_hint, LV_ALIGN_BOTTOM_MID, 0, 60);
     }
 
@@ -108,7 +104,7 @@ void ui_hint_start(void (*fn)(void))
     lv_obj_set_style_text_align(lab_hint, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
     lv_obj_align(lab_hint, LV_ALIGN_CENTER, 0, -10);
     img = lv_img_create(hint_page);
-    lv_img_set_src(img, &hand_down);
+    lv_img_set_src(img, asset_pack_img("hand_down"));
     lv_obj_align_to(img, lab_hint, LV_ALIGN_BOTTOM_MID, 0, 60);
 #endif
 
@@ -140,7 +136,7 @@ void ui_hint_start(void (*fn)(void))
     hint_page = lv_tabview_add_tab(tabview, "Tab 2");
     lv_obj_set_scrollbar_mode(hint_page, LV_SCROLLBAR_MODE_OFF);
     img = lv_img_create(hint_page);
-    lv_img_set_src(img, &hand_left);
+    lv_img_set_src(img, asset_pack_img("hand_left"));
     lv_obj_align(img, LV_ALIGN_TOP_LEFT, 0, 0);
     lv_obj_t *lab_btn_name = lv_label_create(hint_page);
     lv_label_set_recolor(lab_btn_name, true);
@@ -151,7 +147,7 @@ void ui_hint_start(void (*fn)(void))
     lv_obj_align_to(lab_hint, lab_btn_name, LV_ALIGN_OUT_BOTTOM_LEFT, 0, 0);
 
     img = lv_img_create(hint_page);
-    lv_img_set_src(img, &hand_left);
+    lv_img_set_src(img, asset_pack_img("hand_left"));
     lv_obj_align(img, LV_ALIGN_BOTTOM_LEFT, 0, 0);
     lab_btn_name = lv_label_create(hint_page);
     lv_label_set_recolor(lab_btn_name, true);
@@ -191,7 +187,7 @@ void ui_hint_start(void (*fn)(void))
 
     lv_obj_t *label_title = lv_label_create(hint_page);
     lv_obj_set_style_text_color(label_title, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(label_title, &font_en_16, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(label_title, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
     lv_label_set_recolor(label_title, true);
     lv_label_set_text_static(label_title, "#000000 Steps for Voice Assistant#");
     lv_obj_align(label_title, LV_ALIGN_TOP_MID, 0, 50);
@@ -202,13 +198,13 @@ void ui_hint_start(void (*fn)(void))
     lv_obj_set_style_text_color(label_hint, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
     const sys_param_t *param = settings_get_parameter();
     if (SR_LANG_EN == param->sr_lang) {
-        lv_obj_set_style_text_font(label_hint, &font_en_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(label_hint, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
         static const char msg[] = "1: Say \"Hi E. S. P.\" to wake-up the device.\n"
                                   "2: Wait for the \"Hi ESP\" shows on screen.\n"
                                   "3: Say command, like \"turn on the light\".";
         lv_label_set_text_static(label_hint, msg);
     } else {
-        lv_obj_set_style_text_font(label_hint, &font_cn_gb1_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(label_hint, asset_pack_font("font_cn_gb1_16"), LV_STATE_DEFAULT);
         static const char msg[] = "1: Say \"Hi 乐鑫\" to wake-up the device.\n"
                                   "2: Wait for the \"Hi 乐鑫\" shows on screen.\n"
                                   "3: Say command, like \"打开电灯\".";
@@ -244,7 +240,7 @@ void ui_hint_start(void (*fn)(void))
 
     label_title = lv_label_create(hint_page);
     lv_obj_set_style_text_color(label_title, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(label_title, &font_en_16, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(label_title, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
     lv_label_set_recolor(label_title, true);
     lv_label_set_text_static(label_title, "#000000 Default Command Words:#");
     lv_obj_align(label_title, LV_ALIGN_TOP_LEFT, 0, 30);
@@ -252,14 +248,14 @@ void ui_hint_start(void (*fn)(void))
     lv_obj_t *label_cmd_hint = lv_label_create(hint_page);
     lv_label_set_recolor(label_cmd_hint, true);
     if (SR_LANG_EN == param->sr_lang) {
-        lv_obj_set_style_text_font(label_cmd_hint, &font_en_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(label_cmd_hint, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
         static const char cmd_msg[] = "\"Turn on the light\", \"Switch off the light\"\n"
                                       "\"Turn Red\", \"Turn Green\", \"Turn Blue\"\n"
                                       "\"Sing a song\", \"Next Song\"\n"
                                       "\"Pause Playing\"";
         lv_label_set_text_static(label_cmd_hint, cmd_msg);
     } else {
-        lv_obj_set_style_text_font(label_cmd_hint, &font_cn_gb1_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(label_cmd_hint, asset_pack_font("font_cn_gb1_16"), LV_STATE_DEFAULT);
         static const char cmd_msg[] = "\"打开电灯\", 关闭电灯\"\n"
                                       "\"调成红色\", 调成绿色\", 调成蓝色\"\n"
                                       "\"播放音乐\", 切歌\", 暂停播放";
@@ -13,11 +13,14 @@
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "lvgl.h"
+#include "asset_pack.h"
+#include "lvgl_prof.h"
 #include "lv_symbol_extra_def.h"
 #include "app_wifi.h"
 #include "app_rmaker.h"
 #include "settings.h"
 #include "ui_main.h"
+#include "ui_bind.h"
 #include "ui_sr.h"
 #include "ui_mute.h"
 #include "ui_hint.h"
@@ -30,8 +33,6 @@
 
 static const char *TAG = "ui_main";
 
-LV_FONT_DECLARE(font_icon_16);
-
 static int g_item_index = 0;
 static lv_group_t *g_btn_op_group = NULL;
 static button_style_t g_btn_styles;
@@ -41,8 +42,8 @@ static lv_obj_t *g_page_menu = NULL;
  * If you wish to call *any* lvgl function from other threads/tasks
  * you should lock on the very same semaphore! */
 SemaphoreHandle_t g_guisemaphore;
-static lv_obj_t *g_lab_wifi = NULL;
-static lv_obj_t *g_lab_cloud = NULL;
+static ui_bind_t g_wifi_bind = UI_BIND_TEXT_STATIC();
+static ui_bind_t g_cloud_bind = UI_BIND_TEXT_STATIC();
 static lv_obj_t *g_status_bar = NULL;
 
 static void ui_main_menu(int32_t index_id);
@@ -136,16 +137,12 @@ lv_obj_t *ui_main_get_status_bar(void)
 
 void ui_main_status_bar_set_wifi(bool is_connected)
 {
-    if (g_lab_wifi) {
-        lv_label_set_text_static(g_lab_wifi, is_connected ? LV_SYMBOL_WIFI : LV_SYMBOL_EXTRA_WIFI_OFF);
-    }
+    ui_bind_set(&g_wifi_bind, (intptr_t)(is_connected ? LV_SYMBOL_WIFI : LV_SYMBOL_EXTRA_WIFI_OFF));
 }
 
 void ui_main_status_bar_set_cloud(bool is_connected)
 {
-    if (g_lab_cloud) {
-        lv_label_set_text_static(g_lab_cloud, is_connected ? LV_SYMBOL_EXTRA_CLOUD_CHECK : "  ");
-    }
+    ui_bind_set(&g_cloud_bind, (intptr_t)(is_connected ? LV_SYMBOL_EXTRA_CLOUD_CHECK : "  "));
 }
 
 static void hint_end_cb(void)
@@ -198,27 +195,20 @@ static void ui_help(void (*fn)(void))
 
 typedef struct {
     char *name;
-    void *img_src;
+    const char *img_name;
     void (*start_fn)(void (*fn)(void));
     void (*end_fn)(void);
 } item_desc_t;
 
-LV_IMG_DECLARE(icon_about_us)
-LV_IMG_DECLARE(icon_sensor_monitor)
-LV_IMG_DECLARE(icon_dev_ctrl)
-LV_IMG_DECLARE(icon_media_player)
-LV_IMG_DECLARE(icon_help)
-LV_IMG_DECLARE(icon_network)
-
 static item_desc_t item[] = {
 #if CONFIG_BSP_BOARD_ESP32_S3_BOX_3
-    { "Sensor Monitor", (void *) &icon_sensor_monitor,  ui_sensor_monitor_start, sensor_monitor_end_cb},
+    { "Sensor Monitor", "icon_sensor_monitor", ui_sensor_monitor_start, sensor_monitor_end_cb},
 #endif
-    { "Device Control", (void *) &icon_dev_ctrl,        ui_device_ctrl_start, dev_ctrl_end_cb},
-    { "Network",        (void *) &icon_network,         ui_net_config_start, net_end_cb},
-    { "Media Player",   (void *) &icon_media_player,    ui_media_player, player_end_cb},
-    { "Help",           (void *) &icon_help,            ui_help, NULL},
-    { "About Us",       (void *) &icon_about_us,        ui_about_us_start, about_us_end_cb},
+    { "Device Control", "icon_dev_ctrl",       ui_device_ctrl_start, dev_ctrl_end_cb},
+    { "Network",        "icon_network",        ui_net_config_start, net_end_cb},
+    { "Media Player",   "icon_media_player",   ui_media_player, player_end_cb},
+    { "Help",           "icon_help",           ui_help, NULL},
+    { "About Us",       "icon_about_us",       ui_about_us_start, about_us_end_cb},
 };
 
 static lv_obj_t *g_img_btn, *g_img_item = NULL;
@@ -284,7 +274,7 @@ void menu_new_item_select(lv_obj_t *obj)
     g_item_index = menu_get_num_offset(g_item_index, g_item_size, direct);
 
     lv_led_on(g_led_item[g_item_index]);
-    lv_img_set_src(g_img_item, item[g_item_index].img_src);
+    lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
     lv_label_set_text_static(g_lab_item, item[g_item_index].name);
 }
 
@@ -327,7 +317,7 @@ static void menu_prev_cb(lv_event_t *e)
         }
         g_item_index--;
         lv_led_on(g_led_item[g_item_index]);
-        lv_img_set_src(g_img_item, item[g_item_index].img_src);
+        lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
         lv_label_set_text_static(g_lab_item, item[g_item_index].name);
     }
 }
@@ -343,7 +333,7 @@ static void menu_next_cb(lv_event_t *e)
             g_item_index = 0;
         }
         lv_led_on(g_led_item[g_item_index]);
-        lv_img_set_src(g_img_item, item[g_item_index].img_src);
+        lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
         lv_label_set_text_static(g_lab_item, item[g_item_index].name);
     }
 }
@@ -412,7 +402,7 @@ static void ui_main_menu(int32_t index_id)
     lv_obj_add_event_cb(g_img_btn, menu_enter_cb, LV_EVENT_ALL, g_img_btn);
 
     g_img_item = lv_img_create(g_img_btn);
-    lv_img_set_src(g_img_item, item[index_id].img_src);
+    lv_img_set_src(g_img_item, asset_pack_img(item[index_id].img_name));
     lv_obj_center(g_img_item);
 
     g_lab_item = lv_label_create(obj);
@@ -510,19 +500,27 @@ static void ui_after_boot(void)
     }
 }
 
+static void clock_apply(lv_obj_t *lab_time, intptr_t minute_of_day)
+{
+    lv_label_set_text_fmt(lab_time, "%02u:%02u", (unsigned)(minute_of_day / 60), (unsigned)(minute_of_day % 60));
+}
+
+static ui_bind_t g_clock_bind = UI_BIND_CUSTOM(clock_apply);
+
 static void clock_run_cb(lv_timer_t *timer)
 {
-    lv_obj_t *lab_time = (lv_obj_t *) timer->user_data;
     time_t now;
     struct tm timeinfo;
     time(&now);
     localtime_r(&now, &timeinfo);
-    lv_label_set_text_fmt(lab_time, "%02u:%02u", timeinfo.tm_hour, timeinfo.tm_min);
+    /* Ticks every second but only shows minutes, the label is rewritten once a minute */
+    ui_bind_set(&g_clock_bind, timeinfo.tm_hour * 60 + timeinfo.tm_min);
 }
 
 esp_err_t ui_main_start(void)
 {
     ui_acquire();
+    ui_bind_init();
     lv_obj_set_style_bg_color(lv_scr_act(), lv_color_make(237, 238, 239), LV_STATE_DEFAULT);
     ui_button_style_init();
 
@@ -552,15 +550,19 @@ esp_err_t ui_main_start(void)
     lv_obj_t *lab_time = lv_label_create(g_status_bar);
     lv_label_set_text_static(lab_time, "23:59");
     lv_obj_align(lab_time, LV_ALIGN_LEFT_MID, 0, 0);
-    lv_timer_t *timer = lv_timer_create(clock_run_cb, 1000, (void *) lab_time);
+    lvgl_prof_set_name(lab_time, "clock");
+    lv_timer_t *timer = lv_timer_create(clock_run_cb, 1000, NULL);
     clock_run_cb(timer);
+    ui_bind_attach(&g_clock_bind, lab_time);
 
-    g_lab_wifi = lv_label_create(g_status_bar);
-    lv_obj_align_to(g_lab_wifi, lab_time, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    lv_obj_t *lab_wifi = lv_label_create(g_status_bar);
+    lv_obj_align_to(lab_wifi, lab_time, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
+    ui_bind_attach(&g_wifi_bind, lab_wifi);
 
-    g_lab_cloud = lv_label_create(g_status_bar);
-    lv_obj_set_style_text_font(g_lab_cloud, &font_icon_16, LV_PART_MAIN);
-    lv_obj_align_to(g_lab_cloud, g_lab_wifi, LV_ALIGN_OUT_RIGHT_MID, 5, 0);
+    lv_obj_t *lab_cloud = lv_label_create(g_status_bar);
+    lv_obj_set_style_text_font(lab_cloud, asset_pack_font("font_icon_16"), LV_PART_MAIN);
+    lv_obj_align_to(lab_cloud, lab_wifi, LV_ALIGN_OUT_RIGHT_MID, 5, 0);
+    ui_bind_attach(&g_cloud_bind, lab_cloud);
 
     ui_status_bar_set_visible(0);
 
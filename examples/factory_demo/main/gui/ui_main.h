@@ -28,6 +28,7 @@ void ui_release(void);
 lv_group_t *ui_get_btn_op_group(void);
 button_style_t *ui_button_styles(void);
 lv_obj_t *ui_main_get_status_bar(void);
+/* The status bar setters may be called from any task without ui_acquire() */
 void ui_main_status_bar_set_wifi(bool is_connected);
 void ui_main_status_bar_set_cloud(bool is_connected);
 
@@ -7,9 +7,13 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "audio_player.h"
+#include "audio_readahead.h"
 #include "file_iterator.h"
 #include "lvgl.h"
+#include "asset_pack.h"
+#include "lvgl_prof.h"
 #include "ui_main.h"
+#include "ui_bind.h"
 #include "settings.h"
 
 static const char *TAG = "ui_player";
@@ -18,6 +22,9 @@ static bool g_media_is_playing = false;
 lv_obj_t *g_lab_file = NULL;
 static void (*g_player_end_cb)(void) = NULL;
 lv_obj_t *lab_play_pause = NULL;
+/* All writes to the two labels go through the binds, so a set of the value already shown is skipped safely */
+static ui_bind_t g_file_bind = UI_BIND_TEXT_STATIC();
+static ui_bind_t g_play_pause_bind = UI_BIND_TEXT_STATIC();
 
 extern file_iterator_instance_t *file_iterator;
 lv_obj_t *player_page = NULL;
@@ -60,7 +67,7 @@ static void play_present()
         audio_player_resume();
     } else {
         file_iterator_get_full_path_from_index(file_iterator, file_iterator_get_index(file_iterator), filename, sizeof(filename));
-        FILE *fp = fopen(filename, "rb");
+        FILE *fp = audio_readahead_open(filename, NULL);
         if (!fp) {
             ESP_LOGE(TAG, "unable to open '%s'", filename);
             return;
@@ -71,16 +78,14 @@ static void play_present()
 
 static void ui_player_page_pause_click_cb(lv_event_t *e)
 {
-    lv_obj_t *obj = lv_event_get_user_data(e);
-
     if (g_media_is_playing) {
         audio_player_pause();
         g_media_is_playing = false;
-        lv_label_set_text_static(obj, LV_SYMBOL_PLAY);
+        ui_bind_set(&g_play_pause_bind, (intptr_t) LV_SYMBOL_PLAY);
     } else {
         play_present();
         g_media_is_playing = true;
-        lv_label_set_text_static(obj, LV_SYMBOL_PAUSE);
+        ui_bind_set(&g_play_pause_bind, (intptr_t) LV_SYMBOL_PAUSE);
     }
 }
 
@@ -89,7 +94,7 @@ static void ui_player_page_prev_click_cb(lv_event_t *e)
     lv_obj_t *obj = lv_event_get_user_data(e);
     file_iterator_prev(file_iterator);
     play_present();
-    lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
+    ui_bind_set(&g_file_bind, (intptr_t) file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
     lv_event_t event = {
         .user_data = obj,
     };
@@ -102,7 +107,7 @@ static void ui_player_page_next_click_cb(lv_event_t *e)
     lv_obj_t *obj = lv_event_get_user_data(e);
     file_iterator_next(file_iterator);
     play_present();
-    lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
+    ui_bind_set(&g_file_bind, (intptr_t) file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
     lv_event_t event = {
         .user_data = obj,
     };
@@ -145,36 +150,20 @@ static void audio_cb(audio_player_cb_ctx_t *ctx)
         return;
     }
 
-    if (AUDIO_PLAYER_CALLBACK_EVENT_IDLE == ctx->audio_event) {
+    switch (ctx->audio_event) {
+    case AUDIO_PLAYER_CALLBACK_EVENT_IDLE:
+    case AUDIO_PLAYER_CALLBACK_EVENT_PAUSE:
         g_media_is_playing = false;
-        ui_acquire();
-        lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
-        if (lab_play_pause) {
-            lv_label_set_text_static(lab_play_pause, LV_SYMBOL_PLAY);
-        }
-        ui_release();
-    }
-
-    if ((AUDIO_PLAYER_CALLBACK_EVENT_PLAYING == ctx->audio_event) ||
-            (AUDIO_PLAYER_CALLBACK_EVENT_COMPLETED_PLAYING_NEXT == ctx->audio_event)) {
+        break;
+    case AUDIO_PLAYER_CALLBACK_EVENT_PLAYING:
+    case AUDIO_PLAYER_CALLBACK_EVENT_COMPLETED_PLAYING_NEXT:
         g_media_is_playing = true;
-        ui_acquire();
-        lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
-        if (lab_play_pause) {
-            lv_label_set_text_static(lab_play_pause, LV_SYMBOL_PAUSE);
-        }
-        ui_release();
-    }
-
-    if (AUDIO_PLAYER_CALLBACK_EVENT_PAUSE == ctx->audio_event) {
-        g_media_is_playing = false;
-        ui_acquire();
-        lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
-        if (lab_play_pause) {
-            lv_label_set_text_static(lab_play_pause, LV_SYMBOL_PLAY);
-        }
-        ui_release();
+        break;
+    default:
+        return;
     }
+    ui_bind_set(&g_file_bind, (intptr_t) file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
+    ui_bind_set(&g_play_pause_bind, (intptr_t)(g_media_is_playing ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY));
 }
 
 void ui_media_player(void (*fn)(void))
@@ -182,6 +171,7 @@ void ui_media_player(void (*fn)(void))
     g_player_end_cb = fn;
     lv_obj_t *page = lv_obj_create(lv_scr_act());
     player_page = page;
+    lvgl_prof_set_name(page, "player");
     lv_obj_set_size(page, lv_obj_get_width(lv_obj_get_parent(page)), lv_obj_get_height(lv_obj_get_parent(page)) - lv_obj_get_height(ui_main_get_status_bar()));
     lv_obj_set_style_border_width(page, 0, LV_PART_MAIN);
     lv_obj_set_style_bg_color(page, lv_obj_get_style_bg_color(lv_scr_act(), LV_STATE_DEFAULT), LV_PART_MAIN);
@@ -204,13 +194,13 @@ void ui_media_player(void (*fn)(void))
     bsp_btn_register_callback(BSP_BUTTON_MAIN, BUTTON_PRESS_UP, btn_return_down_cb, (void *)btn_return);
 #endif
 
-    LV_IMG_DECLARE(img_music)
     lv_obj_t *img = lv_img_create(page);
-    lv_img_set_src(img, &img_music);
+    lv_img_set_src(img, asset_pack_img("img_music"));
     lv_obj_align(img, LV_ALIGN_TOP_RIGHT, -10, 35);
 
     g_lab_file = lv_label_create(page);
-    lv_label_set_text_static(g_lab_file, file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
+    ui_bind_set(&g_file_bind, (intptr_t) file_iterator_get_name_from_index(file_iterator, file_iterator_get_index(file_iterator)));
+    ui_bind_attach(&g_file_bind, g_lab_file);
     lv_obj_set_size(g_lab_file, 250, 32);
     lv_obj_set_style_text_font(g_lab_file, &lv_font_montserrat_24, LV_STATE_DEFAULT);
     lv_label_set_long_mode(g_lab_file, LV_LABEL_LONG_SCROLL_CIRCULAR);
@@ -233,11 +223,8 @@ void ui_media_player(void (*fn)(void))
     lv_obj_align(btn_play_pause, LV_ALIGN_CENTER, 0, 0);
     lab_play_pause = lv_label_create(btn_play_pause);
     g_media_is_playing = (audio_player_get_state() == AUDIO_PLAYER_STATE_PLAYING);
-    if (g_media_is_playing) {
-        lv_label_set_text_static(lab_play_pause, LV_SYMBOL_PAUSE);
-    } else {
-        lv_label_set_text_static(lab_play_pause, LV_SYMBOL_PLAY);
-    }
+    ui_bind_set(&g_play_pause_bind, (intptr_t)(g_media_is_playing ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY));
+    ui_bind_attach(&g_play_pause_bind, lab_play_pause);
     lv_obj_set_style_text_color(lab_play_pause, lv_color_make(158, 158, 158), LV_STATE_DEFAULT);
     lv_obj_center(lab_play_pause);
     lv_obj_add_event_cb(btn_play_pause, ui_player_page_pause_click_cb, LV_EVENT_CLICKED, lab_play_pause);
@@ -5,24 +5,35 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include <sys/param.h>
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "settings.h"
 
 #include "lvgl.h"
+#include "asset_pack.h"
+#include "lvgl_prof.h"
 #include "app_led.h"
 #include "app_fan.h"
 #include "app_switch.h"
+#include "app_ir_tx.h"
+#include "app_ir_store.h"
+#include "app_telemetry.h"
 #include "ui_main.h"
+#include "ui_bind.h"
 #include "ui_sensor_monitor.h"
 
 #define TEST_MEMORY_LEAK_THRESHOLD      (-400)
 #define IR_RESOLUTION_HZ                1000000 // 1MHz resolution, 1 tick = 1us
 
 #define UPDATE_TIME_PERIOD              300
-#define POWER_ON_PATH                   BSP_SPIFFS_MOUNT_POINT"/my_learn_off.cfg"
-#define POWER_OFF_PATH                  BSP_SPIFFS_MOUNT_POINT"/my_learn_off.cfg"
+#define IR_LEGACY_CFG_PATH              BSP_SPIFFS_MOUNT_POINT"/my_learn_off.cfg"
+#define IR_DEVICE_AIR                   "air"
+#define IR_KEY_POWER_ON                 "power_on"
+#define IR_KEY_POWER_OFF                "power_off"
+#define HISTORY_POINTS                  60
+#define HISTORY_TEMP_OFFSET             300     // same self-heating correction as the live value, 0.01 degree
 
 #define IR_ERR_CHECK(con, err, format, ...) if (con) { \
             ESP_LOGE(TAG, format , ##__VA_ARGS__); \
@@ -31,8 +42,14 @@
 static const char *TAG = "ui_sensor_monitor";
 
 //IR learning
-static QueueHandle_t rmt_out_queue = NULL;
 static ir_learn_handle_t ir_learn_handle = NULL;
+/* The speech commands send from the SR task while the page rebuilds them, both under ir_tx_cmd_lock */
+static SemaphoreHandle_t ir_tx_cmd_lock = NULL;
+static app_ir_tx_cmd_handle_t ir_tx_cmd_on = NULL;
+static app_ir_tx_cmd_handle_t ir_tx_cmd_off = NULL;
+
+static void ir_learn_tx_done_cb(app_ir_tx_cmd_handle_t cmd, void *user_data);
+static void ir_learn_send_tx_cmd(app_ir_tx_cmd_handle_t *cmd, const char *name);
 
 struct ir_learn_list_head learn_off_head;
 struct ir_learn_list_head learn_on_head;
@@ -43,22 +60,6 @@ struct ir_learn_sub_list_head ir_leran_read_off;
 struct ir_learn_sub_list_head ir_leran_data_off;
 struct ir_learn_sub_list_head ir_leran_data_on;
 
-LV_FONT_DECLARE(font_en_12);
-LV_FONT_DECLARE(font_en_bold_10);
-LV_FONT_DECLARE(font_en_16);
-LV_FONT_DECLARE(font_en_22);
-LV_FONT_DECLARE(font_cn_gb1_16);
-LV_FONT_DECLARE(font_cn_gb2_16);
-
-LV_IMG_DECLARE(icon_temp)
-LV_IMG_DECLARE(icon_humidity)
-LV_IMG_DECLARE(icon_degree)
-LV_IMG_DECLARE(icon_percent)
-LV_IMG_DECLARE(icon_rader_on)
-LV_IMG_DECLARE(icon_rader_off)
-LV_IMG_DECLARE(icon_air_switch)
-LV_IMG_DECLARE(icon_esp_sensor_base)
-
 
 // static ui_sensor_monitor_img_type_t g_active_air_ctrl_btn_type = UI_AIR_SWITCH;
 
@@ -73,26 +74,26 @@ static uint8_t Hum = 0;
 typedef struct {
     ui_sensor_monitor_img_type_t type;
     const char *name;
-    lv_img_dsc_t const *img_on;
-    lv_img_dsc_t const *img_off;
+    const char *img_on;
+    const char *img_off;
 } btn_image_src_t;
 
 typedef struct {
     const char *name;
-    lv_img_dsc_t const *img;
+    const char *img;
 } image_src_t;
 
 static const btn_image_src_t air_ctrl_btn_src_list[] = {
-    { .type = UI_RADAR, .name = "Radar", .img_on = &icon_rader_on, .img_off = &icon_rader_off },
-    { .type = UI_AIR_SWITCH, .name = "Air Switch", .img_on = &icon_air_switch, .img_off = &icon_air_switch },
+    { .type = UI_RADAR, .name = "Radar", .img_on = "icon_rader_on", .img_off = "icon_rader_off" },
+    { .type = UI_AIR_SWITCH, .name = "Air Switch", .img_on = "icon_air_switch", .img_off = "icon_air_switch" },
 };
 
 static const image_src_t sensor_monitor_img_src_list[] = {
-    { .name = "Temp", .img = &icon_temp },
-    { .name = "Hum", .img = &icon_humidity },
-    { .name = "sensor base", .img = &icon_esp_sensor_base },
-    { .name = "degree", .img = &icon_degree },
-    { .name = "percent", .img = &icon_percent },
+    { .name = "Temp", .img = "icon_temp" },
+    { .name = "Hum", .img = "icon_humidity" },
+    { .name = "sensor base", .img = "icon_esp_sensor_base" },
+    { .name = "degree", .img = "icon_degree" },
+    { .name = "percent", .img = "icon_percent" },
 };
 
 typedef struct {
@@ -110,6 +111,16 @@ static lv_obj_t *temp_value_label;
 static lv_obj_t *hum_value_label;
 static lv_obj_t *radar_panel = NULL;
 static lv_obj_t *radar_image = NULL;
+
+static void radar_image_apply(lv_obj_t *img, intptr_t src)
+{
+    lv_img_set_src(img, (const void *) src);
+}
+
+/* Readings every UPDATE_TIME_PERIOD mostly repeat, the binds only redraw what changed */
+static ui_bind_t temp_bind = UI_BIND_TEXT_INT("%d");
+static ui_bind_t hum_bind = UI_BIND_TEXT_INT("%d");
+static ui_bind_t radar_image_bind = UI_BIND_CUSTOM(radar_image_apply);
 static lv_obj_t *radar_btn = NULL;
 static lv_obj_t *radar_btn_lab = NULL;
 static lv_obj_t *air_ctrl_panel = NULL;
@@ -124,6 +135,24 @@ static lv_obj_t *relearning_btn = NULL;
 static lv_obj_t *ac_switch_btn = NULL;
 static lv_obj_t *ac_switch_btn_lab = NULL;
 static lv_obj_t *ir_learning_settings_close_btn = NULL;
+static lv_obj_t *history_panel = NULL;
+static lv_obj_t *history_chart = NULL;
+static lv_obj_t *history_range_lab = NULL;
+static lv_obj_t *history_close_btn = NULL;
+static lv_obj_t *history_range_btn = NULL;
+static lv_chart_series_t *history_temp_ser = NULL;
+static lv_chart_series_t *history_hum_ser = NULL;
+static uint8_t history_range_index = 1;
+
+static const struct {
+    const char *name;
+    uint32_t range_s;
+} history_range_list[] = {
+    {"1h",  60 * 60},
+    {"24h", 24 * 60 * 60},
+    {"7d",  7 * 24 * 60 * 60},
+    {"30d", 30 * 24 * 60 * 60},
+};
 
 static lv_timer_t *timer_handle;
 static user_tips_info_t user_tips_info[3];
@@ -141,9 +170,7 @@ bool sensor_ir_learn_enable(void)
 esp_err_t ui_sensor_set_ac_poweroff(void)
 {
     if (!SLIST_EMPTY(&ir_leran_read_off)) {
-        if (rmt_out_queue) {
-            xQueueSendFromISR(rmt_out_queue, &ir_leran_read_off, 0);
-        }
+        ir_learn_send_tx_cmd(&ir_tx_cmd_off, "air_off");
         ui_acquire();
         if (AIR_SWITCH_REVERSE_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) {
             lv_label_set_text(ac_switch_btn_lab, "Turn off the air");
@@ -162,9 +189,7 @@ esp_err_t ui_sensor_set_ac_poweroff(void)
 esp_err_t ui_sensor_set_ac_poweron(void)
 {
     if (!SLIST_EMPTY(&ir_leran_read_on)) {
-        if (rmt_out_queue) {
-            xQueueSendFromISR(rmt_out_queue, &ir_leran_read_on, 0);
-        }
+        ir_learn_send_tx_cmd(&ir_tx_cmd_on, "air_on");
         ui_acquire();
         if (AIR_SWITCH_REVERSE_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) {
             lv_label_set_text(ac_switch_btn_lab, "Turn on the air");
@@ -184,6 +209,8 @@ esp_err_t sensor_task_state_event_init(void)
 {
     sensor_monitor_event_grp = xEventGroupCreate();
     ESP_RETURN_ON_FALSE(sensor_monitor_event_grp, ESP_ERR_NO_MEM, TAG, "event group init failed");
+    ir_tx_cmd_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(ir_tx_cmd_lock, ESP_ERR_NO_MEM, TAG, "ir tx lock init failed");
 
     sys_param_t *param = settings_get_parameter();
 
@@ -216,165 +243,83 @@ static void user_info_send(uint8_t num, char *tips, uint16_t next_delay)
     }
 }
 
-esp_err_t ir_learn_save_cfg(char *filepath, struct ir_learn_sub_list_head *cmd_list)
+static void ir_learn_load_cmd(void)
 {
-    esp_err_t ret = ESP_OK;
-
-    FILE *fp = fopen(filepath, "wb");
-    ESP_GOTO_ON_FALSE(fp, ESP_FAIL, err, TAG,  "Failed open file:%s", filepath);
-
-    uint8_t cmd_num = 0;
-    ir_learn_sub_list_t *sub_it;
-    SLIST_FOREACH(sub_it, cmd_list, next) {
-        cmd_num++;
+    esp_err_t ret = app_ir_store_load(IR_DEVICE_AIR, IR_KEY_POWER_ON, &ir_leran_read_on);
+    if (ret == ESP_OK) {
+        ESP_LOGD(TAG, "air_on ir-data read OK.");
     }
-    ESP_LOGD(TAG, "save cmd_num:%d", cmd_num);
-    fwrite(&cmd_num, 1, sizeof(cmd_num), fp);
-
-    cmd_num = 0;
-    SLIST_FOREACH(sub_it, cmd_list, next) {
-
-        uint32_t timediff = sub_it->timediff;
-        fwrite(&timediff, 1, sizeof(uint32_t), fp);
-
-        size_t symbol_num = sub_it->symbols.num_symbols;
-        fwrite(&symbol_num, 1, sizeof(size_t), fp);
-
-        ESP_LOGD(TAG, "save cmd :%d, symbols:%d", cmd_num++, symbol_num);
-        rmt_symbol_word_t *rmt_nec_symbols = sub_it->symbols.received_symbols;
-        fwrite(rmt_nec_symbols, 1, symbol_num * sizeof(rmt_symbol_word_t), fp);
+    ret = app_ir_store_load(IR_DEVICE_AIR, IR_KEY_POWER_OFF, &ir_leran_read_off);
+    if (ret == ESP_OK) {
+        ESP_LOGD(TAG, "air_off ir-data read OK.");
     }
-    fclose(fp);
-err:
-    return ret;
 }
 
-esp_err_t ir_learn_read_cfg(char *filepath, struct ir_learn_sub_list_head *cmd_list)
+static void ir_learn_store_init(void)
 {
-    esp_err_t ret = ESP_OK;
+    static bool store_initialized = false;
+    struct stat file_stat;
 
-    FILE *fp = fopen(filepath, "r");
-    ESP_GOTO_ON_FALSE(fp, ESP_FAIL, err, TAG,  "Failed open file:%s", filepath);
-
-    uint8_t total_cmd_num = 0;
-    fread(&total_cmd_num, 1, sizeof(total_cmd_num), fp);
-    ESP_LOGD(TAG, "total cmd_num:%d", total_cmd_num);
-
-    for (int i = 0; i < total_cmd_num; i++) {
-        uint32_t timediff;
-        fread(&timediff, 1, sizeof(uint32_t), fp);
-
-        rmt_rx_done_event_data_t symbols;
-        fread(&symbols.num_symbols, 1, sizeof(size_t), fp);
-        ESP_LOGD(TAG, "read cmd :%d, symbols:%d", i, symbols.num_symbols);
-        symbols.received_symbols = (rmt_symbol_word_t *)heap_caps_malloc(symbols.num_symbols * sizeof(rmt_symbol_word_t), \
-                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-        fread(symbols.received_symbols, 1, symbols.num_symbols * sizeof(rmt_symbol_word_t), fp);
-        ir_learn_add_sub_list_node(cmd_list, timediff, &symbols);
-        if (symbols.received_symbols) {
-            free(symbols.received_symbols);
+    if (store_initialized) {
+        return;
+    }
+    store_initialized = true;
+    app_ir_store_init(BSP_SPIFFS_MOUNT_POINT);
+
+    /* Former firmware kept one raw file, used for both power on and off */
+    if (stat(IR_LEGACY_CFG_PATH, &file_stat) == 0) {
+        if (ESP_OK == app_ir_store_import_legacy(IR_LEGACY_CFG_PATH, IR_DEVICE_AIR, IR_KEY_POWER_ON)
+                && ESP_OK == app_ir_store_import_legacy(IR_LEGACY_CFG_PATH, IR_DEVICE_AIR, IR_KEY_POWER_OFF)) {
+            remove(IR_LEGACY_CFG_PATH);
         }
     }
-    fclose(fp);
-err:
-    return ret;
 }
 
-static void ir_learn_test_tx_raw(struct ir_learn_sub_list_head *rmt_out)
+static void ir_learn_tx_done_cb(app_ir_tx_cmd_handle_t cmd, void *user_data)
 {
-    rmt_tx_channel_config_t tx_channel_cfg = {
-        .clk_src = RMT_CLK_SRC_DEFAULT,
-        .resolution_hz = IR_RESOLUTION_HZ,
-        .mem_block_symbols = 128, // amount of RMT symbols that the channel can store at a time
-        .trans_queue_depth = 4,  // number of transactions that allowed to pending in the background, this example won't queue multiple transactions, so queue depth > 1 is sufficient
-        .gpio_num = BSP_IR_TX_GPIO,
-        // .flags.with_dma = true,
-        // .flags.invert_out = true,
-    };
-    rmt_channel_handle_t tx_channel = NULL;
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_channel_cfg, &tx_channel));
-
-    rmt_carrier_config_t carrier_cfg = {
-        .duty_cycle = 0.33,
-        .frequency_hz = 38000, // 38KHz
-    };
-    ESP_ERROR_CHECK(rmt_apply_carrier(tx_channel, &carrier_cfg));
-
-    rmt_transmit_config_t transmit_config = {
-        .loop_count = 0, // no loop
-    };
-
-    ir_encoder_config_t nec_encoder_cfg = {
-        .resolution = IR_RESOLUTION_HZ,
-    };
-    rmt_encoder_handle_t nec_encoder = NULL;
-    ESP_ERROR_CHECK(ir_encoder_new(&nec_encoder_cfg, &nec_encoder));
-
-    ESP_ERROR_CHECK(rmt_enable(tx_channel));
-
-    ir_learn_sub_list_t *sub_it;
-    SLIST_FOREACH(sub_it, rmt_out, next) {
-        ESP_LOGD(TAG, "RMT out timediff:%" PRIu32 " ms, symbols:%03u",
-                 sub_it->timediff / 1000, sub_it->symbols.num_symbols);
-
-        vTaskDelay(pdMS_TO_TICKS(sub_it->timediff / 1000));
-
-        rmt_symbol_word_t *rmt_nec_symbols = sub_it->symbols.received_symbols;
-        size_t symbol_num = sub_it->symbols.num_symbols;
-
-        ESP_ERROR_CHECK(rmt_transmit(tx_channel, nec_encoder, rmt_nec_symbols, symbol_num, &transmit_config));
-        rmt_tx_wait_all_done(tx_channel, -1);
-    }
-
-    rmt_disable(tx_channel);
-    rmt_del_channel(tx_channel);
-    nec_encoder->del(nec_encoder);
+    ESP_LOGD(TAG, "%s ir-data sent.", (const char *)user_data);
 }
 
-static void ir_learn_test_tx_task(void *arg)
+static void ir_learn_send_tx_cmd(app_ir_tx_cmd_handle_t *cmd, const char *name)
 {
-    struct ir_learn_sub_list_head tx_data;
-
-    gpio_config_t io_conf = {};
-    io_conf.pin_bit_mask = BIT64(BSP_IR_CTRL_GPIO);
-    io_conf.mode = GPIO_MODE_OUTPUT;
-    io_conf.pull_up_en = true;
-    gpio_config(&io_conf);
-    gpio_set_level(BSP_IR_CTRL_GPIO, 0);//enable IR TX
-
-    rmt_out_queue = xQueueCreate(1, sizeof(rmt_rx_done_event_data_t));
-    if (NULL == rmt_out_queue) {
-        ESP_LOGW(TAG, "receive queue creation failed");
+    xSemaphoreTake(ir_tx_cmd_lock, portMAX_DELAY);
+    if (*cmd) {
+        app_ir_tx_send(*cmd, ir_learn_tx_done_cb, (void *)name);
     }
+    xSemaphoreGive(ir_tx_cmd_lock);
+}
 
-    if (IR_LEARNING_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) {
-        esp_err_t ret = ir_learn_read_cfg(POWER_ON_PATH, &ir_leran_read_on);
-        if (ret == ESP_OK) {
-            ESP_LOGD(TAG, "air_on ir-data read OK.");
-        }
-        ret = ir_learn_read_cfg(POWER_OFF_PATH, &ir_leran_read_off);
-        if (ret == ESP_OK) {
-            ESP_LOGD(TAG, "air_off ir-data read OK.");
-        }
-    }
+static void ir_learn_swap_tx_cmd(app_ir_tx_cmd_handle_t cmd_on, app_ir_tx_cmd_handle_t cmd_off)
+{
+    xSemaphoreTake(ir_tx_cmd_lock, portMAX_DELAY);
+    app_ir_tx_cmd_handle_t old_on = ir_tx_cmd_on;
+    app_ir_tx_cmd_handle_t old_off = ir_tx_cmd_off;
+    ir_tx_cmd_on = cmd_on;
+    ir_tx_cmd_off = cmd_off;
+    xSemaphoreGive(ir_tx_cmd_lock);
+
+    /* No new send can pick the old commands up, and deleting waits for the queued ones to leave the channel */
+    app_ir_tx_cmd_delete(old_on);
+    app_ir_tx_cmd_delete(old_off);
+}
 
-    xEventGroupClearBits(sensor_monitor_event_grp, NEED_DELETE);
+static void ir_learn_release_tx_cmd(void)
+{
+    ir_learn_swap_tx_cmd(NULL, NULL);
+}
 
-    while (1) {
-        if ((NEED_DELETE & xEventGroupGetBits(sensor_monitor_event_grp))) {
-            xEventGroupSetBits(sensor_monitor_event_grp, TX_CH_DELETED);
-            ESP_LOGD(TAG, "ir learn tx_task delete.");
-            if (rmt_out_queue) {
-                vQueueDelete(rmt_out_queue);
-                rmt_out_queue = NULL;
-            }
-            vTaskDelete(NULL);
-        }
+static void ir_learn_update_tx_cmd(void)
+{
+    app_ir_tx_cmd_handle_t cmd_on = NULL;
+    app_ir_tx_cmd_handle_t cmd_off = NULL;
 
-        if (xQueueReceive(rmt_out_queue, &tx_data, pdMS_TO_TICKS(500)) == pdPASS) {
-            ir_learn_test_tx_raw(&tx_data);
-        }
+    if (!SLIST_EMPTY(&ir_leran_read_on) && (ESP_OK == app_ir_tx_cmd_create(&ir_leran_read_on, &cmd_on))) {
+        ESP_LOGD(TAG, "air_on ir-data encoded.");
+    }
+    if (!SLIST_EMPTY(&ir_leran_read_off) && (ESP_OK == app_ir_tx_cmd_create(&ir_leran_read_off, &cmd_off))) {
+        ESP_LOGD(TAG, "air_off ir-data encoded.");
     }
+    ir_learn_swap_tx_cmd(cmd_on, cmd_off);
 }
 
 static void ir_learn_test_save_result(struct ir_learn_sub_list_head *data_save, struct ir_learn_sub_list_head *data_src)
@@ -453,16 +398,10 @@ static void ir_learn_learn_send_callback(ir_learn_state_t state, uint8_t sub_ste
             lv_obj_clear_flag(ac_switch_btn, LV_OBJ_FLAG_HIDDEN);
             ui_release();
 
-            ir_learn_save_cfg(POWER_ON_PATH, &ir_leran_data_on);
-            esp_err_t ret = ir_learn_read_cfg(POWER_ON_PATH, &ir_leran_read_on);
-            if (ret == ESP_OK) {
-                ESP_LOGD(TAG, "air_on ir-data read OK.");
-            }
-            ir_learn_save_cfg(POWER_OFF_PATH, &ir_leran_data_off);
-            ret = ir_learn_read_cfg(POWER_OFF_PATH, &ir_leran_read_off);
-            if (ret == ESP_OK) {
-                ESP_LOGD(TAG, "air_off ir-data read OK.");
-            }
+            app_ir_store_save(IR_DEVICE_AIR, IR_KEY_POWER_ON, &ir_leran_data_on);
+            app_ir_store_save(IR_DEVICE_AIR, IR_KEY_POWER_OFF, &ir_leran_data_off);
+            ir_learn_load_cmd();
+            ir_learn_update_tx_cmd();
             xEventGroupSetBits(sensor_monitor_event_grp, IR_LEARNING_STATE);
             ir_learn_stop(&ir_learn_handle);
             ir_learn_enable = false;
@@ -545,6 +484,7 @@ static void ui_sensor_monitor_page_return_click_cb(lv_event_t *e)
     ir_learn_clean_sub_data(&ir_leran_data_off);
     ir_learn_clean_sub_data(&ir_leran_read_on);
     ir_learn_clean_sub_data(&ir_leran_read_off);
+    ir_learn_release_tx_cmd();
     xEventGroupClearBits(sensor_monitor_event_grp, SENSOR_MONITOR_ALIVE_STATE);
 
     if (timer_handle) {
@@ -565,9 +505,6 @@ static void ui_sensor_monitor_page_return_click_cb(lv_event_t *e)
         ir_learn_enable = false;
     }
 
-    xEventGroupSetBits(sensor_monitor_event_grp, NEED_DELETE);
-    xEventGroupWaitBits(sensor_monitor_event_grp, NEED_DELETE | TX_CH_DELETED, 1, 1, portMAX_DELAY);
-
     lv_obj_t *obj = lv_event_get_user_data(e);
     if (ui_get_btn_op_group()) {
         lv_group_remove_all_objs(ui_get_btn_op_group());
@@ -656,8 +593,8 @@ static void update_timer_cb(lv_timer_t *timer)
      */
     esp_err_t ret = bsp_board_get_sensor_handle()->get_humiture(&temperature, &humidity);
     if (ret != ESP_OK) {
-        lv_label_set_text(temp_value_label, "0");
-        lv_label_set_text(hum_value_label, "0");
+        ui_bind_set(&temp_bind, 0);
+        ui_bind_set(&hum_bind, 0);
     } else {
         Temp = (uint8_t)temperature;
         float fractionalPart = temperature - Temp;
@@ -665,9 +602,7 @@ static void update_timer_cb(lv_timer_t *timer)
         if (fractionalPart > 0.5) {
             Temp++;
         }
-        char value_str[2] = {0};
-        sprintf(value_str, "%d", Temp);
-        lv_label_set_text(temp_value_label, value_str);
+        ui_bind_set(&temp_bind, Temp);
 
         Hum = (uint8_t)humidity;
         fractionalPart = humidity - Hum;
@@ -677,8 +612,7 @@ static void update_timer_cb(lv_timer_t *timer)
         if (Hum >= 100) {
             Hum = 99;
         }
-        sprintf(value_str, "%d", Hum);
-        lv_label_set_text(hum_value_label, value_str);
+        ui_bind_set(&hum_bind, Hum);
     }
 
     /**
@@ -688,12 +622,12 @@ static void update_timer_cb(lv_timer_t *timer)
         if (true == bsp_board_get_sensor_handle()->get_radar_status()) {
             xEventGroupSetBits(sensor_monitor_event_grp, RADAR_STATE);
             if (SENSOR_MONITOR_ALIVE_STATE & sensor_task_state_event_get_bits()) {
-                lv_img_set_src(radar_image, air_ctrl_btn_src_list[0].img_on);
+                ui_bind_set(&radar_image_bind, (intptr_t) asset_pack_img(air_ctrl_btn_src_list[0].img_on));
             }
         } else {
             xEventGroupClearBits(sensor_monitor_event_grp, RADAR_STATE);
             if (SENSOR_MONITOR_ALIVE_STATE & sensor_task_state_event_get_bits()) {
-                lv_img_set_src(radar_image, air_ctrl_btn_src_list[0].img_off);
+                ui_bind_set(&radar_image_bind, (intptr_t) asset_pack_img(air_ctrl_btn_src_list[0].img_off));
             }
         }
     }
@@ -719,7 +653,7 @@ static void ui_radar_btn_event(lv_event_t *e)
             lv_label_set_text(radar_btn_lab, "OFF");
             lv_obj_set_style_bg_color(radar_btn_lab, lv_color_hex(0x9E9E9E), LV_PART_MAIN | LV_STATE_DEFAULT);
             lv_obj_set_x(radar_btn_lab, -8);
-            lv_img_set_src(radar_image, air_ctrl_btn_src_list[0].img_off);
+            ui_bind_set(&radar_image_bind, (intptr_t) asset_pack_img(air_ctrl_btn_src_list[0].img_off));
         } else {
             lv_obj_set_style_border_color(radar_btn, lv_color_hex(0xEB4839), LV_PART_MAIN | LV_STATE_DEFAULT);
             lv_label_set_text(radar_btn_lab, "ON");
@@ -777,11 +711,13 @@ static void ui_sensor_monitor_relearn_btn_event(lv_event_t *e)
     ir_learn_clean_sub_data(&ir_leran_data_off);
     ir_learn_clean_sub_data(&ir_leran_read_on);
     ir_learn_clean_sub_data(&ir_leran_read_off);
+    ir_learn_release_tx_cmd();
 
-    if (remove(POWER_ON_PATH) == 0 && remove(POWER_OFF_PATH) == 0) {
-        ESP_LOGD(TAG, "remove file succes.\n");
+    if (app_ir_store_remove(IR_DEVICE_AIR, IR_KEY_POWER_ON) == ESP_OK
+            && app_ir_store_remove(IR_DEVICE_AIR, IR_KEY_POWER_OFF) == ESP_OK) {
+        ESP_LOGD(TAG, "remove ir-data succes.\n");
     } else {
-        ESP_LOGE(TAG, "remove file failed.\n");
+        ESP_LOGE(TAG, "remove ir-data failed.\n");
     }
     if (0 == (IR_LEARNING_STATE & xEventGroupGetBits(sensor_monitor_event_grp))) {
         ESP_LOGD(TAG, "ir_learn_stop.\n");
@@ -805,19 +741,129 @@ static void ir_learning_settings_close_event(lv_event_t *e)
     lv_obj_clear_flag(air_ctrl_panel, LV_OBJ_FLAG_HIDDEN);
 }
 
+static void ui_history_refresh(void)
+{
+    app_telemetry_point_t temp[HISTORY_POINTS], hum[HISTORY_POINTS];
+    uint32_t range_s = history_range_list[history_range_index].range_s;
+    int16_t temp_min = INT16_MAX, temp_max = INT16_MIN;
+
+    lv_label_set_text_static(history_range_lab, history_range_list[history_range_index].name);
+    if (ESP_OK != app_telemetry_query(APP_TELEMETRY_TEMPERATURE, range_s, temp, HISTORY_POINTS) ||
+            ESP_OK != app_telemetry_query(APP_TELEMETRY_HUMIDITY, range_s, hum, HISTORY_POINTS)) {
+        lv_chart_set_all_value(history_chart, history_temp_ser, LV_CHART_POINT_NONE);
+        lv_chart_set_all_value(history_chart, history_hum_ser, LV_CHART_POINT_NONE);
+        return;
+    }
+
+    for (int i = 0; i < HISTORY_POINTS; i++) {
+        if (temp[i].count) {
+            temp_min = MIN(temp_min, temp[i].min - HISTORY_TEMP_OFFSET);
+            temp_max = MAX(temp_max, temp[i].max - HISTORY_TEMP_OFFSET);
+        }
+        history_temp_ser->y_points[i] = temp[i].count ? temp[i].avg - HISTORY_TEMP_OFFSET : LV_CHART_POINT_NONE;
+        history_hum_ser->y_points[i] = hum[i].count ? hum[i].avg : LV_CHART_POINT_NONE;
+    }
+
+    /* Whole degrees around the data, at least 2 apart so a flat line stays readable */
+    if (temp_min <= temp_max) {
+        temp_min = (temp_min / 100 - 1) * 100;
+        temp_max = MAX((temp_max / 100 + 1) * 100, temp_min + 200);
+        lv_chart_set_range(history_chart, LV_CHART_AXIS_PRIMARY_Y, temp_min, temp_max);
+    }
+    lv_chart_refresh(history_chart);
+}
+
+static void ui_history_open_event(lv_event_t *e)
+{
+    lv_obj_clear_flag(history_panel, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(history_panel);
+    ui_history_refresh();
+}
+
+static void ui_history_range_event(lv_event_t *e)
+{
+    history_range_index = (history_range_index + 1) % (sizeof(history_range_list) / sizeof(history_range_list[0]));
+    ui_history_refresh();
+}
+
+static void ui_history_close_event(lv_event_t *e)
+{
+    lv_obj_add_flag(history_panel, LV_OBJ_FLAG_HIDDEN);
+}
+
+static void ui_history_create(lv_obj_t *page)
+{
+    history_panel = lv_obj_create(page);
+    lv_obj_set_size(history_panel, lv_pct(100), lv_pct(100));
+    lv_obj_center(history_panel);
+    lv_obj_clear_flag(history_panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_border_width(history_panel, 0, LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_color(history_panel, lv_obj_get_style_bg_color(page, LV_PART_MAIN), LV_PART_MAIN);
+    lv_obj_add_flag(history_panel, LV_OBJ_FLAG_HIDDEN);
+
+    history_close_btn = lv_btn_create(history_panel);
+    lv_obj_set_size(history_close_btn, 24, 24);
+    lv_obj_add_style(history_close_btn, &ui_button_styles()->style, 0);
+    lv_obj_add_style(history_close_btn, &ui_button_styles()->style_pr, LV_STATE_PRESSED);
+    lv_obj_add_style(history_close_btn, &ui_button_styles()->style_focus, LV_STATE_FOCUS_KEY);
+    lv_obj_add_style(history_close_btn, &ui_button_styles()->style_focus, LV_STATE_FOCUSED);
+    lv_obj_align(history_close_btn, LV_ALIGN_TOP_LEFT, 0, -8);
+    lv_obj_t *history_close_btn_text = lv_label_create(history_close_btn);
+    lv_label_set_text_static(history_close_btn_text, LV_SYMBOL_LEFT);
+    lv_obj_set_style_text_color(history_close_btn_text, lv_color_make(158, 158, 158), LV_STATE_DEFAULT);
+    lv_obj_center(history_close_btn_text);
+    lv_obj_add_event_cb(history_close_btn, ui_history_close_event, LV_EVENT_CLICKED, NULL);
+
+    history_range_btn = lv_btn_create(history_panel);
+    lv_obj_add_style(history_range_btn, &ui_button_styles()->style, 0);
+    lv_obj_add_style(history_range_btn, &ui_button_styles()->style_pr, LV_STATE_PRESSED);
+    lv_obj_add_style(history_range_btn, &ui_button_styles()->style_focus_no_outline, LV_STATE_FOCUS_KEY);
+    lv_obj_add_style(history_range_btn, &ui_button_styles()->style_focus_no_outline, LV_STATE_FOCUSED);
+    lv_obj_set_size(history_range_btn, LV_SIZE_CONTENT, 24);
+    lv_obj_align(history_range_btn, LV_ALIGN_TOP_RIGHT, 0, -8);
+    history_range_lab = lv_label_create(history_range_btn);
+    lv_obj_set_style_text_color(history_range_lab, lv_palette_main(LV_PALETTE_RED), LV_PART_MAIN);
+    lv_obj_center(history_range_lab);
+    lv_obj_add_event_cb(history_range_btn, ui_history_range_event, LV_EVENT_CLICKED, NULL);
+
+    lv_obj_t *legend_lab = lv_label_create(history_panel);
+    lv_label_set_recolor(legend_lab, true);
+    lv_label_set_text_static(legend_lab, "#CE244F Temperature#  #2196F3 Humidity#");
+    lv_obj_set_style_text_font(legend_lab, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
+    lv_obj_align(legend_lab, LV_ALIGN_TOP_MID, 0, 22);
+
+    history_chart = lv_chart_create(history_panel);
+    lv_obj_set_size(history_chart, lv_pct(100), 120);
+    lv_obj_align(history_chart, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_chart_set_type(history_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_point_count(history_chart, HISTORY_POINTS);
+    lv_chart_set_div_line_count(history_chart, 5, 0);
+    lv_chart_set_range(history_chart, LV_CHART_AXIS_SECONDARY_Y, 0, 10000);
+    lv_obj_set_style_size(history_chart, 0, LV_PART_INDICATOR);
+    history_temp_ser = lv_chart_add_series(history_chart, lv_color_hex(0xCE244F), LV_CHART_AXIS_PRIMARY_Y);
+    history_hum_ser = lv_chart_add_series(history_chart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_SECONDARY_Y);
+}
+
 void ui_sensor_monitor_start(void (*fn)(void))
 {
     ESP_LOGI(TAG, "sensor monitor initialize");
     g_sensor_monitor_end_cb = fn;
     const sys_param_t *param = settings_get_parameter();
-    struct stat file_stat;
-    if (stat(POWER_ON_PATH, &file_stat) == 0 && stat(POWER_OFF_PATH, &file_stat) == 0) {
+    ir_learn_store_init();
+    if (app_ir_store_exists(IR_DEVICE_AIR, IR_KEY_POWER_ON) && app_ir_store_exists(IR_DEVICE_AIR, IR_KEY_POWER_OFF)) {
         xEventGroupSetBits(sensor_monitor_event_grp, IR_LEARNING_STATE);
     } else {
         xEventGroupClearBits(sensor_monitor_event_grp, IR_LEARNING_STATE);
     }
 
-    xTaskCreatePinnedToCore(ir_learn_test_tx_task, "ir_learn_test_tx_task", 1024 * 4, NULL, 10, NULL, 1);
+    /* The TX channel stays alive across page visits, only the encoded commands are rebuilt */
+    if (ESP_OK != app_ir_tx_init()) {
+        ESP_LOGW(TAG, "ir tx init failed");
+    }
+    if (IR_LEARNING_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) {
+        ir_learn_load_cmd();
+        ir_learn_update_tx_cmd();
+    }
 
     user_info_queue = xQueueCreate(sizeof(user_tips_info) / sizeof(user_tips_info[0]), sizeof(user_tips_info_t));
     if (NULL == user_info_queue) {
@@ -836,6 +882,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     xEventGroupClearBits(sensor_monitor_event_grp, AIR_POWER_STATE);
     xEventGroupSetBits(sensor_monitor_event_grp, SENSOR_BASE_CONNECT_STATE);
     lv_obj_t *page = lv_obj_create(lv_scr_act());
+    lvgl_prof_set_name(page, "sensor");
     lv_obj_set_size(page, lv_obj_get_width(lv_obj_get_parent(page)), lv_obj_get_height(lv_obj_get_parent(page)) - lv_obj_get_height(ui_main_get_status_bar()));
     lv_obj_set_style_border_width(page, 0, LV_PART_MAIN);
     lv_obj_set_style_bg_color(page, lv_obj_get_style_bg_color(lv_scr_act(), LV_STATE_DEFAULT), LV_PART_MAIN);
@@ -861,7 +908,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_style_text_align(reversal_lab, LV_TEXT_ALIGN_LEFT, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_label_set_text(reversal_lab, "If the power button is reversed, click \"Reversal\" button below to fix it.");
     lv_obj_set_style_text_color(reversal_lab, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(reversal_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(reversal_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_align(reversal_lab, LV_ALIGN_CENTER, 20, -75);
     lv_obj_add_flag(reversal_lab, LV_OBJ_FLAG_HIDDEN);
 
@@ -875,7 +922,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_add_flag(air_switch_reversal_btn, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_event_cb(air_switch_reversal_btn, ui_sensor_monitor_air_switch_reversal_btn_event, LV_EVENT_CLICKED, page);
     lv_obj_t *air_switch_reversal_btn_lab = lv_label_create(air_switch_reversal_btn);
-    lv_obj_set_style_text_font(air_switch_reversal_btn_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(air_switch_reversal_btn_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_label_set_text(air_switch_reversal_btn_lab, "Reversal");
     lv_obj_set_style_text_color(air_switch_reversal_btn_lab, lv_palette_main(LV_PALETTE_RED), LV_PART_MAIN);
     lv_obj_center(air_switch_reversal_btn_lab);
@@ -886,7 +933,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_style_text_align(relearning_lab, LV_TEXT_ALIGN_LEFT, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_label_set_text(relearning_lab, "Click the \"Relearn\" button to clear learning history and start IR learning again.");
     lv_obj_set_style_text_color(relearning_lab, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(relearning_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(relearning_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_align(relearning_lab, LV_ALIGN_CENTER, 20, 20);
     lv_obj_add_flag(relearning_lab, LV_OBJ_FLAG_HIDDEN);
 
@@ -900,7 +947,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_add_flag(relearning_btn, LV_OBJ_FLAG_HIDDEN);
     lv_obj_add_event_cb(relearning_btn, ui_sensor_monitor_relearn_btn_event, LV_EVENT_CLICKED, page);
     lv_obj_t *relearning_btn_lab = lv_label_create(relearning_btn);
-    lv_obj_set_style_text_font(relearning_btn_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(relearning_btn_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_label_set_text(relearning_btn_lab, "Relearn");
     lv_obj_set_style_text_color(relearning_btn_lab, lv_palette_main(LV_PALETTE_RED), LV_PART_MAIN);
     lv_obj_center(relearning_btn_lab);
@@ -927,29 +974,33 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_style_border_width(temp_sensor_panel, 0, LV_STATE_DEFAULT);
     lv_obj_set_style_shadow_opa(temp_sensor_panel, LV_OPA_30, LV_STATE_DEFAULT);
     lv_obj_set_style_shadow_width(temp_sensor_panel, 10, LV_STATE_DEFAULT);
+    lv_obj_add_flag(temp_sensor_panel, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(temp_sensor_panel, ui_history_open_event, LV_EVENT_CLICKED, NULL);
     lv_obj_t *temp_sensor_image = lv_img_create(temp_sensor_panel);
     lv_obj_align(temp_sensor_image, LV_ALIGN_CENTER, -62, 0);
-    lv_img_set_src(temp_sensor_image, sensor_monitor_img_src_list[0].img);
+    lv_img_set_src(temp_sensor_image, asset_pack_img(sensor_monitor_img_src_list[0].img));
     temp_value_label = lv_label_create(temp_sensor_panel);
     lv_label_set_text(temp_value_label, "");
     lv_obj_set_style_text_color(temp_value_label, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(temp_value_label, &font_en_22, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(temp_value_label, asset_pack_font("font_en_22"), LV_STATE_DEFAULT);
     lv_obj_align(temp_value_label, LV_ALIGN_CENTER, -37, 1);
+    ui_bind_attach(&temp_bind, temp_value_label);
     lv_obj_t *degree_image = lv_img_create(temp_sensor_panel);
     lv_obj_align(degree_image, LV_ALIGN_CENTER, -14, 0);
-    lv_img_set_src(degree_image, sensor_monitor_img_src_list[3].img);
+    lv_img_set_src(degree_image, asset_pack_img(sensor_monitor_img_src_list[3].img));
 
     lv_obj_t *hum_sensor_image = lv_img_create(temp_sensor_panel);
     lv_obj_align(hum_sensor_image, LV_ALIGN_CENTER, 12, 0);
-    lv_img_set_src(hum_sensor_image, sensor_monitor_img_src_list[1].img);
+    lv_img_set_src(hum_sensor_image, asset_pack_img(sensor_monitor_img_src_list[1].img));
     hum_value_label = lv_label_create(temp_sensor_panel);
     lv_label_set_text(hum_value_label, "");
     lv_obj_set_style_text_color(hum_value_label, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(hum_value_label, &font_en_22, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(hum_value_label, asset_pack_font("font_en_22"), LV_STATE_DEFAULT);
     lv_obj_align(hum_value_label, LV_ALIGN_CENTER, 36, 1);
+    ui_bind_attach(&hum_bind, hum_value_label);
     lv_obj_t *percent_image = lv_img_create(temp_sensor_panel);
     lv_obj_align(percent_image, LV_ALIGN_CENTER, 59, 0);
-    lv_img_set_src(percent_image, sensor_monitor_img_src_list[4].img);
+    lv_img_set_src(percent_image, asset_pack_img(sensor_monitor_img_src_list[4].img));
 
     radar_panel = lv_obj_create(page);
     lv_obj_set_size(radar_panel, 95, 50);
@@ -992,22 +1043,23 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_style_text_color(radar_btn_lab, lv_color_hex(0xFFFFFF), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_text_opa(radar_btn_lab, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_text_align(radar_btn_lab, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(radar_btn_lab, &font_en_bold_10, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(radar_btn_lab, asset_pack_font("font_en_bold_10"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_radius(radar_btn_lab, 7, LV_PART_MAIN | LV_STATE_DEFAULT);
 
     lv_obj_set_style_bg_opa(radar_btn_lab, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
     radar_image = lv_img_create(radar_panel);
     lv_obj_align(radar_image, LV_ALIGN_CENTER, -26, 0);
     if ((RADAR_SWITCH_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) && (RADAR_STATE & xEventGroupGetBits(sensor_monitor_event_grp))) {
-        lv_img_set_src(radar_image, air_ctrl_btn_src_list[0].img_on);
+        ui_bind_set(&radar_image_bind, (intptr_t) asset_pack_img(air_ctrl_btn_src_list[0].img_on));
     } else {
-        lv_img_set_src(radar_image, air_ctrl_btn_src_list[0].img_off);
+        ui_bind_set(&radar_image_bind, (intptr_t) asset_pack_img(air_ctrl_btn_src_list[0].img_off));
     }
+    ui_bind_attach(&radar_image_bind, radar_image);
     lv_obj_t *radar_label = lv_label_create(radar_panel);
     lv_label_set_text_static(radar_label, air_ctrl_btn_src_list[0].name);
     lv_obj_set_style_text_color(radar_label, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
     lv_obj_align(radar_label, LV_ALIGN_CENTER, 19, 9);
-    lv_obj_set_style_text_font(radar_label, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(radar_label, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
 
     air_ctrl_panel = lv_obj_create(page);
     lv_obj_set_size(air_ctrl_panel, 255, 120);
@@ -1040,7 +1092,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_clear_flag(ir_learning_tips_lab, LV_OBJ_FLAG_HIDDEN);
     lv_obj_set_style_text_color(ir_learning_tips_lab, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
     lv_obj_set_style_text_align(ir_learning_tips_lab, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(ir_learning_tips_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(ir_learning_tips_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
 
 
     if (IR_LEARNING_STATE & xEventGroupGetBits(sensor_monitor_event_grp)) {
@@ -1087,7 +1139,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_label_set_text(ir_learning_prompt_words,
                       "1. Point your controller towards the IR module.\n2. Press the power button of the controller.");
     lv_obj_set_style_text_align(ir_learning_prompt_words, LV_TEXT_ALIGN_LEFT, LV_PART_MAIN | LV_STATE_DEFAULT);
-    lv_obj_set_style_text_font(ir_learning_prompt_words, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(ir_learning_prompt_words, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
 
     ir_learning_state_lab = lv_label_create(air_ctrl_panel);
     lv_obj_set_width(ir_learning_state_lab, LV_SIZE_CONTENT);   /// 1
@@ -1097,7 +1149,7 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_align(ir_learning_state_lab, LV_ALIGN_CENTER);
     lv_obj_add_flag(ir_learning_state_lab, LV_OBJ_FLAG_HIDDEN);
     lv_label_set_text(ir_learning_state_lab, "Press the button");
-    lv_obj_set_style_text_font(ir_learning_state_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(ir_learning_state_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
     lv_obj_set_style_text_color(ir_learning_state_lab, lv_color_make(206, 36, 79), LV_STATE_DEFAULT);
 
     ac_switch_btn = lv_btn_create(air_ctrl_panel);
@@ -1122,6 +1174,8 @@ void ui_sensor_monitor_start(void (*fn)(void))
     lv_obj_set_style_text_color(ac_switch_btn_lab, lv_palette_main(LV_PALETTE_RED), LV_PART_MAIN);
     lv_obj_center(ac_switch_btn_lab);
 
+    ui_history_create(page);
+
 #if !CONFIG_BSP_BOARD_ESP32_S3_BOX_Lite
     bsp_btn_register_callback(BSP_BUTTON_MAIN, BUTTON_PRESS_UP, btn_return_down_cb, (void *)btn_return);
 #endif
@@ -1135,16 +1189,16 @@ void ui_sensor_monitor_start(void (*fn)(void))
         lv_obj_add_flag(radar_panel, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(air_ctrl_panel, LV_OBJ_FLAG_HIDDEN);
         lv_obj_add_flag(relearning_lab, LV_OBJ_FLAG_HIDDEN);
-        lv_label_set_text(temp_value_label, "0");
-        lv_label_set_text(hum_value_label, "0");
+        ui_bind_set(&temp_bind, 0);
+        ui_bind_set(&hum_bind, 0);
         esp_sensor_base_img = lv_img_create(page);
         lv_obj_align(esp_sensor_base_img, LV_ALIGN_CENTER, 0, -60);
-        lv_img_set_src(esp_sensor_base_img, sensor_monitor_img_src_list[2].img);
+        lv_img_set_src(esp_sensor_base_img, asset_pack_img(sensor_monitor_img_src_list[2].img));
 
         tips_lab = lv_label_create(page);
         lv_label_set_text(tips_lab, "This function needs the\n sensor accessory. \nPlease mount the esp-box onto it.");
         lv_obj_set_style_text_color(tips_lab, lv_color_make(40, 40, 40), LV_STATE_DEFAULT);
-        lv_obj_set_style_text_font(tips_lab, &font_cn_gb2_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(tips_lab, asset_pack_font("font_cn_gb2_16"), LV_PART_MAIN | LV_STATE_DEFAULT);
         lv_obj_align(tips_lab, LV_ALIGN_CENTER, 0, 15);
         lv_obj_set_style_text_align(tips_lab, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN | LV_STATE_DEFAULT);
 
@@ -1174,5 +1228,8 @@ void ui_sensor_monitor_start(void (*fn)(void))
         lv_group_add_obj(ui_get_btn_op_group(), air_switch_reversal_btn);
         lv_group_add_obj(ui_get_btn_op_group(), relearning_btn);
         lv_group_add_obj(ui_get_btn_op_group(), ir_learning_settings_close_btn);
+        lv_group_add_obj(ui_get_btn_op_group(), temp_sensor_panel);
+        lv_group_add_obj(ui_get_btn_op_group(), history_range_btn);
+        lv_group_add_obj(ui_get_btn_op_group(), history_close_btn);
     }
 }
@@ -7,55 +7,35 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "lvgl.h"
+#include "asset_pack.h"
+#include "lvgl_prof.h"
 #include "ui_main.h"
+#include "ui_bind.h"
 #include "ui_player.h"
+#include "app_sr_level.h"
 
 static const char *TAG = "ui_sr";
 
-LV_FONT_DECLARE(font_cn_gb1_28);
-
+/* Bars follow the mic at this rate, redrawing only those that moved by the threshold or more */
+#define SR_ANIM_FPS         20
+#define SR_BAR_MIN          20
+#define SR_BAR_THRESHOLD    4
+#define SR_BAR_RELEASE      6       /* Fall per frame, rises are shown at once */
 
 static bool g_sr_anim_active = false;
-static int32_t g_sr_anim_count = 0;
 static lv_obj_t *g_sr_label = NULL;
+static ui_bind_t g_sr_label_bind = UI_BIND_TEXT_STATIC();
 static lv_obj_t *g_sr_mask = NULL;
 static lv_obj_t *g_sr_bar[8] = {NULL};
+static int32_t g_sr_bar_val[SR_LEVEL_BANDS];
 
 lv_timer_t *sr_timer;
 
-static int int16_sin(int32_t deg)
-{
-    static const int16_t sin_0_90_table[] = {
-        0,     572,   1144,  1715,  2286,  2856,  3425,  3993,  4560,  5126,  5690,  6252,  6813,  7371,  7927,  8481,
-        9032,  9580,  10126, 10668, 11207, 11743, 12275, 12803, 13328, 13848, 14364, 14876, 15383, 15886, 16383, 16876,
-        17364, 17846, 18323, 18794, 19260, 19720, 20173, 20621, 21062, 21497, 21925, 22347, 22762, 23170, 23571, 23964,
-        24351, 24730, 25101, 25465, 25821, 26169, 26509, 26841, 27165, 27481, 27788, 28087, 28377, 28659, 28932, 29196,
-        29451, 29697, 29934, 30162, 30381, 30591, 30791, 30982, 31163, 31335, 31498, 31650, 31794, 31927, 32051, 32165,
-        32269, 32364, 32448, 32523, 32587, 32642, 32687, 32722, 32747, 32762, 32767
-    };
-
-    if (deg < 0) {
-        deg = -deg;
-    }
-
-    deg = deg % 360;
-
-    if (deg <= 90) {
-        return sin_0_90_table[deg];
-    } else if (deg <= 180) {
-        return sin_0_90_table[180 - deg];
-    } else if (deg <= 270) {
-        return -sin_0_90_table[deg - 270];
-    } else {
-        return -sin_0_90_table[360 - deg];
-    }
-}
-
 static void sr_label_event_handler(lv_event_t *event)
 {
     char *text = (char *) event-> param;
     if (NULL != text) {
-        lv_label_set_text_static(g_sr_label, text);
+        ui_bind_set(&g_sr_label_bind, (intptr_t) text);
     }
 }
 
@@ -70,7 +50,6 @@ static void sr_mask_event_handler(lv_event_t *event)
         }
         lv_indev_t *indev = lv_indev_get_next(NULL);
         lv_indev_enable(indev, false);
-        g_sr_anim_count = 0;
         g_sr_anim_active = true;
         lv_timer_resume(sr_timer);
     } else {
@@ -80,10 +59,23 @@ static void sr_mask_event_handler(lv_event_t *event)
     }
 }
 
+/* Band 0 drives the pair next to the mic, the highest band the outer pair */
+static void sr_bar_set(size_t band, int32_t val)
+{
+    lv_obj_t *pair[2] = { g_sr_bar[SR_LEVEL_BANDS - 1 - band], g_sr_bar[SR_LEVEL_BANDS + band] };
+
+    for (size_t i = 0; i < 2; i++) {
+        lv_bar_set_value(pair[i], val, LV_ANIM_OFF);
+        lv_bar_set_start_value(pair[i], -val, LV_ANIM_OFF);
+    }
+    g_sr_bar_val[band] = val;
+}
+
 static void ui_speech_anim_cb(lv_timer_t *timer)
 {
-    const int32_t step = 40;
     lv_obj_t *player_page = get_player_page();
+    sr_level_t level = { 0 };
+    bool idle = true;
 
     if (g_sr_anim_active) {
         // /* Will hide hint message after wakeup */
@@ -102,40 +94,31 @@ static void ui_speech_anim_cb(lv_timer_t *timer)
         if (player_page) {
             lv_obj_add_flag(player_page, LV_OBJ_FLAG_HIDDEN);
         }
+        app_sr_level_get(&level, NULL);
+    }
+
+    for (size_t band = 0; band < SR_LEVEL_BANDS; band++) {
+        int32_t target = g_sr_anim_active ? SR_BAR_MIN + level.band[band] * (100 - SR_BAR_MIN) / 100 : 0;
+        int32_t shown = g_sr_bar_val[band];
+        int32_t next = (target >= shown) ? target : LV_MAX(target, shown - SR_BAR_RELEASE);
 
-        /* Set bar value */
-        int32_t sr_val[4] = {
-            abs(int16_sin(g_sr_anim_count * step + step * 0)) / (32768 >> 7),
-            abs(int16_sin(g_sr_anim_count * step + step * 1)) / (32768 >> 7),
-            abs(int16_sin(g_sr_anim_count * step + step * 2)) / (32768 >> 7),
-            abs(int16_sin(g_sr_anim_count * step + step * 3)) / (32768 >> 7),
-        };
-
-        for (size_t i = 0; i < 4; i++) {
-            lv_bar_set_value(g_sr_bar[i], sr_val[i] > 20 ? sr_val[i] : 20, LV_ANIM_ON);
-            lv_bar_set_value(g_sr_bar[7 - i], sr_val[i] > 20 ? sr_val[i] : 20, LV_ANIM_ON);
-            lv_bar_set_start_value(g_sr_bar[i], sr_val[i] > 20 ? -sr_val[i] : -20, LV_ANIM_ON);
-            lv_bar_set_start_value(g_sr_bar[7 - i], sr_val[i] > 20 ? -sr_val[i] : -20, LV_ANIM_ON);
+        /* Small moves are skipped, except the last step down to the resting height */
+        if (abs(next - shown) >= SR_BAR_THRESHOLD || (next != shown && next == target && target <= SR_BAR_MIN)) {
+            sr_bar_set(band, next);
         }
-        g_sr_anim_count++;
-    } else {
-        /* The first timer callback will set the bars to 0 */
-        if (g_sr_anim_count != 0) {
-            for (size_t i = 0; i < 8; i++) {
-                lv_bar_set_value(g_sr_bar[i], 0, LV_ANIM_ON);
-                lv_bar_set_start_value(g_sr_bar[i], -0, LV_ANIM_ON);
-            }
-            g_sr_anim_count = 0;
-        } else {
-            /* The second timer callback will hide sr mask */
-            if (!lv_obj_has_flag(g_sr_mask, LV_OBJ_FLAG_HIDDEN)) {
-                lv_obj_add_flag(g_sr_mask, LV_OBJ_FLAG_HIDDEN);
-            }
-
-            if (player_page) {
-                lv_obj_clear_flag(player_page, LV_OBJ_FLAG_HIDDEN);
-            }
+        idle &= (g_sr_bar_val[band] == 0);
+    }
+
+    /* Once the bars have fallen after a stop, hide the mask until the next wake word */
+    if (!g_sr_anim_active && idle) {
+        if (!lv_obj_has_flag(g_sr_mask, LV_OBJ_FLAG_HIDDEN)) {
+            lv_obj_add_flag(g_sr_mask, LV_OBJ_FLAG_HIDDEN);
         }
+
+        if (player_page) {
+            lv_obj_clear_flag(player_page, LV_OBJ_FLAG_HIDDEN);
+        }
+        lv_timer_pause(timer);
     }
 }
 
@@ -143,6 +126,7 @@ void ui_sr_anim_init(void)
 {
     ESP_LOGI(TAG, "sr animation initialize");
     g_sr_mask = lv_obj_create(lv_scr_act());
+    lvgl_prof_set_name(g_sr_mask, "speech_anim");
     lv_obj_set_size(g_sr_mask, lv_obj_get_width(lv_obj_get_parent(g_sr_mask)), lv_obj_get_height(lv_obj_get_parent(g_sr_mask)));
     lv_obj_clear_flag(g_sr_mask, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_add_flag(g_sr_mask, LV_OBJ_FLAG_HIDDEN);
@@ -162,28 +146,24 @@ void ui_sr_anim_init(void)
     lv_obj_set_style_shadow_opa(obj_img, LV_OPA_30, LV_STATE_DEFAULT);
     lv_obj_align(obj_img, LV_ALIGN_CENTER, 0, -30);
     lv_obj_t *img_mic_logo = lv_img_create(obj_img);
-    LV_IMG_DECLARE(mic_logo)
-    lv_img_set_src(img_mic_logo, &mic_logo);
+    lv_img_set_src(img_mic_logo, asset_pack_img("mic_logo"));
     lv_obj_center(img_mic_logo);
 
     g_sr_label = lv_label_create(g_sr_mask);
     lv_label_set_text_static(g_sr_label, "----");
-    lv_obj_set_style_text_font(g_sr_label, &font_cn_gb1_28, LV_STATE_DEFAULT);
+    /* The 28 px font of the Chinese commands has no source in the tree, the 16 px one of the hints has the glyphs */
+    lv_obj_set_style_text_font(g_sr_label, asset_pack_font("font_cn_gb1_16"), LV_STATE_DEFAULT);
     lv_obj_set_style_text_color(g_sr_label, lv_color_black(), LV_STATE_DEFAULT);
     lv_obj_align(g_sr_label, LV_ALIGN_CENTER, 0, 80);
     lv_obj_add_event_cb(g_sr_label, sr_label_event_handler, LV_EVENT_VALUE_CHANGED, NULL);
+    ui_bind_attach(&g_sr_label_bind, g_sr_label);
 
     for (size_t i = 0; i < sizeof(g_sr_bar) / sizeof(g_sr_bar[0]); i++) {
         g_sr_bar[i] = lv_bar_create(g_sr_mask);
         lv_obj_set_size(g_sr_bar[i], 5, 60);
-        lv_obj_set_style_anim_time(g_sr_bar[i], 400, LV_STATE_DEFAULT);
         lv_obj_set_style_bg_color(g_sr_bar[i], lv_color_make(237, 238, 239), LV_STATE_DEFAULT);
         lv_obj_set_style_bg_color(g_sr_bar[i], lv_color_make(246, 175, 171), LV_PART_INDICATOR);
         lv_bar_set_range(g_sr_bar[i], -100, 100);
-        lv_bar_set_value(g_sr_bar[i], 20, LV_ANIM_OFF);
-        lv_bar_set_start_value(g_sr_bar[i], -20, LV_ANIM_OFF);
-        lv_obj_set_style_anim_time(g_sr_bar[i], 400, LV_STATE_DEFAULT);
-
     }
 
     for (size_t i = 0; i < sizeof(g_sr_bar) / sizeof(g_sr_bar[0]) / 2; i++) {
@@ -191,9 +171,12 @@ void ui_sr_anim_init(void)
         lv_obj_align_to(g_sr_bar[i + 4], obj_img, LV_ALIGN_OUT_RIGHT_MID, 15 * i + 20, 0);
     }
 
-    g_sr_anim_count = 0;
+    for (size_t band = 0; band < SR_LEVEL_BANDS; band++) {
+        sr_bar_set(band, SR_BAR_MIN);
+    }
+
     g_sr_anim_active = false;
-    sr_timer = lv_timer_create(ui_speech_anim_cb, 500, NULL);
+    sr_timer = lv_timer_create(ui_speech_anim_cb, 1000 / SR_ANIM_FPS, NULL);
     lv_timer_pause(sr_timer);
 }
 
@@ -209,7 +192,5 @@ void sr_anim_stop(void)
 
 void sr_anim_set_text(char *text)
 {
-    ui_acquire();
-    lv_label_set_text_static(g_sr_label, text);
-    ui_release();
+    ui_bind_set(&g_sr_label_bind, (intptr_t) text);
 }
@@ -19,6 +19,8 @@
 #include "app_led.h"
 #include "app_rmaker.h"
 #include "app_sr.h"
+#include "app_telemetry.h"
+#include "asset_pack.h"
 #include "audio_player.h"
 #include "file_iterator.h"
 #include "gui/ui_main.h"
@@ -26,6 +28,9 @@
 
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
+#include "lvgl_prof.h"
+#include "boot_steps.h"
 
 static const char *TAG = "main";
 
@@ -33,12 +38,13 @@ file_iterator_instance_t *file_iterator;
 
 #define MEMORY_MONITOR 0
 
-#if MEMORY_MONITOR
+#if MEMORY_MONITOR || CONFIG_LVGL_PROF_ENABLE
 static void monitor_task(void *arg)
 {
     (void) arg;
 
     while (true) {
+#if MEMORY_MONITOR
         ESP_LOGI(TAG, "System Info Trace");
         // printf("\tDescription\tInternal\tSPIRAM\n");
         printf("Current Free Memory\t%d\t\t%d\n",
@@ -52,6 +58,14 @@ static void monitor_task(void *arg)
                heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
 
         // esp_intr_dump(stdout);
+#endif
+#if CONFIG_LVGL_PROF_ENABLE
+        lvgl_prof_summary_t summary;
+        bsp_display_lock(0);
+        lvgl_prof_get_summary(&summary);
+        bsp_display_unlock();
+        lvgl_prof_print_summary(&summary);
+#endif
         vTaskDelay(pdMS_TO_TICKS(5 * 1000));
     }
 
@@ -88,62 +102,128 @@ static esp_err_t audio_mute_function(AUDIO_PLAYER_MUTE_SETTING setting)
     return ESP_OK;
 }
 
-void app_main(void)
+esp_err_t boot_nvs(void *arg)
 {
-    ESP_LOGI(TAG, "Compile time: %s %s", __DATE__, __TIME__);
-    /* Initialize NVS. */
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
-        ESP_ERROR_CHECK(nvs_flash_erase());
+        ESP_RETURN_ON_ERROR(nvs_flash_erase(), TAG, "Erase NVS failed");
         err = nvs_flash_init();
     }
-    ESP_ERROR_CHECK(err);
-    ESP_ERROR_CHECK(settings_read_parameter_from_nvs());
+    return err;
+}
 
-#if !SR_RUN_TEST && MEMORY_MONITOR
-    sys_monitor_start(); // Logs should be reduced during SR testing
-#endif
-    bsp_spiffs_mount();
+esp_err_t boot_settings(void *arg)
+{
+    return settings_read_parameter_from_nvs();
+}
+
+esp_err_t boot_spiffs(void *arg)
+{
+    return bsp_spiffs_mount();
+}
 
-    bsp_i2c_init();
+esp_err_t boot_i2c(void *arg)
+{
+    return bsp_i2c_init();
+}
 
+esp_err_t boot_display(void *arg)
+{
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
     cfg.lvgl_port_cfg.task_affinity = 1;
-    bsp_display_start_with_config(&cfg);
-    bsp_board_init();
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
+    ESP_RETURN_ON_FALSE(bsp_display_start_with_config(&cfg), ESP_FAIL, TAG, "Display start failed");
+    bsp_display_lock(0);
+    lvgl_prof_attach(lv_disp_get_default());
+    bsp_display_unlock();
+    return ESP_OK;
+}
+
+esp_err_t boot_board(void *arg)
+{
+    return bsp_board_init();
+}
+
+esp_err_t boot_sensor_events(void *arg)
+{
+    return sensor_task_state_event_init();
+}
+
+esp_err_t boot_telemetry(void *arg)
+{
+    return app_telemetry_init(true);
+}
 
+esp_err_t boot_assets(void *arg)
+{
+    if (ESP_OK != asset_pack_init("assets", NULL)) {
+        ESP_LOGW(TAG, "UI runs without images and custom fonts");
+    }
+    return ESP_OK;
+}
+
+esp_err_t boot_ui(void *arg)
+{
     ESP_LOGI(TAG, "Display LVGL demo");
-    sensor_task_state_event_init();
-    ESP_ERROR_CHECK(ui_main_start());
+    return ui_main_start();
+}
 
+esp_err_t boot_backlight(void *arg)
+{
+    /* Lets the first frames of the boot animation reach the panel before it lights up */
     vTaskDelay(pdMS_TO_TICKS(500));
-    bsp_display_backlight_on();
+    return bsp_display_backlight_on();
+}
 
+esp_err_t boot_player(void *arg)
+{
     file_iterator = file_iterator_new("/spiffs/mp3");
-    assert(file_iterator != NULL);
+    ESP_RETURN_ON_FALSE(file_iterator, ESP_FAIL, TAG, "No file iterator for /spiffs/mp3");
     audio_player_config_t config = { .mute_fn = audio_mute_function,
                                      .write_fn = bsp_i2s_write,
                                      .clk_set_fn = bsp_codec_set_fs,
                                      .priority = 5
                                    };
-    ESP_ERROR_CHECK(audio_player_new(config));
+    return audio_player_new(config);
+}
 
+esp_err_t boot_led(void *arg)
+{
     const board_res_desc_t *brd = bsp_board_get_description();
 #ifdef CONFIG_BSP_BOARD_ESP32_S3_BOX_3
-    app_pwm_led_init(brd->PMOD2->row2[2], brd->PMOD2->row2[3], brd->PMOD2->row1[3]);
+    esp_err_t ret = app_pwm_led_init(brd->PMOD2->row2[2], brd->PMOD2->row2[3], brd->PMOD2->row1[3]);
 #else
-    app_pwm_led_init(brd->PMOD2->row1[1], brd->PMOD2->row1[2], brd->PMOD2->row1[3]);
+    esp_err_t ret = app_pwm_led_init(brd->PMOD2->row1[1], brd->PMOD2->row1[2], brd->PMOD2->row1[3]);
 #endif
+    /* The LED sits on a PMOD, an optional step */
+    return ret;
+}
 
+esp_err_t boot_sr(void *arg)
+{
     ESP_LOGI(TAG, "speech recognition start");
-    vTaskDelay(pdMS_TO_TICKS(4 * 1000));
-    app_sr_start(false);
+    return app_sr_start(false);
+}
+
+esp_err_t boot_rmaker(void *arg)
+{
     app_rmaker_start();
+    return ESP_OK;
+}
+
+void app_main(void)
+{
+    ESP_LOGI(TAG, "Compile time: %s %s", __DATE__, __TIME__);
+
+#if !SR_RUN_TEST && (MEMORY_MONITOR || CONFIG_LVGL_PROF_ENABLE)
+    sys_monitor_start(); // Logs should be reduced during SR testing
+#endif
+
+    boot_seq_config_t config = BOOT_SEQ_DEFAULT_CONFIG();
+    boot_seq_report_t report;
+    esp_err_t ret = boot_seq_run(boot_steps, BOOT_STEP_NUM, &config, &report);
+    boot_seq_print_report(boot_steps, BOOT_STEP_NUM, &report);
+    ESP_ERROR_CHECK(ret);
 }
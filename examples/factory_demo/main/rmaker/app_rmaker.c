@@ -142,16 +142,12 @@ static void event_handler(void *arg, esp_event_base_t event_base,
         g_is_connected = 1;
         ESP_LOGI(TAG, "RMAKER connected");
         ui_net_config_update_cb(UI_NET_EVT_CLOUD_CONNECTED, NULL);
-        ui_acquire();
         ui_main_status_bar_set_cloud(g_is_connected);
-        ui_release();
         break;
     case RMAKER_MQTT_EVENT_DISCONNECTED:
         g_is_connected = 0;
         ESP_LOGI(TAG, "RMAKER disconnected");
-        ui_acquire();
         ui_main_status_bar_set_cloud(g_is_connected);
-        ui_release();
     default:
         break;
     }
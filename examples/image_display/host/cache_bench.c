@@ -0,0 +1,167 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * image_cache.c browsing the PNGs of ../spiffs, with the prefetch task on a pthread and libpng in place of lodepng.
+ * Each budget starts from an empty cache in a process of its own: the last image is shown cold, right after init,
+ * and warm, again. Then 20 clicks back and forth, one per pace, as a user going through the list.
+ *
+ * After every click the bytes held are counted again: frames and thumbnails have to add up to the used size,
+ * thumbnails may not take more than half the budget, and the budget may only be exceeded by the frame on screen.
+ * Exits with 1 when any of that does not hold.
+ */
+
+#include <glob.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "image_cache.c"
+
+#define THUMB_SIZE          (32)
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+typedef struct {
+    const char *name;
+    size_t budget_kb;
+    int pace_ms;
+} run_t;
+
+static const run_t s_runs[] = {
+    {"no cache", 0, 300},
+    {"64 KB", 64, 300},
+    {"100 KB", 100, 300},
+    {"160 KB", 160, 300},
+    {"256 KB", 256, 300},
+    {"256 KB, no pause", 256, 0},
+};
+
+static const size_t s_clicks[] = {1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 4, 3, 4, 5, 0, 5, 0, 1, 0};
+
+static int s_thumbs;
+
+static void thumb_cb(size_t index, const lv_img_dsc_t *thumb, void *user_data)
+{
+    __atomic_add_fetch(&s_thumbs, 1, __ATOMIC_RELAXED);
+}
+
+static bool check_used(void)
+{
+    size_t frames = 0;
+    size_t thumbs = 0;
+    size_t others = 0;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (size_t i = 0; i < s_count; i++) {
+        frames += s_entries[i].img.data ? s_entries[i].img.data_size : 0;
+        thumbs += s_entries[i].thumb.data ? s_entries[i].thumb.data_size : 0;
+        others += (s_entries[i].img.data && i != s_shown) ? s_entries[i].img.data_size : 0;
+    }
+    image_cache_stats_t stats = s_stats;
+    xSemaphoreGive(s_lock);
+
+    CHECK(frames + thumbs == stats.used, "%zu bytes of frames and %zu of thumbnails, used %zu", frames, thumbs,
+          stats.used);
+    CHECK(thumbs == stats.thumb_used && thumbs <= s_cfg.budget / 2, "%zu bytes of thumbnails, %zu counted, budget %zu",
+          thumbs, stats.thumb_used, s_cfg.budget);
+    CHECK(stats.used <= s_cfg.budget || 0 == others, "%zu bytes used, budget %zu, %zu bytes not on screen", stats.used,
+          s_cfg.budget, others);
+    return true;
+}
+
+static int64_t show(size_t index, bool *ok)
+{
+    int64_t start_us = esp_timer_get_time();
+    const lv_img_dsc_t *frame = image_cache_show(index);
+    int64_t show_us = esp_timer_get_time() - start_us;
+
+    if (NULL == frame) {
+        printf("FAIL image %zu not shown\n", index);
+        *ok = false;
+    }
+    *ok = check_used() && *ok;
+    return show_us;
+}
+
+/* In a child process, the cache can only be initialized once */
+static bool run(const run_t *r, const char *const *paths, size_t count)
+{
+    image_cache_cfg_t cfg = {
+        .budget = r->budget_kb * 1024,
+        .thumb_size = THUMB_SIZE,
+        .task_priority = 1,
+        .task_core = 1,
+    };
+    bool ok = true;
+
+    if (ESP_OK != image_cache_init(&cfg, paths, count, thumb_cb, NULL)) {
+        printf("FAIL %s: init\n", r->name);
+        return false;
+    }
+
+    /* The thumbnail pass starts at the first image */
+    int64_t cold_us = show(count - 1, &ok);
+    int64_t warm_us = show(count - 1, &ok);
+    int64_t total_us = 0;
+    int64_t worst_us = 0;
+    size_t clicks = sizeof(s_clicks) / sizeof(s_clicks[0]);
+    for (size_t i = 0; i < clicks; i++) {
+        vTaskDelay(pdMS_TO_TICKS(r->pace_ms));
+        int64_t show_us = show(s_clicks[i] % count, &ok);
+        total_us += show_us;
+        worst_us = show_us > worst_us ? show_us : worst_us;
+    }
+    /* Let the thumbnails finish */
+    vTaskDelay(pdMS_TO_TICKS(300));
+    ok = check_used() && ok;
+
+    image_cache_stats_t stats;
+    image_cache_get_stats(&stats);
+    uint32_t shown = stats.hits + stats.misses;
+    printf("%-18s %8lld %8lld %8lld %8lld %5u%% %7u %9u %7zu %8zu %6d\n", r->name, (long long) cold_us,
+           (long long) warm_us, (long long)(total_us / (int64_t) clicks), (long long) worst_us,
+           (unsigned)(stats.hits * 100 / shown), (unsigned) stats.decodes, (unsigned) stats.evictions,
+           stats.used / 1024, stats.thumb_used / 1024, __atomic_load_n(&s_thumbs, __ATOMIC_RELAXED));
+    return ok;
+}
+
+int main(void)
+{
+    glob_t found;
+    int failed = 0;
+
+    if (0 != glob(IMAGE_DIR "/*.png", 0, NULL, &found) || 0 == found.gl_pathc) {
+        printf("FAIL no PNG in %s\n", IMAGE_DIR);
+        return 1;
+    }
+
+    printf("%d images, times in us\n", (int) found.gl_pathc);
+    printf("%-18s %8s %8s %8s %8s %6s %7s %9s %7s %8s %6s\n", "budget", "cold", "warm", "avg", "worst", "hit",
+           "decodes", "evictions", "used KB", "thumb KB", "thumbs");
+    fflush(stdout);
+    for (size_t i = 0; i < sizeof(s_runs) / sizeof(s_runs[0]); i++) {
+        pid_t pid = fork();
+        if (0 == pid) {
+            bool ok = run(&s_runs[i], (const char *const *) found.gl_pathv, found.gl_pathc);
+            fflush(stdout);
+            _exit(ok ? 0 : 1);
+        }
+        int status = 1;
+        waitpid(pid, &status, 0);
+        failed += !(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+    }
+    globfree(&found);
+    printf(failed ? "FAILED\n" : "All checks passed\n");
+    return failed ? 1 : 0;
+}
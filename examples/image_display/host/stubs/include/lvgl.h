@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* Host stand-in, the image descriptor and color of LVGL 8.3 as configured by sdkconfig.defaults */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LV_USE_PNG                  1
+#define LV_MEM_CUSTOM               1
+#define LV_COLOR_16_SWAP            1
+#define LV_IMG_PX_SIZE_ALPHA_BYTE   3
+
+enum {
+    LV_IMG_CF_TRUE_COLOR_ALPHA = 5,
+};
+
+typedef struct {
+    uint32_t cf : 5;
+    uint32_t always_zero : 3;
+    uint32_t reserved : 2;
+    uint32_t w : 11;
+    uint32_t h : 11;
+} lv_img_header_t;
+
+typedef struct {
+    lv_img_header_t header;
+    uint32_t data_size;
+    const uint8_t *data;
+} lv_img_dsc_t;
+
+/* RGB565 with the bytes swapped */
+typedef union {
+    struct {
+        uint16_t green_h : 3;
+        uint16_t red : 5;
+        uint16_t blue : 5;
+        uint16_t green_l : 3;
+    } ch;
+    uint16_t full;
+} lv_color_t;
+
+static inline lv_color_t lv_color_make(uint8_t r, uint8_t g, uint8_t b)
+{
+    lv_color_t c;
+    c.ch.red = r >> 3;
+    c.ch.green_h = (g >> 5) & 0x7;
+    c.ch.green_l = (g >> 2) & 0x7;
+    c.ch.blue = b >> 3;
+    return c;
+}
+
+/* lodepng_libpng.c allocates with malloc() */
+#define lv_mem_free(ptr)            free(ptr)
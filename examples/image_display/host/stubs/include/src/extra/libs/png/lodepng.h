@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* Host stand-in for the lodepng bundled with LVGL, see lodepng_libpng.c */
+
+#pragma once
+
+#include <stddef.h>
+
+/* RGBA8888, *out is freed with lv_mem_free(). Returns 0 on success. */
+unsigned lodepng_decode32(unsigned char **out, unsigned *w, unsigned *h, const unsigned char *in, size_t insize);
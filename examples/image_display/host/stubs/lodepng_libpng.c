@@ -0,0 +1,41 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * The lodepng call of image_cache.c decoded by the simplified API of libpng. Decode times are those of libpng on the
+ * host, not of lodepng on the chip, only the ratio between cold and warm shows count.
+ */
+
+#include <png.h>
+#include <stdlib.h>
+#include <string.h>
+#include "src/extra/libs/png/lodepng.h"
+
+unsigned lodepng_decode32(unsigned char **out, unsigned *w, unsigned *h, const unsigned char *in, size_t insize)
+{
+    png_image image;
+
+    memset(&image, 0, sizeof(image));
+    image.version = PNG_IMAGE_VERSION;
+    *out = NULL;
+    if (!png_image_begin_read_from_memory(&image, in, insize)) {
+        return 1;
+    }
+    image.format = PNG_FORMAT_RGBA;
+    *out = malloc(PNG_IMAGE_SIZE(image));
+    if (NULL == *out) {
+        png_image_free(&image);
+        return 83;      // lodepng: memory allocation failed
+    }
+    if (!png_image_finish_read(&image, NULL, *out, 0, NULL)) {
+        free(*out);
+        *out = NULL;
+        return 2;
+    }
+    *w = image.width;
+    *h = image.height;
+    return 0;
+}
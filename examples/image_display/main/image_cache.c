@@ -0,0 +1,413 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Decoded images kept in PSRAM, least recently shown dropped first once over budget.
+ *
+ * PNGs are decoded with the lodepng copy shipped with LVGL, without taking the LVGL lock, so the
+ * prefetch task can decode the neighbours of the image on screen while LVGL keeps rendering.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "lvgl.h"
+#include "src/extra/libs/png/lodepng.h"
+#include "image_cache.h"
+
+#if !LV_USE_PNG
+#error "image_cache decodes with the lodepng of LVGL, enable CONFIG_LV_USE_PNG"
+#endif
+#if !LV_MEM_CUSTOM
+#error "lodepng allocates with lv_mem_alloc, which is only safe outside of the LVGL task with CONFIG_LV_MEM_CUSTOM"
+#endif
+
+#define CACHE_QUEUE_LEN         (4)
+#define CACHE_TASK_STACK_SIZE   (4 * 1024)
+#define CACHE_NONE              (SIZE_MAX)
+
+typedef enum {
+    CACHE_LOAD_SHOW = 0,        // the user waits for it, anything else may go
+    CACHE_LOAD_PREFETCH,        // may only push out what was shown before the image on screen
+    CACHE_LOAD_THUMB,           // kept only if there is room left
+} cache_load_t;
+
+typedef struct {
+    char *path;
+    lv_img_dsc_t img;           // data is NULL while not cached
+    lv_img_dsc_t thumb;
+    uint32_t size;              // bytes of the decoded frame, 0 until decoded once
+    uint32_t stamp;             // last use, the smallest goes first
+} cache_entry_t;
+
+static const char *TAG = "image_cache";
+
+static image_cache_cfg_t s_cfg;
+static cache_entry_t *s_entries = NULL;
+static size_t s_count = 0;
+static size_t s_shown = CACHE_NONE;
+static uint32_t s_clock = 0;
+static image_cache_stats_t s_stats;
+static image_cache_thumb_cb_t s_cb = NULL;
+static void *s_cb_args = NULL;
+static SemaphoreHandle_t s_lock = NULL;         // entries and stats
+static SemaphoreHandle_t s_decode_lock = NULL;  // one decode at a time, a miss waits for a prefetch of the same image
+static QueueHandle_t s_queue = NULL;
+
+/* RGBA8888 from lodepng to LV_IMG_CF_TRUE_COLOR_ALPHA, averaging scale x scale blocks for thumbnails */
+static esp_err_t cache_frame(lv_img_dsc_t *dst, const uint8_t *rgba, uint32_t w, uint32_t h, uint32_t scale)
+{
+    uint32_t dw = w / scale ? w / scale : 1;
+    uint32_t dh = h / scale ? h / scale : 1;
+    uint8_t *data = heap_caps_malloc(dw * dh * LV_IMG_PX_SIZE_ALPHA_BYTE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(NULL != data, ESP_ERR_NO_MEM, TAG, "no mem for %" PRIu32 "x%" PRIu32 " frame", dw, dh);
+
+    uint8_t *out = data;
+    for (uint32_t y = 0; y < dh; y++) {
+        for (uint32_t x = 0; x < dw; x++, out += LV_IMG_PX_SIZE_ALPHA_BYTE) {
+            uint8_t r, g, b, a;
+
+            if (1 == scale) {
+                const uint8_t *px = rgba + (y * w + x) * 4;
+                r = px[0];
+                g = px[1];
+                b = px[2];
+                a = px[3];
+            } else {
+                /* Colors weighted by alpha, so transparent pixels do not darken the edges */
+                uint32_t sum[4] = { 0 };
+                for (uint32_t sy = y * scale; sy < (y + 1) * scale && sy < h; sy++) {
+                    const uint8_t *px = rgba + (sy * w + x * scale) * 4;
+                    for (uint32_t sx = x * scale; sx < (x + 1) * scale && sx < w; sx++, px += 4) {
+                        sum[0] += px[0] * px[3];
+                        sum[1] += px[1] * px[3];
+                        sum[2] += px[2] * px[3];
+                        sum[3] += px[3];
+                    }
+                }
+                r = sum[3] ? sum[0] / sum[3] : 0;
+                g = sum[3] ? sum[1] / sum[3] : 0;
+                b = sum[3] ? sum[2] / sum[3] : 0;
+                a = sum[3] / (scale * scale);
+            }
+
+            lv_color_t c = lv_color_make(r, g, b);
+            memcpy(out, &c, sizeof(lv_color_t));
+            out[LV_IMG_PX_SIZE_ALPHA_BYTE - 1] = a;
+        }
+    }
+
+    memset(dst, 0, sizeof(lv_img_dsc_t));
+    dst->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    dst->header.w = dw;
+    dst->header.h = dh;
+    dst->data_size = dw * dh * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    dst->data = data;
+    return ESP_OK;
+}
+
+static esp_err_t cache_decode(const char *path, lv_img_dsc_t *img, lv_img_dsc_t *thumb)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t *png = NULL;
+    uint8_t *rgba = NULL;
+    unsigned w = 0;
+    unsigned h = 0;
+
+    FILE *fp = fopen(path, "rb");
+    ESP_RETURN_ON_FALSE(NULL != fp, ESP_ERR_NOT_FOUND, TAG, "open %s failed", path);
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    png = heap_caps_malloc(size > 0 ? size : 1, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_GOTO_ON_FALSE(NULL != png, ESP_ERR_NO_MEM, err, TAG, "no mem for %s", path);
+    ESP_GOTO_ON_FALSE(size > 0 && 1 == fread(png, size, 1, fp), ESP_FAIL, err, TAG, "read %s failed", path);
+
+    unsigned error = lodepng_decode32(&rgba, &w, &h, png, size);
+    ESP_GOTO_ON_FALSE(0 == error, ESP_FAIL, err, TAG, "decode %s failed: %u", path, error);
+
+    ret = cache_frame(img, rgba, w, h, 1);
+    if (ESP_OK == ret && thumb) {
+        uint32_t side = w > h ? w : h;
+        uint32_t scale = (side + s_cfg.thumb_size - 1) / s_cfg.thumb_size;
+        if (ESP_OK != cache_frame(thumb, rgba, w, h, scale ? scale : 1)) {
+            memset(thumb, 0, sizeof(lv_img_dsc_t));
+        }
+    }
+
+err:
+    if (rgba) {
+        lv_mem_free(rgba);
+    }
+    free(png);
+    fclose(fp);
+    return ret;
+}
+
+static void cache_drop(cache_entry_t *entry)
+{
+    s_stats.used -= entry->img.data_size;
+    free((void *)entry->img.data);
+    entry->img.data = NULL;
+}
+
+/* Called with s_lock held, only frames last used before the given stamp may go */
+static void cache_evict(uint32_t before)
+{
+    while (s_stats.used > s_cfg.budget) {
+        cache_entry_t *oldest = NULL;
+        for (size_t i = 0; i < s_count; i++) {
+            cache_entry_t *entry = &s_entries[i];
+            if (entry->img.data && i != s_shown && entry->stamp < before && (NULL == oldest || entry->stamp < oldest->stamp)) {
+                oldest = entry;
+            }
+        }
+        if (NULL == oldest) {
+            return;
+        }
+        cache_drop(oldest);
+        s_stats.evictions++;
+    }
+}
+
+/* Frames last used before this stamp may be evicted for a load of this kind */
+static uint32_t cache_before(cache_load_t load)
+{
+    if (CACHE_LOAD_SHOW == load) {
+        return UINT32_MAX;
+    }
+    if (CACHE_LOAD_PREFETCH == load && CACHE_NONE != s_shown) {
+        return s_entries[s_shown].stamp;
+    }
+    return 0;
+}
+
+/* Called with s_lock held, bytes of the frames cache_evict(before) has to keep */
+static size_t cache_kept(uint32_t before)
+{
+    size_t kept = 0;
+
+    for (size_t i = 0; i < s_count; i++) {
+        const cache_entry_t *entry = &s_entries[i];
+        if (entry->img.data && (i == s_shown || entry->stamp >= before)) {
+            kept += entry->img.data_size;
+        }
+    }
+    return kept;
+}
+
+/* Called with s_lock held */
+static void cache_insert(size_t index, const lv_img_dsc_t *img, cache_load_t load)
+{
+    cache_entry_t *entry = &s_entries[index];
+
+    entry->img = *img;
+    entry->stamp = ++s_clock;
+    s_stats.used += img->data_size;
+    cache_evict(cache_before(load));
+
+    /* Prefetches must not push out each other, the neighbour that does not fit is decoded again when shown */
+    if (s_stats.used > s_cfg.budget && index != s_shown) {
+        cache_drop(entry);
+    }
+}
+
+/*
+ * Called with s_lock held. Thumbnails are never freed, so all of them together get at most half of the budget, and
+ * they only push out frames the load could evict. Returns false when there is no room, the list keeps its icon.
+ */
+static bool cache_insert_thumb(size_t index, const lv_img_dsc_t *thumb, cache_load_t load)
+{
+    uint32_t before = cache_before(CACHE_LOAD_THUMB == load ? CACHE_LOAD_PREFETCH : load);
+    size_t size = thumb->data_size;
+
+    if (s_stats.thumb_used + size > s_cfg.budget / 2 || s_stats.thumb_used + size + cache_kept(before) > s_cfg.budget) {
+        s_stats.skips++;
+        return false;
+    }
+    s_entries[index].thumb = *thumb;
+    s_stats.used += size;
+    s_stats.thumb_used += size;
+    cache_evict(before);
+    return true;
+}
+
+/* Decode an image unless it is already there, the decode runs without s_lock so the cache can still be hit */
+static esp_err_t cache_load(size_t index, cache_load_t load, bool *new_thumb)
+{
+    cache_entry_t *entry = &s_entries[index];
+    esp_err_t ret = ESP_OK;
+    lv_img_dsc_t img;
+    lv_img_dsc_t thumb = { 0 };
+
+    *new_thumb = false;
+    xSemaphoreTake(s_decode_lock, portMAX_DELAY);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool need_img = (NULL == entry->img.data);
+    bool need_thumb = s_cfg.thumb_size && (NULL == entry->thumb.data);
+    /* Not decoded again to be dropped right away, once its size is known not to fit */
+    if (need_img && CACHE_LOAD_SHOW != load && entry->size &&
+            s_stats.thumb_used + cache_kept(cache_before(load)) + entry->size > s_cfg.budget) {
+        need_img = false;
+        s_stats.skips++;
+    }
+    xSemaphoreGive(s_lock);
+
+    if (need_img || need_thumb) {
+        int64_t start_us = esp_timer_get_time();
+        ret = cache_decode(entry->path, &img, need_thumb ? &thumb : NULL);
+        int64_t decode_us = esp_timer_get_time() - start_us;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_stats.decodes++;
+        s_stats.decode_us += decode_us;
+        if (ESP_OK == ret) {
+            entry->size = img.data_size;
+            if (thumb.data) {
+                *new_thumb = cache_insert_thumb(index, &thumb, load);
+                if (!*new_thumb) {
+                    free((void *)thumb.data);
+                }
+            }
+            if (need_img) {
+                cache_insert(index, &img, load);
+            } else {
+                free((void *)img.data);
+            }
+        }
+        xSemaphoreGive(s_lock);
+        ESP_LOGD(TAG, "%s decoded in %" PRId64 " ms", entry->path, decode_us / 1000);
+    }
+    xSemaphoreGive(s_decode_lock);
+    return ret;
+}
+
+static void cache_prefetch(size_t index, cache_load_t load)
+{
+    bool new_thumb = false;
+
+    if (ESP_OK == cache_load(index, load, &new_thumb) && new_thumb && s_cb) {
+        s_cb(index, &s_entries[index].thumb, s_cb_args);
+    }
+}
+
+static void cache_task(void *arg)
+{
+    size_t thumbs = s_cfg.thumb_size ? 0 : s_count;    // next image to make a thumbnail of
+    size_t index;
+
+    while (true) {
+        /* Neighbours of the image on screen first, thumbnails when there is nothing else to do */
+        if (pdTRUE == xQueueReceive(s_queue, &index, thumbs < s_count ? 0 : portMAX_DELAY)) {
+            cache_prefetch(index, CACHE_LOAD_PREFETCH);
+        } else {
+            cache_prefetch(thumbs++, CACHE_LOAD_THUMB);
+        }
+    }
+}
+
+const lv_img_dsc_t *image_cache_show(size_t index)
+{
+    bool new_thumb = false;
+
+    ESP_RETURN_ON_FALSE(s_entries && index < s_count, NULL, TAG, "invalid image %zu", index);
+    cache_entry_t *entry = &s_entries[index];
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_shown = index;        // pinned, the image shown before may be evicted from now on
+    bool hit = (NULL != entry->img.data);
+    if (hit) {
+        s_stats.hits++;
+        entry->stamp = ++s_clock;
+    } else {
+        s_stats.misses++;
+    }
+    xSemaphoreGive(s_lock);
+
+    /* A prefetch of this image may be running, the load waits for it instead of decoding twice */
+    if (!hit && ESP_OK == cache_load(index, CACHE_LOAD_SHOW, &new_thumb) && new_thumb && s_cb) {
+        s_cb(index, &entry->thumb, s_cb_args);
+    }
+
+    /* Next first, browsing forward is the common case */
+    if (s_cfg.budget) {
+        size_t next = (index + 1) % s_count;
+        size_t prev = (index + s_count - 1) % s_count;
+        xQueueSend(s_queue, &next, 0);
+        if (prev != next) {
+            xQueueSend(s_queue, &prev, 0);
+        }
+    }
+
+    return entry->img.data ? &entry->img : NULL;
+}
+
+void image_cache_get_stats(image_cache_stats_t *stats)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_stats;
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t image_cache_init(const image_cache_cfg_t *cfg, const char *const *paths, size_t count,
+                           image_cache_thumb_cb_t cb, void *user_data)
+{
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_FALSE(cfg && paths && count, ESP_ERR_INVALID_ARG, TAG, "invalid config");
+    ESP_RETURN_ON_FALSE(NULL == s_entries, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+
+    s_cfg = *cfg;
+    s_cb = cb;
+    s_cb_args = user_data;
+    s_entries = heap_caps_calloc(count, sizeof(cache_entry_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(NULL != s_entries, ESP_ERR_NO_MEM, TAG, "no mem for entries");
+    s_count = count;
+    for (size_t i = 0; i < count; i++) {
+        s_entries[i].path = strdup(paths[i]);
+        ESP_GOTO_ON_FALSE(NULL != s_entries[i].path, ESP_ERR_NO_MEM, err, TAG, "no mem for path");
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    s_decode_lock = xSemaphoreCreateMutex();
+    s_queue = xQueueCreate(CACHE_QUEUE_LEN, sizeof(size_t));
+    ESP_GOTO_ON_FALSE(s_lock && s_decode_lock && s_queue, ESP_ERR_NO_MEM, err, TAG, "no mem for cache");
+
+    BaseType_t ret_val = xTaskCreatePinnedToCore(cache_task, "Image Cache Task", CACHE_TASK_STACK_SIZE, NULL,
+                                                 cfg->task_priority, NULL, cfg->task_core);
+    ESP_GOTO_ON_FALSE(pdPASS == ret_val, ESP_FAIL, err, TAG, "Failed create image cache task");
+    return ESP_OK;
+
+err:
+    if (s_queue) {
+        vQueueDelete(s_queue);
+        s_queue = NULL;
+    }
+    if (s_decode_lock) {
+        vSemaphoreDelete(s_decode_lock);
+        s_decode_lock = NULL;
+    }
+    if (s_lock) {
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+    }
+    for (size_t i = 0; i < s_count; i++) {
+        free(s_entries[i].path);
+    }
+    free(s_entries);
+    s_entries = NULL;
+    s_count = 0;
+    return ret;
+}
@@ -0,0 +1,65 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    size_t budget;              /*!< Bytes of decoded frames and thumbnails kept, the image on screen is kept whatever
+                                     its size. Thumbnails get at most half of it. */
+    uint16_t thumb_size;        /*!< Longest side of the thumbnails, 0 for none */
+    int task_priority;          /*!< Prefetch task, below the LVGL task so it only uses idle time */
+    int task_core;
+} image_cache_cfg_t;
+
+typedef struct {
+    uint32_t hits;              /*!< Images shown without decoding */
+    uint32_t misses;            /*!< Images decoded while the user waited */
+    uint32_t decodes;           /*!< All decodes, prefetch and thumbnails included */
+    uint32_t evictions;
+    int64_t decode_us;          /*!< Time spent in all decodes */
+    size_t used;                /*!< Bytes of decoded frames and thumbnails held */
+    size_t thumb_used;          /*!< Part of used held by thumbnails */
+    uint32_t skips;             /*!< Prefetches and thumbnails given up for lack of room */
+} image_cache_stats_t;
+
+/**
+ * @brief Called when the thumbnail of an image is ready, the thumbnail is never freed
+ *
+ * @note Not called for images whose thumbnail does not fit in the budget
+ */
+typedef void (*image_cache_thumb_cb_t)(size_t index, const lv_img_dsc_t *thumb, void *user_data);
+
+/**
+ * @brief Start the cache for a list of PNG files, thumbnails are generated in the background
+ *
+ * @param paths     VFS paths, e.g. "/spiffs/a.png", copied
+ */
+esp_err_t image_cache_init(const image_cache_cfg_t *cfg, const char *const *paths, size_t count,
+                           image_cache_thumb_cb_t cb, void *user_data);
+
+/**
+ * @brief Get the decoded frame of an image, decoding it now on a miss, and prefetch its neighbours
+ *
+ * @note The frame stays valid until the next call, it is never evicted while shown
+ *
+ * @return RGB565 + alpha frame for lv_img_set_src(), NULL if the image could not be decoded
+ */
+const lv_img_dsc_t *image_cache_show(size_t index);
+
+void image_cache_get_stats(image_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,13 +5,24 @@
  */
 
 #include <dirent.h>
+#include <inttypes.h>
 
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "image_cache.h"
+
+#define IMAGE_PATH_MAX          (256)
+#define IMAGE_THUMB_SIZE        (32)
+#define IMAGE_MAX_NUM           (64)
 
 static const char *TAG = "main";
 
 static lv_group_t *g_btn_op_group = NULL;
+static lv_obj_t *g_img = NULL;
+static lv_obj_t *g_stats_label = NULL;
+static lv_obj_t *g_btns[IMAGE_MAX_NUM] = { NULL };
 
 static void image_display(void);
 
@@ -23,12 +34,8 @@ void app_main(void)
     /* Initialize display and LVGL */
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
 
     /* Set display brightness to 100% */
@@ -40,29 +47,51 @@ void app_main(void)
     image_display();
 }
 
-static void btn_event_cb(lv_event_t *event)
+static void image_stats_show(int64_t show_us)
 {
-    lv_obj_t *img = (lv_obj_t *) event->user_data;
-    const char *file_name = lv_list_get_btn_text(lv_obj_get_parent(event->target), event->target);
-    char *file_name_with_path = (char *) heap_caps_malloc(256, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    image_cache_stats_t stats;
+    image_cache_get_stats(&stats);
+
+    uint32_t shown = stats.hits + stats.misses;
+    lv_label_set_text_fmt(g_stats_label, "hit %" PRIu32 "%% (%" PRIu32 "/%" PRIu32 ")  decode %" PRId64 " ms\nshown in %" PRId64 " ms  cache %zu KB",
+                          shown ? stats.hits * 100 / shown : 0, stats.hits, shown,
+                          stats.decodes ? stats.decode_us / stats.decodes / 1000 : 0,
+                          show_us / 1000, stats.used / 1024);
+    ESP_LOGI(TAG, "shown in %" PRId64 " us, %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " decodes in %" PRId64 " ms, %" PRIu32 " evictions, %zu bytes cached, %zu of them thumbnails",
+             show_us, stats.hits, stats.misses, stats.decodes, stats.decode_us / 1000, stats.evictions, stats.used,
+             stats.thumb_used);
+}
 
-    if (NULL != file_name_with_path) {
-        /* Get full file name with mount point and folder path */
-        strcpy(file_name_with_path, "S:/spiffs/");
-        strcat(file_name_with_path, file_name);
+static void btn_event_cb(lv_event_t *event)
+{
+    size_t index = (size_t) event->user_data;
 
-        /* Set src of image with file name */
-        lv_img_set_src(img, file_name_with_path);
+    /* Decoded frames come from the cache, LVGL draws them as they are instead of opening the PNG again */
+    int64_t start_us = esp_timer_get_time();
+    const lv_img_dsc_t *frame = image_cache_show(index);
+    if (NULL != frame) {
+        /* The same descriptor may hold a new frame since it was last shown */
+        lv_img_cache_invalidate_src(frame);
+        lv_img_set_src(g_img, frame);
 
         /* Align object */
-        lv_obj_align(img, LV_ALIGN_CENTER, 80, 0);
+        lv_obj_align(g_img, LV_ALIGN_CENTER, 80, 0);
+    }
+    image_stats_show(esp_timer_get_time() - start_us);
 
-        /* Only for debug */
-        ESP_LOGI(TAG, "Display image file : %s", file_name_with_path);
+    /* Only for debug */
+    ESP_LOGI(TAG, "Display image file : %s", lv_list_get_btn_text(lv_obj_get_parent(event->target), event->target));
+}
 
-        /* Don't forget to free allocated memory */
-        free(file_name_with_path);
+/* Prefetch task, the icon of the list entry becomes the thumbnail */
+static void thumb_ready_cb(size_t index, const lv_img_dsc_t *thumb, void *user_data)
+{
+    bsp_display_lock(0);
+    lv_obj_t *icon = lv_obj_get_child(g_btns[index], 0);
+    if (icon && lv_obj_check_type(icon, &lv_img_class)) {
+        lv_img_set_src(icon, thumb);
     }
+    bsp_display_unlock();
 }
 
 static void image_display(void)
@@ -81,22 +110,44 @@ static void image_display(void)
     lv_obj_set_style_border_width(list, 0, LV_STATE_DEFAULT);
     lv_obj_align(list, LV_ALIGN_LEFT_MID, -15, 0);
 
-    lv_obj_t *img = lv_img_create(lv_scr_act());
+    g_img = lv_img_create(lv_scr_act());
+
+    g_stats_label = lv_label_create(lv_scr_act());
+    lv_label_set_text(g_stats_label, "");
+    lv_obj_align(g_stats_label, LV_ALIGN_BOTTOM_RIGHT, -5, -5);
 
     /* Get file name in storage */
     struct dirent *p_dirent = NULL;
     DIR *p_dir_stream = opendir("/spiffs");
+    static char paths[IMAGE_MAX_NUM][IMAGE_PATH_MAX];
+    const char *path_list[IMAGE_MAX_NUM];
+    size_t count = 0;
 
     /* Scan files in storage */
-    while (true) {
+    while (count < IMAGE_MAX_NUM) {
         p_dirent = readdir(p_dir_stream);
         if (NULL != p_dirent) {
+            /* Get full file name with mount point and folder path */
+            snprintf(paths[count], IMAGE_PATH_MAX, "/spiffs/%s", p_dirent->d_name);
+            path_list[count] = paths[count];
+
             lv_obj_t *btn = lv_list_add_btn(list, LV_SYMBOL_IMAGE, p_dirent->d_name);
             lv_group_add_obj(g_btn_op_group, btn);
-            lv_obj_add_event_cb(btn, btn_event_cb, LV_EVENT_CLICKED, (void *) img);
+            lv_obj_add_event_cb(btn, btn_event_cb, LV_EVENT_CLICKED, (void *) count);
+            g_btns[count++] = btn;
         } else {
-            closedir(p_dir_stream);
             break;
         }
     }
+    closedir(p_dir_stream);
+
+    if (count) {
+        image_cache_cfg_t cache_cfg = {
+            .budget = CONFIG_IMAGE_CACHE_SIZE * 1024,
+            .thumb_size = IMAGE_THUMB_SIZE,
+            .task_priority = 1,
+            .task_core = 1,
+        };
+        ESP_ERROR_CHECK(image_cache_init(&cache_cfg, path_list, count, thumb_ready_cb, NULL));
+    }
 }
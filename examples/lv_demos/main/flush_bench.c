@@ -0,0 +1,198 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include "sdkconfig.h"
+
+#if CONFIG_LV_DEMOS_FLUSH_BENCHMARK
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
+#include "demos/lv_demos.h"
+#include "flush_bench.h"
+
+typedef enum {
+    SCENE_FULL,         /* Whole screen redrawn every frame */
+    SCENE_SPINNER,      /* Only a spinner moves */
+    SCENE_MAX,
+} scene_t;
+
+static const char *TAG = "flush_bench";
+
+static const char *const s_scene_name[SCENE_MAX] = {
+    [SCENE_FULL] = "full screen",
+    [SCENE_SPINNER] = "spinner",
+};
+
+static const bsp_display_buf_mode_t s_modes[] = {
+    BSP_DISPLAY_BUF_SINGLE,
+    BSP_DISPLAY_BUF_DOUBLE,
+    BSP_DISPLAY_BUF_FULL,
+};
+
+static lv_disp_drv_t s_drv;
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_t *s_disp;
+static esp_timer_handle_t s_spi_timer;
+static void *s_buf[2];
+static volatile uint32_t s_frames;
+static volatile uint32_t s_refr_ms;
+
+static void spi_done_cb(void *arg)
+{
+    lv_disp_flush_ready(&s_drv);
+}
+
+static void bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map)
+{
+    /* Bits on the bus over the clock in MHz gives microseconds, as if a panel IO DMA transfer was started */
+    uint64_t us = (uint64_t)lv_area_get_size(area) * LV_COLOR_DEPTH / CONFIG_LV_DEMOS_BENCH_SPI_MHZ;
+    esp_timer_start_once(s_spi_timer, us + 1);
+}
+
+static void bench_monitor_cb(lv_disp_drv_t *drv, uint32_t time, uint32_t px)
+{
+    s_frames++;
+    s_refr_ms += time;
+}
+
+static void invalidate_timer_cb(lv_timer_t *timer)
+{
+    lv_obj_invalidate(lv_scr_act());
+}
+
+static void free_buffers(void)
+{
+    heap_caps_free(s_buf[0]);
+    heap_caps_free(s_buf[1]);
+    s_buf[0] = s_buf[1] = NULL;
+}
+
+/* Allocate like esp_lvgl_port would for the same configuration */
+static bool alloc_buffers(const bsp_display_cfg_t *cfg)
+{
+    uint32_t caps = MALLOC_CAP_DEFAULT;
+    if (cfg->flags.buff_spiram) {
+        caps = MALLOC_CAP_SPIRAM;
+    } else if (cfg->flags.buff_dma) {
+        caps = MALLOC_CAP_DMA;
+    }
+
+    s_buf[0] = heap_caps_malloc(cfg->buffer_size * sizeof(lv_color_t), caps);
+    if (cfg->double_buffer) {
+        s_buf[1] = heap_caps_malloc(cfg->buffer_size * sizeof(lv_color_t), caps);
+    }
+    if (!s_buf[0] || (cfg->double_buffer && !s_buf[1])) {
+        free_buffers();
+        return false;
+    }
+    lv_disp_draw_buf_init(&s_draw_buf, s_buf[0], s_buf[1], cfg->buffer_size);
+    return true;
+}
+
+static void run_scene(scene_t scene, bsp_display_buf_mode_t mode, const bsp_display_cfg_t *cfg)
+{
+    lv_timer_t *invalidate = NULL;
+    lv_obj_t *spinner = NULL;
+
+    lvgl_port_lock(0);
+    if (SCENE_FULL == scene) {
+        invalidate = lv_timer_create(invalidate_timer_cb, 1, NULL);
+    } else {
+        spinner = lv_spinner_create(lv_layer_top(), 1000, 60);
+        lv_obj_set_size(spinner, 80, 80);
+        lv_obj_center(spinner);
+    }
+    /* Let the first frame of the scene through before counting */
+    lv_refr_now(s_disp);
+    s_frames = 0;
+    s_refr_ms = 0;
+    lvgl_port_unlock();
+
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_LV_DEMOS_BENCH_SECONDS * 1000));
+
+    lvgl_port_lock(0);
+    uint32_t frames = s_frames;
+    uint32_t refr_ms = s_refr_ms;
+    if (invalidate) {
+        lv_timer_del(invalidate);
+    }
+    if (spinner) {
+        lv_obj_del(spinner);
+    }
+    lvgl_port_unlock();
+
+    ESP_LOGI(TAG, "%-12s %-7s %u x %6u B %-8s %5u frames %6.1f FPS %6.1f ms/frame", s_scene_name[scene],
+             mode == BSP_DISPLAY_BUF_SINGLE ? "single" : mode == BSP_DISPLAY_BUF_DOUBLE ? "double" : "full",
+             cfg->double_buffer ? 2 : 1, (unsigned)(cfg->buffer_size * sizeof(lv_color_t)),
+             cfg->flags.buff_spiram ? "PSRAM" : "internal", (unsigned)frames,
+             frames / (float)CONFIG_LV_DEMOS_BENCH_SECONDS, frames ? refr_ms / (float)frames : 0.0f);
+}
+
+void flush_bench_run(void)
+{
+    const lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
+    ESP_ERROR_CHECK(lvgl_port_init(&port_cfg));
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = spi_done_cb,
+        .name = "spi_sim",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &s_spi_timer));
+
+    ESP_LOGI(TAG, "%dx%d, %d MHz SPI, %d s per run", BSP_LCD_H_RES, BSP_LCD_V_RES,
+             CONFIG_LV_DEMOS_BENCH_SPI_MHZ, CONFIG_LV_DEMOS_BENCH_SECONDS);
+
+    for (size_t i = 0; i < sizeof(s_modes) / sizeof(s_modes[0]); i++) {
+        bsp_display_cfg_t cfg = { 0 };
+        if (bsp_display_buf_config(&cfg, s_modes[i]) != s_modes[i]) {
+            ESP_LOGW(TAG, "Mode %u not available here, skipped", (unsigned)s_modes[i]);
+            continue;
+        }
+
+        lvgl_port_lock(0);
+        /* The last area of a frame may still be on the simulated bus */
+        while (s_disp && s_draw_buf.flushing) {
+            vTaskDelay(1);
+        }
+        void *old[2] = { s_buf[0], s_buf[1] };
+        if (!alloc_buffers(&cfg)) {
+            s_buf[0] = old[0];
+            s_buf[1] = old[1];
+            lvgl_port_unlock();
+            ESP_LOGW(TAG, "Buffers for mode %u could not be allocated, skipped", (unsigned)s_modes[i]);
+            continue;
+        }
+        if (!s_disp) {
+            lv_disp_drv_init(&s_drv);
+            s_drv.hor_res = BSP_LCD_H_RES;
+            s_drv.ver_res = BSP_LCD_V_RES;
+            s_drv.flush_cb = bench_flush_cb;
+            s_drv.monitor_cb = bench_monitor_cb;
+            s_drv.draw_buf = &s_draw_buf;
+            s_disp = lv_disp_drv_register(&s_drv);
+            /* Refresh as fast as the buffers allow, not at LV_DISP_DEF_REFR_PERIOD */
+            lv_timer_set_period(s_disp->refr_timer, 1);
+            lv_demo_widgets();
+        } else {
+            lv_disp_drv_update(s_disp, &s_drv);
+        }
+        heap_caps_free(old[0]);
+        heap_caps_free(old[1]);
+        lvgl_port_unlock();
+
+        for (scene_t scene = 0; scene < SCENE_MAX; scene++) {
+            run_scene(scene, s_modes[i], &cfg);
+        }
+    }
+    ESP_LOGI(TAG, "Done");
+}
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Render the widgets demo without a panel and log the frame rate of every draw buffer mode
+ *
+ * @note Starts LVGL itself, the BSP display must not be started
+ */
+void flush_bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,22 +5,25 @@
  */
 
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 
 #include "demos/lv_demos.h"
+#include "flush_bench.h"
 
 void app_main(void)
 {
+#if CONFIG_LV_DEMOS_FLUSH_BENCHMARK
+    flush_bench_run();
+    return;
+#endif
+
     /* Initialize I2C (for touch and audio) */
     bsp_i2c_init();
     /* Initialize display and LVGL */
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
 
     /* Set display brightness to 100% */
@@ -18,12 +18,14 @@
 #include "app_led.h"
 #include "app_rmaker.h"
 #include "app_sr.h"
+#include "asset_pack.h"
 #include "audio_player.h"
 #include "file_iterator.h"
 #include "gui/ui_main.h"
 
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 
 static const char *TAG = "main";
 
@@ -113,15 +115,14 @@ void box_main(void)
             .task_max_sleep_ms = 500, \
             .timer_period_ms = 5,     \
         },
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
 
     bsp_board_init();
+    if (ESP_OK != asset_pack_init("assets", NULL)) {
+        ESP_LOGW(TAG, "UI runs without images and custom fonts");
+    }
 
     ESP_LOGI(TAG, "Display LVGL demo");
     bsp_display_backlight_on();
@@ -8,6 +8,7 @@
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "app_led.h"
 #include "app_sr.h"
 #include "settings.h"
@@ -102,11 +103,9 @@ void ui_about_us_start(void (*fn)(void))
     lv_obj_t *img = lv_img_create(page);
     lv_obj_align(img, LV_ALIGN_TOP_MID, 0, 20);
 #if CONFIG_BSP_BOARD_ESP32_S3_BOX_Lite
-    LV_IMG_DECLARE(icon_box_lite);
-    lv_img_set_src(img, &icon_box_lite);
+    lv_img_set_src(img, asset_pack_img("icon_box_lite"));
 #else
-    LV_IMG_DECLARE(icon_box);
-    lv_img_set_src(img, &icon_box);
+    lv_img_set_src(img, asset_pack_img("icon_box"));
 #endif
 
     char msg[256] = {0};
@@ -13,6 +13,7 @@
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "lv_symbol_extra_def.h"
 #include "app_wifi.h"
 #include "app_rmaker.h"
@@ -29,8 +30,6 @@
 
 static const char *TAG = "ui_main";
 
-LV_FONT_DECLARE(font_icon_16);
-
 static int g_item_index = 0;
 static lv_group_t *g_btn_op_group = NULL;
 static button_style_t g_btn_styles;
@@ -185,21 +184,15 @@ static void ui_help(void)
 
 typedef struct {
     char *name;
-    void *img_src;
+    const char *img_name;
 } item_desc_t;
 
-LV_IMG_DECLARE(icon_about_us)
-LV_IMG_DECLARE(icon_dev_ctrl)
-LV_IMG_DECLARE(icon_media_player)
-LV_IMG_DECLARE(icon_help)
-LV_IMG_DECLARE(icon_network)
-
 static item_desc_t item[] = {
-    { .name = "Device Control", .img_src = (void *) &icon_dev_ctrl},
-    { .name = "Network",        .img_src = (void *) &icon_network},
-    { .name = "Media Player",   .img_src = (void *) &icon_media_player},
-    { .name = "Help",           .img_src = (void *) &icon_help},
-    { .name = "About Us",       .img_src = (void *) &icon_about_us},
+    { .name = "Device Control", .img_name = "icon_dev_ctrl"},
+    { .name = "Network",        .img_name = "icon_network"},
+    { .name = "Media Player",   .img_name = "icon_media_player"},
+    { .name = "Help",           .img_name = "icon_help"},
+    { .name = "About Us",       .img_name = "icon_about_us"},
 };
 
 static lv_obj_t *g_img_btn, *g_img_item = NULL;
@@ -265,7 +258,7 @@ void menu_new_item_select(lv_obj_t *obj)
     g_item_index = menu_get_num_offset(g_item_index, g_item_size, direct);
 
     lv_led_on(g_led_item[g_item_index]);
-    lv_img_set_src(g_img_item, item[g_item_index].img_src);
+    lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
     lv_label_set_text_static(g_lab_item, item[g_item_index].name);
 }
 
@@ -308,7 +301,7 @@ static void menu_prev_cb(lv_event_t *e)
         }
         g_item_index--;
         lv_led_on(g_led_item[g_item_index]);
-        lv_img_set_src(g_img_item, item[g_item_index].img_src);
+        lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
         lv_label_set_text_static(g_lab_item, item[g_item_index].name);
     }
 }
@@ -324,7 +317,7 @@ static void menu_next_cb(lv_event_t *e)
             g_item_index = 0;
         }
         lv_led_on(g_led_item[g_item_index]);
-        lv_img_set_src(g_img_item, item[g_item_index].img_src);
+        lv_img_set_src(g_img_item, asset_pack_img(item[g_item_index].img_name));
         lv_label_set_text_static(g_lab_item, item[g_item_index].name);
     }
 }
@@ -415,7 +408,7 @@ static void ui_main_menu(int32_t index_id)
     lv_obj_add_event_cb(g_img_btn, menu_enter_cb, LV_EVENT_ALL, g_img_btn);
 
     g_img_item = lv_img_create(g_img_btn);
-    lv_img_set_src(g_img_item, item[index_id].img_src);
+    lv_img_set_src(g_img_item, asset_pack_img(item[index_id].img_name));
     lv_obj_center(g_img_item);
 
     g_lab_item = lv_label_create(obj);
@@ -564,7 +557,7 @@ esp_err_t ui_main_start(void)
     lv_obj_align_to(g_lab_wifi, lab_time, LV_ALIGN_OUT_RIGHT_MID, 10, 0);
 
     g_lab_cloud = lv_label_create(g_status_bar);
-    lv_obj_set_style_text_font(g_lab_cloud, &font_icon_16, LV_PART_MAIN);
+    lv_obj_set_style_text_font(g_lab_cloud, asset_pack_font("font_icon_16"), LV_PART_MAIN);
     lv_obj_align_to(g_lab_cloud, g_lab_wifi, LV_ALIGN_OUT_RIGHT_MID, 5, 0);
 
     ui_status_bar_set_visible(0);
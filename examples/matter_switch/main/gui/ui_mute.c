@@ -8,13 +8,9 @@
 #include <stdint.h>
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 
-LV_IMG_DECLARE(mute_on)
-LV_IMG_DECLARE(mute_off)
-
-LV_FONT_DECLARE(font_en_16)
-
 static int32_t mute_disp_count = 15;
 static const int32_t disp_time = 15;
 static bool mute_state = false;
@@ -33,9 +29,9 @@ static void mute_timer_cb(lv_timer_t *timer)
     if (mute_disp_count <= disp_time) {
         if (mute_disp_count == 0) {
             if (mute_state) {
-                lv_img_set_src(img, &mute_on);
+                lv_img_set_src(img, asset_pack_img("mute_on"));
             } else {
-                lv_img_set_src(img, &mute_off);
+                lv_img_set_src(img, asset_pack_img("mute_off"));
             }
         } else if (disp_time != mute_disp_count) {
             lv_obj_clear_flag(obj, LV_OBJ_FLAG_HIDDEN);
@@ -69,12 +65,12 @@ void ui_mute_init(void)
 
         lv_obj_t *lab = lv_label_create(obj);
         lv_label_set_text_static(lab, "Voice Command");
-        lv_obj_set_style_text_font(lab, &font_en_16, LV_STATE_DEFAULT);
+        lv_obj_set_style_text_font(lab, asset_pack_font("font_en_16"), LV_STATE_DEFAULT);
         lv_obj_set_style_text_color(lab, lv_color_black(), LV_STATE_DEFAULT);
         lv_obj_align(lab, LV_ALIGN_CENTER, 10, 0);
 
         img = lv_img_create(obj);
-        lv_img_set_src(img, &mute_on);
+        lv_img_set_src(img, asset_pack_img("mute_on"));
         lv_obj_align(img, LV_ALIGN_CENTER, -70, 0);
         lv_obj_set_user_data(obj, (void *) img);
     }
@@ -8,6 +8,7 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "app_wifi.h"
 #include "app_rmaker.h"
 #include "ui_main.h"
@@ -143,7 +144,6 @@ void ui_net_config_update_cb(ui_net_state_t state, void *args)
         /* code */
         break;
     case UI_NET_EVT_GET_NAME: {
-        LV_IMG_DECLARE(esp_logo_tiny);
         const char *prov_msg = app_wifi_get_prov_payload();
         size_t prov_msg_len = strlen(prov_msg);
         g_qr = lv_qrcode_create(g_page, 108, lv_color_black(), lv_color_white());
@@ -162,7 +162,7 @@ void ui_net_config_update_cb(ui_net_state_t state, void *args)
         }
         lv_obj_align(g_qr, LV_ALIGN_TOP_MID, 0, 8);
         lv_obj_t *img = lv_img_create(g_qr);
-        lv_img_set_src(img, &esp_logo_tiny);
+        lv_img_set_src(img, asset_pack_img("esp_logo_tiny"));
         lv_obj_center(img);
         lv_qrcode_update(g_qr, prov_msg, prov_msg_len);
         lv_obj_clear_flag(g_hint_lab, LV_OBJ_FLAG_HIDDEN);
@@ -188,9 +188,8 @@ void ui_net_config_update_cb(ui_net_state_t state, void *args)
     case UI_NET_EVT_CLOUD_CONNECTED: {
         char ssid[64] = {0};
         app_wifi_get_wifi_ssid(ssid, sizeof(ssid));
-        LV_IMG_DECLARE(icon_rmaker);
         g_img = lv_img_create(g_page);
-        lv_img_set_src(g_img, &icon_rmaker);
+        lv_img_set_src(g_img, asset_pack_img("icon_rmaker"));
         lv_obj_align(g_img, LV_ALIGN_CENTER, 0, -10);
         lv_obj_clear_flag(g_hint_lab, LV_OBJ_FLAG_HIDDEN);
         lv_label_set_text_fmt(g_hint_lab, "Device already connected to cloud\n"
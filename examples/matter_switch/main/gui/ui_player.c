@@ -9,6 +9,7 @@
 #include "audio_player.h"
 #include "file_iterator.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 #include "settings.h"
 
@@ -200,9 +201,8 @@ void ui_media_player(void (*fn)(void))
     bsp_btn_register_callback(BSP_BUTTON_MAIN, BUTTON_PRESS_UP, btn_return_down_cb, (void *)btn_return);
 #endif
 
-    LV_IMG_DECLARE(img_music)
     lv_obj_t *img = lv_img_create(page);
-    lv_img_set_src(img, &img_music);
+    lv_img_set_src(img, asset_pack_img("img_music"));
     lv_obj_align(img, LV_ALIGN_TOP_RIGHT, -10, 35);
 
     g_lab_file = lv_label_create(page);
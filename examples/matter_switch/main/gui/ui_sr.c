@@ -7,14 +7,12 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 #include "ui_player.h"
 
 static const char *TAG = "ui_sr";
 
-LV_FONT_DECLARE(font_cn_gb1_28);
-
-
 static bool g_sr_anim_active = false;
 static int32_t g_sr_anim_count = 0;
 static lv_obj_t *g_sr_label = NULL;
@@ -162,13 +160,13 @@ void ui_sr_anim_init(void)
     lv_obj_set_style_shadow_opa(obj_img, LV_OPA_30, LV_STATE_DEFAULT);
     lv_obj_align(obj_img, LV_ALIGN_CENTER, 0, -30);
     lv_obj_t *img_mic_logo = lv_img_create(obj_img);
-    LV_IMG_DECLARE(mic_logo)
-    lv_img_set_src(img_mic_logo, &mic_logo);
+    lv_img_set_src(img_mic_logo, asset_pack_img("mic_logo"));
     lv_obj_center(img_mic_logo);
 
     g_sr_label = lv_label_create(g_sr_mask);
     lv_label_set_text_static(g_sr_label, "----");
-    lv_obj_set_style_text_font(g_sr_label, &font_cn_gb1_28, LV_STATE_DEFAULT);
+    /* The 28 px font of the Chinese commands has no source in the tree, the 16 px one of the hints has the glyphs */
+    lv_obj_set_style_text_font(g_sr_label, asset_pack_font("font_cn_gb1_16"), LV_STATE_DEFAULT);
     lv_obj_set_style_text_color(g_sr_label, lv_color_black(), LV_STATE_DEFAULT);
     lv_obj_align(g_sr_label, LV_ALIGN_CENTER, 0, 80);
     lv_obj_add_event_cb(g_sr_label, sr_label_event_handler, LV_EVENT_VALUE_CHANGED, NULL);
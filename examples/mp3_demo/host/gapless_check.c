@@ -0,0 +1,366 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/*
+ * Writes synthetic WAV and MP3 files, plays them back to back through playlist_open() and measures the
+ * gap at the switch in the output: for WAV the samples between the last of the first file and the first
+ * of the second, for MP3 the frames decoded as silence and the bytes that are no frame.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "playlist.h"
+
+#define WAV_RATE            44100
+#define WAV_A_FRAMES        22050
+#define WAV_B_FRAMES        11025
+
+#define MP3_FRAME_LEN       417     /* MPEG-1 Layer III, 128 kbps, 44.1 kHz, no padding */
+#define MP3_FRAME_LEN_48K   384
+#define MP3_FRAME_SAMPLES   1152
+#define MP3_A_FRAMES        40
+#define MP3_B_FRAMES        25
+#define MP3_ID3_SIZE        300
+
+typedef struct {
+    char paths[3][64];
+    size_t count;
+    size_t switches[4];
+    size_t switch_count;
+} list_t;
+
+static bool get_path(size_t index, char *path, size_t len, void *ctx)
+{
+    list_t *list = (list_t *) ctx;
+    if (index >= list->count) {
+        return false;
+    }
+    snprintf(path, len, "%s", list->paths[index]);
+    return true;
+}
+
+static void on_track(size_t index, void *ctx)
+{
+    list_t *list = (list_t *) ctx;
+    if (list->switch_count < sizeof(list->switches) / sizeof(list->switches[0])) {
+        list->switches[list->switch_count] = index;
+    }
+    list->switch_count++;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; i++) {
+        p[i] = v >> (8 * i);
+    }
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f || fwrite(data, 1, len, f) != len) {
+        fprintf(stderr, "Write %s failed\n", path);
+        exit(2);
+    }
+    fclose(f);
+}
+
+/* One continuous signal across both files, a different tone per channel so a swap shows */
+static void wav_sample(size_t n, int16_t out[2])
+{
+    out[0] = 12000 * sin(2 * M_PI * 440 * (n + 1) / WAV_RATE);
+    out[1] = 12000 * sin(2 * M_PI * 660 * (n + 1) / WAV_RATE);
+}
+
+/*
+ * A LIST chunk of odd size before the data, a chunk after it, and with odd_tail half a sample
+ * more in the data chunk, all of which must not be played
+ */
+static void write_wav(const char *path, uint32_t rate, size_t first, size_t frames, bool odd_tail)
+{
+    static const char list[] = "LIST\x05\x00\x00\x00INFO!\x00";
+    static const char trailer[] = "id3 \x04\x00\x00\x00\x7f\x7f\x7f\x7f";
+    size_t data_len = frames * 4 + (odd_tail ? 2 : 0);
+    size_t len = 12 + 24 + sizeof(list) - 1 + 8 + data_len + sizeof(trailer) - 1;
+    uint8_t *buf = calloc(1, len);
+    uint8_t *p = buf;
+
+    memcpy(p, "RIFF", 4);
+    put_le(p + 4, len - 8, 4);
+    memcpy(p + 8, "WAVE", 4);
+    p += 12;
+    memcpy(p, "fmt ", 4);
+    put_le(p + 4, 16, 4);
+    put_le(p + 8, 1, 2);
+    put_le(p + 10, 2, 2);
+    put_le(p + 12, rate, 4);
+    put_le(p + 16, rate * 4, 4);
+    put_le(p + 20, 4, 2);
+    put_le(p + 22, 16, 2);
+    p += 24;
+    memcpy(p, list, sizeof(list) - 1);
+    p += sizeof(list) - 1;
+    memcpy(p, "data", 4);
+    put_le(p + 4, data_len, 4);
+    p += 8;
+    for (size_t i = 0; i < frames; i++, p += 4) {
+        int16_t s[2];
+        wav_sample(first + i, s);
+        put_le(p, (uint16_t) s[0], 2);
+        put_le(p + 2, (uint16_t) s[1], 2);
+    }
+    if (odd_tail) {
+        p[0] = p[1] = 0x55;
+        p += 2;
+    }
+    memcpy(p, trailer, sizeof(trailer) - 1);
+
+    write_file(path, buf, len);
+    free(buf);
+}
+
+static uint8_t *read_all(FILE *fp, size_t *len)
+{
+    size_t cap = 1 << 20;
+    uint8_t *buf = malloc(cap);
+    *len = 0;
+    size_t got;
+    while ((got = fread(buf + *len, 1, cap - *len, fp)) > 0) {
+        *len += got;
+        if (*len == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    return buf;
+}
+
+static int check_wav(const char *dir)
+{
+    list_t list = { .count = 3 };
+    snprintf(list.paths[0], sizeof(list.paths[0]), "%s/a.wav", dir);
+    snprintf(list.paths[1], sizeof(list.paths[1]), "%s/b.wav", dir);
+    snprintf(list.paths[2], sizeof(list.paths[2]), "%s/c.wav", dir);
+    write_wav(list.paths[0], WAV_RATE, 0, WAV_A_FRAMES, false);
+    write_wav(list.paths[1], WAV_RATE, WAV_A_FRAMES, WAV_B_FRAMES, true);
+    write_wav(list.paths[2], 48000, 0, 4800, false);
+
+    playlist_config_t config = {
+        .count = list.count,
+        .get_path = get_path,
+        .on_track = on_track,
+        .ctx = &list,
+    };
+    FILE *fp = playlist_open(&config, 0);
+    if (!fp) {
+        fprintf(stderr, "Open failed\n");
+        return 1;
+    }
+    size_t len;
+    uint8_t *out = read_all(fp, &len);
+    fclose(fp);
+
+    /* The player reads the header of the first file, the PCM follows its data chunk header */
+    size_t data = 0;
+    for (size_t i = 12; i + 8 <= len; i++) {
+        if (!memcmp(out + i, "data", 4)) {
+            data = i + 8;
+            break;
+        }
+    }
+    size_t frames = (len - data) / 4;
+
+    /* Where the second file starts in the output, and the longest run of silent samples */
+    int16_t first_b[2];
+    wav_sample(WAV_A_FRAMES, first_b);
+    size_t b_at = SIZE_MAX;
+    size_t mismatches = 0;
+    size_t silence = 0, run = 0;
+    size_t source_silence = 0, source_run = 0;
+    for (size_t i = 0; i < frames; i++) {
+        int16_t s[2] = { (int16_t) (out[data + 4 * i] | out[data + 4 * i + 1] << 8),
+                         (int16_t) (out[data + 4 * i + 2] | out[data + 4 * i + 3] << 8)
+                       };
+        int16_t expect[2];
+        wav_sample(i, expect);
+        mismatches += s[0] != expect[0] || s[1] != expect[1];
+        if (SIZE_MAX == b_at && i >= WAV_A_FRAMES - 1 && s[0] == first_b[0] && s[1] == first_b[1]) {
+            b_at = i;
+        }
+        run = 0 == s[0] && 0 == s[1] ? run + 1 : 0;
+        silence = run > silence ? run : silence;
+        source_run = 0 == expect[0] && 0 == expect[1] ? source_run + 1 : 0;
+        source_silence = source_run > source_silence ? source_run : source_silence;
+    }
+    free(out);
+
+    long gap = SIZE_MAX == b_at ? -1 : (long) b_at - WAV_A_FRAMES;
+    /* The 48 kHz file must not follow */
+    bool stopped = WAV_A_FRAMES + WAV_B_FRAMES == frames && 1 == list.switch_count && 1 == list.switches[0];
+    printf("wav: %zu samples out of %d expected, %zu differ, gap at the switch %ld samples, "
+           "longest silence %zu samples (%zu in the source), stopped before the 48 kHz file: %s\n",
+           frames, WAV_A_FRAMES + WAV_B_FRAMES, mismatches, gap, silence, source_silence,
+           stopped ? "yes" : "no");
+    return stopped && 0 == mismatches && 0 == gap && silence <= source_silence ? 0 : 1;
+}
+
+static size_t put_mp3_frame(uint8_t *p, bool rate_48k, int track, int no, const char *info)
+{
+    size_t len = rate_48k ? MP3_FRAME_LEN_48K : MP3_FRAME_LEN;
+    memset(p, 0, len);
+    p[0] = 0xFF;
+    p[1] = 0xFB;                        /* MPEG-1 Layer III, no CRC */
+    p[2] = rate_48k ? 0x94 : 0x90;      /* 128 kbps, no padding */
+    p[3] = 0x00;                        /* Stereo */
+    if (info) {
+        memcpy(p + 4 + 32, info, 4);
+    } else {
+        p[4 + 32] = 'A' + track;
+        put_le(p + 4 + 33, no, 2);
+        memset(p + 4 + 35, 0xA5, len - 4 - 35);
+    }
+    return len;
+}
+
+static size_t put_id3v2(uint8_t *p)
+{
+    memcpy(p, "ID3\x03\x00\x00", 6);
+    uint32_t size = MP3_ID3_SIZE;
+    p[6] = (size >> 21) & 0x7F;
+    p[7] = (size >> 14) & 0x7F;
+    p[8] = (size >> 7) & 0x7F;
+    p[9] = size & 0x7F;
+    memset(p + 10, 'T', MP3_ID3_SIZE);
+    return 10 + MP3_ID3_SIZE;
+}
+
+static size_t build_mp3(uint8_t *buf, bool rate_48k, int track, int frames, const char *info)
+{
+    uint8_t *p = buf;
+    p += put_id3v2(p);
+    p += put_mp3_frame(p, rate_48k, track, 0, info);
+    for (int i = 0; i < frames; i++) {
+        p += put_mp3_frame(p, rate_48k, track, i, NULL);
+    }
+    memcpy(p, "TAG", 3);
+    memset(p + 3, 'x', 125);
+    p += 128;
+    return p - buf;
+}
+
+typedef struct {
+    int frames[2];          /* Audio frames of A and B, in order */
+    int silent;             /* Info frames after the first audio frame */
+    size_t junk;            /* Bytes that are no frame, after the first audio frame */
+    bool in_order;
+} mp3_walk_t;
+
+static mp3_walk_t walk_mp3(const uint8_t *buf, size_t len)
+{
+    mp3_walk_t walk = { .in_order = true };
+    bool started = false;
+    int last_track = 0, last_no = -1;
+    size_t i = 10 + MP3_ID3_SIZE;           /* The ID3v2 tag of the first file is the player's business */
+    while (i < len) {
+        if (i + MP3_FRAME_LEN > len || 0xFF != buf[i] || 0xFB != buf[i + 1]) {
+            walk.junk += started;
+            i++;
+            continue;
+        }
+        const uint8_t *tag = buf + i + 4 + 32;
+        if (!memcmp(tag, "Info", 4) || !memcmp(tag, "Xing", 4)) {
+            walk.silent += started;
+        } else {
+            int track = tag[0] - 'A';
+            int no = tag[1] | tag[2] << 8;
+            walk.in_order &= (track == last_track && no == last_no + 1) || (track == last_track + 1 && 0 == no);
+            last_track = track;
+            last_no = no;
+            walk.frames[track & 1]++;
+            started = true;
+        }
+        i += MP3_FRAME_LEN;
+    }
+    return walk;
+}
+
+static int check_mp3(const char *dir)
+{
+    size_t cap = 2 * (10 + MP3_ID3_SIZE + 128 + (MP3_A_FRAMES + 1) * MP3_FRAME_LEN);
+    uint8_t *a = malloc(cap), *b = malloc(cap), *c = malloc(cap);
+    size_t a_len = build_mp3(a, false, 0, MP3_A_FRAMES, "Info");
+    size_t b_len = build_mp3(b, false, 1, MP3_B_FRAMES, "Xing");
+    size_t c_len = build_mp3(c, true, 2, MP3_B_FRAMES, "Info");
+
+    list_t list = { .count = 3 };
+    snprintf(list.paths[0], sizeof(list.paths[0]), "%s/a.mp3", dir);
+    snprintf(list.paths[1], sizeof(list.paths[1]), "%s/b.mp3", dir);
+    snprintf(list.paths[2], sizeof(list.paths[2]), "%s/c.mp3", dir);
+    write_file(list.paths[0], a, a_len);
+    write_file(list.paths[1], b, b_len);
+    write_file(list.paths[2], c, c_len);
+
+    /* The files one after the other, as a player restarting on each would meet them */
+    uint8_t *joined = malloc(a_len + b_len);
+    memcpy(joined, a, a_len);
+    memcpy(joined + a_len, b, b_len);
+    mp3_walk_t plain = walk_mp3(joined, a_len + b_len);
+    free(joined);
+
+    playlist_config_t config = {
+        .count = list.count,
+        .get_path = get_path,
+        .on_track = on_track,
+        .ctx = &list,
+    };
+    FILE *fp = playlist_open(&config, 0);
+    if (!fp) {
+        fprintf(stderr, "Open failed\n");
+        return 1;
+    }
+    size_t len;
+    uint8_t *out = read_all(fp, &len);
+    fclose(fp);
+    mp3_walk_t walk = walk_mp3(out, len);
+    free(out);
+    free(a);
+    free(b);
+    free(c);
+
+    bool stopped = MP3_A_FRAMES == walk.frames[0] && MP3_B_FRAMES == walk.frames[1]
+                   && 1 == list.switch_count && 1 == list.switches[0];
+    printf("mp3: %d + %d frames in order: %s, gap at the switch %d samples of silence and %zu bytes of tags "
+           "(plain concatenation: %d samples, %zu bytes), stopped before the 48 kHz file: %s\n",
+           walk.frames[0], walk.frames[1], walk.in_order ? "yes" : "no", walk.silent * MP3_FRAME_SAMPLES,
+           walk.junk, plain.silent * MP3_FRAME_SAMPLES, plain.junk, stopped ? "yes" : "no");
+    return stopped && walk.in_order && 0 == walk.silent && 0 == walk.junk ? 0 : 1;
+}
+
+int main(void)
+{
+    char dir[] = "/tmp/gapless.XXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 2;
+    }
+
+    int failed = check_wav(dir);
+    failed |= check_mp3(dir);
+
+    const char *names[] = { "a.wav", "b.wav", "c.wav", "a.mp3", "b.mp3", "c.mp3" };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        unlink(path);
+    }
+    rmdir(dir);
+    return failed;
+}
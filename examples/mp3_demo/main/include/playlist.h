@@ -0,0 +1,53 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "audio_readahead.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Full path of a playlist entry, false if there is none
+ */
+typedef bool (*playlist_path_fn_t)(size_t index, char *path, size_t len, void *ctx);
+
+/**
+ * @brief A track after the first one starts, called from the task reading the stream
+ */
+typedef void (*playlist_track_fn_t)(size_t index, void *ctx);
+
+typedef struct {
+    size_t count;                               /*!< Entries, the first one follows the last */
+    playlist_path_fn_t get_path;
+    playlist_track_fn_t on_track;               /*!< May be NULL */
+    void *ctx;
+    const audio_readahead_config_t *readahead;  /*!< Of each track, NULL for the default */
+} playlist_config_t;
+
+/**
+ * @brief Open a stream that plays the playlist from an entry on, for audio_player_play()
+ *
+ * The stream is the entry as a file. While it plays, the next entry is opened and its header and first
+ * frames are checked on another task. If it has the same sample format, the stream continues with its
+ * audio data right after the last frame of the current one, so the player neither stops nor reconfigures
+ * its output. Otherwise the stream ends there and the player goes idle as with a plain file.
+ *
+ * Tags and MP3 info frames of the following entries are left out, WAV data is cut to whole samples.
+ *
+ * @param config Copied
+ * @return Stream, fclose() releases everything, NULL if the entry cannot be opened
+ */
+FILE *playlist_open(const playlist_config_t *config, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
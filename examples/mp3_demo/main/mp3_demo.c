@@ -6,6 +6,7 @@
 
 #include "audio_player.h"
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 #include "esp_check.h"
 #include "esp_log.h"
 #include "file_iterator.h"
@@ -345,12 +346,8 @@ void app_main(void)
     /* Initialize display and LVGL */
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
 
     /* Set display brightness to 100% */
@@ -0,0 +1,483 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ */
+
+/* fopencookie() */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "esp_log.h"
+#include "playlist.h"
+
+/* Offset type of cookie_seek_function_t */
+#if defined(__NEWLIB__) && defined(__LARGE64_FILES)
+typedef _off64_t cookie_off_t;
+#elif defined(__NEWLIB__)
+typedef off_t cookie_off_t;
+#else
+typedef off64_t cookie_off_t;
+#endif
+
+#define PATH_MAX_LEN        256
+#define PROBE_WINDOW        (8 * 1024)      /* Searched for the first MP3 frame after the ID3v2 tag */
+#define PROBE_FRAMES        3               /* Consecutive valid frame headers to trust the first one */
+
+static const char *TAG = "playlist";
+
+typedef enum {
+    CODEC_NONE = 0,
+    CODEC_WAV,
+    CODEC_MP3,
+} codec_t;
+
+typedef struct {
+    codec_t codec;
+    uint32_t rate;
+    uint16_t channels;
+    uint16_t bits;
+} track_format_t;
+
+typedef struct {
+    FILE *fp;
+    size_t index;
+    track_format_t fmt;
+    int64_t start;                  /* Audio data in the file, without header, tags or MP3 info frame */
+    int64_t end;
+    int64_t pos;                    /* File offset of the next byte read from fp */
+} track_t;
+
+typedef enum {
+    NEXT_NONE,
+    NEXT_PREPARING,
+    NEXT_READY,
+    NEXT_FAILED,
+} next_state_t;
+
+typedef struct {
+    playlist_config_t config;
+    audio_readahead_config_t readahead;
+    track_t cur;
+    track_t next;
+    int64_t out_pos;                /* Bytes returned by the stream */
+    bool spliced;                   /* A track was appended, the stream can no longer seek */
+
+    /* Shared with the preparer */
+    pthread_t preparer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    next_state_t next_state;
+    bool stop;
+} stream_t;
+
+typedef struct {
+    uint32_t len;
+    uint32_t rate;
+    uint16_t channels;
+    bool mpeg1;
+} mp3_frame_t;
+
+static uint32_t read_le(const uint8_t *p, int bytes)
+{
+    uint32_t v = 0;
+    while (bytes--) {
+        v = (v << 8) | p[bytes];
+    }
+    return v;
+}
+
+/* Layer III only, the layer the player decodes */
+static bool mp3_parse_header(const uint8_t *h, mp3_frame_t *frame)
+{
+    static const uint16_t bitrates[2][16] = {
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160, 0 },
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 0 },
+    };
+    static const uint16_t rates[3] = { 44100, 48000, 32000 };
+    static const uint8_t rate_shift[4] = { 2, 0, 1, 0 };
+
+    if (0xFF != h[0] || 0xE0 != (h[1] & 0xE0)) {
+        return false;
+    }
+    int version = (h[1] >> 3) & 3;      /* 0: 2.5, 2: 2, 3: 1 */
+    int layer = (h[1] >> 1) & 3;
+    int bitrate_idx = h[2] >> 4;
+    int rate_idx = (h[2] >> 2) & 3;
+    if (1 == version || 1 != layer || 0 == bitrate_idx || 15 == bitrate_idx || 3 == rate_idx) {
+        return false;
+    }
+
+    frame->mpeg1 = 3 == version;
+    frame->rate = rates[rate_idx] >> rate_shift[version];
+    frame->channels = 3 == (h[3] >> 6) ? 1 : 2;
+    uint32_t bitrate = bitrates[frame->mpeg1][bitrate_idx] * 1000;
+    frame->len = (frame->mpeg1 ? 144 : 72) * bitrate / frame->rate + ((h[2] >> 1) & 1);
+    return true;
+}
+
+/* Xing, Info or VBRI frame at the start of a stream, decoded it is a frame of silence */
+static bool mp3_is_info_frame(const uint8_t *frame, size_t avail, const mp3_frame_t *hdr)
+{
+    size_t side_info = hdr->mpeg1 ? (1 == hdr->channels ? 17 : 32) : (1 == hdr->channels ? 9 : 17);
+    size_t xing = 4 + side_info;
+    if (xing + 4 <= avail && (!memcmp(frame + xing, "Xing", 4) || !memcmp(frame + xing, "Info", 4))) {
+        return true;
+    }
+    return 40 <= avail && !memcmp(frame + 36, "VBRI", 4);
+}
+
+static bool probe_mp3(FILE *fp, int64_t size, track_t *track)
+{
+    uint8_t hdr[10];
+    int64_t audio = 0;
+    if (fseek(fp, 0, SEEK_SET) || fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) {
+        return false;
+    }
+    if (!memcmp(hdr, "ID3", 3)) {
+        audio = 10 + ((hdr[6] & 0x7F) << 21 | (hdr[7] & 0x7F) << 14 | (hdr[8] & 0x7F) << 7 | (hdr[9] & 0x7F));
+        if (hdr[5] & 0x10) {
+            audio += 10;                /* Footer */
+        }
+    }
+
+    uint8_t *window = malloc(PROBE_WINDOW);
+    if (NULL == window || fseek(fp, audio, SEEK_SET)) {
+        free(window);
+        return false;
+    }
+    size_t avail = fread(window, 1, PROBE_WINDOW, fp);
+
+    /* The first header followed by PROBE_FRAMES - 1 more of the same format, or by the end of the file */
+    bool found = false;
+    mp3_frame_t first;
+    size_t at;
+    for (at = 0; at + 4 <= avail; at++) {
+        if (!mp3_parse_header(window + at, &first)) {
+            continue;
+        }
+        size_t next = at + first.len;
+        int frames = 1;
+        mp3_frame_t frame;
+        while (frames < PROBE_FRAMES && next + 4 <= avail && mp3_parse_header(window + next, &frame)
+                && frame.rate == first.rate && frame.channels == first.channels) {
+            next += frame.len;
+            frames++;
+        }
+        if (PROBE_FRAMES == frames || audio + (int64_t) next >= size) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        free(window);
+        return false;
+    }
+    bool info = mp3_is_info_frame(window + at, avail - at, &first);
+    free(window);
+
+    track->fmt = (track_format_t) {
+        .codec = CODEC_MP3,
+        .rate = first.rate,
+        .channels = first.channels,
+        .bits = 16,
+    };
+    track->start = audio + at + (info ? first.len : 0);
+    track->end = size;
+
+    /* ID3v1 and APEv2 tags at the end */
+    uint8_t tail[32];
+    if (track->end - 128 >= track->start && 0 == fseek(fp, track->end - 128, SEEK_SET)
+            && 3 == fread(tail, 1, 3, fp) && !memcmp(tail, "TAG", 3)) {
+        track->end -= 128;
+    }
+    if (track->end - 32 >= track->start && 0 == fseek(fp, track->end - 32, SEEK_SET)
+            && sizeof(tail) == fread(tail, 1, sizeof(tail), fp) && !memcmp(tail, "APETAGEX", 8)) {
+        int64_t ape = read_le(tail + 12, 4) + ((tail[23] & 0x80) ? 32 : 0);
+        if (track->end - ape >= track->start) {
+            track->end -= ape;
+        }
+    }
+    return true;
+}
+
+static bool probe_wav(FILE *fp, int64_t size, track_t *track)
+{
+    uint8_t hdr[16];
+    if (fseek(fp, 0, SEEK_SET) || fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        return false;
+    }
+
+    uint16_t block_align = 0;
+    int64_t pos = 12;
+    while (pos + 8 <= size) {
+        if (fseek(fp, pos, SEEK_SET) || fread(hdr, 1, 8, fp) != 8) {
+            return false;
+        }
+        uint32_t chunk = read_le(hdr + 4, 4);
+        if (!memcmp(hdr, "fmt ", 4)) {
+            if (chunk < 16 || fread(hdr, 1, 16, fp) != 16 || 1 != read_le(hdr, 2)) {
+                return false;       /* Not PCM */
+            }
+            track->fmt = (track_format_t) {
+                .codec = CODEC_WAV,
+                .channels = read_le(hdr + 2, 2),
+                .rate = read_le(hdr + 4, 4),
+                .bits = read_le(hdr + 14, 2),
+            };
+            block_align = read_le(hdr + 12, 2);
+        } else if (!memcmp(hdr, "data", 4)) {
+            if (!block_align) {
+                return false;
+            }
+            track->start = pos + 8;
+            /* Streamed WAVs leave the size at 0 or all ones */
+            track->end = chunk && 0xFFFFFFFF != chunk && track->start + chunk < size ? track->start + chunk : size;
+            track->end -= (track->end - track->start) % block_align;
+            return true;
+        }
+        pos += 8 + chunk + (chunk & 1);
+    }
+    return false;
+}
+
+/* Opens the track, from its first byte or from its audio data */
+static bool track_open(stream_t *s, track_t *track, size_t index, bool from_start)
+{
+    char path[PATH_MAX_LEN];
+    struct stat st;
+    if (!s->config.get_path(index, path, sizeof(path), s->config.ctx) || stat(path, &st)) {
+        ESP_LOGE(TAG, "No entry %u", (unsigned) index);
+        return false;
+    }
+
+    /* Probed on a plain file, the read-ahead ring is only filled from where playback starts */
+    memset(track, 0, sizeof(track_t));
+    track->index = index;
+    FILE *fp = fopen(path, "rb");
+    if (NULL == fp) {
+        ESP_LOGE(TAG, "Open '%s' failed", path);
+        return false;
+    }
+    if (!probe_wav(fp, st.st_size, track) && !probe_mp3(fp, st.st_size, track)) {
+        memset(&track->fmt, 0, sizeof(track->fmt));
+        track->start = 0;
+        track->end = st.st_size;
+    }
+    fclose(fp);
+    if (!from_start && CODEC_NONE == track->fmt.codec) {
+        ESP_LOGW(TAG, "'%s' is neither PCM WAV nor MP3", path);
+        return false;
+    }
+
+    track->fp = audio_readahead_open(path, s->config.readahead);
+    if (NULL == track->fp) {
+        ESP_LOGE(TAG, "Open '%s' failed", path);
+        return false;
+    }
+    track->pos = from_start ? 0 : track->start;
+    if (track->pos && fseek(track->fp, track->pos, SEEK_SET)) {
+        fclose(track->fp);
+        track->fp = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void *preparer_main(void *arg)
+{
+    stream_t *s = (stream_t *) arg;
+
+    pthread_mutex_lock(&s->lock);
+    while (!s->stop) {
+        if (NEXT_PREPARING != s->next_state || s->next.fp) {
+            pthread_cond_wait(&s->cond, &s->lock);
+            continue;
+        }
+        size_t index = s->next.index;
+        pthread_mutex_unlock(&s->lock);
+
+        track_t track;
+        bool ok = track_open(s, &track, index, false);
+
+        pthread_mutex_lock(&s->lock);
+        if (ok) {
+            s->next = track;
+        }
+        s->next_state = ok ? NEXT_READY : NEXT_FAILED;
+        pthread_cond_broadcast(&s->cond);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+/* Called with the lock held */
+static void request_next(stream_t *s)
+{
+    s->next.index = (s->cur.index + 1) % s->config.count;
+    s->next_state = NEXT_PREPARING;
+    pthread_cond_broadcast(&s->cond);
+}
+
+static bool same_format(const track_format_t *a, const track_format_t *b)
+{
+    return CODEC_NONE != a->codec && a->codec == b->codec && a->rate == b->rate
+           && a->channels == b->channels && a->bits == b->bits;
+}
+
+/* At the end of the current track, continue with the next one if it is ready and plays the same way */
+static bool switch_track(stream_t *s)
+{
+    pthread_mutex_lock(&s->lock);
+    while (NEXT_PREPARING == s->next_state) {
+        pthread_cond_wait(&s->cond, &s->lock);
+    }
+    if (NEXT_READY != s->next_state || !same_format(&s->cur.fmt, &s->next.fmt)) {
+        pthread_mutex_unlock(&s->lock);
+        return false;
+    }
+    FILE *done = s->cur.fp;
+    s->cur = s->next;
+    s->next.fp = NULL;
+    s->spliced = true;
+    request_next(s);
+    pthread_mutex_unlock(&s->lock);
+
+    fclose(done);
+    ESP_LOGI(TAG, "Continue with entry %u", (unsigned) s->cur.index);
+    if (s->config.on_track) {
+        s->config.on_track(s->cur.index, s->config.ctx);
+    }
+    return true;
+}
+
+static ssize_t stream_read(void *cookie, char *buf, size_t size)
+{
+    stream_t *s = (stream_t *) cookie;
+
+    while (true) {
+        if (s->cur.pos < s->cur.end) {
+            int64_t left = s->cur.end - s->cur.pos;
+            size_t want = left < (int64_t) size ? (size_t) left : size;
+            size_t got = fread(buf, 1, want, s->cur.fp);
+            if (got) {
+                s->cur.pos += got;
+                s->out_pos += got;
+                return got;
+            }
+            if (ferror(s->cur.fp)) {
+                errno = EIO;
+                return -1;
+            }
+            /* Shorter than when probed */
+            s->cur.end = s->cur.pos;
+        }
+        if (!switch_track(s)) {
+            return 0;
+        }
+    }
+}
+
+/* Only within the first track, for the format detection of the player */
+static int stream_seek(void *cookie, cookie_off_t *offset, int whence)
+{
+    stream_t *s = (stream_t *) cookie;
+
+    if (SEEK_CUR == whence && 0 == *offset) {
+        *offset = s->out_pos;
+        return 0;
+    }
+    if (s->spliced) {
+        errno = ESPIPE;
+        return -1;
+    }
+    int64_t target = *offset + (SEEK_CUR == whence ? s->out_pos : SEEK_END == whence ? s->cur.end : 0);
+    if (target < 0 || target > s->cur.end) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (fseek(s->cur.fp, target, SEEK_SET)) {
+        return -1;
+    }
+    s->cur.pos = s->out_pos = target;
+    *offset = target;
+    return 0;
+}
+
+static int stream_close(void *cookie)
+{
+    stream_t *s = (stream_t *) cookie;
+
+    pthread_mutex_lock(&s->lock);
+    s->stop = true;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->preparer, NULL);
+
+    fclose(s->cur.fp);
+    if (s->next.fp) {
+        fclose(s->next.fp);
+    }
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+    return 0;
+}
+
+FILE *playlist_open(const playlist_config_t *config, size_t index)
+{
+    if (NULL == config || NULL == config->get_path || index >= config->count) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    stream_t *s = calloc(1, sizeof(stream_t));
+    if (NULL == s) {
+        return NULL;
+    }
+    s->config = *config;
+    if (config->readahead) {
+        s->readahead = *config->readahead;
+        s->config.readahead = &s->readahead;
+    }
+    if (!track_open(s, &s->cur, index, true)) {
+        free(s);
+        return NULL;
+    }
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    if (pthread_create(&s->preparer, NULL, preparer_main, s)) {
+        ESP_LOGE(TAG, "Start preparer failed");
+        goto err;
+    }
+
+    cookie_io_functions_t io = {
+        .read = stream_read,
+        .seek = stream_seek,
+        .close = stream_close,
+    };
+    FILE *fp = fopencookie(s, "r", io);
+    if (NULL == fp) {
+        stream_close(s);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    request_next(s);
+    pthread_mutex_unlock(&s->lock);
+    return fp;
+
+err:
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->lock);
+    fclose(s->cur.fp);
+    free(s);
+    return NULL;
+}
@@ -12,6 +12,7 @@
 #include "bsp_board.h"
 #include "usb/uac_host.h"
 #include "mp3_demo.h"
+#include "playlist.h"
 
 static const char *TAG = "ui_audio";
 
@@ -61,6 +62,32 @@ static void ui_button_style_init(void)
     lv_style_set_shadow_width(&g_btn_styles.style_bg, 0);
 }
 
+static bool playlist_get_path(size_t index, char *path, size_t len, void *ctx)
+{
+    return file_iterator_get_full_path_from_index(file_iterator, index, path, len) != 0;
+}
+
+/* The player does not report a track joined without a stop, follow it here */
+static void playlist_on_track(size_t index, void *ctx)
+{
+    lv_obj_t *music_list = (lv_obj_t *) ctx;
+    lv_obj_t *label_title = (lv_obj_t *) music_list->user_data;
+
+    ESP_LOGI(TAG, "gapless switch to index %d", (int) index);
+    file_iterator_set_index(file_iterator, index);
+
+    bsp_display_lock(0);
+    lv_dropdown_set_selected(music_list, index);
+    lv_label_set_text_static(label_title,
+                             file_iterator_get_name_from_index(file_iterator, index));
+    bsp_display_unlock();
+}
+
+static playlist_config_t g_playlist = {
+    .get_path = playlist_get_path,
+    .on_track = playlist_on_track,
+};
+
 static void play_index(int index)
 {
     ESP_LOGI(TAG, "play_index(%d)", index);
@@ -72,7 +99,13 @@ static void play_index(int index)
         return;
     }
 
-    FILE *fp = fopen(filename, "rb");
+    /*
+     * Read ahead on another task, so that SPIFFS stalls do not reach the decoder, and continue with the
+     * next file in the stream when it has the same format. Otherwise the player goes idle at the end and
+     * audio_callback() starts the next file.
+     */
+    g_playlist.count = file_iterator_get_count(file_iterator);
+    FILE *fp = playlist_open(&g_playlist, index);
     if (fp) {
         ESP_LOGI(TAG, "Playing '%s'", filename);
         audio_player_play(fp);
@@ -471,6 +504,7 @@ void ui_audio_start(file_iterator_instance_t *i)
     lv_obj_add_event_cb(music_list, music_list_cb, LV_EVENT_VALUE_CHANGED, NULL);
 
     build_file_list(music_list);
+    g_playlist.ctx = music_list;
     audio_player_callback_register(audio_callback, (void *) music_list);
 
     // initiate playback
@@ -0,0 +1,160 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Cost of create + enable, fire and disable with 10 to 1000 day-of-week schedules over a week on the mock clock.
+ * The clock jumps from one fire time to the next and every fire must happen at its second, else the exit status is 1.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_schedule.h"
+#include "mock_clock.h"
+
+#define WEEK_SEC        (7 * 24 * 3600)
+/* Monday 2024-03-04 00:00:00 UTC */
+#define BENCH_START     1709510400
+#define IDLE_RUNS       200
+
+typedef struct {
+    time_t next;            /* From the timestamp callback */
+    time_t late;            /* Latest difference between a fire and its time */
+    uint32_t fires;
+} bench_sched_t;
+
+static bench_sched_t *s_sched;
+
+static uint32_t s_rng = 0x2545F491;
+
+static uint32_t rng_next(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void trigger_cb(esp_schedule_handle_t handle, void *priv_data)
+{
+    (void) handle;
+    bench_sched_t *sched = priv_data;
+    time_t late = time(NULL) - sched->next;
+    if (late > sched->late || late < 0) {
+        sched->late = late < 0 ? -late : late;
+    }
+    sched->fires++;
+}
+
+static void timestamp_cb(esp_schedule_handle_t handle, uint32_t next_timestamp, void *priv_data)
+{
+    (void) handle;
+    ((bench_sched_t *) priv_data)->next = next_timestamp;
+}
+
+static bool bench(int count)
+{
+    esp_schedule_handle_t *handles = calloc(count, sizeof(esp_schedule_handle_t));
+    s_sched = calloc(count, sizeof(bench_sched_t));
+    if (!handles || !s_sched) {
+        return false;
+    }
+
+    /* Every run starts on a Monday at midnight */
+    time_t start = (mock_clock_now_ms() / 1000 / WEEK_SEC + 1) * WEEK_SEC + (BENCH_START % WEEK_SEC);
+    mock_clock_advance_ms((start - mock_clock_now_ms() / 1000) * 1000);
+
+    double t0 = now_us();
+    for (int i = 0; i < count; i++) {
+        esp_schedule_config_t config = {
+            .trigger.type = ESP_SCHEDULE_TYPE_DAYS_OF_WEEK,
+            .trigger.hours = rng_next() % 24,
+            .trigger.minutes = rng_next() % 60,
+            .trigger.day.repeat_days = 1 + rng_next() % ESP_SCHEDULE_DAY_EVERYDAY,
+            .trigger_cb = trigger_cb,
+            .timestamp_cb = timestamp_cb,
+            .priv_data = &s_sched[i],
+        };
+        snprintf(config.name, sizeof(config.name), "s%d", i);
+        handles[i] = esp_schedule_create(&config);
+        esp_schedule_enable(handles[i]);
+    }
+    double insert_us = now_us() - t0;
+    mock_clock_settle();
+
+    /* What a clock step costs with nothing due, taken off the fire cost below */
+    t0 = now_us();
+    for (int i = 0; i < IDLE_RUNS; i++) {
+        mock_clock_settle();
+    }
+    double idle_us = (now_us() - t0) / IDLE_RUNS;
+
+    uint32_t steps = 0;
+    t0 = now_us();
+    while (1) {
+        time_t now = mock_clock_now_ms() / 1000;
+        time_t next = 0;
+        for (int i = 0; i < count; i++) {
+            if (s_sched[i].next > now && (next == 0 || s_sched[i].next < next)) {
+                next = s_sched[i].next;
+            }
+        }
+        if (next == 0 || next >= start + WEEK_SEC) {
+            break;
+        }
+        mock_clock_advance_ms((next - now) * 1000);
+        steps++;
+    }
+    double fire_us = now_us() - t0 - steps * idle_us;
+
+    uint32_t fires = 0;
+    time_t late = 0;
+    for (int i = 0; i < count; i++) {
+        fires += s_sched[i].fires;
+        late = s_sched[i].late > late ? s_sched[i].late : late;
+    }
+
+    t0 = now_us();
+    for (int i = 0; i < count; i++) {
+        esp_schedule_disable(handles[i]);
+    }
+    double cancel_us = now_us() - t0;
+    for (int i = 0; i < count; i++) {
+        esp_schedule_delete(handles[i]);
+    }
+
+    printf("%6d %10.2f %10.2f %8u %10.2f %6lld\n", count, insert_us / count, cancel_us / count, (unsigned) fires,
+           fires ? (fire_us > 0 ? fire_us : 0) / fires : 0, (long long) late);
+    free(handles);
+    free(s_sched);
+    return late == 0 && fires > 0;
+}
+
+int main(void)
+{
+    const int counts[] = { 10, 100, 1000 };
+    bool ok = true;
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    mock_clock_set(BENCH_START);
+
+    printf("%6s %10s %10s %8s %10s %6s\n", "count", "insert us", "cancel us", "fires", "fire us", "late s");
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        ok &= bench(counts[i]);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Next occurrence of day-of-week and date schedules in time zones with DST, across the transitions, for 29 February,
+ * months without the day, validity windows and date schedules without a year.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mock_clock.h"
+
+/* Included for the static next occurrence and expiry functions */
+#include "../src/esp_schedule.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define TZ_BERLIN       "CET-1CEST,M3.5.0,M10.5.0/3"
+#define TZ_NEW_YORK     "EST5EDT,M3.2.0,M11.1.0"
+#define TZ_SYDNEY       "AEST-10AEDT,M10.1.0,M4.1.0/3"
+
+static void set_tz(const char *tz)
+{
+    setenv("TZ", tz, 1);
+    tzset();
+}
+
+/* Local wall clock time to a timestamp, with the DST state of that date */
+static time_t local(int year, int month, int mday, int hour, int min)
+{
+    struct tm tm = {
+        .tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = mday, .tm_hour = hour, .tm_min = min, .tm_isdst = -1,
+    };
+    return mktime(&tm);
+}
+
+static time_t utc(int year, int month, int mday, int hour, int min)
+{
+    struct tm tm = {
+        .tm_year = year - 1900, .tm_mon = month - 1, .tm_mday = mday, .tm_hour = hour, .tm_min = min,
+    };
+    return timegm(&tm);
+}
+
+static esp_schedule_t weekly(uint8_t days, int hour, int min)
+{
+    return (esp_schedule_t) {
+        .trigger = {
+            .type = ESP_SCHEDULE_TYPE_DAYS_OF_WEEK, .hours = hour, .minutes = min, .day.repeat_days = days,
+        },
+    };
+}
+
+static esp_schedule_t dated(int day, uint16_t months, int year, bool every_year, int hour, int min)
+{
+    return (esp_schedule_t) {
+        .trigger = {
+            .type = ESP_SCHEDULE_TYPE_DATE, .hours = hour, .minutes = min,
+            .date = { .day = day, .repeat_months = months, .year = year, .repeat_every_year = every_year },
+        },
+    };
+}
+
+static char *fmt(time_t t)
+{
+    static char buf[4][40];
+    static int next;
+    char *out = buf[next++ % 4];
+    struct tm tm;
+    if (t == 0) {
+        snprintf(out, 40, "none");
+    } else {
+        gmtime_r(&t, &tm);
+        strftime(out, 40, "%Y-%m-%d %H:%M UTC", &tm);
+    }
+    return out;
+}
+
+#define CHECK_NEXT(schedule, from, expected) do {                                              \
+        time_t next_ = esp_schedule_get_next_occurrence(&(schedule), (from));                  \
+        CHECK(next_ == (expected), "from %s: next %s, expected %s", fmt(from), fmt(next_), fmt(expected)); \
+    } while (0)
+
+static bool test_weekdays(void)
+{
+    set_tz("UTC0");
+    /* Monday 2024-03-04 */
+    esp_schedule_t s = weekly(ESP_SCHEDULE_DAY_MONDAY | ESP_SCHEDULE_DAY_THURSDAY, 13, 30);
+    CHECK_NEXT(s, utc(2024, 3, 4, 13, 0), utc(2024, 3, 4, 13, 30));
+    CHECK_NEXT(s, utc(2024, 3, 4, 13, 30), utc(2024, 3, 7, 13, 30));
+    CHECK_NEXT(s, utc(2024, 3, 7, 14, 0), utc(2024, 3, 11, 13, 30));
+
+    /* Same weekday next week, and once: the next time the hour comes */
+    s = weekly(ESP_SCHEDULE_DAY_SUNDAY, 0, 0);
+    CHECK_NEXT(s, utc(2024, 3, 10, 0, 0), utc(2024, 3, 17, 0, 0));
+    s = weekly(ESP_SCHEDULE_DAY_ONCE, 6, 0);
+    CHECK_NEXT(s, utc(2024, 3, 4, 5, 59), utc(2024, 3, 4, 6, 0));
+    CHECK_NEXT(s, utc(2024, 3, 4, 6, 0), utc(2024, 3, 5, 6, 0));
+
+    /* Across the end of a year */
+    s = weekly(ESP_SCHEDULE_DAY_WEDNESDAY, 9, 0);
+    CHECK_NEXT(s, utc(2024, 12, 31, 12, 0), utc(2025, 1, 1, 9, 0));
+    return true;
+}
+
+/* A daily local hour stays on that hour when the UTC offset changes */
+static bool test_dst_daily(void)
+{
+    esp_schedule_t s = weekly(ESP_SCHEDULE_DAY_EVERYDAY, 8, 0);
+
+    set_tz(TZ_BERLIN);
+    /* DST starts on 2024-03-31 at 02:00 and ends on 2024-10-27 at 03:00 */
+    CHECK_NEXT(s, utc(2024, 3, 30, 8, 0), utc(2024, 3, 31, 6, 0));
+    CHECK_NEXT(s, utc(2024, 3, 29, 12, 0), utc(2024, 3, 30, 7, 0));
+    CHECK_NEXT(s, utc(2024, 10, 26, 12, 0), utc(2024, 10, 27, 7, 0));
+
+    set_tz(TZ_NEW_YORK);
+    /* DST starts on 2024-03-10 and ends on 2024-11-03 */
+    CHECK_NEXT(s, utc(2024, 3, 9, 14, 0), utc(2024, 3, 10, 12, 0));
+    CHECK_NEXT(s, utc(2024, 11, 2, 13, 0), utc(2024, 11, 3, 13, 0));
+
+    /* Southern hemisphere, DST ends on 2024-04-07 and starts on 2024-10-06 */
+    set_tz(TZ_SYDNEY);
+    CHECK_NEXT(s, utc(2024, 4, 6, 0, 0), utc(2024, 4, 6, 22, 0));
+    CHECK_NEXT(s, utc(2024, 10, 5, 0, 0), utc(2024, 10, 5, 21, 0));
+    return true;
+}
+
+/* An hour inside the transition still fires exactly once on that day */
+static bool test_dst_gap_and_overlap(void)
+{
+    set_tz(TZ_BERLIN);
+
+    /* 02:30 does not exist on 2024-03-31, mktime() moves it into summer time */
+    esp_schedule_t s = weekly(ESP_SCHEDULE_DAY_EVERYDAY, 2, 30);
+    time_t gap = esp_schedule_get_next_occurrence(&s, utc(2024, 3, 30, 12, 0));
+    CHECK(gap > utc(2024, 3, 30, 12, 0) && gap < utc(2024, 3, 31, 12, 0), "gap day skipped: %s", fmt(gap));
+    CHECK_NEXT(s, gap, local(2024, 4, 1, 2, 30));
+
+    /* 02:30 comes twice on 2024-10-27 */
+    time_t overlap = esp_schedule_get_next_occurrence(&s, utc(2024, 10, 26, 12, 0));
+    CHECK(overlap == utc(2024, 10, 27, 0, 30) || overlap == utc(2024, 10, 27, 1, 30), "overlap at %s", fmt(overlap));
+    time_t after = esp_schedule_get_next_occurrence(&s, overlap);
+    CHECK(after == utc(2024, 10, 28, 1, 30), "fired twice on the overlap day, next %s", fmt(after));
+    return true;
+}
+
+static bool test_dates(void)
+{
+    set_tz(TZ_BERLIN);
+
+    /* 29 February every year */
+    esp_schedule_t s = dated(29, ESP_SCHEDULE_MONTH_FEBRUARY, 2024, true, 10, 0);
+    CHECK_NEXT(s, local(2024, 3, 1, 0, 0), local(2028, 2, 29, 10, 0));
+
+    /* The 31st, in the months that have one */
+    s = dated(31, ESP_SCHEDULE_MONTH_APRIL | ESP_SCHEDULE_MONTH_MAY | ESP_SCHEDULE_MONTH_JUNE, 2024, true, 7, 0);
+    CHECK_NEXT(s, local(2024, 4, 1, 0, 0), local(2024, 5, 31, 7, 0));
+    CHECK_NEXT(s, local(2024, 5, 31, 7, 0), local(2025, 5, 31, 7, 0));
+
+    /* A year in the future, and a non-repeating year that has passed */
+    s = dated(15, ESP_SCHEDULE_MONTH_MARCH, 2026, false, 12, 0);
+    CHECK_NEXT(s, local(2024, 6, 1, 0, 0), local(2026, 3, 15, 12, 0));
+    CHECK_NEXT(s, local(2026, 3, 15, 12, 0), 0);
+
+    /* Any month once */
+    s = dated(10, ESP_SCHEDULE_MONTH_ONCE, 0, false, 9, 0);
+    CHECK_NEXT(s, local(2024, 12, 20, 0, 0), local(2025, 1, 10, 9, 0));
+
+    /* Summer and winter time on the same schedule */
+    s = dated(1, ESP_SCHEDULE_MONTH_JANUARY | ESP_SCHEDULE_MONTH_JULY, 2024, true, 12, 0);
+    CHECK_NEXT(s, utc(2024, 2, 1, 0, 0), utc(2024, 7, 1, 10, 0));
+    CHECK_NEXT(s, utc(2024, 7, 1, 10, 0), utc(2025, 1, 1, 11, 0));
+    return true;
+}
+
+/* No year and no yearly repeat: this year, or next year if the dates have passed, and then no more */
+static bool test_date_year_zero(void)
+{
+    set_tz(TZ_BERLIN);
+
+    esp_schedule_t s = dated(1, ESP_SCHEDULE_MONTH_JANUARY | ESP_SCHEDULE_MONTH_JUNE, 0, false, 8, 0);
+    CHECK_NEXT(s, local(2024, 5, 10, 0, 0), local(2024, 6, 1, 8, 0));
+    CHECK_NEXT(s, local(2024, 7, 1, 0, 0), local(2025, 1, 1, 8, 0));
+    CHECK(!esp_schedule_is_expired(&s.trigger), "schedule without a year expired before it was armed");
+
+    /* Through arming, which pins the year of the first occurrence */
+    mock_clock_set(local(2024, 7, 1, 0, 0));
+    snprintf(s.name, sizeof(s.name), "year0");
+    esp_schedule_get_next_schedule_time_diff(&s);
+    CHECK(s.trigger.next_scheduled_time_utc == local(2025, 1, 1, 8, 0), "armed for %s",
+          fmt(s.trigger.next_scheduled_time_utc));
+    CHECK(2025 == s.trigger.date.year, "year pinned to %d", s.trigger.date.year);
+    CHECK_NEXT(s, local(2025, 1, 1, 8, 0), local(2025, 6, 1, 8, 0));
+    CHECK_NEXT(s, local(2025, 6, 1, 8, 0), 0);
+
+    mock_clock_set(local(2025, 6, 1, 8, 1));
+    CHECK(esp_schedule_is_expired(&s.trigger), "not expired after its last date");
+    return true;
+}
+
+static bool test_validity(void)
+{
+    set_tz(TZ_NEW_YORK);
+
+    esp_schedule_t s = weekly(ESP_SCHEDULE_DAY_EVERYDAY, 20, 0);
+    s.validity.start_time = local(2024, 3, 12, 0, 0);
+    s.validity.end_time = local(2024, 3, 14, 0, 0);
+    CHECK_NEXT(s, local(2024, 3, 1, 0, 0), local(2024, 3, 12, 20, 0));
+    CHECK_NEXT(s, local(2024, 3, 12, 20, 0), local(2024, 3, 13, 20, 0));
+    CHECK_NEXT(s, local(2024, 3, 13, 20, 0), 0);
+
+    /* Starting right at an occurrence includes it */
+    s.validity.start_time = local(2024, 3, 12, 20, 0);
+    CHECK_NEXT(s, local(2024, 3, 1, 0, 0), local(2024, 3, 12, 20, 0));
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_weekdays, test_dst_daily, test_dst_gap_and_overlap, test_dates, test_date_year_zero, test_validity,
+    };
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,310 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Fires schedules on the mock clock and checks the order and the times, then races disable, enable and delete
+ * against a fire held in its callback. Build with the sanitizers to catch a use after free, see README.md.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_err.h"
+#include "esp_schedule.h"
+#include "mock_clock.h"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+#define DAY_SEC         (24 * 3600)
+#define FIRES_MAX       64
+/* Monday 2024-03-04 00:00:00 UTC */
+#define TEST_START      1709510400
+
+typedef struct {
+    int id;
+    time_t at;
+} fire_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static fire_t s_fires[FIRES_MAX];
+static int s_fire_count;
+/* A fire of a schedule with `hold` set waits in its callback until the gate opens */
+static bool s_entered;
+static bool s_open;
+static bool s_delete_self;
+
+/* Static in the tests, a schedule left armed by a failed check must not point into a dead frame */
+typedef struct {
+    int id;
+    bool hold;
+} sched_arg_t;
+
+static void trigger_cb(esp_schedule_handle_t handle, void *priv_data)
+{
+    sched_arg_t *arg = priv_data;
+
+    pthread_mutex_lock(&s_lock);
+    if (s_fire_count < FIRES_MAX) {
+        s_fires[s_fire_count++] = (fire_t) {
+            .id = arg->id, .at = time(NULL)
+        };
+    }
+    if (arg->hold) {
+        s_entered = true;
+        pthread_cond_broadcast(&s_cond);
+        while (!s_open) {
+            pthread_cond_wait(&s_cond, &s_lock);
+        }
+    }
+    bool delete_self = s_delete_self;
+    pthread_mutex_unlock(&s_lock);
+
+    if (delete_self) {
+        esp_schedule_delete(handle);
+    }
+}
+
+static void reset_fires(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_fire_count = 0;
+    s_entered = false;
+    s_open = false;
+    s_delete_self = false;
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void wait_entered(void)
+{
+    pthread_mutex_lock(&s_lock);
+    while (!s_entered) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void open_gate(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_open = true;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+static esp_schedule_handle_t create_daily(const char *name, int hours, int minutes, sched_arg_t *arg)
+{
+    esp_schedule_config_t config = {
+        .trigger.type = ESP_SCHEDULE_TYPE_DAYS_OF_WEEK,
+        .trigger.hours = hours,
+        .trigger.minutes = minutes,
+        .trigger.day.repeat_days = ESP_SCHEDULE_DAY_EVERYDAY,
+        .trigger_cb = trigger_cb,
+        .priv_data = arg,
+    };
+    snprintf(config.name, sizeof(config.name), "%s", name);
+    esp_schedule_handle_t handle = esp_schedule_create(&config);
+    if (handle) {
+        esp_schedule_enable(handle);
+    }
+    return handle;
+}
+
+/* Start of the next day, each test begins there */
+static time_t next_day(void)
+{
+    time_t now = mock_clock_now_ms() / 1000;
+    time_t day = (now / DAY_SEC + 1) * DAY_SEC;
+    mock_clock_advance_ms((day - now) * 1000);
+    reset_fires();
+    return day;
+}
+
+/* Steps the clock to `until` a minute at a time, so a fire at the wrong minute shows */
+static void run_until(time_t until)
+{
+    while (mock_clock_now_ms() / 1000 < until) {
+        mock_clock_advance_ms(60 * 1000);
+    }
+}
+
+static bool test_order(void)
+{
+    static sched_arg_t args[3] = { { .id = 0 }, { .id = 1 }, { .id = 2 } };
+    const int at[3][2] = { { 18, 15 }, { 6, 30 }, { 7, 0 } };
+    const int order[3] = { 1, 2, 0 };
+    esp_schedule_handle_t handles[3];
+
+    time_t day = next_day();
+    for (int i = 0; i < 3; i++) {
+        handles[i] = create_daily((char[]) { 'a' + i, 0 }, at[i][0], at[i][1], &args[i]);
+        CHECK(handles[i], "create failed");
+    }
+    run_until(day + 3 * DAY_SEC);
+
+    CHECK(9 == s_fire_count, "%d fires in 3 days", s_fire_count);
+    for (int i = 0; i < 9; i++) {
+        int id = order[i % 3];
+        time_t expected = day + (i / 3) * DAY_SEC + at[id][0] * 3600 + at[id][1] * 60;
+        CHECK(s_fires[i].id == id && s_fires[i].at == expected, "fire %d: schedule %d at %lld, expected %d at %lld", i,
+              s_fires[i].id, (long long) s_fires[i].at, id, (long long) expected);
+    }
+    for (int i = 0; i < 3; i++) {
+        esp_schedule_delete(handles[i]);
+    }
+    return true;
+}
+
+/* A disable while the schedule fires must not be undone by the re-arm at the end of the fire */
+static bool test_disable_in_fire(void)
+{
+    static sched_arg_t arg = { .id = 0, .hold = true };
+
+    time_t day = next_day();
+    esp_schedule_handle_t handle = create_daily("held", 8, 0, &arg);
+    mock_clock_advance_async_ms(8 * 3600 * 1000LL);
+    wait_entered();
+    esp_schedule_disable(handle);
+    open_gate();
+    mock_clock_settle();
+    run_until(day + 3 * DAY_SEC);
+
+    CHECK(1 == s_fire_count, "disabled schedule fired %d times", s_fire_count);
+    esp_schedule_delete(handle);
+    return true;
+}
+
+/* Disabled and enabled again while it fires, it keeps firing */
+static bool test_enable_in_fire(void)
+{
+    static sched_arg_t arg = { .id = 0, .hold = true };
+
+    time_t day = next_day();
+    esp_schedule_handle_t handle = create_daily("held", 8, 0, &arg);
+    mock_clock_advance_async_ms(8 * 3600 * 1000LL);
+    wait_entered();
+    esp_schedule_disable(handle);
+    esp_schedule_enable(handle);
+    open_gate();
+    mock_clock_settle();
+    arg.hold = false;
+    run_until(day + 3 * DAY_SEC);
+
+    CHECK(3 == s_fire_count, "re-enabled schedule fired %d times in 3 days", s_fire_count);
+    CHECK(day + 2 * DAY_SEC + 8 * 3600 == s_fires[2].at, "last fire at %lld", (long long) s_fires[2].at);
+    esp_schedule_delete(handle);
+    return true;
+}
+
+static bool s_deleted;
+
+static void *delete_thread(void *handle)
+{
+    esp_schedule_delete(handle);
+    pthread_mutex_lock(&s_lock);
+    s_deleted = true;
+    pthread_mutex_unlock(&s_lock);
+    return NULL;
+}
+
+/* A delete while the schedule fires waits for the fire, which must not touch the freed schedule */
+static bool test_delete_in_fire(void)
+{
+    static sched_arg_t arg = { .id = 0, .hold = true };
+    pthread_t thread;
+
+    time_t day = next_day();
+    esp_schedule_handle_t handle = create_daily("held", 8, 0, &arg);
+    mock_clock_advance_async_ms(8 * 3600 * 1000LL);
+    wait_entered();
+    s_deleted = false;
+    pthread_create(&thread, NULL, delete_thread, handle);
+    usleep(50 * 1000);
+    pthread_mutex_lock(&s_lock);
+    bool deleted_early = s_deleted;
+    pthread_mutex_unlock(&s_lock);
+    open_gate();
+    pthread_join(thread, NULL);
+    mock_clock_settle();
+    run_until(day + 3 * DAY_SEC);
+
+    CHECK(!deleted_early, "delete returned while the schedule fired");
+    CHECK(1 == s_fire_count, "deleted schedule fired %d times", s_fire_count);
+    return true;
+}
+
+static bool test_delete_self(void)
+{
+    static sched_arg_t arg = { .id = 0 };
+
+    time_t day = next_day();
+    s_delete_self = true;
+    create_daily("self", 8, 0, &arg);
+    run_until(day + 3 * DAY_SEC);
+
+    CHECK(1 == s_fire_count, "self-deleted schedule fired %d times", s_fire_count);
+    return true;
+}
+
+/* Deleting idle schedules leaves the others on time */
+static bool test_delete_idle(void)
+{
+    static sched_arg_t args[6];
+    esp_schedule_handle_t handles[6];
+
+    time_t day = next_day();
+    for (int i = 0; i < 6; i++) {
+        args[i] = (sched_arg_t) {
+            .id = i
+        };
+        handles[i] = create_daily((char[]) { 'a' + i, 0 }, 5 + (i * 7) % 6, 10 * i, &args[i]);
+    }
+    esp_schedule_delete(handles[0]);
+    esp_schedule_delete(handles[3]);
+    esp_schedule_delete(handles[4]);
+    run_until(day + DAY_SEC);
+
+    CHECK(3 == s_fire_count, "%d fires", s_fire_count);
+    for (int i = 0; i < 3; i++) {
+        int id = s_fires[i].id;
+        CHECK(id == 1 || id == 2 || id == 5, "deleted schedule %d fired", id);
+        CHECK(s_fires[i].at == day + (5 + (id * 7) % 6) * 3600 + 10 * id * 60, "schedule %d late", id);
+        CHECK(i == 0 || s_fires[i].at >= s_fires[i - 1].at, "out of order");
+    }
+    esp_schedule_delete(handles[1]);
+    esp_schedule_delete(handles[2]);
+    esp_schedule_delete(handles[5]);
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_order, test_disable_in_fire, test_enable_in_fire, test_delete_in_fire, test_delete_self,
+        test_delete_idle,
+    };
+    int failed = 0;
+
+    setenv("TZ", "UTC0", 1);
+    tzset();
+    mock_clock_set(TEST_START);
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
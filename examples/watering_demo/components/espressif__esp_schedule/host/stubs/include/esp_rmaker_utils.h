@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MEM_CALLOC_EXTRAM(num, size) calloc(num, size)
+
+/* newlib provides fls(), glibc does not */
+static inline int fls(int mask)
+{
+    return mask ? 32 - __builtin_clz((unsigned int) mask) : 0;
+}
+
+/* Nor strlcpy() before 2.38 */
+static inline size_t host_strlcpy(char *dst, const char *src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#define strlcpy host_strlcpy
@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host stand-in, the mock clock is always set */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_idf_version.h"
+
+#define SNTP_OPMODE_POLL 0
+
+static inline bool esp_sntp_enabled(void)
+{
+    return true;
+}
+
+static inline void esp_sntp_setoperatingmode(int mode)
+{
+    (void) mode;
+}
+
+static inline void esp_sntp_setservername(int index, const char *server)
+{
+    (void) index;
+    (void) server;
+}
+
+static inline void esp_sntp_init(void)
+{
+}
@@ -0,0 +1,24 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* The clock time() returns on the host, and the sleeps of the mock FreeRTOS tasks on it */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+void mock_clock_set(time_t now);
+int64_t mock_clock_now_ms(void);
+
+/* Moves the clock on and returns once every task sleeping on it is asleep again with nothing due */
+void mock_clock_advance_ms(int64_t ms);
+
+/* Moves the clock on without waiting, for a test that blocks a task meanwhile */
+void mock_clock_advance_async_ms(int64_t ms);
+
+/* Returns once every task sleeping on the clock is asleep again with nothing due */
+void mock_clock_settle(void);
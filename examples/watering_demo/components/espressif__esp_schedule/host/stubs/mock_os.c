@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* FreeRTOS tasks, notifications and mutexes on pthreads, with time() and the task sleeps on a mock clock */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "mock_clock.h"
+
+#define MOCK_TASK_MAX   4
+
+struct mock_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t notified;
+    bool waiting;               /* In ulTaskNotifyTake() with nothing to return yet */
+    int64_t deadline_ms;
+    uint64_t wait_epoch;        /* Epoch at which it went back to waiting */
+};
+
+struct mock_mutex {
+    pthread_mutex_t mutex;
+};
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_cond = PTHREAD_COND_INITIALIZER;
+static struct mock_task s_tasks[MOCK_TASK_MAX];
+static int s_task_count;
+static int64_t s_now_ms;
+static uint64_t s_epoch;
+static __thread struct mock_task *s_current;
+
+time_t time(time_t *out)
+{
+    pthread_mutex_lock(&s_lock);
+    time_t now = s_now_ms / 1000;
+    pthread_mutex_unlock(&s_lock);
+    if (out) {
+        *out = now;
+    }
+    return now;
+}
+
+void mock_clock_set(time_t now)
+{
+    pthread_mutex_lock(&s_lock);
+    s_now_ms = (int64_t) now * 1000;
+    s_epoch++;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+int64_t mock_clock_now_ms(void)
+{
+    pthread_mutex_lock(&s_lock);
+    int64_t now = s_now_ms;
+    pthread_mutex_unlock(&s_lock);
+    return now;
+}
+
+static bool settled(void)
+{
+    for (int i = 0; i < s_task_count; i++) {
+        struct mock_task *task = &s_tasks[i];
+        if (!task->waiting || task->wait_epoch != s_epoch || task->notified || task->deadline_ms <= s_now_ms) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void mock_clock_settle(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_epoch++;
+    pthread_cond_broadcast(&s_cond);
+    while (!settled()) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void mock_clock_advance_async_ms(int64_t ms)
+{
+    pthread_mutex_lock(&s_lock);
+    s_now_ms += ms;
+    s_epoch++;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+}
+
+void mock_clock_advance_ms(int64_t ms)
+{
+    mock_clock_advance_async_ms(ms);
+    mock_clock_settle();
+}
+
+static void *task_main(void *arg)
+{
+    s_current = (struct mock_task *) arg;
+    s_current->fn(s_current->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg, UBaseType_t priority,
+                       TaskHandle_t *created_task)
+{
+    (void) name;
+    (void) stack_depth;
+    (void) priority;
+
+    pthread_mutex_lock(&s_lock);
+    if (s_task_count == MOCK_TASK_MAX) {
+        pthread_mutex_unlock(&s_lock);
+        return pdFAIL;
+    }
+    struct mock_task *task = &s_tasks[s_task_count++];
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_unlock(&s_lock);
+
+    if (pthread_create(&task->thread, NULL, task_main, task)) {
+        abort();
+    }
+    pthread_detach(task->thread);
+    if (created_task) {
+        *created_task = task;
+    }
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&s_lock);
+    task->notified++;
+    pthread_cond_broadcast(&s_cond);
+    pthread_mutex_unlock(&s_lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait)
+{
+    struct mock_task *task = s_current;
+
+    pthread_mutex_lock(&s_lock);
+    task->deadline_ms = ticks_to_wait == portMAX_DELAY ? INT64_MAX : s_now_ms + ticks_to_wait;
+    while (!task->notified && s_now_ms < task->deadline_ms) {
+        /* Tell mock_clock_settle() that this task is idle as of the current epoch */
+        task->waiting = true;
+        task->wait_epoch = s_epoch;
+        pthread_cond_broadcast(&s_cond);
+        pthread_cond_wait(&s_cond, &s_lock);
+    }
+    task->waiting = false;
+    uint32_t value = task->notified;
+    task->notified = clear_on_exit ? 0 : (value ? value - 1 : 0);
+    pthread_mutex_unlock(&s_lock);
+    return value;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep(ticks * 1000);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct mock_mutex *mutex = calloc(1, sizeof(struct mock_mutex));
+    if (mutex) {
+        pthread_mutex_init(&mutex->mutex, NULL);
+    }
+    return mutex;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_destroy(&mutex->mutex);
+    free(mutex);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks_to_wait)
+{
+    (void) ticks_to_wait;
+    pthread_mutex_lock(&mutex->mutex);
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_unlock(&mutex->mutex);
+    return pdPASS;
+}
@@ -0,0 +1,39 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* Host stand-in for esp_schedule_nvs.c, schedules are not persisted */
+
+#include <stddef.h>
+#include "esp_schedule_internal.h"
+
+esp_err_t esp_schedule_nvs_add(esp_schedule_t *schedule)
+{
+    (void) schedule;
+    return ESP_OK;
+}
+
+esp_err_t esp_schedule_nvs_remove(esp_schedule_t *schedule)
+{
+    (void) schedule;
+    return ESP_OK;
+}
+
+esp_schedule_handle_t *esp_schedule_nvs_get_all(uint8_t *schedule_count)
+{
+    *schedule_count = 0;
+    return NULL;
+}
+
+bool esp_schedule_nvs_is_enabled(void)
+{
+    return false;
+}
+
+esp_err_t esp_schedule_nvs_init(char *nvs_partition)
+{
+    (void) nvs_partition;
+    return ESP_OK;
+}
@@ -97,7 +97,8 @@ typedef struct esp_schedule_trigger {
         uint8_t day;
         /* 'OR' list of esp_schedule_months_t */
         uint16_t repeat_months;
-        /** Year */
+        /** Year. 0 for this year, or the next one if the date has passed this year. Set to that year once the
+         * schedule is armed, unless it repeats every year. */
         uint16_t year;
         /** If the schedule is to be repeated every year. */
         bool repeat_every_year;
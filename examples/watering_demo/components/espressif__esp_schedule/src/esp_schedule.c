@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <string.h>
+#include <sys/param.h>
 #include <inttypes.h>
 #include <esp_log.h>
 #include <esp_sntp.h>
@@ -17,147 +18,124 @@ static const char *TAG = "esp_schedule";
 
 static bool init_done = false;
 
-static int esp_schedule_get_no_of_days(esp_schedule_trigger_t *trigger, struct tm *current_time, struct tm *schedule_time)
+static bool esp_schedule_is_leap_year(int year)
 {
-    /* for day, monday = 0, sunday = 6. */
-    int next_day = 0;
-    /* struct tm has tm_wday with sunday as 0. Whereas we have monday as 0. Converting struct tm to our format */
-    int today = ((current_time->tm_wday + 7 - 1) % 7);
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int esp_schedule_days_in_month(int year, int month)
+{
+    static const uint8_t days[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return (month == 1 && esp_schedule_is_leap_year(year)) ? 29 : days[month];
+}
+
+/* Converts a local wall clock time to a timestamp. tm_isdst = -1 lets mktime() pick the DST state
+ * valid on that date, so the schedule keeps its local hour across DST transitions.
+ */
+static time_t esp_schedule_local_to_time(int year, int month, int mday, esp_schedule_trigger_t *trigger)
+{
+    struct tm local_time = {
+        .tm_year = year - 1900,
+        .tm_mon = month,
+        .tm_mday = mday,
+        .tm_hour = trigger->hours,
+        .tm_min = trigger->minutes,
+        .tm_sec = 0,
+        .tm_isdst = -1,
+    };
+    return mktime(&local_time);
+}
 
-    esp_schedule_days_t today_bit = 1 << today;
+static time_t esp_schedule_next_day_of_week(esp_schedule_trigger_t *trigger, time_t from)
+{
+    struct tm from_time;
+    localtime_r(&from, &from_time);
     uint8_t repeat_days = trigger->day.repeat_days;
-    int current_seconds = (current_time->tm_hour * 60 + current_time->tm_min) * 60 + current_time->tm_sec;
-    int schedule_seconds = (schedule_time->tm_hour * 60 + schedule_time->tm_min) * 60;
-
-    /* Handling for one time schedule */
-    if (repeat_days == ESP_SCHEDULE_DAY_ONCE) {
-        if (schedule_seconds > current_seconds) {
-            /* The schedule is today and is yet to go off */
-            return 0;
-        } else {
-            /* The schedule is tomorrow */
-            return 1;
-        }
-    }
 
-    /* Handling for repeating schedules */
-    /* Check if it is today */
-    if ((repeat_days & today_bit)) {
-        if (schedule_seconds > current_seconds) {
-            /* The schedule is today and is yet to go off. */
-            return 0;
+    /* Offset 7 covers "same weekday next week" when today's time has already passed */
+    for (int offset = 0; offset <= 7; offset++) {
+        /* struct tm has tm_wday with sunday as 0. Whereas we have monday as 0. */
+        int day = (from_time.tm_wday + 6 + offset) % 7;
+        if (repeat_days != ESP_SCHEDULE_DAY_ONCE && !(repeat_days & (1 << day))) {
+            continue;
         }
-    }
-    /* Check if it is this week or next week */
-    if ((repeat_days & (today_bit ^ 0xFF)) > today_bit) {
-        /* Next schedule is yet to come in this week */
-        next_day = ffs(repeat_days & (0xFF << (today + 1))) - 1;
-        return (next_day - today);
-    } else {
-        /* First scheduled day of the next week */
-        next_day = ffs(repeat_days) - 1;
-        if (next_day == today) {
-            /* Same day, next week */
-            return 7;
+        time_t next = esp_schedule_local_to_time(from_time.tm_year + 1900, from_time.tm_mon, from_time.tm_mday + offset, trigger);
+        if (next > from) {
+            return next;
         }
-        return (7 - today + next_day);
     }
-
-    ESP_LOGE(TAG, "No of days could not be found. This should not happen.");
     return 0;
 }
 
-static uint8_t esp_schedule_get_next_month(esp_schedule_trigger_t *trigger, struct tm *current_time, struct tm *schedule_time)
+static time_t esp_schedule_next_date(esp_schedule_trigger_t *trigger, time_t from)
 {
-    int current_seconds = (current_time->tm_hour * 60 + current_time->tm_min) * 60 + current_time->tm_sec;
-    int schedule_seconds = (schedule_time->tm_hour * 60 + schedule_time->tm_min) * 60;
-    /* +1 is because struct tm has months starting from 0, whereas we have them starting from 1 */
-    uint8_t current_month = current_time->tm_mon + 1;
-    /* -1 because month_bit starts from 0b1. So for January, it should be 1 << 0. And current_month starts from 1. */
-    uint16_t current_month_bit = 1 << (current_month - 1);
-    uint8_t next_schedule_month = 0;
+    struct tm from_time;
+    localtime_r(&from, &from_time);
+    int year = from_time.tm_year + 1900;
+    int month = from_time.tm_mon;
+    int last_year = year;
     uint16_t repeat_months = trigger->date.repeat_months;
 
-    /* Check if month is not specified */
     if (repeat_months == ESP_SCHEDULE_MONTH_ONCE) {
-        if (trigger->date.day == current_time->tm_mday) {
-            /* The schedule day is same. Check if time has already passed */
-            if (schedule_seconds > current_seconds) {
-                /* The schedule is today and is yet to go off */
-                return current_month;
-            } else {
-                /* Today's time has passed */
-                return (current_month + 1);
-            }
-        } else if (trigger->date.day > current_time->tm_mday) {
-            /* The day is yet to come in this month */
-            return current_month;
-        } else {
-            /* The day has passed in the current month */
-            return (current_month + 1);
-        }
+        /* Any month will do, the first one where the day exists and has not passed */
+        repeat_months = 0xFFF;
+        last_year = year + 1;
+    } else if (trigger->date.repeat_every_year) {
+        /* Day 29 of February may need up to 8 years */
+        last_year = MAX(year, trigger->date.year) + 8;
+    } else if (trigger->date.year == 0) {
+        /* No year given: this year, or the next one once this year's dates have passed */
+        last_year = year + 1;
+    } else {
+        last_year = trigger->date.year;
     }
 
-    /* Check if schedule is not this year itself, it is in future. */
-    if (trigger->date.year > (current_time->tm_year + 1900)) {
-        /* Find first schedule month of next year */
-        next_schedule_month = ffs(repeat_months);
-        /* Year will be handled by the caller. So no need to add any additional months */
-        return next_schedule_month;
+    if (trigger->date.year > year && trigger->date.repeat_months != ESP_SCHEDULE_MONTH_ONCE) {
+        year = trigger->date.year;
+        month = 0;
     }
 
-    /* Check if schedule is this month and is yet to come */
-    if (current_month_bit & repeat_months) {
-        if (trigger->date.day == current_time->tm_mday) {
-            /* The schedule day is same. Check if time has already passed */
-            if (schedule_seconds > current_seconds) {
-                /* The schedule is today and is yet to go off */
-                return current_month;
+    for (; year <= last_year; year++, month = 0) {
+        for (; month < 12; month++) {
+            if (!(repeat_months & (1 << month)) || trigger->date.day > esp_schedule_days_in_month(year, month)) {
+                continue;
+            }
+            time_t next = esp_schedule_local_to_time(year, month, trigger->date.day, trigger);
+            if (next > from) {
+                return next;
             }
-        }
-        if (trigger->date.day > current_time->tm_mday) {
-            /* The day is yet to come in this month */
-            return current_month;
         }
     }
+    return 0;
+}
 
-    /* Check if schedule is this year */
-    if ((repeat_months & (current_month_bit ^ 0xFFFF)) > current_month_bit) {
-        /* Next schedule month is yet to come in this year */
-        next_schedule_month = ffs(repeat_months & (0xFFFF << (current_month)));
-        return next_schedule_month;
-    }
+/* Returns the first occurrence strictly after `from` and within the validity window, or 0 if there is none */
+static time_t esp_schedule_get_next_occurrence(esp_schedule_t *schedule, time_t from)
+{
+    esp_schedule_trigger_t *trigger = &schedule->trigger;
+    time_t next = 0;
 
-    /* Check if schedule is for this year and does not repeat */
-    if (!trigger->date.repeat_every_year) {
-        if (trigger->date.year <= (current_time->tm_year + 1900)) {
-            ESP_LOGE(TAG, "Schedule does not repeat next year, but get_next_month has been called.");
-            return 0;
-        }
+    if (schedule->validity.start_time != 0 && from < schedule->validity.start_time - 1) {
+        from = schedule->validity.start_time - 1;
     }
 
-    /* Schedule is not this year */
-    /* Find first schedule month of next year */
-    next_schedule_month = ffs(repeat_months);
-    /* +12 because the schedule is next year */
-    return (next_schedule_month + 12);
-}
+    if (trigger->type == ESP_SCHEDULE_TYPE_DAYS_OF_WEEK) {
+        next = esp_schedule_next_day_of_week(trigger, from);
+    } else if (trigger->type == ESP_SCHEDULE_TYPE_DATE) {
+        next = esp_schedule_next_date(trigger, from);
+    }
 
-static uint16_t esp_schedule_get_next_year(esp_schedule_trigger_t *trigger, struct tm *current_time, struct tm *schedule_time)
-{
-    uint16_t current_year = current_time->tm_year + 1900;
-    uint16_t schedule_year = trigger->date.year;
-    if (schedule_year > current_year) {
-        return schedule_year;
-    }
-    /* If the schedule is set to repeat_every_year, we return the current year */
-    /* If the schedule has already passed in this year, we still return current year, as the additional months will be handled in get_next_month */
-    return current_year;
+    if (schedule->validity.end_time != 0 && next > schedule->validity.end_time) {
+        return 0;
+    }
+    return next;
 }
 
-static uint32_t esp_schedule_get_next_schedule_time_diff(const char *schedule_name, esp_schedule_trigger_t *trigger)
+static uint32_t esp_schedule_get_next_schedule_time_diff(esp_schedule_t *schedule)
 {
-    struct tm current_time, schedule_time;
+    const char *schedule_name = schedule->name;
+    esp_schedule_trigger_t *trigger = &schedule->trigger;
+    struct tm schedule_time;
     time_t now;
     char time_str[64];
     int32_t time_diff;
@@ -187,46 +165,22 @@ static uint32_t esp_schedule_get_next_schedule_time_diff(const char *schedule_na
         ESP_LOGI(TAG, "Schedule %s will be active on: %s. DST: %s", schedule_name, time_str, schedule_time.tm_isdst ? "Yes" : "No");
         return time_diff;
     }
-    localtime_r(&now, &current_time);
-
-    /* Get schedule time */
-    localtime_r(&now, &schedule_time);
-    schedule_time.tm_sec = 0;
-    schedule_time.tm_min = trigger->minutes;
-    schedule_time.tm_hour = trigger->hours;
-    mktime(&schedule_time);
 
-    /* Adjust schedule day */
-    if (trigger->type == ESP_SCHEDULE_TYPE_DAYS_OF_WEEK) {
-        int no_of_days = 0;
-        no_of_days = esp_schedule_get_no_of_days(trigger, &current_time, &schedule_time);
-        schedule_time.tm_sec += no_of_days * SECONDS_IN_DAY;
-    }
-    if (trigger->type == ESP_SCHEDULE_TYPE_DATE) {
-        schedule_time.tm_mday = trigger->date.day;
-        schedule_time.tm_mon = esp_schedule_get_next_month(trigger, &current_time, &schedule_time) - 1;
-        schedule_time.tm_year = esp_schedule_get_next_year(trigger, &current_time, &schedule_time) - 1900;
-        if (schedule_time.tm_mon < 0) {
-            ESP_LOGE(TAG, "Invalid month found: %d. Setting it to next month.", schedule_time.tm_mon);
-            schedule_time.tm_mon = current_time.tm_mon + 1;
-        }
-        if (schedule_time.tm_mon >= 12) {
-            schedule_time.tm_year += schedule_time.tm_mon / 12;
-            schedule_time.tm_mon = schedule_time.tm_mon % 12;
-        }
+    time_t next = esp_schedule_get_next_occurrence(schedule, now);
+    /* For one time schedules to check for expiry after a reboot. If NVS is enabled, this should be stored in NVS. */
+    trigger->next_scheduled_time_utc = next;
+    if (next == 0) {
+        ESP_LOGW(TAG, "Schedule %s has no occurrence left within its validity window", schedule_name);
+        return 0;
     }
-    mktime(&schedule_time);
 
-    /* Adjust time according to DST */
-    time_t dst_adjust = 0;
-    if (!current_time.tm_isdst && schedule_time.tm_isdst) {
-        dst_adjust = -3600;
-    } else if (current_time.tm_isdst && !schedule_time.tm_isdst ) {
-        dst_adjust = 3600;
+    localtime_r(&next, &schedule_time);
+    if (trigger->type == ESP_SCHEDULE_TYPE_DATE && !trigger->date.repeat_every_year
+            && trigger->date.repeat_months != ESP_SCHEDULE_MONTH_ONCE && trigger->date.year == 0) {
+        /* Pin the year of the first occurrence, so that the schedule ends with that year */
+        trigger->date.year = schedule_time.tm_year + 1900;
+        esp_schedule_nvs_add(schedule);
     }
-    ESP_LOGD(TAG, "DST adjust seconds: %lld", (long long) dst_adjust);
-    schedule_time.tm_sec += dst_adjust;
-    mktime(&schedule_time);
 
     /* Print schedule time */
     memset(time_str, 0, sizeof(time_str));
@@ -234,10 +188,7 @@ static uint32_t esp_schedule_get_next_schedule_time_diff(const char *schedule_na
     ESP_LOGI(TAG, "Schedule %s will be active on: %s. DST: %s", schedule_name, time_str, schedule_time.tm_isdst ? "Yes" : "No");
 
     /* Calculate difference */
-    time_diff = difftime((mktime(&schedule_time)), mktime(&current_time));
-
-    /* For one time schedules to check for expiry after a reboot. If NVS is enabled, this should be stored in NVS. */
-    trigger->next_scheduled_time_utc = mktime(&schedule_time);
+    time_diff = difftime(next, now);
 
     return time_diff;
 }
@@ -279,6 +230,10 @@ static bool esp_schedule_is_expired(esp_schedule_trigger_t *trigger)
         if (trigger->date.repeat_every_year == true) {
             return false;
         }
+        if (trigger->date.year == 0) {
+            /* Not armed yet, the year is pinned when it is */
+            return false;
+        }
 
         struct tm schedule_time = {0};
         localtime_r(&current_timestamp, &schedule_time);
@@ -305,10 +260,11 @@ static bool esp_schedule_is_expired(esp_schedule_trigger_t *trigger)
 
 static void esp_schedule_stop_timer(esp_schedule_t *schedule)
 {
-    xTimerStop(schedule->timer, portMAX_DELAY);
+    esp_schedule_timer_disarm(schedule);
 }
 
-static void esp_schedule_start_timer(esp_schedule_t *schedule)
+/* `rearm` is set at the end of a fire, which must not undo a disable or delete issued meanwhile */
+static void esp_schedule_start_timer(esp_schedule_t *schedule, bool rearm)
 {
     time_t current_time = 0;
     time(&current_time);
@@ -317,24 +273,27 @@ static void esp_schedule_start_timer(esp_schedule_t *schedule)
         return;
     }
 
-    schedule->next_scheduled_time_diff = esp_schedule_get_next_schedule_time_diff(schedule->name, &schedule->trigger);
+    schedule->next_scheduled_time_diff = esp_schedule_get_next_schedule_time_diff(schedule);
+    if (schedule->trigger.next_scheduled_time_utc == 0) {
+        /* Nothing left to fire within the validity window, do not arm at all */
+        esp_schedule_timer_disarm(schedule);
+        return;
+    }
+    if (!esp_schedule_timer_arm(schedule, schedule->trigger.next_scheduled_time_utc, rearm)) {
+        if (rearm) {
+            schedule->trigger.next_scheduled_time_utc = 0;
+        }
+        return;
+    }
     ESP_LOGI(TAG, "Starting a timer for %"PRIu32" seconds for schedule %s", schedule->next_scheduled_time_diff, schedule->name);
 
     if (schedule->timestamp_cb) {
         schedule->timestamp_cb((esp_schedule_handle_t)schedule, schedule->trigger.next_scheduled_time_utc, schedule->priv_data);
     }
-
-    xTimerStop(schedule->timer, portMAX_DELAY);
-    xTimerChangePeriod(schedule->timer, (schedule->next_scheduled_time_diff * 1000) / portTICK_PERIOD_MS, portMAX_DELAY);
 }
 
-static void esp_schedule_common_timer_cb(TimerHandle_t timer)
+void esp_schedule_timer_fire(esp_schedule_t *schedule)
 {
-    void *priv_data = pvTimerGetTimerID(timer);
-    if (priv_data == NULL) {
-        return;
-    }
-    esp_schedule_t *schedule = (esp_schedule_t *)priv_data;
     time_t now;
     time(&now);
     struct tm validity_time;
@@ -345,9 +304,7 @@ static void esp_schedule_common_timer_cb(TimerHandle_t timer)
             localtime_r(&schedule->validity.start_time, &validity_time);
             strftime(time_str, sizeof(time_str), "%c %z[%Z]", &validity_time);
             ESP_LOGW(TAG, "Schedule %s skipped. It will be active only after: %s. DST: %s.", schedule->name, time_str, validity_time.tm_isdst ? "Yes" : "No");
-            /* TODO: Start the timer such that the next time it triggeres, it will be within the valid window.
-             * Currently, it will just keep triggering and then get skipped if not in valid range.
-             */
+            /* Day/date schedules are armed inside the window already, only relative schedules get here */
             goto restart_schedule;
         }
     }
@@ -371,23 +328,18 @@ restart_schedule:
         /* Not deleting the schedule here. Just not starting it again. */
         return;
     }
-    esp_schedule_start_timer(schedule);
-}
-
-static void esp_schedule_delete_timer(esp_schedule_t *schedule)
-{
-    xTimerDelete(schedule->timer, portMAX_DELAY);
+    esp_schedule_start_timer(schedule, true);
 }
 
 static void esp_schedule_create_timer(esp_schedule_t *schedule)
 {
     if (esp_schedule_nvs_is_enabled()) {
         /* This is just used for calculating next_scheduled_time_utc for ESP_SCHEDULE_DAY_ONCE (in case of ESP_SCHEDULE_TYPE_DAYS_OF_WEEK) or for ESP_SCHEDULE_MONTH_ONCE (in case of ESP_SCHEDULE_TYPE_DATE), and only used when NVS is enabled. And if NVS is enabled, time will already be synced and the time will be correctly calculated. */
-        schedule->next_scheduled_time_diff = esp_schedule_get_next_schedule_time_diff(schedule->name, &schedule->trigger);
+        schedule->next_scheduled_time_diff = esp_schedule_get_next_schedule_time_diff(schedule);
     }
 
-    /* Temporarily setting the timer for 1 (anything greater than 0) tick. This will get changed when xTimerChangePeriod() is called. */
-    schedule->timer = xTimerCreate("schedule", 1, pdFALSE, (void *)schedule, esp_schedule_common_timer_cb);
+    /* The schedule is armed on the shared scheduler task by esp_schedule_start_timer() */
+    schedule->heap_index = -1;
 }
 
 esp_err_t esp_schedule_get(esp_schedule_handle_t handle, esp_schedule_config_t *schedule_config)
@@ -426,7 +378,7 @@ esp_err_t esp_schedule_enable(esp_schedule_handle_t handle)
         return ESP_ERR_INVALID_ARG;
     }
     esp_schedule_t *schedule = (esp_schedule_t *)handle;
-    esp_schedule_start_timer(schedule);
+    esp_schedule_start_timer(schedule, false);
     return ESP_OK;
 }
 
@@ -500,12 +452,11 @@ esp_err_t esp_schedule_delete(esp_schedule_handle_t handle)
     }
     esp_schedule_t *schedule = (esp_schedule_t *)handle;
     ESP_LOGI(TAG, "Deleting schedule %s", schedule->name);
-    if (schedule->timer) {
-        esp_schedule_stop_timer(schedule);
-        esp_schedule_delete_timer(schedule);
-    }
     esp_schedule_nvs_remove(schedule);
-    free(schedule);
+    /* A schedule deleted from its own callback is freed by the scheduler task after the fire */
+    if (esp_schedule_timer_release(schedule)) {
+        free(schedule);
+    }
     return ESP_OK;
 }
 
@@ -580,7 +531,7 @@ esp_schedule_handle_t *esp_schedule_init(bool enable_nvs, char *nvs_partition, u
     for (size_t handle_count = 0; handle_count < *schedule_count; handle_count++) {
         schedule = (esp_schedule_t *)handle_list[handle_count];
         schedule->trigger_cb = NULL;
-        schedule->timer = NULL;
+        schedule->heap_index = -1;
         /* Check for ONCE and expired schedules and delete them. */
         if (esp_schedule_is_expired(&schedule->trigger)) {
             /* This schedule has already expired. */
@@ -593,7 +544,7 @@ esp_schedule_handle_t *esp_schedule_init(bool enable_nvs, char *nvs_partition, u
             continue;
         }
         esp_schedule_create_timer(schedule);
-        esp_schedule_start_timer(schedule);
+        esp_schedule_start_timer(schedule, false);
     }
     init_done = true;
     return handle_list;
@@ -7,18 +7,20 @@
 #pragma once
 
 #include <freertos/FreeRTOS.h>
-#include <freertos/timers.h>
 #include <esp_schedule.h>
 
 typedef struct esp_schedule {
     char name[MAX_SCHEDULE_NAME_LEN + 1];
     esp_schedule_trigger_t trigger;
     uint32_t next_scheduled_time_diff;
-    TimerHandle_t timer;
+    /* Position in the timer heap, -1 when the schedule is not armed */
+    int heap_index;
     esp_schedule_trigger_cb_t trigger_cb;
     esp_schedule_timestamp_cb_t timestamp_cb;
     void *priv_data;
     esp_schedule_validity_t validity;
+    /* Absolute time at which the schedule fires next, valid while armed. Appended last to keep older NVS blobs readable. */
+    time_t next_fire;
 } esp_schedule_t;
 
 esp_err_t esp_schedule_nvs_add(esp_schedule_t *schedule);
@@ -26,3 +28,15 @@ esp_err_t esp_schedule_nvs_remove(esp_schedule_t *schedule);
 esp_schedule_handle_t *esp_schedule_nvs_get_all(uint8_t *schedule_count);
 bool esp_schedule_nvs_is_enabled(void);
 esp_err_t esp_schedule_nvs_init(char *nvs_partition);
+
+/* Arms or moves the schedule. A re-arm at the end of a fire is dropped, returning false, if the schedule was
+ * disarmed or released while it fired.
+ */
+bool esp_schedule_timer_arm(esp_schedule_t *schedule, time_t fire_time, bool rearm);
+void esp_schedule_timer_disarm(esp_schedule_t *schedule);
+/* Disarms the schedule before it is freed. Returns once no fire of it runs any more. From the schedule's own
+ * callback it returns false instead, and the scheduler task frees the schedule when the fire is over.
+ */
+bool esp_schedule_timer_release(esp_schedule_t *schedule);
+/* Called from the scheduler task once the fire time of an armed schedule is reached */
+void esp_schedule_timer_fire(esp_schedule_t *schedule);
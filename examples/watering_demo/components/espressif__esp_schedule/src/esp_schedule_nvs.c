@@ -183,7 +183,13 @@ static esp_schedule_handle_t esp_schedule_nvs_get(char *nvs_key)
         nvs_close(nvs_handle);
         return NULL;
     }
-    esp_schedule_t *schedule = (esp_schedule_t *)malloc(buf_size);
+    if (buf_size > sizeof(esp_schedule_t)) {
+        ESP_LOGE(TAG, "Schedule %s has unexpected size %d", nvs_key, (int)buf_size);
+        nvs_close(nvs_handle);
+        return NULL;
+    }
+    /* Blobs saved by older versions may be shorter, the missing trailing fields stay zero */
+    esp_schedule_t *schedule = (esp_schedule_t *)calloc(1, sizeof(esp_schedule_t));
     if (schedule == NULL) {
         ESP_LOGE(TAG, "Could not allocate handle");
         nvs_close(nvs_handle);
@@ -0,0 +1,254 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* All schedules share one task which sleeps until the earliest fire time in a
+ * binary min-heap. Arming, disarming and firing are O(log n) and no per-schedule
+ * FreeRTOS timer is allocated.
+ *
+ * A schedule being fired is out of the heap and used without the lock. The task
+ * records it in `firing`, so that a disarm meanwhile drops the re-arm at the end
+ * of the fire and a release waits for the fire, or leaves the free to this task
+ * when the schedule's own callback releases it.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include "esp_schedule_internal.h"
+
+static const char *TAG = "esp_schedule_timer";
+
+#ifndef ESP_SCHEDULE_TASK_STACK_SIZE
+#define ESP_SCHEDULE_TASK_STACK_SIZE    (4 * 1024)
+#endif
+#ifndef ESP_SCHEDULE_TASK_PRIORITY
+#define ESP_SCHEDULE_TASK_PRIORITY      5
+#endif
+/* Upper bound of a single sleep, so that wall clock corrections (SNTP) are picked up */
+#define ESP_SCHEDULE_MAX_SLEEP_SEC      (10 * 60)
+#define ESP_SCHEDULE_HEAP_INITIAL_SIZE  8
+
+static esp_schedule_t **heap = NULL;
+static int heap_size = 0;
+static int heap_capacity = 0;
+static SemaphoreHandle_t heap_lock = NULL;
+static TaskHandle_t scheduler_task = NULL;
+/* Schedule the task fires right now, and what happened to it meanwhile, under heap_lock */
+static esp_schedule_t *firing = NULL;
+static bool firing_disarmed = false;
+static bool firing_released = false;
+
+static void esp_schedule_heap_swap(int a, int b)
+{
+    esp_schedule_t *tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    heap[a]->heap_index = a;
+    heap[b]->heap_index = b;
+}
+
+static void esp_schedule_heap_sift_up(int index)
+{
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (heap[parent]->next_fire <= heap[index]->next_fire) {
+            break;
+        }
+        esp_schedule_heap_swap(parent, index);
+        index = parent;
+    }
+}
+
+static void esp_schedule_heap_sift_down(int index)
+{
+    while (1) {
+        int smallest = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if (left < heap_size && heap[left]->next_fire < heap[smallest]->next_fire) {
+            smallest = left;
+        }
+        if (right < heap_size && heap[right]->next_fire < heap[smallest]->next_fire) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+        esp_schedule_heap_swap(index, smallest);
+        index = smallest;
+    }
+}
+
+static void esp_schedule_heap_remove(esp_schedule_t *schedule)
+{
+    int index = schedule->heap_index;
+    if (index < 0 || index >= heap_size || heap[index] != schedule) {
+        return;
+    }
+    heap_size--;
+    if (index != heap_size) {
+        heap[index] = heap[heap_size];
+        heap[index]->heap_index = index;
+        esp_schedule_heap_sift_down(index);
+        esp_schedule_heap_sift_up(index);
+    }
+    schedule->heap_index = -1;
+}
+
+static bool esp_schedule_heap_reserve(int capacity)
+{
+    if (capacity <= heap_capacity) {
+        return true;
+    }
+    int new_capacity = heap_capacity ? heap_capacity * 2 : ESP_SCHEDULE_HEAP_INITIAL_SIZE;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+    esp_schedule_t **new_heap = realloc(heap, new_capacity * sizeof(esp_schedule_t *));
+    if (new_heap == NULL) {
+        return false;
+    }
+    heap = new_heap;
+    heap_capacity = new_capacity;
+    return true;
+}
+
+static void esp_schedule_timer_task(void *arg)
+{
+    while (1) {
+        time_t now;
+        time(&now);
+
+        xSemaphoreTake(heap_lock, portMAX_DELAY);
+        if (heap_size > 0 && heap[0]->next_fire <= now) {
+            esp_schedule_t *schedule = heap[0];
+            esp_schedule_heap_remove(schedule);
+            firing = schedule;
+            firing_disarmed = false;
+            firing_released = false;
+            xSemaphoreGive(heap_lock);
+            /* The callback may re-arm, edit or disable schedules, so it runs without the lock held */
+            esp_schedule_timer_fire(schedule);
+
+            xSemaphoreTake(heap_lock, portMAX_DELAY);
+            bool released = firing_released;
+            firing = NULL;
+            xSemaphoreGive(heap_lock);
+            if (released) {
+                free(schedule);
+            }
+            continue;
+        }
+        time_t sleep_sec = ESP_SCHEDULE_MAX_SLEEP_SEC;
+        if (heap_size > 0 && heap[0]->next_fire - now < sleep_sec) {
+            sleep_sec = heap[0]->next_fire - now;
+        }
+        xSemaphoreGive(heap_lock);
+
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleep_sec * 1000));
+    }
+}
+
+static esp_err_t esp_schedule_timer_init(void)
+{
+    if (scheduler_task) {
+        return ESP_OK;
+    }
+    heap_lock = xSemaphoreCreateMutex();
+    if (heap_lock == NULL) {
+        ESP_LOGE(TAG, "Could not create heap lock");
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(esp_schedule_timer_task, "schedule", ESP_SCHEDULE_TASK_STACK_SIZE, NULL,
+                    ESP_SCHEDULE_TASK_PRIORITY, &scheduler_task) != pdPASS) {
+        ESP_LOGE(TAG, "Could not create scheduler task");
+        vSemaphoreDelete(heap_lock);
+        heap_lock = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool esp_schedule_timer_arm(esp_schedule_t *schedule, time_t fire_time, bool rearm)
+{
+    if (esp_schedule_timer_init() != ESP_OK) {
+        return false;
+    }
+
+    xSemaphoreTake(heap_lock, portMAX_DELAY);
+    if (schedule == firing) {
+        if (rearm && (firing_disarmed || firing_released)) {
+            /* Disabled or deleted while it fired */
+            xSemaphoreGive(heap_lock);
+            return false;
+        }
+        if (!rearm) {
+            /* Enabled again while it fires, the re-arm at the end of the fire goes ahead too */
+            firing_disarmed = false;
+        }
+    }
+    esp_schedule_heap_remove(schedule);
+    if (!esp_schedule_heap_reserve(heap_size + 1)) {
+        xSemaphoreGive(heap_lock);
+        ESP_LOGE(TAG, "Could not arm schedule %s", schedule->name);
+        return false;
+    }
+    schedule->next_fire = fire_time;
+    schedule->heap_index = heap_size;
+    heap[heap_size++] = schedule;
+    esp_schedule_heap_sift_up(schedule->heap_index);
+    bool is_earliest = (heap[0] == schedule);
+    xSemaphoreGive(heap_lock);
+
+    /* Only a new earliest deadline shortens the current sleep */
+    if (is_earliest) {
+        xTaskNotifyGive(scheduler_task);
+    }
+    return true;
+}
+
+void esp_schedule_timer_disarm(esp_schedule_t *schedule)
+{
+    if (heap_lock == NULL) {
+        return;
+    }
+    xSemaphoreTake(heap_lock, portMAX_DELAY);
+    esp_schedule_heap_remove(schedule);
+    if (schedule == firing) {
+        firing_disarmed = true;
+    }
+    xSemaphoreGive(heap_lock);
+}
+
+bool esp_schedule_timer_release(esp_schedule_t *schedule)
+{
+    if (heap_lock == NULL) {
+        return true;
+    }
+    xSemaphoreTake(heap_lock, portMAX_DELAY);
+    esp_schedule_heap_remove(schedule);
+    if (schedule == firing && xTaskGetCurrentTaskHandle() == scheduler_task) {
+        /* Deleted from its own callback, freed by the task once the fire returns */
+        firing_released = true;
+        xSemaphoreGive(heap_lock);
+        return false;
+    }
+    if (schedule == firing) {
+        firing_disarmed = true;
+    }
+    /* Fires end with the callback, a short poll is enough to wait for one */
+    while (schedule == firing) {
+        xSemaphoreGive(heap_lock);
+        vTaskDelay(1);
+        xSemaphoreTake(heap_lock, portMAX_DELAY);
+    }
+    xSemaphoreGive(heap_lock);
+    return true;
+}
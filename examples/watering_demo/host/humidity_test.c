@@ -0,0 +1,397 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * app_humidity.c on a simulated soil sensor: each second takes a burst from the fake ADC of stubs/fake_adc.c and runs
+ * it through the median, the IIR filter, the calibration table and the hysteresis, as humidity_task does. The sensor
+ * adds noise, single-sample spikes and reads lost to Wi-Fi. The tests count the watcher notifications and the error
+ * of the reported value against the true moisture, and check the calibration table and how it is saved to NVS.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "fake_adc.h"
+#include "fake_nvs.h"
+#include "app_pump.h"
+
+/* Included to step the sampling loop of humidity_task one period at a time */
+#include "app_humidity.c"
+
+#define CHECK(cond, ...) do {                       \
+        if (!(cond)) {                              \
+            printf("FAIL %s:%d: ", __func__, __LINE__); \
+            printf(__VA_ARGS__);                    \
+            printf("\n");                           \
+            return false;                           \
+        }                                           \
+    } while (0)
+
+typedef struct {
+    double mv;              /*!< True sensor output */
+    double noise_mv;        /*!< Standard deviation of a conversion */
+    double spike_rate;      /*!< Conversions read as 0 or full scale */
+    double timeout_rate;    /*!< Conversions lost to Wi-Fi */
+    uint32_t rng;
+} soil_sensor_t;
+
+static soil_sensor_t s_sensor;
+static int s_notified;
+
+static uint32_t xorshift32(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static double uniform(soil_sensor_t *sensor)
+{
+    return (xorshift32(&sensor->rng) >> 8) / (double)(1 << 24);
+}
+
+/* Sum of 12 uniforms, close enough to a normal distribution for ADC noise */
+static double gaussian(soil_sensor_t *sensor)
+{
+    double sum = 0;
+    for (int i = 0; i < 12; i++) {
+        sum += uniform(sensor);
+    }
+    return sum - 6;
+}
+
+static int sensor_read(void *arg)
+{
+    soil_sensor_t *sensor = arg;
+    double p = uniform(sensor);
+
+    if (p < sensor->timeout_rate) {
+        return -1;
+    }
+    if (p < sensor->timeout_rate + sensor->spike_rate) {
+        return (xorshift32(&sensor->rng) & 1) ? 4095 : 0;
+    }
+    int raw = (int) lround((sensor->mv + gaussian(sensor) * sensor->noise_mv) * 4095 / APP_HUMIDITY_ADC_MAX_INPUT_V);
+    return raw < 0 ? 0 : raw;
+}
+
+static void on_humidity(void *args)
+{
+    (*(int *) args)++;
+}
+
+/* A freshly booted sensor with an empty NVS unless `keep_nvs` */
+static bool sim_reset(bool keep_nvs)
+{
+    app_humidity_t *ref = humidity_ref();
+
+    if (ref->cal_lock) {
+        vSemaphoreDelete(ref->cal_lock);
+    }
+    memset(ref, 0, sizeof(*ref));
+    if (!keep_nvs) {
+        fake_nvs_reset();
+    }
+    s_sensor = (soil_sensor_t) {
+        .mv = 2000, .noise_mv = 25, .spike_rate = 0.03, .timeout_rate = 0.05, .rng = 0x2545f491
+    };
+    fake_adc_set_reader(sensor_read, &s_sensor);
+    s_notified = 0;
+    CHECK(app_humidity_init() == ESP_OK, "init");
+    CHECK(app_humidity_add_watcher(on_humidity, &s_notified) == ESP_OK, "watcher");
+    ref->adc_channel = ADC_CHANNEL_0;
+    ref->adc_atten = ADC_ATTEN_DB_11;
+    ref->adc_width = SOC_ADC_RTC_MAX_BITWIDTH;
+    app_humidity_drive_init(ref);
+    return true;
+}
+
+/* One pass of the humidity_task loop */
+static void sim_tick(void)
+{
+    app_humidity_t *ref = humidity_ref();
+    int mv = app_humidity_drive_read_mv(ref);
+    if (mv >= 0) {
+        app_humidity_update(ref, mv);
+    }
+}
+
+static double true_humidity(void)
+{
+    app_humidity_t *ref = humidity_ref();
+    return cal_mv_to_humidity(ref->cal, ref->cal_num, (int) lround(s_sensor.mv)) / 10.0;
+}
+
+typedef struct {
+    int notified;
+    int reversals;          /*!< Reports moving against the trend of the true value */
+    double max_error;       /*!< Largest |reported - true| in % once settled */
+    int unfiltered;         /*!< Reports of one conversion per second, on every change of the whole percent */
+} sim_result_t;
+
+/* Moves the true voltage from `from` to `to` over `ramp_s` and holds it until `seconds`, errors count from `settle_s` */
+static sim_result_t sim_run(double from, double to, int ramp_s, int seconds, int settle_s)
+{
+    sim_result_t result = {0};
+    app_humidity_t *ref = humidity_ref();
+    soil_sensor_t unfiltered = s_sensor;
+    int last_reported = -1;
+    int last_unfiltered = -1;
+    int start = s_notified;
+
+    for (int t = 0; t < seconds; t++) {
+        s_sensor.mv = t < ramp_s ? from + (to - from) * t / ramp_s : to;
+        unfiltered.mv = s_sensor.mv;
+        sim_tick();
+
+        if (ref->humidity_valid) {
+            if (last_reported >= 0 && (ref->humidity - last_reported) * (from - to) < 0) {
+                result.reversals++;
+            }
+            last_reported = ref->humidity;
+            double error = fabs(ref->humidity - true_humidity());
+            if (t >= settle_s && error > result.max_error) {
+                result.max_error = error;
+            }
+        }
+
+        int raw = sensor_read(&unfiltered);
+        if (raw >= 0) {
+            int value = (cal_mv_to_humidity(ref->cal, ref->cal_num, raw * APP_HUMIDITY_ADC_MAX_INPUT_V / 4095) + 5) / 10;
+            result.unfiltered += value != last_unfiltered;
+            last_unfiltered = value;
+        }
+    }
+    result.notified = s_notified - start;
+    return result;
+}
+
+static void print_result(const char *name, const sim_result_t *result)
+{
+    printf("%-22s %9d %9d %11.1f %11d\n", name, result->notified, result->reversals, result->max_error,
+           result->unfiltered);
+}
+
+static bool test_steady(void)
+{
+    const int levels[] = {1500, 2000, 2312, 2700};
+
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); i++) {
+        if (!sim_reset(false)) {
+            return false;
+        }
+        sim_result_t result = sim_run(levels[i], levels[i], 0, 1800, 30);
+        char name[32];
+        snprintf(name, sizeof(name), "steady %d mV", levels[i]);
+        print_result(name, &result);
+        CHECK(result.notified == 1, "%d mV notified %d times in 30 min", levels[i], result.notified);
+        CHECK(result.max_error <= 1, "%d mV off by %.1f %%", levels[i], result.max_error);
+    }
+    return true;
+}
+
+static bool test_bad_link(void)
+{
+    if (!sim_reset(false)) {
+        return false;
+    }
+    s_sensor.spike_rate = 0.06;
+    s_sensor.timeout_rate = 0.3;
+    s_sensor.noise_mv = 40;
+    sim_result_t result = sim_run(2100, 2100, 0, 1800, 30);
+    print_result("spikes and timeouts", &result);
+    CHECK(result.notified == 1, "notified %d times", result.notified);
+    CHECK(result.max_error <= 1, "off by %.1f %%", result.max_error);
+    return true;
+}
+
+static bool test_drying(void)
+{
+    if (!sim_reset(false)) {
+        return false;
+    }
+    sim_run(1600, 1600, 0, 60, 0);
+    double start = true_humidity();
+    sim_result_t result = sim_run(1600, 2600, 7200, 7260, 0);
+    double span = start - true_humidity();
+    print_result("drying over 2 h", &result);
+    CHECK(result.reversals == 0, "%d reports went up while drying", result.reversals);
+    /* The band is 1.5 % wide but reports are whole percents, so each one moves at least 1 % */
+    CHECK(result.notified <= span + 1, "%d reports over %.1f %%", result.notified, span);
+    CHECK(result.max_error <= 2, "lagged by %.1f %%", result.max_error);
+    return true;
+}
+
+static bool test_watering_step(void)
+{
+    app_humidity_t *ref = humidity_ref();
+
+    if (!sim_reset(false)) {
+        return false;
+    }
+    sim_run(2600, 2600, 0, 120, 0);
+    s_sensor.mv = 1500;
+    int settled = -1;
+    for (int t = 0; t < 120 && settled < 0; t++) {
+        sim_tick();
+        if (fabs(ref->humidity - true_humidity()) <= 2) {
+            settled = t + 1;
+        }
+    }
+    sim_result_t result = sim_run(1500, 1500, 0, 600, 0);
+    print_result("after watering", &result);
+    printf("watering step settled within 2 %% after %d s\n", settled);
+    CHECK(settled > 0 && settled <= 40, "settled after %d s", settled);
+    CHECK(result.max_error <= 1 && result.notified <= 1, "kept moving: %d reports, off by %.1f %%", result.notified,
+          result.max_error);
+    return true;
+}
+
+static bool test_no_reading(void)
+{
+    if (!sim_reset(false)) {
+        return false;
+    }
+    s_sensor.timeout_rate = 1;
+    for (int t = 0; t < 10; t++) {
+        sim_tick();
+    }
+    CHECK(app_humidity_get_voltage() == -1, "voltage %d without a reading", app_humidity_get_voltage());
+    CHECK(s_notified == 0, "notified without a reading");
+    CHECK(fake_adc_reads() > 0, "no read attempted");
+    return true;
+}
+
+static bool test_cal_interpolation(void)
+{
+    const app_humidity_cal_point_t cal[] = {
+        {.mv = 1000, .humidity = 90}, {.mv = 2000, .humidity = 50}, {.mv = 3000, .humidity = 10},
+    };
+    const struct {
+        int mv;
+        int value;
+    } cases[] = {
+        {0, 900}, {1000, 900}, {1500, 700}, {2000, 500}, {2500, 300}, {3000, 100}, {3100, 100},
+        {1001, 900}, {1013, 895}, {1012, 895}, {2999, 100},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        int value = cal_mv_to_humidity(cal, 3, cases[i].mv);
+        CHECK(value == cases[i].value, "%d mV -> %d, expected %d", cases[i].mv, value, cases[i].value);
+    }
+    return true;
+}
+
+static bool test_cal_normalize(void)
+{
+    app_humidity_cal_point_t cal[] = {
+        {.mv = 3000, .humidity = 10}, {.mv = 1000, .humidity = 90}, {.mv = 2000, .humidity = 50},
+    };
+    CHECK(cal_normalize(cal, 3) == ESP_OK, "valid table");
+    CHECK(cal[0].mv == 1000 && cal[1].mv == 2000 && cal[2].mv == 3000, "not sorted");
+
+    CHECK(cal_normalize(cal, 1) == ESP_ERR_INVALID_SIZE, "one point");
+    CHECK(cal_normalize(cal, APP_HUMIDITY_CAL_MAX_POINTS + 1) == ESP_ERR_INVALID_SIZE, "too many points");
+
+    app_humidity_cal_point_t dup[] = {{.mv = 1000, .humidity = 90}, {.mv = 1000, .humidity = 50}};
+    CHECK(cal_normalize(dup, 2) == ESP_ERR_INVALID_ARG, "duplicated voltage");
+
+    app_humidity_cal_point_t range[] = {{.mv = 1000, .humidity = 101}, {.mv = 2000, .humidity = 50}};
+    CHECK(cal_normalize(range, 2) == ESP_ERR_INVALID_ARG, "moisture above 100");
+    return true;
+}
+
+static bool cal_equal(const app_humidity_cal_point_t *a, const app_humidity_cal_point_t *b, size_t num)
+{
+    return !memcmp(a, b, num * sizeof(app_humidity_cal_point_t));
+}
+
+static bool test_cal_saved(void)
+{
+    const app_humidity_cal_point_t set[] = {{.mv = 2500, .humidity = 20}, {.mv = 1300, .humidity = 80}};
+    const app_humidity_cal_point_t sorted[] = {{.mv = 1300, .humidity = 80}, {.mv = 2500, .humidity = 20}};
+    app_humidity_cal_point_t got[APP_HUMIDITY_CAL_MAX_POINTS];
+
+    if (!sim_reset(false)) {
+        return false;
+    }
+    CHECK(app_humidity_cal_set(set, 2) == ESP_OK, "set");
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, sorted, 2), "in use");
+
+    /* The table is back after a reboot */
+    if (!sim_reset(true)) {
+        return false;
+    }
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, sorted, 2), "after reboot");
+
+    CHECK(app_humidity_cal_set(NULL, 0) == ESP_OK, "restore factory table");
+    CHECK(!fake_nvs_has_key("humidity_cal"), "key left");
+    if (!sim_reset(true)) {
+        return false;
+    }
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, default_cal, 2),
+          "factory table after reboot");
+    CHECK(fake_nvs_open_handles() == 0, "%d handles left open", fake_nvs_open_handles());
+    return true;
+}
+
+static bool test_commit_failure(void)
+{
+    const app_humidity_cal_point_t first[] = {{.mv = 1300, .humidity = 80}, {.mv = 2500, .humidity = 20}};
+    const app_humidity_cal_point_t second[] = {{.mv = 1400, .humidity = 70}, {.mv = 2600, .humidity = 10}};
+    app_humidity_cal_point_t got[APP_HUMIDITY_CAL_MAX_POINTS];
+
+    if (!sim_reset(false)) {
+        return false;
+    }
+    CHECK(app_humidity_cal_set(first, 2) == ESP_OK, "set");
+
+    /* A table that did not reach the flash must not be used, it would be gone after a reboot */
+    fake_nvs_fail_next_commit(ESP_FAIL);
+    CHECK(app_humidity_cal_set(second, 2) == ESP_FAIL, "failed commit not reported");
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, first, 2), "unsaved table used");
+
+    fake_nvs_fail_next_commit(ESP_FAIL);
+    CHECK(app_humidity_cal_set(NULL, 0) == ESP_FAIL, "failed erase not reported");
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, first, 2), "unsaved erase used");
+
+    if (!sim_reset(true)) {
+        return false;
+    }
+    CHECK(app_humidity_cal_get(got, APP_HUMIDITY_CAL_MAX_POINTS) == 2 && cal_equal(got, first, 2), "after reboot");
+
+    /* The other settings report it the same way */
+    int time = 0;
+    fake_nvs_fail_next_commit(ESP_FAIL);
+    CHECK(app_nvs_set_watering_time(25) == ESP_FAIL, "watering time");
+    CHECK(app_nvs_get_watering_time(&time) == ESP_OK && time == APP_PUMP_WATERING_DEFAULT_TIME, "time %d", time);
+    fake_nvs_fail_next_commit(ESP_FAIL);
+    CHECK(app_nvs_set_lower_humidity(30) == ESP_FAIL, "lower humidity");
+    fake_nvs_fail_next_commit(ESP_FAIL);
+    CHECK(app_nvs_set_auto_watering_enable(false) == ESP_FAIL, "auto watering");
+    CHECK(fake_nvs_open_handles() == 0, "%d handles left open", fake_nvs_open_handles());
+    return true;
+}
+
+int main(void)
+{
+    bool (*const tests[])(void) = {
+        test_steady, test_bad_link, test_drying, test_watering_step, test_no_reading,
+        test_cal_interpolation, test_cal_normalize, test_cal_saved, test_commit_failure,
+    };
+    int failed = 0;
+
+    printf("%-22s %9s %9s %11s %11s\n", "scenario", "notified", "reversed", "max err %", "unfiltered");
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        failed += !tests[i]();
+    }
+    printf("%s\n", failed ? "FAILED" : "All checks passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * The three controllers of app_pump_ctrl.c on a simulated pot for a week, one second per step. Water from the pump
+ * first sits on the surface, soaks into the root zone and only then reaches the probe. The root zone loses water to
+ * evaporation that follows the sun and drains above field capacity. The pump task steps the controller once per
+ * second while the pump is idle, the same happens here.
+ *
+ * The controllers are compared with the watering of app_pump.c before app_pump_ctrl.c: a full max_watering_time
+ * start on every humidity report at or below the lower bound, without any limit. Prints pump starts and water per
+ * day, the worst overshoot of the root zone over the target and how well the moisture stays between the lower bound
+ * and the target, for sand, loam and clay. Exits with 1 when a controller breaks the minimum interval between starts
+ * or the daily budget, or keeps pumping from an empty tank.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "app_pump_ctrl.h"
+
+#define SIM_DAY_S           (24 * 60 * 60)
+#define SIM_DAYS            (7)
+
+/* The settings of app_pump.c with the default watering time and lower humidity */
+#define SIM_LOWER           (40)
+#define SIM_TARGET          (48)
+#define SIM_MAX_PULSE       (10)
+
+typedef struct {
+    const char *name;
+    double gain;            /*!< Root zone moisture added by one second of pumping, % */
+    double infil_tau_s;     /*!< Surface to root zone */
+    double probe_tau_s;     /*!< Root zone to probe */
+    double field_capacity;  /*!< Moisture above which the pot drains, % */
+    double drain_tau_s;
+    double et_peak;         /*!< Evaporation at noon, % per hour at field capacity */
+} soil_param_t;
+
+typedef struct {
+    const soil_param_t *param;
+    double surface;         /*!< Water on its way to the root zone, % */
+    double root;
+    double probe;
+    bool tank_empty;
+} soil_t;
+
+static const soil_param_t s_soils[] = {
+    {"sand", 0.25,  5 * 60, 10 * 60, 50, 1 * 3600, 1.0},
+    {"loam", 0.15, 10 * 60, 15 * 60, 55, 3 * 3600, 0.6},
+    {"clay", 0.08, 30 * 60, 30 * 60, 60, 8 * 3600, 0.4},
+};
+
+static const struct {
+    const char *name;
+    bool baseline;          /*!< The former watcher of app_pump.c instead of app_pump_ctrl.c */
+    app_pump_ctrl_type_t type;
+} s_ctrls[] = {
+    {"fixed", true, APP_PUMP_CTRL_BANG_BANG},      /* type unused */
+    {"bang-bang", false, APP_PUMP_CTRL_BANG_BANG},
+    {"pulse-soak", false, APP_PUMP_CTRL_PULSE_SOAK},
+    {"pi", false, APP_PUMP_CTRL_PI},
+};
+
+static void soil_step(soil_t *soil, uint32_t now_s, bool pumping)
+{
+    const soil_param_t *p = soil->param;
+
+    if (pumping && !soil->tank_empty) {
+        soil->surface += p->gain;
+    }
+    double flow = soil->surface / p->infil_tau_s;
+    soil->surface -= flow;
+    soil->root += flow;
+
+    /* Mostly during the day, a tenth of the peak at night, slower as the soil dries */
+    double sun = sin(2 * M_PI * ((now_s % SIM_DAY_S) - 6 * 3600.0) / SIM_DAY_S);
+    double et = p->et_peak * (0.1 + 0.9 * (sun > 0 ? sun : 0)) / 3600;
+    soil->root -= et * soil->root / p->field_capacity;
+    if (soil->root > p->field_capacity) {
+        soil->root -= (soil->root - p->field_capacity) / p->drain_tau_s;
+    }
+    soil->probe += (soil->root - soil->probe) / p->probe_tau_s;
+}
+
+typedef struct {
+    int starts;
+    int empty_starts;       /*!< Starts with the tank empty */
+    int water_s;
+    int max_day_s;
+    int min_gap_s;          /*!< Shortest time between two pump starts */
+    double max_root;
+    double dry_share;       /*!< Time with the root zone below the lower bound - 2 */
+    double wet_share;       /*!< Time with the root zone above the target + 2 */
+    bool locked;
+} sim_result_t;
+
+/*
+ * app_pump_auto_watering() as a humidity watcher: app_humidity.c notifies each change of the reported value, a value
+ * at or below the lower bound starts the pump for max_watering_time. Starts while watering are ignored.
+ */
+static int baseline_step(int *reported, int moisture)
+{
+    if (moisture == *reported) {
+        return 0;
+    }
+    *reported = moisture;
+    return moisture <= SIM_LOWER ? SIM_MAX_PULSE : 0;
+}
+
+static sim_result_t sim_run(size_t ctrl_index, const soil_param_t *param, int empty_after_s)
+{
+    bool baseline = s_ctrls[ctrl_index].baseline;
+    sim_result_t result = {.min_gap_s = SIM_DAY_S};
+    app_pump_ctrl_t ctrl;
+    app_pump_ctrl_cfg_t cfg = {
+        .type = s_ctrls[ctrl_index].type,
+        .lower = SIM_LOWER,
+        .target = SIM_TARGET,
+        .min_pulse_s = 2,
+        .max_pulse_s = SIM_MAX_PULSE,
+        .soak_s = 30 * 60,
+        .min_interval_s = 5 * 60,
+        .max_daily_s = 5 * 60,
+        .max_dry_pulses = 4,
+    };
+    soil_t soil = {.param = param, .root = SIM_LOWER + 5, .probe = SIM_LOWER + 5};
+    int pump_left = 0;
+    int pulse = 0;
+    int day_s = 0;
+    int dry = 0, wet = 0;
+    uint32_t last_start = 0;
+    int reported = -1;
+
+    app_pump_ctrl_init(&ctrl, &cfg);
+    for (uint32_t now = 0; now < SIM_DAYS * SIM_DAY_S; now++) {
+        if (now % SIM_DAY_S == 0) {
+            day_s = 0;
+        }
+        soil.tank_empty = empty_after_s >= 0 && now >= (uint32_t) empty_after_s;
+
+        int moisture = (int) lround(soil.probe);
+        if (pump_left) {
+            if (--pump_left == 0 && !baseline) {
+                app_pump_ctrl_watered(&ctrl, now, pulse, false);
+            }
+            if (baseline) {
+                baseline_step(&reported, moisture);
+            }
+        } else {
+            pulse = baseline ? baseline_step(&reported, moisture) : app_pump_ctrl_step(&ctrl, now, moisture);
+            if (pulse) {
+                if (result.starts && (int)(now - last_start) < result.min_gap_s) {
+                    result.min_gap_s = now - last_start;
+                }
+                last_start = now;
+                result.starts++;
+                result.empty_starts += soil.tank_empty;
+                result.water_s += pulse;
+                day_s += pulse;
+                result.max_day_s = day_s > result.max_day_s ? day_s : result.max_day_s;
+                pump_left = pulse;
+            }
+        }
+        soil_step(&soil, now, pump_left > 0);
+
+        result.max_root = soil.root > result.max_root ? soil.root : result.max_root;
+        dry += soil.root < SIM_LOWER - 2;
+        wet += soil.root > SIM_TARGET + 2;
+    }
+    result.dry_share = 100.0 * dry / (SIM_DAYS * SIM_DAY_S);
+    result.wet_share = 100.0 * wet / (SIM_DAYS * SIM_DAY_S);
+    result.locked = ctrl.locked;
+    return result;
+}
+
+static bool check_limits(const char *name, const sim_result_t *result)
+{
+    bool ok = true;
+
+    if (result->starts > 1 && result->min_gap_s < 5 * 60) {
+        printf("FAIL %s: two starts %d s apart\n", name, result->min_gap_s);
+        ok = false;
+    }
+    if (result->max_day_s > 5 * 60) {
+        printf("FAIL %s: %d s pumped in a day\n", name, result->max_day_s);
+        ok = false;
+    }
+    return ok;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("%-5s %-10s %8s %8s %8s %9s %7s %7s\n", "soil", "controller", "starts/d", "water/d", "max/day",
+           "overshoot", "dry %", "wet %");
+    for (size_t s = 0; s < sizeof(s_soils) / sizeof(s_soils[0]); s++) {
+        for (size_t c = 0; c < sizeof(s_ctrls) / sizeof(s_ctrls[0]); c++) {
+            sim_result_t result = sim_run(c, &s_soils[s], -1);
+            printf("%-5s %-10s %8.1f %6.1f s %6d s %+7.1f %% %7.1f %7.1f\n", s_soils[s].name, s_ctrls[c].name,
+                   (double) result.starts / SIM_DAYS, (double) result.water_s / SIM_DAYS, result.max_day_s,
+                   result.max_root - SIM_TARGET, result.dry_share, result.wet_share);
+            /* The former watering has no limits to check */
+            if (!s_ctrls[c].baseline) {
+                failed += !check_limits(s_ctrls[c].name, &result);
+            }
+        }
+    }
+
+    /* The tank runs dry at noon on the second day: every controller must stop after a few pulses */
+    printf("\nempty tank on loam after 36 h\n");
+    for (size_t c = 0; c < sizeof(s_ctrls) / sizeof(s_ctrls[0]); c++) {
+        sim_result_t result = sim_run(c, &s_soils[1], 36 * 3600);
+        if (s_ctrls[c].baseline) {
+            printf("%-10s %d starts on the empty tank, no lock out\n", s_ctrls[c].name, result.empty_starts);
+            continue;
+        }
+        printf("%-10s %d starts on the empty tank, %s\n", s_ctrls[c].name, result.empty_starts,
+               result.locked ? "locked" : "not locked");
+        if (!result.locked || result.empty_starts > 4) {
+            printf("FAIL %s: still pumping from an empty tank\n", s_ctrls[c].name);
+            failed++;
+        }
+        failed += !check_limits(s_ctrls[c].name, &result);
+    }
+    return failed ? 1 : 0;
+}
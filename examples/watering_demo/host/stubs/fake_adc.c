@@ -0,0 +1,54 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include <stddef.h>
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "fake_adc.h"
+
+static fake_adc_reader_t s_reader;
+static void *s_reader_arg;
+static unsigned s_reads;
+static int s_unit;
+
+void fake_adc_set_reader(fake_adc_reader_t reader, void *arg)
+{
+    s_reader = reader;
+    s_reader_arg = arg;
+}
+
+unsigned fake_adc_reads(void)
+{
+    return s_reads;
+}
+
+esp_err_t adc_oneshot_new_unit(const adc_oneshot_unit_init_cfg_t *init_config, adc_oneshot_unit_handle_t *ret_unit)
+{
+    *ret_unit = (adc_oneshot_unit_handle_t) &s_unit;
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_config_channel(adc_oneshot_unit_handle_t handle, adc_channel_t channel,
+                                     const adc_oneshot_chan_cfg_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t adc_oneshot_read(adc_oneshot_unit_handle_t handle, adc_channel_t chan, int *out_raw)
+{
+    s_reads++;
+    int raw = s_reader ? s_reader(s_reader_arg) : 0;
+    if (raw < 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *out_raw = raw > 4095 ? 4095 : raw;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
@@ -0,0 +1,169 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/*
+ * One namespace of typed keys in RAM. The keys are copied when a handle opens, so a failed commit can put them back
+ * and the writes of that handle are lost, as when the flash write behind the commit fails.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+#include "nvs.h"
+#include "fake_nvs.h"
+
+#define FAKE_NVS_KEYS       16
+#define FAKE_NVS_KEY_LEN    16
+#define FAKE_NVS_VALUE_MAX  64
+
+typedef enum {
+    FAKE_NVS_I8 = 1,
+    FAKE_NVS_I32,
+    FAKE_NVS_BLOB,
+} fake_nvs_type_t;
+
+typedef struct {
+    char key[FAKE_NVS_KEY_LEN];
+    fake_nvs_type_t type;
+    size_t size;
+    uint8_t value[FAKE_NVS_VALUE_MAX];
+} fake_nvs_entry_t;
+
+static fake_nvs_entry_t s_keys[FAKE_NVS_KEYS];
+static fake_nvs_entry_t s_snapshot[FAKE_NVS_KEYS];
+static int s_open;
+static esp_err_t s_commit_err;
+
+void fake_nvs_reset(void)
+{
+    memset(s_keys, 0, sizeof(s_keys));
+    s_open = 0;
+    s_commit_err = ESP_OK;
+}
+
+void fake_nvs_fail_next_commit(esp_err_t err)
+{
+    s_commit_err = err;
+}
+
+int fake_nvs_open_handles(void)
+{
+    return s_open;
+}
+
+static fake_nvs_entry_t *fake_nvs_find(const char *key)
+{
+    for (int i = 0; i < FAKE_NVS_KEYS; i++) {
+        if (s_keys[i].type && !strncmp(s_keys[i].key, key, FAKE_NVS_KEY_LEN)) {
+            return &s_keys[i];
+        }
+    }
+    return NULL;
+}
+
+bool fake_nvs_has_key(const char *key)
+{
+    return fake_nvs_find(key) != NULL;
+}
+
+static esp_err_t fake_nvs_set(const char *key, fake_nvs_type_t type, const void *value, size_t size)
+{
+    if (size > FAKE_NVS_VALUE_MAX || strlen(key) >= FAKE_NVS_KEY_LEN) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    fake_nvs_entry_t *entry = fake_nvs_find(key);
+    for (int i = 0; !entry && i < FAKE_NVS_KEYS; i++) {
+        if (!s_keys[i].type) {
+            entry = &s_keys[i];
+        }
+    }
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+    }
+    strncpy(entry->key, key, FAKE_NVS_KEY_LEN - 1);
+    entry->type = type;
+    entry->size = size;
+    memcpy(entry->value, value, size);
+    return ESP_OK;
+}
+
+static esp_err_t fake_nvs_get(const char *key, fake_nvs_type_t type, void *value, size_t *size)
+{
+    fake_nvs_entry_t *entry = fake_nvs_find(key);
+    if (!entry || entry->type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (*size < entry->size) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(value, entry->value, entry->size);
+    *size = entry->size;
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    memcpy(s_snapshot, s_keys, sizeof(s_keys));
+    s_open++;
+    *out_handle = 1;
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    s_open--;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    esp_err_t err = s_commit_err;
+    if (err != ESP_OK) {
+        memcpy(s_keys, s_snapshot, sizeof(s_keys));
+        s_commit_err = ESP_OK;
+    }
+    return err;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    fake_nvs_entry_t *entry = fake_nvs_find(key);
+    if (!entry) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memset(entry, 0, sizeof(*entry));
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_i8(nvs_handle_t handle, const char *key, int8_t value)
+{
+    return fake_nvs_set(key, FAKE_NVS_I8, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i8(nvs_handle_t handle, const char *key, int8_t *out_value)
+{
+    size_t size = sizeof(*out_value);
+    return fake_nvs_get(key, FAKE_NVS_I8, out_value, &size);
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char *key, int32_t value)
+{
+    return fake_nvs_set(key, FAKE_NVS_I32, &value, sizeof(value));
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char *key, int32_t *out_value)
+{
+    size_t size = sizeof(*out_value);
+    return fake_nvs_get(key, FAKE_NVS_I32, out_value, &size);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return fake_nvs_set(key, FAKE_NVS_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    return fake_nvs_get(key, FAKE_NVS_BLOB, out_value, length);
+}
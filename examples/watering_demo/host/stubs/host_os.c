@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* FreeRTOS on one thread: tasks are recorded but never run, delays move the tick count */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+struct host_mutex {
+    int taken;
+};
+
+static TickType_t s_ticks;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created_task, BaseType_t core_id)
+{
+    static int s_task;
+    if (created_task) {
+        *created_task = (TaskHandle_t) &s_task;
+    }
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return s_ticks;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_ticks += ticks;
+}
+
+void vTaskDelayUntil(TickType_t *previous_wake, TickType_t increment)
+{
+    *previous_wake += increment;
+    if ((int32_t)(*previous_wake - s_ticks) > 0) {
+        s_ticks = *previous_wake;
+    }
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct host_mutex));
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t mutex)
+{
+    free(mutex);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks_to_wait)
+{
+    /* One thread, a second take would block forever */
+    if (mutex->taken) {
+        fprintf(stderr, "mutex %p taken twice\n", (void *) mutex);
+        abort();
+    }
+    mutex->taken = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    if (!mutex->taken) {
+        return pdFALSE;
+    }
+    mutex->taken = 0;
+    return pdTRUE;
+}
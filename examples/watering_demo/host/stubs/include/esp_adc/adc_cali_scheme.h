@@ -0,0 +1,11 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* No scheme is supported, as on a chip without the eFuse burnt: readings use the nominal full scale */
+
+#pragma once
+
+#include "esp_adc/adc_cali.h"
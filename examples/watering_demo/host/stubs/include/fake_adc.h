@@ -0,0 +1,18 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+/* Returns a raw 12 bit conversion, or -1 when the read times out like ADC2 losing arbitration to Wi-Fi */
+typedef int (*fake_adc_reader_t)(void *arg);
+
+void fake_adc_set_reader(fake_adc_reader_t reader, void *arg);
+
+/* Reads taken so far */
+unsigned fake_adc_reads(void);
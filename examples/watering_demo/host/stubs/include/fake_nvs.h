@@ -0,0 +1,21 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "nvs.h"
+
+/* Drop every key */
+void fake_nvs_reset(void);
+
+/* Make the next nvs_commit() fail with `err` and roll back the writes made since nvs_open() */
+void fake_nvs_fail_next_commit(esp_err_t err);
+
+/* Handles opened and not closed yet */
+int fake_nvs_open_handles(void);
+
+bool fake_nvs_has_key(const char *key);
@@ -7,9 +7,12 @@
 
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <freertos/timers.h>
 
 #include "esp_err.h"
@@ -28,9 +31,13 @@
 #endif
 
 #include "app_humidity.h"
+#include "app_nvs.h"
 
 #define APP_HUMIDITY_MAX_WATCHERS (5)
-#define APP_HUMIDITY_MAX_DEBOUNCE (5)
+#define APP_HUMIDITY_PERIOD_MS    (1000)
+#define APP_HUMIDITY_BURST_SAMPLES (9)  // median of a short burst rejects single-sample spikes
+#define APP_HUMIDITY_IIR_SHIFT    (3)   // y += (x - y) / 8, about 8 s time constant
+#define APP_HUMIDITY_HYSTERESIS   (15)  // 0.1 %RH, the reported value only moves past +-1.5 %
 
 
 #define DEFAULT_VREF    1100
@@ -38,6 +45,12 @@
 
 static const char *TAG = "app_humidity";
 
+/* These numbers come from measurement by hands, used until the sensor is calibrated */
+static const app_humidity_cal_point_t default_cal[] = {
+    {.mv = 1200, .humidity = 84},
+    {.mv = APP_HUMIDITY_ADC_MAX_INPUT_V, .humidity = 1},
+};
+
 typedef struct {
     app_humidity_cb_t cb;
     void *args;
@@ -59,8 +72,17 @@ typedef struct {
     adc_bits_width_t adc_width;
     esp_adc_cal_characteristics_t *adc_chars;
 #endif
+    //filter
+    int32_t iir_state;          // mV << APP_HUMIDITY_IIR_SHIFT
+    bool iir_valid;
+    //calibration
+    SemaphoreHandle_t cal_lock;
+    app_humidity_cal_point_t cal[APP_HUMIDITY_CAL_MAX_POINTS];
+    size_t cal_num;
     //value
+    int voltage;
     int humidity;
+    bool humidity_valid;
     //cb
     watcher_t watchers[APP_HUMIDITY_MAX_WATCHERS];
     TaskHandle_t  task_handle;
@@ -99,7 +121,7 @@ static esp_err_t adc_calibration_init(app_humidity_t *ref)
     if (!calibrated) {
         ESP_LOGI(TAG, "calibration scheme version is %s", "Line Fitting");
         adc_cali_line_fitting_config_t cali_config = {
-            .unit_id = unit,
+            .unit_id = ADC_UNIT_2,
             .atten = ref->adc_atten,
             .bitwidth = ref->adc_width,
         };
@@ -160,12 +182,10 @@ static esp_err_t app_humidity_drive_init(app_humidity_t *ref)
     } else {
         ESP_LOGW(TAG, "eFuse Vref: NOT supported");
     }
-    /** Configure ADC */
-    adc1_config_width(ref->adc_width);
     /** initialize adc channel */
-    adc1_config_channel_atten(ref->adc_channel, ref->adc_atten);
+    adc2_config_channel_atten(ref->adc_channel, ref->adc_atten);
     /** Characterize ADC */
-    esp_adc_cal_value_t val_type = esp_adc_cal_characterize(ADC_UNIT_1, ref->adc_atten, ref->adc_width, DEFAULT_VREF, ref->adc_chars);
+    esp_adc_cal_value_t val_type = esp_adc_cal_characterize(ADC_UNIT_2, ref->adc_atten, ref->adc_width, DEFAULT_VREF, ref->adc_chars);
 
     if (val_type == ESP_ADC_CAL_VAL_EFUSE_TP) {
         ESP_LOGI(TAG, "Characterized using Two Point Value");
@@ -178,51 +198,126 @@ static esp_err_t app_humidity_drive_init(app_humidity_t *ref)
     return ESP_OK;
 }
 
-static int voltage2humidity(int v)
+static int median(int *v, int num)
 {
-    int h;
-    float p;
-    int max_h = 84;
-    int min_h = 1;
-
-    int max_v = APP_HUMIDITY_ADC_MAX_INPUT_V;
-    int min_v = 1200;
-
-    /*all these magic numbers come from measurement by hands*/
-    if (v <= min_v) {
-        h = max_h;
-        p = 1;
-    } else if (v >= max_v) {
-        h = min_h;
-        p = 0.01;
+    for (int i = 1; i < num; i++) {
+        int x = v[i];
+        int j = i - 1;
+        for (; j >= 0 && v[j] > x; j--) {
+            v[j + 1] = v[j];
+        }
+        v[j + 1] = x;
+    }
+    return v[num / 2];
+}
+
+static int iir_update(app_humidity_t *ref, int mv)
+{
+    if (!ref->iir_valid) {
+        ref->iir_state = mv << APP_HUMIDITY_IIR_SHIFT;
+        ref->iir_valid = true;
     } else {
-        p = 1.0 - 1.0 * (v - min_v) / (max_v - min_v);
-        h = (int)(p * (max_h - min_h));
+        ref->iir_state += mv - (ref->iir_state >> APP_HUMIDITY_IIR_SHIFT);
     }
-    //ESP_LOGI(TAG, "v %dmv p %f h %d%%",v,p,h);
-    return h;
+    return (ref->iir_state + (1 << (APP_HUMIDITY_IIR_SHIFT - 1))) >> APP_HUMIDITY_IIR_SHIFT;
 }
 
-static int app_humidity_drive_read_value(app_humidity_t *ref)
+/* Piecewise linear over points sorted by mV, clamped to the end points, result in 0.1 %RH */
+static int cal_mv_to_humidity(const app_humidity_cal_point_t *cal, size_t num, int mv)
 {
-    uint32_t adc_reading = 0;
-#define NO_OF_SAMPLES 64
-#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
-    int adc_raw = 0;
-    for (int i = 0; i < NO_OF_SAMPLES; i++) {
-        adc_oneshot_read(ref->adc1_handle, ref->adc_channel, &adc_raw);
-        adc_reading += adc_raw;
+    if (mv <= cal[0].mv) {
+        return cal[0].humidity * 10;
+    }
+    for (size_t i = 1; i < num; i++) {
+        if (mv <= cal[i].mv) {
+            int dv = cal[i].mv - cal[i - 1].mv;
+            int dh = (cal[i].humidity - cal[i - 1].humidity) * 10;
+            int off = mv - cal[i - 1].mv;
+            return cal[i - 1].humidity * 10 + (dh * off + (dh >= 0 ? dv / 2 : -dv / 2)) / dv;
+        }
+    }
+    return cal[num - 1].humidity * 10;
+}
+
+static int cal_point_cmp(const void *a, const void *b)
+{
+    return ((const app_humidity_cal_point_t *)a)->mv - ((const app_humidity_cal_point_t *)b)->mv;
+}
+
+/* Sort by voltage and reject tables that cannot be interpolated */
+static esp_err_t cal_normalize(app_humidity_cal_point_t *cal, size_t num)
+{
+    ESP_RETURN_ON_FALSE(num >= 2 && num <= APP_HUMIDITY_CAL_MAX_POINTS, ESP_ERR_INVALID_SIZE, TAG, "need 2 to %d points", APP_HUMIDITY_CAL_MAX_POINTS);
+    qsort(cal, num, sizeof(app_humidity_cal_point_t), cal_point_cmp);
+    for (size_t i = 0; i < num; i++) {
+        ESP_RETURN_ON_FALSE(cal[i].humidity >= 0 && cal[i].humidity <= 100, ESP_ERR_INVALID_ARG, TAG, "humidity out of range");
+        ESP_RETURN_ON_FALSE(0 == i || cal[i].mv > cal[i - 1].mv, ESP_ERR_INVALID_ARG, TAG, "duplicated voltage %d mV", cal[i].mv);
     }
+    return ESP_OK;
+}
+
+/*
+ * Returns -1 when most of the burst could not be taken, ADC2 is shared with Wi-Fi and may time out. The median of a
+ * few conversions would let spikes through.
+ */
+static int app_humidity_drive_read_mv(app_humidity_t *ref)
+{
+    int samples[APP_HUMIDITY_BURST_SAMPLES];
+    int num = 0;
+
+    for (int i = 0; i < APP_HUMIDITY_BURST_SAMPLES; i++) {
+        int adc_raw = 0;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+        if (adc_oneshot_read(ref->adc1_handle, ref->adc_channel, &adc_raw) != ESP_OK) {
+            continue;
+        }
 #else
-    for (int i = 0; i < NO_OF_SAMPLES; i++) {
-        adc_reading += adc1_get_raw(ref->adc_channel);
+        if (adc2_get_raw(ref->adc_channel, ref->adc_width, &adc_raw) != ESP_OK) {
+            continue;
+        }
+#endif
+        samples[num++] = adc_raw;
+    }
+    if (num <= APP_HUMIDITY_BURST_SAMPLES / 2) {
+        return -1;
+    }
+
+    int adc_raw = median(samples, num);
+    int mv = adc_raw * APP_HUMIDITY_ADC_MAX_INPUT_V / 4095;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    if (ref->adc1_cali_handle) {
+        adc_cali_raw_to_voltage(ref->adc1_cali_handle, adc_raw, &mv);
     }
+#else
+    mv = esp_adc_cal_raw_to_voltage(adc_raw, ref->adc_chars);
 #endif
-    adc_reading /= NO_OF_SAMPLES;
-#undef NO_OF_SAMPLES
+    return mv;
+}
 
-    //return esp_adc_cal_raw_to_voltage(adc_reading, ref->adc_chars);
-    return voltage2humidity(adc_reading * APP_HUMIDITY_ADC_MAX_INPUT_V / 4095);
+static void app_humidity_notify(app_humidity_t *ref)
+{
+    for (int i = 0; i < APP_HUMIDITY_MAX_WATCHERS; i++) {
+        if (ref->watchers[i].cb) {
+            ref->watchers[i].cb(ref->watchers[i].args);
+        }
+    }
+}
+
+/* Filter one reading, map it through the calibration and report it once it leaves the band around the last report */
+static void app_humidity_update(app_humidity_t *ref, int mv)
+{
+    ref->voltage = iir_update(ref, mv);
+
+    xSemaphoreTake(ref->cal_lock, portMAX_DELAY);
+    int value = cal_mv_to_humidity(ref->cal, ref->cal_num, ref->voltage);
+    xSemaphoreGive(ref->cal_lock);
+
+    if (!ref->humidity_valid || abs(value - ref->humidity * 10) >= APP_HUMIDITY_HYSTERESIS) {
+        ref->humidity = (value + 5) / 10;
+        ref->humidity_valid = true;
+        ESP_LOGD(TAG, "%d mV -> %d%%", ref->voltage, ref->humidity);
+        app_humidity_notify(ref);
+    }
 }
 
 static void humidity_task(void *pvParam)
@@ -241,37 +336,13 @@ static void humidity_task(void *pvParam)
 #endif
     app_humidity_drive_init(ref);
 
-    //init
-    int debounce_cnt = 0;
-    int cur_humidity = app_humidity_drive_read_value(ref);
-    vTaskDelay(pdMS_TO_TICKS(5000));//wait ui
-
+    TickType_t last_wake = xTaskGetTickCount();
     for (;;) {
-        int value = app_humidity_drive_read_value(ref);
-        //ESP_LOGI(TAG, "==>h %d%%",value);
-
-        if (value != cur_humidity) {
-            cur_humidity = value;
-            debounce_cnt = 0;
-        } else {
-            debounce_cnt++;
-
-            if (debounce_cnt > APP_HUMIDITY_MAX_DEBOUNCE) {
-                //we got a stable humidity
-                if (cur_humidity != ref->humidity) {
-                    ref->humidity = cur_humidity;
-
-                    for (int i = 0; i < APP_HUMIDITY_MAX_WATCHERS; i++) {
-                        if (ref->watchers[i].cb) {
-                            ref->watchers[i].cb(ref->watchers[i].args);
-                        }
-                    }
-                } else {
-                    debounce_cnt = 0;
-                }
-            }
+        int mv = app_humidity_drive_read_mv(ref);
+        if (mv >= 0) {
+            app_humidity_update(ref, mv);
         }
-        vTaskDelay(pdMS_TO_TICKS(1000));
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(APP_HUMIDITY_PERIOD_MS));
     }
 }
 
@@ -280,6 +351,16 @@ esp_err_t app_humidity_init(void)
     app_humidity_t *ref = humidity_ref();
     ESP_RETURN_ON_FALSE(ref->task_handle == NULL, ESP_FAIL, TAG, "already init");
 
+    ref->cal_lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(ref->cal_lock, ESP_ERR_NO_MEM, TAG, "create cal lock failed");
+
+    ref->cal_num = APP_HUMIDITY_CAL_MAX_POINTS;
+    if (app_nvs_get_humidity_cal(ref->cal, &ref->cal_num) != ESP_OK || cal_normalize(ref->cal, ref->cal_num) != ESP_OK) {
+        memcpy(ref->cal, default_cal, sizeof(default_cal));
+        ref->cal_num = sizeof(default_cal) / sizeof(default_cal[0]);
+    }
+    ESP_LOGI(TAG, "calibration with %d points", (int) ref->cal_num);
+
     BaseType_t ret_val = xTaskCreatePinnedToCore(
                              (TaskFunction_t)        humidity_task,
                              (const char *const)    "RH Task",
@@ -295,6 +376,52 @@ int app_humidity_get_value(void)
 {
     return humidity_ref()->humidity;
 }
+
+int app_humidity_get_voltage(void)
+{
+    return humidity_ref()->iir_valid ? humidity_ref()->voltage : -1;
+}
+
+esp_err_t app_humidity_cal_set(const app_humidity_cal_point_t *points, size_t num)
+{
+    app_humidity_t *ref = humidity_ref();
+    app_humidity_cal_point_t cal[APP_HUMIDITY_CAL_MAX_POINTS];
+
+    ESP_RETURN_ON_FALSE(ref->cal_lock, ESP_ERR_INVALID_STATE, TAG, "not init");
+    if (0 == num) {
+        ESP_RETURN_ON_ERROR(app_nvs_set_humidity_cal(NULL, 0), TAG, "erase calibration failed");
+        memcpy(cal, default_cal, sizeof(default_cal));
+        num = sizeof(default_cal) / sizeof(default_cal[0]);
+    } else {
+        ESP_RETURN_ON_FALSE(points && num <= APP_HUMIDITY_CAL_MAX_POINTS, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+        memcpy(cal, points, num * sizeof(app_humidity_cal_point_t));
+        ESP_RETURN_ON_ERROR(cal_normalize(cal, num), TAG, "invalid calibration");
+        ESP_RETURN_ON_ERROR(app_nvs_set_humidity_cal(cal, num), TAG, "save calibration failed");
+    }
+
+    xSemaphoreTake(ref->cal_lock, portMAX_DELAY);
+    memcpy(ref->cal, cal, num * sizeof(app_humidity_cal_point_t));
+    ref->cal_num = num;
+    /* Report the new mapping right away instead of waiting for the value to cross the band */
+    ref->humidity_valid = false;
+    xSemaphoreGive(ref->cal_lock);
+    return ESP_OK;
+}
+
+size_t app_humidity_cal_get(app_humidity_cal_point_t *points, size_t max)
+{
+    app_humidity_t *ref = humidity_ref();
+
+    if (!ref->cal_lock) {
+        return 0;
+    }
+    xSemaphoreTake(ref->cal_lock, portMAX_DELAY);
+    size_t num = ref->cal_num < max ? ref->cal_num : max;
+    memcpy(points, ref->cal, num * sizeof(app_humidity_cal_point_t));
+    xSemaphoreGive(ref->cal_lock);
+    return num;
+}
+
 esp_err_t app_humidity_add_watcher(app_humidity_cb_t cb, void *args)
 {
     app_humidity_t *ref = humidity_ref();
@@ -7,18 +7,52 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define APP_HUMIDITY_CAL_MAX_POINTS (8)
+
 typedef void (*app_humidity_cb_t)(void *args);
 
+typedef struct {
+    int16_t mv;         /*!< Filtered sensor voltage */
+    int16_t humidity;   /*!< Reference soil moisture in %, 0 ~ 100 */
+} app_humidity_cal_point_t;
+
 esp_err_t app_humidity_init(void);
 esp_err_t app_humidity_add_watcher(app_humidity_cb_t cb, void *args);
 esp_err_t app_humidity_del_watcher(app_humidity_cb_t cb, void *args);
 int  app_humidity_get_value(void);
+
+/**
+ * @brief Get the filtered sensor voltage in mV, -1 before the first sample
+ */
+int  app_humidity_get_voltage(void);
+
+/**
+ * @brief Replace the voltage to moisture table and save it to NVS
+ *
+ * @param points    Calibration points in any order, voltages must differ
+ * @param num       2 ~ APP_HUMIDITY_CAL_MAX_POINTS, or 0 to restore the factory table
+ *
+ * @return
+ *      - ESP_OK                On success
+ *      - ESP_ERR_INVALID_SIZE  Wrong number of points
+ *      - ESP_ERR_INVALID_ARG   Duplicated voltage or moisture out of range
+ */
+esp_err_t app_humidity_cal_set(const app_humidity_cal_point_t *points, size_t num);
+
+/**
+ * @brief Copy the table in use, sorted by voltage
+ *
+ * @return Number of points copied
+ */
+size_t app_humidity_cal_get(app_humidity_cal_point_t *points, size_t max);
 #ifdef __cplusplus
 }
 #endif
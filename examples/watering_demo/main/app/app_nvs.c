@@ -23,9 +23,11 @@ esp_err_t app_nvs_set_watering_time(int time)
     ret = nvs_open(NVS_NAMESPACE_APP_WATERING_CFG, NVS_READWRITE, &handle);
     ESP_RETURN_ON_ERROR(ret, TAG, "nvs open failed");
     ret = nvs_set_i32(handle, "watering_time", time);
-    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
-    nvs_commit(handle);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
     nvs_close(handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
     return ret;
 }
 
@@ -58,9 +60,11 @@ esp_err_t app_nvs_set_lower_humidity(int humidity)
     ret = nvs_open(NVS_NAMESPACE_APP_WATERING_CFG, NVS_READWRITE, &handle);
     ESP_RETURN_ON_ERROR(ret, TAG, "nvs open failed");
     ret = nvs_set_i32(handle, "lower_humidity", humidity);
-    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
-    nvs_commit(handle);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
     nvs_close(handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
     return ret;
 }
 
@@ -93,9 +97,11 @@ esp_err_t app_nvs_set_auto_watering_enable(bool on)
     ret = nvs_open(NVS_NAMESPACE_APP_WATERING_CFG, NVS_READWRITE, &handle);
     ESP_RETURN_ON_ERROR(ret, TAG, "nvs open failed");
     ret = nvs_set_i8(handle, "auto_watering", (int8_t)on);
-    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
-    nvs_commit(handle);
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
     nvs_close(handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
     return ret;
 }
 
@@ -120,3 +126,46 @@ esp_err_t app_nvs_get_auto_watering_enable(bool *on)
     }
     return ret;
 }
+
+/* A table of 0 points erases the key so the factory table is used again */
+esp_err_t app_nvs_set_humidity_cal(const app_humidity_cal_point_t *points, size_t num)
+{
+    esp_err_t ret;
+    nvs_handle handle;
+
+    ret = nvs_open(NVS_NAMESPACE_APP_WATERING_CFG, NVS_READWRITE, &handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs open failed");
+    if (num) {
+        ret = nvs_set_blob(handle, "humidity_cal", points, num * sizeof(app_humidity_cal_point_t));
+    } else {
+        ret = nvs_erase_key(handle, "humidity_cal");
+        ret = (ret == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : ret;
+    }
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs set failed");
+    return ret;
+}
+
+/* `num` holds the capacity of `points` on entry */
+esp_err_t app_nvs_get_humidity_cal(app_humidity_cal_point_t *points, size_t *num)
+{
+    esp_err_t ret;
+    nvs_handle handle;
+    if (!points || !num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ret = nvs_open(NVS_NAMESPACE_APP_WATERING_CFG, NVS_READWRITE, &handle);
+    ESP_RETURN_ON_ERROR(ret, TAG, "nvs open failed");
+    size_t size = *num * sizeof(app_humidity_cal_point_t);
+    ret = nvs_get_blob(handle, "humidity_cal", points, &size);
+    nvs_close(handle);
+
+    if (ret == ESP_OK) {
+        *num = size / sizeof(app_humidity_cal_point_t);
+    }
+    return ret;
+}
@@ -8,6 +8,7 @@
 
 #include <stdbool.h>
 #include "esp_err.h"
+#include "app_humidity.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +23,9 @@ esp_err_t app_nvs_get_lower_humidity(int *humidity);
 
 esp_err_t app_nvs_set_auto_watering_enable(bool on);
 esp_err_t app_nvs_get_auto_watering_enable(bool *on);
+
+esp_err_t app_nvs_set_humidity_cal(const app_humidity_cal_point_t *points, size_t num);
+esp_err_t app_nvs_get_humidity_cal(app_humidity_cal_point_t *points, size_t *num);
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: Unlicense OR CC0-1.0
  */
 
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 
@@ -18,19 +19,37 @@
 #include "esp_check.h"
 
 #include "driver/gpio.h"
+#include "esp_timer.h"
 #include "app_humidity.h"
 #include "app_pump.h"
 #include "app_nvs.h"
 
+#define APP_PUMP_CTRL_PERIOD_MS     (1000)
+#define APP_PUMP_CTRL_BAND          (8)     // a cycle waters up to lower humidity + band
+#define APP_PUMP_CTRL_MIN_PULSE_S   (2)
+#define APP_PUMP_CTRL_SOAK_S        (30 * 60)
+#define APP_PUMP_CTRL_MIN_INTERVAL_S (5 * 60)
+#define APP_PUMP_CTRL_MAX_DAILY_S   (5 * 60)
+#define APP_PUMP_CTRL_MAX_DRY_PULSES (4)
+
 static const char *TAG = "app_pump";
 
 enum {
     APP_PUMP_CMD_NA,
     APP_PUMP_CMD_STOP,
     APP_PUMP_CMD_START,
+    APP_PUMP_CMD_SET_CTRL,
+    APP_PUMP_CMD_SET_MAX_TIME,
+    APP_PUMP_CMD_SET_LOWER,
     APP_PUMP_CMD_MAX,
 };
 
+typedef struct {
+    int cmd;
+    int duration;   // seconds for APP_PUMP_CMD_START, the new value for APP_PUMP_CMD_SET_*
+    bool manual;
+} pump_cmd_t;
+
 struct cb_entry {
     STAILQ_ENTRY(cb_entry) next;
     app_pump_cb_t cb;
@@ -46,10 +65,13 @@ typedef struct {
     int is_watering;
     int max_watering_time;
     int curr_watering_time; //in seconds
+    int target_watering_time; //length of the running session
+    bool manual_watering;
 
     // triggers
     bool auto_watering_en;
     int lower_humidity; // when humidity below this trigger watering automatically
+    app_pump_ctrl_t ctrl;
 
     //cb
     cb_list_t cb_before;
@@ -84,23 +106,55 @@ static void app_pump_drive_set(app_pump_t *ref, int onoff)
     gpio_set_level(ref->gpio_num, onoff == 0 ? !(ref->gpio_active_level) : ref->gpio_active_level);
 }
 
-/*handle auto watering*/
-void app_pump_auto_watering(void *args)
+static uint32_t app_pump_now_s(void)
+{
+    return esp_timer_get_time() / 1000000;
+}
+
+static void app_pump_cycle_log(const app_pump_cycle_t *cycle, void *args)
 {
-    if (app_pump_get_auto_watering_enable() == 0) {
+    ESP_LOGI(TAG, "watering cycle: %d pulses, %d s pumped, %d%% -> %d%% in %" PRIu32 " s%s",
+             cycle->pulses, cycle->water_s, cycle->moisture_start, cycle->moisture_end,
+             app_pump_now_s() - cycle->start_s, cycle->locked ? ", no response, auto watering locked" : "");
+}
+
+static void app_pump_ctrl_config(app_pump_t *ref, app_pump_ctrl_type_t type)
+{
+    app_pump_ctrl_cfg_t cfg = {
+        .type = type,
+        .lower = ref->lower_humidity,
+        .target = ref->lower_humidity + APP_PUMP_CTRL_BAND,
+        .min_pulse_s = APP_PUMP_CTRL_MIN_PULSE_S,
+        .max_pulse_s = ref->max_watering_time,
+        .soak_s = APP_PUMP_CTRL_SOAK_S,
+        .min_interval_s = APP_PUMP_CTRL_MIN_INTERVAL_S,
+        .max_daily_s = APP_PUMP_CTRL_MAX_DAILY_S,
+        .max_dry_pulses = APP_PUMP_CTRL_MAX_DRY_PULSES,
+        .cycle_cb = app_pump_cycle_log,
+    };
+    app_pump_ctrl_init(&ref->ctrl, &cfg);
+}
+
+/*handle auto watering, runs in the pump task while the pump is idle*/
+static void app_pump_auto_watering(app_pump_t *ref)
+{
+    /* No decision before the moisture sensor produced its first sample */
+    if (!ref->auto_watering_en || app_humidity_get_voltage() < 0) {
         return;
     }
 
-    if (app_humidity_get_value() <= app_pump_get_lower_humidity()) {
-        ESP_LOGW(TAG, "auto watering start");
-        app_pump_watering_start();
+    int pulse = app_pump_ctrl_step(&ref->ctrl, app_pump_now_s(), app_humidity_get_value());
+    if (pulse) {
+        ESP_LOGI(TAG, "auto watering %d s at %d%%", pulse, app_humidity_get_value());
+        pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_START, .duration = pulse, .manual = false};
+        xQueueSend(ref->queue_handle, &cmd, 0);
     }
 }
 
 static void pump_timer_cb(TimerHandle_t tmr)
 {
     app_pump_t *ref = (app_pump_t *) pvTimerGetTimerID(tmr);
-    if (++ref->curr_watering_time < ref->max_watering_time) {
+    if (++ref->curr_watering_time < ref->target_watering_time) {
         struct cb_entry *entry;
         STAILQ_FOREACH(entry, &ref->cb_during, next) {
             entry->cb(entry->args);
@@ -117,7 +171,9 @@ static void pump_task(void *pvParam)
     ESP_ERROR_CHECK(app_nvs_get_auto_watering_enable(&ref->auto_watering_en));
     ESP_ERROR_CHECK(app_nvs_get_lower_humidity(&ref->lower_humidity));
 
-    ref->queue_handle = xQueueCreate(1, sizeof(int));
+    app_pump_ctrl_config(ref, APP_PUMP_CTRL_DEFAULT);
+
+    ref->queue_handle = xQueueCreate(4, sizeof(pump_cmd_t));
     ESP_ERROR_CHECK(ref->queue_handle == NULL ? ESP_FAIL : ESP_OK);
 
     ref->timer_handle = xTimerCreate("watering timer",
@@ -137,15 +193,21 @@ static void pump_task(void *pvParam)
     struct cb_entry *entry;
 
     for (;;) {
-        int cmd = APP_PUMP_CMD_NA;
-        if (xQueueReceive(ref->queue_handle, &cmd, portMAX_DELAY) == pdPASS) {
-            switch (cmd) {
+        pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_NA};
+        if (xQueueReceive(ref->queue_handle, &cmd, pdMS_TO_TICKS(APP_PUMP_CTRL_PERIOD_MS)) != pdPASS) {
+            if (!ref->is_watering) {
+                app_pump_auto_watering(ref);
+            }
+        } else {
+            switch (cmd.cmd) {
             case APP_PUMP_CMD_START: {
                 if (ref->is_watering) {
                     ESP_LOGW(TAG, "alread in watering state");
                 } else {
                     ref->is_watering = 1;
                     ref->curr_watering_time = 0;
+                    ref->target_watering_time = cmd.duration;
+                    ref->manual_watering = cmd.manual;
                     xTimerStart(ref->timer_handle, 0);
 
                     STAILQ_FOREACH(entry, &ref->cb_before, next) {
@@ -157,9 +219,10 @@ static void pump_task(void *pvParam)
             break;
             case APP_PUMP_CMD_STOP: {
                 if (ref->is_watering) {
-                    ESP_LOGW(TAG, "stop watering (%d/%d)", ref->curr_watering_time, ref->max_watering_time);
+                    ESP_LOGW(TAG, "stop watering (%d/%d)", ref->curr_watering_time, ref->target_watering_time);
                     ref->is_watering = 0;
                     xTimerStop(ref->timer_handle, 0);
+                    app_pump_ctrl_watered(&ref->ctrl, app_pump_now_s(), ref->curr_watering_time, ref->manual_watering);
 
                     STAILQ_FOREACH(entry, &ref->cb_after, next) {
                         entry->cb(entry->args);
@@ -169,6 +232,17 @@ static void pump_task(void *pvParam)
                 }
             }
             break;
+            case APP_PUMP_CMD_SET_CTRL:
+                app_pump_ctrl_config(ref, (app_pump_ctrl_type_t)cmd.duration);
+                break;
+            /* Limits change in place, the learned soil response is kept */
+            case APP_PUMP_CMD_SET_MAX_TIME:
+                ref->ctrl.cfg.max_pulse_s = cmd.duration;
+                break;
+            case APP_PUMP_CMD_SET_LOWER:
+                ref->ctrl.cfg.lower = cmd.duration;
+                ref->ctrl.cfg.target = cmd.duration + APP_PUMP_CTRL_BAND;
+                break;
             }
         }
 
@@ -198,32 +272,33 @@ esp_err_t app_pump_init(void)
     return ESP_OK;
 }
 
-esp_err_t app_pump_watering_start(void)
+static esp_err_t app_pump_send_cmd(app_pump_t *ref, const pump_cmd_t *cmd)
 {
-    app_pump_t *ref = pump_ref();
-    int cmd = APP_PUMP_CMD_START;
-    if (xQueueSend(ref->queue_handle, &cmd, pdMS_TO_TICKS(10)) != pdPASS) {
-        ESP_LOGW(TAG, "send cmd %d failed", cmd);
+    if (xQueueSend(ref->queue_handle, cmd, pdMS_TO_TICKS(10)) != pdPASS) {
+        ESP_LOGW(TAG, "send cmd %d failed", cmd->cmd);
         return ESP_FAIL;
     }
     return ESP_OK;
 }
 
+esp_err_t app_pump_watering_start(void)
+{
+    app_pump_t *ref = pump_ref();
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_START, .duration = ref->max_watering_time, .manual = true};
+    return app_pump_send_cmd(ref, &cmd);
+}
+
 esp_err_t app_pump_watering_stop(void)
 {
     app_pump_t *ref = pump_ref();
-    int cmd = APP_PUMP_CMD_STOP;
-    if (xQueueSend(ref->queue_handle, &cmd, pdMS_TO_TICKS(10)) != pdPASS) {
-        ESP_LOGW(TAG, "send cmd %d failed", cmd);
-        return ESP_FAIL;
-    }
-    return ESP_OK;
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_STOP};
+    return app_pump_send_cmd(ref, &cmd);
 }
 
 void app_pump_watering_stop_isr(void)
 {
     app_pump_t *ref = pump_ref();
-    int cmd = APP_PUMP_CMD_STOP;
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_STOP};
     BaseType_t do_yield = pdFALSE;
     xQueueSendFromISR(ref->queue_handle, &cmd, &do_yield);
 }
@@ -267,7 +342,7 @@ int app_pump_curr_watering_time(void)
 
 int app_pump_watering_remaining_time(void)
 {
-    return pump_ref()->max_watering_time - pump_ref()->curr_watering_time;
+    return pump_ref()->target_watering_time - pump_ref()->curr_watering_time;
 }
 
 int app_pump_get_watering_time(void)
@@ -277,9 +352,13 @@ int app_pump_get_watering_time(void)
 
 int app_pump_set_watering_time(int max_time)
 {
-    pump_ref()->max_watering_time = max_time;
+    app_pump_t *ref = pump_ref();
+    /* The controller state belongs to the pump task */
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_SET_MAX_TIME, .duration = max_time};
+
+    ref->max_watering_time = max_time;
     app_nvs_set_watering_time(max_time);
-    return 0;
+    return app_pump_send_cmd(ref, &cmd);
 }
 
 int app_pump_get_auto_watering_enable(void)
@@ -301,7 +380,23 @@ int app_pump_get_lower_humidity(void)
 
 int app_pump_set_lower_humidity(int min)
 {
-    pump_ref()->lower_humidity = min;
+    app_pump_t *ref = pump_ref();
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_SET_LOWER, .duration = min};
+
+    ref->lower_humidity = min;
     app_nvs_set_lower_humidity(min);
-    return 0;
+    return app_pump_send_cmd(ref, &cmd);
+}
+
+esp_err_t app_pump_set_controller(app_pump_ctrl_type_t type)
+{
+    app_pump_t *ref = pump_ref();
+    /* The controller state belongs to the pump task, the learned response is dropped */
+    pump_cmd_t cmd = {.cmd = APP_PUMP_CMD_SET_CTRL, .duration = type};
+    return app_pump_send_cmd(ref, &cmd);
+}
+
+app_pump_ctrl_type_t app_pump_get_controller(void)
+{
+    return pump_ref()->ctrl.cfg.type;
 }
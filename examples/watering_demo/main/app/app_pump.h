@@ -8,6 +8,7 @@
 
 #include <stdbool.h>
 #include "esp_err.h"
+#include "app_pump_ctrl.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,6 +16,8 @@ extern "C" {
 #define APP_PUMP_WATERING_DEFAULT_TIME   (10)
 #define APP_PUMP_WATERING_LOWER_HUMIDITY (40)
 #define APP_PUMP_WATERING_AUTO_ENABLE    (1)
+/* Within 2 % of the target on every soil of host/pump_ctrl_bench.c, with fewer starts than pulse-and-soak */
+#define APP_PUMP_CTRL_DEFAULT            APP_PUMP_CTRL_PI
 
 enum {
     APP_PUMP_CMD_FROM_BUTTON,
@@ -48,6 +51,16 @@ int app_pump_set_auto_watering_enable(int on);
 int app_pump_get_lower_humidity(void);
 int app_pump_set_lower_humidity(int min);
 
+/**
+ * @brief Select the automatic watering strategy
+ *
+ * Every strategy shares the same safety limits: max watering time per pulse,
+ * a minimum interval between pump starts, a daily pump time budget and a lock out
+ * when the soil stops responding. Manual watering is never limited.
+ */
+esp_err_t app_pump_set_controller(app_pump_ctrl_type_t type);
+app_pump_ctrl_type_t app_pump_get_controller(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,161 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+/* Watering decisions only, no driver calls, so the same code runs against a soil model on a host */
+
+#include <string.h>
+#include "app_pump_ctrl.h"
+
+#define CTRL_DAY_S              (24 * 60 * 60)
+#define CTRL_GAP_PERCENT        (75)    // pulse-and-soak fills this share of the gap, the rest comes from lag
+#define CTRL_PI_KP              (2)     // pump seconds per % of error
+#define CTRL_PI_KI_DIV          (2)     // pump seconds per % of error per soak, divided
+
+#define CLAMP(x, lo, hi)        ((x) < (lo) ? (lo) : ((x) > (hi) ? (hi) : (x)))
+
+void app_pump_ctrl_init(app_pump_ctrl_t *ctrl, const app_pump_ctrl_cfg_t *cfg)
+{
+    memset(ctrl, 0, sizeof(app_pump_ctrl_t));
+    ctrl->cfg = *cfg;
+}
+
+static void ctrl_cycle_end(app_pump_ctrl_t *ctrl, int moisture)
+{
+    ctrl->in_cycle = false;
+    ctrl->cycle.moisture_end = moisture;
+    ctrl->cycle.locked = ctrl->locked;
+    if (ctrl->cfg.cycle_cb) {
+        ctrl->cfg.cycle_cb(&ctrl->cycle, ctrl->cfg.cycle_cb_args);
+    }
+}
+
+/* Compare the soaked moisture with the one before the pulse */
+static void ctrl_judge(app_pump_ctrl_t *ctrl, int moisture)
+{
+    int delta = moisture - ctrl->moisture_before;
+
+    ctrl->judge_pending = false;
+    if (delta <= 0) {
+        ctrl->dry_pulses++;
+        return;
+    }
+    ctrl->dry_pulses = 0;
+
+    int gain = delta * 100 / ctrl->last_pulse_s;
+    gain = gain > 0 ? gain : 1;
+    ctrl->gain_x100 = ctrl->gain_x100 ? (ctrl->gain_x100 * 3 + gain) / 4 : gain;
+}
+
+static int ctrl_pulse_len(app_pump_ctrl_t *ctrl, int moisture)
+{
+    const app_pump_ctrl_cfg_t *cfg = &ctrl->cfg;
+    int error = cfg->target - moisture;
+
+    switch (cfg->type) {
+    case APP_PUMP_CTRL_PULSE_SOAK:
+        if (!ctrl->gain_x100) {
+            return cfg->min_pulse_s;    // probe pulse, its response sizes the next ones
+        }
+        return error * CTRL_GAP_PERCENT / ctrl->gain_x100;
+    case APP_PUMP_CTRL_PI: {
+        int integral = ctrl->integral + error;
+        int out = CTRL_PI_KP * error + integral / CTRL_PI_KI_DIV;
+        /* Conditional integration: the integral only moves while the output is not clamped */
+        if (out >= 0 && out <= cfg->max_pulse_s) {
+            ctrl->integral = integral > 0 ? integral : 0;
+        }
+        return CTRL_PI_KP * error + ctrl->integral / CTRL_PI_KI_DIV;
+    }
+    case APP_PUMP_CTRL_BANG_BANG:
+    default:
+        return cfg->max_pulse_s;
+    }
+}
+
+int app_pump_ctrl_step(app_pump_ctrl_t *ctrl, uint32_t now_s, int moisture)
+{
+    const app_pump_ctrl_cfg_t *cfg = &ctrl->cfg;
+    bool bang_bang = (APP_PUMP_CTRL_BANG_BANG == cfg->type);
+
+    if (now_s - ctrl->day_start_s >= CTRL_DAY_S) {
+        ctrl->day_start_s = now_s;
+        ctrl->day_used_s = 0;
+    }
+
+    if (ctrl->locked) {
+        if (moisture <= cfg->lower) {
+            return 0;
+        }
+        ctrl->locked = false;
+        ctrl->dry_pulses = 0;
+    }
+
+    if (!ctrl->in_cycle) {
+        if (moisture > cfg->lower) {
+            return 0;
+        }
+        memset(&ctrl->cycle, 0, sizeof(app_pump_cycle_t));
+        ctrl->cycle.start_s = now_s;
+        ctrl->cycle.moisture_start = moisture;
+        ctrl->in_cycle = true;
+        ctrl->judge_pending = false;
+        ctrl->integral = 0;
+    } else {
+        /* Bang-bang acts on the current reading, the others wait for the water to soak in */
+        if (!bang_bang && now_s - ctrl->last_water_end_s < (uint32_t)cfg->soak_s) {
+            return 0;
+        }
+        if (ctrl->judge_pending) {
+            ctrl_judge(ctrl, moisture);
+        }
+        if (moisture >= cfg->target) {
+            ctrl_cycle_end(ctrl, moisture);
+            return 0;
+        }
+        if (cfg->max_dry_pulses && ctrl->dry_pulses >= cfg->max_dry_pulses) {
+            /* Empty tank, unplugged pump or a probe out of the soil */
+            ctrl->locked = true;
+            ctrl_cycle_end(ctrl, moisture);
+            return 0;
+        }
+    }
+
+    if (ctrl->started && now_s - ctrl->last_start_s < (uint32_t)cfg->min_interval_s) {
+        return 0;
+    }
+    int budget = cfg->max_daily_s ? cfg->max_daily_s - ctrl->day_used_s : cfg->max_pulse_s;
+    if (budget <= 0) {
+        return 0;
+    }
+
+    int pulse = CLAMP(ctrl_pulse_len(ctrl, moisture), cfg->min_pulse_s, cfg->max_pulse_s);
+    pulse = pulse < budget ? pulse : budget;
+
+    ctrl->started = true;
+    ctrl->last_start_s = now_s;
+    ctrl->last_pulse_s = pulse;
+    ctrl->moisture_before = moisture;
+    ctrl->judge_pending = true;
+    ctrl->cycle.pulses++;
+    return pulse;
+}
+
+void app_pump_ctrl_watered(app_pump_ctrl_t *ctrl, uint32_t now_s, int seconds, bool manual)
+{
+    ctrl->last_water_end_s = now_s;
+    if (manual) {
+        /* The soil state changed behind the controller's back, do not learn from it */
+        ctrl->judge_pending = false;
+        ctrl->locked = false;
+        ctrl->dry_pulses = 0;
+    } else {
+        ctrl->day_used_s += seconds;
+        ctrl->last_pulse_s = seconds > 0 ? seconds : 1;
+    }
+    if (ctrl->in_cycle) {
+        ctrl->cycle.water_s += seconds;
+    }
+}
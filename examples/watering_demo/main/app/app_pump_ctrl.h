@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    APP_PUMP_CTRL_BANG_BANG,    /*!< Full length pulses from the lower bound until the target, without soaking */
+    APP_PUMP_CTRL_PULSE_SOAK,   /*!< Pulses sized from the measured soil response, each followed by a soak */
+    APP_PUMP_CTRL_PI,           /*!< PI on the moisture error once per soak, integration stops while saturated */
+} app_pump_ctrl_type_t;
+
+typedef struct {
+    uint32_t start_s;
+    int pulses;
+    int water_s;                /*!< Pump time delivered during the cycle */
+    int moisture_start;
+    int moisture_end;           /*!< Moisture once the last soak finished */
+    bool locked;                /*!< Cycle aborted because the soil stopped responding */
+} app_pump_cycle_t;
+
+typedef void (*app_pump_cycle_cb_t)(const app_pump_cycle_t *cycle, void *args);
+
+typedef struct {
+    app_pump_ctrl_type_t type;
+    int lower;                  /*!< Start a cycle at or below this moisture, % */
+    int target;                 /*!< Moisture a cycle aims for, % */
+    int min_pulse_s;
+    int max_pulse_s;            /*!< Safety cap for one pulse */
+    int soak_s;                 /*!< Time for the water to reach the probe before a pulse is judged */
+    int min_interval_s;         /*!< Rate limit between two pump starts */
+    int max_daily_s;            /*!< Pump time allowed per 24 h */
+    int max_dry_pulses;         /*!< Lock out after this many pulses without any response */
+    app_pump_cycle_cb_t cycle_cb;
+    void *cycle_cb_args;
+} app_pump_ctrl_cfg_t;
+
+typedef struct {
+    app_pump_ctrl_cfg_t cfg;
+    bool in_cycle;
+    bool locked;
+    bool judge_pending;         // last pulse has not been compared with its soaked result yet
+    bool started;
+    uint32_t last_start_s;
+    uint32_t last_water_end_s;
+    int last_pulse_s;
+    int moisture_before;
+    int gain_x100;              // moisture % per 100 s of pumping, 0 until measured
+    int integral;
+    int dry_pulses;
+    uint32_t day_start_s;
+    int day_used_s;
+    app_pump_cycle_t cycle;
+} app_pump_ctrl_t;
+
+/**
+ * @brief Reset a controller, the learned soil response is lost
+ */
+void app_pump_ctrl_init(app_pump_ctrl_t *ctrl, const app_pump_ctrl_cfg_t *cfg);
+
+/**
+ * @brief Run one control step while the pump is idle
+ *
+ * @param now_s     Monotonic time in seconds
+ * @param moisture  Current soil moisture, %
+ *
+ * @return Seconds to pump from now, 0 to stay idle
+ */
+int app_pump_ctrl_step(app_pump_ctrl_t *ctrl, uint32_t now_s, int moisture);
+
+/**
+ * @brief Report the end of any pumping, automatic or not
+ *
+ * @param seconds   Pump time actually delivered
+ * @param manual    Started by the user, it is not charged to the daily budget nor learned from
+ */
+void app_pump_ctrl_watered(app_pump_ctrl_t *ctrl, uint32_t now_s, int seconds, bool manual);
+
+#ifdef __cplusplus
+}
+#endif
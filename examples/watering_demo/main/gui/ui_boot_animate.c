@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <math.h>
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 
 #ifndef PI
@@ -24,9 +25,8 @@ static void anim_timer_cb(lv_timer_t *timer)
     static lv_obj_t *img_text = NULL;
 
     if (-90 == count) {
-        LV_IMG_DECLARE(esp_logo);
         img_logo = lv_img_create(page);
-        lv_img_set_src(img_logo, &esp_logo);
+        lv_img_set_src(img_logo, asset_pack_img("esp_logo"));
         lv_obj_center(img_logo);
     }
 
@@ -45,9 +45,8 @@ static void anim_timer_cb(lv_timer_t *timer)
             lv_obj_del(arc[i]);
         }
 
-        LV_IMG_DECLARE(esp_text);
         img_text = lv_img_create(page);
-        lv_img_set_src(img_text, &esp_text);
+        lv_img_set_src(img_text, asset_pack_img("esp_text"));
         lv_obj_set_style_img_opa(img_text, 0, 0);
     }
 
@@ -0,0 +1,176 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#include "esp_log.h"
+#include "lvgl.h"
+#include "app_humidity.h"
+#include "ui_main.h"
+#include "ui_humidity_cal.h"
+
+#define UI_HUMIDITY_CAL_UPDATE_MS   (500)
+#define UI_HUMIDITY_CAL_STEP        (10)
+
+static const char *TAG = "ui_humidity_cal";
+
+static app_humidity_cal_point_t g_points[APP_HUMIDITY_CAL_MAX_POINTS];
+static size_t g_point_num = 0;
+static lv_obj_t *g_lab_voltage = NULL;
+static lv_obj_t *g_lab_status = NULL;
+static lv_obj_t *g_roller = NULL;
+static lv_timer_t *g_timer = NULL;
+
+static void ui_humidity_cal_timer_cb(lv_timer_t *timer)
+{
+    int mv = app_humidity_get_voltage();
+    if (mv < 0) {
+        lv_label_set_text_static(g_lab_voltage, "Sensor: --");
+    } else {
+        lv_label_set_text_fmt(g_lab_voltage, "Sensor: %d mV  (%d%%)", mv, app_humidity_get_value());
+    }
+}
+
+static void ui_humidity_cal_add_click_cb(lv_event_t *e)
+{
+    int mv = app_humidity_get_voltage();
+    int humidity = lv_roller_get_selected(g_roller) * UI_HUMIDITY_CAL_STEP;
+    size_t i = 0;
+
+    if (mv < 0) {
+        lv_label_set_text_static(g_lab_status, "No sensor reading yet");
+        return;
+    }
+
+    /* Picking the same reference twice replaces the earlier measurement */
+    while (i < g_point_num && g_points[i].humidity != humidity) {
+        i++;
+    }
+    if (i == APP_HUMIDITY_CAL_MAX_POINTS) {
+        lv_label_set_text_static(g_lab_status, "Table full, save or reset");
+        return;
+    }
+    g_points[i].mv = mv;
+    g_points[i].humidity = humidity;
+    if (i == g_point_num) {
+        g_point_num++;
+    }
+    lv_label_set_text_fmt(g_lab_status, "%d%% = %d mV, %u points", humidity, mv, (unsigned)g_point_num);
+}
+
+static void ui_humidity_cal_save_click_cb(lv_event_t *e)
+{
+    esp_err_t ret = app_humidity_cal_set(g_points, g_point_num);
+    if (ret == ESP_OK) {
+        lv_label_set_text_fmt(g_lab_status, "Saved %u points", (unsigned)g_point_num);
+    } else if (ret == ESP_ERR_INVALID_SIZE) {
+        lv_label_set_text_static(g_lab_status, "Add 2 points at least");
+    } else {
+        lv_label_set_text_static(g_lab_status, "Readings too close, redo");
+        ESP_LOGW(TAG, "save calibration failed: %s", esp_err_to_name(ret));
+    }
+}
+
+static void ui_humidity_cal_reset_click_cb(lv_event_t *e)
+{
+    g_point_num = 0;
+    if (app_humidity_cal_set(NULL, 0) == ESP_OK) {
+        lv_label_set_text_static(g_lab_status, "Factory table restored");
+    }
+}
+
+static void ui_humidity_cal_return_click_cb(lv_event_t *e)
+{
+    lv_obj_t *page = lv_event_get_user_data(e);
+    if (ui_get_btn_op_group()) {
+        lv_group_focus_freeze(ui_get_btn_op_group(), false);
+    }
+    lv_timer_del(g_timer);
+    g_timer = NULL;
+    lv_obj_del(page);
+}
+
+static lv_obj_t *ui_humidity_cal_btn_create(lv_obj_t *parent, const char *text, lv_event_cb_t cb, void *user_data)
+{
+    lv_obj_t *btn = lv_btn_create(parent);
+    lv_obj_add_style(btn, &ui_button_styles()->style, 0);
+    lv_obj_add_style(btn, &ui_button_styles()->style_pr, LV_STATE_PRESSED);
+    lv_obj_add_style(btn, &ui_button_styles()->style_focus, LV_STATE_FOCUS_KEY);
+    lv_obj_add_style(btn, &ui_button_styles()->style_focus, LV_STATE_FOCUSED);
+    lv_obj_set_size(btn, 80, 32);
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text_static(label, text);
+    lv_obj_set_style_text_color(label, lv_color_black(), LV_PART_MAIN);
+    lv_obj_center(label);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, user_data);
+    if (ui_get_btn_op_group()) {
+        lv_group_add_obj(ui_get_btn_op_group(), btn);
+    }
+    return btn;
+}
+
+void ui_humidity_cal_start(void)
+{
+    if (g_timer) {
+        return;
+    }
+    g_point_num = 0;
+
+    lv_obj_t *page = lv_obj_create(lv_scr_act());
+    lv_obj_set_size(page, lv_obj_get_width(lv_obj_get_parent(page)), 200);
+    lv_obj_clear_flag(page, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_set_style_radius(page, 15, LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(page, 1, LV_STATE_DEFAULT);
+    lv_obj_set_style_shadow_width(page, 20, LV_PART_MAIN);
+    lv_obj_set_style_shadow_opa(page, LV_OPA_30, LV_PART_MAIN);
+    lv_obj_align(page, LV_ALIGN_BOTTOM_MID, 0, 0);
+
+    lv_obj_t *btn_return = lv_btn_create(page);
+    lv_obj_set_size(btn_return, 24, 24);
+    lv_obj_add_style(btn_return, &ui_button_styles()->style, 0);
+    lv_obj_add_style(btn_return, &ui_button_styles()->style_pr, LV_STATE_PRESSED);
+    lv_obj_add_style(btn_return, &ui_button_styles()->style_focus, LV_STATE_FOCUS_KEY);
+    lv_obj_add_style(btn_return, &ui_button_styles()->style_focus, LV_STATE_FOCUSED);
+    lv_obj_align(btn_return, LV_ALIGN_TOP_LEFT, 0, 0);
+    lv_obj_t *lab_btn_text = lv_label_create(btn_return);
+    lv_label_set_text_static(lab_btn_text, LV_SYMBOL_LEFT);
+    lv_obj_set_style_text_color(lab_btn_text, lv_color_make(158, 158, 158), LV_STATE_DEFAULT);
+    lv_obj_center(lab_btn_text);
+    lv_obj_add_event_cb(btn_return, ui_humidity_cal_return_click_cb, LV_EVENT_CLICKED, page);
+    if (ui_get_btn_op_group()) {
+        lv_group_add_obj(ui_get_btn_op_group(), btn_return);
+        lv_group_focus_obj(btn_return);
+        lv_group_focus_freeze(ui_get_btn_op_group(), true);
+    }
+
+    lv_obj_t *lab_title = lv_label_create(page);
+    lv_label_set_text_static(lab_title, "Moisture calibration");
+    lv_obj_align(lab_title, LV_ALIGN_TOP_MID, 10, 2);
+
+    g_lab_voltage = lv_label_create(page);
+    lv_obj_align(g_lab_voltage, LV_ALIGN_TOP_MID, 0, 30);
+
+    g_roller = lv_roller_create(page);
+    lv_roller_set_options(g_roller, "0%\n10%\n20%\n30%\n40%\n50%\n60%\n70%\n80%\n90%\n100%", LV_ROLLER_MODE_NORMAL);
+    lv_roller_set_visible_row_count(g_roller, 3);
+    lv_obj_set_width(g_roller, 80);
+    lv_obj_align(g_roller, LV_ALIGN_LEFT_MID, 10, 20);
+    if (ui_get_btn_op_group()) {
+        lv_group_add_obj(ui_get_btn_op_group(), g_roller);
+    }
+
+    lv_obj_t *btn_add = ui_humidity_cal_btn_create(page, "Add", ui_humidity_cal_add_click_cb, NULL);
+    lv_obj_align(btn_add, LV_ALIGN_RIGHT_MID, -100, 0);
+    lv_obj_t *btn_save = ui_humidity_cal_btn_create(page, "Save", ui_humidity_cal_save_click_cb, NULL);
+    lv_obj_align(btn_save, LV_ALIGN_RIGHT_MID, -10, 0);
+    lv_obj_t *btn_reset = ui_humidity_cal_btn_create(page, "Reset", ui_humidity_cal_reset_click_cb, NULL);
+    lv_obj_align(btn_reset, LV_ALIGN_RIGHT_MID, -10, 40);
+
+    g_lab_status = lv_label_create(page);
+    lv_label_set_text_static(g_lab_status, "Pick the reference, then Add");
+    lv_obj_align(g_lab_status, LV_ALIGN_BOTTOM_MID, 0, 0);
+
+    g_timer = lv_timer_create(ui_humidity_cal_timer_cb, UI_HUMIDITY_CAL_UPDATE_MS, NULL);
+    ui_humidity_cal_timer_cb(g_timer);
+}
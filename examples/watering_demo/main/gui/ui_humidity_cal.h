@@ -0,0 +1,23 @@
+/*
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Unlicense OR CC0-1.0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Open the soil moisture calibration page
+ *
+ * Each step pairs the live sensor voltage with a reference moisture picked by the user,
+ * typically dry air, dry soil, wet soil and water. The table is saved once it holds 2 points or more.
+ */
+void ui_humidity_cal_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,6 +19,7 @@
 #include "app_humidity.h"
 #include "ui_sr.h"
 #include "ui_net_config.h"
+#include "ui_humidity_cal.h"
 #include "ui_boot_animate.h"
 
 #include "bsp_board.h"
@@ -180,7 +181,7 @@ static void ui_arc_animation_ctrl(int start)
         lv_obj_clear_flag(g_btn_arc_item, LV_OBJ_FLAG_HIDDEN);
 
         lv_timer_reset(g_arc_timer);
-        int period = app_pump_get_watering_time() * 1000 / lv_arc_get_max_value(g_btn_arc_item);
+        int period = (app_pump_curr_watering_time() + app_pump_watering_remaining_time()) * 1000 / lv_arc_get_max_value(g_btn_arc_item);
         lv_timer_set_period(g_arc_timer, period);
         lv_timer_resume(g_arc_timer);
     } else {
@@ -288,6 +289,11 @@ static void label_humidity_value_handler(lv_event_t *e)
     }
 }
 
+static void label_humidity_long_press_handler(lv_event_t *e)
+{
+    ui_humidity_cal_start();
+}
+
 static void label_time_handler(lv_timer_t *timer)
 {
     char time_str[8];
@@ -349,6 +355,9 @@ static void ui_watering_main(void)
     lv_obj_align(label_rh_value, LV_ALIGN_LEFT_MID, 0, 40);
     lv_obj_add_event_cb(label_rh_value, label_humidity_value_handler, LV_EVENT_VALUE_CHANGED, label_rh_value);
     app_humidity_add_watcher(label_humidity_event_send, label_rh_value);
+    //long press the value to calibrate the sensor
+    lv_obj_add_flag(label_rh_value, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(label_rh_value, label_humidity_long_press_handler, LV_EVENT_LONG_PRESSED, NULL);
     ui_watering_btn(page);
 }
 
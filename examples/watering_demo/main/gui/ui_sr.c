@@ -7,6 +7,7 @@
 #include "esp_log.h"
 #include "bsp_board.h"
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "ui_main.h"
 
 // static void (*g_sr_end_cb)(void) = NULL;
@@ -88,13 +89,11 @@
 /* **************** SPEECH ANIMATE **************** */
 
 #ifdef CONFIG_SR_MN_ENGLISH
-#define FONT_CMD    font_cmd_en_36
+#define FONT_CMD    asset_pack_font("font_cmd_en_36")
 #else
-#define FONT_CMD    lv_font_montserrat_36
+#define FONT_CMD    (&lv_font_montserrat_36)
 #endif
 
-LV_FONT_DECLARE(FONT_CMD)
-
 static bool g_sr_anim_active = false;
 static int32_t g_sr_anim_count = 0;
 static lv_obj_t *g_sr_label = NULL;
@@ -228,13 +227,12 @@ void ui_sr_anim_init(void)
     lv_obj_set_style_shadow_opa(obj_img, LV_OPA_30, LV_STATE_DEFAULT);
     lv_obj_align(obj_img, LV_ALIGN_CENTER, 0, -30);
     lv_obj_t *img_mic_logo = lv_img_create(obj_img);
-    LV_IMG_DECLARE(mic_logo)
-    lv_img_set_src(img_mic_logo, &mic_logo);
+    lv_img_set_src(img_mic_logo, asset_pack_img("mic_logo"));
     lv_obj_center(img_mic_logo);
 
     g_sr_label = lv_label_create(g_sr_mask);
     lv_label_set_text_static(g_sr_label, "");
-    lv_obj_set_style_text_font(g_sr_label, &FONT_CMD, LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(g_sr_label, FONT_CMD, LV_STATE_DEFAULT);
     lv_obj_set_style_text_color(g_sr_label, lv_color_black(), LV_STATE_DEFAULT);
     lv_obj_align(g_sr_label, LV_ALIGN_CENTER, 0, 80);
     lv_obj_add_event_cb(g_sr_label, sr_label_event_handler, LV_EVENT_VALUE_CHANGED, NULL);
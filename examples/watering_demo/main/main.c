@@ -21,8 +21,10 @@
 
 #include "bsp_board.h"
 #include "bsp/esp-bsp.h"
+#include "bsp_display_buf.h"
 
 #include "lvgl.h"
+#include "asset_pack.h"
 #include "gui/ui_main.h"
 
 static const char *TAG = "main";
@@ -85,15 +87,14 @@ void app_main(void)
 
     bsp_display_cfg_t cfg = {
         .lvgl_port_cfg = ESP_LVGL_PORT_INIT_CONFIG(),
-        .buffer_size = BSP_LCD_H_RES * CONFIG_BSP_LCD_DRAW_BUF_HEIGHT,
-        .double_buffer = 0,
-        .flags = {
-            .buff_dma = true,
-        }
     };
+    bsp_display_buf_config(&cfg, BSP_DISPLAY_BUF_DEFAULT);
     bsp_display_start_with_config(&cfg);
     bsp_board_init();
     ESP_ERROR_CHECK(bsp_spiffs_mount());
+    if (ESP_OK != asset_pack_init("assets", NULL)) {
+        ESP_LOGW(TAG, "UI runs without images and custom fonts");
+    }
 
     ESP_LOGI(TAG, "Display LVGL demo");
     bsp_display_backlight_on();